@@ -146,8 +146,7 @@ public:
 		}
 		template <typename T>
 		void inline operator /= (const T &v) {
-			this_->get_or_create(i_) *= v;
-			return *this;
+			this_->get_or_create(i_) /= v;
 		}
 	private:
 		map_vec<value_type, idx_type, MAP_TYPE> * const this_;
@@ -0,0 +1,296 @@
+#include "BatchJob.h"
+
+#include "../ModelMesh/MeshModel.h"
+#include "../Param/Parameter.h"
+#include "../Param/ParamDrawer.h"
+#include "../Param/SolveMonitor.h"
+#include "../Common/stopwatch.h"
+#include "../Common/Parallel.h"
+
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <new>
+#include <exception>
+#include <boost/shared_ptr.hpp>
+
+namespace BATCH
+{
+	//! the peak memory model. the constants are rough per element sizes of the arrays
+	//! below with some headroom, not a measured fit, so a job whose peak is known better
+	//! gives it with memory=MB in the manifest.
+	//! the face arrays of the mesh, the index, normal and texture coordinate per face
+	const double MESH_BYTES_PER_FACE = 600;
+	//! the vertex arrays and the operator cache of the mesh, and the least squares system:
+	//! the equations of both coordinates, their transpose and the normal matrix
+	const double SYSTEM_BYTES_PER_VERT = 12800;
+	//! the chart parallel solve keeps a dense Schur complement block per chart. it grows
+	//! with the square of the chart boundary, that is with the chart area, so the sum
+	//! over the charts is linear in the vertices whatever the chart number
+	const double CHART_INTERFACE_BYTES_PER_VERT = 20000;
+	//! the factor has about 13 n log2(n) entries of 8 bytes for n unknowns
+	const double FACTOR_BYTES_PER_FILL = 108;
+	//! the patch layout, the result arrays and the loader's buffers
+	const double JOB_BASE_BYTES = 8.0*1024*1024;
+
+	BatchMethod ParseBatchMethod(const std::string& method_name)
+	{
+		if(method_name == "param") return BATCH_METHOD_PARAM;
+		return BATCH_METHOD_UNKNOWN;
+	}
+
+	const char* GetBatchMethodName(BatchMethod method)
+	{
+		switch(method)
+		{
+		case BATCH_METHOD_PARAM:
+			return "param";
+		default:
+			return "unknown";
+		}
+	}
+
+	BatchPreview ParseBatchPreview(const std::string& preview_name)
+	{
+		if(preview_name == "none") return BATCH_PREVIEW_NONE;
+		if(preview_name == "distortion") return BATCH_PREVIEW_DISTORTION;
+		if(preview_name == "texture") return BATCH_PREVIEW_TEXTURE;
+		if(preview_name == "patch") return BATCH_PREVIEW_PATCH;
+		return BATCH_PREVIEW_UNKNOWN;
+	}
+
+	const char* GetBatchJobStatusName(BatchJobStatus status)
+	{
+		switch(status)
+		{
+		case BATCH_JOB_PENDING:
+			return "pending";
+		case BATCH_JOB_SUCCEEDED:
+			return "succeeded";
+		case BATCH_JOB_FAILED:
+			return "failed";
+		case BATCH_JOB_TIMEOUT:
+			return "timeout";
+		case BATCH_JOB_SKIPPED:
+			return "skipped";
+		default:
+			return "unknown";
+		}
+	}
+
+	bool EstimateJobMemory(BatchJob& job)
+	{
+		MeshModelIO mesh_io;
+		if(!mesh_io.PeekModelSize(job.mesh_file, job.vert_num, job.face_num) || job.vert_num <= 0)
+		{
+			job.estimated_memory = job.memory_limit;
+			return false;
+		}
+
+		double vari_num = 2.0*job.vert_num;
+		double system_bytes = MESH_BYTES_PER_FACE*job.face_num + SYSTEM_BYTES_PER_VERT*job.vert_num;
+		if(job.chart_parallel) system_bytes += CHART_INTERFACE_BYTES_PER_VERT*job.vert_num;
+		double factor_bytes = FACTOR_BYTES_PER_FILL*vari_num*std::max(1.0, log(vari_num)/log(2.0));
+
+		job.estimated_memory = (size_t) (JOB_BASE_BYTES + system_bytes + factor_bytes);
+		if(job.memory_limit != 0) job.estimated_memory = job.memory_limit;
+		return true;
+	}
+
+	//! cancels the solve after the job's time limit and counts the solve loops
+	class BatchJobMonitor : public PARAM::SolveMonitor
+	{
+	public:
+		BatchJobMonitor(double time_limit) : m_start_time(SystemStopwatch::now()), m_time_limit(time_limit),
+			m_timeout(false), m_solve_loop_num(0) {}
+
+		bool IsCanceled()
+		{
+			if(m_time_limit > 0 && SystemStopwatch::now() - m_start_time > m_time_limit) m_timeout = true;
+			return m_timeout;
+		}
+
+		void ReportProgress(int stage, int iteration, double residual)
+		{
+			if(stage == PARAM::SOLVE_STAGE_SOLVE) ++m_solve_loop_num;
+		}
+
+		bool IsTimeout() const { return m_timeout; }
+		int GetSolveLoopNum() const { return m_solve_loop_num; }
+
+	private:
+		double m_start_time;
+		double m_time_limit;
+		bool m_timeout;
+		int m_solve_loop_num;
+	};
+
+	static std::string GetOutputFileName(const std::string& output_dir, const std::string& name, const char* ext)
+	{
+		std::string file_name = output_dir;
+		if(!file_name.empty() && file_name[file_name.size()-1] != '/' && file_name[file_name.size()-1] != '\\')
+			file_name += '/';
+		return file_name + name + ext;
+	}
+
+	//! the face parameter coordinates as QGLViewer::SaveFaceTexCoord writes them, (s0 t0 s1 t1 s2 t2)
+	//! per line in the mesh file order, and each face's chart in a second file of the same order.
+	//! a face removed from the model gets zeros and chart -1
+	static bool WriteFaceParamCoord(const PARAM::Parameter& param, const std::string& output_dir,
+		const std::string& name)
+	{
+		std::vector<double> face_param_coord;
+		param.GatherFaceParamCoord(face_param_coord);
+
+		ModelInfo& model_info = param.GetMeshModel()->m_Kernel.GetModelInfo();
+		int file_face_num = model_info.GetFileFaceNum();
+
+		std::ofstream tex_out(GetOutputFileName(output_dir, name, ".ftex").c_str());
+		std::ofstream chart_out(GetOutputFileName(output_dir, name, ".fchart").c_str());
+		if(tex_out.fail() || chart_out.fail()) return false;
+
+		for(int k=0; k<file_face_num; ++k)
+		{
+			int fid = model_info.GetModelFaceID(k);
+			if(fid == -1)
+			{
+				tex_out << "0 0 0 0 0 0 " << std::endl;
+				chart_out << -1 << std::endl;
+				continue;
+			}
+			for(int i=0; i<6; ++i) tex_out << face_param_coord[fid*6+i] << " ";
+			tex_out << std::endl;
+			chart_out << param.GetFaceChartID(fid) << std::endl;
+		}
+
+		return !tex_out.fail() && !chart_out.fail();
+	}
+
+	//! the preview image rendered without OpenGL, the patch edges and conners on top of the shading
+	static bool WritePreview(const PARAM::Parameter& param, const std::string& output_dir,
+		const std::string& name, BatchPreview preview)
+	{
+		int mode = PARAM::ParamDrawer::DRAWPATCHEDGE | PARAM::ParamDrawer::DRAWPATCHCONNER;
+		switch(preview)
+		{
+		case BATCH_PREVIEW_DISTORTION:
+			mode |= PARAM::ParamDrawer::DRAWDISTORTION;
+			break;
+		case BATCH_PREVIEW_TEXTURE:
+			mode |= PARAM::ParamDrawer::DRAWFACETEXTURE;
+			break;
+		case BATCH_PREVIEW_PATCH:
+			mode |= PARAM::ParamDrawer::DRAWPATCHFACE;
+			break;
+		default:
+			return true;
+		}
+
+		PARAM::ParamDrawer drawer(param);
+		return drawer.SaveSnapshot(GetOutputFileName(output_dir, name, ".png"), mode);
+	}
+
+	static void RunParamJob(const BatchJob& job, const std::string& output_dir, BatchJobResult& result)
+	{
+		double stage_start = SystemStopwatch::now();
+
+		boost::shared_ptr<MeshModel> p_mesh(new MeshModel);
+		p_mesh->AttachModel(job.mesh_file);
+		if(!p_mesh->m_bAttachModel)
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "can't load mesh " + job.mesh_file;
+			return;
+		}
+		result.load_time = SystemStopwatch::now() - stage_start;
+		stage_start = SystemStopwatch::now();
+
+		PARAM::Parameter param(p_mesh);
+		param.SetChartParallelSolve(job.chart_parallel);
+		param.SetResultCacheDir(job.cache_dir);
+		if(!param.LoadPatchFile(job.layout_file))
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "can't load patch layout " + job.layout_file;
+			return;
+		}
+		result.layout_time = SystemStopwatch::now() - stage_start;
+		stage_start = SystemStopwatch::now();
+
+		BatchJobMonitor monitor(job.time_limit);
+		param.SetSolveMonitor(&monitor);
+		bool succeeded = param.ComputeParamCoord();
+		param.SetSolveMonitor(NULL);
+		result.solve_time = SystemStopwatch::now() - stage_start;
+		result.solve_loop_num = monitor.GetSolveLoopNum();
+		if(!succeeded)
+		{
+			result.status = monitor.IsTimeout() ? BATCH_JOB_TIMEOUT : BATCH_JOB_FAILED;
+			result.message = monitor.IsTimeout() ? "time limit exceeded" : "parameterization failed";
+			return;
+		}
+
+		result.fliped_face_num = (int) param.GetFlipedFaceArray().size();
+		result.out_range_vert_num = (int) param.GetOutRangeVertArray().size();
+		const std::vector<double>& distortion = param.GetFaceIsometricDistortion();
+		for(size_t k=0; k<distortion.size(); ++k) result.mean_isometric_distortion += distortion[k];
+		if(!distortion.empty()) result.mean_isometric_distortion /= distortion.size();
+
+		stage_start = SystemStopwatch::now();
+		if(!WriteFaceParamCoord(param, output_dir, job.name))
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "can't write the result to " + output_dir;
+			return;
+		}
+		if(!WritePreview(param, output_dir, job.name, job.preview))
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "can't write the preview to " + output_dir;
+			return;
+		}
+		result.write_time = SystemStopwatch::now() - stage_start;
+
+		result.status = BATCH_JOB_SUCCEEDED;
+	}
+
+	void RunBatchJob(const BatchJob& job, const std::string& output_dir, BatchJobResult& result)
+	{
+		double start_time = SystemStopwatch::now();
+		try
+		{
+			//! the parallel loops of the job run on threads of its own, so they neither wait
+			//! for the other jobs nor take their cores
+			ParallelRuntime runtime(std::max(1, job.core_num));
+			ParallelRuntimeScope runtime_scope(runtime);
+
+			switch(job.method)
+			{
+			case BATCH_METHOD_PARAM:
+				RunParamJob(job, output_dir, result);
+				break;
+			default:
+				result.status = BATCH_JOB_FAILED;
+				result.message = "unknown method";
+				break;
+			}
+		}
+		catch(std::bad_alloc&)
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "out of memory";
+		}
+		catch(std::exception& e)
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = e.what();
+		}
+		catch(...)
+		{
+			result.status = BATCH_JOB_FAILED;
+			result.message = "unknown exception";
+		}
+		result.total_time = SystemStopwatch::now() - start_time;
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef BATCHJOB_H_
+#define BATCHJOB_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace BATCH
+{
+	//! what a job computes
+	enum BatchMethod
+	{
+		BATCH_METHOD_PARAM = 0,		//! Parameter::ComputeParamCoord on a mesh and its patch layout
+		BATCH_METHOD_UNKNOWN
+	};
+
+	//! the image a job renders of its result with ParamDrawer::SaveSnapshot
+	enum BatchPreview
+	{
+		BATCH_PREVIEW_NONE = 0,
+		BATCH_PREVIEW_DISTORTION,	//! the face harmonic distortion
+		BATCH_PREVIEW_TEXTURE,		//! a checkerboard of the parameter coordinates
+		BATCH_PREVIEW_PATCH,		//! the patch colors
+		BATCH_PREVIEW_UNKNOWN
+	};
+
+	//! the state a job ends in
+	enum BatchJobStatus
+	{
+		BATCH_JOB_PENDING = 0,
+		BATCH_JOB_SUCCEEDED,
+		BATCH_JOB_FAILED,			//! the job itself failed: bad input, failed solve, exception
+		BATCH_JOB_TIMEOUT,			//! canceled after its time limit
+		BATCH_JOB_SKIPPED			//! never run, its inputs could not be sized
+	};
+
+	//! one line of the manifest
+	class BatchJob
+	{
+	public:
+		BatchJob() : method(BATCH_METHOD_PARAM), preview(BATCH_PREVIEW_NONE), chart_parallel(true), core_num(1),
+			time_limit(0), memory_limit(0), vert_num(0), face_num(0), estimated_memory(0) {}
+
+	public:
+		std::string name;				//! unique, names the output files
+		std::string mesh_file;
+		std::string layout_file;
+		BatchMethod method;
+		BatchPreview preview;			//! written as name.png next to the result, with the layout on top
+
+		bool chart_parallel;			//! Parameter::SetChartParallelSolve
+		int core_num;					//! cores reserved for the job
+		std::string cache_dir;			//! Parameter::SetResultCacheDir, empty for none
+		double time_limit;				//! seconds, 0 for none
+		size_t memory_limit;			//! bytes given in the manifest, overrides the estimation when not 0
+
+		//! filled by EstimateJobMemory
+		int vert_num;
+		int face_num;
+		size_t estimated_memory;		//! bytes
+	};
+
+	//! what one run produced, written to the batch report
+	class BatchJobResult
+	{
+	public:
+		BatchJobResult() : status(BATCH_JOB_PENDING), wait_time(0), load_time(0), layout_time(0),
+			solve_time(0), write_time(0), total_time(0), solve_loop_num(0), fliped_face_num(0),
+			out_range_vert_num(0), mean_isometric_distortion(0) {}
+
+	public:
+		BatchJobStatus status;
+		std::string message;			//! why it failed
+
+		//! wall clock seconds
+		double wait_time;				//! from the batch start to the job start
+		double load_time;
+		double layout_time;
+		double solve_time;
+		double write_time;
+		double total_time;
+
+		int solve_loop_num;
+		int fliped_face_num;
+		int out_range_vert_num;
+		double mean_isometric_distortion;
+	};
+
+	//! parse the method name of the manifest, BATCH_METHOD_UNKNOWN for an unknown one
+	BatchMethod ParseBatchMethod(const std::string& method_name);
+	const char* GetBatchMethodName(BatchMethod method);
+	BatchPreview ParseBatchPreview(const std::string& preview_name);
+	const char* GetBatchJobStatusName(BatchJobStatus status);
+
+	//! read the mesh size from the mesh file header and estimate the peak memory of the job:
+	//! the mesh with its cached operators, the least squares system of the 2 coordinates per
+	//! vertex, the chart interface blocks of the chart parallel solve, and the Cholesky factor
+	//! of the normal matrix. the factor of a mesh Laplacian ordered by nested dissection has
+	//! about n log2(n) entries for n unknowns, so it is the part that grows faster than the
+	//! mesh. false when the mesh file can not be read
+	bool EstimateJobMemory(BatchJob& job);
+
+	//! run the job in the calling thread with a mesh, a solver and a ParallelRuntime of
+	//! job.core_num threads of its own, and write its face parameter coordinates to
+	//! output_dir, with its preview image when it asks for one. all the failures end in
+	//! result, the function never throws
+	void RunBatchJob(const BatchJob& job, const std::string& output_dir, BatchJobResult& result);
+}
+
+#endif //BATCHJOB_H_
@@ -0,0 +1,140 @@
+#include "BatchManifest.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <cstdlib>
+
+namespace BATCH
+{
+	namespace
+	{
+		bool IsAbsolutePath(const std::string& path)
+		{
+			if(path.empty()) return false;
+			if(path[0] == '/' || path[0] == '\\') return true;
+			return path.size() > 1 && path[1] == ':';
+		}
+
+		std::string ResolvePath(const std::string& path, const std::string& base_dir)
+		{
+			if(IsAbsolutePath(path)) return path;
+			return base_dir + path;
+		}
+
+		bool ParseInt(const std::string& str, int& value)
+		{
+			char* end = NULL;
+			long v = strtol(str.c_str(), &end, 10);
+			if(str.empty() || *end != '\0') return false;
+			value = (int) v;
+			return true;
+		}
+
+		bool ParseDouble(const std::string& str, double& value)
+		{
+			char* end = NULL;
+			value = strtod(str.c_str(), &end);
+			return !str.empty() && *end == '\0';
+		}
+
+		bool ParseJobOption(const std::string& key, const std::string& value, const std::string& base_dir, BatchJob& job)
+		{
+			if(key == "solver")
+			{
+				if(value != "chart" && value != "direct") return false;
+				job.chart_parallel = (value == "chart");
+				return true;
+			}
+			if(key == "cores")
+			{
+				return ParseInt(value, job.core_num) && job.core_num > 0;
+			}
+			if(key == "preview")
+			{
+				job.preview = ParseBatchPreview(value);
+				return job.preview != BATCH_PREVIEW_UNKNOWN;
+			}
+			if(key == "cache")
+			{
+				job.cache_dir = ResolvePath(value, base_dir);
+				return true;
+			}
+			if(key == "time_limit")
+			{
+				return ParseDouble(value, job.time_limit) && job.time_limit >= 0;
+			}
+			if(key == "memory")
+			{
+				double memory_mb = 0;
+				if(!ParseDouble(value, memory_mb) || memory_mb <= 0) return false;
+				job.memory_limit = (size_t) (memory_mb*1024*1024);
+				return true;
+			}
+			return false;
+		}
+
+		//! the error of a malformed line, empty when it is fine
+		std::string ParseJobLine(const std::string& line, const std::string& base_dir, BatchJob& job)
+		{
+			std::istringstream stream(line);
+			std::string method_name;
+			if(!(stream >> job.name >> job.mesh_file >> job.layout_file >> method_name))
+				return "expect name, mesh file, layout file and method";
+
+			job.mesh_file = ResolvePath(job.mesh_file, base_dir);
+			job.layout_file = ResolvePath(job.layout_file, base_dir);
+			job.method = ParseBatchMethod(method_name);
+			if(job.method == BATCH_METHOD_UNKNOWN) return "unknown method " + method_name;
+
+			std::string option;
+			while(stream >> option)
+			{
+				size_t pos = option.find('=');
+				if(pos == std::string::npos) return "expect key=value, get " + option;
+				if(!ParseJobOption(option.substr(0, pos), option.substr(pos+1), base_dir, job))
+					return "bad option " + option;
+			}
+			return std::string();
+		}
+	}
+
+	bool LoadBatchManifest(const std::string& file_name, std::vector<BatchJob>& job_array)
+	{
+		std::ifstream fin(file_name.c_str());
+		if(fin.fail())
+		{
+			std::cerr << "Error : cannot open manifest " << file_name << "!" << std::endl;
+			return false;
+		}
+
+		size_t slash_pos = file_name.find_last_of("/\\");
+		std::string base_dir = (slash_pos == std::string::npos) ? std::string() : file_name.substr(0, slash_pos+1);
+
+		job_array.clear();
+		std::set<std::string> name_set;
+		std::string line;
+		int line_no = 0;
+		while(std::getline(fin, line))
+		{
+			++line_no;
+			if(!line.empty() && line[line.size()-1] == '\r') line.erase(line.size()-1);
+
+			size_t first = line.find_first_not_of(" \t");
+			if(first == std::string::npos || line[first] == '#') continue;
+
+			BatchJob job;
+			std::string error = ParseJobLine(line, base_dir, job);
+			if(error.empty() && !name_set.insert(job.name).second) error = "repeated job name " + job.name;
+			if(!error.empty())
+			{
+				std::cerr << "Error : " << file_name << " line " << line_no << ", " << error << "!" << std::endl;
+				job_array.clear();
+				return false;
+			}
+			job_array.push_back(job);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef BATCHMANIFEST_H_
+#define BATCHMANIFEST_H_
+
+#include "BatchJob.h"
+
+#include <string>
+#include <vector>
+
+namespace BATCH
+{
+	//! a manifest is a text file of one job per line,
+	//!
+	//!     name mesh_file layout_file method [key=value ...]
+	//!
+	//! method is "param". the options are
+	//!     solver=chart|direct   chart parallel (default) or whole system factorization
+	//!     cores=N               cores reserved for the job, 1 by default
+	//!     cache=DIR             result cache directory, none by default
+	//!     time_limit=SECONDS    cancel the solve at its first check after it, none by default.
+	//!                           the solve checks between its loops, so a job may run a loop longer
+	//!     memory=MB             use it instead of the estimated peak memory
+	//! relative paths are relative to the manifest's directory, empty lines and
+	//! lines starting with '#' are skipped.
+	//!
+	//! false on the first malformed line or a repeated job name, the whole manifest is rejected then
+	bool LoadBatchManifest(const std::string& file_name, std::vector<BatchJob>& job_array);
+}
+
+#endif //BATCHMANIFEST_H_
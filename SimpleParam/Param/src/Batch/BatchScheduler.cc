@@ -0,0 +1,323 @@
+#include "BatchScheduler.h"
+
+#include "../Common/Parallel.h"
+#include "../Common/stopwatch.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace BATCH
+{
+	const double DEFAULT_MEMORY_BUDGET_RATIO = 0.8;
+	const double MEGA_BYTE = 1024.0*1024.0;
+
+	/* ================== Platform Primitives ================== */
+
+	class BatchScheduler::Mutex
+	{
+	public:
+#ifdef WIN32
+		CRITICAL_SECTION cs;
+		Mutex() { InitializeCriticalSection(&cs); }
+		~Mutex() { DeleteCriticalSection(&cs); }
+		void Lock() { EnterCriticalSection(&cs); }
+		void Unlock() { LeaveCriticalSection(&cs); }
+#else
+		pthread_mutex_t mutex;
+		Mutex() { pthread_mutex_init(&mutex, NULL); }
+		~Mutex() { pthread_mutex_destroy(&mutex); }
+		void Lock() { pthread_mutex_lock(&mutex); }
+		void Unlock() { pthread_mutex_unlock(&mutex); }
+#endif
+	};
+
+	class BatchScheduler::Condition
+	{
+	public:
+#ifdef WIN32
+		CONDITION_VARIABLE cond;
+		Condition() { InitializeConditionVariable(&cond); }
+		void Wait(Mutex& m) { SleepConditionVariableCS(&cond, &m.cs, INFINITE); }
+		void Broadcast() { WakeAllConditionVariable(&cond); }
+#else
+		pthread_cond_t cond;
+		Condition() { pthread_cond_init(&cond, NULL); }
+		~Condition() { pthread_cond_destroy(&cond); }
+		void Wait(Mutex& m) { pthread_cond_wait(&cond, &m.mutex); }
+		void Broadcast() { pthread_cond_broadcast(&cond); }
+#endif
+	};
+
+	class BatchScheduler::Worker
+	{
+	public:
+		BatchScheduler* scheduler;
+#ifdef WIN32
+		HANDLE thread;
+
+		static DWORD WINAPI ThreadProc(LPVOID param)
+		{
+			((Worker*) param)->scheduler->WorkerMain();
+			return 0;
+		}
+
+		bool StartThread()
+		{
+			thread = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+			return thread != NULL;
+		}
+
+		void JoinThread()
+		{
+			WaitForSingleObject(thread, INFINITE);
+			CloseHandle(thread);
+		}
+#else
+		pthread_t thread;
+
+		static void* ThreadProc(void* param)
+		{
+			((Worker*) param)->scheduler->WorkerMain();
+			return NULL;
+		}
+
+		bool StartThread()
+		{
+			return pthread_create(&thread, NULL, ThreadProc, this) == 0;
+		}
+
+		void JoinThread()
+		{
+			pthread_join(thread, NULL);
+		}
+#endif
+
+		Worker(BatchScheduler* s) : scheduler(s) {}
+	};
+
+	/* ================== Batch Scheduler ================== */
+
+	//! larger estimation first, the manifest order among equal ones
+	class LargerJobFirst
+	{
+	public:
+		LargerJobFirst(const std::vector<BatchJob>& _job_array) : job_array(_job_array) {}
+
+		bool operator()(int a, int b) const
+		{
+			if(job_array[a].estimated_memory != job_array[b].estimated_memory)
+				return job_array[a].estimated_memory > job_array[b].estimated_memory;
+			return a < b;
+		}
+
+	private:
+		const std::vector<BatchJob>& job_array;
+	};
+
+	BatchScheduler::BatchScheduler() : m_memory_budget(0), m_core_budget(0),
+		m_core_num(ParallelRuntime::Instance().GetThreadNum()),
+		m_pMutex(new Mutex), m_pDoneCond(new Condition), p_job_array(NULL), p_result_array(NULL),
+		m_used_memory(0), m_used_core_num(0), m_running_job_num(0), m_finished_job_num(0),
+		m_total_job_num(0), m_start_time(0) {}
+
+	BatchScheduler::~BatchScheduler()
+	{
+		delete m_pDoneCond;
+		delete m_pMutex;
+	}
+
+	size_t BatchScheduler::GetPhysicalMemory()
+	{
+#ifdef WIN32
+		MEMORYSTATUSEX status;
+		status.dwLength = sizeof(status);
+		if(!GlobalMemoryStatusEx(&status)) return 0;
+		return (size_t) status.ullTotalPhys;
+#else
+		long page_num = sysconf(_SC_PHYS_PAGES);
+		long page_size = sysconf(_SC_PAGE_SIZE);
+		if(page_num <= 0 || page_size <= 0) return 0;
+		return (size_t) page_num * (size_t) page_size;
+#endif
+	}
+
+	size_t BatchScheduler::GetMemoryBudget() const
+	{
+		if(m_memory_budget != 0) return m_memory_budget;
+		return (size_t) (GetPhysicalMemory()*DEFAULT_MEMORY_BUDGET_RATIO);
+	}
+
+	int BatchScheduler::GetCoreBudget() const
+	{
+		return m_core_budget > 0 ? m_core_budget : m_core_num;
+	}
+
+	int BatchScheduler::GetJobCoreNum(const BatchJob& job) const
+	{
+		return std::max(1, std::min(job.core_num, GetCoreBudget()));
+	}
+
+	void BatchScheduler::Run(std::vector<BatchJob>& job_array, std::vector<BatchJobResult>& result_array)
+	{
+		size_t memory_budget = GetMemoryBudget();
+		int core_budget = GetCoreBudget();
+
+		result_array.clear();
+		result_array.resize(job_array.size());
+
+		p_job_array = &job_array;
+		p_result_array = &result_array;
+		m_pending_job_array.clear();
+		m_used_memory = 0;
+		m_used_core_num = 0;
+		m_running_job_num = 0;
+		m_finished_job_num = 0;
+		m_total_job_num = 0;
+
+		for(size_t k=0; k<job_array.size(); ++k)
+		{
+			BatchJob& job = job_array[k];
+			if(!EstimateJobMemory(job) && job.memory_limit == 0)
+			{
+				result_array[k].status = BATCH_JOB_SKIPPED;
+				result_array[k].message = "can't read the mesh size of " + job.mesh_file;
+				std::cout << "Warning : skip job " << job.name << ", " << result_array[k].message << std::endl;
+				continue;
+			}
+			if(job.estimated_memory > memory_budget)
+			{
+				std::cout << "Warning : job " << job.name << " needs " << job.estimated_memory/MEGA_BYTE
+					<< "MB, more than the budget, it runs alone" << std::endl;
+			}
+			m_pending_job_array.push_back((int) k);
+		}
+		std::sort(m_pending_job_array.begin(), m_pending_job_array.end(), LargerJobFirst(job_array));
+		m_total_job_num = (int) m_pending_job_array.size();
+
+		//! every worker runs one job, which takes at least one core
+		int worker_num = std::min(core_budget, m_total_job_num);
+
+		std::cout << "Run " << m_total_job_num << " jobs within " << memory_budget/MEGA_BYTE << "MB and "
+			<< core_budget << " cores, " << worker_num << " at a time" << std::endl;
+
+		m_start_time = SystemStopwatch::now();
+		std::vector<Worker*> worker_array;
+		for(int k=0; k<worker_num; ++k)
+		{
+			Worker* worker = new Worker(this);
+			if(!worker->StartThread())
+			{
+				delete worker;
+				break;
+			}
+			worker_array.push_back(worker);
+		}
+
+		//! run in the calling thread when no thread could be started
+		if(worker_array.empty() && m_total_job_num > 0) WorkerMain();
+
+		for(size_t k=0; k<worker_array.size(); ++k)
+		{
+			worker_array[k]->JoinThread();
+			delete worker_array[k];
+		}
+
+		p_job_array = NULL;
+		p_result_array = NULL;
+	}
+
+	int BatchScheduler::PickJob()
+	{
+		size_t memory_budget = GetMemoryBudget();
+		int core_budget = GetCoreBudget();
+
+		for(size_t k=0; k<m_pending_job_array.size(); ++k)
+		{
+			int job_idx = m_pending_job_array[k];
+			const BatchJob& job = (*p_job_array)[job_idx];
+			int core_num = GetJobCoreNum(job);
+
+			//! anything fits when nothing runs, so an oversized job is not stuck
+			bool fit = (m_running_job_num == 0) || (m_used_memory + job.estimated_memory <= memory_budget
+				&& m_used_core_num + core_num <= core_budget);
+			if(!fit) continue;
+
+			m_pending_job_array.erase(m_pending_job_array.begin() + k);
+			m_used_memory += job.estimated_memory;
+			m_used_core_num += core_num;
+			++m_running_job_num;
+			return job_idx;
+		}
+		return -1;
+	}
+
+	void BatchScheduler::WorkerMain()
+	{
+		m_pMutex->Lock();
+		while(true)
+		{
+			int job_idx = PickJob();
+			if(job_idx == -1)
+			{
+				if(m_pending_job_array.empty()) break;
+				m_pDoneCond->Wait(*m_pMutex);
+				continue;
+			}
+
+			BatchJob job = (*p_job_array)[job_idx];
+			job.core_num = GetJobCoreNum(job);
+			BatchJobResult& result = (*p_result_array)[job_idx];
+			result.wait_time = SystemStopwatch::now() - m_start_time;
+			m_pMutex->Unlock();
+
+			RunBatchJob(job, m_output_dir, result);
+
+			m_pMutex->Lock();
+			m_used_memory -= job.estimated_memory;
+			m_used_core_num -= job.core_num;
+			--m_running_job_num;
+			++m_finished_job_num;
+			std::cout << "[" << m_finished_job_num << "/" << m_total_job_num << "] " << job.name << " "
+				<< GetBatchJobStatusName(result.status) << " in " << result.total_time << "s";
+			if(!result.message.empty()) std::cout << ", " << result.message;
+			std::cout << std::endl;
+			m_pDoneCond->Broadcast();
+		}
+		m_pMutex->Unlock();
+	}
+
+	bool WriteBatchReport(const std::string& file_name, const std::vector<BatchJob>& job_array,
+		const std::vector<BatchJobResult>& result_array)
+	{
+		std::ofstream fout(file_name.c_str());
+		if(fout.fail())
+		{
+			std::cerr << "Error : cannot write report " << file_name << "!" << std::endl;
+			return false;
+		}
+
+		fout << "name\tmethod\tstatus\tvertices\tfaces\testimated_mb\tcores\twait_s\tload_s\tlayout_s\tsolve_s\twrite_s\ttotal_s"
+			<< "\tsolve_loops\tfliped_faces\tout_range_vertices\tmean_isometric_distortion\tmessage" << std::endl;
+		for(size_t k=0; k<job_array.size() && k<result_array.size(); ++k)
+		{
+			const BatchJob& job = job_array[k];
+			const BatchJobResult& result = result_array[k];
+			fout << job.name << "\t" << GetBatchMethodName(job.method) << "\t" << GetBatchJobStatusName(result.status)
+				<< "\t" << job.vert_num << "\t" << job.face_num << "\t" << job.estimated_memory/MEGA_BYTE
+				<< "\t" << job.core_num << "\t" << result.wait_time << "\t" << result.load_time
+				<< "\t" << result.layout_time << "\t" << result.solve_time << "\t" << result.write_time
+				<< "\t" << result.total_time << "\t" << result.solve_loop_num << "\t" << result.fliped_face_num
+				<< "\t" << result.out_range_vert_num << "\t" << result.mean_isometric_distortion
+				<< "\t" << result.message << std::endl;
+		}
+		return !fout.fail();
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef BATCHSCHEDULER_H_
+#define BATCHSCHEDULER_H_
+
+#include "BatchJob.h"
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace BATCH
+{
+	//! runs the jobs of a manifest concurrently within a memory and a core budget.
+	//!
+	//! each running job holds its cores and reserves its estimated peak memory. the
+	//! pending jobs are kept largest first and a free worker takes the first one that
+	//! fits into the cores and the memory left, so the big jobs start early and the small
+	//! ones fill the gaps. a job larger than the whole budget runs alone once nothing
+	//! else runs.
+	//!
+	//! every job has its own MeshModel, Parameter and ParallelRuntime, see RunBatchJob,
+	//! so nothing is shared between the running jobs.
+	//!
+	//! the failures are contained in the job: a failed load, solve or write and any
+	//! exception, also one thrown in a parallel loop, end in its result and the others
+	//! go on. a crash still takes the whole process down, run the manifest in parts when
+	//! that is a concern
+	class BatchScheduler
+	{
+	public:
+		BatchScheduler();
+		~BatchScheduler();
+
+		//! 0 for the default, 80% of the physical memory
+		void SetMemoryBudget(size_t byte_num) { m_memory_budget = byte_num; }
+		//! 0 for the default, the number of cores
+		void SetCoreBudget(int core_num) { m_core_budget = core_num; }
+		void SetOutputDir(const std::string& output_dir) { m_output_dir = output_dir; }
+
+		size_t GetMemoryBudget() const;
+		int GetCoreBudget() const;
+
+		//! estimate and run all the jobs, block until they are done. result_array[i]
+		//! belongs to job_array[i], the estimation is left in job_array
+		void Run(std::vector<BatchJob>& job_array, std::vector<BatchJobResult>& result_array);
+
+		//! 0 when unknown
+		static size_t GetPhysicalMemory();
+
+	private:
+		class Mutex;
+		class Condition;
+		class Worker;
+
+		//! the first pending job fitting into the free cores and memory, reserved and removed
+		//! from the pending list. -1 when none fits now. called with m_pMutex locked
+		int PickJob();
+		//! cores a job runs on, its request within the budget
+		int GetJobCoreNum(const BatchJob& job) const;
+		void WorkerMain();
+
+	private:
+		size_t m_memory_budget;
+		int m_core_budget;
+		int m_core_num;				//! detected by ParallelRuntime, PARAM_THREAD_NUM overrides it
+		std::string m_output_dir;
+
+		Mutex* m_pMutex;
+		Condition* m_pDoneCond;		//! a job finished and released its budget
+
+		//! state of the current Run, guarded by m_pMutex
+		std::vector<BatchJob>* p_job_array;
+		std::vector<BatchJobResult>* p_result_array;
+		std::vector<int> m_pending_job_array;	//! largest estimation first
+		size_t m_used_memory;
+		int m_used_core_num;
+		int m_running_job_num;
+		int m_finished_job_num;
+		int m_total_job_num;
+		double m_start_time;
+
+		friend class Worker;
+	};
+
+	//! one tab separated line per job with its estimation, status, timings and quality,
+	//! in the manifest order
+	bool WriteBatchReport(const std::string& file_name, const std::vector<BatchJob>& job_array,
+		const std::vector<BatchJobResult>& result_array);
+}
+
+#endif //BATCHSCHEDULER_H_
@@ -0,0 +1,88 @@
+#include "BatchManifest.h"
+#include "BatchScheduler.h"
+#include "../Param/PatchLayoutIO.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage(const char* program)
+{
+	std::cout << "Usage : " << program << " manifest [options]\n"
+		<< "        " << program << " -convert layout_in layout_out\n"
+		<< "  -o DIR      directory of the results and the report, the current one by default\n"
+		<< "  -r FILE     report file, DIR/batch_report.txt by default\n"
+		<< "  -m MB       memory budget, 80% of the physical memory by default\n"
+		<< "  -c N        core budget, the number of cores by default\n"
+		<< "The manifest has one job per line:\n"
+		<< "  name mesh_file layout_file param [solver=chart|direct] [cores=N] [cache=DIR]"
+		<< " [time_limit=SECONDS] [memory=MB] [preview=distortion|texture|patch]\n"
+		<< "-convert rewrites a patch layout in the binary form when layout_out ends with "
+		<< PARAM::PATCH_LAYOUT_BINARY_EXT << " and in the text form otherwise" << std::endl;
+}
+
+//! 0 when all the jobs succeeded, 1 when some failed, 2 when nothing could run
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	if(strcmp(argv[1], "-convert") == 0)
+	{
+		if(argc != 4)
+		{
+			PrintUsage(argv[0]);
+			return 2;
+		}
+		return PARAM::ConvertPatchLayoutFile(argv[2], argv[3]) ? 0 : 2;
+	}
+
+	std::string manifest_file = argv[1];
+	std::string output_dir = ".";
+	std::string report_file;
+	double memory_mb = 0;
+	int core_num = 0;
+
+	for(int k=2; k<argc; ++k)
+	{
+		bool has_value = (k+1 < argc);
+		if(strcmp(argv[k], "-o") == 0 && has_value) output_dir = argv[++k];
+		else if(strcmp(argv[k], "-r") == 0 && has_value) report_file = argv[++k];
+		else if(strcmp(argv[k], "-m") == 0 && has_value) memory_mb = atof(argv[++k]);
+		else if(strcmp(argv[k], "-c") == 0 && has_value) core_num = atoi(argv[++k]);
+		else
+		{
+			PrintUsage(argv[0]);
+			return 2;
+		}
+	}
+	if(report_file.empty()) report_file = output_dir + "/batch_report.txt";
+
+	std::vector<BATCH::BatchJob> job_array;
+	if(!BATCH::LoadBatchManifest(manifest_file, job_array)) return 2;
+
+	BATCH::BatchScheduler scheduler;
+	scheduler.SetMemoryBudget((size_t) (memory_mb*1024*1024));
+	scheduler.SetCoreBudget(core_num);
+	scheduler.SetOutputDir(output_dir);
+
+	std::vector<BATCH::BatchJobResult> result_array;
+	scheduler.Run(job_array, result_array);
+
+	if(!BATCH::WriteBatchReport(report_file, job_array, result_array)) return 2;
+
+	int succeeded_num = 0;
+	for(size_t k=0; k<result_array.size(); ++k)
+	{
+		if(result_array[k].status == BATCH::BATCH_JOB_SUCCEEDED) ++succeeded_num;
+	}
+	std::cout << succeeded_num << " of " << result_array.size() << " jobs succeeded, report in "
+		<< report_file << std::endl;
+
+	return succeeded_num == (int) result_array.size() ? 0 : 1;
+}
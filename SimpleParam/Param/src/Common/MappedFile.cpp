@@ -0,0 +1,120 @@
+#include "MappedFile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef WIN32
+
+MappedFile::MappedFile() : m_pData(NULL), m_nSize(0), m_hFile(INVALID_HANDLE_VALUE), m_hMapping(NULL)
+{
+}
+
+bool MappedFile::Open(const std::string& file_name)
+{
+    Close();
+    m_hFile = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if(m_hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(m_hFile, &size))
+    {
+        Close();
+        return false;
+    }
+    m_nSize = (size_t) size.QuadPart;
+    if(m_nSize == 0)
+        return true;
+
+    m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(m_hMapping != NULL)
+        m_pData = (const char*) MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if(m_pData == NULL)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(m_pData != NULL)
+        UnmapViewOfFile(m_pData);
+    if(m_hMapping != NULL)
+        CloseHandle(m_hMapping);
+    if(m_hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(m_hFile);
+    m_pData = NULL;
+    m_nSize = 0;
+    m_hMapping = NULL;
+    m_hFile = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_hFile != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : m_pData(NULL), m_nSize(0), m_nFile(-1)
+{
+}
+
+bool MappedFile::Open(const std::string& file_name)
+{
+    Close();
+    m_nFile = open(file_name.c_str(), O_RDONLY);
+    if(m_nFile < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(m_nFile, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        Close();
+        return false;
+    }
+    m_nSize = (size_t) st.st_size;
+    if(m_nSize == 0)
+        return true;
+
+    void* data = mmap(NULL, m_nSize, PROT_READ, MAP_PRIVATE, m_nFile, 0);
+    if(data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    m_pData = (const char*) data;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(m_pData != NULL)
+        munmap((void*) m_pData, m_nSize);
+    if(m_nFile >= 0)
+        close(m_nFile);
+    m_pData = NULL;
+    m_nSize = 0;
+    m_nFile = -1;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_nFile >= 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
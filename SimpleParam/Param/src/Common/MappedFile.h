@@ -0,0 +1,65 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MappedFile.h
+//
+// [Goal]
+// A read-only memory mapping of a whole file
+//
+// The loaders of the binary formats read their arrays straight from the
+// mapping instead of copying the file into a buffer first. An empty file is
+// opened with a NULL data pointer and a zero size.
+
+
+
+#include <string>
+#include <cstddef>
+#pragma once
+
+
+
+/* ================== Mapped File ================== */
+
+class MappedFile
+{
+private:
+    const char* m_pData;
+    size_t m_nSize;
+#ifdef WIN32
+    void* m_hFile;
+    void* m_hMapping;
+#else
+    int m_nFile;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Map the file, false if it can't be opened or mapped
+    bool Open(const std::string& file_name);
+    void Close();
+
+    bool IsOpen() const;
+    const char* GetData() const { return m_pData; }
+    size_t GetSize() const { return m_nSize; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
@@ -0,0 +1,491 @@
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+
+/* ================== Platform Primitives ================== */
+
+class ParallelRuntime::Mutex
+{
+public:
+#ifdef WIN32
+    CRITICAL_SECTION cs;
+    Mutex() { InitializeCriticalSection(&cs); }
+    ~Mutex() { DeleteCriticalSection(&cs); }
+    void Lock() { EnterCriticalSection(&cs); }
+    void Unlock() { LeaveCriticalSection(&cs); }
+#else
+    pthread_mutex_t mutex;
+    Mutex() { pthread_mutex_init(&mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&mutex); }
+    void Lock() { pthread_mutex_lock(&mutex); }
+    void Unlock() { pthread_mutex_unlock(&mutex); }
+#endif
+};
+
+class ParallelRuntime::Condition
+{
+public:
+#ifdef WIN32
+    CONDITION_VARIABLE cond;
+    Condition() { InitializeConditionVariable(&cond); }
+    void Wait(Mutex& m) { SleepConditionVariableCS(&cond, &m.cs, INFINITE); }
+    void Broadcast() { WakeAllConditionVariable(&cond); }
+#else
+    pthread_cond_t cond;
+    Condition() { pthread_cond_init(&cond, NULL); }
+    ~Condition() { pthread_cond_destroy(&cond); }
+    void Wait(Mutex& m) { pthread_cond_wait(&cond, &m.mutex); }
+    void Broadcast() { pthread_cond_broadcast(&cond); }
+#endif
+};
+
+// Each worker owns a range of chunks, it pops from the front while thieves
+// take the back half
+class ParallelRuntime::Worker
+{
+public:
+    ParallelRuntime* runtime;
+    int id;
+    Mutex range_mutex;
+    int chunk_lo;
+    int chunk_hi;
+    bool canceled;              // Current job canceled, guarded by range_mutex
+    unsigned int generation;    // Last job seen by this worker
+#ifdef WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+
+    Worker(ParallelRuntime* r, int i) : runtime(r), id(i), chunk_lo(0), chunk_hi(0), canceled(false), generation(0) {}
+
+#ifdef WIN32
+    static DWORD WINAPI ThreadProc(LPVOID param)
+    {
+        Worker* w = (Worker*) param;
+        ParallelRuntime::WorkerMain(w->runtime, w->id);
+        return 0;
+    }
+
+    bool StartThread()
+    {
+        thread = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+        return thread != NULL;
+    }
+
+    void JoinThread()
+    {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+#else
+    static void* ThreadProc(void* param)
+    {
+        Worker* w = (Worker*) param;
+        ParallelRuntime::WorkerMain(w->runtime, w->id);
+        return NULL;
+    }
+
+    bool StartThread()
+    {
+        return pthread_create(&thread, NULL, ThreadProc, this) == 0;
+    }
+
+    void JoinThread()
+    {
+        pthread_join(thread, NULL);
+    }
+#endif
+};
+
+// Releases the runtime when the calling thread leaves Run, also when the
+// workers could not be started. Once the job is handed out it waits for all
+// the workers and takes the job's exception
+class ParallelRuntime::JobGuard
+{
+public:
+    ParallelRuntime* runtime;
+    boost::exception_ptr& exception;
+    bool dispatched;
+
+    JobGuard(ParallelRuntime* r, boost::exception_ptr& e) : runtime(r), exception(e), dispatched(false) {}
+
+    ~JobGuard()
+    {
+        runtime->m_pMutex->Lock();
+        if(dispatched)
+        {
+            while(runtime->m_nFinished < (int) runtime->m_Workers.size())
+                runtime->m_pDoneCond->Wait(*runtime->m_pMutex);
+        }
+        exception = runtime->m_Exception;
+        runtime->m_Exception = boost::exception_ptr();
+        runtime->m_pTask = NULL;
+        runtime->m_bBusy = false;
+        runtime->m_pDoneCond->Broadcast();
+        runtime->m_pMutex->Unlock();
+    }
+};
+
+static int GetCoreNum()
+{
+    // PARAM_THREAD_NUM overrides the detected core number
+    const char* env = getenv("PARAM_THREAD_NUM");
+    if(env != NULL && atoi(env) > 0)
+        return atoi(env);
+
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int n = (int) info.dwNumberOfProcessors;
+#else
+    int n = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n > 0 ? n : 1;
+}
+
+
+
+/* ================== Parallel Runtime ================== */
+
+// Runtime bound to each thread, NULL for the process wide one
+#ifdef WIN32
+static __declspec(thread) ParallelRuntime* s_pThreadRuntime = NULL;
+#else
+static __thread ParallelRuntime* s_pThreadRuntime = NULL;
+#endif
+
+// Constructor
+ParallelRuntime::ParallelRuntime(int nThread)
+    : m_pMutex(new Mutex), m_pWorkCond(new Condition), m_pDoneCond(new Condition),
+      m_nThread(nThread > 0 ? nThread : GetCoreNum()), m_bStarted(false), m_bStop(false), m_bBusy(false),
+      m_nGeneration(0), m_nFinished(0),
+      m_pTask(NULL), m_nBegin(0), m_nEnd(0), m_nChunkSize(1)
+{
+}
+
+// Destructor
+ParallelRuntime::~ParallelRuntime()
+{
+    Stop();
+    delete m_pDoneCond;
+    delete m_pWorkCond;
+    delete m_pMutex;
+}
+
+ParallelRuntime& ParallelRuntime::Instance()
+{
+    static ParallelRuntime runtime;
+    return runtime;
+}
+
+ParallelRuntime& ParallelRuntime::Current()
+{
+    return s_pThreadRuntime != NULL ? *s_pThreadRuntime : Instance();
+}
+
+ParallelRuntime* ParallelRuntime::Bind(ParallelRuntime* runtime)
+{
+    ParallelRuntime* previous = s_pThreadRuntime;
+    s_pThreadRuntime = runtime;
+    return previous;
+}
+
+void ParallelRuntime::SetThreadNum(int nThread)
+{
+    if(nThread < 1)
+        nThread = 1;
+
+    // Hold the runtime while the workers are replaced, the calls made
+    // meanwhile run serially
+    m_pMutex->Lock();
+    while(m_bBusy)
+        m_pDoneCond->Wait(*m_pMutex);
+    if(nThread == m_nThread)
+    {
+        m_pMutex->Unlock();
+        return;
+    }
+    m_bBusy = true;
+    m_pMutex->Unlock();
+
+    Stop();
+
+    m_pMutex->Lock();
+    m_nThread = nThread;
+    m_bBusy = false;
+    m_pDoneCond->Broadcast();
+    m_pMutex->Unlock();
+}
+
+int ParallelRuntime::ChunkSize(int n, int grain)
+{
+    if(grain > 0)
+        return grain;
+    // At most 256 chunks, with at least 1024 indices each
+    int chunk = (n+255)/256;
+    return chunk < 1024 ? 1024 : chunk;
+}
+
+void ParallelRuntime::Start()
+{
+    if(m_bStarted)
+        return;
+
+    m_bStop = false;
+    m_Workers.resize(m_nThread);
+    for(int i = 0; i < m_nThread; ++ i)
+    {
+        m_Workers[i] = new Worker(this, i);
+        m_Workers[i]->generation = m_nGeneration;
+    }
+    // Worker 0 is the calling thread
+    for(int i = 1; i < m_nThread; ++ i)
+    {
+        if(!m_Workers[i]->StartThread())
+        {
+            // Run with the threads created so far
+            for(int j = i; j < m_nThread; ++ j)
+                delete m_Workers[j];
+            m_Workers.resize(i);
+            m_nThread = i;
+            break;
+        }
+    }
+    m_bStarted = true;
+}
+
+void ParallelRuntime::Stop()
+{
+    if(!m_bStarted)
+        return;
+
+    m_pMutex->Lock();
+    m_bStop = true;
+    m_pWorkCond->Broadcast();
+    m_pMutex->Unlock();
+
+    for(size_t i = 1; i < m_Workers.size(); ++ i)
+        m_Workers[i]->JoinThread();
+    for(size_t i = 0; i < m_Workers.size(); ++ i)
+        delete m_Workers[i];
+    m_Workers.clear();
+    m_bStarted = false;
+}
+
+void ParallelRuntime::Run(ParallelTask& task, int begin, int end, int grain)
+{
+    if(end <= begin)
+        return;
+
+    int chunk = ChunkSize(end-begin, grain);
+    int nChunk = (end-begin+chunk-1)/chunk;
+
+    // Serial execution for single chunk, single thread or nested call
+    bool bSerial = (nChunk == 1);
+    if(!bSerial)
+    {
+        m_pMutex->Lock();
+        bSerial = (m_bBusy || m_nThread == 1);
+        if(!bSerial)
+            m_bBusy = true;
+        m_pMutex->Unlock();
+    }
+    if(bSerial)
+    {
+        for(int b = begin; b < end; b += chunk)
+            task.Run(b, std::min(b+chunk, end));
+        return;
+    }
+
+    boost::exception_ptr exception;
+    {
+        JobGuard guard(this, exception);
+
+        Start();
+
+        m_pMutex->Lock();
+        m_pTask = &task;
+        m_nBegin = begin;
+        m_nEnd = end;
+        m_nChunkSize = chunk;
+        m_nFinished = 0;
+
+        // Initial even distribution of the chunks over the workers
+        int nWorker = (int) m_Workers.size();
+        for(int i = 0; i < nWorker; ++ i)
+        {
+            Worker* w = m_Workers[i];
+            w->range_mutex.Lock();
+            w->chunk_lo = (int) ((long long) nChunk*i/nWorker);
+            w->chunk_hi = (int) ((long long) nChunk*(i+1)/nWorker);
+            w->canceled = false;
+            w->range_mutex.Unlock();
+        }
+        ++ m_nGeneration;
+        guard.dispatched = true;
+        m_pWorkCond->Broadcast();
+        m_pMutex->Unlock();
+
+        // The chunks catch their exceptions, so the caller always gets here
+        ExecuteJob(0);
+        FinishJob();
+    }
+
+    if(exception)
+        boost::rethrow_exception(exception);
+}
+
+void ParallelRuntime::WorkerMain(ParallelRuntime* runtime, int id)
+{
+    // A loop started from a body finds the runtime busy and runs serially
+    Bind(runtime);
+    Worker* self = runtime->m_Workers[id];
+    for(;;)
+    {
+        runtime->m_pMutex->Lock();
+        while(!runtime->m_bStop && self->generation == runtime->m_nGeneration)
+            runtime->m_pWorkCond->Wait(*runtime->m_pMutex);
+        if(runtime->m_bStop)
+        {
+            runtime->m_pMutex->Unlock();
+            return;
+        }
+        self->generation = runtime->m_nGeneration;
+        runtime->m_pMutex->Unlock();
+
+        runtime->ExecuteJob(id);
+        runtime->FinishJob();
+    }
+}
+
+void ParallelRuntime::FinishJob()
+{
+    m_pMutex->Lock();
+    ++ m_nFinished;
+    if(m_nFinished == (int) m_Workers.size())
+        m_pDoneCond->Broadcast();
+    m_pMutex->Unlock();
+}
+
+void ParallelRuntime::ExecuteJob(int id)
+{
+    int chunk;
+    for(;;)
+    {
+        if(!PopChunk(id, chunk) && !(StealChunks(id) && PopChunk(id, chunk)))
+            break;
+        int b = m_nBegin + chunk*m_nChunkSize;
+        int e = std::min(b+m_nChunkSize, m_nEnd);
+        try
+        {
+            m_pTask->Run(b, e);
+        }
+        catch(...)
+        {
+            m_pMutex->Lock();
+            if(!m_Exception)
+                m_Exception = boost::current_exception();
+            m_pMutex->Unlock();
+            CancelJob();
+        }
+    }
+}
+
+void ParallelRuntime::CancelJob()
+{
+    // Empty the ranges, the chunks being run still finish. The flag stops a
+    // thief from installing a range it took before the victim was emptied
+    for(size_t i = 0; i < m_Workers.size(); ++ i)
+    {
+        Worker* w = m_Workers[i];
+        w->range_mutex.Lock();
+        w->chunk_lo = w->chunk_hi;
+        w->canceled = true;
+        w->range_mutex.Unlock();
+    }
+}
+
+bool ParallelRuntime::PopChunk(int id, int& chunk)
+{
+    Worker* w = m_Workers[id];
+    w->range_mutex.Lock();
+    bool bFound = (w->chunk_lo < w->chunk_hi);
+    if(bFound)
+        chunk = w->chunk_lo ++;
+    w->range_mutex.Unlock();
+    return bFound;
+}
+
+bool ParallelRuntime::StealChunks(int id)
+{
+    int nWorker = (int) m_Workers.size();
+    for(int k = 1; k < nWorker; ++ k)
+    {
+        Worker* victim = m_Workers[(id+k)%nWorker];
+        int lo = 0, hi = 0;
+        victim->range_mutex.Lock();
+        if(victim->chunk_lo < victim->chunk_hi)
+        {
+            // Take the back half, at least one chunk
+            lo = victim->chunk_lo + (victim->chunk_hi-victim->chunk_lo)/2;
+            hi = victim->chunk_hi;
+            victim->chunk_hi = lo;
+        }
+        victim->range_mutex.Unlock();
+
+        if(lo < hi)
+        {
+            // The stolen chunks are dropped if the job was canceled meanwhile
+            Worker* self = m_Workers[id];
+            self->range_mutex.Lock();
+            bool bCanceled = self->canceled;
+            if(!bCanceled)
+            {
+                self->chunk_lo = lo;
+                self->chunk_hi = hi;
+            }
+            self->range_mutex.Unlock();
+            return !bCanceled;
+        }
+    }
+    return false;
+}
+
+
+
+/* ================== Locks ================== */
+
+ParallelMutex::ParallelMutex()
+{
+    m_pMutex = new ParallelRuntime::Mutex;
+}
+
+ParallelMutex::ParallelMutex(const ParallelMutex&)
+{
+    m_pMutex = new ParallelRuntime::Mutex;
+}
+
+ParallelMutex::~ParallelMutex()
+{
+    delete m_pMutex;
+}
+
+void ParallelMutex::Lock()
+{
+    m_pMutex->Lock();
+}
+
+void ParallelMutex::Unlock()
+{
+    m_pMutex->Unlock();
+}
@@ -0,0 +1,263 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// Parallel.h
+//
+// [Goal]
+// A small work-stealing thread pool with parallel_for and parallel_reduce
+//
+// A range [begin, end) is cut into chunks whose size only depends on the
+// range length and the grain size, so the chunks -- and the order in which
+// parallel_reduce joins their partial results -- do not depend on the thread
+// number. Results are thus the same for any number of threads.
+//
+// Bodies are functors, parallel_for calls body(i) for each index and
+// parallel_reduce calls body(chunk_begin, chunk_end, identity) for each chunk.
+// A parallel call issued while the pool is busy (e.g. from inside a body)
+// runs serially in the calling thread.
+//
+// An exception thrown by a body, in any thread, stops the chunks not yet
+// started and the first one is rethrown in the calling thread once all the
+// threads are done with the job.
+//
+// The loops run on the runtime bound to the calling thread by a
+// ParallelRuntimeScope, the process wide one by default. Work that must not
+// wait for the others, like the jobs of the batch driver, gives each thread
+// a runtime of its own.
+
+
+
+#include <vector>
+#include <boost/exception_ptr.hpp>
+#pragma once
+
+
+
+/* ================== Parallel Task ================== */
+
+class ParallelTask
+{
+public:
+    virtual ~ParallelTask() {}
+
+    // Process the indices [begin, end), called once per chunk
+    virtual void Run(int begin, int end) = 0;
+};
+
+
+
+/* ================== Parallel Runtime ================== */
+
+class ParallelRuntime
+{
+private:
+    class Worker;
+    class Mutex;
+    class Condition;
+    class JobGuard;
+
+    std::vector<Worker*> m_Workers;     // m_Workers[0] is the calling thread
+    Mutex* m_pMutex;
+    Condition* m_pWorkCond;
+    Condition* m_pDoneCond;
+
+    int  m_nThread;
+    bool m_bStarted;
+    bool m_bStop;
+    bool m_bBusy;
+    unsigned int m_nGeneration;         // Bumped for each job
+    int  m_nFinished;                   // Number of workers done with current job
+    boost::exception_ptr m_Exception;   // First exception thrown by the current job
+
+    // Current job
+    ParallelTask* m_pTask;
+    int m_nBegin;
+    int m_nEnd;
+    int m_nChunkSize;
+
+public:
+    // A runtime of nThread threads, 0 for the number of cores
+    explicit ParallelRuntime(int nThread = 0);
+
+    // Destructor
+    ~ParallelRuntime();
+
+    // Get the process wide runtime
+    static ParallelRuntime& Instance();
+
+    // Get the runtime bound to the calling thread, the process wide one when none is
+    static ParallelRuntime& Current();
+
+    // Number of threads including the calling one, default to the number of cores.
+    // SetThreadNum waits for the running job, it must not be called from a body
+    int  GetThreadNum() const { return m_nThread; }
+    void SetThreadNum(int nThread);
+
+    // Run task on the chunks of [begin, end) and wait until all are done,
+    // rethrows the first exception of the task
+    void Run(ParallelTask& task, int begin, int end, int grain);
+
+    // Chunk size used for a range of n indices
+    static int ChunkSize(int n, int grain);
+
+private:
+    ParallelRuntime(const ParallelRuntime&);
+    ParallelRuntime& operator=(const ParallelRuntime&);
+
+    void Start();
+    void Stop();
+
+    void ExecuteJob(int id);
+    bool PopChunk(int id, int& chunk);
+    bool StealChunks(int id);
+    void CancelJob();
+    void FinishJob();
+
+    static void WorkerMain(ParallelRuntime* runtime, int id);
+
+    // Bind runtime to the calling thread and return the previous one
+    static ParallelRuntime* Bind(ParallelRuntime* runtime);
+
+    friend class Worker;
+    friend class JobGuard;
+    friend class ParallelRuntimeScope;
+    friend class ParallelMutex;
+};
+
+// Binds a runtime to the calling thread for the scope's lifetime
+class ParallelRuntimeScope
+{
+private:
+    ParallelRuntime* m_pPrevious;
+
+public:
+    ParallelRuntimeScope(ParallelRuntime& runtime) : m_pPrevious(ParallelRuntime::Bind(&runtime)) {}
+    ~ParallelRuntimeScope() { ParallelRuntime::Bind(m_pPrevious); }
+
+private:
+    ParallelRuntimeScope(const ParallelRuntimeScope&);
+    ParallelRuntimeScope& operator=(const ParallelRuntimeScope&);
+};
+
+
+
+/* ================== Locks ================== */
+
+// A mutex for data built on demand and shared by the threads, not recursive.
+// A copy gets a mutex of its own, so the owner stays copyable
+class ParallelMutex
+{
+private:
+    ParallelRuntime::Mutex* m_pMutex;
+
+public:
+    ParallelMutex();
+    ParallelMutex(const ParallelMutex&);
+    ~ParallelMutex();
+
+    ParallelMutex& operator=(const ParallelMutex&) { return *this; }
+
+    void Lock();
+    void Unlock();
+};
+
+// Holds a ParallelMutex for the scope's lifetime
+class ParallelLock
+{
+private:
+    ParallelMutex& m_Mutex;
+
+public:
+    ParallelLock(ParallelMutex& mutex) : m_Mutex(mutex) { m_Mutex.Lock(); }
+    ~ParallelLock() { m_Mutex.Unlock(); }
+
+private:
+    ParallelLock(const ParallelLock&);
+    ParallelLock& operator=(const ParallelLock&);
+};
+
+
+
+/* ================== Parallel Functions ================== */
+
+template <class Body>
+class ParallelForTask : public ParallelTask
+{
+private:
+    const Body& body;
+
+public:
+    ParallelForTask(const Body& b) : body(b) {}
+
+    void Run(int begin, int end)
+    {
+        for(int i = begin; i < end; ++ i)
+            body(i);
+    }
+};
+
+template <class T, class Body>
+class ParallelReduceTask : public ParallelTask
+{
+private:
+    const Body& body;
+    const T& identity;
+    int first;
+    int chunk;
+    std::vector<T>& partial;
+
+public:
+    ParallelReduceTask(const Body& b, const T& id, int f, int c, std::vector<T>& p)
+        : body(b), identity(id), first(f), chunk(c), partial(p) {}
+
+    void Run(int begin, int end)
+    {
+        partial[(begin-first)/chunk] = body(begin, end, identity);
+    }
+};
+
+// Call body(i) for each i in [begin, end)
+template <class Body>
+void parallel_for(int begin, int end, const Body& body, int grain = 0)
+{
+    if(end <= begin)
+        return;
+    ParallelForTask<Body> task(body);
+    ParallelRuntime::Current().Run(task, begin, end, grain);
+}
+
+// Reduce [begin, end) as join(...join(join(identity, p0), p1)..., pn) with
+// p_k = body(chunk_begin_k, chunk_end_k, identity)
+template <class T, class Body, class Join>
+T parallel_reduce(int begin, int end, const T& identity, const Body& body, const Join& join, int grain = 0)
+{
+    if(end <= begin)
+        return identity;
+
+    int chunk = ParallelRuntime::ChunkSize(end-begin, grain);
+    int nChunk = (end-begin+chunk-1)/chunk;
+    std::vector<T> partial(nChunk, identity);
+
+    ParallelReduceTask<T, Body> task(body, identity, begin, chunk, partial);
+    ParallelRuntime::Current().Run(task, begin, end, grain);
+
+    T result = identity;
+    for(int k = 0; k < nChunk; ++ k)
+        result = join(result, partial[k]);
+    return result;
+}
@@ -3,6 +3,7 @@
 #include "../Param/Parameter.h"
 #include "../Param/ParamDrawer.h"
 #include "../ModelMesh/MeshModel.h"
+#include "SolveJob.h"
 #include <fstream>
 
 CrossParamControl::CrossParamControl(QGLViewer* _gl_viewer_1, QGLViewer* _gl_viewer_2, QWidget* parent)
@@ -19,6 +20,9 @@ CrossParamControl::CrossParamControl(QGLViewer* _gl_viewer_1, QGLViewer* _gl_vie
     m_corresponding_group = CreateCorrespondingGroup(this);
     
 	CreateMainLayout();
+
+	m_cross_param_timer = new QTimer(this);
+	connect(m_cross_param_timer, SIGNAL(timeout()), this, SLOT(PollCrossParamJob()));
 }
 
 QGroupBox* CrossParamControl::CreateSurface1Group(QWidget* parent /* = 0 */)
@@ -36,6 +40,8 @@ QGroupBox* CrossParamControl::CreateSurface1Group(QWidget* parent /* = 0 */)
 // 	optimize_ambiguity_patch->setText(tr("Optimize Ambiguity Patch"));
 	QPushButton* parameter_1 = new QPushButton(surface_1_group);
 	parameter_1->setText(tr("Parameter"));
+	QPushButton* move_conner_1 = new QPushButton(surface_1_group);
+	move_conner_1->setText(tr("Move Conner To Selected Vertex"));
 
 	/// layout
 	QVBoxLayout* surface_1_layout = new QVBoxLayout(surface_1_group);
@@ -43,12 +49,14 @@ QGroupBox* CrossParamControl::CreateSurface1Group(QWidget* parent /* = 0 */)
 	surface_1_layout->addWidget(load_surface_1_patch);
 //	surface_1_layout->addWidget(optimize_ambiguity_patch);
 	surface_1_layout->addWidget(parameter_1);
+	surface_1_layout->addWidget(move_conner_1);
 
 	/// connections
 	connect(load_surface_1_mesh, SIGNAL(clicked()), m_gl_viewer_1, SLOT(loadMeshModel()));
 	connect(load_surface_1_patch, SIGNAL(clicked()), m_gl_viewer_1, SLOT(loadQuadFile()));
 //	connect(optimize_ambiguity_patch, SIGNAL(clicked()), m_gl_viewer_1, SLOT(OptimizeAmbiguityPatch()));
 	connect(parameter_1, SIGNAL(clicked()), m_gl_viewer_1, SLOT(SolveParameter()));
+	connect(move_conner_1, SIGNAL(clicked()), m_gl_viewer_1, SLOT(MovePatchConner()));
 
 	return surface_1_group;
 }
@@ -102,15 +110,21 @@ QGroupBox* CrossParamControl::CreateCrossParamGroup(QWidget* parent /* = 0 */)
 	compute_cross_parameter->setText(tr("Compute Cross Parameter"));
 	QPushButton* optimizer = new QPushButton(cross_param_group);
 	optimizer->setText(tr("Cross Parameter Optimize"));
+	QPushButton* cancel_solve = new QPushButton(cross_param_group);
+	cancel_solve->setText(tr("Cancel Solving"));
 
 	/// layout
 	QVBoxLayout* cross_parameter_layout = new QVBoxLayout(cross_param_group);
 	cross_parameter_layout->addWidget(compute_cross_parameter);
 	cross_parameter_layout->addWidget(optimizer);
+	cross_parameter_layout->addWidget(cancel_solve);
 
 	/// connections
 	connect(compute_cross_parameter, SIGNAL(clicked()), this, SLOT(ComputeCrossParam()));
 	connect(optimizer, SIGNAL(clicked()), this, SLOT(OptimizeCrossParam()));
+	connect(cancel_solve, SIGNAL(clicked()), this, SLOT(CancelSolve()));
+	connect(cancel_solve, SIGNAL(clicked()), m_gl_viewer_1, SLOT(CancelSolve()));
+	connect(cancel_solve, SIGNAL(clicked()), m_gl_viewer_2, SLOT(CancelSolve()));
 
 	return cross_param_group;
 }
@@ -247,6 +261,8 @@ QGroupBox* CrossParamControl::CreateCorrespondingGroup(QWidget* parent /* = 0 */
 
 void CrossParamControl::LoadCorrespondingFile()
 {
+	if(IsSolving()) return;
+
 	std::string prev_file_path;
 	ifstream fin ("open_file_path.txt");
 	if(!fin.fail()){
@@ -283,6 +299,7 @@ void CrossParamControl::LoadCorrespondingFile()
 
 void CrossParamControl::FindCorrespondingOnA()
 {
+	if(IsSolving() || m_gl_viewer_1->IsSolving() || m_gl_viewer_2->IsSolving()) return;
 	int vid = m_gl_viewer_2->p_param_drawer->GetSelectedVertID();
 	if(vid == -1) return;
 	if(m_gl_viewer_2->p_param == NULL) return;
@@ -299,6 +316,7 @@ void CrossParamControl::FindCorrespondingOnA()
 
 void CrossParamControl::FindCorrespondingOnB()
 {
+	if(IsSolving() || m_gl_viewer_1->IsSolving() || m_gl_viewer_2->IsSolving()) return;
 //	int vid = m_gl_viewer_1->p_param_drawer->GetSelectedVertID();
 	PARAM::SurfaceCoord surf_coord = m_gl_viewer_1->p_param_drawer->GetSelectedSurfaceCorod();
 	if(surf_coord.face_index == -1) return;
@@ -309,11 +327,11 @@ void CrossParamControl::FindCorrespondingOnB()
 	int fid = surf_coord.face_index;
 	PARAM::Barycentrc baryc = surf_coord.barycentric;
 
-	const PolyIndexArray& fIndex1 = m_gl_viewer_1->p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-	const PolyIndexArray& fIndex2 = m_gl_viewer_2->p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+	const FaceInfo& fInfo1 = m_gl_viewer_1->p_mesh->m_Kernel.GetFaceInfo();
+	const FaceInfo& fInfo2 = m_gl_viewer_2->p_mesh->m_Kernel.GetFaceInfo();
 	const CoordArray& vCoord2 = m_gl_viewer_2->p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-	const IndexArray& face1 = fIndex1[fid];
+	const int* face1 = fInfo1.GetFaceVertices(fid);
 	std::vector<PARAM::SurfaceCoord> face_vert_sf_vec(3);
 	std::vector<Coord> face_vert_coord_vec(3); 
 	for(int i=0; i<3; ++i)
@@ -323,7 +341,7 @@ void CrossParamControl::FindCorrespondingOnB()
 		int _fid = surf_coord.face_index;
 		if(_fid == -1) { std::cerr <<" Fid == -1" << std::endl; return;}
 		PARAM::Barycentrc _baryc = surf_coord.barycentric;
-		const IndexArray& face2 = fIndex2[_fid];	
+		const int* face2 = fInfo2.GetFaceVertices(_fid);	
 		face_vert_coord_vec[i] = vCoord2[face2[0]]*_baryc[0] + vCoord2[face2[1]]*_baryc[1] + vCoord2[face2[2]]*_baryc[2];
 
 	//	int chart_id = m_gl_viewer_1->p_param->GetVertexChartID(vid);
@@ -348,8 +366,46 @@ void CrossParamControl::ComputeCrossParam()
 {
 	if(m_gl_viewer_1 == 0 || m_gl_viewer_2 == 0) return;
 	if(m_gl_viewer_1->p_param == 0 || m_gl_viewer_2->p_param == 0) return;
+	if(p_cross_parameter == NULL || IsSolving()) return;
+	if(m_gl_viewer_1->IsSolving() || m_gl_viewer_2->IsSolving()) return;
+
+	p_cross_param_job = boost::shared_ptr<SolveJob> (new CrossParamJob(p_cross_parameter));
+	p_cross_param_job->start();
+	m_cross_param_timer->start(SOLVE_POLL_INTERVAL);
+	//! the job reads both parameterizations
+	m_surface_1_group->setEnabled(false);
+	m_surface_2_group->setEnabled(false);
+	emit solve_message(tr("Finding corresponding"));
+}
+
+void CrossParamControl::CancelSolve()
+{
+	if(p_cross_param_job) p_cross_param_job->Cancel();
+}
+
+void CrossParamControl::PollCrossParamJob()
+{
+	if(p_cross_param_job == NULL)
+	{
+		m_cross_param_timer->stop();
+		return;
+	}
 
-	p_cross_parameter->FindCorrespondingAB();
+	SolveProgress progress;
+	if(p_cross_param_job->PollProgress(progress)) emit solve_message(progress.ToString());
+	if(!p_cross_param_job->isFinished()) return;
+
+	m_cross_param_timer->stop();
+	p_cross_param_job->wait();
+	SolveJobResult result = p_cross_param_job->GetResult();
+	QString error_message = QString::fromLocal8Bit(p_cross_param_job->GetErrorMessage().c_str());
+	p_cross_param_job.reset();
+	m_surface_1_group->setEnabled(true);
+	m_surface_2_group->setEnabled(true);
+	if(result == SOLVE_JOB_SUCCEEDED) emit solve_message(tr("Corresponding done"));
+	else if(result == SOLVE_JOB_CANCELED) emit solve_message(tr("Corresponding canceled"));
+	else if(error_message.isEmpty()) emit solve_message(tr("Corresponding failed"));
+	else emit solve_message(tr("Corresponding failed: %1").arg(error_message));
 
 // 	p_cross_parameter->FindCorrespondingBA();
 // 	p_cross_parameter->VertTextureTransferBA();
@@ -8,6 +8,8 @@ namespace PARAM
 	class CrossParameter;
 }
 
+class SolveJob;
+
 class CrossParamControl : public QWidget
 {
 	Q_OBJECT
@@ -30,9 +32,16 @@ public:
 	void FindCorrespondingOnA();
 	void FindCorrespondingOnB();
 
+	bool IsSolving() const { return p_cross_param_job != NULL; }
+
+signals:
+	void solve_message(const QString& message);
+
 private slots:
 	void ComputeCrossParam();
 	void OptimizeCrossParam();
+	void CancelSolve();
+	void PollCrossParamJob();
 
 	void LoadCorrespondingFile();
 
@@ -59,6 +68,9 @@ private:
 
 	boost::shared_ptr<PARAM::CrossParameter> p_cross_parameter;
 
+	boost::shared_ptr<SolveJob> p_cross_param_job;
+	QTimer* m_cross_param_timer;
+
 };
 
 #endif
\ No newline at end of file
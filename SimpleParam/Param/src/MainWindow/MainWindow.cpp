@@ -46,6 +46,9 @@ MainWindow::MainWindow(QWidget *parent):QMainWindow(parent)
 	setWindowTitle("Cross Parameter");
 
 	connect(glViewer_1, SIGNAL(select_vertex()), this, SLOT(findCorrespondingOnB()));
+	connect(glViewer_1, SIGNAL(solve_message(const QString&)), statusBar(), SLOT(showMessage(const QString&)));
+	connect(glViewer_2, SIGNAL(solve_message(const QString&)), statusBar(), SLOT(showMessage(const QString&)));
+	connect(m_cross_param_control, SIGNAL(solve_message(const QString&)), statusBar(), SLOT(showMessage(const QString&)));
     //	connect(glViewer_2, SIGNAL(select_vertex()), this, SLOT(findCorrespondingOnA()));
 }
 
@@ -17,7 +17,9 @@
 #include "../UI/UIHandler.h"
 #include "../Common/Utility.h"
 #include "../Param/Parameter.h"
+#include "../Param/ChartCreator.h"
 #include "../Param/ParamDrawer.h"
+#include "SolveJob.h"
 using namespace Qt;
 
 
@@ -34,6 +36,13 @@ QGLViewer::QGLViewer( QWidget* _parent )
 
 QGLViewer::~QGLViewer()
 {
+	p_solve_job.reset();
+
+	// the drawers free their buffer objects, while the context is still there
+	makeCurrent();
+	p_param_drawer.reset();
+	p_param.reset();
+	p_mesh.reset();
 }
 
 //----------------------------------------------------------------------------
@@ -70,6 +79,9 @@ void QGLViewer::init(void)
 	p_param = boost::shared_ptr<PARAM::Parameter> (new PARAM::Parameter(p_mesh));
 	p_param_drawer = boost::shared_ptr<PARAM::ParamDrawer> (new
 		PARAM::ParamDrawer(*p_param.get()));
+
+	m_solve_timer = new QTimer(this);
+	connect(m_solve_timer, SIGNAL(timeout()), this, SLOT(PollSolveJob()));
 }
 
 
@@ -141,6 +153,8 @@ void QGLViewer::createPopMenu()
 // ----------------- public slots ------------------
 void QGLViewer::loadMeshModel()
 {
+	if(IsSolving()) return;
+
 	std::string prev_file_name;
 	ifstream fin ("open_file_path.txt");
 	if(!fin.fail()){
@@ -159,8 +173,10 @@ void QGLViewer::loadMeshModel()
 	if(f.size()!=0)
 	{
 		// add your codes here
+		makeCurrent();
 		p_mesh->ClearData();
 		p_mesh->AttachModel(f);
+		p_mesh->ReorderModel();
 		Coord center;
 		double radius;
 		p_mesh->m_Kernel.GetModelInfo().GetBoundingSphere(center, radius);
@@ -261,6 +277,8 @@ int QGLViewer::loadTextureImage()
 }
 int QGLViewer::loadQuadFile()
 {
+	if(IsSolving()) return -1;
+
 	std::string prev_file_path;
 	ifstream fin ("open_file_path.txt");
 	if(!fin.fail()){
@@ -279,11 +297,24 @@ int QGLViewer::loadQuadFile()
 	{
 		if(p_mesh)
 		{
+			makeCurrent();
 			p_param = boost::shared_ptr<PARAM::Parameter> (new PARAM::Parameter(p_mesh));
 			p_param_drawer = boost::shared_ptr<PARAM::ParamDrawer> (new
 				PARAM::ParamDrawer(*p_param.get()));
+
+			// a solved layout is cached next to the mesh, solving it again loads the result
+			std::string mesh_file_name = p_mesh->GetModelFileName();
+			size_t slash = mesh_file_name.find_last_of("/\\");
+			p_param->SetResultCacheDir(slash == std::string::npos ? std::string(".") : mesh_file_name.substr(0, slash));
 			
-			p_param->LoadPatchFile(f);		
+			if(!p_param->LoadPatchFile(f))
+			{
+				p_param.reset();
+				p_param_drawer.reset();
+				updateGL();
+				emit solve_message(tr("Can't load the patch file %1, see the console for the error").arg(fileName));
+				return -1;
+			}
 
 			updateGL();
 
@@ -326,18 +357,143 @@ void QGLViewer::CreateBoundaryTexture()
 
 void QGLViewer::OptimizeAmbiguityPatch()
 {
-	if(p_param == NULL) return;
+	if(p_param == NULL || IsSolving()) return;
 	p_param->OptimizeAmbiguityPatch();
 	updateGL();
 }
 
 void QGLViewer::SolveParameter()
 {
-	if(p_param == NULL) return;
-	p_param->ComputeParamCoord();
+	if(p_param == NULL || IsSolving()) return;
+	p_solve_job = boost::shared_ptr<SolveJob> (new ParamSolveJob(p_param));
+	p_solve_job->start();
+	m_solve_timer->start(SOLVE_POLL_INTERVAL);
+	emit solve_message(tr("Parameterizing, press Esc to cancel"));
+}
+
+void QGLViewer::MovePatchConner()
+{
+	if(p_param == NULL || p_param_drawer == NULL || IsSolving()) return;
+	boost::shared_ptr<PARAM::ChartCreator> p_chart_creator = p_param->GetChartCreator();
+	if(p_chart_creator == NULL) return;
+
+	int vid = p_param_drawer->GetSelectedVertID();
+	if(vid == -1)
+	{
+		emit solve_message(tr("Select the new conner vertex first"));
+		return;
+	}
+
+	boost::shared_ptr<PARAM::ParamEditState> p_state(new PARAM::ParamEditState);
+	p_param->SaveEditState(*p_state);
+
+	std::vector<int> edited_patch_array;
+	int conner_idx = p_chart_creator->FindNearestPatchConner(vid);
+	if(conner_idx == -1 || !p_chart_creator->MovePatchConner(conner_idx, vid, edited_patch_array))
+	{
+		emit solve_message(tr("Can't move the conner to the selected vertex"));
+		return;
+	}
+	p_param_drawer->InvalidateOverlay();
+	p_edit_state = p_state;
+
+	p_solve_job = boost::shared_ptr<SolveJob> (new ParamUpdateJob(p_param, edited_patch_array));
+	p_solve_job->start();
+	m_solve_timer->start(SOLVE_POLL_INTERVAL);
+	emit solve_message(tr("Updating the parameterization, press Esc to cancel"));
+}
+
+void QGLViewer::CancelSolve()
+{
+	if(p_solve_job) p_solve_job->Cancel();
+}
+
+void QGLViewer::PollSolveJob()
+{
+	if(p_solve_job == NULL)
+	{
+		m_solve_timer->stop();
+		return;
+	}
+
+	SolveProgress progress;
+	if(p_solve_job->PollProgress(progress)) emit solve_message(progress.ToString());
+
+	const std::vector<double>* face_param_coord = p_solve_job->TakeSnapshot();
+	if(face_param_coord) ApplyFaceParamCoord(*face_param_coord);
+
+	if(p_solve_job->isFinished())
+	{
+		m_solve_timer->stop();
+		p_solve_job->wait();
+		SolveJobResult result = p_solve_job->GetResult();
+		QString error_message = QString::fromLocal8Bit(p_solve_job->GetErrorMessage().c_str());
+		p_solve_job.reset();
+
+		/// an edit whose update didn't finish is undone, with the solution it started from
+		bool edit_undone = (result != SOLVE_JOB_SUCCEEDED && p_edit_state);
+		if(edit_undone)
+		{
+			p_param->RestoreEditState(*p_edit_state);
+			if(!p_param->GetVertexParamCoordArray().empty())
+			{
+				std::vector<double> param_coord;
+				p_param->GatherFaceParamCoord(param_coord);
+				ApplyFaceParamCoord(param_coord);
+			}
+			p_param_drawer->InvalidateOverlay();
+		}
+		p_edit_state.reset();
+
+		if(result == SOLVE_JOB_SUCCEEDED)
+		{
+			std::vector<double> final_param_coord;
+			p_param->GatherFaceParamCoord(final_param_coord);
+			ApplyFaceParamCoord(final_param_coord);
+			p_param->UpdateMeshColor();
+			p_param_drawer->InvalidateOverlay();
+			emit solve_message(tr("Parameterization done"));
+		}else
+		{
+			QString message;
+			if(result == SOLVE_JOB_CANCELED) message = tr("Parameterization canceled");
+			else if(error_message.isEmpty()) message = tr("Parameterization failed, see the console for the error");
+			else message = tr("Parameterization failed: %1").arg(error_message);
+			if(edit_undone) message += tr(", the layout edit is undone");
+			emit solve_message(message);
+		}
+	}
 	updateGL();
 }
 
+void QGLViewer::ApplyFaceParamCoord(const std::vector<double>& face_param_coord)
+{
+	size_t face_num = face_param_coord.size() / 6;
+	if(face_num != p_mesh->m_Kernel.GetFaceInfo().GetFaceNum()) return;
+
+	//! the render buffer reads per corner texture coordinates through the face texture indices
+	PolyTexCoordArray& face_tex_coord = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
+	PolyIndexArray& face_tex_index = p_mesh->m_Kernel.GetFaceInfo().GetTexIndex();
+	TexCoordArray& corner_tex_coord = p_mesh->m_Kernel.GetVertexInfo().GetTexCoord();
+	face_tex_coord.resize(face_num);
+	face_tex_index.resize(face_num);
+	corner_tex_coord.resize(face_num*3);
+	for(size_t fid = 0; fid < face_num; ++fid)
+	{
+		const double* pc = &face_param_coord[fid*6];
+		face_tex_coord[fid].resize(3);
+		face_tex_index[fid].resize(3);
+		for(int k = 0; k < 3; ++k)
+		{
+			TexCoord tex(pc[2*k], pc[2*k+1]);
+			face_tex_coord[fid][k] = tex;
+			corner_tex_coord[fid*3+k] = tex;
+			face_tex_index[fid][k] = (int) fid*3 + k;
+		}
+	}
+	p_mesh->m_Render.Invalidate(RENDER_BUFFER_TEXCOORD);
+}
+
 void QGLViewer::LoadFaceTexCoord()
 {
 	if(p_mesh == NULL) return;
@@ -360,9 +516,9 @@ void QGLViewer::LoadFaceTexCoord()
 		if(p_mesh)
 		{
 			PolyTexCoordArray& face_tex_coord_vec = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
-			int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
+			ModelInfo& model_info = p_mesh->m_Kernel.GetModelInfo();
 			face_tex_coord_vec.clear();
-			face_tex_coord_vec.resize(face_num);
+			face_tex_coord_vec.resize(model_info.GetFaceNum());
 
 			ifstream fin(f.c_str());
 			if(fin.fail()){
@@ -370,14 +526,18 @@ void QGLViewer::LoadFaceTexCoord()
 				return;
 			}
 
-			for(int k=0; k<face_num; ++k)
+			//! the file lists the faces in the mesh file order, the lines of the faces
+			//! removed from the model are skipped
+			int file_face_num = model_info.GetFileFaceNum();
+			TexCoordArray tex_coord(3);
+			for(int k=0; k<file_face_num; ++k)
 			{
-				TexCoordArray& tex_coord = face_tex_coord_vec[k];
-				tex_coord.clear(); tex_coord.resize(3);
 				for(size_t i=0; i<3; ++i)
 				{
 					fin >> tex_coord[i][0] >> tex_coord[i][1];
 				}
+				int fid = model_info.GetModelFaceID(k);
+				if(fid != -1) face_tex_coord_vec[fid] = tex_coord;
 			}
 
 
@@ -439,10 +599,20 @@ void QGLViewer::SaveFaceTexCoord()
 	}
 
 	const PolyTexCoordArray& face_tex_coord = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
+	ModelInfo& model_info = p_mesh->m_Kernel.GetModelInfo();
 
-	for(size_t k=0; k<face_tex_coord.size(); ++k)
+	//! written in the mesh file order, a face removed from the model or without
+	//! coordinates gets zeros so the lines stay in step with the file
+	int file_face_num = model_info.GetFileFaceNum();
+	for(int k=0; k<file_face_num; ++k)
 	{
-		const TexCoordArray& tex_coord_vec = face_tex_coord[k];
+		int fid = model_info.GetModelFaceID(k);
+		if(fid == -1 || fid >= (int) face_tex_coord.size() || face_tex_coord[fid].size() != 3)
+		{
+			fout << "0 0 0 0 0 0 " << std::endl;
+			continue;
+		}
+		const TexCoordArray& tex_coord_vec = face_tex_coord[fid];
 		for(size_t i=0; i<tex_coord_vec.size(); ++i)
 		{
 			fout << tex_coord_vec[i][0] <<" " << tex_coord_vec[i][1] <<" ";
@@ -665,7 +835,8 @@ void QGLViewer::paintGL()
 	p_opengl->SetModelView();
 	if(p_mesh) p_mesh->DrawModel();
 //	if(p_param) p_param->Draw();
-	if(p_param_drawer) p_param_drawer->Draw();
+	//! the overlays read the parameterization the solve thread is writing
+	if(p_param_drawer && !IsSolving()) p_param_drawer->Draw();
 	p_opengl->DetectOpenGLError();
 	p_opengl->OnEndPaint();
 }
@@ -683,6 +854,8 @@ void QGLViewer::mousePressEvent( QMouseEvent* _event )
         
 	case LeftButton:
 		assert(p_UIHander);
+		//! selections look up the parameterization
+		if(IsSolving() && p_UIHander->GetMouseMode() >= MOUSE_MODE_SELECT_VERTEX) break;
 		p_UIHander->OnLButtonDown(_event->buttons(), x, y);
 		break;
 
@@ -735,7 +908,8 @@ void QGLViewer::keyPressEvent( QKeyEvent* _event)
 	switch( _event->key() )
 	{
 	case Key_Escape:
-		qApp->quit();
+		if(IsSolving()) CancelSolve();
+		else qApp->quit();
 		break;
 	default: break;
 	}
@@ -11,15 +11,18 @@
 //== FORWARD DECLARATIONS =====================================================
 
 class QMenu;
+class QTimer;
 class MeshModel;
 class COpenGL;
 class CUIHandler;
 class Utility;
+class SolveJob;
 
 namespace PARAM
 {
     class Parameter;
 	class ParamDrawer;
+	class ParamEditState;
 }
 
 //== CLASS DEFINITION =========================================================
@@ -51,8 +54,13 @@ public:
 		emit select_vertex();
 	}
 
+	//! a parameterization is running on the solve thread, p_param and the
+	//! param drawer must not be touched until it is done
+	bool IsSolving() const { return p_solve_job != NULL; }
+
 signals:
 	void select_vertex(void);
+	void solve_message(const QString& message);
 
 public slots:
 	void loadMeshModel();
@@ -72,6 +80,9 @@ public slots:
 
 	void OptimizeAmbiguityPatch();
 	void SolveParameter();
+	void CancelSolve();
+	//! move the patch conner nearest to the selected vertex onto it and update the parameterization
+	void MovePatchConner();
 
 	void SaveFaceTexCoord();
 	void LoadFaceTexCoord();
@@ -93,6 +104,8 @@ private slots:
 	void RenderingBoundingBox();
 	void RenderingParamTexture();
 
+	void PollSolveJob();
+
 
 private: // inherited
 
@@ -114,6 +127,9 @@ private:
 
 	int CreateTexture(const std::string& texture_file_name);
 
+	//! show (s0, t0, s1, t1, s2, t2) per face as the mesh texture coordinates
+	void ApplyFaceParamCoord(const std::vector<double>& face_param_coord);
+
 
 protected:
 
@@ -129,6 +145,11 @@ private:
 	QMenu*	popup_menu_;
 
 	GLuint texture[2];
+
+	boost::shared_ptr<SolveJob> p_solve_job;
+	QTimer* m_solve_timer;
+	//! the layout and solution before the edit the running update job solves, NULL for a full solve
+	boost::shared_ptr<PARAM::ParamEditState> p_edit_state;
 public:
 	//
 	boost::shared_ptr<MeshModel> p_mesh;
@@ -0,0 +1,161 @@
+#include "SolveJob.h"
+#include "../Param/Parameter.h"
+#include "../Param/CrossParameter.h"
+#include <exception>
+
+namespace
+{
+	//! sets the job as the solve monitor for its lifetime, also when the solve throws
+	template <typename T>
+	class SolveMonitorScope
+	{
+	public:
+		SolveMonitorScope(T& _target, PARAM::SolveMonitor* monitor) : target(_target) { target.SetSolveMonitor(monitor); }
+		~SolveMonitorScope() { target.SetSolveMonitor(NULL); }
+
+	private:
+		T& target;
+	};
+}
+
+QString SolveProgress::ToString() const
+{
+	switch(stage)
+	{
+	case PARAM::SOLVE_STAGE_SETUP:
+		return QString("Setting up the charts");
+	case PARAM::SOLVE_STAGE_SOLVE:
+		return QString("Solve loop %1, parameter change %2").arg(iteration + 1).arg(residual, 0, 'g', 3);
+	case PARAM::SOLVE_STAGE_ADJUST:
+		return QString("Adjusting patch boundary, round %1, %2 vertices moved").arg(iteration + 1).arg((int) residual);
+	case PARAM::SOLVE_STAGE_CORRESPONDING:
+		return QString("Finding corresponding %1%").arg(iteration);
+	case PARAM::SOLVE_STAGE_FINISH:
+		return QString("Finished");
+	default:
+		return QString();
+	}
+}
+
+SolveJob::SolveJob() : m_preview(false), m_result(SOLVE_JOB_FAILED), m_canceled(0) {}
+
+SolveJob::~SolveJob()
+{
+	Stop();
+}
+
+void SolveJob::Cancel()
+{
+	m_canceled.fetchAndStoreOrdered(1);
+}
+
+void SolveJob::Stop()
+{
+	Cancel();
+	wait();
+}
+
+bool SolveJob::PollProgress(SolveProgress& progress)
+{
+	if(!m_progress.Update()) return false;
+	progress = m_progress.ReadSlot();
+	return true;
+}
+
+const std::vector<double>* SolveJob::TakeSnapshot()
+{
+	if(!m_snapshot.Update()) return NULL;
+	return &m_snapshot.ReadSlot();
+}
+
+bool SolveJob::IsCanceled()
+{
+	return m_canceled.fetchAndAddOrdered(0) != 0;
+}
+
+void SolveJob::ReportProgress(int stage, int iteration, double residual)
+{
+	SolveProgress& progress = m_progress.WriteSlot();
+	progress.stage = stage;
+	progress.iteration = iteration;
+	progress.residual = residual;
+	m_progress.Publish();
+}
+
+std::vector<double>* SolveJob::GetSnapshotBuffer()
+{
+	return m_preview ? &m_snapshot.WriteSlot() : NULL;
+}
+
+void SolveJob::PublishSnapshot()
+{
+	m_snapshot.Publish();
+}
+
+void SolveJob::run()
+{
+	/// an exception must not leave the thread, it ends the job as failed
+	bool succeeded = false;
+	try
+	{
+		succeeded = Execute();
+	}catch(std::exception& e)
+	{
+		m_error_message = e.what();
+	}catch(...)
+	{
+		m_error_message = "unknown error";
+	}
+
+	if(succeeded) m_result = SOLVE_JOB_SUCCEEDED;
+	else if(IsCanceled() && m_error_message.empty()) m_result = SOLVE_JOB_CANCELED;
+	else m_result = SOLVE_JOB_FAILED;
+}
+
+ParamSolveJob::ParamSolveJob(boost::shared_ptr<PARAM::Parameter> _p_param) : p_param(_p_param)
+{
+	m_preview = true;
+}
+
+ParamSolveJob::~ParamSolveJob()
+{
+	Stop();
+}
+
+bool ParamSolveJob::Execute()
+{
+	SolveMonitorScope<PARAM::Parameter> monitor_scope(*p_param, this);
+	return p_param->ComputeParamCoord();
+}
+
+ParamUpdateJob::ParamUpdateJob(boost::shared_ptr<PARAM::Parameter> _p_param, const std::vector<int>& _edited_patch_array)
+	: p_param(_p_param), m_edited_patch_array(_edited_patch_array)
+{
+	m_preview = true;
+}
+
+ParamUpdateJob::~ParamUpdateJob()
+{
+	Stop();
+}
+
+bool ParamUpdateJob::Execute()
+{
+	SolveMonitorScope<PARAM::Parameter> monitor_scope(*p_param, this);
+	return p_param->UpdateParamCoord(m_edited_patch_array);
+}
+
+CrossParamJob::CrossParamJob(boost::shared_ptr<PARAM::CrossParameter> _p_cross_parameter)
+	: p_cross_parameter(_p_cross_parameter) {}
+
+CrossParamJob::~CrossParamJob()
+{
+	Stop();
+}
+
+bool CrossParamJob::Execute()
+{
+	SolveMonitorScope<PARAM::CrossParameter> monitor_scope(*p_cross_parameter, this);
+	p_cross_parameter->FindCorrespondingAB();
+	return !IsCanceled();
+}
@@ -0,0 +1,161 @@
+#ifndef SOLVEJOB_H_
+#define SOLVEJOB_H_
+
+#include "../Param/SolveMonitor.h"
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QString>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <string>
+
+namespace PARAM
+{
+	class Parameter;
+	class CrossParameter;
+}
+
+//! how often the GUI picks up the progress and the preview of a job, in ms
+const int SOLVE_POLL_INTERVAL = 100;
+
+//! the latest value handed from one writer thread to one reader thread without locks.
+//! it is a double buffer with a spare slot: the writer fills its own slot and swaps it
+//! with the shared one, the reader swaps the shared slot with its own only when it
+//! holds something new. each side always owns one slot, so neither ever waits
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : m_write(0), m_shared(1), m_read(2) {}
+
+	//! writer side
+	T& WriteSlot() { return m_slot[m_write]; }
+	void Publish() { m_write = m_shared.fetchAndStoreOrdered(m_write | FRESH_BIT) & INDEX_MASK; }
+
+	//! reader side, true when a value newer than ReadSlot() has been taken
+	bool Update()
+	{
+		if((m_shared.fetchAndAddOrdered(0) & FRESH_BIT) == 0) return false;
+		m_read = m_shared.fetchAndStoreOrdered(m_read) & INDEX_MASK;
+		return true;
+	}
+	const T& ReadSlot() const { return m_slot[m_read]; }
+
+private:
+	enum { INDEX_MASK = 3, FRESH_BIT = 4 };
+
+	T m_slot[3];
+	int m_write;
+	QAtomicInt m_shared;
+	int m_read;
+};
+
+class SolveProgress
+{
+public:
+	SolveProgress() : stage(PARAM::SOLVE_STAGE_SETUP), iteration(0), residual(0) {}
+
+	QString ToString() const;
+
+public:
+	int stage;
+	int iteration;
+	double residual;
+};
+
+//! how a finished job ended
+enum SolveJobResult
+{
+	SOLVE_JOB_SUCCEEDED = 0,
+	SOLVE_JOB_CANCELED,		//! stopped by Cancel()
+	SOLVE_JOB_FAILED		//! the solve returned false without a cancel, or threw
+};
+
+//! a solve run on its own thread. the GUI thread starts it, polls PollProgress()
+//! and TakeSnapshot() from a timer and may Cancel() it at any time, the solver
+//! sees the cancellation at its next check between iterations
+class SolveJob : public QThread, public PARAM::SolveMonitor
+{
+public:
+	SolveJob();
+	virtual ~SolveJob();
+
+	//! GUI thread
+	void Cancel();
+	//! cancel and wait for the thread, derived destructors have to call it
+	void Stop();
+	bool PollProgress(SolveProgress& progress);
+	//! the latest parameter coordinates not taken yet, NULL when there are none
+	const std::vector<double>* TakeSnapshot();
+	//! valid once the thread is finished
+	SolveJobResult GetResult() const { return m_result; }
+	//! what went wrong when the result is SOLVE_JOB_FAILED, may be empty
+	const std::string& GetErrorMessage() const { return m_error_message; }
+
+	//! SolveMonitor, solving thread
+	bool IsCanceled();
+	void ReportProgress(int stage, int iteration, double residual);
+	std::vector<double>* GetSnapshotBuffer();
+	void PublishSnapshot();
+
+protected:
+	void run();
+	virtual bool Execute() = 0;
+
+protected:
+	bool m_preview;
+
+private:
+	SolveJobResult m_result;
+	std::string m_error_message;
+	QAtomicInt m_canceled;
+
+	TripleBuffer<SolveProgress> m_progress;
+	TripleBuffer< std::vector<double> > m_snapshot;
+};
+
+//! Parameter::ComputeParamCoord, with a preview after each solve loop
+class ParamSolveJob : public SolveJob
+{
+public:
+	ParamSolveJob(boost::shared_ptr<PARAM::Parameter> _p_param);
+	~ParamSolveJob();
+
+protected:
+	bool Execute();
+
+private:
+	boost::shared_ptr<PARAM::Parameter> p_param;
+};
+
+//! Parameter::UpdateParamCoord after a layout edit, with a preview after each solve loop
+class ParamUpdateJob : public SolveJob
+{
+public:
+	ParamUpdateJob(boost::shared_ptr<PARAM::Parameter> _p_param, const std::vector<int>& _edited_patch_array);
+	~ParamUpdateJob();
+
+protected:
+	bool Execute();
+
+private:
+	boost::shared_ptr<PARAM::Parameter> p_param;
+	std::vector<int> m_edited_patch_array;
+};
+
+//! CrossParameter::FindCorrespondingAB
+class CrossParamJob : public SolveJob
+{
+public:
+	CrossParamJob(boost::shared_ptr<PARAM::CrossParameter> _p_cross_parameter);
+	~CrossParamJob();
+
+protected:
+	bool Execute();
+
+private:
+	boost::shared_ptr<PARAM::CrossParameter> p_cross_parameter;
+};
+
+#endif //SOLVEJOB_H_
@@ -39,11 +39,21 @@ MeshModel::MeshModel()
 
     m_BasicOp.AttachKernel(&m_Kernel);
     m_BasicOp.AttachAuxData(&m_AuxData);
+    m_BasicOp.AttachSpatialIndex(&m_SpatialIndex);
 
     m_AdvancedOp.AttachKernel(&m_Kernel);
     m_AdvancedOp.AttachAuxData(&m_AuxData);
     m_AdvancedOp.AttachBasicOp(&m_BasicOp);
 
+    m_OperatorCache.AttachKernel(&m_Kernel);
+    m_OperatorCache.AttachBasicOp(&m_BasicOp);
+
+    m_SpatialIndex.AttachKernel(&m_Kernel);
+
+    m_Geodesic.AttachKernel(&m_Kernel);
+    m_Geodesic.AttachBasicOp(&m_BasicOp);
+    m_Geodesic.AttachOperatorCache(&m_OperatorCache);
+
     ClearData();
 }
 
@@ -62,6 +72,9 @@ void MeshModel::ClearData()
     m_Render.ClearData();
     m_BasicOp.ClearData();
     m_AdvancedOp.ClearData();
+    m_OperatorCache.ClearData();
+    m_SpatialIndex.ClearData();
+    m_Geodesic.ClearData();
 
     m_bAttachModel = false;
 }
@@ -83,7 +96,61 @@ string MeshModel::GetModelFileName()
 void MeshModel::StoreModel(string filename)
 {
 //	m_AdvancedOp.CompactModel();
-    m_IO.StoreModel(filename);
+    ModelInfo& mInfo = m_Kernel.GetModelInfo();
+    if(!mInfo.IsReordered())
+    {
+        m_IO.StoreModel(filename);
+        return;
+    }
+
+    // Write a copy of the stored arrays back in the file order
+    MeshModelKernel kernel;
+    kernel.ClearData();
+    VertexInfo& vInfo = kernel.GetVertexInfo();
+    FaceInfo& fInfo = kernel.GetFaceInfo();
+    vInfo.GetCoord() = m_Kernel.GetVertexInfo().GetCoord();
+    vInfo.GetNormal() = m_Kernel.GetVertexInfo().GetNormal();
+    vInfo.GetColor() = m_Kernel.GetVertexInfo().GetColor();
+    vInfo.GetTexCoord() = m_Kernel.GetVertexInfo().GetTexCoord();
+    m_Kernel.GetFaceInfo().CopyIndex(fInfo.GetIndex());
+    fInfo.BuildTriIndex();
+    fInfo.GetNormal() = m_Kernel.GetFaceInfo().GetNormal();
+    fInfo.GetColor() = m_Kernel.GetFaceInfo().GetColor();
+    fInfo.GetTexCoord() = m_Kernel.GetFaceInfo().GetTexCoord();
+    fInfo.GetTexIndex() = m_Kernel.GetFaceInfo().GetTexIndex();
+
+    IndexArray vtxOrder, faceOrder;
+    IndexArray& vtxRank = mInfo.GetVertexRank();
+    IndexArray& faceRank = mInfo.GetFaceRank();
+    size_t i;
+    for(i = 0; i < vtxRank.size(); ++ i)
+    {
+        if(vtxRank[i] != -1)
+            vtxOrder.push_back(vtxRank[i]);
+    }
+    for(i = 0; i < faceRank.size(); ++ i)
+    {
+        if(faceRank[i] != -1)
+            faceOrder.push_back(faceRank[i]);
+    }
+    if(vtxRank.empty())
+    {
+        for(i = 0; i < vInfo.GetCoord().size(); ++ i)
+            vtxOrder.push_back((int) i);
+    }
+    if(faceRank.empty())
+    {
+        for(i = 0; i < (size_t) fInfo.GetFaceNum(); ++ i)
+            faceOrder.push_back((int) i);
+    }
+
+    MeshModelAdvancedOp op;
+    op.AttachKernel(&kernel);
+    op.PermuteModel(vtxOrder, faceOrder);
+
+    MeshModelIO io;
+    io.AttachKernel(&kernel);
+    io.StoreModel(filename);
 }
 
 // Create a model by coord array and face index array
@@ -121,6 +188,15 @@ void MeshModel::CompactModel()
     m_BasicOp.InitModel();
 }
 
+// The order is computed on the current model and composed with the earlier ones,
+// the model is analyzed again in the new order
+void MeshModel::ReorderModel(int method)
+{
+    m_AdvancedOp.ReorderModel(method);
+    m_Kernel.GetModelInfo().SetType(MODEL_TYPE_POLYGON_SOAP);
+    m_BasicOp.InitModel();
+}
+
 // Transformation functions
 void MeshModel::Translate(Coord delta)
 {
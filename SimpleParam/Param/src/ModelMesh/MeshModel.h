@@ -39,6 +39,9 @@
 #include "MeshModelRender.h"    // Rendering functions
 #include "MeshModelBasicOp.h"       // Basic operations -- those do not change mesh topology
 #include "MeshModelAdvancedOp.h"    // Advanced operations -- those change mesh topology
+#include "MeshModelOperatorCache.h" // Cached geometric operators -- cotangent weights, Laplacians, etc
+#include "MeshModelSpatialIndex.h"  // Spatial queries -- nearest vertex, nearest surface point, ray
+#include "MeshModelGeodesic.h"      // Geodesic distances -- heat method on the cached Laplacian
 
 #pragma once
 
@@ -55,6 +58,9 @@ public:
     MeshModelRender     m_Render;
     MeshModelBasicOp    m_BasicOp;
     MeshModelAdvancedOp m_AdvancedOp;
+    MeshModelOperatorCache m_OperatorCache;
+    MeshModelSpatialIndex  m_SpatialIndex;
+    MeshModelGeodesic      m_Geodesic;
     bool        m_bAttachModel;
 	std::string      m_ModelName;
 
@@ -88,6 +94,9 @@ public:
     // Compact model
     void CompactModel();
 
+    // Reorder the vertices and faces for memory locality, files are still read and written in the file order
+    void ReorderModel(int method = MODEL_REORDER_RCM);
+
     // Transformation functions
     void Translate(Coord delta);
     void Rotate(Coord center, Coord axis, double angle);
@@ -35,9 +35,284 @@
 
 #include "MeshModelAdvancedOp.h"
 #include "../Numerical/Rotation.h"
+#include <algorithm>
 #include <cassert>
 
 
+namespace
+{
+    // Gather arr[order[i]] to i, arrays not sized to the order are left alone
+    template <typename T>
+    void PermuteArray(std::vector<T>& arr, const IndexArray& order)
+    {
+        if(arr.size() != order.size())
+            return;
+        std::vector<T> tmp(arr.size());
+        for(size_t i = 0; i < order.size(); ++ i)
+            std::swap(tmp[i], arr[order[i]]);
+        arr.swap(tmp);
+    }
+
+    // Follow a reordering in the file order and rank of the elements
+    void ComposeFileOrder(IndexArray& fileOrder, IndexArray& fileRank, const IndexArray& order)
+    {
+        if(fileOrder.empty())
+        {
+            fileOrder = order;
+            fileRank.resize(order.size());
+        }
+        else
+        {
+            IndexArray tmp(order.size());
+            for(size_t i = 0; i < order.size(); ++ i)
+                tmp[i] = fileOrder[order[i]];
+            fileOrder.swap(tmp);
+        }
+        fill(fileRank.begin(), fileRank.end(), -1);
+        for(size_t i = 0; i < fileOrder.size(); ++ i)
+            fileRank[fileOrder[i]] = (int) i;
+    }
+
+    // Follow a compaction, idMap[i] is the new index of element i or -1
+    void CompactFileOrder(IndexArray& fileOrder, IndexArray& fileRank, const IndexArray& idMap, size_t nNew)
+    {
+        if(fileOrder.empty())
+        {
+            if(nNew == idMap.size())
+                return;
+            fileOrder.resize(idMap.size());
+            fileRank.resize(idMap.size());
+            for(size_t i = 0; i < idMap.size(); ++ i)
+                fileOrder[i] = (int) i;
+        }
+        for(size_t i = 0; i < idMap.size(); ++ i)
+        {
+            if(idMap[i] != -1)
+                fileOrder[idMap[i]] = fileOrder[i];     // idMap[i] <= i
+        }
+        fileOrder.resize(nNew);
+        fill(fileRank.begin(), fileRank.end(), -1);
+        for(size_t i = 0; i < nNew; ++ i)
+            fileRank[fileOrder[i]] = (int) i;
+    }
+
+    // Vertex graph in compressed rows, the neighbors of vertex i are adj[offset[i] .. offset[i+1]-1]
+    void BuildVertexGraph(const FaceInfo& fInfo, int nVertex, IndexArray& offset, IndexArray& adj)
+    {
+        size_t i, j, n, nFace = fInfo.GetFaceNum();
+        offset.assign(nVertex+1, 0);
+        for(i = 0; i < nFace; ++ i)
+        {
+            const int* f = fInfo.GetFaceVertices((FaceID) i);
+            n = fInfo.GetFaceDegree((FaceID) i);
+            for(j = 0; j < n; ++ j)
+                offset[f[j]+1] += 2;
+        }
+        for(int v = 0; v < nVertex; ++ v)
+            offset[v+1] += offset[v];
+
+        adj.resize(offset[nVertex]);
+        IndexArray pos(offset.begin(), offset.end() - 1);
+        for(i = 0; i < nFace; ++ i)
+        {
+            const int* f = fInfo.GetFaceVertices((FaceID) i);
+            n = fInfo.GetFaceDegree((FaceID) i);
+            for(j = 0; j < n; ++ j)
+            {
+                adj[pos[f[j]] ++] = f[(j+1)%n];
+                adj[pos[f[j]] ++] = f[(j+n-1)%n];
+            }
+        }
+
+        // Remove the duplicated neighbors in place
+        int k = 0;
+        for(int v = 0; v < nVertex; ++ v)
+        {
+            IndexArray::iterator begin = adj.begin() + offset[v];
+            IndexArray::iterator end = adj.begin() + offset[v+1];
+            sort(begin, end);
+            end = unique(begin, end);
+            offset[v] = k;
+            for(IndexArray::iterator it = begin; it != end; ++ it)
+            {
+                if(*it != v)
+                    adj[k ++] = *it;
+            }
+        }
+        offset[nVertex] = k;
+        adj.resize(k);
+    }
+
+    class DegreeLess
+    {
+    public:
+        const IndexArray& offset;
+
+        DegreeLess(const IndexArray& o) : offset(o) {}
+
+        bool operator()(int a, int b) const
+        {
+            int da = offset[a+1] - offset[a], db = offset[b+1] - offset[b];
+            return da < db || (da == db && a < b);
+        }
+    };
+
+    // Breadth first search from root, returns the number of levels, last gets the deepest level
+    int LevelStructure(const IndexArray& offset, const IndexArray& adj, int root,
+                       IndexArray& stamp, int s, IndexArray& queue, IndexArray& last)
+    {
+        queue.clear();
+        queue.push_back(root);
+        stamp[root] = s;
+        size_t head = 0;
+        int depth = 0;
+        while(head < queue.size())
+        {
+            size_t levelEnd = queue.size();
+            last.assign(queue.begin() + head, queue.end());
+            ++ depth;
+            for(; head < levelEnd; ++ head)
+            {
+                int v = queue[head];
+                for(int k = offset[v]; k < offset[v+1]; ++ k)
+                {
+                    if(stamp[adj[k]] != s)
+                    {
+                        stamp[adj[k]] = s;
+                        queue.push_back(adj[k]);
+                    }
+                }
+            }
+        }
+        return depth;
+    }
+
+    void ReverseCuthillMcKee(const IndexArray& offset, const IndexArray& adj, IndexArray& order)
+    {
+        int nVertex = (int) offset.size() - 1;
+        DegreeLess less(offset);
+        IndexArray stamp(nVertex, -1);
+        IndexArray queue, last;
+        int s = 0;
+
+        order.clear();
+        order.reserve(nVertex);
+        std::vector<bool> visited(nVertex, false);
+        for(int i = 0; i < nVertex; ++ i)
+        {
+            if(visited[i])
+                continue;
+
+            // Pseudo-peripheral root of the component, moving to a thinnest vertex of the deepest level
+            int root = i;
+            int depth = LevelStructure(offset, adj, root, stamp, s ++, queue, last);
+            for(int iter = 0; iter < 8; ++ iter)
+            {
+                int cand = *min_element(last.begin(), last.end(), less);
+                int candDepth = LevelStructure(offset, adj, cand, stamp, s ++, queue, last);
+                if(candDepth <= depth)
+                    break;
+                root = cand;
+                depth = candDepth;
+            }
+
+            // Cuthill-McKee, the neighbors of each vertex are queued by increasing degree
+            size_t head = order.size();
+            order.push_back(root);
+            visited[root] = true;
+            for(; head < order.size(); ++ head)
+            {
+                int v = order[head];
+                size_t first = order.size();
+                for(int k = offset[v]; k < offset[v+1]; ++ k)
+                {
+                    if(!visited[adj[k]])
+                    {
+                        visited[adj[k]] = true;
+                        order.push_back(adj[k]);
+                    }
+                }
+                sort(order.begin() + first, order.end(), less);
+            }
+        }
+        reverse(order.begin(), order.end());
+    }
+
+    // Index of a point along the 3D Hilbert curve of order bits, from Skilling's transpose form
+    unsigned long long HilbertKey(unsigned int x[3], int bits)
+    {
+        unsigned int M = 1u << (bits - 1), P, Q, t;
+        int i;
+        for(Q = M; Q > 1; Q >>= 1)
+        {
+            P = Q - 1;
+            for(i = 0; i < 3; ++ i)
+            {
+                if(x[i] & Q)
+                    x[0] ^= P;
+                else
+                {
+                    t = (x[0] ^ x[i]) & P;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+        for(i = 1; i < 3; ++ i)
+            x[i] ^= x[i-1];
+        t = 0;
+        for(Q = M; Q > 1; Q >>= 1)
+        {
+            if(x[2] & Q)
+                t ^= Q - 1;
+        }
+        for(i = 0; i < 3; ++ i)
+            x[i] ^= t;
+
+        unsigned long long key = 0;
+        for(int b = bits - 1; b >= 0; -- b)
+        {
+            for(i = 0; i < 3; ++ i)
+                key = (key << 1) | ((x[i] >> b) & 1);
+        }
+        return key;
+    }
+
+    void HilbertOrder(CoordArray& vCoord, IndexArray& order)
+    {
+        const int bits = 16;
+        size_t i, nVertex = vCoord.size();
+        order.resize(nVertex);
+        if(nVertex == 0)
+            return;
+
+        Coord BoxMin = vCoord[0], BoxMax = vCoord[0];
+        for(i = 1; i < nVertex; ++ i)
+        {
+            for(int j = 0; j < 3; ++ j)
+            {
+                BoxMin[j] = min(BoxMin[j], vCoord[i][j]);
+                BoxMax[j] = max(BoxMax[j], vCoord[i][j]);
+            }
+        }
+        double size = max(BoxMax[0]-BoxMin[0], max(BoxMax[1]-BoxMin[1], BoxMax[2]-BoxMin[2]));
+        double scale = (size > 0.0) ? ((1 << bits) - 1) / size : 0.0;
+
+        std::vector< std::pair<unsigned long long, int> > keys(nVertex);
+        for(i = 0; i < nVertex; ++ i)
+        {
+            unsigned int x[3];
+            for(int j = 0; j < 3; ++ j)
+                x[j] = (unsigned int) ((vCoord[i][j] - BoxMin[j]) * scale);
+            keys[i] = std::make_pair(HilbertKey(x, bits), (int) i);
+        }
+        sort(keys.begin(), keys.end());
+        for(i = 0; i < nVertex; ++ i)
+            order[i] = keys[i].second;
+    }
+}
+
+
 // Constructor
 MeshModelAdvancedOp::MeshModelAdvancedOp()
 {
@@ -148,6 +423,121 @@ void MeshModelAdvancedOp::CompactModel()
         }
     }
     fIndex.erase(fIndex.begin()+nNewFace, fIndex.end());
+    kernel->GetFaceInfo().BuildTriIndex();
+
+    // Keep track of the file orders
+    ModelInfo& mInfo = kernel->GetModelInfo();
+    CompactFileOrder(mInfo.GetVertexOrder(), mInfo.GetVertexRank(), VtxIDMap, nNewVtx);
+    CompactFileOrder(mInfo.GetFaceOrder(), mInfo.GetFaceRank(), FaceIDMap, nNewFace);
+
+    kernel->IncModifyCount();
+}
+
+// Reorder the vertices and faces for memory locality, the file orders are kept in ModelInfo
+void MeshModelAdvancedOp::ReorderModel(int method)
+{
+    IndexArray vtxOrder, faceOrder;
+    ComputeVertexOrder(method, vtxOrder);
+    ComputeFaceOrder(vtxOrder, faceOrder);
+    PermuteModel(vtxOrder, faceOrder);
+}
+
+// Locality preserving vertex order, vtxOrder[i] is the vertex moved to i
+void MeshModelAdvancedOp::ComputeVertexOrder(int method, IndexArray& vtxOrder)
+{
+    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    if(method == MODEL_REORDER_HILBERT)
+    {
+        HilbertOrder(vCoord, vtxOrder);
+    }
+    else
+    {
+        IndexArray offset, adj;
+        BuildVertexGraph(kernel->GetFaceInfo(), (int) vCoord.size(), offset, adj);
+        ReverseCuthillMcKee(offset, adj, vtxOrder);
+    }
+}
+
+// Faces sorted by their smallest vertex after vtxOrder, faceOrder[i] is the face moved to i
+void MeshModelAdvancedOp::ComputeFaceOrder(const IndexArray& vtxOrder, IndexArray& faceOrder)
+{
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t i, j, nVertex = vtxOrder.size(), nFace = fInfo.GetFaceNum();
+
+    IndexArray vtxRank(nVertex);
+    for(i = 0; i < nVertex; ++ i)
+        vtxRank[vtxOrder[i]] = (int) i;
+
+    // Counting sort, stable for the faces sharing their smallest vertex
+    IndexArray key(nFace), offset(nVertex+1, 0);
+    for(i = 0; i < nFace; ++ i)
+    {
+        const int* f = fInfo.GetFaceVertices((FaceID) i);
+        int k = (int) nVertex - 1;
+        for(j = 0; j < (size_t) fInfo.GetFaceDegree((FaceID) i); ++ j)
+            k = min(k, vtxRank[f[j]]);
+        key[i] = k;
+        ++ offset[k+1];
+    }
+    for(i = 0; i < nVertex; ++ i)
+        offset[i+1] += offset[i];
+
+    faceOrder.resize(nFace);
+    for(i = 0; i < nFace; ++ i)
+        faceOrder[offset[key[i]] ++] = (int) i;
+}
+
+// Move vertex vtxOrder[i] and face faceOrder[i] to i in every element array
+// Derived adjacency and edge data are freed, InitModel() rebuilds them
+void MeshModelAdvancedOp::PermuteModel(const IndexArray& vtxOrder, const IndexArray& faceOrder)
+{
+    VertexInfo& vInfo = kernel->GetVertexInfo();
+    FaceInfo& fInfo = kernel->GetFaceInfo();
+    ModelInfo& mInfo = kernel->GetModelInfo();
+    size_t i, j, nVertex = vtxOrder.size(), nFace = faceOrder.size();
+    assert(nVertex == vInfo.GetCoord().size() && (int) nFace == fInfo.GetFaceNum());
+
+    IndexArray vtxRank(nVertex);
+    for(i = 0; i < nVertex; ++ i)
+        vtxRank[vtxOrder[i]] = (int) i;
+
+    // Vertex arrays, the texture coordinates are per vertex unless the faces index them
+    PermuteArray(vInfo.GetCoord(), vtxOrder);
+    PermuteArray(vInfo.GetNormal(), vtxOrder);
+    PermuteArray(vInfo.GetColor(), vtxOrder);
+    PermuteArray(vInfo.GetFlag(), vtxOrder);
+    PermuteArray(vInfo.GetCurvatures(), vtxOrder);
+    PermuteArray(vInfo.GetMeanCurvature(), vtxOrder);
+    PermuteArray(vInfo.GetGaussCurvature(), vtxOrder);
+    if(fInfo.GetTexIndex().empty())
+        PermuteArray(vInfo.GetTexCoord(), vtxOrder);
+    util.FreeVector(vInfo.GetAdjFaces());
+    util.FreeVector(vInfo.GetAdjVertices());
+    util.FreeVector(vInfo.GetAdjEdges());
+
+    // Face arrays
+    fInfo.PermuteIndex(faceOrder, vtxRank);
+    PermuteArray(fInfo.GetNormal(), faceOrder);
+    PermuteArray(fInfo.GetColor(), faceOrder);
+    PermuteArray(fInfo.GetTexCoord(), faceOrder);
+    PermuteArray(fInfo.GetFlag(), faceOrder);
+    PermuteArray(fInfo.GetBaryCenter(), faceOrder);
+    PermuteArray(fInfo.GetFaceArea(), faceOrder);
+    PermuteArray(fInfo.GetTexIndex(), faceOrder);
+
+    kernel->GetEdgeInfo().ClearData();
+
+    PolyIndexArray& boundaries = mInfo.GetBoundary();
+    for(i = 0; i < boundaries.size(); ++ i)
+    {
+        for(j = 0; j < boundaries[i].size(); ++ j)
+            boundaries[i][j] = vtxRank[boundaries[i][j]];
+    }
+
+    ComposeFileOrder(mInfo.GetVertexOrder(), mInfo.GetVertexRank(), vtxOrder);
+    ComposeFileOrder(mInfo.GetFaceOrder(), mInfo.GetFaceRank(), faceOrder);
+
+    kernel->IncModifyCount();
 }
 
 // Model transformation
@@ -158,6 +548,7 @@ void MeshModelAdvancedOp::Translate(Coord delta)
     size_t i, n = vCoord.size();
     for(i = 0; i < n; ++ i)
         vCoord[i] += delta;
+    kernel->IncModifyCount();
 
     // Update bounding box
     Coord BoxMin, BoxMax, BoxDim, Center;
@@ -182,6 +573,7 @@ void MeshModelAdvancedOp::Rotate(Coord center, Coord axis, double angle)
     size_t i, n = vCoord.size();
     for(i = 0; i < n; ++ i)
         vCoord[i] = VectorTransform(vCoord[i]-center, rot) + center;
+    kernel->IncModifyCount();
 
     // Update model
     basicop->CalFaceNormal();
@@ -197,6 +589,7 @@ void MeshModelAdvancedOp::Scale(Coord center, Coord ratio)
     for(i = 0; i < n; ++ i)
         for(j = 0; j < 3; ++ j)
             vCoord[i][j] = (vCoord[i][j]-center[j])*ratio[j] + center[j];
+    kernel->IncModifyCount();
 
     // Update bounding box
     Coord BoxMin, BoxMax, BoxDim, Center;
@@ -43,6 +43,13 @@
 
 
 
+/* ================== Reorder Methods ================== */
+
+#define MODEL_REORDER_RCM       0   // Reverse Cuthill-McKee on the vertex graph
+#define MODEL_REORDER_HILBERT   1   // Hilbert curve over the vertex positions
+
+
+
 /* ================== Advanced Operation ================== */
 
 class MeshModelAdvancedOp
@@ -69,6 +76,19 @@ public:
     // Compact model
     void CompactModel();
 
+    // Reorder the vertices and faces for memory locality, the file orders are kept in ModelInfo
+    void ReorderModel(int method = MODEL_REORDER_RCM);
+
+    // Locality preserving vertex order, vtxOrder[i] is the vertex moved to i
+    void ComputeVertexOrder(int method, IndexArray& vtxOrder);
+
+    // Faces sorted by their smallest vertex after vtxOrder, faceOrder[i] is the face moved to i
+    void ComputeFaceOrder(const IndexArray& vtxOrder, IndexArray& faceOrder);
+
+    // Move vertex vtxOrder[i] and face faceOrder[i] to i in every element array
+    // Derived adjacency and edge data are freed, InitModel() rebuilds them
+    void PermuteModel(const IndexArray& vtxOrder, const IndexArray& faceOrder);
+
     // Euler operator
     void EdgeCollapse(VertexID vID1, VertexID vID2);
     void VertexSplit(VertexID vID);
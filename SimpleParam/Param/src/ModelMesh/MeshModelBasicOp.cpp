@@ -32,6 +32,7 @@
 // This class is responsible for the manipulations of the kernel components and states
 
 #include "MeshModelBasicOp.h"
+#include "../Common/Parallel.h"
 #include <stack>
 #include <algorithm>
 #include "../Numerical/Heap.h"
@@ -45,6 +46,7 @@ MeshModelBasicOp::MeshModelBasicOp()
 {
     kernel = NULL ;
     auxdata = NULL;
+    spatialindex = NULL;
 }
 
 // Destructor
@@ -71,6 +73,701 @@ void MeshModelBasicOp::AttachAuxData(MeshModelAuxData* pAuxData)
     auxdata = pAuxData;
 }
 
+void MeshModelBasicOp::AttachSpatialIndex(MeshModelSpatialIndex* pSpatialIndex)
+{
+    assert(pSpatialIndex != NULL);
+    spatialindex = pSpatialIndex;
+}
+
+
+/* ================== Parallel passes ================== */
+
+// Per-element bodies of the InitModel passes, run by parallel_for/parallel_reduce
+// Each body only writes the entries of its own vertex or face
+namespace
+{
+    class AdjVerticesPass
+    {
+    public:
+        FaceInfo& fInfo;
+        PolyIndexArray& vAdjFaces;
+        PolyIndexArray& vAdjVertices;
+
+        AdjVerticesPass(FaceInfo& f, PolyIndexArray& af, PolyIndexArray& av)
+            : fInfo(f), vAdjFaces(af), vAdjVertices(av) {}
+
+        void operator()(int i) const
+        {
+            // Gathering the adjacent vertices of vertex i from adjacent faces
+            IndexArray& adjVertices = vAdjVertices[i];
+            IndexArray& adjFaces = vAdjFaces[i];
+            size_t n = adjFaces.size();
+            adjVertices.reserve(2*n);
+            for(size_t j = 0; j < n; ++ j)
+            {
+                const int* face = fInfo.GetFaceVertices(adjFaces[j]);
+                size_t m = fInfo.GetFaceDegree(adjFaces[j]);
+                // Find the position of vertex i in face fID
+                size_t idx = find(face, face+m, i) - face;
+                assert(idx >= 0 && idx < m);
+
+                // Add previous and next vertices of vertex i to adjacent-vertex array
+                adjVertices.push_back(face[(idx+1)%m]);
+                adjVertices.push_back(face[(idx+m-1)%m]);
+            }
+
+            // Validate the 1-ring neighborhood of vertex i
+            // Make sure NOT contain central vertex i
+            adjVertices.erase(remove(adjVertices.begin(), adjVertices.end(), i), adjVertices.end());
+            // Sort and make sure NO duplicated adjacent vertex
+            sort(adjVertices.begin(), adjVertices.end());
+            adjVertices.erase(unique(adjVertices.begin(), adjVertices.end()), adjVertices.end());
+        }
+    };
+
+    class VertexNormalPass
+    {
+    public:
+        NormalArray& fNormal;
+        PolyIndexArray& vAdjFaces;
+        NormalArray& vNormal;
+
+        VertexNormalPass(NormalArray& fn, PolyIndexArray& af, NormalArray& vn)
+            : fNormal(fn), vAdjFaces(af), vNormal(vn) {}
+
+        void operator()(int i) const
+        {
+            IndexArray& adjFaces = vAdjFaces[i];
+            size_t n = adjFaces.size();
+            Normal& vn = vNormal[i];
+            vn.setCoords(0.0, 0.0, 0.0);
+            for(size_t j = 0; j < n; ++ j)
+                vn += fNormal[adjFaces[j]];
+
+            if(!vn.normalize())
+                vn = COORD_AXIS_Z;
+        }
+    };
+
+    class FaceNormalPass
+    {
+    public:
+        CoordArray& vCoord;
+        FaceInfo& fInfo;
+        NormalArray& fNormal;
+
+        FaceNormalPass(CoordArray& v, FaceInfo& f, NormalArray& fn)
+            : vCoord(v), fInfo(f), fNormal(fn) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            Normal& fn = fNormal[i];
+            fn = cross(vCoord[f[1]]-vCoord[f[0]], vCoord[f[2]]-vCoord[f[0]]);
+            if(!fn.normalize())
+                fn = COORD_AXIS_Z;
+        }
+    };
+
+    class FaceBaryCenterPass
+    {
+    public:
+        CoordArray& vCoord;
+        FaceInfo& fInfo;
+        CoordArray& fBaryCenter;
+
+        FaceBaryCenterPass(CoordArray& v, FaceInfo& f, CoordArray& c)
+            : vCoord(v), fInfo(f), fBaryCenter(c) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            fBaryCenter[i] = (vCoord[f[0]] + vCoord[f[1]] + vCoord[f[2]]) / 3;
+        }
+    };
+
+    class FaceAreaPass
+    {
+    public:
+        CoordArray& vCoord;
+        FaceInfo& fInfo;
+        DoubleArray& faceArea;
+
+        FaceAreaPass(CoordArray& v, FaceInfo& f, DoubleArray& a)
+            : vCoord(v), fInfo(f), faceArea(a) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            faceArea[i] = cross(vCoord[f[1]]-vCoord[f[0]], vCoord[f[2]]-vCoord[f[0]]).abs() / 2;
+        }
+    };
+
+    // Partial bounding box and coordinate sum of a range of vertices
+    class BoundingBoxData
+    {
+    public:
+        Coord BoxMin;
+        Coord BoxMax;
+        Coord Sum;
+    };
+
+    class BoundingBoxPass
+    {
+    public:
+        CoordArray& vCoord;
+
+        BoundingBoxPass(CoordArray& v) : vCoord(v) {}
+
+        BoundingBoxData operator()(int begin, int end, BoundingBoxData data) const
+        {
+            for(int i = begin; i < end; ++ i)
+            {
+                Coord& v = vCoord[i];
+                for(int j = 0; j < 3; ++ j)
+                {
+                    if(v[j] < data.BoxMin[j])
+                        data.BoxMin[j] = v[j];
+                    if(v[j] > data.BoxMax[j])
+                        data.BoxMax[j] = v[j];
+                    data.Sum[j] += v[j];
+                }
+            }
+            return data;
+        }
+
+        BoundingBoxData operator()(const BoundingBoxData& a, const BoundingBoxData& b) const
+        {
+            BoundingBoxData data;
+            for(int j = 0; j < 3; ++ j)
+            {
+                data.BoxMin[j] = std::min(a.BoxMin[j], b.BoxMin[j]);
+                data.BoxMax[j] = std::max(a.BoxMax[j], b.BoxMax[j]);
+            }
+            data.Sum = a.Sum + b.Sum;
+            return data;
+        }
+    };
+
+    class SphereRadiusPass
+    {
+    public:
+        CoordArray& vCoord;
+        Coord Center;
+
+        SphereRadiusPass(CoordArray& v, const Coord& c) : vCoord(v), Center(c) {}
+
+        double operator()(int begin, int end, double r) const
+        {
+            for(int i = begin; i < end; ++ i)
+                r = std::max(r, (vCoord[i]-Center).abs());
+            return r;
+        }
+
+        double operator()(double a, double b) const { return std::max(a, b); }
+    };
+
+    // Classify each vertex by the number of faces adjacent to its 1-ring edges
+    // vReport marks the vertices having boundary or non-manifold edges
+    class VertexTopologyPass
+    {
+    public:
+        MeshModelBasicOp* op;
+        PolyIndexArray& vAdjFaces;
+        PolyIndexArray& vAdjVertices;
+        FlagArray& vFlag;
+        std::vector<char>& vReport;
+
+        VertexTopologyPass(MeshModelBasicOp* o, PolyIndexArray& af, PolyIndexArray& av, FlagArray& vf, std::vector<char>& r)
+            : op(o), vAdjFaces(af), vAdjVertices(av), vFlag(vf), vReport(r) {}
+
+        void operator()(int i) const
+        {
+            Utility util;
+            Flag& flag = vFlag[i];
+            if(vAdjFaces[i].empty())  // Isolated vertex
+            {
+                util.SetFlag(flag, VERTEX_FLAG_ISOLATED);
+                return;
+            }
+
+            // Check topology for the 1-ring neighborhood of vertex i
+            IndexArray& adjVertices = vAdjVertices[i];
+            size_t n = adjVertices.size();
+            int nBdyFace = 0, nNonManifoldFace = 0;
+            for(size_t j = 0; j < n; ++ j)
+            {
+                switch(op->AdjFaceNum(i, adjVertices[j]))
+                {
+                case 1:     // Boundary
+                    ++ nBdyFace;
+                    break;
+                case 2:     // 2-Manifold
+                    break;
+                default:    // Non-Manifold
+                    ++ nNonManifoldFace;
+                }
+            }
+            vReport[i] = (nBdyFace || nNonManifoldFace);
+            if(nNonManifoldFace || nBdyFace > 2)    // Non-manifold vertex
+                return;
+
+            // Manifold vertex
+            util.SetFlag(flag, VERTEX_FLAG_MANIFOLD);
+            if(nBdyFace == 2)   // Boundary vertex
+                util.SetFlag(flag, VERTEX_FLAG_BOUNDARY);
+        }
+    };
+
+    // Set face flags, returning whether the faces are all triangles (bit 0) and quads (bit 1)
+    class FaceTopologyPass
+    {
+    public:
+        const FaceInfo& fInfo;
+        FlagArray& vFlag;
+        FlagArray& fFlag;
+
+        FaceTopologyPass(const FaceInfo& f, FlagArray& vf, FlagArray& ff)
+            : fInfo(f), vFlag(vf), fFlag(ff) {}
+
+        int operator()(int begin, int end, int type) const
+        {
+            Utility util;
+            for(int i = begin; i < end; ++ i)
+            {
+                const int* f = fInfo.GetFaceVertices(i);
+                size_t n = fInfo.GetFaceDegree(i);
+
+                if(n != 3)
+                    type &= ~1;
+                else if(n != 4)
+                    type &= ~2;
+
+                int nBdyVtx = 0;
+                bool bManifoldFace = true;
+                for(size_t j = 0; j < n; ++ j)
+                {
+                    if(!util.IsSetFlag(vFlag[f[j]], VERTEX_FLAG_MANIFOLD))
+                    {
+                        bManifoldFace = false;
+                        break;
+                    }
+                    else if(util.IsSetFlag(vFlag[f[j]], VERTEX_FLAG_BOUNDARY))
+                        nBdyVtx ++;
+                }
+                Flag& flag = fFlag[i];
+                if(bManifoldFace)
+                {
+                    util.SetFlag(flag, FACE_FLAG_MANIFOLD);
+                    if(nBdyVtx > 1)
+                        util.SetFlag(flag, FACE_FLAG_BOUNDARY);
+                }
+            }
+            return type;
+        }
+
+        int operator()(int a, int b) const { return a & b; }
+    };
+
+    class SortAdjacentPass
+    {
+    public:
+        MeshModelBasicOp* op;
+
+        SortAdjacentPass(MeshModelBasicOp* o) : op(o) {}
+
+        void operator()(int i) const { op->SortAdjacentInfo(i); }
+    };
+
+    // Corners bucketed by the smaller vertex of their edge, as (larger vertex, corner) pairs
+    typedef std::pair<int, int> EdgeCorner;
+
+    class EdgeBucketPass
+    {
+    public:
+        std::vector<EdgeCorner>& bucket;
+        IndexArray& bucketOffset;
+        IndexArray& edgeNum;
+
+        EdgeBucketPass(std::vector<EdgeCorner>& b, IndexArray& bo, IndexArray& en)
+            : bucket(b), bucketOffset(bo), edgeNum(en) {}
+
+        void operator()(int i) const
+        {
+            // Sorting the corners of vertex i by the other vertex, and counting the distinct ones
+            std::vector<EdgeCorner>::iterator begin = bucket.begin() + bucketOffset[i];
+            std::vector<EdgeCorner>::iterator end = bucket.begin() + bucketOffset[i+1];
+            sort(begin, end);
+            int n = 0;
+            for(std::vector<EdgeCorner>::iterator it = begin; it != end; ++ it)
+            {
+                if(it == begin || it->first != (it-1)->first)
+                    ++ n;
+            }
+            edgeNum[i] = n;
+        }
+    };
+
+    class EdgeAssignPass
+    {
+    public:
+        std::vector<EdgeCorner>& bucket;
+        IndexArray& bucketOffset;
+        IndexArray& edgeOffset;
+        IndexArray& cornerFace;
+        IndexArray& cornerOffset;
+        const FaceInfo& fInfo;
+        IndexArray& eVtx;
+        IndexArray& eFace;
+        IndexArray& fEdge;
+
+        EdgeAssignPass(std::vector<EdgeCorner>& b, IndexArray& bo, IndexArray& eo, IndexArray& cf,
+                       IndexArray& co, const FaceInfo& f, IndexArray& ev, IndexArray& ef, IndexArray& fe)
+            : bucket(b), bucketOffset(bo), edgeOffset(eo), cornerFace(cf),
+              cornerOffset(co), fInfo(f), eVtx(ev), eFace(ef), fEdge(fe) {}
+
+        void operator()(int i) const
+        {
+            // The edges of the bucket of vertex i are numbered from edgeOffset[i] on
+            int eID = edgeOffset[i] - 1;
+            for(int k = bucketOffset[i]; k < bucketOffset[i+1]; ++ k)
+            {
+                const EdgeCorner& ec = bucket[k];
+                if(k == bucketOffset[i] || ec.first != bucket[k-1].first)
+                {
+                    ++ eID;
+                    eVtx[2*eID] = i;
+                    eVtx[2*eID+1] = ec.first;
+                }
+                int c = ec.second;
+                fEdge[c] = eID;
+
+                // Face running from vertex i to the other one goes first, extra faces of non-manifold edges are dropped
+                FaceID fID = cornerFace[c];
+                int side = (fInfo.GetFaceVertices(fID)[c - cornerOffset[fID]] == i) ? 0 : 1;
+                if(eFace[2*eID+side] < 0)
+                    eFace[2*eID+side] = fID;
+                else if(eFace[2*eID+1-side] < 0)
+                    eFace[2*eID+1-side] = fID;
+            }
+        }
+    };
+
+    class CornerFacePass
+    {
+    public:
+        IndexArray& cornerOffset;
+        IndexArray& cornerFace;
+
+        CornerFacePass(IndexArray& co, IndexArray& cf) : cornerOffset(co), cornerFace(cf) {}
+
+        void operator()(int i) const
+        {
+            for(int c = cornerOffset[i]; c < cornerOffset[i+1]; ++ c)
+                cornerFace[c] = i;
+        }
+    };
+
+    class EdgeLengthPass
+    {
+    public:
+        IndexArray& eVtx;
+        CoordArray& vCoord;
+        DoubleArray& eLength;
+
+        EdgeLengthPass(IndexArray& ev, CoordArray& vc, DoubleArray& el) : eVtx(ev), vCoord(vc), eLength(el) {}
+
+        void operator()(int i) const
+        {
+            eLength[i] = (vCoord[eVtx[2*i+1]] - vCoord[eVtx[2*i]]).abs();
+        }
+    };
+
+    class DihedralAnglePass
+    {
+    public:
+        IndexArray& eFace;
+        NormalArray& fNormal;
+        DoubleArray& eAngle;
+
+        DihedralAnglePass(IndexArray& ef, NormalArray& fn, DoubleArray& ea) : eFace(ef), fNormal(fn), eAngle(ea) {}
+
+        void operator()(int i) const
+        {
+            FaceID fID1 = eFace[2*i], fID2 = eFace[2*i+1];
+
+            // if not boundary edge
+            if(fID1 >= 0 && fID2 >= 0)
+                eAngle[i] = angle(fNormal[fID1], fNormal[fID2]);
+            else
+                eAngle[i] = PI / 2.0;
+        }
+    };
+
+    // Rotate the frame (u, v) about the axis u x v so that its normal becomes n
+    void RotateFrame(const Coord& u, const Coord& v, const Coord& n, Coord& ru, Coord& rv)
+    {
+        Coord old_n = cross(u, v);
+        double ndot = dot(old_n, n);
+        ru = u;
+        rv = v;
+        if(ndot <= -1.0)
+        {
+            ru = -u;
+            rv = -v;
+            return;
+        }
+        Coord perp = n - old_n*ndot;
+        Coord dperp = (old_n + n) * (1.0/(1.0+ndot));
+        ru -= dperp*dot(ru, perp);
+        rv -= dperp*dot(rv, perp);
+    }
+
+    // Second fundamental form k = (ku, kuv, kv) in the frame (u, v) expressed in the frame
+    // (new_u, new_v), both frames having the same normal
+    void ProjectTensor(const Coord& u, const Coord& v, const double* k, const Coord& new_u, const Coord& new_v, double* new_k)
+    {
+        double u1 = dot(new_u, u), v1 = dot(new_u, v);
+        double u2 = dot(new_v, u), v2 = dot(new_v, v);
+        new_k[0] = k[0]*u1*u1 + k[1]*(2.0*u1*v1) + k[2]*v1*v1;
+        new_k[1] = k[0]*u1*u2 + k[1]*(u1*v2 + u2*v1) + k[2]*v1*v2;
+        new_k[2] = k[0]*u2*u2 + k[1]*(2.0*u2*v2) + k[2]*v2*v2;
+    }
+
+    // Second fundamental form of each triangle, fitted in its frame (fU, n x fU) to the
+    // change of the vertex normals along its edges
+    class FaceCurvaturePass
+    {
+    public:
+        CoordArray& vCoord;
+        NormalArray& vNormal;
+        FaceInfo& fInfo;
+        NormalArray& fNormal;
+        CoordArray& fU;
+        DoubleArray& fK;
+
+        FaceCurvaturePass(CoordArray& v, NormalArray& vn, FaceInfo& f, NormalArray& fn, CoordArray& u, DoubleArray& k)
+            : vCoord(v), vNormal(vn), fInfo(f), fNormal(fn), fU(u), fK(k) {}
+
+        void operator()(int i) const
+        {
+            double* k = &fK[3*i];
+            k[0] = k[1] = k[2] = 0.0;
+            fU[i] = COORD_AXIS_X;
+            if(fInfo.GetFaceDegree(i) != 3)
+                return;
+            const int* f = fInfo.GetFaceVertices(i);
+
+            Coord u = vCoord[f[2]] - vCoord[f[1]];
+            double len = u.abs();
+            if(len == 0.0)
+                return;
+            u *= 1.0/len;
+            Coord v = cross(fNormal[i], u);
+            fU[i] = u;
+
+            // Least squares over the three edges, normal equations of the unknowns (ku, kuv, kv)
+            double m00 = 0, m01 = 0, m11 = 0, m12 = 0, m22 = 0;
+            double r0 = 0, r1 = 0, r2 = 0;
+            for(int j = 0; j < 3; ++ j)
+            {
+                Coord e = vCoord[f[(j+2)%3]] - vCoord[f[(j+1)%3]];
+                Coord dn = vNormal[f[(j+2)%3]] - vNormal[f[(j+1)%3]];
+                double eu = dot(e, u), ev = dot(e, v);
+                double dnu = dot(dn, u), dnv = dot(dn, v);
+                m00 += eu*eu;
+                m01 += eu*ev;
+                m11 += eu*eu + ev*ev;
+                m12 += eu*ev;
+                m22 += ev*ev;
+                r0 += eu*dnu;
+                r1 += ev*dnu + eu*dnv;
+                r2 += ev*dnv;
+            }
+
+            // Cramer's rule on the symmetric tridiagonal system
+            double det = m00*(m11*m22 - m12*m12) - m01*m01*m22;
+            if(fabs(det) < 1.0e-300)
+                return;
+            k[0] = (r0*(m11*m22 - m12*m12) - m01*(r1*m22 - m12*r2)) / det;
+            k[1] = (m00*(r1*m22 - m12*r2) - r0*m01*m22) / det;
+            k[2] = (m00*(m11*r2 - r1*m12) - m01*(m01*r2) + r0*m01*m12) / det;
+        }
+    };
+
+    // Area weighted average of the adjacent face tensors in the vertex frame (vU, n x vU)
+    class VertexCurvaturePass
+    {
+    public:
+        CoordArray& vCoord;
+        NormalArray& vNormal;
+        PolyIndexArray& vAdjVertices;
+        PolyIndexArray& vAdjFaces;
+        NormalArray& fNormal;
+        DoubleArray& fArea;
+        CoordArray& fU;
+        DoubleArray& fK;
+        CoordArray& vU;
+        DoubleArray& vK;
+        DoubleArray& vArea;
+
+        VertexCurvaturePass(CoordArray& v, NormalArray& vn, PolyIndexArray& av, PolyIndexArray& af, NormalArray& fn,
+                            DoubleArray& fa, CoordArray& fu, DoubleArray& fk, CoordArray& vu, DoubleArray& vk, DoubleArray& va)
+            : vCoord(v), vNormal(vn), vAdjVertices(av), vAdjFaces(af), fNormal(fn), fArea(fa),
+              fU(fu), fK(fk), vU(vu), vK(vk), vArea(va) {}
+
+        void operator()(int i) const
+        {
+            const Normal& n = vNormal[i];
+            double* k = &vK[3*i];
+            k[0] = k[1] = k[2] = 0.0;
+            vArea[i] = 0.0;
+
+            // Tangent frame from the first neighbor
+            Coord u = COORD_AXIS_X;
+            IndexArray& adjVertices = vAdjVertices[i];
+            if(!adjVertices.empty())
+                u = vCoord[adjVertices[0]] - vCoord[i];
+            u -= n*dot(u, n);
+            if(!u.normalize())
+            {
+                u = cross(n, COORD_AXIS_X);
+                if(!u.normalize())
+                    u = cross(n, COORD_AXIS_Y);
+                u.normalize();
+            }
+            Coord v = cross(n, u);
+            vU[i] = u;
+
+            IndexArray& adjFaces = vAdjFaces[i];
+            double weight = 0.0;
+            for(size_t j = 0; j < adjFaces.size(); ++ j)
+            {
+                FaceID fID = adjFaces[j];
+                double w = fArea[fID];
+                Coord ru, rv;
+                double fk[3];
+                RotateFrame(fU[fID], cross(fNormal[fID], fU[fID]), n, ru, rv);
+                ProjectTensor(ru, rv, &fK[3*fID], u, v, fk);
+                k[0] += w*fk[0];
+                k[1] += w*fk[1];
+                k[2] += w*fk[2];
+                weight += w;
+            }
+            if(weight > 0.0)
+            {
+                k[0] /= weight;
+                k[1] /= weight;
+                k[2] /= weight;
+            }
+            vArea[i] = weight / 3.0;
+        }
+    };
+
+    // One ring area weighted average of the vertex tensors, from K into smoothK
+    class CurvatureSmoothPass
+    {
+    public:
+        NormalArray& vNormal;
+        PolyIndexArray& vAdjVertices;
+        CoordArray& vU;
+        DoubleArray& vArea;
+        DoubleArray& K;
+        DoubleArray& smoothK;
+
+        CurvatureSmoothPass(NormalArray& vn, PolyIndexArray& av, CoordArray& vu, DoubleArray& va, DoubleArray& k, DoubleArray& sk)
+            : vNormal(vn), vAdjVertices(av), vU(vu), vArea(va), K(k), smoothK(sk) {}
+
+        void operator()(int i) const
+        {
+            const Normal& n = vNormal[i];
+            Coord u = vU[i], v = cross(n, u);
+            double w = vArea[i];
+            double* sk = &smoothK[3*i];
+            sk[0] = w*K[3*i];
+            sk[1] = w*K[3*i+1];
+            sk[2] = w*K[3*i+2];
+            double weight = w;
+
+            IndexArray& adjVertices = vAdjVertices[i];
+            for(size_t j = 0; j < adjVertices.size(); ++ j)
+            {
+                VertexID vID = adjVertices[j];
+                Coord ru, rv;
+                double k[3];
+                RotateFrame(vU[vID], cross(vNormal[vID], vU[vID]), n, ru, rv);
+                ProjectTensor(ru, rv, &K[3*vID], u, v, k);
+                w = vArea[vID];
+                sk[0] += w*k[0];
+                sk[1] += w*k[1];
+                sk[2] += w*k[2];
+                weight += w;
+            }
+            if(weight > 0.0)
+            {
+                sk[0] /= weight;
+                sk[1] /= weight;
+                sk[2] /= weight;
+            }
+        }
+    };
+
+    // Eigen decomposition of the 2x2 tensor of each vertex
+    class PrincipalCurvaturePass
+    {
+    public:
+        NormalArray& vNormal;
+        CoordArray& vU;
+        DoubleArray& vK;
+        CurvatureArray& vCurvature;
+        DoubleArray& vMean;
+        DoubleArray& vGauss;
+
+        PrincipalCurvaturePass(NormalArray& vn, CoordArray& vu, DoubleArray& vk, CurvatureArray& c, DoubleArray& m, DoubleArray& g)
+            : vNormal(vn), vU(vu), vK(vk), vCurvature(c), vMean(m), vGauss(g) {}
+
+        void operator()(int i) const
+        {
+            double ku = vK[3*i], kuv = vK[3*i+1], kv = vK[3*i+2];
+            double c = 1.0, s = 0.0, t = 0.0;
+            if(kuv != 0.0)
+            {
+                // Jacobi rotation that zeroes the off-diagonal term
+                double h = 0.5*(kv - ku)/kuv;
+                t = (h < 0.0) ? 1.0/(h - sqrt(1.0 + h*h)) : 1.0/(h + sqrt(1.0 + h*h));
+                c = 1.0/sqrt(1.0 + t*t);
+                s = t*c;
+            }
+            double k1 = ku - t*kuv;
+            double k2 = kv + t*kuv;
+
+            const Normal& n = vNormal[i];
+            Coord u = vU[i], v = cross(n, u);
+            Coord d1 = u*c - v*s;
+            Coord d2 = cross(n, d1);
+
+            CCurvature& curv = vCurvature[i];
+            if(k1 >= k2)
+            {
+                curv.m_kmax = k1;
+                curv.m_kmin = k2;
+                curv.m_direction_kmax = d1;
+                curv.m_direction_kmin = d2;
+            }
+            else
+            {
+                curv.m_kmax = k2;
+                curv.m_kmin = k1;
+                curv.m_direction_kmax = d2;
+                curv.m_direction_kmin = d1;
+            }
+            vMean[i] = 0.5*(k1 + k2);
+            vGauss[i] = k1*k2;
+        }
+    };
+}
+
+
 
 /* ================== Vertex information calculation ================== */
 
@@ -91,12 +788,11 @@ void MeshModelBasicOp::CalAdjacentInfo()
     size_t nVertex = vInfo.GetCoord().size();
     vAdjFaces.resize(nVertex);
 
-    PolyIndexArray& fIndex = fInfo.GetIndex();
-    size_t nFace = fIndex.size();
+    size_t nFace = fInfo.GetFaceNum();
     for(i = 0; i < nFace; ++ i)
     {
-        IndexArray& f = fIndex[i];
-        n = f.size();
+        const int* f = fInfo.GetFaceVertices((FaceID) i);
+        n = fInfo.GetFaceDegree((FaceID) i);
         for(j = 0; j < n; ++ j)
         {
             VertexID vID = f[j];    // vID is the jth vertex of ith Face
@@ -106,38 +802,7 @@ void MeshModelBasicOp::CalAdjacentInfo()
 
     // Calculate the adjacent vertices for each vertex
     vAdjVertices.resize(nVertex);
-    for(i = 0; i < nVertex; ++ i)
-    {
-        // Gathering the adjacent vertices of vertex i from adjacent faces
-        IndexArray& adjVertices = vAdjVertices[i];
-        IndexArray& adjFaces = vAdjFaces[i];
-        n = adjFaces.size();
-        for(j = 0; j < n; ++ j)
-        {
-            FaceID fID = vAdjFaces[i][j];
-            IndexArray& face = fIndex[fID];
-            // Find the position of vertex i in face fID
-            size_t idx = distance(face.begin(), find(face.begin(), face.end(), i));
-            assert(idx >= 0 && idx < face.size());
-
-            // Add previous and next vertices of vertex i to adjacent-vertex array
-            size_t m = face.size();
-            adjVertices.push_back(face[(idx+1)%m]);
-            adjVertices.push_back(face[(idx+m-1)%m]);
-        }
-
-        // Validate the 1-ring neighborhood of vertex i
-        // Make sure NOT contain central vertex i
-        adjVertices.erase(remove(adjVertices.begin(), adjVertices.end(), i), adjVertices.end());
-        // Sort for the next function unique
-        sort(adjVertices.begin(), adjVertices.end());
-        // Make sure NO duplicated adjacent vertex, but does not resize the vector
-        // Resize the vector so that only contain all necessary elements
-        adjVertices.erase(unique(adjVertices.begin(), adjVertices.end()), adjVertices.end());
-
-        // Debug
-//        util.PrintArray(adjVertices, "Adjvertices");
-    }
+    parallel_for(0, (int) nVertex, AdjVerticesPass(fInfo, vAdjFaces, vAdjVertices));
 
     // Debug
 //    for(i = 0; i < nVertex; ++ i)
@@ -159,21 +824,7 @@ void MeshModelBasicOp::CalVertexNormal()
 
     size_t nVertex = vCoord.size();
     vNormal.resize(nVertex);
-    size_t i, j, n;
-    for(i = 0; i < nVertex; ++ i)
-    {
-        n = vAdjFaces[i].size();
-        Normal& vn = vNormal[i];
-        vn.setCoords(0.0, 0.0, 0.0);
-        for(j = 0; j < n; ++ j)
-        {
-            FaceID fID = vAdjFaces[i][j];
-            vn += fNormal[fID];
-        }
-
-        if(!vn.normalize())
-            vn = COORD_AXIS_Z;
-    }
+    parallel_for(0, (int) nVertex, VertexNormalPass(fNormal, vAdjFaces, vNormal));
 }
 
 // Calculate normal vector of selected vertices
@@ -211,41 +862,26 @@ void MeshModelBasicOp::CalVertexNormal(IntArray& arrIndex)
 void MeshModelBasicOp::CalFaceNormal()
 {
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-
-    size_t nVertex = vCoord.size();
-    size_t nFace = fIndex.size();
+    size_t nFace = kernel->GetFaceInfo().GetFaceNum();
 
     NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
     fNormal.resize(nFace);
-    size_t i, j, n;
-    Coord v[3];
-    for(i = 0; i < nFace; ++ i)
-    {
-        IndexArray& f = fIndex[i];
-        n = f.size();
-        for(j = 0; j < 3; ++ j)
-            v[j] = vCoord[f[j]];
-        Normal& fn = fNormal[i];
-        fn = cross(v[1]-v[0], v[2]-v[0]);
-        if(!fn.normalize())
-            fn = COORD_AXIS_Z;
-    }
+    parallel_for(0, (int) nFace, FaceNormalPass(vCoord, kernel->GetFaceInfo(), fNormal));
 }
 
 // Calculate normal vector of selected faces
 void MeshModelBasicOp::CalFaceNormal(IntArray& arrIndex)
 {
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
+    FaceInfo& fInfo = kernel->GetFaceInfo();
+    NormalArray& fNormal = fInfo.GetNormal();
 
     Coord v[3];
     size_t i, j, n = arrIndex.size();
     for(i = 0; i < n; ++ i)
     {
         FaceID fID = arrIndex[i];
-        IndexArray& f = fIndex[fID];
+        const int* f = fInfo.GetFaceVertices(fID);
         for(j = 0; j < 3; ++ j)
             v[j] = vCoord[f[j]];
         Normal& fn = fNormal[fID];
@@ -259,49 +895,22 @@ void MeshModelBasicOp::CalFaceBaryCenter()
 {
 	// cal the BaryCenter of each face.
 	FaceInfo& fInfo = kernel->GetFaceInfo();
-	PolyIndexArray& polyIndexArray = fInfo.GetIndex();
 	VertexInfo& vInfo = kernel->GetVertexInfo();
 	CoordArray& arrCoord = vInfo.GetCoord();
-	size_t nFace = polyIndexArray.size();
+	size_t nFace = fInfo.GetFaceNum();
 
 	CoordArray& fBaryCenter = kernel->GetFaceInfo().GetBaryCenter();
 	fBaryCenter.resize(nFace);
-
-	for (size_t i = 0; i < polyIndexArray.size(); i++)
-	{
-		IndexArray indexArray = polyIndexArray[i];
-        Coord& center = fBaryCenter[i];
-		center = (arrCoord[indexArray[0]] + arrCoord[indexArray[1]] + arrCoord[indexArray[2]]) / 3;
-	}
+	parallel_for(0, (int) nFace, FaceBaryCenterPass(arrCoord, fInfo, fBaryCenter));
 }
 void MeshModelBasicOp::CalFaceArea()
 {
 	CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
 	DoubleArray& faceArea = kernel->GetFaceInfo().GetFaceArea();
 	
-	size_t nFace = fIndex.size();
+	size_t nFace = kernel->GetFaceInfo().GetFaceNum();
 	faceArea.resize(nFace);
-
-    size_t i, j;
-	Coord v[3], fNormal;
-	double area;
-	
-	for (j = 0; j < nFace; j++)
-
-	{
-		IndexArray& face = fIndex[j];
-		
-		for(i = 0; i < 3; i ++)
-		{
-            v[i] = vCoord[face[i]];
-		}
-		
-		fNormal = cross(v[1]-v[0], v[2]-v[0]);
-		area = fNormal.abs();
-		
-		faceArea[j] = area / 2;
-	}
+	parallel_for(0, (int) nFace, FaceAreaPass(vCoord, kernel->GetFaceInfo(), faceArea));
 }
 
 /* ================== Edge information calculation, optional functions ================== */
@@ -315,92 +924,104 @@ void MeshModelBasicOp::CreateHalfEdge()
 void MeshModelBasicOp::CalHalfEdgeInfo()
 {
 }
-// Calculate the edge information, optional function
-void MeshModelBasicOp::CalVertexEdgeInfo()
+// Calculate the edge table, the face-edge and the vertex-edge indices, optional function
+// The edges are sorted by their (smaller, larger) vertex pairs
+void MeshModelBasicOp::CalEdgeInfo()
 {
-	PolyIndexArray& polyIndexArray = kernel->GetEdgeInfo().GetVertexIndex();
-	CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-	PolyIndexArray& adjVerticesArray = kernel->GetVertexInfo().GetAdjVertices();
-	
-	size_t i;
-	size_t nVertex = vCoord.size();
-	vector<bool> Visited;
-	Visited.resize(nVertex);
-	fill(Visited.begin(), Visited.end(), false);
+    EdgeInfo& eInfo = kernel->GetEdgeInfo();
+    FaceInfo& fInfo = kernel->GetFaceInfo();
+    int nVertex = (int) kernel->GetVertexInfo().GetCoord().size();
+    int nFace = fInfo.GetFaceNum();
+
+    // Numbering the face corners, corner j of a face starts the edge to corner j+1
+    IndexArray& cornerOffset = eInfo.GetFaceEdgeOffset();
+    cornerOffset.resize(nFace+1);
+    cornerOffset[0] = 0;
+    for(int i = 0; i < nFace; ++ i)
+        cornerOffset[i+1] = cornerOffset[i] + fInfo.GetFaceDegree(i);
+    int nCorner = cornerOffset[nFace];
+
+    IndexArray cornerFace(nCorner);
+    parallel_for(0, nFace, CornerFacePass(cornerOffset, cornerFace));
+
+    // Bucketing the corners by the smaller vertex of their edge
+    IndexArray bucketOffset(nVertex+1, 0);
+    for(int i = 0; i < nFace; ++ i)
+    {
+        const int* face = fInfo.GetFaceVertices(i);
+        size_t n = fInfo.GetFaceDegree(i);
+        for(size_t j = 0; j < n; ++ j)
+            ++ bucketOffset[min(face[j], face[(j+1)%n]) + 1];
+    }
+    for(int i = 0; i < nVertex; ++ i)
+        bucketOffset[i+1] += bucketOffset[i];
 
-	//
-	for (i = 0; i < nVertex; i++)
-	{
-		IndexArray& adjVertices = adjVerticesArray[i];
+    std::vector<EdgeCorner> bucket(nCorner);
+    IndexArray bucketPos(bucketOffset.begin(), bucketOffset.end() - 1);
+    for(int i = 0; i < nFace; ++ i)
+    {
+        const int* face = fInfo.GetFaceVertices(i);
+        size_t n = fInfo.GetFaceDegree(i);
+        for(size_t j = 0; j < n; ++ j)
+        {
+            int v1 = face[j], v2 = face[(j+1)%n];
+            bucket[bucketPos[min(v1, v2)] ++] = EdgeCorner(max(v1, v2), cornerOffset[i] + (int) j);
+        }
+    }
 
-		for (size_t j = 0; j < adjVertices.size(); j++)
-		{
-			if (!Visited[adjVertices[j]])
-			{
-				IndexArray edge;
-				edge.clear();
-				edge.push_back((int) i);
-				edge.push_back(adjVertices[j]);
-			    polyIndexArray.push_back(edge);
-			}
-		}
-        Visited[i] = true;
-	}
+    // Sorting each bucket and numbering the edges
+    IndexArray edgeOffset(nVertex+1, 0);
+    parallel_for(0, nVertex, EdgeBucketPass(bucket, bucketOffset, edgeOffset));
+    int nEdge = 0;
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        int n = edgeOffset[i];
+        edgeOffset[i] = nEdge;
+        nEdge += n;
+    }
+    edgeOffset[nVertex] = nEdge;
+
+    IndexArray& eVtx = eInfo.GetVertexIndex();
+    IndexArray& eFace = eInfo.GetFaceIndex();
+    IndexArray& fEdge = eInfo.GetFaceEdge();
+    eVtx.assign(2*nEdge, -1);
+    eFace.assign(2*nEdge, -1);
+    fEdge.resize(nCorner);
+    parallel_for(0, nVertex, EdgeAssignPass(bucket, bucketOffset, edgeOffset, cornerFace,
+                                            cornerOffset, fInfo, eVtx, eFace, fEdge));
+
+    // Vertex-edge index
+    IndexArray& vEdgeOffset = eInfo.GetVertexEdgeOffset();
+    IndexArray& vEdge = eInfo.GetVertexEdge();
+    vEdgeOffset.assign(nVertex+1, 0);
+    for(int i = 0; i < 2*nEdge; ++ i)
+        ++ vEdgeOffset[eVtx[i]+1];
+    for(int i = 0; i < nVertex; ++ i)
+        vEdgeOffset[i+1] += vEdgeOffset[i];
+    vEdge.resize(2*nEdge);
+    IndexArray vEdgePos(vEdgeOffset.begin(), vEdgeOffset.end() - 1);
+    for(int i = 0; i < 2*nEdge; ++ i)
+        vEdge[vEdgePos[eVtx[i]] ++] = i / 2;
 }
 
-void MeshModelBasicOp::CalFaceEdgeInfo()
+// Calculate the dihedral angle information, needs the edge table and the face normals
+void MeshModelBasicOp::CalDihedralAngle()
 {
-	PolyIndexArray& vtxIdxArray = kernel->GetEdgeInfo().GetVertexIndex();
-	PolyIndexArray& faceIdxArray = kernel->GetEdgeInfo().GetFaceIndex();
-
-	faceIdxArray.clear();
-	faceIdxArray.resize(vtxIdxArray.size());
-
-	for (size_t i = 0; i < vtxIdxArray.size(); i++)
-	{
-		IndexArray& edge_vtx = vtxIdxArray[i];
-		IndexArray& edge_face = faceIdxArray[i];
-
-		int fid1, fid2;
-		GetAdjacentFace(edge_vtx[0], edge_vtx[1], fid1, fid2);
-		if (fid1 >= 0)
-		{
-			edge_face.push_back(fid1);
-		}
-		if (fid2 >= 0)
-		{
-			edge_face.push_back(fid2);
-		}
-	}
+    EdgeInfo& eInfo = kernel->GetEdgeInfo();
+    int nEdge = (int) eInfo.GetEdgeNum();
+    DoubleArray& angleArray = eInfo.GetDihedralAngle();
+    angleArray.resize(nEdge);
+    parallel_for(0, nEdge, DihedralAnglePass(eInfo.GetFaceIndex(), kernel->GetFaceInfo().GetNormal(), angleArray));
 }
 
-// Calculate the dihedral angle information, optional function
-void MeshModelBasicOp::CalDihedralAngle()
+// Calculate the edge lengths, needs the edge table
+void MeshModelBasicOp::CalEdgeLength()
 {
-	PolyIndexArray& polyIndexArray = kernel->GetEdgeInfo().GetVertexIndex();
-	size_t nEdge = polyIndexArray.size();
-	DoubleArray& angleArray = kernel->GetEdgeInfo().GetDihedralAngle();
-	angleArray.resize(nEdge);
-	NormalArray& noramlArray = kernel->GetFaceInfo().GetNormal();
-
-	// calculate the dihedral angle here.
-	for (size_t i = 0; i < nEdge; i++)
-	{
-		IndexArray& indexArray = polyIndexArray[i];
-		FaceID faceID1, faceID2;
-		GetAdjacentFace(indexArray[0], indexArray[1], faceID1, faceID2);
-
-		// if not boundary edge
-		if (faceID1 >= 0 && faceID2 >= 0)
-		{
-			angleArray[i] = angle(noramlArray[faceID1], noramlArray[faceID2]);
-		}
-		else
-		{
-			angleArray[i] = PI / 2.0;
-		}
-		//double a = angle(noramlArray[faceID1], noramlArray[faceID2]);
-	}
+    EdgeInfo& eInfo = kernel->GetEdgeInfo();
+    int nEdge = (int) eInfo.GetEdgeNum();
+    DoubleArray& lengthArray = eInfo.GetLength();
+    lengthArray.resize(nEdge);
+    parallel_for(0, nEdge, EdgeLengthPass(eInfo.GetVertexIndex(), kernel->GetVertexInfo().GetCoord(), lengthArray));
 }
 /* ================== Model information calculation ================== */
 
@@ -410,36 +1031,22 @@ void MeshModelBasicOp::CalBoundingBox()
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
     size_t nVertex = vCoord.size();
 
-    size_t i;
-	int j;
     Coord BoxMin, BoxMax, SphereCenter;
     double SphereRadius;
-    for(j = 0; j < 3; ++ j)
-        BoxMin[j] = BoxMax[j] = SphereCenter[j] = vCoord[0][j];
 
     // Calculate the bounding box and the center of the bounding sphere
-    for(i = 1; i < nVertex; ++ i)
-    {
-        Coord& v = vCoord[i];
-		for(j = 0; j < 3; ++ j)
-		{
-			if(v[j] < BoxMin[j])
-				BoxMin[j] = v[j];
-			if(v[j] > BoxMax[j])
-				BoxMax[j] = v[j];
-            SphereCenter[j] += v[j];
-		}
-    }
-    SphereCenter /= (double)nVertex;
+    BoundingBoxData init;
+    init.BoxMin = init.BoxMax = vCoord[0];
+    init.Sum = Coord(0.0, 0.0, 0.0);
+    BoundingBoxPass BoxPass(vCoord);
+    BoundingBoxData box = parallel_reduce(0, (int) nVertex, init, BoxPass, BoxPass);
+    BoxMin = box.BoxMin;
+    BoxMax = box.BoxMax;
+    SphereCenter = box.Sum / (double)nVertex;
 
     // Calculate the radius of the bounding sphere
-    SphereRadius = (vCoord[0]-SphereCenter).abs();
-    for(i = 1; i < nVertex; ++ i)
-    {
-        double r = (vCoord[i]-SphereCenter).abs();
-        if(r > SphereRadius)
-            SphereRadius = r;
-    }
+    SphereRadiusPass RadiusPass(vCoord, SphereCenter);
+    SphereRadius = parallel_reduce(0, (int) nVertex, 0.0, RadiusPass, RadiusPass);
 
     // Update corresponding model information
     ModelInfo& mInfo = kernel->GetModelInfo();
@@ -548,14 +1155,15 @@ int MeshModelBasicOp::AdjFaceNum(VertexID vID, VertexID vID2)
     int fID;
 	int nAdjFace = 0;
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
 
 	size_t n = vAdjFaces[vID].size();
 	for(size_t i = 0; i < n; ++ i)
 	{
 		fID = vAdjFaces[vID][i];
-        IndexArray& face = fIndex[fID];
-        if(find(face.begin(), face.end(), vID2) != face.end()) // find end point in current polygon
+        const int* face = fInfo.GetFaceVertices(fID);
+        const int* face_end = face + fInfo.GetFaceDegree(fID);
+        if(find(face, face_end, vID2) != face_end) // find end point in current polygon
 			nAdjFace ++;
 	}
 	return nAdjFace;
@@ -568,11 +1176,10 @@ void MeshModelBasicOp::TopologyAnalysis()
     FlagArray& vFlag = kernel->GetVertexInfo().GetFlag();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
     FlagArray& fFlag = kernel->GetFaceInfo().GetFlag();
 
     size_t nVertex = vCoord.size();
-    size_t nFace = fIndex.size();
+    size_t nFace = kernel->GetFaceInfo().GetFaceNum();
 
     size_t i, j, n;
     vFlag.resize(nVertex);
@@ -580,97 +1187,44 @@ void MeshModelBasicOp::TopologyAnalysis()
     fill(vFlag.begin(),vFlag.end(), 0);
     fill(fFlag.begin(),fFlag.end(), 0);
 
-	ofstream fout("bad_topogloy.txt");
+    // Classify the vertices in parallel
+    std::vector<char> vReport(nVertex, 0);
+    parallel_for(0, (int) nVertex, VertexTopologyPass(this, vAdjFaces, vAdjVertices, vFlag, vReport));
 
+    // Mark the non-manifold edges and vertices in vertex order
     bool bManifoldModel = true;
     for(i = 0; i < nVertex; ++ i)
     {
-        IndexArray& adjFaces = vAdjFaces[i];
-        Flag& flag = vFlag[i];
-
-        n = adjFaces.size();
-        if(!n)  // Isolated vertex
-        {
-            util.SetFlag(flag, VERTEX_FLAG_ISOLATED);
+        if(!vReport[i])
             continue;
-        }
 
-        // Check topology for the 1-ring neighborhood of vertex i
         IndexArray& adjVertices = vAdjVertices[i];
         n = adjVertices.size();
-        int nBdyFace = 0, nNonManifoldFace = 0;
         for(j = 0; j < n; ++ j)
         {
             switch(AdjFaceNum((int) i, adjVertices[j]))
             {
             case 1:     // Boundary
-                ++ nBdyFace;
-		//		auxdata->AddLine(vCoord[i], vCoord[adjVertices[j]], DARK_GREEN);
-				fout << i+1 <<' '<<adjVertices[j]+1 <<endl;
                 break;
             case 2:     // 2-Manifold
                 break;
             default:    // Non-Manifold
-                ++ nNonManifoldFace;
 				auxdata->AddLine(vCoord[i], vCoord[adjVertices[j]], DARK_GREEN);
-				fout << i+1 <<' '<<adjVertices[j]+1 <<endl;
             }
-			
         }
-        if(nNonManifoldFace || nBdyFace > 2)    // Non-manifold vertex
+        if(!util.IsSetFlag(vFlag[i], VERTEX_FLAG_MANIFOLD))    // Non-manifold vertex
         {
             Coord v = vCoord[i];
             auxdata->AddPoint(v, DARK_RED);
-			fout<< i+1 << endl;
             bManifoldModel = false;
-            continue;
         }
-
-// 		auxdata->AddPoint(vCoord[0], DARK_RED);
-// 		auxdata->AddPoint(vCoord[15], DARK_GREEN);
-// 		auxdata->AddPoint(vCoord[240], DARK_BLUE);
-// 		auxdata->AddPoint(vCoord[255], DARK_GREY);
-        
-        // Manifold vertex
-        util.SetFlag(flag, VERTEX_FLAG_MANIFOLD);
-        if(nBdyFace == 2)   // Boundary vertex
-            util.SetFlag(flag, VERTEX_FLAG_BOUNDARY);
     }
-	fout.close();
 
     // Set face flag
-    bool bTriMesh = true;
-    bool bQuadMesh = true;
-    for(i = 0; i < nFace; ++ i)
-    {
-        IndexArray& f = fIndex[i];
-        n = f.size();
-
-        if(n != 3)
-            bTriMesh = false;
-        else if(n != 4)
-            bQuadMesh = false;
-
-        int nBdyVtx = 0;
-        bool bManifoldFace = true;
-        for(j = 0; j < n; ++ j)
-        {
-            if(!util.IsSetFlag(vFlag[f[j]], VERTEX_FLAG_MANIFOLD))
-            {
-                bManifoldFace = false;
-                break;
-            }
-            else if(util.IsSetFlag(vFlag[f[j]], VERTEX_FLAG_BOUNDARY))
-                nBdyVtx ++;
-        }
-        Flag& flag = fFlag[i];
-        if(bManifoldFace)
-        {
-            util.SetFlag(flag, FACE_FLAG_MANIFOLD);
-            if(nBdyVtx > 1)
-                util.SetFlag(flag, FACE_FLAG_BOUNDARY);
-        }
-    }
+    FaceTopologyPass FacePass(kernel->GetFaceInfo(), vFlag, fFlag);
+    int nFaceType = parallel_reduce(0, (int) nFace, 3, FacePass, FacePass);
+    bool bTriMesh = (nFaceType & 1) != 0;
+    bool bQuadMesh = (nFaceType & 2) != 0;
 
     // Set model flag
     Flag& mFlag = kernel->GetModelInfo().GetFlag();
@@ -704,116 +1258,121 @@ void MeshModelBasicOp::TopologyAnalysis()
 // Make sure the 1-ring neighbors are CCW order
 void MeshModelBasicOp::SortAdjacentInfo()
 {
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    size_t nVertex = kernel->GetVertexInfo().GetCoord().size();
+
+    // The 1-ring of each vertex is sorted independently
+    parallel_for(0, (int) nVertex, SortAdjacentPass(this));
+}
+
+// Sort the 1-ring neighbors of a manifold vertex in CCW order
+void MeshModelBasicOp::SortAdjacentInfo(VertexID vID)
+{
     FlagArray& vFlag = kernel->GetVertexInfo().GetFlag();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
     FlagArray& fFlag = kernel->GetFaceInfo().GetFlag();
 
-    size_t nVertex = vCoord.size();
-    size_t nFace = fIndex.size();
-    
-    size_t i, j, n, m;
+    size_t j, n, m;
 	size_t k;
-    for(i = 0; i < nVertex; ++ i)
-    {
-        Flag& flag = vFlag[i];
-        if(!util.IsSetFlag(flag, VERTEX_FLAG_MANIFOLD))  // Non-manifold vertex
-            continue;
-        if(util.IsSetFlag(flag, VERTEX_FLAG_ISOLATED))  // Isolated vertex
-            continue;
 
-        // Only for manifold vertex
-        IndexArray& adjFaces = vAdjFaces[i];
-        n = adjFaces.size();
-        assert(n > 0);
+    Flag& flag = vFlag[vID];
+    if(!util.IsSetFlag(flag, VERTEX_FLAG_MANIFOLD))  // Non-manifold vertex
+        return;
+    if(util.IsSetFlag(flag, VERTEX_FLAG_ISOLATED))  // Isolated vertex
+        return;
 
-        // Find the start face
-        FaceID start_fID = adjFaces[0];
-        if(util.IsSetFlag(flag, VERTEX_FLAG_BOUNDARY))   // Boundary vertex
-        {
-            start_fID = -1;
-            for(j = 0; j < n; ++ j)
-            {
-                FaceID fID = adjFaces[j];
-                if(!util.IsSetFlag(fFlag[fID], FACE_FLAG_BOUNDARY))
-                    continue;
-                IndexArray& face = fIndex[fID];
-                size_t idx = distance(face.begin(), find(face.begin(), face.end(), i));
-                VertexID next_vID = face[(idx+1)%face.size()];
-                if(util.IsSetFlag(vFlag[next_vID], VERTEX_FLAG_BOUNDARY))   // Find it
-                {
-                    if(AdjFaceNum((int) i, next_vID) == 1)    // Make sure it is a boundary edge (i, next_vID)
-                    {
-                        start_fID = fID;
-                        break;
-                    }
-                }
-            }
-            assert(start_fID != -1);
-        }
+    // Only for manifold vertex
+    IndexArray& adjFaces = vAdjFaces[vID];
+    n = adjFaces.size();
+    assert(n > 0);
 
-        // Iteratively find the next neighboring face
-        IndexArray Sorted;
-        Sorted.reserve(n);
-        
-        IndexArray Idx;     // Record the index of vertex i in each sorted adjacent face
-        Idx.reserve(n);
+    // Find the start face
+    FaceID start_fID = adjFaces[0];
+    if(util.IsSetFlag(flag, VERTEX_FLAG_BOUNDARY))   // Boundary vertex
+    {
+        start_fID = -1;
         for(j = 0; j < n; ++ j)
         {
-            IndexArray& face = fIndex[start_fID];
-            m = face.size();
-            size_t idx = distance(face.begin(), find(face.begin(), face.end(), i));
-            Idx.push_back((int) idx);
-            
-            // Vertex i may have only 1 adjacent face
-            if(j == n-1)    // Last one, Not need to find the next neighboring face
+            FaceID fID = adjFaces[j];
+            if(!util.IsSetFlag(fFlag[fID], FACE_FLAG_BOUNDARY))
                 continue;
-
-            Sorted.push_back(start_fID);
-            adjFaces.erase(remove(adjFaces.begin(), adjFaces.end(), start_fID), adjFaces.end());
-        
-            VertexID prev_vID = face[(idx+m-1)%m];
-            for(k = 0; k < adjFaces.size(); ++ k)
+            const int* face = fInfo.GetFaceVertices(fID);
+            m = fInfo.GetFaceDegree(fID);
+            size_t idx = find(face, face+m, vID) - face;
+            VertexID next_vID = face[(idx+1)%m];
+            if(util.IsSetFlag(vFlag[next_vID], VERTEX_FLAG_BOUNDARY))   // Find it
             {
-                FaceID fID = adjFaces[k];
-                IndexArray& f = fIndex[fID];
-                size_t idx = distance(f.begin(), find(f.begin(), f.end(), i));
-                VertexID next_vID = f[(idx+1)%f.size()];
-                if(next_vID == prev_vID)    // Next neighboring face
+                if(AdjFaceNum(vID, next_vID) == 1)    // Make sure it is a boundary edge (vID, next_vID)
                 {
                     start_fID = fID;
                     break;
                 }
             }
         }
-        assert(adjFaces.size() >= 1);
-        Sorted.push_back(adjFaces[0]);
-        adjFaces.clear();
-        adjFaces = Sorted;
+        assert(start_fID != -1);
+    }
 
-        // Set sorted adjacent vertices for vertex i
-        IndexArray& adjVertices = vAdjVertices[i];
-        adjVertices.clear();
-        n = adjFaces.size();
-        for(j = 0; j < n; ++ j)
-        {
-            IndexArray& face = fIndex[adjFaces[j]];
-            int idx = Idx[j];
-            m = face.size();
-            VertexID vID = face[(idx+1)%m];
-            adjVertices.push_back(vID);
-        }
-        if(util.IsSetFlag(vFlag[i], VERTEX_FLAG_BOUNDARY))  // Boundary vertex, add one more adjacent vertex
+    // Iteratively find the next neighboring face
+    IndexArray Sorted;
+    Sorted.reserve(n);
+    
+    IndexArray Idx;     // Record the index of vertex vID in each sorted adjacent face
+    Idx.reserve(n);
+    for(j = 0; j < n; ++ j)
+    {
+        const int* face = fInfo.GetFaceVertices(start_fID);
+        m = fInfo.GetFaceDegree(start_fID);
+        size_t idx = find(face, face+m, vID) - face;
+        Idx.push_back((int) idx);
+        
+        // Vertex vID may have only 1 adjacent face
+        if(j == n-1)    // Last one, Not need to find the next neighboring face
+            continue;
+
+        Sorted.push_back(start_fID);
+        adjFaces.erase(remove(adjFaces.begin(), adjFaces.end(), start_fID), adjFaces.end());
+    
+        VertexID prev_vID = face[(idx+m-1)%m];
+        for(k = 0; k < adjFaces.size(); ++ k)
         {
-            IndexArray& face = fIndex[adjFaces[n-1]];
-            int idx = Idx[n-1];
-            m = face.size();
-            VertexID vID = face[(idx+m-1)%m];
-            adjVertices.push_back(vID);
+            FaceID fID = adjFaces[k];
+            const int* f = fInfo.GetFaceVertices(fID);
+            size_t nf = fInfo.GetFaceDegree(fID);
+            size_t idx = find(f, f+nf, vID) - f;
+            VertexID next_vID = f[(idx+1)%nf];
+            if(next_vID == prev_vID)    // Next neighboring face
+            {
+                start_fID = fID;
+                break;
+            }
         }
     }
+    assert(adjFaces.size() >= 1);
+    Sorted.push_back(adjFaces[0]);
+    adjFaces.clear();
+    adjFaces = Sorted;
+
+    // Set sorted adjacent vertices for vertex vID
+    IndexArray& adjVertices = vAdjVertices[vID];
+    adjVertices.clear();
+    n = adjFaces.size();
+    for(j = 0; j < n; ++ j)
+    {
+        const int* face = fInfo.GetFaceVertices(adjFaces[j]);
+        int idx = Idx[j];
+        m = fInfo.GetFaceDegree(adjFaces[j]);
+        VertexID adj_vID = face[(idx+1)%m];
+        adjVertices.push_back(adj_vID);
+    }
+    if(util.IsSetFlag(vFlag[vID], VERTEX_FLAG_BOUNDARY))  // Boundary vertex, add one more adjacent vertex
+    {
+        const int* face = fInfo.GetFaceVertices(adjFaces[n-1]);
+        int idx = Idx[n-1];
+        m = fInfo.GetFaceDegree(adjFaces[n-1]);
+        VertexID adj_vID = face[(idx+m-1)%m];
+        adjVertices.push_back(adj_vID);
+    }
 }
 
 // Boundary calculation
@@ -879,6 +1438,11 @@ void MeshModelBasicOp::InitModel()
     
     printf("Analyze the mesh model...\n");
 
+    kernel->IncModifyCount();
+
+    // The faces of a triangle model go to the triangle store, after an edit through GetIndex() too
+    kernel->GetFaceInfo().BuildTriIndex();
+
     // Calculating the adjacent information for each vertex - the basic topological data structure
     CalAdjacentInfo();
 
@@ -910,18 +1474,18 @@ void MeshModelBasicOp::InitModel()
 	kernel->GetModelInfo().SetAvgEdgeLength(GetAvgEdgeLength());
 
 	// cal the dihedral angle here.
-	CalVertexEdgeInfo();
-	CalFaceEdgeInfo();
+	CalEdgeInfo();
 	CalDihedralAngle();
+    CalEdgeLength();
 
 	// cal the vertex curature here.
-	//CalVertexCurvature();
+	CalVertexCurvature();
 
 	//m_VertexFlag.resize(kernel->GetVertexInfo().GetCoord().size());
 
 	/// 
 	int vert_num = (int)kernel->GetVertexInfo().GetCoord().size();
-	int face_num = (int)kernel->GetFaceInfo().GetIndex().size();
+	int face_num = kernel->GetFaceInfo().GetFaceNum();
 
 	kernel->GetModelInfo().SetVertexNum(vert_num);
 	kernel->GetModelInfo().SetFaceNum(face_num);
@@ -1020,46 +1584,42 @@ void MeshModelBasicOp::GetShortestPath(VertexID vStart, VertexID vEnd, IndexArra
 
 // Flood fill from a seed to marked boundary
 void MeshModelBasicOp::SurfaceFloodFillVertex(VertexID vID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedVtx)
+{
+    MeshModelPooledQueryContext context(m_QueryContextPool);
+    SurfaceFloodFillVertex(vID, FillVtx, FillFace, SelectedVtx, context.Get());
+}
+
+void MeshModelBasicOp::SurfaceFloodFillVertex(VertexID vID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedVtx, MeshModelQueryContext& context)
 {
     assert(IsValidVertexIndex(vID));
 
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+	const FaceInfo& fInfo = kernel->GetFaceInfo();
 
-    size_t nVertex = vAdjVertices.size();
-    size_t nFace = fIndex.size();
-
-    BoolArray VtxVisited, FaceVisited;
-    VtxVisited.resize(nVertex);
-    FaceVisited.resize(nFace);
-    fill(VtxVisited.begin(), VtxVisited.end(), false);
-    fill(FaceVisited.begin(), FaceVisited.end(), false);
-    VtxVisited[vID] = true;
+    context.Begin(vAdjVertices.size(), fInfo.GetFaceNum());
+    context.MarkVertex(vID);
 
     // Mark boundary vertices
     size_t i, n = SelectedVtx.size();
     for(i = 0; i < n; ++ i)
-        VtxVisited[SelectedVtx[i]] = true;
+        context.MarkVertex(SelectedVtx[i]);
 
     // Gather filled vertices
-    stack<VertexID> Stack;
-    Stack.push(vID);
+    IndexArray& Stack = context.m_Stack;
+    Stack.push_back(vID);
 
     while(!Stack.empty())
     {
-        VertexID vID = Stack.top();
-        Stack.pop();
+        VertexID vID = Stack.back();
+        Stack.pop_back();
         IndexArray& adjVertices = vAdjVertices[vID];
         n = adjVertices.size();
         for(i = 0; i < n; ++ i)
         {
             VertexID vtxID = adjVertices[i];
-            if(!VtxVisited[vtxID])
-            {
-                Stack.push(vtxID);
-                VtxVisited[vtxID] = true;
-            }
+            if(context.MarkVertex(vtxID))
+                Stack.push_back(vtxID);
         }
 
         FillVtx.push_back(vID);
@@ -1075,48 +1635,44 @@ void MeshModelBasicOp::SurfaceFloodFillVertex(VertexID vID, IndexArray& FillVtx,
         for(j = 0; j < m; ++ j)
         {
             FaceID fID = adjFaces[j];
-            if(!FaceVisited[fID])
-            {
+            if(context.MarkFace(fID))
                 FillFace.push_back(fID);
-                FaceVisited[fID] = true;
-            }
         }
     }
 }
 
 void MeshModelBasicOp::SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedFace)
+{
+    MeshModelPooledQueryContext context(m_QueryContextPool);
+    SurfaceFloodFillFace(fID, FillVtx, FillFace, SelectedFace, context.Get());
+}
+
+void MeshModelBasicOp::SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedFace, MeshModelQueryContext& context)
 {
     assert(IsValidFaceIndex(fID));
 
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+	const FaceInfo& fInfo = kernel->GetFaceInfo();
 
-    size_t nVertex = vAdjVertices.size();
-    size_t nFace = fIndex.size();
-
-    BoolArray VtxVisited, FaceVisited;
-    VtxVisited.resize(nVertex);
-    FaceVisited.resize(nFace);
-    fill(VtxVisited.begin(), VtxVisited.end(), false);
-    fill(FaceVisited.begin(), FaceVisited.end(), false);
-    FaceVisited[fID] = true;
+    context.Begin(vAdjVertices.size(), fInfo.GetFaceNum());
+    context.MarkFace(fID);
 
     // Mark boundary faces
     size_t i, n = SelectedFace.size();
     for(i = 0; i < n; ++ i)
-        FaceVisited[SelectedFace[i]] = true;
+        context.MarkFace(SelectedFace[i]);
 
-    // Gather filled vertices
-    stack<VertexID> Stack;
-    Stack.push(fID);
+    // Gather filled faces
+    IndexArray& Stack = context.m_Stack;
+    Stack.push_back(fID);
 
     while(!Stack.empty())
     {
-        FaceID fID = Stack.top();
-        Stack.pop();
-        IndexArray& face = fIndex[fID];
-        n = face.size();
+        FaceID fID = Stack.back();
+        Stack.pop_back();
+        const int* face = fInfo.GetFaceVertices(fID);
+        n = fInfo.GetFaceDegree(fID);
         for(i = 0; i < n; ++ i)
         {
             VertexID vID = face[i];
@@ -1125,32 +1681,26 @@ void MeshModelBasicOp::SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, Ind
             for(j = 0; j < m; ++ j)
             {
                 FaceID faceID = adjFaces[j];
-                if(!FaceVisited[faceID])
-                {
-                    Stack.push(faceID);
-                    FaceVisited[faceID] = true;
-                }
+                if(context.MarkFace(faceID))
+                    Stack.push_back(faceID);
             }
         }
 
         FillFace.push_back(fID);
     }
 
-    // Gather filled faces
+    // Gather filled vertices
     n = FillFace.size();
     for(i = 0; i < n; ++ i)
     {
         FaceID fID = FillFace[i];
-        IndexArray& face = fIndex[fID];
-        size_t j, m = face.size();
+        const int* face = fInfo.GetFaceVertices(fID);
+        size_t j, m = fInfo.GetFaceDegree(fID);
         for(j = 0; j < m; ++ j)
         {
             VertexID vID = face[j];
-            if(!VtxVisited[vID])
-            {
+            if(context.MarkVertex(vID))
                 FillVtx.push_back(vID);
-                VtxVisited[vID] = true;
-            }
         }
     }
 }
@@ -1158,93 +1708,66 @@ void MeshModelBasicOp::SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, Ind
 // Get the neighbors of a given vertex inside a circle with a given radius
 // DO NOT clear out arrays
 void MeshModelBasicOp::GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexArray& NeiFace, double radius)
+{
+    MeshModelPooledQueryContext context(m_QueryContextPool);
+    GetNeighborhood(vID, NeiVtx, NeiFace, radius, context.Get());
+}
+
+void MeshModelBasicOp::GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexArray& NeiFace, double radius, MeshModelQueryContext& context)
 {
     assert(IsValidVertexIndex(vID));
     
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    size_t nVertex = vCoord.size();
+	const FaceInfo& fInfo = kernel->GetFaceInfo();
 
     // Multiply the distance factor
 	radius *= GetDistanceFactor();
 
     size_t i, j, n;
-    DoubleArray m_VtxDist;
-    IndexArray  m_VtxParent;
-    m_VtxDist.resize(nVertex);
-    m_VtxParent.resize(nVertex);
-    fill(m_VtxDist.begin(), m_VtxDist.end(), INFINITE_DISTANCE);
-    fill(m_VtxParent.begin(), m_VtxParent.end(), -1);
+    context.Begin(vCoord.size(), fInfo.GetFaceNum());
 
-    CHeap heap;
-
-	m_VtxDist[vID] = 0.0;
-	Node* pNode = new Node;
-	pNode->v = 0.0;
-	pNode->type = vID;
-	heap.insert(pNode);
+	context.SetDistance(vID, 0.0);
+	context.PushHeap(vID);
 
 	// Mark selected vertices
-    BoolArray VtxVisited;
-    VtxVisited.resize(nVertex);
-    fill(VtxVisited.begin(), VtxVisited.end(), false);
     n = NeiVtx.size();
     for(i = 0; i < n; ++ i)
-        VtxVisited[NeiVtx[i]] = true;
+        context.MarkVertex(NeiVtx[i]);
 
     // Mark selected faces
-    size_t nFace = fIndex.size();
-    BoolArray FaceVisited;
-    FaceVisited.resize(nFace);
-    fill(FaceVisited.begin(), FaceVisited.end(), false);
     n = NeiFace.size();
     for(i = 0; i < n; ++ i)
-        FaceVisited[NeiFace[i]] = true;
+        context.MarkFace(NeiFace[i]);
 
 	// Gather all neighboring vertices
-	while(!heap.heapEmpty())
+	while(!context.IsHeapEmpty())
 	{
-		Node* pNode = heap.Remove();
-		VertexID vID = pNode->type;
-		double v_dist = m_VtxDist[vID];
+		VertexID vID = context.PopHeap();
+		double v_dist = context.GetDistance(vID);
 		Coord v = vCoord[vID];
         IndexArray& adjVertices = vAdjVertices[vID];
         n = adjVertices.size();
         for(i = 0; i < n; ++ i)
 		{
 			VertexID vtxID = adjVertices[i];
-			double vtx_dist = m_VtxDist[vtxID];
+			double vtx_dist = context.GetDistance(vtxID);
 			Coord vtx = vCoord[vtxID];
 			double edge_length = (vtx-v).abs();
 			if(v_dist+edge_length < vtx_dist)		// Update
 			{
-				m_VtxDist[vtxID] = v_dist+edge_length;
-				int index = heap.heapFind(vtxID);
-				if(index)	// Already in heap
-				{
-					heap.a[index]->v = m_VtxDist[vtxID];
-                    m_VtxParent[vtxID] = vID;
-					heap.upheap(index);
-				}
-				else if(m_VtxDist[vtxID] < radius)
-				{
-					Node* pNewNode = new Node;
-					pNewNode->v = m_VtxDist[vtxID];
-					pNewNode->type = vtxID;
-					heap.insert(pNewNode);
-				}
+				context.SetDistance(vtxID, v_dist+edge_length);
+				if(context.IsInHeap(vtxID))	// Already in heap
+					context.UpdateHeap(vtxID);
+				else if(v_dist+edge_length < radius)
+					context.PushHeap(vtxID);
 			}
 		}
-		delete pNode;
 
         // Add to neighboring vertex array
-        if(!VtxVisited[vID])
-        {
+        if(context.MarkVertex(vID))
             NeiVtx.push_back(vID);
-            VtxVisited[vID] = true;
-        }
 
         // Add to neighboring face array
         IndexArray& adjFaces = vAdjFaces[vID];
@@ -1252,17 +1775,17 @@ void MeshModelBasicOp::GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexAr
         for(i = 0; i < n; ++ i)
         {
             FaceID fID = adjFaces[i];
-            if(FaceVisited[fID])
+            if(context.IsFaceMarked(fID))
                 continue;
-            IndexArray& face = fIndex[fID];
-            size_t m = face.size();
+            const int* face = fInfo.GetFaceVertices(fID);
+            size_t m = fInfo.GetFaceDegree(fID);
             for(j = 0; j < m; ++ j)
-                if(!VtxVisited[face[j]])
+                if(!context.IsVertexMarked(face[j]))
                     break;
             if(j == m)    // All vertices of the given face are visited
             {
                 NeiFace.push_back(fID);
-                FaceVisited[fID] = true;
+                context.MarkFace(fID);
             }
         }
 	}
@@ -1271,10 +1794,10 @@ void MeshModelBasicOp::GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexAr
 // Get the nearest vertex in a given face for a give position
 void MeshModelBasicOp::GetNearestVertex(FaceID fID, Coord pos, VertexID& vID)
 {
-    IndexArray& face = kernel->GetFaceInfo().GetIndex()[fID];
+    const int* face = kernel->GetFaceInfo().GetFaceVertices(fID);
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
 
-    size_t i, n = face.size();
+    size_t i, n = kernel->GetFaceInfo().GetFaceDegree(fID);
     DoubleArray Dist;
     Dist.resize(n);
     for(i = 0; i < n; ++ i)
@@ -1290,6 +1813,9 @@ void MeshModelBasicOp::GetNearestVertex(FaceID fID, Coord pos, VertexID& vID)
 }
 void MeshModelBasicOp::GetNearestVertex(Coord pos, VertexID& vID)
 {
+    if(spatialindex != NULL && spatialindex->GetNearestVertex(pos, vID))
+        return;
+
 	CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
 
     size_t i;
@@ -1310,14 +1836,26 @@ void MeshModelBasicOp::GetNearestVertex(Coord pos, VertexID& vID)
 
 // Get the neighbors of a given face
 void MeshModelBasicOp::GetFaceNeighborhood(FaceID fID, IndexArray& NeiFace)
+{
+    MeshModelPooledQueryContext context(m_QueryContextPool);
+    GetFaceNeighborhood(fID, NeiFace, context.Get());
+}
+
+void MeshModelBasicOp::GetFaceNeighborhood(FaceID fID, IndexArray& NeiFace, MeshModelQueryContext& context)
 {
     assert(IsValidFaceIndex(fID));
 
-    IndexArray& f = kernel->GetFaceInfo().GetIndex()[fID];
+    const int* f = kernel->GetFaceInfo().GetFaceVertices(fID);
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
     FlagArray& vFlag = kernel->GetVertexInfo().GetFlag();
 
-    size_t i, n = f.size();
+    // Faces already in the array are not added again
+    context.Begin(vAdjFaces.size(), kernel->GetFaceInfo().GetFaceNum());
+    size_t i, n = NeiFace.size();
+    for(i = 0; i < n; ++ i)
+        context.MarkFace(NeiFace[i]);
+
+    n = kernel->GetFaceInfo().GetFaceDegree(fID);
     for(i = 0; i < n; ++ i)
     {
         VertexID vID = f[i];
@@ -1329,13 +1867,13 @@ void MeshModelBasicOp::GetFaceNeighborhood(FaceID fID, IndexArray& NeiFace)
         if(!util.IsSetFlag(flag, VERTEX_FLAG_BOUNDARY))
         {
             FaceID faceID = adjFaces[(idx+1)%m];
-            if(find(NeiFace.begin(), NeiFace.end(), faceID) == NeiFace.end())
+            if(context.MarkFace(faceID))
                 NeiFace.push_back(faceID);
         }
         else if(idx != m-1)    // Not the last adjacent face
         {
             FaceID faceID =  adjFaces[(idx+1)%m];
-            if(find(NeiFace.begin(), NeiFace.end(), faceID) == NeiFace.end())
+            if(context.MarkFace(faceID))
                 NeiFace.push_back(faceID);
         }
     }
@@ -1429,8 +1967,8 @@ double MeshModelBasicOp::DistanceFromSeeds2(IndexArray& Seeds, DoubleArray& VtxD
 {
     DistanceFromSeeds(Seeds, VtxDist, distance);
 
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    size_t nFace = fIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t nFace = fInfo.GetFaceNum();
 
 	FaceDist.clear();
 	FaceDist.resize(nFace);
@@ -1441,10 +1979,10 @@ double MeshModelBasicOp::DistanceFromSeeds2(IndexArray& Seeds, DoubleArray& VtxD
     size_t i, j, n;
     for(i = 0; i < nFace; ++ i)
 	{
-		IndexArray& f = fIndex[i];
+		const int* f = fInfo.GetFaceVertices(i);
 		double dist = 0.0;
 		bool bValid = true;
-        n = f.size();
+        n = fInfo.GetFaceDegree(i);
 		for(j = 0; j < n; ++ j)
 		{
 			if(VtxDist[f[j]] == INFINITE_DISTANCE)
@@ -1472,8 +2010,8 @@ double MeshModelBasicOp::DistanceFromSeeds3(IndexArray& Seeds, DoubleArray& Face
     DoubleArray VtxDist;
     DistanceFromSeeds(Seeds, VtxDist, distance);
 
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    size_t nFace = fIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t nFace = fInfo.GetFaceNum();
 
 	FaceDist.clear();
 	FaceDist.resize(nFace);
@@ -1484,10 +2022,10 @@ double MeshModelBasicOp::DistanceFromSeeds3(IndexArray& Seeds, DoubleArray& Face
     size_t i, j, n;
     for(i = 0; i < nFace; ++ i)
 	{
-		IndexArray& f = fIndex[i];
+		const int* f = fInfo.GetFaceVertices(i);
 		double dist = 0.0;
 		bool bValid = true;
-        n = f.size();
+        n = fInfo.GetFaceDegree(i);
 		for(j = 0; j < n; ++ j)
 		{
 			if(VtxDist[f[j]] == INFINITE_DISTANCE)
@@ -1513,6 +2051,12 @@ double MeshModelBasicOp::DistanceFromSeeds3(IndexArray& Seeds, DoubleArray& Face
 // Compute the neighboring vertices of given seeds (not including seeds) within the given threshold
 // and their corresponding distance from seeds
 double MeshModelBasicOp::DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVtx, DoubleArray& NeiVtxDist, double distance /* = INFINITE_DISTANCE */)
+{
+    MeshModelPooledQueryContext context(m_QueryContextPool);
+    return DistanceFromSeeds4(Seeds, NeiVtx, NeiVtxDist, context.Get(), distance);
+}
+
+double MeshModelBasicOp::DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVtx, DoubleArray& NeiVtxDist, MeshModelQueryContext& context, double distance /* = INFINITE_DISTANCE */)
 {
 	size_t nVtx = Seeds.size();
 	if(!nVtx)
@@ -1524,44 +2068,29 @@ double MeshModelBasicOp::DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVt
 
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
-    size_t nVertex = vCoord.size();
 
     NeiVtx.clear();
     NeiVtxDist.clear();
 
-    DoubleArray VtxDist;
-	VtxDist.resize(nVertex);
-    fill(VtxDist.begin(), VtxDist.end(), INFINITE_DISTANCE);
-
-	CHeap heap;
+    context.Begin(vCoord.size(), kernel->GetFaceInfo().GetFaceNum());
     size_t i, n;
 
     for(i = 0; i < nVtx; ++ i)
 	{
 		VertexID vID = Seeds[i];
-		VtxDist[vID] = 0.0;
-		Node* pNode = new Node;
-		pNode->v = 0.0;
-		pNode->type = vID;
-		heap.insert(pNode);
+		if(context.IsInHeap(vID))
+			continue;
+		context.SetDistance(vID, 0.0);
+		context.PushHeap(vID);
 	}
-	
-	// Mark selected vertices
-    BoolArray VtxVisited;
-    VtxVisited.resize(nVertex);
-    fill(VtxVisited.begin(), VtxVisited.end(), false);
-    n = Seeds.size();
-    for(i = 0; i < n; ++ i)
-        VtxVisited[Seeds[i]] = true;
 
     double VtxMaxDist = 0.0;
     // Gather all neighborhood vertices
     Coord v, vtx;
-	while(!heap.heapEmpty())
+	while(!context.IsHeapEmpty())
 	{
-		Node* pNode = heap.Remove();
-		VertexID vID = pNode->type;
-		double v_dist = VtxDist[vID];
+		VertexID vID = context.PopHeap();
+		double v_dist = context.GetDistance(vID);
 		v = vCoord[vID];
         
         IndexArray& adjVertices = vAdjVertices[vID];
@@ -1569,39 +2098,31 @@ double MeshModelBasicOp::DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVt
         for(i = 0; i < n; ++ i)
 		{
 			VertexID vtxID = adjVertices[i];
-			double vtx_dist = VtxDist[vtxID];
+			double vtx_dist = context.GetDistance(vtxID);
 			vtx = vCoord[vtxID];
 			double edge_length = (vtx-v).abs();
 			if(v_dist+edge_length < vtx_dist)		// Update
 			{
-				VtxDist[vtxID] = v_dist+edge_length;
-				int index = heap.heapFind(vtxID);
-				if(index)	// Already in heap
-				{
-					heap.a[index]->v = VtxDist[vtxID];
-					heap.upheap(index);
-				}
-				else if(VtxDist[vtxID] < distance)
+				context.SetDistance(vtxID, v_dist+edge_length);
+				if(context.IsInHeap(vtxID))	// Already in heap
+					context.UpdateHeap(vtxID);
+				else if(v_dist+edge_length < distance)
 				{
-					Node* pNewNode = new Node;
-					pNewNode->v = VtxDist[vtxID];
-					pNewNode->type = vtxID;
-					heap.insert(pNewNode);
+					context.PushHeap(vtxID);
 
                     // Add to neighborhood
                     NeiVtx.push_back(vtxID);
 				}
 			}
 		}
-		VtxMaxDist = VtxDist[vID];
-		delete pNode;
+		VtxMaxDist = v_dist;
 	}
 
     // Output
     n = NeiVtx.size();
     NeiVtxDist.resize(n);
     for(i = 0; i < n; ++ i)
-        NeiVtxDist[i] = VtxDist[NeiVtx[i]];
+        NeiVtxDist[i] = context.GetDistance(NeiVtx[i]);
 
     return VtxMaxDist;
 }
@@ -1670,8 +2191,8 @@ void MeshModelBasicOp::CalMeanCurvature(CoordArray& VtxMeanCurv)
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
     PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
     PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    size_t nFace = fIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t nFace = fInfo.GetFaceNum();
     size_t nVertex = vCoord.size();
     
     // Calculate the three inner angles of each face
@@ -1682,8 +2203,8 @@ void MeshModelBasicOp::CalMeanCurvature(CoordArray& VtxMeanCurv)
 	size_t k, l;
     for(i = 0; i < n; ++ i)
     {
-        IndexArray& f = fIndex[i];
-        size_t j, m = f.size();
+        const int* f = fInfo.GetFaceVertices(i);
+        size_t j, m = fInfo.GetFaceDegree(i);
         size_t idx = i*3;
         for(j = 0; j < 3; ++ j)
         {
@@ -1738,7 +2259,7 @@ void MeshModelBasicOp::CalMeanCurvature(CoordArray& VtxMeanCurv)
                     break;
             }
 
-            IndexArray& f = fIndex[fID];
+            const int* f = fInfo.GetFaceVertices(fID);
             for(l = 0; l < 3; ++ l)
             {
                 if(f[l] == i)
@@ -1810,19 +2331,19 @@ bool MeshModelBasicOp::GetBdyIndex(VertexID vID, BdyID& bdyID, Index& idx)
 void MeshModelBasicOp::GetAdjacentFace(VertexID vID1, VertexID vID2, FaceID& fID1, FaceID& fID2)
 {
     IndexArray& adjFaces = kernel->GetVertexInfo().GetAdjFaces()[vID1];
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
     
     fID1 = fID2 = -1;
     size_t i, n = adjFaces.size();
     for(i = 0; i < n; ++ i)
     {
         FaceID fID = adjFaces[i];
-        IndexArray& f = fIndex[fID];
-        IndexArray::iterator iter = find(f.begin(), f.end(), vID1);
-        if(iter == f.end())
+        const int* f = fInfo.GetFaceVertices(fID);
+        size_t m = fInfo.GetFaceDegree(fID);
+        const int* iter = find(f, f+m, vID1);
+        if(iter == f+m)
             continue;
-        size_t idx = distance(f.begin(), iter);
-        size_t m = f.size();
+        size_t idx = iter - f;
         if(f[(idx+1)%m] == vID2)
             fID1 = fID;
         else if(f[(idx+m-1)%m] == vID2)
@@ -1847,12 +2368,12 @@ void MeshModelBasicOp::GetAdjacentFace(VertexID vID1, VertexID vID2, vector<Face
 }
 void MeshModelBasicOp::GetAdjacentFace(FaceID fID, vector<FaceID>& face_vec)
 {
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-	IndexArray& face = fIndex[fID];
+	const FaceInfo& fInfo = kernel->GetFaceInfo();
+	const int* face = fInfo.GetFaceVertices(fID);
 
 	//
 	face_vec.clear();
-	for (size_t i = 0; i < face.size(); i++)
+	for (size_t i = 0; i < fInfo.GetFaceDegree(fID); i++)
 	{
 		int oppfid;
 		GetEdgeOppositeFace(face[i], face[(i+1)%3], fID, oppfid);
@@ -1870,6 +2391,26 @@ void MeshModelBasicOp::GetEdgeOppositeFace(VertexID vID1, VertexID vID2, FaceID&
 	oppfID = fid1 == fID ? fid2 : fid1;
 }
 
+// Get the edge (vID1, vID2) in the edge table, -1 when there is none
+int MeshModelBasicOp::GetEdgeIndex(VertexID vID1, VertexID vID2)
+{
+    EdgeInfo& eInfo = kernel->GetEdgeInfo();
+    IndexArray& vEdgeOffset = eInfo.GetVertexEdgeOffset();
+    if(vID1 < 0 || vID1+1 >= (int) vEdgeOffset.size())
+        return -1;
+
+    IndexArray& vEdge = eInfo.GetVertexEdge();
+    IndexArray& eVtx = eInfo.GetVertexIndex();
+    int lo = min(vID1, vID2), hi = max(vID1, vID2);
+    for(int i = vEdgeOffset[vID1]; i < vEdgeOffset[vID1+1]; ++ i)
+    {
+        int eID = vEdge[i];
+        if(eVtx[2*eID] == lo && eVtx[2*eID+1] == hi)
+            return eID;
+    }
+    return -1;
+}
+
 // Get the adjacent vertices of the edge (vID1, vID2)
 void MeshModelBasicOp::GetAdjacentVertex(VertexID vID1, VertexID vID2, vector<VertexID>& oppVID)
 {
@@ -1884,18 +2425,18 @@ void MeshModelBasicOp::GetAdjacentVertex(VertexID vID1, VertexID vID2, vector<Ve
     else
     { 
         IndexArray& adjFaces = kernel->GetVertexInfo().GetAdjFaces()[vID1];
-        PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+        const FaceInfo& fInfo = kernel->GetFaceInfo();
         
         size_t i, n = adjFaces.size();
         for(i = 0; i < n; ++ i)
         {
             FaceID fID = adjFaces[i];
-            IndexArray& f = fIndex[fID];
-            IndexArray::iterator iter = find(f.begin(), f.end(), vID1);
-            if(iter == f.end())
+            const int* f = fInfo.GetFaceVertices(fID);
+            size_t m = fInfo.GetFaceDegree(fID);
+            const int* iter = find(f, f+m, vID1);
+            if(iter == f+m)
                 continue;
-            size_t idx = distance(f.begin(), iter);
-            size_t m = f.size();
+            size_t idx = iter - f;
             if(f[(idx+1)%m] == vID2)
                 oppVID.push_back(f[(idx+m-1)%m]);
             else if(f[(idx+m-1)%m] == vID2)
@@ -1907,11 +2448,11 @@ void MeshModelBasicOp::GetAdjacentVertex(VertexID vID1, VertexID vID2, vector<Ve
 void MeshModelBasicOp::CalBaryCentricCoord(FaceID fID, Coord& pos, Coord& bCenter)
 {
 	int i;
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+	const FaceInfo& fInfo = kernel->GetFaceInfo();
 	CoordArray& vCoord =  kernel->GetVertexInfo().GetCoord();
     
 	Coord v[3], fNormal;
-	IndexArray& face = fIndex[fID];
+	const int* face = fInfo.GetFaceVertices(fID);
 	
 	for(i = 0; i < 3; i ++)
 	{
@@ -1932,13 +2473,49 @@ void MeshModelBasicOp::CalTrglGradient(vector<Coord>& trgP, vector<Coord>& trgG)
 {
 
 }
-void MeshModelBasicOp::CalVertexCurvature()
+// Principal curvatures by the face based tensor estimate of Rusinkiewicz: the second
+// fundamental form of each triangle is fitted to the change of the vertex normals along
+// its edges, then the forms of the adjacent faces are averaged in each vertex frame.
+// Needs the vertex and face normals and the face areas
+void MeshModelBasicOp::CalVertexCurvature(int nSmoothRing)
 {
-	/*
-	CMeshModelCurvature meshCurv;
-	meshCurv.AttachMeshModelKernel(kernel);
-	meshCurv.EstimatorVertexCurvatures();
-	*/
+    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
+    PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
+    PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
+    DoubleArray& fArea = kernel->GetFaceInfo().GetFaceArea();
+
+    int nVertex = (int) vCoord.size();
+    int nFace = (int) fInfo.GetFaceNum();
+
+    // Face tensors, then the vertex tensors in the frames (vU, n x vU)
+    CoordArray fU(nFace), vU(nVertex);
+    DoubleArray fK(3*nFace), vK(3*nVertex), vArea(nVertex);
+    parallel_for(0, nFace, FaceCurvaturePass(vCoord, vNormal, kernel->GetFaceInfo(), fNormal, fU, fK));
+    parallel_for(0, nVertex, VertexCurvaturePass(vCoord, vNormal, vAdjVertices, vAdjFaces, fNormal, fArea, fU, fK, vU, vK, vArea));
+    Utility util;
+    util.FreeVector(fU);
+    util.FreeVector(fK);
+
+    if(nSmoothRing > 0)
+    {
+        DoubleArray smoothK(3*nVertex);
+        for(int ring = 0; ring < nSmoothRing; ++ ring)
+        {
+            parallel_for(0, nVertex, CurvatureSmoothPass(vNormal, vAdjVertices, vU, vArea, vK, smoothK));
+            vK.swap(smoothK);
+        }
+    }
+
+    CurvatureArray& vCurvature = kernel->GetVertexInfo().GetCurvatures();
+    DoubleArray& vMean = kernel->GetVertexInfo().GetMeanCurvature();
+    DoubleArray& vGauss = kernel->GetVertexInfo().GetGaussCurvature();
+    vCurvature.resize(nVertex);
+    vMean.resize(nVertex);
+    vGauss.resize(nVertex);
+    parallel_for(0, nVertex, PrincipalCurvaturePass(vNormal, vU, vK, vCurvature, vMean, vGauss));
 }
 double MeshModelBasicOp::GetBaryAdjFaceArea(VertexID vID)
 {
@@ -1974,46 +2551,44 @@ double MeshModelBasicOp::GetEdgeAdjFaceArea(VertexID vID_1, VertexID vID_2)
 	return area / num;
 }
 void MeshModelBasicOp::GetNeighborhoodVertex(int vID, size_t neighRingSize, bool onlyRing, vector<int>& neighVIDs)
+{
+	MeshModelPooledQueryContext context(m_QueryContextPool);
+	GetNeighborhoodVertex(vID, neighRingSize, onlyRing, neighVIDs, context.Get());
+}
+
+void MeshModelBasicOp::GetNeighborhoodVertex(int vID, size_t neighRingSize, bool onlyRing, vector<int>& neighVIDs, MeshModelQueryContext& context)
 {
 	PolyIndexArray& vAdjIndexArray = kernel->GetVertexInfo().GetAdjVertices();
-	m_VertexFlag.clear(); m_VertexFlag.resize(vAdjIndexArray.size(), false);
-	m_VertexFlag[vID] = true;
+	context.Begin(vAdjIndexArray.size(), kernel->GetFaceInfo().GetFaceNum());
+	context.MarkVertex(vID);
 
-	vector<int> vidArray, tmpArray;
-	vidArray.push_back(vID);
+	// The rings are appended to the output, ring_begin is the first vertex of the last ring
+	neighVIDs.clear();
+	neighVIDs.push_back(vID);
+	size_t ring_begin = 0;
 
 	for (size_t i = 0; i < neighRingSize; i++)
 	{
-		for (size_t j = 0; j < vidArray.size(); j++)
+		size_t ring_end = neighVIDs.size();
+		for (size_t j = ring_begin; j < ring_end; j++)
 		{
-			int vid = vidArray[j];
-			IntArray& adjVIndex = vAdjIndexArray[vid];
+			IntArray& adjVIndex = vAdjIndexArray[neighVIDs[j]];
 
 			for (size_t k = 0; k < adjVIndex.size(); k++)
 			{
 				int vvvid = adjVIndex[k];
 
-				if (!m_VertexFlag[vvvid])
-				{
-					tmpArray.push_back(vvvid);
-					m_VertexFlag[vvvid] = true;
-				}
+				if (context.MarkVertex(vvvid))
+					neighVIDs.push_back(vvvid);
 			}
 		}
-
-		if (onlyRing)
-		{
-			vidArray.assign(tmpArray.begin(), tmpArray.end());
-		}
-		else
-		{
-			vidArray.insert(vidArray.end(), tmpArray.begin(), tmpArray.end());
-		}
-
-		tmpArray.clear();
+		ring_begin = ring_end;
 	}
 
-	neighVIDs.assign(vidArray.begin(), vidArray.end());
+	if (onlyRing)
+	{
+		neighVIDs.erase(neighVIDs.begin(), neighVIDs.begin() + ring_begin);
+	}
 }
 void MeshModelBasicOp::AddNoise2Model(double amp_)
 {
@@ -35,6 +35,8 @@
 
 #include "MeshModelKernel.h"
 #include "MeshModelAuxData.h"
+#include "MeshModelSpatialIndex.h"
+#include "MeshModelQueryContext.h"
 #include "../Common/Utility.h"
 #pragma once
 
@@ -50,8 +52,9 @@ class MeshModelBasicOp
 private:
     MeshModelKernel* kernel;
     MeshModelAuxData* auxdata;
+    MeshModelSpatialIndex* spatialindex;
     Utility util;
-	vector<bool> m_VertexFlag;
+    MeshModelQueryContextPool m_QueryContextPool;  // Contexts of the queries called without one
 
 public:
     // Constructor
@@ -64,12 +67,13 @@ public:
     void ClearData();
     void AttachKernel(MeshModelKernel* pKernel);
     void AttachAuxData(MeshModelAuxData* pAuxData);
+    void AttachSpatialIndex(MeshModelSpatialIndex* pSpatialIndex);
 
     // Vertex information calculation
     void CalAdjacentInfo(); // Calculate the adjacent information for each vertex
     void CalVertexNormal(); // Calculate normal vector of all vertices
     void CalVertexNormal(IntArray& arrIndex);   // Calculate normal vector of selected vertices
-	void CalVertexCurvature();   // Calculate vertices Curvature
+	void CalVertexCurvature(int nSmoothRing = 0);   // Calculate principal, mean and Gaussian curvatures, smoothed over nSmoothRing rings
 
     // Face information calculation
     void CalFaceNormal();   // Calculate normal vector of all faces
@@ -80,9 +84,9 @@ public:
     // Edge information calculation, optional functions
     void CreateHalfEdge();  // Create halfedge, optional function
     void CalHalfEdgeInfo(); // Calculate the halfedge information, optional function
-	void CalDihedralAngle(); // Calculate the dihedral angle information, optional function
-	void CalFaceEdgeInfo(); // Calculate the face index information, optional function
-    void CalVertexEdgeInfo(); // Calculate the edge information, optional function
+    void CalEdgeInfo();     // Calculate the edge table, the face-edge and the vertex-edge indices, optional function
+	void CalDihedralAngle(); // Calculate the dihedral angle information, needs the edge table and the face normals
+    void CalEdgeLength();   // Calculate the edge lengths, needs the edge table
     
 	// Model information calculation
     void CalBoundingBox();      // Bounding box calculation
@@ -91,6 +95,7 @@ public:
 
     // Manifold functions
     void SortAdjacentInfo();    // Make sure the 1-ring neighbors are CCW order
+    void SortAdjacentInfo(VertexID vID);    // Sort the 1-ring neighbors of a manifold vertex
     void CalBoundaryInfo();     // Boundary calculation
 
     // Model analysis functions
@@ -114,16 +119,26 @@ public:
     double DistanceFromSeeds2(IndexArray& Seeds, DoubleArray& VtxDist, DoubleArray& FaceDist, double distance = INFINITE_DISTANCE);
     double DistanceFromSeeds3(IndexArray& Seeds, DoubleArray& FaceDist, double distance = INFINITE_DISTANCE);
     double DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVtx, DoubleArray& NeiVtxDist, double distance = INFINITE_DISTANCE);
+    double DistanceFromSeeds4(IndexArray& Seeds, IndexArray& NeiVtx, DoubleArray& NeiVtxDist, MeshModelQueryContext& context, double distance = INFINITE_DISTANCE);
+
+    // Local queries
+    // The versions taking a MeshModelQueryContext cost time in the size of the region they
+    // visit and only read the kernel, so they can run concurrently with one context per thread.
+    // The other versions borrow a context from a pool of this object, they may run concurrently too
 
     // Flood fill from a seed to marked boundary
     void SurfaceFloodFillVertex(VertexID vID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedVtx);
+    void SurfaceFloodFillVertex(VertexID vID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedVtx, MeshModelQueryContext& context);
     void SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedFace);
+    void SurfaceFloodFillFace(FaceID fID, IndexArray& FillVtx, IndexArray& FillFace, IndexArray& SelectedFace, MeshModelQueryContext& context);
 
     // Get the neighbors of a given face
     void GetFaceNeighborhood(FaceID fID, IndexArray& NeiFace);
+    void GetFaceNeighborhood(FaceID fID, IndexArray& NeiFace, MeshModelQueryContext& context);
 
     // Get the neighbors of a given vertex inside a circle with a given radius
     void GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexArray& NeiFace, double radius);
+    void GetNeighborhood(VertexID vID, IndexArray& NeiVtx, IndexArray& NeiFace, double radius, MeshModelQueryContext& context);
 
     // Get the nearest vertex in a given face for a give position
     void GetNearestVertex(FaceID fID, Coord pos, VertexID& vID);
@@ -153,6 +168,9 @@ public:
 	void GetAdjacentFace(FaceID fID, vector<FaceID>& face_vec);
 	void GetEdgeOppositeFace(VertexID vID1, VertexID vID2, FaceID& fID, FaceID& oppfID);
 
+    // Get the edge (vID1, vID2) in the edge table, -1 when there is none
+    int GetEdgeIndex(VertexID vID1, VertexID vID2);
+
     // Get the adjacent vertices of the edge (vID1, vID2)
     void GetAdjacentVertex(VertexID vID1, VertexID vID2, vector<VertexID>& oppVID);
 
@@ -163,6 +181,7 @@ public:
 
 	// Get the neighbors of a given vertex inside a circle with a given radius
 	void GetNeighborhoodVertex(int vID, size_t neighRingSize, bool onlyRing, vector<int>& neighVIDs);
+	void GetNeighborhoodVertex(int vID, size_t neighRingSize, bool onlyRing, vector<int>& neighVIDs, MeshModelQueryContext& context);
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -179,7 +198,7 @@ bool MeshModelBasicOp::IsValidVertexIndex(VertexID vID)
 
 inline bool MeshModelBasicOp::IsValidFaceIndex(FaceID fID)
 {
-    if(fID < 0  || fID >= (int) kernel->GetFaceInfo().GetIndex().size())
+    if(fID < 0  || fID >= kernel->GetFaceInfo().GetFaceNum())
         return false;
     
     return (!util.IsSetFlag(kernel->GetFaceInfo().GetFlag()[fID], FLAG_INVALID));
@@ -0,0 +1,467 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelGeodesic.cpp
+//
+// [Goal]
+// Geodesic distances of a triangle mesh model by the heat method
+
+
+
+#include "MeshModelGeodesic.h"
+#include "../Numerical/sparse_cholesky.h"
+#include "../Common/Parallel.h"
+#include <cassert>
+
+
+
+// The heat has to stay above the double range over the whole model, so the
+// time step is at least (bounding box diagonal / GEODESIC_MAX_DECAY)^2
+#define GEODESIC_MAX_DECAY      500.0
+
+// Weight of the mass that makes the Laplacian definite, relative to the mean diagonal
+#define GEODESIC_REGULARIZATION 1.0e-12
+
+
+
+// Per-face and per-vertex bodies run by parallel_for, each only writes its own entries
+namespace
+{
+    class VertexAreaPass
+    {
+    public:
+        const PolyIndexArray& vAdjFaces;
+        const DoubleArray& FaceArea;
+        DoubleArray& VtxArea;
+
+        VertexAreaPass(const PolyIndexArray& af, const DoubleArray& fa, DoubleArray& va)
+            : vAdjFaces(af), FaceArea(fa), VtxArea(va) {}
+
+        void operator()(int i) const
+        {
+            const IndexArray& adjFaces = vAdjFaces[i];
+            double area = 0.0;
+            for(size_t j = 0; j < adjFaces.size(); ++ j)
+                area += FaceArea[adjFaces[j]];
+            VtxArea[i] = area/3.0;
+        }
+    };
+
+    // Unit field against the heat gradient on each face, zero where the heat is flat
+    class HeatGradientPass
+    {
+    public:
+        const CoordArray& vCoord;
+        const FaceInfo& fInfo;
+        const double* Heat;
+        std::vector<Coord>& FaceField;
+
+        HeatGradientPass(const CoordArray& v, const FaceInfo& f, const double* u, std::vector<Coord>& x)
+            : vCoord(v), fInfo(f), Heat(u), FaceField(x) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            Coord normal = cross(vCoord[f[1]] - vCoord[f[0]], vCoord[f[2]] - vCoord[f[0]]);
+
+            // The gradient up to the positive factor 1/(2*area*|normal|)
+            Coord grad(0, 0, 0);
+            for(int j = 0; j < 3; ++ j)
+                grad += cross(normal, vCoord[f[(j+2)%3]] - vCoord[f[(j+1)%3]]) * Heat[f[j]];
+
+            double len = grad.abs();
+            if(len > 0.0)
+                FaceField[i] = grad * (-1.0/len);   // Coord::operator/ rejects tiny divisors
+            else
+                FaceField[i] = Coord(0, 0, 0);
+        }
+    };
+
+    // Integrated divergence of the face field at each vertex, negated for the
+    // positive semi-definite Laplacian
+    class DivergencePass
+    {
+    public:
+        const CoordArray& vCoord;
+        const FaceInfo& fInfo;
+        const PolyIndexArray& vAdjFaces;
+        const std::vector<Coord>& CotCoef;
+        const std::vector<Coord>& FaceField;
+        double* Div;
+
+        DivergencePass(const CoordArray& v, const FaceInfo& f, const PolyIndexArray& af,
+                       const std::vector<Coord>& c, const std::vector<Coord>& x, double* d)
+            : vCoord(v), fInfo(f), vAdjFaces(af), CotCoef(c), FaceField(x), Div(d) {}
+
+        void operator()(int i) const
+        {
+            const IndexArray& adjFaces = vAdjFaces[i];
+            double div = 0.0;
+            for(size_t k = 0; k < adjFaces.size(); ++ k)
+            {
+                FaceID fID = adjFaces[k];
+                const int* f = fInfo.GetFaceVertices(fID);
+                int j = 0;
+                while(j < 3 && f[j] != i)
+                    ++ j;
+                assert(j != 3);
+
+                const Coord& x = FaceField[fID];
+                Coord e1 = vCoord[f[(j+1)%3]] - vCoord[i];
+                Coord e2 = vCoord[f[(j+2)%3]] - vCoord[i];
+                div += 0.5*(CotCoef[fID][(j+2)%3]*dot(e1, x) + CotCoef[fID][(j+1)%3]*dot(e2, x));
+            }
+            Div[i] = -div;
+        }
+    };
+}
+
+
+
+// Constructor
+MeshModelGeodesic::MeshModelGeodesic()
+{
+    kernel = NULL;
+    basicop = NULL;
+    cache = NULL;
+    m_HeatSolver = NULL;
+    m_PoissonSolver = NULL;
+    m_TimeFactor = 1.0;
+    ClearData();
+}
+
+// Destructor
+MeshModelGeodesic::~MeshModelGeodesic()
+{
+    Invalidate();
+}
+
+// Initializer
+void MeshModelGeodesic::ClearData()
+{
+    Invalidate();
+}
+
+void MeshModelGeodesic::AttachKernel(MeshModelKernel* pKernel)
+{
+    assert(pKernel != NULL);
+    kernel = pKernel;
+}
+
+void MeshModelGeodesic::AttachBasicOp(MeshModelBasicOp* pBasicOp)
+{
+    assert(pBasicOp != NULL);
+    basicop = pBasicOp;
+}
+
+void MeshModelGeodesic::AttachOperatorCache(MeshModelOperatorCache* pCache)
+{
+    assert(pCache != NULL);
+    cache = pCache;
+}
+
+void MeshModelGeodesic::Invalidate()
+{
+    m_bValid = false;
+    m_ModifyCount = 0;
+
+    delete m_HeatSolver;
+    delete m_PoissonSolver;
+    m_HeatSolver = NULL;
+    m_PoissonSolver = NULL;
+
+    m_VtxArea.clear();
+    m_VtxComponent.clear();
+    m_nComponent = 0;
+}
+
+void MeshModelGeodesic::SetTimeFactor(double factor)
+{
+    assert(factor > 0.0);
+    if(factor != m_TimeFactor)
+    {
+        m_TimeFactor = factor;
+        Invalidate();
+    }
+}
+
+bool MeshModelGeodesic::ComputeDistance(const IndexArray& Sources, DoubleArray& VtxDist)
+{
+    std::vector<IndexArray> SourceSets(1, Sources);
+    std::vector<DoubleArray> Dist;
+    if(!ComputeDistance(SourceSets, Dist))
+        return false;
+    VtxDist.swap(Dist[0]);
+    return true;
+}
+
+bool MeshModelGeodesic::ComputeDistance(const std::vector<IndexArray>& SourceSets, std::vector<DoubleArray>& VtxDist)
+{
+    VtxDist.clear();
+    if(!Prepare())
+        return false;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    const std::vector<Coord>& cot_coef = cache->GetCotCoef();
+
+    int nVertex = (int) vCoord.size();
+    int nFace = (int) fInfo.GetFaceNum();
+    int nSet = (int) SourceSets.size();
+    if(nSet == 0)
+        return true;
+
+    // Heat flowed from the sources, one column per source set
+    DoubleArray b((size_t) nVertex*nSet, 0.0), x((size_t) nVertex*nSet);
+    for(int k = 0; k < nSet; ++ k)
+    {
+        const IndexArray& Sources = SourceSets[k];
+        for(size_t i = 0; i < Sources.size(); ++ i)
+        {
+            assert(Sources[i] >= 0 && Sources[i] < nVertex);
+            b[(size_t) k*nVertex + Sources[i]] = 1.0;
+        }
+    }
+    if(!m_HeatSolver->solve(&b[0], &x[0], nSet))
+        return false;
+
+    // Divergence of the normalized gradient field
+    std::vector<Coord> FaceField(nFace);
+    for(int k = 0; k < nSet; ++ k)
+    {
+        parallel_for(0, nFace, HeatGradientPass(vCoord, fInfo, &x[(size_t) k*nVertex], FaceField));
+        parallel_for(0, nVertex, DivergencePass(vCoord, fInfo, vAdjFaces, cot_coef, FaceField, &b[(size_t) k*nVertex]));
+    }
+
+    // The potential whose gradient fits the field, shifted to zero at the nearest source
+    if(!m_PoissonSolver->solve(&b[0], &x[0], nSet))
+        return false;
+
+    VtxDist.resize(nSet);
+    DoubleArray Shift;
+    for(int k = 0; k < nSet; ++ k)
+    {
+        const IndexArray& Sources = SourceSets[k];
+        const double* phi = &x[(size_t) k*nVertex];
+
+        Shift.assign(m_nComponent, INFINITE_DISTANCE);
+        for(size_t i = 0; i < Sources.size(); ++ i)
+        {
+            int c = m_VtxComponent[Sources[i]];
+            Shift[c] = min(Shift[c], phi[Sources[i]]);
+        }
+
+        DoubleArray& Dist = VtxDist[k];
+        Dist.resize(nVertex);
+        for(int i = 0; i < nVertex; ++ i)
+        {
+            double shift = Shift[m_VtxComponent[i]];
+            Dist[i] = (shift == INFINITE_DISTANCE) ? INFINITE_DISTANCE : max(phi[i]-shift, 0.0);
+        }
+        for(size_t i = 0; i < Sources.size(); ++ i)
+            Dist[Sources[i]] = 0.0;
+    }
+
+    return true;
+}
+
+void MeshModelGeodesic::GetShortestPath(VertexID vStart, VertexID vEnd, IndexArray& Path)
+{
+    Path.clear();
+    if(vStart == vEnd)
+    {
+        Path.push_back(vStart);
+        return;
+    }
+
+    IndexArray Sources(1, vEnd);
+    DoubleArray Dist;
+    if(ComputeDistance(Sources, Dist) && Dist[vStart] < INFINITE_DISTANCE)
+    {
+        const PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
+        VertexID vID = vStart;
+        Path.push_back(vID);
+        while(vID != vEnd)
+        {
+            const IndexArray& adjVertices = vAdjVertices[vID];
+            VertexID next = -1;
+            for(size_t j = 0; j < adjVertices.size(); ++ j)
+            {
+                if(Dist[adjVertices[j]] < (next == -1 ? Dist[vID] : Dist[next]))
+                    next = adjVertices[j];
+            }
+            if(next == -1)
+                break;
+            vID = next;
+            Path.push_back(vID);
+        }
+        if(vID == vEnd)
+            return;
+    }
+
+    basicop->GetShortestPath(vStart, vEnd, Path);
+}
+
+// Build and factorize M + tL and L on the first query after a change of the model
+bool MeshModelGeodesic::Prepare()
+{
+    if(m_bValid && m_ModifyCount == kernel->GetModifyCount())
+        return m_HeatSolver != NULL && m_PoissonSolver != NULL;
+
+    Invalidate();
+    m_bValid = true;
+    m_ModifyCount = kernel->GetModifyCount();
+
+    CalVertexArea();
+    CalComponent();
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    EdgeInfo& eInfo = kernel->GetEdgeInfo();
+    const IndexArray& eVtxIndex = eInfo.GetVertexIndex();
+    const IndexArray& eFaceEdgeOffset = eInfo.GetFaceEdgeOffset();
+    const IndexArray& eFaceEdge = eInfo.GetFaceEdge();
+    const IndexArray& eVtxEdgeOffset = eInfo.GetVertexEdgeOffset();
+    const IndexArray& eVtxEdge = eInfo.GetVertexEdge();
+    const std::vector<Coord>& cot_coef = cache->GetCotCoef();
+
+    int nVertex = (int) vCoord.size();
+    int nFace = (int) fInfo.GetFaceNum();
+    int nEdge = (int) eInfo.GetEdgeNum();
+    if(nVertex == 0 || (int) eVtxEdgeOffset.size() != nVertex+1)
+        return false;
+
+    // Cotangent weight of each edge
+    DoubleArray EdgeWeight(nEdge, 0.0);
+    double h = 0.0;
+    for(int i = 0; i < nFace; ++ i)
+    {
+        for(int j = 0; j < 3; ++ j)
+            EdgeWeight[eFaceEdge[eFaceEdgeOffset[i]+j]] += 0.5*cot_coef[i][(j+2)%3];
+    }
+    for(int e = 0; e < nEdge; ++ e)
+        h += (vCoord[eVtxIndex[2*e]] - vCoord[eVtxIndex[2*e+1]]).abs();
+    h = (nEdge > 0) ? h/nEdge : 1.0;
+
+    Coord BoxMin = vCoord[0], BoxMax = vCoord[0];
+    for(int i = 1; i < nVertex; ++ i)
+    {
+        for(int k = 0; k < 3; ++ k)
+        {
+            BoxMin[k] = min(BoxMin[k], vCoord[i][k]);
+            BoxMax[k] = max(BoxMax[k], vCoord[i][k]);
+        }
+    }
+    double diag = (BoxMax - BoxMin).abs() / GEODESIC_MAX_DECAY;
+    double t = m_TimeFactor * max(h*h, diag*diag);
+
+    // Both matrices on the pattern of the vertex graph, the diagonal first in each column
+    hj::sparse::spm_csc<double> A(nVertex, nVertex, nVertex + 2*nEdge);
+    DoubleArray LapVal(nVertex + 2*nEdge);
+    int k = 0;
+    double LapDiagSum = 0.0, AreaSum = 0.0;
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        int diag_k = k;
+        A.idx_[k] = i;
+        LapVal[k ++] = 0.0;
+        for(int j = eVtxEdgeOffset[i]; j < eVtxEdgeOffset[i+1]; ++ j)
+        {
+            int e = eVtxEdge[j];
+            A.idx_[k] = (eVtxIndex[2*e] == i) ? eVtxIndex[2*e+1] : eVtxIndex[2*e];
+            LapVal[k ++] = -EdgeWeight[e];
+            LapVal[diag_k] += EdgeWeight[e];
+        }
+        A.ptr_[i+1] = k;
+        LapDiagSum += LapVal[diag_k];
+        AreaSum += m_VtxArea[i];
+    }
+    double eps = (AreaSum > 0.0) ? GEODESIC_REGULARIZATION * LapDiagSum / AreaSum : GEODESIC_REGULARIZATION;
+
+    // Isolated vertices get an identity row, they are components of their own
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        int diag_k = (int) A.ptr_[i];
+        bool isolated = (m_VtxArea[i] == 0.0 && A.ptr_[i+1] == diag_k+1);
+        for(k = diag_k; k < A.ptr_[i+1]; ++ k)
+            A.val_[k] = t*LapVal[k];
+        A.val_[diag_k] += isolated ? 1.0 : m_VtxArea[i];
+    }
+    m_HeatSolver = SparseDirectSolver::create(A);
+
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        int diag_k = (int) A.ptr_[i];
+        bool isolated = (m_VtxArea[i] == 0.0 && A.ptr_[i+1] == diag_k+1);
+        for(k = diag_k; k < A.ptr_[i+1]; ++ k)
+            A.val_[k] = LapVal[k];
+        A.val_[diag_k] += isolated ? 1.0 : eps*m_VtxArea[i];
+    }
+    m_PoissonSolver = SparseDirectSolver::create(A);
+
+    if(m_HeatSolver == NULL || m_PoissonSolver == NULL)
+    {
+        printf("Geodesic: factorization failed.\n");
+        return false;
+    }
+    return true;
+}
+
+void MeshModelGeodesic::CalVertexArea()
+{
+    const PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+    const DoubleArray& face_area = cache->GetFaceArea();
+
+    int nVertex = (int) vAdjFaces.size();
+    m_VtxArea.resize(nVertex);
+
+    parallel_for(0, nVertex, VertexAreaPass(vAdjFaces, face_area, m_VtxArea));
+}
+
+// Connected components by breadth first search over the vertex adjacency
+void MeshModelGeodesic::CalComponent()
+{
+    const PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
+
+    int nVertex = (int) vAdjVertices.size();
+    m_VtxComponent.assign(nVertex, -1);
+    m_nComponent = 0;
+
+    IndexArray Queue;
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        if(m_VtxComponent[i] != -1)
+            continue;
+        Queue.clear();
+        Queue.push_back(i);
+        m_VtxComponent[i] = m_nComponent;
+        for(size_t head = 0; head < Queue.size(); ++ head)
+        {
+            const IndexArray& adjVertices = vAdjVertices[Queue[head]];
+            for(size_t j = 0; j < adjVertices.size(); ++ j)
+            {
+                if(m_VtxComponent[adjVertices[j]] != -1)
+                    continue;
+                m_VtxComponent[adjVertices[j]] = m_nComponent;
+                Queue.push_back(adjVertices[j]);
+            }
+        }
+        ++ m_nComponent;
+    }
+}
@@ -0,0 +1,101 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelGeodesic.h
+//
+// [Goal]
+// Geodesic distances of a triangle mesh model by the heat method
+//
+// The heat u = (M + tL)^-1 b flowed from the sources for a short time t,
+// the unit field X = -grad u / |grad u| on each face, and the distance is
+// the solution of L phi = div X shifted to zero at the sources. M is the
+// lumped mass and L the cotangent Laplacian of MeshModelOperatorCache. Both
+// matrices are factorized on the first query and kept until the kernel's
+// modification counter changes, so a query costs two pairs of triangular
+// solves and two passes over the faces. Several source sets are solved
+// together as the columns of one right hand side
+
+
+
+#include "MeshModelKernel.h"
+#include "MeshModelBasicOp.h"
+#include "MeshModelOperatorCache.h"
+#pragma once
+
+
+class SparseDirectSolver;
+
+
+
+/* ================== Heat Method Geodesic ================== */
+
+class MeshModelGeodesic
+{
+private:
+    MeshModelKernel* kernel;
+    MeshModelBasicOp* basicop;
+    MeshModelOperatorCache* cache;
+
+    unsigned int m_ModifyCount;     // Kernel modification count when the factorizations were computed
+    bool m_bValid;
+    double m_TimeFactor;            // Time step in squared mean edge lengths
+
+    DoubleArray m_VtxArea;          // Lumped mass, a third of the adjacent face areas
+    IndexArray  m_VtxComponent;     // Connected component of each vertex
+    int m_nComponent;
+
+    SparseDirectSolver* m_HeatSolver;       // M + tL
+    SparseDirectSolver* m_PoissonSolver;    // L, regularized by a tiny multiple of M
+
+public:
+    // Constructor
+    MeshModelGeodesic();
+
+    // Destructor
+    ~MeshModelGeodesic();
+
+    // Initializer
+    void ClearData();
+    void AttachKernel(MeshModelKernel* pKernel);
+    void AttachBasicOp(MeshModelBasicOp* pBasicOp);
+    void AttachOperatorCache(MeshModelOperatorCache* pCache);
+
+    // Drop the factorizations
+    void Invalidate();
+
+    // Time step t = factor * h^2 with h the mean edge length, 1 by default.
+    // Larger steps give smoother distances
+    void SetTimeFactor(double factor);
+    double GetTimeFactor() const { return m_TimeFactor; }
+
+    // Distance of each vertex to the nearest source, INFINITE_DISTANCE on the
+    // components without a source. False when the factorization fails
+    bool ComputeDistance(const IndexArray& Sources, DoubleArray& VtxDist);
+
+    // The same for several source sets at once, VtxDist[k] belongs to SourceSets[k]
+    bool ComputeDistance(const std::vector<IndexArray>& SourceSets, std::vector<DoubleArray>& VtxDist);
+
+    // Vertex path from vStart to vEnd descending the distance to vEnd over the
+    // mesh edges, falls back to the edge Dijkstra of MeshModelBasicOp where it stalls
+    void GetShortestPath(VertexID vStart, VertexID vEnd, IndexArray& Path);
+
+private:
+    bool Prepare();
+    void CalVertexArea();
+    void CalComponent();
+};
@@ -102,13 +102,55 @@ bool MeshModelIO::LoadModel(const std::string& filename)
     if(bOpenFlag)
     {
         size_t nVertex = kernel->GetVertexInfo().GetCoord().size();
-        size_t nFace   = kernel->GetFaceInfo().GetIndex().size();
+        size_t nFace   = kernel->GetFaceInfo().GetFaceNum();
         printf("#Vertex = %d, #Face = %d\n\n", nVertex, nFace);
     }
 
     return bOpenFlag;
 }
 
+bool MeshModelIO::PeekModelSize(const std::string& filename, int& nVertex, int& nFace)
+{
+    std::string file_path, file_title, file_ext;
+    util.ResolveFileName(filename, file_path, file_title, file_ext);
+    util.MakeLower(file_ext);
+
+    nVertex = nFace = 0;
+    std::ifstream file(filename.c_str());
+    if(! file)
+        return false;
+
+    if(file_ext == ".tm" || file_ext == ".ply2")
+    {
+        file >> nVertex >> nFace;
+    }
+    else if(file_ext == ".off")
+    {
+        std::string format;
+        file >> format >> nVertex >> nFace;
+    }
+    else if(file_ext == ".obj")
+    {
+        std::string str;
+        while(getline(file, str, '\n'))
+        {
+            if(str.size() < 2 || str[1] != ' ')
+                continue;
+            if(str[0] == 'v')
+                ++ nVertex;
+            else if(str[0] == 'f')
+                ++ nFace;
+        }
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+
+    return !file.fail() && nVertex >= 0 && nFace >= 0;
+}
+
 bool MeshModelIO::StoreModel(const std::string& filename)
 {
     // Resolve file name
@@ -185,21 +227,13 @@ bool MeshModelIO::OpenTmFile(const std::string& filename)
 
     // Load face information
     FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& fIndex = fInfo.GetIndex();
 
-    fIndex.resize(nFace);
-    int fv0;
-    int fv1;
-    int fv2;
+    fInfo.ReserveFaces(nFace);
+    int f[3];
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = fIndex[i];
-        f.resize(3);
-
-        fscanf(fp, "%d %d %d", &fv0, &fv1, &fv2);
-        f[0] = fv0;
-        f[1] = fv1;
-        f[2] = fv2;
+        fscanf(fp, "%d %d %d", &f[0], &f[1], &f[2]);
+        fInfo.AddFace(f, 3);
     }
 
     fclose(fp);
@@ -219,9 +253,8 @@ bool MeshModelIO::SaveTmFile(const std::string& filename)
     CoordArray& arrCoord = vInfo.GetCoord();
     nVertex = arrCoord.size();
 
-    FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& arrIndex = fInfo.GetIndex();
-    nFace = arrIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    nFace = fInfo.GetFaceNum();
 
     file << nVertex << ' ' << nFace << ' ' << nFace << '\n';
 
@@ -237,7 +270,7 @@ bool MeshModelIO::SaveTmFile(const std::string& filename)
     // Store face information
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = arrIndex[i];
+        const int* f = fInfo.GetFaceVertices(i);
         for(j = 0; j < 3; ++ j)
             file << f[j] << ((j<2) ? ' ' : '\n');
     }
@@ -275,16 +308,16 @@ bool MeshModelIO::OpenPly2File(const std::string& filename)
 
     // Load face information
     FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& fIndex = fInfo.GetIndex();
 
-    fIndex.resize(nFace);
+    fInfo.ReserveFaces(nFace);
+    IntArray f;
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = fIndex[i];
         file >> n;
         f.resize(n);
         for(j = 0; j < n; ++ j)
             file >> f[j];
+        fInfo.AddFace(&f[0], n);
     }
     file.close();
 
@@ -303,9 +336,8 @@ bool MeshModelIO::SavePly2File(const std::string& filename)
     CoordArray& arrCoord = vInfo.GetCoord();
     nVertex = arrCoord.size();
 
-    FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& arrIndex = fInfo.GetIndex();
-    nFace = arrIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    nFace = fInfo.GetFaceNum();
 
     file << nVertex << ' ' << nFace << '\n';
 
@@ -321,8 +353,8 @@ bool MeshModelIO::SavePly2File(const std::string& filename)
     // Store face information
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = arrIndex[i];
-        n = f.size();
+        const int* f = fInfo.GetFaceVertices(i);
+        n = fInfo.GetFaceDegree(i);
         file << n << ' ';
         for(j = 0; j < 3; ++ j)
             file << f[j] << ((j<2) ? ' ' : '\n');
@@ -370,12 +402,11 @@ bool MeshModelIO::OpenOffFile(const std::string& filename)
 
     // Load face information
     FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& fIndex = fInfo.GetIndex();
 
-    fIndex.resize(nFace);
+    fInfo.ReserveFaces(nFace);
+    IntArray f;
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = fIndex[i];
         fscanf(fp, "%d", &n);
         f.resize(n);
 
@@ -385,6 +416,7 @@ bool MeshModelIO::OpenOffFile(const std::string& filename)
             fscanf(fp, "%d", &vertexID);
             f[j] = vertexID;
         }
+        fInfo.AddFace(&f[0], n);
     }
     fclose(fp);
 
@@ -405,9 +437,8 @@ bool MeshModelIO::SaveOffFile(const std::string& filename)
     VertexInfo& vInfo = kernel->GetVertexInfo();
     CoordArray& arrCoord = vInfo.GetCoord();
     nVertex = arrCoord.size();
-    FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& arrIndex = fInfo.GetIndex();
-    nFace = arrIndex.size();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    nFace = fInfo.GetFaceNum();
 	
     file << nVertex << ' ' << nFace << ' ' << 0 <<'\n';
 	
@@ -423,8 +454,8 @@ bool MeshModelIO::SaveOffFile(const std::string& filename)
     // Store face information
     for(i = 0; i < nFace; ++ i)
     {
-        IntArray& f = arrIndex[i];
-        n = f.size();
+        const int* f = fInfo.GetFaceVertices(i);
+        n = fInfo.GetFaceDegree(i);
         file << n << ' ';
         for(j = 0; j < 3; ++ j)
             file << f[j] << ((j<2) ? ' ' : '\n');
@@ -493,8 +524,8 @@ bool MeshModelIO::OpenObjFile(const std::string& filename)
 
 	// Load face information
     FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& fIndex = fInfo.GetIndex();
-    fIndex.resize(nFace);
+    fInfo.ReserveFaces(nFace);
+	IntArray face;
 
 	PolyTexCoordArray& face_tcoord = fInfo.GetTexCoord();
 	face_tcoord.resize(nFace);
@@ -542,6 +573,7 @@ bool MeshModelIO::OpenObjFile(const std::string& filename)
 					len=(int)line.length();
 				}	
 				v=0, t=0, n=0;
+				face.clear();
 				for(int i=1;i<len;i++)
 				{
 					c=line[i]-'0';
@@ -561,7 +593,7 @@ bool MeshModelIO::OpenObjFile(const std::string& filename)
 						mark=2;
 					}
 					if((line[i]==' '&&isdigit(line[i-1]))|| i == (int) line.length()-1){
-						fIndex[fn].push_back(v-1);
+						face.push_back(v-1);
 						if(t >=1){
 							face_tex_index[fn].push_back(t-1);
 							const TexCoord& tex_coord = vTex[t-1];
@@ -570,6 +602,7 @@ bool MeshModelIO::OpenObjFile(const std::string& filename)
 						v = t = n  = 0;
 					}
 				}
+				fInfo.AddFace(face.empty() ? NULL : &face[0], (int) face.size());
 				++fn;
 				break;
 
@@ -599,9 +632,8 @@ bool MeshModelIO::SaveObjFile(const std::string& filename)
     nVertex = arrCoord.size();
 	
     FaceInfo& fInfo = kernel->GetFaceInfo();
-    PolyIndexArray& arrIndex = fInfo.GetIndex();
 	PolyIndexArray& texIndex = fInfo.GetTexIndex();
-    nFace = arrIndex.size();
+    nFace = fInfo.GetFaceNum();
 	
 	// Store vertex information
     size_t i, j;
@@ -626,7 +658,7 @@ bool MeshModelIO::SaveObjFile(const std::string& filename)
     // Store face information
     for(i = 0; i < nFace; ++ i)
     {
-        const IntArray& f = arrIndex[i];		
+        const int* f = fInfo.GetFaceVertices(i);		
         file << "f ";
 
 		if(!with_tex){
@@ -684,16 +716,11 @@ bool MeshModelIO::LoadTriangularMesh(boost::shared_ptr<const tri_mesh_3d> p_mesh
 
 	// Load face information
 	FaceInfo& fInfo = kernel->GetFaceInfo();
-	PolyIndexArray& fIndex = fInfo.GetIndex();
 
-	fIndex.resize(nFace);
+	fInfo.ReserveFaces(nFace);
 	for(size_t fn = 0; fn < nFace; ++fn)
 	{
-		IntArray& f = fIndex[fn];
-		for(size_t k=0; k<3; ++k)
-		{
-			f[k] = face_list_array[fn*3+k];
-		}
+		fInfo.AddFace(&face_list_array[fn*3], 3);
 	}
 
 	return true;
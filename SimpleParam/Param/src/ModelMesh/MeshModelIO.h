@@ -61,6 +61,10 @@ public:
 	bool LoadModel(const std::string& filename);
 	bool StoreModel(const std::string& filename);
 
+    // Vertex and face numbers of a model file without loading it, from the
+    // header of .tm, .ply2 and .off files and by counting the lines of .obj files
+	bool PeekModelSize(const std::string& filename, int& nVertex, int& nFace);
+
     // .tm file I/O functions
 	bool OpenTmFile(const std::string& filename);
 	bool SaveTmFile(const std::string& filename);
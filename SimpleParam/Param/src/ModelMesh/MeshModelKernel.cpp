@@ -63,6 +63,10 @@ void VertexInfo::ClearData()
     util.FreeVector(m_AdjVertices);
     util.FreeVector(m_AdjEdges);
 
+    util.FreeVector(m_Curvatures);
+    util.FreeVector(m_MeanCurvature);
+    util.FreeVector(m_GaussCurvature);
+
     m_nVertices = 0;
 }
 
@@ -93,10 +97,108 @@ void FaceInfo::ClearData()
     util.FreeVector(m_Flag);
 	util.FreeVector(m_FaceBaryCenter);
 	util.FreeVector(m_TexIndex);
+    util.FreeVector(m_TriIndex);
 
     m_nFaces = 0;
 }
 
+PolyIndexArray& FaceInfo::GetIndex()
+{
+    if(HasTriIndex())
+    {
+        CopyIndex(m_Index);
+        Utility util;
+        util.FreeVector(m_TriIndex);
+    }
+    return m_Index;
+}
+
+bool FaceInfo::BuildTriIndex()
+{
+    size_t i, nFace = m_Index.size();
+    if(HasTriIndex() || nFace == 0)
+        return HasTriIndex();
+    for(i = 0; i < nFace; ++ i)
+    {
+        if(m_Index[i].size() != 3)
+            return false;
+    }
+
+    m_TriIndex.resize(3*nFace);
+    for(i = 0; i < nFace; ++ i)
+    {
+        const IndexArray& f = m_Index[i];
+        m_TriIndex[3*i]   = f[0];
+        m_TriIndex[3*i+1] = f[1];
+        m_TriIndex[3*i+2] = f[2];
+    }
+    Utility util;
+    util.FreeVector(m_Index);
+    return true;
+}
+
+void FaceInfo::ReserveFaces(size_t nFace)
+{
+    if(m_Index.empty())
+        m_TriIndex.reserve(3*nFace);
+}
+
+void FaceInfo::AddFace(const int* vertices, int degree)
+{
+    if(degree == 3 && m_Index.empty())
+    {
+        m_TriIndex.insert(m_TriIndex.end(), vertices, vertices + 3);
+        return;
+    }
+    // The first polygon moves the triangles read so far to m_Index
+    GetIndex().push_back(IndexArray(vertices, vertices + degree));
+}
+
+void FaceInfo::GetFace(FaceID fID, IndexArray& face) const
+{
+    const int* f = GetFaceVertices(fID);
+    face.assign(f, f + GetFaceDegree(fID));
+}
+
+void FaceInfo::PermuteIndex(const IndexArray& faceOrder, const IndexArray& vtxRank)
+{
+    size_t i, j, nFace = faceOrder.size();
+    if(HasTriIndex())
+    {
+        IndexArray tmp(3*nFace);
+        for(i = 0; i < nFace; ++ i)
+        {
+            for(j = 0; j < 3; ++ j)
+                tmp[3*i+j] = vtxRank[m_TriIndex[3*faceOrder[i]+j]];
+        }
+        m_TriIndex.swap(tmp);
+        return;
+    }
+
+    PolyIndexArray tmp(nFace);
+    for(i = 0; i < nFace; ++ i)
+    {
+        tmp[i].swap(m_Index[faceOrder[i]]);
+        for(j = 0; j < tmp[i].size(); ++ j)
+            tmp[i][j] = vtxRank[tmp[i][j]];
+    }
+    m_Index.swap(tmp);
+}
+
+void FaceInfo::CopyIndex(PolyIndexArray& faces) const
+{
+    if(!HasTriIndex())
+    {
+        if(&faces != &m_Index)
+            faces = m_Index;
+        return;
+    }
+    int nFace = GetFaceNum();
+    faces.resize(nFace);
+    for(int i = 0; i < nFace; ++ i)
+        faces[i].assign(&m_TriIndex[3*i], &m_TriIndex[3*i] + 3);
+}
+
 
 
 /* ================== Kernel Element - Mesh Edge Information ================== */
@@ -121,7 +223,12 @@ void EdgeInfo::ClearData()
     util.FreeVector(m_Color);
     util.FreeVector(m_Flag);
 	util.FreeVector(m_DihedralAngle);
+    util.FreeVector(m_Length);
 	util.FreeVector(m_FaceIndex);
+    util.FreeVector(m_FaceEdgeOffset);
+    util.FreeVector(m_FaceEdge);
+    util.FreeVector(m_VtxEdgeOffset);
+    util.FreeVector(m_VtxEdge);
 
     m_nHalfEdges = 0;
 }
@@ -162,6 +269,10 @@ void ModelInfo::ClearData()
     m_AvgFaceArea = 0.0;
 
     util.FreeVector(m_Boundaries);
+    util.FreeVector(m_VtxOrder);
+    util.FreeVector(m_VtxRank);
+    util.FreeVector(m_FaceOrder);
+    util.FreeVector(m_FaceRank);
 }
 
 void ModelInfo::SetFileName(std::string filename)
@@ -169,6 +280,34 @@ void ModelInfo::SetFileName(std::string filename)
     m_FileName = filename;
 }
 
+VertexID ModelInfo::GetModelVertexID(int fileID)
+{
+    if(m_VtxRank.empty())
+        return (fileID >= 0 && fileID < m_nVertices) ? fileID : -1;
+    return (fileID >= 0 && fileID < (int) m_VtxRank.size()) ? m_VtxRank[fileID] : -1;
+}
+
+FaceID ModelInfo::GetModelFaceID(int fileID)
+{
+    if(m_FaceRank.empty())
+        return (fileID >= 0 && fileID < m_nFaces) ? fileID : -1;
+    return (fileID >= 0 && fileID < (int) m_FaceRank.size()) ? m_FaceRank[fileID] : -1;
+}
+
+int ModelInfo::GetFileVertexID(VertexID vID)
+{
+    if(m_VtxOrder.empty())
+        return (vID >= 0 && vID < m_nVertices) ? vID : -1;
+    return (vID >= 0 && vID < (int) m_VtxOrder.size()) ? m_VtxOrder[vID] : -1;
+}
+
+int ModelInfo::GetFileFaceID(FaceID fID)
+{
+    if(m_FaceOrder.empty())
+        return (fID >= 0 && fID < m_nFaces) ? fID : -1;
+    return (fID >= 0 && fID < (int) m_FaceOrder.size()) ? m_FaceOrder[fID] : -1;
+}
+
 bool ModelInfo::IsTriMesh()
 {
     return util.IsSetFlag(m_Flag, MODEL_FLAG_TRIMESH);
@@ -204,12 +343,17 @@ bool ModelInfo::IsPatch()
     return (util.IsSetFlag(m_Flag, MODEL_FLAG_MANIFOLD) && m_nBoundaries == 1);
 }
 
+bool ModelInfo::IsReordered()
+{
+    return !m_VtxOrder.empty() || !m_FaceOrder.empty();
+}
+
 /* ================== Mesh Model Kernel  ================== */
 
 // Constructor
 MeshModelKernel::MeshModelKernel()
 {
-    
+    m_nModifyCount = 0;
 }
 
 // Destructor
@@ -225,4 +369,6 @@ void MeshModelKernel::ClearData()
     m_FaceInfo.ClearData();
     m_EdgeInfo.ClearData();
     m_ModelInfo.ClearData();
+
+    IncModifyCount();
 }
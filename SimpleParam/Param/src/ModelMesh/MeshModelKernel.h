@@ -96,6 +96,8 @@ private:
     PolyIndexArray  m_AdjEdges;     // Vertex adjacent half-edge-index array   
     
 	CurvatureArray  m_Curvatures;   // Vertex curvature array
+    DoubleArray     m_MeanCurvature;    // Vertex mean curvature array, (kmin+kmax)/2
+    DoubleArray     m_GaussCurvature;   // Vertex Gaussian curvature array, kmin*kmax
 
     int m_nVertices;
 
@@ -120,6 +122,8 @@ public:
     PolyIndexArray& GetAdjVertices() { return m_AdjVertices; }
     PolyIndexArray& GetAdjEdges() { return m_AdjEdges; }
 	CurvatureArray& GetCurvatures() { return m_Curvatures; }
+    DoubleArray& GetMeanCurvature() { return m_MeanCurvature; }
+    DoubleArray& GetGaussCurvature() { return m_GaussCurvature; }
 };
 
 
@@ -130,7 +134,7 @@ class FaceInfo
 {
 private:
     // The following properties (arrays) are one-for-each-face
-    PolyIndexArray     m_Index;    // Face vertex-index array
+    PolyIndexArray     m_Index;    // Face vertex-index array of a polygonal model
     NormalArray        m_Normal;   // Face normal array
     ColorArray         m_Color;    // Face color array
     PolyTexCoordArray  m_TexCoord; // Face vertex-texture-coordinate array
@@ -138,6 +142,11 @@ private:
 	CoordArray         m_FaceBaryCenter; // the barycenter of each face.
 	DoubleArray        m_FaceArea;	
 	PolyIndexArray     m_TexIndex; // Face vertex-texture-index array
+
+    // Face vertex-index array of a model whose faces are all triangles, the vertices
+    // of face f are m_TriIndex[3*f .. 3*f+2]. A model keeps its faces either here or
+    // in m_Index, never in both
+    IndexArray         m_TriIndex;
      
     int m_nFaces;
 
@@ -152,7 +161,9 @@ public:
     void ClearData();
 
     // Get/Set functions
-    PolyIndexArray& GetIndex() { return m_Index; }
+    // Faces as one vector each, for the code that edits them. A triangle store is
+    // moved there first, BuildTriIndex() moves the faces back
+    PolyIndexArray& GetIndex();
     NormalArray& GetNormal() { return m_Normal; }
     ColorArray& GetColor() { return m_Color; }
     PolyTexCoordArray& GetTexCoord() { return m_TexCoord; }
@@ -161,20 +172,53 @@ public:
 	DoubleArray& GetFaceArea() { return m_FaceArea; }
 	PolyIndexArray& GetTexIndex() { return m_TexIndex; }
 
+    // Triangle store. BuildTriIndex() moves the faces of m_Index there when all are
+    // triangles and returns whether the model has a triangle store afterwards
+    bool BuildTriIndex();
+    bool HasTriIndex() const { return !m_TriIndex.empty(); }
+    const IndexArray& GetTriIndex() const { return m_TriIndex; }
+
+    // Face building for the loaders, the faces go to the triangle store as long as
+    // all of them are triangles
+    void ReserveFaces(size_t nFace);
+    void AddFace(const int* vertices, int degree);
+
+    // Read access to the faces of either store
+    int GetFaceNum() const { return HasTriIndex() ? (int) m_TriIndex.size()/3 : (int) m_Index.size(); }
+    int GetFaceDegree(FaceID fID) const { return HasTriIndex() ? 3 : (int) m_Index[fID].size(); }
+    const int* GetFaceVertices(FaceID fID) const { return HasTriIndex() ? &m_TriIndex[3*fID] : &m_Index[fID][0]; }
+    void GetFace(FaceID fID, IndexArray& face) const;
+    void CopyIndex(PolyIndexArray& faces) const;
+
+    // Move face faceOrder[i] to i and renumber the vertices by vtxRank, in either store
+    void PermuteIndex(const IndexArray& faceOrder, const IndexArray& vtxRank);
 };
 
 
 
 /* ================== Kernel Element - Mesh Edge Information ================== */
 
+// Flat edge table, edge i joins the vertices m_VtxIndex[2*i] < m_VtxIndex[2*i+1]
+// m_FaceIndex[2*i] is the face running along edge i from its first vertex to its second,
+// m_FaceIndex[2*i+1] the face running back, -1 on a boundary
 class EdgeInfo
 {
 private:
-    PolyIndexArray  m_VtxIndex;    // Edge vertex-index array
+    IndexArray      m_VtxIndex;     // Edge vertex-index array, 2 per edge
     ColorArray      m_Color;    // Edge color array
     FlagArray       m_Flag;     // Edge 32-bit flag array
     DoubleArray     m_DihedralAngle;     // the dihedral angle of each edge.
-	PolyIndexArray  m_FaceIndex;    // Edge face-index array
+    DoubleArray     m_Length;       // Edge length array
+	IndexArray      m_FaceIndex;    // Edge face-index array, 2 per edge
+
+    // The edge from corner j to corner j+1 of face f is m_FaceEdge[m_FaceEdgeOffset[f]+j]
+    IndexArray      m_FaceEdgeOffset;
+    IndexArray      m_FaceEdge;
+
+    // The edges of vertex v are m_VtxEdge[m_VtxEdgeOffset[v] .. m_VtxEdgeOffset[v+1]-1]
+    IndexArray      m_VtxEdgeOffset;
+    IndexArray      m_VtxEdge;
+
     int m_nHalfEdges;
     
 public:
@@ -188,11 +232,17 @@ public:
     void ClearData();
 
     // Get/Set functions
-    PolyIndexArray& GetVertexIndex() { return m_VtxIndex; }
+    size_t GetEdgeNum() const { return m_VtxIndex.size() / 2; }
+    IndexArray& GetVertexIndex() { return m_VtxIndex; }
     ColorArray& GetColor() { return m_Color; }
     FlagArray& GetFlag() { return m_Flag; }
 	DoubleArray& GetDihedralAngle() {return m_DihedralAngle;}
-	PolyIndexArray& GetFaceIndex() {return m_FaceIndex;}
+    DoubleArray& GetLength() { return m_Length; }
+	IndexArray& GetFaceIndex() {return m_FaceIndex;}
+    IndexArray& GetFaceEdgeOffset() { return m_FaceEdgeOffset; }
+    IndexArray& GetFaceEdge() { return m_FaceEdge; }
+    IndexArray& GetVertexEdgeOffset() { return m_VtxEdgeOffset; }
+    IndexArray& GetVertexEdge() { return m_VtxEdge; }
 
 };
 
@@ -223,6 +273,13 @@ private:
     double  m_AvgFaceArea;
 
     PolyIndexArray  m_Boundaries;   // Boundary vertex loop
+
+    // Element orders against the loaded file, empty while the model keeps the file order
+    IndexArray  m_VtxOrder;     // File index of each vertex
+    IndexArray  m_VtxRank;      // Vertex index of each file vertex, -1 when removed
+    IndexArray  m_FaceOrder;    // File index of each face
+    IndexArray  m_FaceRank;     // Face index of each file face, -1 when removed
+
     Utility     util;
 
 public:
@@ -275,6 +332,22 @@ public:
     void SetAvgFaceArea(double area) { m_AvgFaceArea = area; }    
 
     PolyIndexArray& GetBoundary() { return m_Boundaries; }
+
+    IndexArray& GetVertexOrder() { return m_VtxOrder; }
+    IndexArray& GetVertexRank() { return m_VtxRank; }
+    IndexArray& GetFaceOrder() { return m_FaceOrder; }
+    IndexArray& GetFaceRank() { return m_FaceRank; }
+
+    // Element numbers of the file, a compacted model has fewer
+    int GetFileVertexNum() { return m_VtxRank.empty() ? m_nVertices : (int) m_VtxRank.size(); }
+    int GetFileFaceNum() { return m_FaceRank.empty() ? m_nFaces : (int) m_FaceRank.size(); }
+
+    // Conversions between the file and the model indices, -1 when out of range
+    // or removed from the model
+    VertexID GetModelVertexID(int fileID);
+    FaceID GetModelFaceID(int fileID);
+    int GetFileVertexID(VertexID vID);
+    int GetFileFaceID(FaceID fID);
     
     // Predictions    
     bool IsTriMesh();       // Whether the model is a triangle mesh (only containing triangles)
@@ -286,6 +359,8 @@ public:
     bool IsManifold();      // Whether the model is a 2-manifold one (locally disc-like)
     bool IsTriManifold();   // Whether the model is a 2-mainfold triangle mesh
     bool IsPatch();         // Whether the model is a patch (single boundary, 2-manifold)
+
+    bool IsReordered();     // Whether the elements are no longer in the file order
 };
 
 
@@ -302,6 +377,9 @@ private:
     ModelInfo   m_ModelInfo;
     Utility     util;
 
+    // Modification counter -- never reset, so cached data can detect a changed model
+    unsigned int m_nModifyCount;
+
 public:
 	// Constructor & Destructor
 	MeshModelKernel();
@@ -315,4 +393,8 @@ public:
     EdgeInfo&   GetEdgeInfo()   { return m_EdgeInfo; }
     FaceInfo&   GetFaceInfo()   { return m_FaceInfo; }
     ModelInfo&  GetModelInfo()  { return m_ModelInfo; }
+
+    // Modification counter -- bumped whenever the geometry or topology changes
+    unsigned int GetModifyCount() const { return m_nModifyCount; }
+    void IncModifyCount() { ++ m_nModifyCount; }
 };
@@ -0,0 +1,552 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelOperatorCache.cpp
+//
+// [Goal]
+// Lazily computed geometric operators of a triangle mesh model
+// Including cotangent weights, Laplacian matrices, per-face local frames,
+// areas, gradient operators and edge lengths
+
+
+
+#include "MeshModelOperatorCache.h"
+#include "../Common/Parallel.h"
+#include <cassert>
+
+
+
+// Per-face bodies run by parallel_for, each only writes the entries of its own face
+namespace
+{
+    class CotCoefPass
+    {
+    public:
+        const CoordArray& vCoord;
+        const FaceInfo& fInfo;
+        std::vector<Coord>& CotCoef;
+
+        CotCoefPass(const CoordArray& v, const FaceInfo& f, std::vector<Coord>& c)
+            : vCoord(v), fInfo(f), CotCoef(c) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            Coord e[3];
+            double a[3];
+            for(int j = 0; j < 3; ++ j)
+            {
+                e[j] = (vCoord[f[(j+1)%3]] - vCoord[f[j]]).unit();
+            }
+
+            a[0] = angle(e[0], -e[2]);
+            a[1] = angle(e[1], -e[0]);
+            a[2] = PI-a[0]-a[1];
+
+            for(int j = 0; j < 3; ++ j)
+            {
+                // angle < 1 or angle > 179
+                if(fabs(a[j]-0.0) < 0.0174 || fabs(a[j]-PI) < 0.0174)
+                {
+                    CotCoef[i][j] = 57.289;   // atan(1)
+                }
+                else
+                {
+                    CotCoef[i][j] = 1.0/tan(a[j]);
+                }
+            }
+        }
+    };
+
+    class FaceLocalFramePass
+    {
+    public:
+        const CoordArray& vCoord;
+        const FaceInfo& fInfo;
+        std::vector<Coord2D>& LocalCoord;
+        DoubleArray& FaceArea;
+
+        FaceLocalFramePass(const CoordArray& v, const FaceInfo& f, std::vector<Coord2D>& c, DoubleArray& a)
+            : vCoord(v), fInfo(f), LocalCoord(c), FaceArea(a) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            Coord vec_1 = vCoord[f[1]] - vCoord[f[0]];
+            Coord vec_2 = vCoord[f[2]] - vCoord[f[0]];
+
+            double len_1 = vec_1.abs();
+            double len_2 = vec_2.abs();
+            double agl = angle(vec_1, vec_2);
+
+            LocalCoord[i*3]   = Coord2D(0, 0);
+            LocalCoord[i*3+1] = Coord2D(len_1, 0);
+            LocalCoord[i*3+2] = Coord2D(len_2*cos(agl), len_2*sin(agl));
+
+            FaceArea[i] = 0.5*len_1*len_2*sin(agl);
+        }
+    };
+
+    // Faces sharing edge (f[j], f[j+1]) with face i, counted when Adj is NULL
+    class FaceAdjacencyPass
+    {
+    public:
+        const FaceInfo& fInfo;
+        const PolyIndexArray& vAdjFaces;
+        IndexArray& Offset;
+        IndexArray* Adj;
+
+        FaceAdjacencyPass(const FaceInfo& f, const PolyIndexArray& af, IndexArray& o, IndexArray* a)
+            : fInfo(f), vAdjFaces(af), Offset(o), Adj(a) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            size_t n = fInfo.GetFaceDegree(i);
+            int nAdj = 0;
+            for(size_t j = 0; j < n; ++ j)
+            {
+                const IndexArray& adjFaces1 = vAdjFaces[f[j]];
+                const IndexArray& adjFaces2 = vAdjFaces[f[(j+1)%n]];
+                for(size_t k = 0; k < adjFaces1.size(); ++ k)
+                {
+                    FaceID fID = adjFaces1[k];
+                    if(fID == i || find(adjFaces2.begin(), adjFaces2.end(), fID) == adjFaces2.end())
+                        continue;
+                    if(Adj != NULL)
+                        (*Adj)[Offset[i]+nAdj] = fID;
+                    ++ nAdj;
+                }
+            }
+            if(Adj == NULL)
+                Offset[i+1] = nAdj;
+        }
+    };
+
+    class EdgeLengthPass
+    {
+    public:
+        const CoordArray& vCoord;
+        const FaceInfo& fInfo;
+        std::vector<Coord>& EdgeLength;
+
+        EdgeLengthPass(const CoordArray& v, const FaceInfo& f, std::vector<Coord>& l)
+            : vCoord(v), fInfo(f), EdgeLength(l) {}
+
+        void operator()(int i) const
+        {
+            const int* f = fInfo.GetFaceVertices(i);
+            for(int j = 0; j < 3; ++ j)
+                EdgeLength[i][j] = (vCoord[f[(j+1)%3]] - vCoord[f[j]]).abs();
+        }
+    };
+}
+
+
+
+// Constructor
+MeshModelOperatorCache::MeshModelOperatorCache()
+{
+    kernel = NULL;
+    basicop = NULL;
+    ClearData();
+}
+
+// Destructor
+MeshModelOperatorCache::~MeshModelOperatorCache()
+{
+
+}
+
+// Initializer
+void MeshModelOperatorCache::ClearData()
+{
+    Invalidate();
+}
+
+void MeshModelOperatorCache::AttachKernel(MeshModelKernel* pKernel)
+{
+    assert(pKernel != NULL);
+    kernel = pKernel;
+}
+
+void MeshModelOperatorCache::AttachBasicOp(MeshModelBasicOp* pBasicOp)
+{
+    assert(pBasicOp != NULL);
+    basicop = pBasicOp;
+}
+
+void MeshModelOperatorCache::Invalidate()
+{
+    ParallelLock lock(m_Mutex);
+    for(int i = 0; i < OPERATOR_NUM; ++ i)
+    {
+        m_bValid[i] = false;
+        m_ModifyCount[i] = 0;
+    }
+
+    m_CotCoef.clear();
+    m_CotLaplacian.ClearData();
+    m_MeanValueLaplacian.ClearData();
+    m_FaceLocalCoord.clear();
+    m_FaceArea.clear();
+    m_FaceGradient.clear();
+    m_EdgeLength.clear();
+    m_FaceAdjOffset.clear();
+    m_FaceAdjIndex.clear();
+}
+
+bool MeshModelOperatorCache::IsValid(int op)
+{
+    return m_bValid[op] && m_ModifyCount[op] == kernel->GetModifyCount();
+}
+
+void MeshModelOperatorCache::SetValid(int op)
+{
+    m_bValid[op] = true;
+    m_ModifyCount[op] = kernel->GetModifyCount();
+}
+
+// Compute an operator if it is out of date, m_Mutex must be held
+void MeshModelOperatorCache::Ensure(int op)
+{
+    if(IsValid(op))
+        return;
+
+    switch(op)
+    {
+    case OPERATOR_COT_COEF:             CalCotCoef(); break;
+    case OPERATOR_COT_LAPLACIAN:        CalCotLaplacian(); break;
+    case OPERATOR_MEAN_VALUE_LAPLACIAN: CalMeanValueLaplacian(); break;
+    case OPERATOR_FACE_LOCAL_FRAME:     CalFaceLocalFrame(); break;
+    case OPERATOR_FACE_GRADIENT:        CalFaceGradient(); break;
+    case OPERATOR_EDGE_LENGTH:          CalEdgeLength(); break;
+    case OPERATOR_FACE_ADJACENCY:       CalFaceAdjacency(); break;
+    default: assert(false);
+    }
+    SetValid(op);
+}
+
+// Get functions, safe to call from several threads
+const std::vector<Coord>& MeshModelOperatorCache::GetCotCoef()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_COT_COEF);
+    return m_CotCoef;
+}
+
+const CMeshSparseMatrix& MeshModelOperatorCache::GetCotLaplacian()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_COT_LAPLACIAN);
+    return m_CotLaplacian;
+}
+
+const CMeshSparseMatrix& MeshModelOperatorCache::GetMeanValueLaplacian()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_MEAN_VALUE_LAPLACIAN);
+    return m_MeanValueLaplacian;
+}
+
+const std::vector<Coord2D>& MeshModelOperatorCache::GetFaceLocalCoord()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_FACE_LOCAL_FRAME);
+    return m_FaceLocalCoord;
+}
+
+const DoubleArray& MeshModelOperatorCache::GetFaceArea()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_FACE_LOCAL_FRAME);
+    return m_FaceArea;
+}
+
+const std::vector<Coord2D>& MeshModelOperatorCache::GetFaceGradient()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_FACE_GRADIENT);
+    return m_FaceGradient;
+}
+
+const std::vector<Coord>& MeshModelOperatorCache::GetEdgeLength()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_EDGE_LENGTH);
+    return m_EdgeLength;
+}
+
+const IndexArray& MeshModelOperatorCache::GetFaceAdjOffset()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_FACE_ADJACENCY);
+    return m_FaceAdjOffset;
+}
+
+const IndexArray& MeshModelOperatorCache::GetFaceAdjIndex()
+{
+    ParallelLock lock(m_Mutex);
+    Ensure(OPERATOR_FACE_ADJACENCY);
+    return m_FaceAdjIndex;
+}
+
+// Multi-source breadth first search over the face adjacency, stopping at MaxRing
+void MeshModelOperatorCache::GetFaceRingDistance(const IndexArray& SrcFaces, int MaxRing, IntArray& Dist)
+{
+    const IndexArray& Offset = GetFaceAdjOffset();
+    const IndexArray& AdjIndex = GetFaceAdjIndex();
+
+    size_t nFace = Offset.size()-1;
+    Dist.assign(nFace, -1);
+
+    IndexArray Front, NextFront;
+    for(size_t i = 0; i < SrcFaces.size(); ++ i)
+    {
+        if(Dist[SrcFaces[i]] == 0)
+            continue;
+        Dist[SrcFaces[i]] = 0;
+        Front.push_back(SrcFaces[i]);
+    }
+
+    for(int ring = 1; ring <= MaxRing && !Front.empty(); ++ ring)
+    {
+        NextFront.clear();
+        for(size_t i = 0; i < Front.size(); ++ i)
+        {
+            FaceID fID = Front[i];
+            for(int k = Offset[fID]; k < Offset[fID+1]; ++ k)
+            {
+                FaceID adj_fID = AdjIndex[k];
+                if(Dist[adj_fID] != -1)
+                    continue;
+                Dist[adj_fID] = ring;
+                NextFront.push_back(adj_fID);
+            }
+        }
+        Front.swap(NextFront);
+    }
+}
+
+// Cotangent of each face corner, with the alpha+beta < PI check
+void MeshModelOperatorCache::CalCotCoef()
+{
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+
+    size_t nFace = fInfo.GetFaceNum();
+    m_CotCoef.clear();
+    m_CotCoef.resize(nFace);
+
+    parallel_for(0, (int) nFace, CotCoefPass(vCoord, kernel->GetFaceInfo(), m_CotCoef));
+
+    // The adjustment couples neighboring faces, keep it serial so the result
+    // does not depend on the thread number
+    size_t i, j;
+    size_t nVertex = vCoord.size();
+    const PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+    int k, h;
+    for(i = 0; i < nVertex; ++ i)
+    {
+        const IndexArray& adjf = vAdjFaces[i];
+        size_t n = adjf.size();
+        if(n == 0)
+            continue;
+        size_t begin_idx = 0, end_idx = n-1;
+        if(basicop->IsBoundaryVertex((int) i))
+        {
+            begin_idx = 1;
+            end_idx = n-1;
+        }
+        for(j = begin_idx; j <= end_idx; ++ j)
+        {
+            FaceID fID1 = adjf[(j+n-1)%n];
+            FaceID fID2 = adjf[j];
+            const int* f1 = fInfo.GetFaceVertices(fID1);
+            const int* f2 = fInfo.GetFaceVertices(fID2);
+            for(k = 0; k < 3; ++ k)
+            {
+                if(f1[k] == i)
+                    break;
+            }
+            for(h = 0; h < 3; ++ h)
+            {
+                if(f2[h] == i)
+                    break;
+            }
+            if(m_CotCoef[fID1][(k+1)%3] + m_CotCoef[fID2][(h+2)%3] < 0.0)
+            {
+                m_CotCoef[fID1][(k+1)%3] = m_CotCoef[fID2][(h+2)%3] = 0.0;
+            }
+        }
+    }
+}
+
+void MeshModelOperatorCache::CalCotLaplacian()
+{
+    Ensure(OPERATOR_COT_COEF);
+    const std::vector<Coord>& cot_coef = m_CotCoef;
+
+    const PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+
+    int i, j, k, n;
+    int fID;
+    double d;
+
+    int nVertex = (int) kernel->GetVertexInfo().GetCoord().size();
+    m_CotLaplacian.ClearData();
+    m_CotLaplacian.SetRowCol(nVertex, nVertex);
+
+    for(i = 0; i < nVertex; ++ i)
+    {
+        const IndexArray& adjFaces = vAdjFaces[i];
+        n = (int) adjFaces.size();
+
+        for(j = 0; j < n; ++ j)
+        {
+            fID = adjFaces[j];
+            const int* f = fInfo.GetFaceVertices(fID);
+
+            // Find the position of vertex i in face fID
+            for(k = 0; k < 3; ++ k)
+            {
+                if(f[k] == i) break;
+            }
+            assert(k != 3);
+
+            m_CotLaplacian.GetElement(i, f[(k+1)%3], d);
+            m_CotLaplacian.SetElement(i, f[(k+1)%3], d - cot_coef[fID][(k+2)%3]);
+
+            m_CotLaplacian.GetElement(i, f[(k+2)%3], d);
+            m_CotLaplacian.SetElement(i, f[(k+2)%3], d - cot_coef[fID][(k+1)%3]);
+
+            m_CotLaplacian.GetElement(i, i, d);
+            m_CotLaplacian.SetElement(i, i, d + cot_coef[fID][(k+1)%3] + cot_coef[fID][(k+2)%3]);
+        }
+    }
+}
+
+// Mean value Laplacian, boundary rows are left empty
+void MeshModelOperatorCache::CalMeanValueLaplacian()
+{
+    const PolyIndexArray& vAdjVertices = kernel->GetVertexInfo().GetAdjVertices();
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+
+    int nVertex = (int) vCoord.size();
+    m_MeanValueLaplacian.ClearData();
+    m_MeanValueLaplacian.SetRowCol(nVertex, nVertex);
+
+    DoubleArray tan_coef;
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        if(basicop->IsBoundaryVertex(i))
+            continue;
+
+        const IndexArray& adjVertices = vAdjVertices[i];
+        int n = (int) adjVertices.size();
+
+        tan_coef.resize(n);
+        for(int j = 0; j < n; ++ j)
+        {
+            Coord e1 = vCoord[adjVertices[j]] - vCoord[i];
+            Coord e2 = vCoord[adjVertices[(j+1)%n]] - vCoord[i];
+            tan_coef[j] = tan(angle(e1, e2)/2);
+        }
+
+        for(int j = 0; j < n; ++ j)
+        {
+            int col = adjVertices[j];
+            double edge_len = (vCoord[i]-vCoord[col]).abs();
+            double coef = (tan_coef[j] + tan_coef[(j+n-1)%n])/edge_len;
+            double d;
+
+            m_MeanValueLaplacian.GetElement(i, col, d);
+            m_MeanValueLaplacian.SetElement(i, col, d - coef);
+
+            m_MeanValueLaplacian.GetElement(i, i, d);
+            m_MeanValueLaplacian.SetElement(i, i, d + coef);
+        }
+    }
+}
+
+// Local frame of each face: f[0] at origin, f[1] on positive x axis, f[2] in upper half plane
+void MeshModelOperatorCache::CalFaceLocalFrame()
+{
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+
+    size_t nFace = fInfo.GetFaceNum();
+    m_FaceLocalCoord.resize(nFace*3);
+    m_FaceArea.resize(nFace);
+
+    parallel_for(0, (int) nFace, FaceLocalFramePass(vCoord, kernel->GetFaceInfo(), m_FaceLocalCoord, m_FaceArea));
+}
+
+// Gradient of the hat function of each face corner, grad_j = rot90(p[j+2]-p[j+1]) / (2*area)
+void MeshModelOperatorCache::CalFaceGradient()
+{
+    Ensure(OPERATOR_FACE_LOCAL_FRAME);
+    const std::vector<Coord2D>& local_coord = m_FaceLocalCoord;
+    const DoubleArray& face_area = m_FaceArea;
+
+    size_t nFace = face_area.size();
+    m_FaceGradient.resize(nFace*3);
+
+    for(size_t i = 0; i < nFace; ++ i)
+    {
+        const Coord2D* p = &local_coord[i*3];
+        double area_2 = 2*face_area[i];
+        for(int j = 0; j < 3; ++ j)
+        {
+            Coord2D e = p[(j+2)%3] - p[(j+1)%3];
+            if(area_2 < SMALL_ZERO_EPSILON)
+                m_FaceGradient[i*3+j] = Coord2D(0, 0);
+            else
+                m_FaceGradient[i*3+j] = Coord2D(-e[1]/area_2, e[0]/area_2);
+        }
+    }
+}
+
+void MeshModelOperatorCache::CalEdgeLength()
+{
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+
+    size_t nFace = fInfo.GetFaceNum();
+    m_EdgeLength.resize(nFace);
+
+    parallel_for(0, (int) nFace, EdgeLengthPass(vCoord, kernel->GetFaceInfo(), m_EdgeLength));
+}
+
+// Face adjacency through shared edges, counted then filled in parallel
+void MeshModelOperatorCache::CalFaceAdjacency()
+{
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    const PolyIndexArray& vAdjFaces = kernel->GetVertexInfo().GetAdjFaces();
+
+    size_t nFace = fInfo.GetFaceNum();
+    m_FaceAdjOffset.assign(nFace+1, 0);
+
+    parallel_for(0, (int) nFace, FaceAdjacencyPass(fInfo, vAdjFaces, m_FaceAdjOffset, NULL));
+    for(size_t i = 0; i < nFace; ++ i)
+        m_FaceAdjOffset[i+1] += m_FaceAdjOffset[i];
+
+    m_FaceAdjIndex.resize(m_FaceAdjOffset[nFace]);
+    parallel_for(0, (int) nFace, FaceAdjacencyPass(fInfo, vAdjFaces, m_FaceAdjOffset, &m_FaceAdjIndex));
+}
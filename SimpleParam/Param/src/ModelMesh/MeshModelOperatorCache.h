@@ -0,0 +1,117 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelOperatorCache.h
+//
+// [Goal]
+// Lazily computed geometric operators of a triangle mesh model
+// Including cotangent weights, Laplacian matrices, per-face local frames,
+// areas, gradient operators, edge lengths and the face adjacency
+//
+// Each operator is computed on first request and kept until the kernel's
+// modification counter changes. The get functions may be called from several
+// threads, the first caller computes the operator while the others wait
+
+
+
+#include "MeshModelKernel.h"
+#include "MeshModelBasicOp.h"
+#include "../Numerical/MeshSparseMatrix.h"
+#include "../Common/Utility.h"
+#include "../Common/Parallel.h"
+#pragma once
+
+
+
+/* ================== Operator Cache ================== */
+
+class MeshModelOperatorCache
+{
+private:
+    MeshModelKernel* kernel;
+    MeshModelBasicOp* basicop;
+
+    enum
+    {
+        OPERATOR_COT_COEF = 0,
+        OPERATOR_COT_LAPLACIAN,
+        OPERATOR_MEAN_VALUE_LAPLACIAN,
+        OPERATOR_FACE_LOCAL_FRAME,
+        OPERATOR_FACE_GRADIENT,
+        OPERATOR_EDGE_LENGTH,
+        OPERATOR_FACE_ADJACENCY,
+        OPERATOR_NUM
+    };
+
+    unsigned int m_ModifyCount[OPERATOR_NUM];   // Kernel modification count when each operator was computed
+    bool m_bValid[OPERATOR_NUM];
+    ParallelMutex m_Mutex;                      // Guards the computation of the operators
+
+    std::vector<Coord> m_CotCoef;           // Cotangent of the angle at each face corner
+    CMeshSparseMatrix  m_CotLaplacian;      // Cotangent Laplacian
+    CMeshSparseMatrix  m_MeanValueLaplacian;// Mean value Laplacian
+    std::vector<Coord2D> m_FaceLocalCoord;  // 3 local 2D coords per face, the first at origin, the second on x axis
+    DoubleArray m_FaceArea;                 // Area of each face
+    std::vector<Coord2D> m_FaceGradient;    // 3 gradient vectors per face, in the face local frame
+    std::vector<Coord> m_EdgeLength;        // Length of edge (f[j], f[j+1]) of each face
+    IndexArray m_FaceAdjOffset;             // Face adjacency in CSR form, the faces sharing an edge with
+    IndexArray m_FaceAdjIndex;              // face i are m_FaceAdjIndex[m_FaceAdjOffset[i], m_FaceAdjOffset[i+1])
+
+public:
+    // Constructor
+    MeshModelOperatorCache();
+
+    // Destructor
+    ~MeshModelOperatorCache();
+
+    // Initializer
+    void ClearData();
+    void AttachKernel(MeshModelKernel* pKernel);
+    void AttachBasicOp(MeshModelBasicOp* pBasicOp);
+
+    // Drop all the cached operators
+    void Invalidate();
+
+    // Get functions, computing the operator on demand
+    const std::vector<Coord>& GetCotCoef();
+    const CMeshSparseMatrix& GetCotLaplacian();
+    const CMeshSparseMatrix& GetMeanValueLaplacian();
+    const std::vector<Coord2D>& GetFaceLocalCoord();
+    const DoubleArray& GetFaceArea();
+    const std::vector<Coord2D>& GetFaceGradient();
+    const std::vector<Coord>& GetEdgeLength();
+    const IndexArray& GetFaceAdjOffset();
+    const IndexArray& GetFaceAdjIndex();
+
+    // Ring distance of each face to the nearest source face through shared edges,
+    // -1 for the faces farther than MaxRing
+    void GetFaceRingDistance(const IndexArray& SrcFaces, int MaxRing, IntArray& Dist);
+
+private:
+    bool IsValid(int op);
+    void SetValid(int op);
+    void Ensure(int op);
+
+    void CalCotCoef();
+    void CalCotLaplacian();
+    void CalMeanValueLaplacian();
+    void CalFaceLocalFrame();
+    void CalFaceGradient();
+    void CalEdgeLength();
+    void CalFaceAdjacency();
+};
@@ -0,0 +1,204 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelQueryContext.cpp
+//
+// [Goal]
+// Scratch data of the local neighborhood queries of MeshModelBasicOp
+
+#include "MeshModelQueryContext.h"
+#include <algorithm>
+#include <cassert>
+
+// Constructor
+MeshModelQueryContext::MeshModelQueryContext()
+{
+    m_Epoch = 0;
+}
+
+// Destructor
+MeshModelQueryContext::~MeshModelQueryContext()
+{
+}
+
+void MeshModelQueryContext::Begin(size_t nVertex, size_t nFace)
+{
+    // Arrays only grow, the new entries are stamped 0 which no query uses
+    if(m_VtxStamp.size() < nVertex)
+    {
+        m_VtxStamp.resize(nVertex, 0);
+        m_VtxDist.resize(nVertex);
+        m_VtxHeapPos.resize(nVertex);
+        m_VtxMark.resize(nVertex, 0);
+    }
+    if(m_FaceMark.size() < nFace)
+        m_FaceMark.resize(nFace, 0);
+
+    ++ m_Epoch;
+    if(m_Epoch == 0)    // Wrapped around, old stamps could match again
+    {
+        fill(m_VtxStamp.begin(), m_VtxStamp.end(), 0);
+        fill(m_VtxMark.begin(), m_VtxMark.end(), 0);
+        fill(m_FaceMark.begin(), m_FaceMark.end(), 0);
+        m_Epoch = 1;
+    }
+
+    m_Heap.clear();
+    m_Stack.clear();
+}
+
+bool MeshModelQueryContext::MarkVertex(VertexID vID)
+{
+    if(m_VtxMark[vID] == m_Epoch)
+        return false;
+    m_VtxMark[vID] = m_Epoch;
+    return true;
+}
+
+bool MeshModelQueryContext::MarkFace(FaceID fID)
+{
+    if(m_FaceMark[fID] == m_Epoch)
+        return false;
+    m_FaceMark[fID] = m_Epoch;
+    return true;
+}
+
+double MeshModelQueryContext::GetDistance(VertexID vID) const
+{
+    return (m_VtxStamp[vID] == m_Epoch) ? m_VtxDist[vID] : INFINITE_DISTANCE;
+}
+
+void MeshModelQueryContext::SetDistance(VertexID vID, double dist)
+{
+    if(m_VtxStamp[vID] != m_Epoch)
+    {
+        m_VtxStamp[vID] = m_Epoch;
+        m_VtxHeapPos[vID] = -1;
+    }
+    m_VtxDist[vID] = dist;
+}
+
+bool MeshModelQueryContext::IsInHeap(VertexID vID) const
+{
+    return m_VtxStamp[vID] == m_Epoch && m_VtxHeapPos[vID] >= 0;
+}
+
+void MeshModelQueryContext::PushHeap(VertexID vID)
+{
+    assert(m_VtxStamp[vID] == m_Epoch && m_VtxHeapPos[vID] < 0);
+    m_Heap.push_back(vID);
+    m_VtxHeapPos[vID] = (int) m_Heap.size() - 1;
+    SiftUp(m_VtxHeapPos[vID]);
+}
+
+void MeshModelQueryContext::UpdateHeap(VertexID vID)
+{
+    assert(IsInHeap(vID));
+    SiftUp(m_VtxHeapPos[vID]);
+}
+
+VertexID MeshModelQueryContext::PopHeap()
+{
+    assert(!m_Heap.empty());
+    VertexID vID = m_Heap[0];
+    m_VtxHeapPos[vID] = -1;
+
+    VertexID last = m_Heap.back();
+    m_Heap.pop_back();
+    if(!m_Heap.empty())
+    {
+        m_Heap[0] = last;
+        m_VtxHeapPos[last] = 0;
+        SiftDown(0);
+    }
+    return vID;
+}
+
+void MeshModelQueryContext::SiftUp(int pos)
+{
+    VertexID vID = m_Heap[pos];
+    double dist = m_VtxDist[vID];
+    while(pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        VertexID pID = m_Heap[parent];
+        if(m_VtxDist[pID] <= dist)
+            break;
+        m_Heap[pos] = pID;
+        m_VtxHeapPos[pID] = pos;
+        pos = parent;
+    }
+    m_Heap[pos] = vID;
+    m_VtxHeapPos[vID] = pos;
+}
+
+void MeshModelQueryContext::SiftDown(int pos)
+{
+    int n = (int) m_Heap.size();
+    VertexID vID = m_Heap[pos];
+    double dist = m_VtxDist[vID];
+    while(2 * pos + 1 < n)
+    {
+        int child = 2 * pos + 1;
+        if(child + 1 < n && m_VtxDist[m_Heap[child+1]] < m_VtxDist[m_Heap[child]])
+            ++ child;
+        VertexID cID = m_Heap[child];
+        if(dist <= m_VtxDist[cID])
+            break;
+        m_Heap[pos] = cID;
+        m_VtxHeapPos[cID] = pos;
+        pos = child;
+    }
+    m_Heap[pos] = vID;
+    m_VtxHeapPos[vID] = pos;
+}
+
+// Query context pool
+MeshModelQueryContextPool::MeshModelQueryContextPool()
+{
+}
+
+MeshModelQueryContextPool::MeshModelQueryContextPool(const MeshModelQueryContextPool&)
+{
+}
+
+MeshModelQueryContextPool::~MeshModelQueryContextPool()
+{
+    for(size_t i = 0; i < m_FreeContext.size(); ++ i)
+        delete m_FreeContext[i];
+}
+
+MeshModelQueryContext* MeshModelQueryContextPool::Acquire()
+{
+    {
+        ParallelLock lock(m_Mutex);
+        if(!m_FreeContext.empty())
+        {
+            MeshModelQueryContext* pContext = m_FreeContext.back();
+            m_FreeContext.pop_back();
+            return pContext;
+        }
+    }
+    return new MeshModelQueryContext;
+}
+
+void MeshModelQueryContextPool::Release(MeshModelQueryContext* pContext)
+{
+    ParallelLock lock(m_Mutex);
+    m_FreeContext.push_back(pContext);
+}
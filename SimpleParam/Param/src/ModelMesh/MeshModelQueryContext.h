@@ -0,0 +1,140 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelQueryContext.h
+//
+// [Goal]
+// Scratch data of the local neighborhood queries of MeshModelBasicOp
+//
+// The per vertex and per face states are stamped with the number of the
+// query that wrote them, so starting a query only bumps the stamp and a
+// query costs time in the size of the region it visits. The arrays are
+// sized to the mesh once and reused. A context serves one query at a
+// time, concurrent queries need one context per thread. A context pool hands
+// out contexts to the calls that do not bring one
+
+
+
+#include "../Common/BasicDataType.h"
+#include "../Common/Parallel.h"
+#pragma once
+
+
+#ifndef INFINITE_DISTANCE
+#define INFINITE_DISTANCE   1.0e30
+#endif
+
+
+/* ================== Query Context ================== */
+
+class MeshModelQueryContext
+{
+private:
+    unsigned int m_Epoch;
+
+    // A vertex has a distance and a heap position in the current query when its stamp is m_Epoch
+    std::vector<unsigned int> m_VtxStamp;
+    DoubleArray m_VtxDist;
+    IndexArray  m_VtxHeapPos;       // -1 when not in the heap
+
+    // Visited marks
+    std::vector<unsigned int> m_VtxMark;
+    std::vector<unsigned int> m_FaceMark;
+
+    // Binary min heap of vertices keyed by m_VtxDist
+    IndexArray m_Heap;
+
+public:
+    // Scratch stack for the flood fills
+    IndexArray m_Stack;
+
+public:
+    // Constructor
+    MeshModelQueryContext();
+
+    // Destructor
+    ~MeshModelQueryContext();
+
+    // Start a query on a mesh of the given size, forgetting the states of the last one
+    void Begin(size_t nVertex, size_t nFace);
+
+    // Visited marks, Mark*() returns false when already marked
+    bool IsVertexMarked(VertexID vID) const { return m_VtxMark[vID] == m_Epoch; }
+    bool IsFaceMarked(FaceID fID) const { return m_FaceMark[fID] == m_Epoch; }
+    bool MarkVertex(VertexID vID);
+    bool MarkFace(FaceID fID);
+
+    // Tentative distances, INFINITE_DISTANCE when not reached yet
+    double GetDistance(VertexID vID) const;
+    void SetDistance(VertexID vID, double dist);
+
+    // Heap of vertices by their distance
+    bool IsHeapEmpty() const { return m_Heap.empty(); }
+    bool IsInHeap(VertexID vID) const;
+    void PushHeap(VertexID vID);        // Insert a vertex at its current distance
+    void UpdateHeap(VertexID vID);      // Move a vertex in the heap after its distance decreased
+    VertexID PopHeap();
+
+private:
+    void SiftUp(int pos);
+    void SiftDown(int pos);
+};
+
+
+
+/* ================== Query Context Pool ================== */
+
+// Free contexts, a call takes one and gives it back so concurrent calls never
+// share a context. There are as many contexts as calls that ever overlapped
+class MeshModelQueryContextPool
+{
+private:
+    std::vector<MeshModelQueryContext*> m_FreeContext;
+    ParallelMutex m_Mutex;
+
+public:
+    // Constructor, a copy starts empty
+    MeshModelQueryContextPool();
+    MeshModelQueryContextPool(const MeshModelQueryContextPool&);
+
+    // Destructor
+    ~MeshModelQueryContextPool();
+
+    MeshModelQueryContextPool& operator=(const MeshModelQueryContextPool&) { return *this; }
+
+    MeshModelQueryContext* Acquire();
+    void Release(MeshModelQueryContext* pContext);
+};
+
+// Holds a context of a pool for the scope's lifetime
+class MeshModelPooledQueryContext
+{
+private:
+    MeshModelQueryContextPool& m_Pool;
+    MeshModelQueryContext* m_pContext;
+
+public:
+    MeshModelPooledQueryContext(MeshModelQueryContextPool& pool) : m_Pool(pool), m_pContext(pool.Acquire()) {}
+    ~MeshModelPooledQueryContext() { m_Pool.Release(m_pContext); }
+
+    MeshModelQueryContext& Get() { return *m_pContext; }
+
+private:
+    MeshModelPooledQueryContext(const MeshModelPooledQueryContext&);
+    MeshModelPooledQueryContext& operator=(const MeshModelPooledQueryContext&);
+};
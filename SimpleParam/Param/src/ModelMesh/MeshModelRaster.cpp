@@ -0,0 +1,647 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelRaster.cpp
+//
+// [Goal]
+// A software rasterizer rendering a mesh model into an image without OpenGL
+
+
+
+#include "MeshModelRaster.h"
+#include "../Common/Parallel.h"
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+
+
+
+#define RASTER_TILE_SIZE        32
+#define RASTER_AMBIENT          0.2
+#define RASTER_TEX_LINE_WIDTH   0.04    // iso-line half width, in texture cells
+#define RASTER_OVERLAY_BIAS     0.005   // relative depth by which overlays may be behind the surface
+
+namespace
+{
+    inline double EdgeFunction(const Coord& a, const Coord& b, double x, double y)
+    {
+        return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+    }
+
+    inline void PutPixel(std::vector<unsigned char>& image, size_t pixel, const Color& c)
+    {
+        for(int i = 0; i < 3; ++ i)
+        {
+            double v = std::min(1.0, std::max(0.0, c[i]));
+            image[pixel * 3 + i] = (unsigned char)(v * 255.0 + 0.5);
+        }
+    }
+
+    // Project the vertices of the model
+    class ProjectFunctor
+    {
+    public:
+        ProjectFunctor(const MeshModelRaster& raster, const CoordArray& coord, CoordArray& screen)
+            : m_Raster(raster), m_Coord(coord), m_Screen(screen) {}
+
+        void operator()(int i) const
+        {
+            if(!m_Raster.Project(m_Coord[i], m_Screen[i]))
+                m_Screen[i] = Coord(0.0, 0.0, -1.0);
+        }
+
+    private:
+        const MeshModelRaster& m_Raster;
+        const CoordArray& m_Coord;
+        CoordArray& m_Screen;
+    };
+
+    // PNG chunk and zlib checksums
+    unsigned int Crc32(const unsigned char* data, size_t size, unsigned int crc)
+    {
+        static unsigned int table[256];
+        static bool initialized = false;
+        if(!initialized)
+        {
+            for(unsigned int n = 0; n < 256; ++ n)
+            {
+                unsigned int c = n;
+                for(int k = 0; k < 8; ++ k)
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                table[n] = c;
+            }
+            initialized = true;
+        }
+        crc = ~crc;
+        for(size_t i = 0; i < size; ++ i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void AppendUInt32(std::vector<unsigned char>& buffer, unsigned int v)
+    {
+        buffer.push_back((unsigned char)(v >> 24));
+        buffer.push_back((unsigned char)(v >> 16));
+        buffer.push_back((unsigned char)(v >> 8));
+        buffer.push_back((unsigned char)v);
+    }
+
+    void WritePNGChunk(FILE* fp, const char* type, const std::vector<unsigned char>& data)
+    {
+        std::vector<unsigned char> chunk;
+        AppendUInt32(chunk, (unsigned int)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        AppendUInt32(chunk, Crc32(&chunk[4], chunk.size() - 4, 0));
+        fwrite(&chunk[0], 1, chunk.size(), fp);
+    }
+}
+
+
+
+/* ================== Tile Rasterization ================== */
+
+class MeshModelRaster::TileFunctor
+{
+public:
+    TileFunctor(MeshModelRaster& raster, MeshModelKernel& kernel)
+        : m_Raster(raster),
+          m_VertexColor(kernel.GetVertexInfo().GetColor()),
+          m_FaceColor(kernel.GetFaceInfo().GetColor()),
+          m_FaceTexCoord(kernel.GetFaceInfo().GetTexCoord()),
+          m_FaceInfo(kernel.GetFaceInfo())
+    {
+        // Fall back to the solid color when the shading data is missing
+        m_ShadeMode = raster.m_ShadeMode;
+        if(m_ShadeMode == RASTER_SHADE_VERTEX_COLOR && m_VertexColor.size() != raster.m_Screen.size())
+            m_ShadeMode = RASTER_SHADE_SOLID;
+        if(m_ShadeMode == RASTER_SHADE_FACE_COLOR && m_FaceColor.size() != (size_t)m_FaceInfo.GetFaceNum())
+            m_ShadeMode = RASTER_SHADE_SOLID;
+        if((m_ShadeMode == RASTER_SHADE_TEX_CHECKER || m_ShadeMode == RASTER_SHADE_TEX_LINES)
+            && m_FaceTexCoord.size() != (size_t)m_FaceInfo.GetFaceNum())
+            m_ShadeMode = RASTER_SHADE_SOLID;
+    }
+
+    void operator()(int tile) const
+    {
+        MeshModelRaster& r = m_Raster;
+        int x0 = (tile % r.m_TileNumX) * RASTER_TILE_SIZE;
+        int y0 = (tile / r.m_TileNumX) * RASTER_TILE_SIZE;
+        int x1 = std::min(r.m_Width, x0 + RASTER_TILE_SIZE);
+        int y1 = std::min(r.m_Height, y0 + RASTER_TILE_SIZE);
+
+        for(int y = y0; y < y1; ++ y)
+        {
+            for(int x = x0; x < x1; ++ x)
+            {
+                size_t pixel = (size_t)y * r.m_Width + x;
+                PutPixel(r.m_Image, pixel, r.m_BackColor);
+                r.m_Depth[pixel] = std::numeric_limits<float>::max();
+            }
+        }
+
+        for(int i = r.m_TileTriOffset[tile]; i < r.m_TileTriOffset[tile + 1]; ++ i)
+            DrawTriangle(r.m_Tri[r.m_TileTri[i]], x0, y0, x1, y1);
+        for(int i = r.m_TileSegOffset[tile]; i < r.m_TileSegOffset[tile + 1]; ++ i)
+            DrawSegment(r.m_TileSeg[i], x0, y0, x1, y1);
+    }
+
+private:
+    void DrawTriangle(const RasterTri& tri, int x0, int y0, int x1, int y1) const
+    {
+        MeshModelRaster& r = m_Raster;
+        const int* face = m_FaceInfo.GetFaceVertices(tri.face);
+        const Coord& a = r.m_Screen[face[tri.corner[0]]];
+        const Coord& b = r.m_Screen[face[tri.corner[1]]];
+        const Coord& c = r.m_Screen[face[tri.corner[2]]];
+
+        double area = EdgeFunction(a, b, c[0], c[1]);
+        int xmin = std::max(x0, (int)floor(std::min(a[0], std::min(b[0], c[0]))));
+        int xmax = std::min(x1 - 1, (int)ceil(std::max(a[0], std::max(b[0], c[0]))));
+        int ymin = std::max(y0, (int)floor(std::min(a[1], std::min(b[1], c[1]))));
+        int ymax = std::min(y1 - 1, (int)ceil(std::max(a[1], std::max(b[1], c[1]))));
+
+        for(int y = ymin; y <= ymax; ++ y)
+        {
+            for(int x = xmin; x <= xmax; ++ x)
+            {
+                double px = x + 0.5, py = y + 0.5;
+                double w0 = EdgeFunction(b, c, px, py) / area;
+                double w1 = EdgeFunction(c, a, px, py) / area;
+                double w2 = 1.0 - w0 - w1;
+                if(w0 < 0.0 || w1 < 0.0 || w2 < 0.0)
+                    continue;
+
+                // Perspective correct weights
+                double inv_z = w0 / a[2] + w1 / b[2] + w2 / c[2];
+                double z = 1.0 / inv_z;
+                size_t pixel = (size_t)y * r.m_Width + x;
+                if(z >= r.m_Depth[pixel])
+                    continue;
+                double w[3] = {w0 / a[2] * z, w1 / b[2] * z, w2 / c[2] * z};
+
+                r.m_Depth[pixel] = (float)z;
+                PutPixel(r.m_Image, pixel, Shade(tri, w));
+            }
+        }
+    }
+
+    Color Shade(const RasterTri& tri, const double w[3]) const
+    {
+        MeshModelRaster& r = m_Raster;
+        const int* face = m_FaceInfo.GetFaceVertices(tri.face);
+
+        switch(m_ShadeMode)
+        {
+        case RASTER_SHADE_VERTEX_COLOR:
+            return m_VertexColor[face[tri.corner[0]]] * w[0] + m_VertexColor[face[tri.corner[1]]] * w[1]
+                + m_VertexColor[face[tri.corner[2]]] * w[2];
+        case RASTER_SHADE_FACE_COLOR:
+            return m_FaceColor[tri.face];
+        case RASTER_SHADE_TEX_CHECKER:
+        case RASTER_SHADE_TEX_LINES:
+            {
+                const TexCoordArray& tex = m_FaceTexCoord[tri.face];
+                double s = 0.0, t = 0.0;
+                for(int i = 0; i < 3; ++ i)
+                {
+                    s += tex[tri.corner[i]][0] * w[i];
+                    t += tex[tri.corner[i]][1] * w[i];
+                }
+                s *= r.m_TexScale;
+                t *= r.m_TexScale;
+                double fs = floor(s), ft = floor(t);
+                int cell;
+                if(m_ShadeMode == RASTER_SHADE_TEX_CHECKER)
+                    cell = ((int)fs + (int)ft) & 1;
+                else
+                {
+                    double ds = std::min(s - fs, fs + 1.0 - s);
+                    double dt = std::min(t - ft, ft + 1.0 - t);
+                    cell = (std::min(ds, dt) < RASTER_TEX_LINE_WIDTH) ? 1 : 0;
+                }
+                return r.m_TexColor[cell] * tri.shade;
+            }
+        default:
+            return r.m_SolidColor * tri.shade;
+        }
+    }
+
+    void DrawSegment(int seg, int x0, int y0, int x1, int y1) const
+    {
+        MeshModelRaster& r = m_Raster;
+        const Coord& a = r.m_SegmentScreen[2 * seg];
+        const Coord& b = r.m_SegmentScreen[2 * seg + 1];
+        const Color& color = r.m_SegmentColor[seg];
+        double half = 0.5 * r.m_LineWidth;
+
+        int xmin = std::max(x0, (int)floor(std::min(a[0], b[0]) - half));
+        int xmax = std::min(x1 - 1, (int)ceil(std::max(a[0], b[0]) + half));
+        int ymin = std::max(y0, (int)floor(std::min(a[1], b[1]) - half));
+        int ymax = std::min(y1 - 1, (int)ceil(std::max(a[1], b[1]) + half));
+
+        double dx = b[0] - a[0], dy = b[1] - a[1];
+        double len2 = dx * dx + dy * dy;
+        for(int y = ymin; y <= ymax; ++ y)
+        {
+            for(int x = xmin; x <= xmax; ++ x)
+            {
+                double px = x + 0.5, py = y + 0.5;
+                double u = 0.0;
+                if(len2 > 0.0)
+                    u = std::min(1.0, std::max(0.0, ((px - a[0]) * dx + (py - a[1]) * dy) / len2));
+                double ex = a[0] + u * dx - px, ey = a[1] + u * dy - py;
+                if(ex * ex + ey * ey > half * half)
+                    continue;
+
+                double z = 1.0 / ((1.0 - u) / a[2] + u / b[2]);
+                size_t pixel = (size_t)y * r.m_Width + x;
+                if(z * (1.0 - RASTER_OVERLAY_BIAS) > r.m_Depth[pixel])
+                    continue;
+                PutPixel(r.m_Image, pixel, color);
+            }
+        }
+    }
+
+private:
+    MeshModelRaster& m_Raster;
+    const ColorArray& m_VertexColor;
+    const ColorArray& m_FaceColor;
+    const PolyTexCoordArray& m_FaceTexCoord;
+    const FaceInfo& m_FaceInfo;
+    int m_ShadeMode;
+};
+
+
+
+/* ================== Mesh Model Raster ================== */
+
+// Constructor
+MeshModelRaster::MeshModelRaster()
+{
+    m_Width = m_Height = 0;
+    m_TileNumX = m_TileNumY = 0;
+    m_Fovy = 30.0;
+    SetImageSize(640, 480);
+    SetCamera(Coord(0.0, 0.0, 3.0), Coord(0.0, 0.0, 0.0), Coord(0.0, 1.0, 0.0));
+
+    m_ShadeMode = RASTER_SHADE_SOLID;
+    m_BackColor = Color(1.0, 1.0, 1.0);
+    m_SolidColor = Color(0.7, 0.7, 0.7);
+    m_TexColor[0] = Color(0.95, 0.95, 0.95);
+    m_TexColor[1] = Color(0.25, 0.25, 0.25);
+    m_TexScale = 10.0;
+    m_LineWidth = 2.0f;
+}
+
+// Destructor
+MeshModelRaster::~MeshModelRaster()
+{
+
+}
+
+// Image
+void MeshModelRaster::SetImageSize(int width, int height)
+{
+    assert(width > 0 && height > 0);
+    m_Width = width;
+    m_Height = height;
+    m_Focal = 0.5 * m_Height / tan(0.5 * m_Fovy * PI / 180.0);
+    m_Image.assign((size_t)width * height * 3, 0);
+    m_Depth.assign((size_t)width * height, std::numeric_limits<float>::max());
+}
+
+// Camera
+void MeshModelRaster::SetCamera(const Coord& eye, const Coord& center, const Coord& up, double fovy)
+{
+    m_Eye = eye;
+    m_Forward = (center - eye).unit();
+    m_Right = cross(m_Forward, up).unit();
+    m_Up = cross(m_Right, m_Forward);
+    m_Fovy = fovy;
+    m_Focal = 0.5 * m_Height / tan(0.5 * m_Fovy * PI / 180.0);
+    m_Near = 1e-6 * (center - eye).abs();
+}
+
+void MeshModelRaster::FitCamera(MeshModelKernel& kernel, const Coord& view_dir, const Coord& up, double fovy)
+{
+    Coord center;
+    double radius;
+    kernel.GetModelInfo().GetBoundingSphere(center, radius);
+
+    // The sphere fits the smaller of the two fields of view
+    double half = 0.5 * fovy * PI / 180.0;
+    if(m_Width < m_Height)
+        half = atan(tan(half) * m_Width / m_Height);
+    double dist = 1.05 * radius / sin(half);
+    SetCamera(center - view_dir.unit() * dist, center, up, fovy);
+}
+
+bool MeshModelRaster::Project(const Coord& pos, Coord& screen) const
+{
+    Coord d = pos - m_Eye;
+    double z = dot(d, m_Forward);
+    if(z <= m_Near)
+        return false;
+    screen = Coord(0.5 * m_Width + dot(d, m_Right) / z * m_Focal, 0.5 * m_Height - dot(d, m_Up) / z * m_Focal, z);
+    return true;
+}
+
+// Overlays
+void MeshModelRaster::ClearOverlay()
+{
+    m_SegmentCoord.clear();
+    m_SegmentColor.clear();
+    m_PointCoord.clear();
+    m_PointColor.clear();
+    m_PointRadius.clear();
+}
+
+void MeshModelRaster::AddLineStrip(const CoordArray& strip, const Color& color)
+{
+    for(size_t i = 1; i < strip.size(); ++ i)
+    {
+        m_SegmentCoord.push_back(strip[i - 1]);
+        m_SegmentCoord.push_back(strip[i]);
+        m_SegmentColor.push_back(color);
+    }
+}
+
+void MeshModelRaster::AddPoint(const Coord& pos, const Color& color, float radius)
+{
+    m_PointCoord.push_back(pos);
+    m_PointColor.push_back(color);
+    m_PointRadius.push_back(radius);
+}
+
+// Render
+void MeshModelRaster::Render(MeshModelKernel& kernel)
+{
+    m_TileNumX = (m_Width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    m_TileNumY = (m_Height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+
+    SetupTriangles(kernel);
+    SetupSegments();
+
+    parallel_for(0, m_TileNumX * m_TileNumY, TileFunctor(*this, kernel), 1);
+
+    DrawPoints();
+}
+
+void MeshModelRaster::SetupTriangles(MeshModelKernel& kernel)
+{
+    const CoordArray& vCoord = kernel.GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel.GetFaceInfo();
+    size_t nFace = fInfo.GetFaceNum();
+
+    m_Screen.resize(vCoord.size());
+    parallel_for(0, (int)vCoord.size(), ProjectFunctor(*this, vCoord, m_Screen));
+
+    // Polygons are split into fans, a triangle with a vertex behind the camera is dropped
+    std::vector<double> box;
+    m_Tri.clear();
+    for(size_t i = 0; i < nFace; ++ i)
+    {
+        const int* face = fInfo.GetFaceVertices(i);
+        for(size_t j = 1; j + 1 < (size_t)fInfo.GetFaceDegree(i); ++ j)
+        {
+            RasterTri tri;
+            tri.face = (int)i;
+            tri.corner[0] = 0;
+            tri.corner[1] = (int)j;
+            tri.corner[2] = (int)j + 1;
+
+            const Coord& a = m_Screen[face[0]];
+            const Coord& b = m_Screen[face[j]];
+            const Coord& c = m_Screen[face[j + 1]];
+            if(a[2] < 0.0 || b[2] < 0.0 || c[2] < 0.0)
+                continue;
+            if(EdgeFunction(a, b, c[0], c[1]) == 0.0)
+                continue;
+
+            // Headlight from the eye
+            const Coord& p0 = vCoord[face[0]];
+            Coord n = cross(vCoord[face[j]] - p0, vCoord[face[j + 1]] - p0);
+            Coord v = m_Eye - (p0 + vCoord[face[j]] + vCoord[face[j + 1]]) / 3.0;
+            double len = n.abs() * v.abs();
+            double diffuse = (len > 0.0) ? fabs(dot(n, v)) / len : 0.0;
+            tri.shade = (float)(RASTER_AMBIENT + (1.0 - RASTER_AMBIENT) * diffuse);
+
+            m_Tri.push_back(tri);
+            box.push_back(std::min(a[0], std::min(b[0], c[0])));
+            box.push_back(std::max(a[0], std::max(b[0], c[0])));
+            box.push_back(std::min(a[1], std::min(b[1], c[1])));
+            box.push_back(std::max(a[1], std::max(b[1], c[1])));
+        }
+    }
+    BinToTiles(box, m_TileTriOffset, m_TileTri);
+}
+
+void MeshModelRaster::SetupSegments()
+{
+    size_t nSegment = m_SegmentColor.size();
+    double half = 0.5 * m_LineWidth + 1.0;
+
+    // A segment with an end point behind the camera gets an empty box
+    std::vector<double> box(nSegment * 4, -1.0);
+    m_SegmentScreen.resize(nSegment * 2);
+    for(size_t i = 0; i < nSegment; ++ i)
+    {
+        Coord& a = m_SegmentScreen[2 * i];
+        Coord& b = m_SegmentScreen[2 * i + 1];
+        if(!Project(m_SegmentCoord[2 * i], a) || !Project(m_SegmentCoord[2 * i + 1], b))
+            continue;
+        box[4 * i] = std::min(a[0], b[0]) - half;
+        box[4 * i + 1] = std::max(a[0], b[0]) + half;
+        box[4 * i + 2] = std::min(a[1], b[1]) - half;
+        box[4 * i + 3] = std::max(a[1], b[1]) + half;
+    }
+    BinToTiles(box, m_TileSegOffset, m_TileSeg);
+}
+
+void MeshModelRaster::BinToTiles(const std::vector<double>& box, IndexArray& offset, IndexArray& index) const
+{
+    int nTile = m_TileNumX * m_TileNumY;
+    int nPrim = (int)box.size() / 4;
+
+    // Tile range of each primitive, empty when it is out of the image
+    std::vector<int> range(nPrim * 4);
+    offset.assign(nTile + 1, 0);
+    for(int i = 0; i < nPrim; ++ i)
+    {
+        const double* b = &box[4 * i];
+        int* t = &range[4 * i];
+        if(b[1] < 0.0 || b[0] >= m_Width || b[3] < 0.0 || b[2] >= m_Height || b[1] < b[0])
+        {
+            t[0] = t[2] = 0;
+            t[1] = t[3] = -1;
+            continue;
+        }
+        t[0] = std::max(0, (int)b[0]) / RASTER_TILE_SIZE;
+        t[1] = std::min(m_Width - 1, (int)b[1]) / RASTER_TILE_SIZE;
+        t[2] = std::max(0, (int)b[2]) / RASTER_TILE_SIZE;
+        t[3] = std::min(m_Height - 1, (int)b[3]) / RASTER_TILE_SIZE;
+        for(int ty = t[2]; ty <= t[3]; ++ ty)
+            for(int tx = t[0]; tx <= t[1]; ++ tx)
+                ++ offset[ty * m_TileNumX + tx + 1];
+    }
+    for(int i = 1; i <= nTile; ++ i)
+        offset[i] += offset[i - 1];
+
+    index.resize(offset[nTile]);
+    IndexArray pos(offset.begin(), offset.end() - 1);
+    for(int i = 0; i < nPrim; ++ i)
+    {
+        const int* t = &range[4 * i];
+        for(int ty = t[2]; ty <= t[3]; ++ ty)
+            for(int tx = t[0]; tx <= t[1]; ++ tx)
+                index[pos[ty * m_TileNumX + tx] ++] = i;
+    }
+}
+
+void MeshModelRaster::DrawPoints()
+{
+    // A point is drawn as a disc when its center is not hidden
+    for(size_t i = 0; i < m_PointCoord.size(); ++ i)
+    {
+        Coord p;
+        if(!Project(m_PointCoord[i], p))
+            continue;
+        int cx = (int)floor(p[0]), cy = (int)floor(p[1]);
+        if(cx < 0 || cx >= m_Width || cy < 0 || cy >= m_Height)
+            continue;
+        if(p[2] * (1.0 - RASTER_OVERLAY_BIAS) > m_Depth[(size_t)cy * m_Width + cx])
+            continue;
+
+        double radius = m_PointRadius[i];
+        int xmin = std::max(0, (int)floor(p[0] - radius)), xmax = std::min(m_Width - 1, (int)ceil(p[0] + radius));
+        int ymin = std::max(0, (int)floor(p[1] - radius)), ymax = std::min(m_Height - 1, (int)ceil(p[1] + radius));
+        for(int y = ymin; y <= ymax; ++ y)
+        {
+            for(int x = xmin; x <= xmax; ++ x)
+            {
+                double dx = x + 0.5 - p[0], dy = y + 0.5 - p[1];
+                if(dx * dx + dy * dy <= radius * radius)
+                    PutPixel(m_Image, (size_t)y * m_Width + x, m_PointColor[i]);
+            }
+        }
+    }
+}
+
+// Output
+bool MeshModelRaster::SavePPM(const std::string& file_name) const
+{
+    FILE* fp = fopen(file_name.c_str(), "wb");
+    if(fp == NULL)
+        return false;
+    fprintf(fp, "P6\n%d %d\n255\n", m_Width, m_Height);
+    size_t size = fwrite(&m_Image[0], 1, m_Image.size(), fp);
+    fclose(fp);
+    return size == m_Image.size();
+}
+
+bool MeshModelRaster::SavePNG(const std::string& file_name) const
+{
+    FILE* fp = fopen(file_name.c_str(), "wb");
+    if(fp == NULL)
+        return false;
+
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    fwrite(signature, 1, 8, fp);
+
+    std::vector<unsigned char> header;
+    AppendUInt32(header, m_Width);
+    AppendUInt32(header, m_Height);
+    header.push_back(8);    // bit depth
+    header.push_back(2);    // RGB
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    WritePNGChunk(fp, "IHDR", header);
+
+    // Rows with filter type 0, kept in stored (uncompressed) deflate blocks
+    size_t row = (size_t)m_Width * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((row + 1) * m_Height);
+    for(int y = 0; y < m_Height; ++ y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), m_Image.begin() + y * row, m_Image.begin() + (y + 1) * row);
+    }
+
+    std::vector<unsigned char> zdata;
+    zdata.push_back(0x78);
+    zdata.push_back(0x01);
+    for(size_t pos = 0; pos < raw.size(); pos += 65535)
+    {
+        size_t len = std::min((size_t)65535, raw.size() - pos);
+        zdata.push_back(pos + len == raw.size() ? 1 : 0);
+        zdata.push_back((unsigned char)len);
+        zdata.push_back((unsigned char)(len >> 8));
+        zdata.push_back((unsigned char)~len);
+        zdata.push_back((unsigned char)(~len >> 8));
+        zdata.insert(zdata.end(), raw.begin() + pos, raw.begin() + pos + len);
+    }
+    unsigned int s1 = 1, s2 = 0;
+    for(size_t i = 0; i < raw.size(); ++ i)
+    {
+        s1 = (s1 + raw[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    AppendUInt32(zdata, (s2 << 16) | s1);
+    WritePNGChunk(fp, "IDAT", zdata);
+    WritePNGChunk(fp, "IEND", std::vector<unsigned char>());
+
+    bool ok = (ferror(fp) == 0);
+    fclose(fp);
+    return ok;
+}
+
+bool MeshModelRaster::SaveImage(const std::string& file_name) const
+{
+    std::string ext;
+    size_t dot_pos = file_name.rfind('.');
+    if(dot_pos != std::string::npos)
+        ext = file_name.substr(dot_pos);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if(ext == ".png")
+        return SavePNG(file_name);
+    return SavePPM(file_name);
+}
+
+void MeshModelRaster::ScalarToColor(const std::vector<double>& value, ColorArray& color)
+{
+    color.resize(value.size());
+    if(value.empty())
+        return;
+
+    double vmin = *std::min_element(value.begin(), value.end());
+    double vmax = *std::max_element(value.begin(), value.end());
+    double range = vmax - vmin;
+    for(size_t i = 0; i < value.size(); ++ i)
+    {
+        double t = (range > 0.0) ? (value[i] - vmin) / range : 0.0;
+        if(t < 0.5)
+            color[i] = Color(0.0, 2.0 * t, 1.0 - 2.0 * t);
+        else
+            color[i] = Color(2.0 * t - 1.0, 2.0 - 2.0 * t, 0.0);
+    }
+}
@@ -0,0 +1,156 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelRaster.h
+//
+// [Goal]
+// A software rasterizer rendering a mesh model into an image without OpenGL
+// Supporting solid, vertex color, face color and (s,t) texture shading,
+// line and point overlays, and PPM/PNG output
+//
+// The image is cut into square tiles, the triangles and the overlay lines
+// are binned to the tiles they cover and the tiles are rasterized in
+// parallel. Each tile draws its primitives in their input order, so the
+// image does not depend on the thread number. Overlay points are few and
+// drawn afterwards
+
+
+
+#include "MeshModelKernel.h"
+#include <string>
+#pragma once
+
+
+
+/* ================== Raster Shade Modes ================== */
+
+#define RASTER_SHADE_SOLID          0X00000001      // Lit default color
+#define RASTER_SHADE_VERTEX_COLOR   0X00000002      // Vertex color array, interpolated
+#define RASTER_SHADE_FACE_COLOR     0X00000003      // Face color array
+#define RASTER_SHADE_TEX_CHECKER    0X00000004      // Checkerboard of the face texture coordinates
+#define RASTER_SHADE_TEX_LINES      0X00000005      // Iso-lines of the face texture coordinates
+
+
+
+/* ================== Mesh Model Raster ================== */
+
+class MeshModelRaster
+{
+private:
+    class TileFunctor;
+
+    // A triangle of the model, polygons are split into fans
+    class RasterTri
+    {
+    public:
+        int face;
+        int corner[3];  // corner index in the face, for texture coordinates
+        float shade;    // headlight intensity
+    };
+
+    int m_Width;
+    int m_Height;
+
+    // Camera frame, looking along m_Forward
+    Coord m_Eye;
+    Coord m_Right;
+    Coord m_Up;
+    Coord m_Forward;
+    double m_Fovy;
+    double m_Focal;     // focal length in pixels
+    double m_Near;
+
+    int   m_ShadeMode;
+    Color m_BackColor;
+    Color m_SolidColor;
+    Color m_TexColor[2];    // checker cells or background/iso-line colors
+    double m_TexScale;      // texture cells per unit (s,t)
+    float m_LineWidth;      // overlay line width in pixels
+
+    // Overlays
+    CoordArray m_SegmentCoord;  // two end points per segment
+    ColorArray m_SegmentColor;
+    CoordArray m_PointCoord;
+    ColorArray m_PointColor;
+    std::vector<float> m_PointRadius;   // in pixels
+
+    // Frame buffers, rows from top to bottom
+    std::vector<unsigned char> m_Image;     // RGB
+    std::vector<float> m_Depth;
+
+    // Per frame data
+    CoordArray m_Screen;                    // (x, y, depth) of each vertex
+    std::vector<RasterTri> m_Tri;
+    IndexArray m_TileTriOffset, m_TileTri;  // triangles of each tile
+    IndexArray m_TileSegOffset, m_TileSeg;  // overlay segments of each tile
+    CoordArray m_SegmentScreen;
+    int m_TileNumX;
+    int m_TileNumY;
+
+public:
+    // Constructor
+    MeshModelRaster();
+
+    // Destructor
+    ~MeshModelRaster();
+
+    // Image
+    void SetImageSize(int width, int height);
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    const std::vector<unsigned char>& GetImage() const { return m_Image; }
+
+    // Camera, fovy in degree
+    void SetCamera(const Coord& eye, const Coord& center, const Coord& up, double fovy = 30.0);
+    // Look at the model's bounding sphere along view_dir
+    void FitCamera(MeshModelKernel& kernel, const Coord& view_dir, const Coord& up, double fovy = 30.0);
+
+    // Shading
+    int& ShadeMode() { return m_ShadeMode; }
+    void SetBackColor(const Color& color) { m_BackColor = color; }
+    void SetSolidColor(const Color& color) { m_SolidColor = color; }
+    void SetTexColor(const Color& color0, const Color& color1) { m_TexColor[0] = color0; m_TexColor[1] = color1; }
+    void SetTexScale(double scale) { m_TexScale = scale; }
+    void SetLineWidth(float width) { m_LineWidth = width; }
+
+    // Overlays, drawn over the model where they are not hidden by it
+    void ClearOverlay();
+    void AddLineStrip(const CoordArray& strip, const Color& color);
+    void AddPoint(const Coord& pos, const Color& color, float radius = 4.0f);
+
+    // Render the model with the overlays
+    void Render(MeshModelKernel& kernel);
+
+    // Output
+    bool SavePPM(const std::string& file_name) const;
+    bool SavePNG(const std::string& file_name) const;
+    // Choose the format by the file extension, ".ppm" or ".png"
+    bool SaveImage(const std::string& file_name) const;
+
+    // Project a point to (x, y, depth) in pixels, false when it is behind the camera
+    bool Project(const Coord& pos, Coord& screen) const;
+
+    // Map scalars to a blue-green-red heat color, the range is [min, max] of the values
+    static void ScalarToColor(const std::vector<double>& value, ColorArray& color);
+
+private:
+    void SetupTriangles(MeshModelKernel& kernel);
+    void SetupSegments();
+    void DrawPoints();
+    void BinToTiles(const std::vector<double>& box, IndexArray& offset, IndexArray& index) const;
+};
@@ -111,6 +111,7 @@ void MeshModelRender::AttachKernel(MeshModelKernel* pKernel)
 {
     assert(pKernel != NULL);
     kernel = pKernel;
+    m_Buffer.AttachKernel(pKernel);
 
     ClearData();
 }
@@ -229,18 +230,7 @@ void MeshModelRender::DrawModelVertices()
     glColor3d(c[0], c[1], c[2]);
     glPointSize(m_DftVtxSize);
 
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    FlagArray& vFlag = kernel->GetVertexInfo().GetFlag();
-    size_t nVertex = vCoord.size();
-    glBegin(GL_POINTS);
-    for(size_t i = 0; i < nVertex; ++ i)
-    {
-        if(util.IsSetFlag(vFlag[i], FLAG_INVALID))
-            continue;
-        Coord& v = vCoord[i];
-        glVertex3d(v[0], v[1], v[2]);
-    }
-    glEnd();
+    m_Buffer.DrawVertices();
     
     glDepthFunc(GL_LESS);
     glEnable(GL_LIGHTING);
@@ -257,30 +247,10 @@ void MeshModelRender::DrawModelWireframe()
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
     glLineWidth(m_DftEdgeWidth);
     
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
-    
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
-    
     Color c = BLUE*0.70;
     glColor3d(c[0], c[1], c[2]);
     
-    glBegin(GL_LINES);
-    for(i = 0; i < nFace; ++ i)
-    {
-        IndexArray& f = fIndex[i];
-        n = f.size();
-        for(j = 0; j < n; ++ j)
-        {
-            Coord& v1 = vCoord[f[j]];
-            Coord& v2 = vCoord[f[(j+1)%n]];
-            glVertex3d(v1[0], v1[1], v1[2]);
-            glVertex3d(v2[0], v2[1], v2[2]);
-        }
-    }
-    glEnd();
+    m_Buffer.DrawEdges();
     
     glHint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
     glDisable(GL_BLEND);
@@ -296,56 +266,9 @@ void MeshModelRender::DrawModelSolidFlat()
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(2.0, 2.0);
 	
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-    NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
+    // Face normals are kept per corner
+    m_Buffer.DrawCornerFaces(RENDER_ARRAY_NORMAL);
 
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
-
-    if(!kernel->GetModelInfo().IsGeneralMesh())
-    {
-        if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-            glBegin(GL_TRIANGLES);
-        else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-            glBegin(GL_QUADS);
-        else
-            return;
-
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID& vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = fNormal[i];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-        }
-        glEnd();
-    }
-
-    else    // General polygonal mesh
-    {
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            glBegin(GL_POLYGON);
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = fNormal[i];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-            glEnd();
-        }
-    }
     glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
@@ -372,53 +295,17 @@ void MeshModelRender::DrawModelFaceTexture()
 	glDepthFunc(GL_LEQUAL);
 	//glShadeModel(GL_SMOOTH);
 
-	CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-	TexCoordArray& vTexCoord = kernel->GetVertexInfo().GetTexCoord();
 	PolyTexCoordArray& fTexCoord = kernel->GetFaceInfo().GetTexCoord();
-	NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-	PolyIndexArray& ftIndex = kernel->GetFaceInfo().GetTexIndex();
 
 	if(fTexCoord.size() ==0) return;
 
-	size_t nFace = fIndex.size();
-	size_t i, j, n;
-
 	// set texture env here.
 	glEnable(GL_TEXTURE_2D);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 	//glBindTexture(GL_TEXTURE_1D, texName);
 
-	if(!kernel->GetModelInfo().IsGeneralMesh())
-	{
-		if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-			glBegin(GL_TRIANGLES);
-		else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-			glBegin(GL_QUADS);
-		else
-			return;
-
-		for(i = 0; i < nFace; ++ i)
-		{
-			IndexArray& face = fIndex[i];
-			IndexArray& tex_index = ftIndex[i];
-			TexCoordArray& f_tex = fTexCoord[i];
-			Normal& fn = fNormal[i];
-
-			n = face.size();
-			for(j = 0; j < n; ++ j)
-			{
-				VertexID& vID = face[j];
-				Coord& v = vCoord[vID];
-				const TexCoord& tex = vTexCoord[tex_index[j]];
-				glNormal3d(fn[0], fn[1], fn[2]);
-				glTexCoord2d(tex[0], tex[1]);
-				//glTexCoord2d(f_tex[j][0], f_tex[j][1]);
-				glVertex3d(v[0], v[1], v[2]);
-			}
-		}
-		glEnd();
-	}
+	// Texture coordinates are indexed per face corner
+	m_Buffer.DrawCornerFaces(RENDER_ARRAY_NORMAL | RENDER_ARRAY_TEXCOORD);
 
 	glDisable(GL_TEXTURE_2D);
 	glDisable(GL_POLYGON_OFFSET_FILL);
@@ -432,56 +319,8 @@ void MeshModelRender::DrawModelSolidSmooth()
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(2.0, 2.0);
 	
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
+    m_Buffer.DrawVertexFaces(RENDER_ARRAY_NORMAL);
 
-    if(!kernel->GetModelInfo().IsGeneralMesh())
-    {
-        if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-            glBegin(GL_TRIANGLES);
-        else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-            glBegin(GL_QUADS);
-        else
-            return;
-
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID& vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-        }
-        glEnd();
-    }
-
-    else    // General polygonal mesh
-    {
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            glBegin(GL_POLYGON);
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-            glEnd();
-        }
-    }
     glDisable(GL_POLYGON_OFFSET_FILL);
     glDisable(GL_POLYGON_SMOOTH);
 }
@@ -498,56 +337,8 @@ void MeshModelRender::DrawModelSolidAndWireframe()
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	glPolygonOffset(2.0, 2.0);
 	
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
-
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
+    m_Buffer.DrawVertexFaces(RENDER_ARRAY_NORMAL);
 
-    if(!kernel->GetModelInfo().IsGeneralMesh())
-    {
-        if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-            glBegin(GL_TRIANGLES);
-        else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-            glBegin(GL_QUADS);
-        else
-            return;
-
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID& vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-        }
-        glEnd();
-    }
-
-    else    // General polygonal mesh
-    {
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            glBegin(GL_POLYGON);
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-            glEnd();
-        }
-    }
     glDisable(GL_POLYGON_OFFSET_FILL);
     glDisable(GL_POLYGON_SMOOTH);
 
@@ -564,20 +355,7 @@ void MeshModelRender::DrawModelSolidAndWireframe()
     Color c = BLUE*0.70;
     glColor3d(c[0], c[1], c[2]);
 
-    glBegin(GL_LINES);
-    for(i = 0; i < nFace; ++ i)
-    {
-        IndexArray& f = fIndex[i];
-        n = f.size();
-        for(j = 0; j < n; ++ j)
-        {
-            Coord& v1 = vCoord[f[j]];
-            Coord& v2 = vCoord[f[(j+1)%n]];
-            glVertex3d(v1[0], v1[1], v1[2]);
-            glVertex3d(v2[0], v2[1], v2[2]);
-        }
-    }
-    glEnd();
+    m_Buffer.DrawEdges();
 
     glHint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
     glDisable(GL_BLEND);
@@ -593,10 +371,7 @@ void MeshModelRender::DrawModelHighlightOnly()
 
 void MeshModelRender::DrawModelTextureMapping()
 {
-	CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
 	TexCoordArray& tCoord = kernel->GetVertexInfo().GetTexCoord();
-	NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
-	PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
 
 	if (tCoord.empty())
 	{
@@ -609,60 +384,13 @@ void MeshModelRender::DrawModelTextureMapping()
 	glPolygonOffset(2.0, 2.0);
 	glDepthFunc(GL_LEQUAL);
 	//glShadeModel(GL_SMOOTH);
-	size_t nFace = fIndex.size();
-	size_t i, j, n;
 
 	// set texture env here.
 	glEnable(GL_TEXTURE_2D);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 	//glBindTexture(GL_TEXTURE_1D, texName);
 
-	if(!kernel->GetModelInfo().IsGeneralMesh())
-	{
-		if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-			glBegin(GL_TRIANGLES);
-		else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-			glBegin(GL_QUADS);
-		else
-			return;
-
-		for(i = 0; i < nFace; ++ i)
-		{
-			IndexArray& face = fIndex[i];
-			n = face.size();
-			for(j = 0; j < n; ++ j)
-			{
-				VertexID& vID = face[j];
-				Coord& v = vCoord[vID];
-				Coord2D& t = tCoord[vID];
-				Normal& n = vNormal[vID];
-				glNormal3d(n[0], n[1], n[2]);
-				glTexCoord2d(t[0], t[1]);
-				glVertex3d(v[0], v[1], v[2]);
-			}
-		}
-		glEnd();
-	}
-	else    // General polygonal mesh
-	{
-		for(i = 0; i < nFace; ++ i)
-		{
-			IndexArray& face = fIndex[i];
-			n = face.size();
-			glBegin(GL_POLYGON);
-			for(j = 0; j < n; ++ j)
-			{
-				VertexID vID = face[j];
-				Coord& v = vCoord[vID];
-				Coord2D& t = tCoord[vID];
-				Normal& n = vNormal[vID];
-				glNormal3d(n[0], n[1], n[2]);
-				glTexCoord2d(t[0], t[1]);
-				glVertex3d(v[0], v[1], v[2]);
-			}
-			glEnd();
-		}
-	}
+	m_Buffer.DrawVertexFaces(RENDER_ARRAY_NORMAL | RENDER_ARRAY_TEXCOORD);
 
 	glDisable(GL_TEXTURE_2D);
 	glDisable(GL_POLYGON_OFFSET_FILL);
@@ -672,9 +400,7 @@ void MeshModelRender::DrawModelTextureMapping()
 void MeshModelRender::DrawModelVertexColor()
 {
     CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
     ColorArray& vColor = kernel->GetVertexInfo().GetColor();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
 
     if(vColor.size() != vCoord.size())
         return;
@@ -697,56 +423,7 @@ void MeshModelRender::DrawModelVertexColor()
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
 
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
-
-    if(!kernel->GetModelInfo().IsGeneralMesh())
-    {
-        if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-            glBegin(GL_TRIANGLES);
-        else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-            glBegin(GL_QUADS);
-        else
-            return;
-
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID& vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                Color& c = vColor[vID];
-                glColor3d (c[0], c[1], c[2]);
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-        }
-        glEnd();
-    }
-
-    else    // General polygonal mesh
-    {
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            glBegin(GL_POLYGON);
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                Color& c = vColor[vID];
-                glColor3d (c[0], c[1], c[2]);
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-            glEnd();
-        }
-    }
+    m_Buffer.DrawVertexFaces(RENDER_ARRAY_NORMAL | RENDER_ARRAY_COLOR);
 
     glDisable(GL_COLOR_MATERIAL);
     glDisable(GL_POLYGON_OFFSET_FILL);
@@ -763,12 +440,10 @@ void MeshModelRender::DrawModelVertexColor()
 
 void MeshModelRender::DrawModelFaceColor()
 {
-    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
-    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
     ColorArray& fColor = kernel->GetFaceInfo().GetColor();
-    PolyIndexArray& fIndex = kernel->GetFaceInfo().GetIndex();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
 
-    if(fColor.size() != fIndex.size())
+    if(fColor.size() != (size_t) fInfo.GetFaceNum())
         return;
 
     // Get previous material diffuse components
@@ -790,56 +465,9 @@ void MeshModelRender::DrawModelFaceColor()
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT, GL_DIFFUSE);
 
-    size_t nFace = fIndex.size();
-    size_t i, j, n;
+    // Face colors are kept per corner, lighting is off so the face normals stand for the vertex ones
+    m_Buffer.DrawCornerFaces(RENDER_ARRAY_NORMAL | RENDER_ARRAY_COLOR);
 
-    if(!kernel->GetModelInfo().IsGeneralMesh())
-    {
-        if(kernel->GetModelInfo().IsTriMesh())  // Triangle mesh
-            glBegin(GL_TRIANGLES);
-        else if(kernel->GetModelInfo().IsQuadMesh())    // Quadangle mesh
-            glBegin(GL_QUADS);
-        else
-            return;
-
-        for(i = 0; i < nFace; ++ i)
-        {			
-			IndexArray& face = fIndex[i];
-            n = face.size();
-            Color& c = fColor[i];
-            glColor3d(c[0], c[1], c[2]);			
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID& vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-        }
-        glEnd();
-    }
-
-    else    // General polygonal mesh
-    {
-        for(i = 0; i < nFace; ++ i)
-        {
-            IndexArray& face = fIndex[i];
-            n = face.size();
-            Color& c = fColor[i];
-            glColor3d(c[0], c[1], c[2]);
-            glBegin(GL_POLYGON);
-            for(j = 0; j < n; ++ j)
-            {
-                VertexID vID = face[j];
-                Coord& v = vCoord[vID];
-                Normal& n = vNormal[vID];
-                glNormal3d(n[0], n[1], n[2]);
-                glVertex3d(v[0], v[1], v[2]);
-            }
-            glEnd();
-        }
-    }
     glDisable(GL_COLOR_MATERIAL);
     glDisable(GL_POLYGON_OFFSET_FILL);
     glDisable(GL_POLYGON_SMOOTH);
@@ -34,6 +34,7 @@
 #include "MeshModelKernel.h"
 #include "MeshModelAuxData.h"
 #include "../Common/Utility.h"
+#include "MeshModelRenderBuffer.h"
 #include "../OpenGL/GLElement.h"
 #pragma once
 
@@ -161,6 +162,9 @@ private:
     MeshModelKernel* kernel;
     MeshModelAuxData* auxdata;
 
+    // Vertex and index buffers the model is drawn from
+    MeshModelRenderBuffer m_Buffer;
+
 private:
     Utility util;
 
@@ -197,7 +201,7 @@ public:
     // Constructor
     MeshModelRender();
 
-    // Destructor
+    // Destructor -- frees the buffer objects, the GL context has to be current
     ~MeshModelRender();
 
     // Initializer
@@ -242,6 +246,10 @@ public:
     // Rendering entrance function
     void DrawModel();
 
+    // Upload the given RENDER_BUFFER_* groups again on the next draw,
+    // needed after changing colors or texture coordinates in place
+    void Invalidate(int flags = RENDER_BUFFER_ALL) { m_Buffer.Invalidate(flags); }
+
 	int CreateTexture(const std::string& file_name);
 
 
@@ -0,0 +1,423 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelRenderBuffer.cpp
+//
+// [Goal]
+// Vertex and index buffers of a mesh model for the OpenGL renderer
+
+#include "MeshModelRenderBuffer.h"
+#include "../Common/Utility.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace
+{
+    void PushCoord(std::vector<float>& array, const Coord& v)
+    {
+        array.push_back((float)v[0]);
+        array.push_back((float)v[1]);
+        array.push_back((float)v[2]);
+    }
+
+    void PushColor(std::vector<unsigned char>& array, const Color& c)
+    {
+        // Same clamping as glColor3d
+        for(int i = 0; i < 3; ++ i)
+        {
+            double ci = (c[i] < 0.0) ? 0.0 : ((c[i] > 1.0) ? 1.0 : c[i]);
+            array.push_back((unsigned char)(ci * 255.0 + 0.5));
+        }
+    }
+
+    template<typename T>
+    void UploadArray(GLBuffer& buffer, const std::vector<T>& array)
+    {
+        buffer.Upload(array.empty() ? NULL : &array[0], array.size() * sizeof(T));
+    }
+}
+
+// Constructor
+MeshModelRenderBuffer::MeshModelRenderBuffer()
+    : m_EdgeIndex(GL_ELEMENT_ARRAY_BUFFER), m_PointIndex(GL_ELEMENT_ARRAY_BUFFER)
+{
+    kernel = NULL;
+    m_EdgeIndexNum = 0;
+    m_PointIndexNum = 0;
+    m_ModifyCount = 0;
+    m_VertexNum = 0;
+    m_FaceNum = 0;
+}
+
+// Destructor
+MeshModelRenderBuffer::~MeshModelRenderBuffer()
+{
+}
+
+// Initializer
+void MeshModelRenderBuffer::AttachKernel(MeshModelKernel* pKernel)
+{
+    assert(pKernel != NULL);
+    kernel = pKernel;
+
+    Invalidate(RENDER_BUFFER_ALL);
+}
+
+void MeshModelRenderBuffer::Invalidate(int flags)
+{
+    m_Vertex.valid &= ~flags;
+    m_Corner.valid &= ~flags;
+}
+
+void MeshModelRenderBuffer::Release()
+{
+    Layout* layout[2] = { &m_Vertex, &m_Corner };
+    for(int i = 0; i < 2; ++ i)
+    {
+        layout[i]->coord.Release();
+        layout[i]->normal.Release();
+        layout[i]->color.Release();
+        layout[i]->texcoord.Release();
+        layout[i]->tri_index.Release();
+        layout[i]->tri_index_num = 0;
+        layout[i]->valid = 0;
+    }
+    m_EdgeIndex.Release();
+    m_PointIndex.Release();
+    m_EdgeIndexNum = 0;
+    m_PointIndexNum = 0;
+}
+
+// Draw functions
+bool MeshModelRenderBuffer::DrawVertexFaces(int arrays)
+{
+    CheckKernel();
+    if(!HasAttribute(arrays, false))
+        return false;
+
+    UploadVertexLayout(RENDER_BUFFER_GEOMETRY | arrays);
+    DrawLayout(m_Vertex, arrays);
+    return true;
+}
+
+bool MeshModelRenderBuffer::DrawCornerFaces(int arrays)
+{
+    CheckKernel();
+    if(!HasAttribute(arrays, true))
+        return false;
+
+    UploadCornerLayout(RENDER_BUFFER_GEOMETRY | arrays);
+    DrawLayout(m_Corner, arrays);
+    return true;
+}
+
+bool MeshModelRenderBuffer::DrawEdges()
+{
+    CheckKernel();
+    UploadVertexLayout(RENDER_BUFFER_GEOMETRY);
+    if(m_EdgeIndexNum == 0)
+        return true;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, m_Vertex.coord.Bind());
+    m_Vertex.coord.Unbind();
+    glDrawElements(GL_LINES, (GLsizei)m_EdgeIndexNum, GL_UNSIGNED_INT, m_EdgeIndex.Bind());
+    m_EdgeIndex.Unbind();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    return true;
+}
+
+bool MeshModelRenderBuffer::DrawVertices()
+{
+    CheckKernel();
+    UploadVertexLayout(RENDER_BUFFER_GEOMETRY);
+    if(m_PointIndexNum == 0)
+        return true;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, m_Vertex.coord.Bind());
+    m_Vertex.coord.Unbind();
+    glDrawElements(GL_POINTS, (GLsizei)m_PointIndexNum, GL_UNSIGNED_INT, m_PointIndex.Bind());
+    m_PointIndex.Unbind();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    return true;
+}
+
+void MeshModelRenderBuffer::CheckKernel()
+{
+    assert(kernel != NULL);
+
+    size_t nVertex = kernel->GetVertexInfo().GetCoord().size();
+    size_t nFace = kernel->GetFaceInfo().GetFaceNum();
+    if(m_ModifyCount != kernel->GetModifyCount() || m_VertexNum != nVertex || m_FaceNum != nFace)
+    {
+        Invalidate(RENDER_BUFFER_ALL);
+        m_ModifyCount = kernel->GetModifyCount();
+        m_VertexNum = nVertex;
+        m_FaceNum = nFace;
+    }
+}
+
+bool MeshModelRenderBuffer::HasAttribute(int arrays, bool corner)
+{
+    if(corner)
+    {
+        if((arrays & RENDER_ARRAY_COLOR) && kernel->GetFaceInfo().GetColor().size() != m_FaceNum)
+            return false;
+        if((arrays & RENDER_ARRAY_TEXCOORD) && kernel->GetFaceInfo().GetTexIndex().size() != m_FaceNum)
+            return false;
+    }
+    else
+    {
+        if((arrays & RENDER_ARRAY_COLOR) && kernel->GetVertexInfo().GetColor().size() != m_VertexNum)
+            return false;
+        if((arrays & RENDER_ARRAY_TEXCOORD) && kernel->GetVertexInfo().GetTexCoord().size() != m_VertexNum)
+            return false;
+    }
+    return true;
+}
+
+void MeshModelRenderBuffer::UploadVertexLayout(int groups)
+{
+    // The groups share their bits with the arrays, the normals are geometry
+    groups &= ~RENDER_ARRAY_NORMAL;
+    groups |= RENDER_BUFFER_GEOMETRY;
+    int missing = groups & ~m_Vertex.valid;
+    if(missing == 0)
+        return;
+
+    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    NormalArray& vNormal = kernel->GetVertexInfo().GetNormal();
+    FlagArray& vFlag = kernel->GetVertexInfo().GetFlag();
+    FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t nVertex = vCoord.size();
+    size_t nFace = fInfo.GetFaceNum();
+    size_t i, j, n;
+
+    if(missing & RENDER_BUFFER_GEOMETRY)
+    {
+        std::vector<float> coord, normal;
+        coord.reserve(nVertex * 3);
+        normal.reserve(nVertex * 3);
+        for(i = 0; i < nVertex; ++ i)
+        {
+            PushCoord(coord, vCoord[i]);
+            PushCoord(normal, (vNormal.size() == nVertex) ? vNormal[i] : Normal(0.0, 0.0, 0.0));
+        }
+        UploadArray(m_Vertex.coord, coord);
+        UploadArray(m_Vertex.normal, normal);
+
+        // Faces as triangle fans, and each edge once
+        std::vector<unsigned int> tri_index;
+        std::vector< std::pair<unsigned int, unsigned int> > edge;
+        tri_index.reserve(nFace * 3);
+        edge.reserve(nFace * 3);
+        for(i = 0; i < nFace; ++ i)
+        {
+            const int* face = fInfo.GetFaceVertices((FaceID) i);
+            n = fInfo.GetFaceDegree((FaceID) i);
+            for(j = 1; j + 1 < n; ++ j)
+            {
+                tri_index.push_back(face[0]);
+                tri_index.push_back(face[j]);
+                tri_index.push_back(face[j+1]);
+            }
+            for(j = 0; j < n; ++ j)
+            {
+                unsigned int v1 = face[j], v2 = face[(j+1)%n];
+                edge.push_back(std::make_pair(std::min(v1, v2), std::max(v1, v2)));
+            }
+        }
+        std::sort(edge.begin(), edge.end());
+        edge.erase(std::unique(edge.begin(), edge.end()), edge.end());
+
+        std::vector<unsigned int> edge_index(edge.size() * 2);
+        for(i = 0; i < edge.size(); ++ i)
+        {
+            edge_index[2*i] = edge[i].first;
+            edge_index[2*i+1] = edge[i].second;
+        }
+
+        Utility util;
+        std::vector<unsigned int> point_index;
+        point_index.reserve(nVertex);
+        for(i = 0; i < nVertex; ++ i)
+        {
+            if(i < vFlag.size() && util.IsSetFlag(vFlag[i], FLAG_INVALID))
+                continue;
+            point_index.push_back((unsigned int)i);
+        }
+
+        UploadArray(m_Vertex.tri_index, tri_index);
+        UploadArray(m_EdgeIndex, edge_index);
+        UploadArray(m_PointIndex, point_index);
+        m_Vertex.tri_index_num = tri_index.size();
+        m_EdgeIndexNum = edge_index.size();
+        m_PointIndexNum = point_index.size();
+    }
+
+    if(missing & RENDER_BUFFER_COLOR)
+    {
+        ColorArray& vColor = kernel->GetVertexInfo().GetColor();
+        std::vector<unsigned char> color;
+        color.reserve(nVertex * 3);
+        for(i = 0; i < vColor.size(); ++ i)
+            PushColor(color, vColor[i]);
+        UploadArray(m_Vertex.color, color);
+    }
+
+    if(missing & RENDER_BUFFER_TEXCOORD)
+    {
+        TexCoordArray& vTexCoord = kernel->GetVertexInfo().GetTexCoord();
+        std::vector<float> texcoord;
+        texcoord.reserve(nVertex * 2);
+        for(i = 0; i < vTexCoord.size(); ++ i)
+        {
+            texcoord.push_back((float)vTexCoord[i][0]);
+            texcoord.push_back((float)vTexCoord[i][1]);
+        }
+        UploadArray(m_Vertex.texcoord, texcoord);
+    }
+
+    m_Vertex.valid |= groups;
+}
+
+void MeshModelRenderBuffer::UploadCornerLayout(int groups)
+{
+    groups &= ~RENDER_ARRAY_NORMAL;
+    groups |= RENDER_BUFFER_GEOMETRY;
+    int missing = groups & ~m_Corner.valid;
+    if(missing == 0)
+        return;
+
+    CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    NormalArray& fNormal = kernel->GetFaceInfo().GetNormal();
+    size_t nFace = fInfo.GetFaceNum();
+    size_t i, j, n;
+
+    size_t nCorner = 0;
+    for(i = 0; i < nFace; ++ i)
+        nCorner += fInfo.GetFaceDegree(i);
+
+    if(missing & RENDER_BUFFER_GEOMETRY)
+    {
+        std::vector<float> coord, normal;
+        std::vector<unsigned int> tri_index;
+        coord.reserve(nCorner * 3);
+        normal.reserve(nCorner * 3);
+        tri_index.reserve(nCorner * 3);
+        unsigned int first = 0;
+        for(i = 0; i < nFace; ++ i)
+        {
+            const int* face = fInfo.GetFaceVertices(i);
+            n = fInfo.GetFaceDegree(i);
+            const Normal& fn = (fNormal.size() == nFace) ? fNormal[i] : Normal(0.0, 0.0, 0.0);
+            for(j = 0; j < n; ++ j)
+            {
+                PushCoord(coord, vCoord[face[j]]);
+                PushCoord(normal, fn);
+            }
+            for(j = 1; j + 1 < n; ++ j)
+            {
+                tri_index.push_back(first);
+                tri_index.push_back(first + (unsigned int)j);
+                tri_index.push_back(first + (unsigned int)j + 1);
+            }
+            first += (unsigned int)n;
+        }
+        UploadArray(m_Corner.coord, coord);
+        UploadArray(m_Corner.normal, normal);
+        UploadArray(m_Corner.tri_index, tri_index);
+        m_Corner.tri_index_num = tri_index.size();
+    }
+
+    if(missing & RENDER_BUFFER_COLOR)
+    {
+        ColorArray& fColor = kernel->GetFaceInfo().GetColor();
+        std::vector<unsigned char> color;
+        color.reserve(nCorner * 3);
+        for(i = 0; i < nFace && i < fColor.size(); ++ i)
+        {
+            n = fInfo.GetFaceDegree(i);
+            for(j = 0; j < n; ++ j)
+                PushColor(color, fColor[i]);
+        }
+        UploadArray(m_Corner.color, color);
+    }
+
+    if(missing & RENDER_BUFFER_TEXCOORD)
+    {
+        // Texture coordinates are indexed per corner into the vertex texture coordinates
+        TexCoordArray& vTexCoord = kernel->GetVertexInfo().GetTexCoord();
+        PolyIndexArray& ftIndex = kernel->GetFaceInfo().GetTexIndex();
+        std::vector<float> texcoord;
+        texcoord.reserve(nCorner * 2);
+        for(i = 0; i < nFace && i < ftIndex.size(); ++ i)
+        {
+            IndexArray& tex_index = ftIndex[i];
+            n = fInfo.GetFaceDegree(i);
+            for(j = 0; j < n; ++ j)
+            {
+                bool valid = (j < tex_index.size() && tex_index[j] < (int)vTexCoord.size());
+                texcoord.push_back(valid ? (float)vTexCoord[tex_index[j]][0] : 0.0f);
+                texcoord.push_back(valid ? (float)vTexCoord[tex_index[j]][1] : 0.0f);
+            }
+        }
+        UploadArray(m_Corner.texcoord, texcoord);
+    }
+
+    m_Corner.valid |= groups;
+}
+
+void MeshModelRenderBuffer::DrawLayout(Layout& layout, int arrays)
+{
+    if(layout.tri_index_num == 0)
+        return;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, layout.coord.Bind());
+    if(arrays & RENDER_ARRAY_NORMAL)
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, 0, layout.normal.Bind());
+    }
+    if(arrays & RENDER_ARRAY_COLOR)
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_UNSIGNED_BYTE, 0, layout.color.Bind());
+    }
+    if(arrays & RENDER_ARRAY_TEXCOORD)
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, layout.texcoord.Bind());
+    }
+    layout.coord.Unbind();
+
+    glDrawElements(GL_TRIANGLES, (GLsizei)layout.tri_index_num, GL_UNSIGNED_INT, layout.tri_index.Bind());
+    layout.tri_index.Unbind();
+
+    if(arrays & RENDER_ARRAY_TEXCOORD)
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    if(arrays & RENDER_ARRAY_COLOR)
+        glDisableClientState(GL_COLOR_ARRAY);
+    if(arrays & RENDER_ARRAY_NORMAL)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
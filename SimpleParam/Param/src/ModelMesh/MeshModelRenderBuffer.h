@@ -0,0 +1,118 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelRenderBuffer.h
+//
+// [Goal]
+// Vertex and index buffers of a mesh model for the OpenGL renderer
+//
+// Two layouts are kept. The vertex layout has one entry per vertex, with the
+// vertex normals, colors and texture coordinates, and is drawn through the
+// face and edge index buffers. The corner layout has one entry per face
+// corner, with the face normals, colors and indexed texture coordinates.
+// Polygons are split into fans. Each attribute group is uploaded on the
+// first draw that needs it, and everything is rebuilt when the kernel's
+// modification counter or element numbers change. Writes that do not touch
+// the counter, such as recoloring, have to call Invalidate()
+
+
+
+#include "MeshModelKernel.h"
+#include "../OpenGL/GLBuffer.h"
+#pragma once
+
+
+
+/* ================== Render Buffer Macros ================== */
+
+// Attribute groups, for Invalidate()
+#define RENDER_BUFFER_GEOMETRY      0X00000001      // Coordinates, normals and indices
+#define RENDER_BUFFER_COLOR         0X00000002
+#define RENDER_BUFFER_TEXCOORD      0X00000004
+#define RENDER_BUFFER_ALL           0X00000007
+
+// Attribute arrays enabled when drawing faces, besides the coordinates
+#define RENDER_ARRAY_NORMAL         0X00000001
+#define RENDER_ARRAY_COLOR          0X00000002
+#define RENDER_ARRAY_TEXCOORD       0X00000004
+
+
+
+/* ================== Mesh Model Render Buffer ================== */
+
+class MeshModelRenderBuffer
+{
+private:
+    class Layout
+    {
+    public:
+        GLBuffer coord;
+        GLBuffer normal;
+        GLBuffer color;
+        GLBuffer texcoord;
+        GLBuffer tri_index;
+        size_t tri_index_num;
+        int valid;          // uploaded attribute groups
+
+        Layout() : tri_index(GL_ELEMENT_ARRAY_BUFFER), tri_index_num(0), valid(0) {}
+    };
+
+    MeshModelKernel* kernel;
+
+    Layout m_Vertex;
+    Layout m_Corner;
+    GLBuffer m_EdgeIndex;       // vertex layout, each mesh edge once
+    GLBuffer m_PointIndex;      // vertex layout, valid vertices
+    size_t m_EdgeIndexNum;
+    size_t m_PointIndexNum;
+
+    // Kernel state the buffers were built from
+    unsigned int m_ModifyCount;
+    size_t m_VertexNum;
+    size_t m_FaceNum;
+
+public:
+    // Constructor
+    MeshModelRenderBuffer();
+
+    // Destructor
+    ~MeshModelRenderBuffer();
+
+    // Initializer
+    void AttachKernel(MeshModelKernel* pKernel);
+
+    // Mark attribute groups to be uploaded again, flags is a combination of RENDER_BUFFER_*
+    void Invalidate(int flags = RENDER_BUFFER_ALL);
+
+    // Free the buffer objects, the context has to be current
+    void Release();
+
+    // Draw functions, false when the kernel lacks a requested attribute
+    // arrays is a combination of RENDER_ARRAY_*
+    bool DrawVertexFaces(int arrays);
+    bool DrawCornerFaces(int arrays);
+    bool DrawEdges();
+    bool DrawVertices();
+
+private:
+    void CheckKernel();
+    bool HasAttribute(int arrays, bool corner);
+    void UploadVertexLayout(int groups);
+    void UploadCornerLayout(int groups);
+    void DrawLayout(Layout& layout, int arrays);
+};
@@ -0,0 +1,631 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelSpatialIndex.cpp
+//
+// [Goal]
+// Bounding volume hierarchies over the vertices and the faces of a mesh model
+// Supporting nearest vertex, nearest surface point and ray queries
+
+
+
+#include "MeshModelSpatialIndex.h"
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+
+
+#define BVH_VERTEX_LEAF_SIZE    8
+#define BVH_FACE_LEAF_SIZE      4
+#define BVH_STACK_SIZE          128
+#define BVH_SUBTREE_SIZE        4096    // Ranges up to this size are built by one thread
+
+namespace
+{
+    // Nodes left to visit. Median splits keep the depth near log2(n), far
+    // below BVH_STACK_SIZE, a deeper tree spills to the heap
+    class TraversalStack
+    {
+    public:
+        TraversalStack() : m_nTop(0) {}
+
+        bool Empty() const { return m_nTop == 0; }
+
+        void Push(int node)
+        {
+            if(m_nTop < BVH_STACK_SIZE)
+                m_Stack[m_nTop] = node;
+            else
+                m_Overflow.push_back(node);
+            ++ m_nTop;
+        }
+
+        int Pop()
+        {
+            -- m_nTop;
+            if(m_nTop < BVH_STACK_SIZE)
+                return m_Stack[m_nTop];
+            int node = m_Overflow.back();
+            m_Overflow.pop_back();
+            return node;
+        }
+
+    private:
+        int m_Stack[BVH_STACK_SIZE];
+        std::vector<int> m_Overflow;
+        int m_nTop;
+    };
+
+    // Order primitives by their center along one axis
+    class CenterLess
+    {
+    public:
+        CenterLess(const CoordArray& center, int axis) : m_Center(center), m_Axis(axis) {}
+        bool operator()(int a, int b) const { return m_Center[a][m_Axis] < m_Center[b][m_Axis]; }
+
+    private:
+        const CoordArray& m_Center;
+        int m_Axis;
+    };
+}
+
+// Builds each pending subtree into its own node array, rooted at local node 0
+class MeshModelSpatialIndex::SubtreePass
+{
+public:
+    const std::vector<BVHTask>& Tasks;
+    IndexArray& Index;
+    const CoordArray& Center;
+    const CoordArray& BoxMin;
+    const CoordArray& BoxMax;
+    int LeafSize;
+    std::vector< std::vector<BVHNode> >& Nodes;
+
+    SubtreePass(const std::vector<BVHTask>& t, IndexArray& i, const CoordArray& c, const CoordArray& bmin,
+        const CoordArray& bmax, int l, std::vector< std::vector<BVHNode> >& n)
+        : Tasks(t), Index(i), Center(c), BoxMin(bmin), BoxMax(bmax), LeafSize(l), Nodes(n) {}
+
+    void operator()(int i) const
+    {
+        const BVHTask& task = Tasks[i];
+        Nodes[i].push_back(BVHNode());
+        BuildBVHNode(Nodes[i], Index, 0, task.first, task.count, Center, BoxMin, BoxMax, LeafSize);
+    }
+};
+
+class MeshModelSpatialIndex::NearestVertexPass
+{
+public:
+    const MeshModelSpatialIndex& SpatialIndex;
+    const CoordArray& PosArray;
+    IndexArray& VtxArray;
+
+    NearestVertexPass(const MeshModelSpatialIndex& s, const CoordArray& p, IndexArray& v)
+        : SpatialIndex(s), PosArray(p), VtxArray(v) {}
+
+    void operator()(int i) const
+    {
+        SpatialIndex.NearestVertex(PosArray[i], VtxArray[i]);
+    }
+};
+
+// Constructor
+MeshModelSpatialIndex::MeshModelSpatialIndex()
+{
+    kernel = NULL;
+}
+
+// Destructor
+MeshModelSpatialIndex::~MeshModelSpatialIndex()
+{
+
+}
+
+// Initializer
+void MeshModelSpatialIndex::ClearData()
+{
+    Invalidate();
+}
+
+void MeshModelSpatialIndex::AttachKernel(MeshModelKernel* pKernel)
+{
+    assert(pKernel != NULL);
+    kernel = pKernel;
+}
+
+void MeshModelSpatialIndex::Invalidate()
+{
+    ParallelLock lock(m_Mutex);
+    m_VertexBVH.ClearData();
+    m_FaceBVH.ClearData();
+}
+
+// Queries
+bool MeshModelSpatialIndex::GetNearestVertex(const Coord& pos, VertexID& vID)
+{
+    {
+        ParallelLock lock(m_Mutex);
+        UpdateVertexBVH();
+    }
+    return NearestVertex(pos, vID);
+}
+
+bool MeshModelSpatialIndex::GetNearestVertex(const CoordArray& PosArray, IndexArray& VtxArray)
+{
+    {
+        ParallelLock lock(m_Mutex);
+        UpdateVertexBVH();
+    }
+    if(m_VertexBVH.nodes.empty())
+        return false;
+
+    VtxArray.resize(PosArray.size());
+    parallel_for(0, (int) PosArray.size(), NearestVertexPass(*this, PosArray, VtxArray));
+    return true;
+}
+
+bool MeshModelSpatialIndex::NearestVertex(const Coord& pos, VertexID& vID) const
+{
+    if(m_VertexBVH.nodes.empty())
+        return false;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const std::vector<BVHNode>& nodes = m_VertexBVH.nodes;
+    const IndexArray& index = m_VertexBVH.index;
+
+    double minDist = std::numeric_limits<double>::max();
+    vID = -1;
+
+    TraversalStack stack;
+    stack.Push(0);
+    while(!stack.Empty())
+    {
+        const BVHNode& node = nodes[stack.Pop()];
+        if(BoxSqrDistance(node, pos) >= minDist)
+            continue;
+
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++ i)
+            {
+                double dist = (vCoord[index[i]] - pos).sqrabs();
+                if(dist < minDist)
+                {
+                    minDist = dist;
+                    vID = index[i];
+                }
+            }
+        }
+        else
+        {
+            // Visit the nearer child first
+            int near_child = node.first, far_child = node.first + 1;
+            if(BoxSqrDistance(nodes[near_child], pos) > BoxSqrDistance(nodes[far_child], pos))
+                std::swap(near_child, far_child);
+            stack.Push(far_child);
+            stack.Push(near_child);
+        }
+    }
+    return vID != -1;
+}
+
+bool MeshModelSpatialIndex::GetNearestSurfacePoint(const Coord& pos, FaceID& fID, Coord& barycentric)
+{
+    {
+        ParallelLock lock(m_Mutex);
+        UpdateFaceBVH();
+    }
+    if(m_FaceBVH.nodes.empty())
+        return false;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    const std::vector<BVHNode>& nodes = m_FaceBVH.nodes;
+    const IndexArray& index = m_FaceBVH.index;
+
+    double minDist = std::numeric_limits<double>::max();
+    fID = -1;
+
+    TraversalStack stack;
+    stack.Push(0);
+    while(!stack.Empty())
+    {
+        const BVHNode& node = nodes[stack.Pop()];
+        if(BoxSqrDistance(node, pos) >= minDist)
+            continue;
+
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++ i)
+            {
+                const int* f = fInfo.GetFaceVertices(index[i]);
+                Coord bc;
+                Coord p = ClosestPointOnTriangle(pos, vCoord[f[0]], vCoord[f[1]], vCoord[f[2]], bc);
+                double dist = (p - pos).sqrabs();
+                if(dist < minDist)
+                {
+                    minDist = dist;
+                    fID = index[i];
+                    barycentric = bc;
+                }
+            }
+        }
+        else
+        {
+            int near_child = node.first, far_child = node.first + 1;
+            if(BoxSqrDistance(nodes[near_child], pos) > BoxSqrDistance(nodes[far_child], pos))
+                std::swap(near_child, far_child);
+            stack.Push(far_child);
+            stack.Push(near_child);
+        }
+    }
+    return fID != -1;
+}
+
+// Nearest hit along origin + t*dir, t >= 0, none for a zero direction
+bool MeshModelSpatialIndex::RayIntersect(const Coord& origin, const Coord& dir, FaceID& fID, Coord& barycentric, double& t)
+{
+    {
+        ParallelLock lock(m_Mutex);
+        UpdateFaceBVH();
+    }
+    fID = -1;
+    if(m_FaceBVH.nodes.empty() || dir.sqrabs() == 0.0)
+        return false;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    const std::vector<BVHNode>& nodes = m_FaceBVH.nodes;
+    const IndexArray& index = m_FaceBVH.index;
+
+    // An axis the ray does not move along gets a zero inverse, RayBoxIntersect
+    // tests it against the slab directly, 0*inf would give NaN
+    Coord inv_dir(0, 0, 0);
+    for(int k = 0; k < 3; ++ k)
+    {
+        double inv = 1.0/dir[k];
+        if(fabs(inv) <= std::numeric_limits<double>::max())
+            inv_dir[k] = inv;
+    }
+    t = std::numeric_limits<double>::max();
+
+    TraversalStack stack;
+    stack.Push(0);
+    while(!stack.Empty())
+    {
+        const BVHNode& node = nodes[stack.Pop()];
+        if(!RayBoxIntersect(node, origin, inv_dir, t))
+            continue;
+
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++ i)
+            {
+                const int* f = fInfo.GetFaceVertices(index[i]);
+                double cur_t;
+                Coord bc;
+                if(RayTriangleIntersect(origin, dir, vCoord[f[0]], vCoord[f[1]], vCoord[f[2]], cur_t, bc) && cur_t < t)
+                {
+                    t = cur_t;
+                    fID = index[i];
+                    barycentric = bc;
+                }
+            }
+        }
+        else
+        {
+            stack.Push(node.first + 1);
+            stack.Push(node.first);
+        }
+    }
+    return fID != -1;
+}
+
+// Build
+void MeshModelSpatialIndex::UpdateVertexBVH()
+{
+    assert(kernel != NULL);
+    if(m_VertexBVH.valid && m_VertexBVH.modify_count == kernel->GetModifyCount())
+        return;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    BuildBVH(m_VertexBVH, vCoord, vCoord, vCoord, BVH_VERTEX_LEAF_SIZE);
+    m_VertexBVH.modify_count = kernel->GetModifyCount();
+}
+
+void MeshModelSpatialIndex::UpdateFaceBVH()
+{
+    assert(kernel != NULL);
+    if(m_FaceBVH.valid && m_FaceBVH.modify_count == kernel->GetModifyCount())
+        return;
+
+    const CoordArray& vCoord = kernel->GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = kernel->GetFaceInfo();
+    size_t nFace = fInfo.GetFaceNum();
+
+    CoordArray Center(nFace), BoxMin(nFace), BoxMax(nFace);
+    for(size_t i = 0; i < nFace; ++ i)
+    {
+        const int* f = fInfo.GetFaceVertices(i);
+        BoxMin[i] = BoxMax[i] = vCoord[f[0]];
+        for(size_t j = 1; j < (size_t) fInfo.GetFaceDegree(i); ++ j)
+        {
+            const Coord& v = vCoord[f[j]];
+            for(int k = 0; k < 3; ++ k)
+            {
+                BoxMin[i][k] = std::min(BoxMin[i][k], v[k]);
+                BoxMax[i][k] = std::max(BoxMax[i][k], v[k]);
+            }
+        }
+        Center[i] = (BoxMin[i] + BoxMax[i]) * 0.5;
+    }
+
+    BuildBVH(m_FaceBVH, Center, BoxMin, BoxMax, BVH_FACE_LEAF_SIZE);
+    m_FaceBVH.modify_count = kernel->GetModifyCount();
+}
+
+// The top levels are split in breadth first order until the ranges hold at
+// most BVH_SUBTREE_SIZE primitives, the subtrees below are built in parallel
+// and appended in task order, so the tree does not depend on the thread number
+void MeshModelSpatialIndex::BuildBVH(BVH& bvh, const CoordArray& Center, const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize)
+{
+    int n = (int) Center.size();
+    bvh.nodes.clear();
+    bvh.index.resize(n);
+    for(int i = 0; i < n; ++ i)
+        bvh.index[i] = i;
+
+    if(n > 0)
+    {
+        bvh.nodes.reserve(2*(n/LeafSize+1));
+        bvh.nodes.push_back(BVHNode());
+
+        std::vector<BVHTask> Tasks, Subtrees;
+        Tasks.push_back(BVHTask(0, 0, n));
+        for(size_t k = 0; k < Tasks.size(); ++ k)
+        {
+            BVHTask task = Tasks[k];
+            if(task.count <= BVH_SUBTREE_SIZE)
+            {
+                Subtrees.push_back(task);
+                continue;
+            }
+
+            int half;
+            if(!SplitBVHNode(bvh.nodes[task.node], bvh.index, task.first, task.count, Center, BoxMin, BoxMax, LeafSize, half))
+                continue;
+
+            int child = (int) bvh.nodes.size();
+            bvh.nodes.push_back(BVHNode());
+            bvh.nodes.push_back(BVHNode());
+            bvh.nodes[task.node].first = child;
+            bvh.nodes[task.node].count = 0;
+            Tasks.push_back(BVHTask(child, task.first, half));
+            Tasks.push_back(BVHTask(child+1, task.first+half, task.count-half));
+        }
+
+        // The subtrees write disjoint ranges of the index
+        std::vector< std::vector<BVHNode> > SubNodes(Subtrees.size());
+        parallel_for(0, (int) Subtrees.size(), SubtreePass(Subtrees, bvh.index, Center, BoxMin, BoxMax, LeafSize, SubNodes), 1);
+
+        // Local node 0 replaces the subtree root, local node j > 0 lands at base+j-1
+        for(size_t k = 0; k < Subtrees.size(); ++ k)
+        {
+            std::vector<BVHNode>& local = SubNodes[k];
+            int base = (int) bvh.nodes.size();
+            for(size_t j = 0; j < local.size(); ++ j)
+            {
+                if(local[j].count == 0)
+                    local[j].first += base - 1;
+            }
+            bvh.nodes[Subtrees[k].node] = local[0];
+            bvh.nodes.insert(bvh.nodes.end(), local.begin()+1, local.end());
+        }
+    }
+    bvh.valid = true;
+}
+
+void MeshModelSpatialIndex::BuildBVHNode(std::vector<BVHNode>& nodes, IndexArray& index, int node, int first, int count,
+    const CoordArray& Center, const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize)
+{
+    int half;
+    if(!SplitBVHNode(nodes[node], index, first, count, Center, BoxMin, BoxMax, LeafSize, half))
+        return;
+
+    int child = (int) nodes.size();
+    nodes.push_back(BVHNode());
+    nodes.push_back(BVHNode());
+    nodes[node].first = child;
+    nodes[node].count = 0;
+
+    BuildBVHNode(nodes, index, child, first, half, Center, BoxMin, BoxMax, LeafSize);
+    BuildBVHNode(nodes, index, child+1, first+half, count-half, Center, BoxMin, BoxMax, LeafSize);
+}
+
+// Bound the primitives of a node and split them at the median along the longest
+// axis of their centers, the node becomes a leaf and false is returned when
+// they are few or all at one place
+bool MeshModelSpatialIndex::SplitBVHNode(BVHNode& node, IndexArray& index, int first, int count, const CoordArray& Center,
+    const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize, int& half)
+{
+    Coord box_min = BoxMin[index[first]], box_max = BoxMax[index[first]];
+    Coord center_min = Center[index[first]], center_max = Center[index[first]];
+    for(int i = first+1; i < first+count; ++ i)
+    {
+        int id = index[i];
+        for(int k = 0; k < 3; ++ k)
+        {
+            box_min[k] = std::min(box_min[k], BoxMin[id][k]);
+            box_max[k] = std::max(box_max[k], BoxMax[id][k]);
+            center_min[k] = std::min(center_min[k], Center[id][k]);
+            center_max[k] = std::max(center_max[k], Center[id][k]);
+        }
+    }
+    node.box_min = box_min;
+    node.box_max = box_max;
+
+    Coord extent = center_max - center_min;
+    if(count <= LeafSize || extent.abs() == 0.0)
+    {
+        node.first = first;
+        node.count = count;
+        return false;
+    }
+
+    int axis = 0;
+    if(extent[1] > extent[axis]) axis = 1;
+    if(extent[2] > extent[axis]) axis = 2;
+
+    half = count/2;
+    std::nth_element(index.begin()+first, index.begin()+first+half, index.begin()+first+count, CenterLess(Center, axis));
+    return true;
+}
+
+// Geometric predicates
+double MeshModelSpatialIndex::BoxSqrDistance(const BVHNode& node, const Coord& pos)
+{
+    double dist = 0.0;
+    for(int k = 0; k < 3; ++ k)
+    {
+        double d = 0.0;
+        if(pos[k] < node.box_min[k]) d = node.box_min[k] - pos[k];
+        else if(pos[k] > node.box_max[k]) d = pos[k] - node.box_max[k];
+        dist += d*d;
+    }
+    return dist;
+}
+
+bool MeshModelSpatialIndex::RayBoxIntersect(const BVHNode& node, const Coord& origin, const Coord& inv_dir, double t_max)
+{
+    double t_near = 0.0, t_far = t_max;
+    for(int k = 0; k < 3; ++ k)
+    {
+        // Parallel to the slabs of this axis, between them or never
+        if(inv_dir[k] == 0.0)
+        {
+            if(origin[k] < node.box_min[k] || origin[k] > node.box_max[k])
+                return false;
+            continue;
+        }
+
+        double t0 = (node.box_min[k] - origin[k]) * inv_dir[k];
+        double t1 = (node.box_max[k] - origin[k]) * inv_dir[k];
+        if(t0 > t1) std::swap(t0, t1);
+        if(t0 > t_near) t_near = t0;
+        if(t1 < t_far) t_far = t1;
+        if(t_near > t_far)
+            return false;
+    }
+    return true;
+}
+
+// Real-Time Collision Detection, Ericson, 5.1.5
+Coord MeshModelSpatialIndex::ClosestPointOnTriangle(const Coord& p, const Coord& a, const Coord& b, const Coord& c, Coord& barycentric)
+{
+    Coord ab = b - a, ac = c - a, ap = p - a;
+    double d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if(d1 <= 0.0 && d2 <= 0.0)
+    {
+        barycentric = Coord(1, 0, 0);
+        return a;
+    }
+
+    Coord bp = p - b;
+    double d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if(d3 >= 0.0 && d4 <= d3)
+    {
+        barycentric = Coord(0, 1, 0);
+        return b;
+    }
+
+    double vc = d1*d4 - d3*d2;
+    if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        double v = d1 / (d1 - d3);
+        barycentric = Coord(1-v, v, 0);
+        return a + ab*v;
+    }
+
+    Coord cp = p - c;
+    double d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if(d6 >= 0.0 && d5 <= d6)
+    {
+        barycentric = Coord(0, 0, 1);
+        return c;
+    }
+
+    double vb = d5*d2 - d1*d6;
+    if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        double w = d2 / (d2 - d6);
+        barycentric = Coord(1-w, 0, w);
+        return a + ac*w;
+    }
+
+    double va = d3*d6 - d5*d4;
+    if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+        double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        barycentric = Coord(0, 1-w, w);
+        return b + (c - b)*w;
+    }
+
+    double denom = va + vb + vc;
+    if(fabs(denom) < SMALL_ZERO_EPSILON)
+    {
+        // Degenerated triangle
+        barycentric = Coord(1, 0, 0);
+        return a;
+    }
+    double v = vb / denom, w = vc / denom;
+    barycentric = Coord(1-v-w, v, w);
+    return a + ab*v + ac*w;
+}
+
+// Moller-Trumbore
+bool MeshModelSpatialIndex::RayTriangleIntersect(const Coord& origin, const Coord& dir,
+    const Coord& a, const Coord& b, const Coord& c, double& t, Coord& barycentric)
+{
+    Coord e1 = b - a, e2 = c - a;
+    Coord pvec = cross(dir, e2);
+    double det = dot(e1, pvec);
+
+    // det is |dir| |e1 x e2| cos(dir, normal), measured against the lengths it
+    // scales with so the test holds at any model size
+    if(fabs(det) <= LARGE_ZERO_EPSILON * dir.abs() * e1.abs() * e2.abs())
+        return false;
+
+    double inv_det = 1.0 / det;
+    Coord tvec = origin - a;
+    double u = dot(tvec, pvec) * inv_det;
+    if(u < 0.0 || u > 1.0)
+        return false;
+
+    Coord qvec = cross(tvec, e1);
+    double v = dot(dir, qvec) * inv_det;
+    if(v < 0.0 || u + v > 1.0)
+        return false;
+
+    t = dot(e2, qvec) * inv_det;
+    if(t < 0.0)
+        return false;
+
+    barycentric = Coord(1-u-v, u, v);
+    return true;
+}
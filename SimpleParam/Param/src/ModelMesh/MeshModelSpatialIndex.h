@@ -0,0 +1,124 @@
+/* ================== Library Information ================== */
+// [Name]
+// MeshLib Library
+//
+// [Developer]
+// Xu Dong
+// State Key Lab of CAD&CG, Zhejiang University
+//
+// [Date]
+// 2005-08-05
+//
+// [Goal]
+// A general, flexible, versatile and easy-to-use mesh library for research purpose.
+// Supporting arbitrary polygonal meshes as input, but with a
+// primary focus on triangle meshes.
+
+/* ================== File Information ================== */
+// [Name]
+// MeshModelSpatialIndex.h
+//
+// [Goal]
+// Bounding volume hierarchies over the vertices and the faces of a mesh model
+// Supporting nearest vertex, nearest surface point and ray queries
+//
+// The hierarchies are built on first query and rebuilt when the kernel's
+// modification counter changes. Queries may be issued from several threads,
+// the first one rebuilds an out of date hierarchy while the others wait
+
+
+
+#include "MeshModelKernel.h"
+#include "../Common/Utility.h"
+#include "../Common/Parallel.h"
+#pragma once
+
+
+
+/* ================== Spatial Index ================== */
+
+class MeshModelSpatialIndex
+{
+private:
+    // A node covers the primitives m_Index[first, first+count) when it is a leaf,
+    // otherwise its children are the nodes right and right+1
+    class BVHNode
+    {
+    public:
+        Coord box_min;
+        Coord box_max;
+        int first;      // first primitive (leaf) or first child (inner node)
+        int count;      // number of primitives, 0 for inner node
+    };
+
+    class BVH
+    {
+    public:
+        std::vector<BVHNode> nodes;
+        IndexArray index;       // primitive index, reordered so each leaf is a range
+        bool valid;
+        unsigned int modify_count;
+
+        BVH() : valid(false), modify_count(0) {}
+        void ClearData() { nodes.clear(); index.clear(); valid = false; modify_count = 0; }
+    };
+
+    // A subtree left to build, rooted at an allocated node
+    class BVHTask
+    {
+    public:
+        int node;
+        int first;
+        int count;
+
+        BVHTask(int n, int f, int c) : node(n), first(f), count(c) {}
+    };
+
+    class SubtreePass;
+    class NearestVertexPass;
+
+    MeshModelKernel* kernel;
+
+    BVH m_VertexBVH;
+    BVH m_FaceBVH;
+    ParallelMutex m_Mutex;  // Guards the rebuild of the hierarchies
+
+public:
+    // Constructor
+    MeshModelSpatialIndex();
+
+    // Destructor
+    ~MeshModelSpatialIndex();
+
+    // Initializer
+    void ClearData();
+    void AttachKernel(MeshModelKernel* pKernel);
+
+    // Drop the hierarchies, they are rebuilt on next query
+    void Invalidate();
+
+    // Queries -- return false when the model is empty
+    bool GetNearestVertex(const Coord& pos, VertexID& vID);
+    bool GetNearestVertex(const CoordArray& PosArray, IndexArray& VtxArray);
+    bool GetNearestSurfacePoint(const Coord& pos, FaceID& fID, Coord& barycentric);
+    bool RayIntersect(const Coord& origin, const Coord& dir, FaceID& fID, Coord& barycentric, double& t);
+
+private:
+    void UpdateVertexBVH();
+    void UpdateFaceBVH();
+
+    bool NearestVertex(const Coord& pos, VertexID& vID) const;
+
+    static void BuildBVH(BVH& bvh, const CoordArray& Center, const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize);
+    static void BuildBVHNode(std::vector<BVHNode>& nodes, IndexArray& index, int node, int first, int count,
+        const CoordArray& Center, const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize);
+    static bool SplitBVHNode(BVHNode& node, IndexArray& index, int first, int count, const CoordArray& Center,
+        const CoordArray& BoxMin, const CoordArray& BoxMax, int LeafSize, int& half);
+
+    static double BoxSqrDistance(const BVHNode& node, const Coord& pos);
+    static bool RayBoxIntersect(const BVHNode& node, const Coord& origin, const Coord& inv_dir, double t_max);
+
+    static Coord ClosestPointOnTriangle(const Coord& p, const Coord& a, const Coord& b, const Coord& c, Coord& barycentric);
+    static bool RayTriangleIntersect(const Coord& origin, const Coord& dir,
+        const Coord& a, const Coord& b, const Coord& c, double& t, Coord& barycentric);
+};
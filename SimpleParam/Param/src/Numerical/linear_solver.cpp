@@ -1,12 +1,10 @@
 #include "linear_solver.h"
 #include "../Common/stopwatch.h"
 #include "../Numerical/MatrixConverter.h"
+#include "schur_solver.h"
+#include "sparse_cholesky.h"
+#include "sparse_product.h"
 
-#ifdef WIN32
-#include <hj_3rd/hjlib/sparse_old/sparse_multi_cl.h>
-#else
-#include <hj_3rd/hjlib/sparse/sparse_multi_cl.h>
-#endif
 
 #include <assert.h>
 #include <float.h>
@@ -14,7 +12,7 @@
 #include <iostream>
 #include <fstream>
 #include <stdio.h> 
-#include <memory>
+#include <boost/scoped_ptr.hpp>
 //#include <process.h>
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -24,6 +22,7 @@ LinearSolver::LinearSolver(int nb_variables)
 {
 	factorize_state = false;
 	m_is_printf_info = true;
+	m_schur_solver = NULL;
 }
 LinearSolver::~LinearSolver()
 {
@@ -236,20 +235,21 @@ void LinearSolver::solve()
 	m_solve_matrix_AT_.MultiplyVector(m_solve_b_vec, at_b_vec);
 
 	//
-	std::auto_ptr<hj::sparse::solver> m_solver_;
+	boost::scoped_ptr<SparseDirectSolver> m_solver_;
+	hj::sparse::spm_csc<double> spm_ATA;
 
 	// H = JT * J
 	SystemStopwatch watch_;
 	{
-		hj::sparse::spm_csc<double> spm_ATA;
-
 		hj::sparse::spm_csc<double> spm_A;
 		CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_A, m_solve_matrix_AT_);
 
-		spm_dmm(false, spm_A, true, spm_A, spm_ATA);
+		sparse_multiply(false, spm_A, true, spm_A, spm_ATA);
 
 		m_solve_matrix_AT_.ClearData();
-		m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
+		if(!m_schur_solver) {
+			m_solver_.reset(SparseDirectSolver::create(spm_ATA));
+		}
 	}
 	//
 	if (m_is_printf_info){
@@ -258,12 +258,27 @@ void LinearSolver::solve()
 
 	//
 	m_equation_vec.clear();
-	if(!m_solver_.get()) {
-		printf("factorize failed.\n");
-	}
 	m_solve_b_vec.clear();
 	m_right_b_vec.clear();
-	bool su = m_solver_->solve(&at_b_vec[0], &m_x_[0]);
+
+	bool su = false;
+	if(m_schur_solver) {
+		// domain of each free variable, in internal index
+		vector<int> free_domain_vec(nb_free_variables_, -1);
+		for(int i=0; i<nb_variables_; i++) {
+			if (is_free(variable_[i].index())) {
+				free_domain_vec[variable_[i].index()] = m_var_domain_vec[i];
+			}
+		}
+		m_schur_solver->is_printf_info(m_is_printf_info);
+		su = m_schur_solver->solve(spm_ATA, free_domain_vec, at_b_vec, m_x_);
+	} else {
+		if(!m_solver_.get()) {
+			printf("factorize failed.\n");
+		} else {
+			su = m_solver_->solve(&at_b_vec[0], &m_x_[0]);
+		}
+	}
 	
 	if (!su)
 	{
@@ -296,9 +311,9 @@ void LinearSolver::factorize()
 			hj::sparse::spm_csc<double> spm_A;
 			CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_A, m_solve_matrix_AT_);
 
-			spm_dmm(false, spm_A, true, spm_A, spm_ATA);
+			sparse_multiply(false, spm_A, true, spm_A, spm_ATA);
 		}
-		m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
+		m_solver_.reset(SparseDirectSolver::create(spm_ATA));
 
 		if (m_is_printf_info){
 			watch_.print_elapsed_time();
@@ -326,6 +341,11 @@ void LinearSolver::equations_value(vector<double>& var_val_vec)
 
 	print_f(input_x_);
 }
+void LinearSolver::set_domain_solver(SchurSolver* p_schur_solver, const vector<int>& var_domain_vec)
+{
+	m_schur_solver = p_schur_solver;
+	m_var_domain_vec = var_domain_vec;
+}
 void LinearSolver::set_equation_div_flag()
 {
 	m_equ_div_flag_vec.push_back(m_equation_vec.size());
@@ -527,7 +547,7 @@ void LinearSolver::write_to_file(string ata_filename, string atb_filename)
 	hj::sparse::spm_csc<double> spm_ATA;
 	hj::sparse::spm_csc<double> spm_A;
 	CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_A, m_solve_matrix_AT_);
-	spm_dmm(false, spm_A, true, spm_A, spm_ATA);
+	sparse_multiply(false, spm_A, true, spm_A, spm_ATA);
 
 	//
 	zjucad::matrix::matrix<double> atb_(1, (int)at_b_vec.size());
@@ -15,6 +15,8 @@
 #include <hj_3rd/hjlib/sparse/sparse.h>
 #endif
 
+class SchurSolver;
+
 class LinearSolver: public Solver
 {
 public:
@@ -40,6 +42,9 @@ public:
 	void renew_right_b(vector<double>& right_b_vec);
 	void set_equation_div_flag();
 
+	//! solve by domain decomposition, var_domain_vec[i] is the domain of variable i
+	void set_domain_solver(SchurSolver* p_schur_solver, const vector<int>& var_domain_vec);
+
 	void equations_value(vector<double>& var_val_vec);
 	size_t get_equation_size(){return m_equation_vec.size();}
 
@@ -70,13 +75,16 @@ private:
 	vector<double> m_xc_;
 
 private:
-	//std::auto_ptr<hj::sparse::solver> m_solver_;
+	//std::auto_ptr<SparseDirectSolver> m_solver_;
 	CMeshSparseMatrix m_solve_matrix_AT_;
 	vector<double> m_solve_b_vec;
 
 private:
 	bool factorize_state;
 
+	SchurSolver* m_schur_solver;
+	vector<int> m_var_domain_vec;
+
 private:
 	vector<size_t> m_equ_div_flag_vec;
 	bool m_is_printf_info;
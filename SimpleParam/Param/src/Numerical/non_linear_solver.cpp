@@ -1,20 +1,198 @@
 #include "non_linear_solver.h"
 #include "../Common/stopwatch.h"
 #include "../Numerical/MatrixConverter.h"
+#include "../Common/Parallel.h"
+#include "sparse_cholesky.h"
 
-#ifdef WIN32
-#include <hj_3rd/hjlib/sparse_old/sparse_multi_cl.h>
-#else
-#include <hj_3rd/hjlib/sparse/sparse_multi_cl.h>
-#endif
 
 #include <math.h>
 #include <float.h>
 #include <memory>
+#include <algorithm>
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
-static mm_rtn cache;
+
+namespace
+{
+	//! value and derivatives of stencil instance k at xc_, written to its own slots of the value arrays
+	class StencilEvalPass
+	{
+	public:
+		StencilEvalPass(std::deque<OGF::StencilInstance>& _equation_vec, const vector<double>& _xc,
+			const vector<int>& _var_offset, const vector<int>& _hess_offset,
+			vector<double>& _function_vec, vector<double>& _grad_val, vector<double>* _hess_val)
+			: equation_vec(_equation_vec), xc(_xc), var_offset(_var_offset), hess_offset(_hess_offset),
+			function_vec(_function_vec), grad_val(_grad_val), hess_val(_hess_val) {}
+
+		void operator()(int k) const
+		{
+			OGF::StencilInstance& RS = equation_vec[k];
+			OGF::Stencil* S = RS.stencil() ;
+			int N = RS.nb_variables() ;
+			OGF::Symbolic::Context args ;
+
+			for(int i=0; i<N; i++) {
+				args.variables.push_back(xc[RS.global_variable_index(i)]) ;
+			}
+			for(int i=0; i<S->nb_parameters(); i++) {
+				args.parameters.push_back(RS.parameter(i)) ;
+			}
+
+			function_vec[k] = S->f(args);
+			for(int i=0; i<N; i++) {
+				grad_val[var_offset[k] + i] = S->g(i,args);
+			}
+			if(hess_val) {
+				int h = hess_offset[k];
+				for(int i=0; i<N; i++) {
+					for(int j=0; j<=i; j++) {
+						(*hess_val)[h++] = S->G(i,j,args);
+					}
+				}
+			}
+		}
+
+	private:
+		std::deque<OGF::StencilInstance>& equation_vec;
+		const vector<double>& xc;
+		const vector<int>& var_offset;
+		const vector<int>& hess_offset;
+		vector<double>& function_vec;
+		vector<double>& grad_val;
+		vector<double>* hess_val;
+	};
+
+	//! row k of the jacobi matrix, a variable appearing twice in a stencil gets the sum of its derivatives
+	class JacobiFillPass
+	{
+	public:
+		JacobiFillPass(const vector<int>& _var_offset, const vector<int>& _jacobi_slot,
+			const vector<double>& _grad_val, zjucad::matrix::matrix<double>& _jacobi_val)
+			: var_offset(_var_offset), jacobi_slot(_jacobi_slot), grad_val(_grad_val), jacobi_val(_jacobi_val) {}
+
+		void operator()(int k) const
+		{
+			for(int i=var_offset[k]; i<var_offset[k+1]; i++) {
+				if(jacobi_slot[i] >= 0) jacobi_val[jacobi_slot[i]] = 0.0;
+			}
+			for(int i=var_offset[k]; i<var_offset[k+1]; i++) {
+				if(jacobi_slot[i] >= 0) jacobi_val[jacobi_slot[i]] += grad_val[i];
+			}
+		}
+
+	private:
+		const vector<int>& var_offset;
+		const vector<int>& jacobi_slot;
+		const vector<double>& grad_val;
+		zjucad::matrix::matrix<double>& jacobi_val;
+	};
+
+	//! dst[i] = sum of src[pos[k]] for k in [ptr[i], ptr[i+1])
+	template <class Vec>
+	class ContributionSumPass
+	{
+	public:
+		ContributionSumPass(const vector<int>& _ptr, const vector<int>& _pos, const vector<double>& _src, Vec& _dst)
+			: ptr(_ptr), pos(_pos), src(_src), dst(_dst) {}
+
+		void operator()(int i) const
+		{
+			double sum_ = 0;
+			for(int k=ptr[i]; k<ptr[i+1]; k++) {
+				sum_ += src[pos[k]];
+			}
+			dst[i] = sum_;
+		}
+
+	private:
+		const vector<int>& ptr;
+		const vector<int>& pos;
+		const vector<double>& src;
+		Vec& dst;
+	};
+
+	//! g = JT*f, one variable (column of J) at a time
+	class JacobiTransMultiplyPass
+	{
+	public:
+		JacobiTransMultiplyPass(const hj::sparse::spm_csc<double>& _jacobi, const vector<double>& _f, vector<double>& _g)
+			: jacobi(_jacobi), f(_f), g(_g) {}
+
+		void operator()(int c) const
+		{
+			double sum_ = 0;
+			for(int k=jacobi.ptr_[c]; k<jacobi.ptr_[c+1]; k++) {
+				sum_ += jacobi.val_[k] * f[jacobi.idx_[k]];
+			}
+			g[c] = sum_;
+		}
+
+	private:
+		const hj::sparse::spm_csc<double>& jacobi;
+		const vector<double>& f;
+		vector<double>& g;
+	};
+
+	//! sum of the equation values at xc_, squared for least squares
+	class FunctionValueReduce
+	{
+	public:
+		FunctionValueReduce(std::deque<OGF::StencilInstance>& _equation_vec, const vector<double>& _xc, bool _squared)
+			: equation_vec(_equation_vec), xc(_xc), squared(_squared) {}
+
+		double operator()(int begin, int end, double rst_) const
+		{
+			OGF::Symbolic::Context args ;
+			for (int k = begin; k < end; k++)
+			{
+				OGF::StencilInstance& RS = equation_vec[k];
+				OGF::Stencil* S = RS.stencil() ;
+				int N = RS.nb_variables() ;
+
+				args.variables.clear();
+				args.parameters.clear();
+				for(int i=0; i<N; i++) {
+					args.variables.push_back(xc[RS.global_variable_index(i)]) ;
+				}
+				for(int i=0; i<S->nb_parameters(); i++) {
+					args.parameters.push_back(RS.parameter(i)) ;
+				}
+				double val_ = S->f(args) ;
+				rst_ += squared ? val_ * val_ : val_;
+			}
+			return rst_;
+		}
+
+	private:
+		std::deque<OGF::StencilInstance>& equation_vec;
+		const vector<double>& xc;
+		bool squared;
+	};
+
+	class VectorSumReduce
+	{
+	public:
+		VectorSumReduce(const vector<double>& _vec) : vec(_vec) {}
+
+		double operator()(int begin, int end, double sum_) const
+		{
+			for (int k = begin; k < end; k++) {
+				sum_ += vec[k];
+			}
+			return sum_;
+		}
+
+	private:
+		const vector<double>& vec;
+	};
+
+	class SumJoin
+	{
+	public:
+		double operator()(double a, double b) const { return a + b; }
+	};
+}
 
 NonLinearSolver::NonLinearSolver(int nb_variables) 
 : Solver(nb_variables) 
@@ -22,14 +200,20 @@ NonLinearSolver::NonLinearSolver(int nb_variables)
 	state_ = INITIAL ;
 	solve_method_ = GAUSS_NEWTON;
 	max_newton_iter_ = 15 ;
+	m_max_iter_set_ = false ;
 	gradient_threshold_ = 1e-3 ;
+	function_threshold_ = 0.0 ;
+	step_threshold_ = 0.0 ;
+	m_factor_ = NULL ;
 	m_stencil_use_hessian = false;
 	m_is_printf = true;
+	lbfgs_memory_ = 8;
 
 	::OGF::Logger::initialize();
 }
 NonLinearSolver::~NonLinearSolver() 
 {
+	clear_factor();
 	for(size_t i=0; i<stencil_.size(); i++) 
 	{
 		delete stencil_[i] ;
@@ -48,6 +232,12 @@ void NonLinearSolver::set_solve_method(NonLinearSolveMethod method_)
 		m_mu_ = -1.0;
 		m_nu_ = 2.0;
 	}
+
+	if (!m_max_iter_set_)
+	{
+		// each quasi newton step is cheap, but many more of them are needed than for newton
+		max_newton_iter_ = (method_ == QUASI_NEWTON) ? 1000 : 15;
+	}
 }
 //////////////////////////////////////////////////////////////////////
 // NonLinearSolver public methods
@@ -240,10 +430,27 @@ void NonLinearSolver::solve()
 {
 	ogf_assert(state_ == CONSTRUCTED) ;
 
+	build_stencil_pattern();
+	clear_factor();
+
 	int k = 0;
 	m_jacobi_ata_first_time = true;
+	m_lbfgs_first_iter = true;
+	m_lbfgs_fail_num = 0;
+	m_lbfgs_stalled = false;
+	m_lbfgs_s_.clear();
+	m_lbfgs_y_.clear();
+	m_lbfgs_rho_.clear();
+
+	double f_prev_ = 0;
+	bool has_f_prev_ = false;
+	vector<double> x_prev_;
 	for(; k<max_newton_iter_; k++) {
 
+		if (step_threshold_ > 0) {
+			x_prev_.assign(m_xc_.begin(), m_xc_.begin() + nb_free_variables_);
+		}
+
 		//
 		if (solve_method_ == GAUSS_NEWTON)
 		{
@@ -251,6 +458,10 @@ void NonLinearSolver::solve()
 		}
 		else if (solve_method_ == QUASI_NEWTON)
 		{
+			solve_one_iteration_lbfgs();
+			if (m_lbfgs_stalled) {
+				break ;
+			}
 		}
 		else if (solve_method_ == NEWTON)
 		{
@@ -276,10 +487,32 @@ void NonLinearSolver::solve()
 		if(gk_ < gradient_threshold_) {
 			break ;
 		}
+
+		if (step_threshold_ > 0) {
+			double dx2_ = 0, x2_ = 0;
+			for(int i=0; i<nb_free_variables_; i++) {
+				double d_ = m_xc_[i] - x_prev_[i];
+				dx2_ += d_ * d_;
+				x2_ += m_xc_[i] * m_xc_[i];
+			}
+			if (::sqrt(dx2_) < step_threshold_ * (::sqrt(x2_) + step_threshold_)) {
+				break ;
+			}
+		}
+
+		if (function_threshold_ > 0) {
+			double f_cur_ = (solve_method_ == QUASI_NEWTON) ? fk_ : f();
+			if (has_f_prev_ && fabs(f_prev_ - f_cur_) <= function_threshold_ * std::max(fabs(f_prev_), 1.0)) {
+				break ;
+			}
+			f_prev_ = f_cur_;
+			has_f_prev_ = true;
+		}
 	}
 	printf("iteration %d times.\n", k);
 
 	update_variables() ;
+	clear_factor();
 	state_ = MINIMIZED ;
 }
 void NonLinearSolver::solve_one_Levenberg_marquardt(double& mu_, double& nu_)
@@ -289,36 +522,47 @@ void NonLinearSolver::solve_one_Levenberg_marquardt(double& mu_, double& nu_)
 
 	//
 	SystemStopwatch watch_;
-	CMeshSparseMatrix JTJ;
+	hj::sparse::spm_csc<double> JTJ;
+	{
+		if(m_jacobi_ata_first_time) 
+		{
+			m_jacobi_ata_.analyze(true, m_Jacobi_, false, m_Jacobi_);
+			m_jacobi_ata_first_time = false;
+		}
+		m_jacobi_ata_.multiply(true, m_Jacobi_, false, m_Jacobi_, JTJ);
+	}
+
+	// position of the diagonal entries, the pattern does not change so only the values are refactorized
+	vector<int> diag_(JTJ.size(2), -1);
+	for (int c = 0; c < JTJ.size(2); c++)
 	{
-		CMeshSparseMatrix jacobian_matrix_AT;
-		m_Jacobi_.Transpose(jacobian_matrix_AT);
-		jacobian_matrix_AT.Multiply(m_Jacobi_, JTJ);
+		for (int k = JTJ.ptr_[c]; k < JTJ.ptr_[c+1]; k++)
+		{
+			if (JTJ.idx_[k] == c) diag_[c] = k;
+		}
 	}
 
 	// if first time
-	double avg_ii;
 	if (mu_ < 0)
 	{
-		mu_ = JTJ.MaxAii() * 1e-3;
-		avg_ii = JTJ.AvgAii();
+		double max_ii = 0;
+		for (size_t c = 0; c < diag_.size(); c++)
+		{
+			if (diag_[c] >= 0) max_ii = std::max(max_ii, (double) JTJ.val_[diag_[c]]);
+		}
+		mu_ = max_ii * 1e-3;
 	}
 
 	bool is_step_ok = false;
 	while (!is_step_ok)
 	{
 		// add \mu*I here.
-		for (int i = 0; i < JTJ.GetRowNum(); i++)
+		for (size_t c = 0; c < diag_.size(); c++)
 		{
-			JTJ.AddElement(i, i, mu_);
+			if (diag_[c] >= 0) JTJ.val_[diag_[c]] += mu_;
 		}
-		hj::sparse::spm_csc<double> spm_ATA;
-		CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_ATA, JTJ);
 
-		std::auto_ptr<hj::sparse::solver> m_solver_;
-		m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
-
-		bool su = m_solver_->solve(&m_gradient_[0], &m_dx_[0]);
+		bool su = factorize(JTJ) && m_factor_->solve(&m_gradient_[0], &m_dx_[0]);
 		if (!su)
 		{
 			printf("solve dx failed.\n");
@@ -363,9 +607,9 @@ void NonLinearSolver::solve_one_Levenberg_marquardt(double& mu_, double& nu_)
 		else
 		{
 			// remove \mu*I here.
-			for (int i = 0; i < JTJ.GetRowNum(); i++)
+			for (size_t c = 0; c < diag_.size(); c++)
 			{
-				JTJ.AddElement(i, i, -mu_);
+				if (diag_[c] >= 0) JTJ.val_[diag_[c]] -= mu_;
 			}
 
 			mu_ *= nu_;
@@ -374,6 +618,230 @@ void NonLinearSolver::solve_one_Levenberg_marquardt(double& mu_, double& nu_)
 	}
 	watch_.print_elapsed_time();
 }
+void NonLinearSolver::solve_one_iteration_lbfgs()
+{
+	if (m_lbfgs_first_iter)
+	{
+		fk_ = f_and_gradient(m_xc_, m_gradient_);
+		m_lbfgs_first_iter = false;
+	}
+
+	// d = -H * g
+	lbfgs_direction(m_gradient_, m_dx_);
+	double dg_ = vec_multiply_vec(m_dx_, m_gradient_);
+	if (dg_ >= 0)
+	{
+		// not a descent direction, restart from steepest descent
+		m_lbfgs_s_.clear();
+		m_lbfgs_y_.clear();
+		m_lbfgs_rho_.clear();
+		lbfgs_direction(m_gradient_, m_dx_);
+	}
+
+	// the first step has no curvature information, so scale it to unit length
+	bool steepest_ = m_lbfgs_s_.empty();
+	double alpha_ = 1.0;
+	if (steepest_)
+	{
+		double gnorm_ = norm_grad_f();
+		if (gnorm_ > 0) alpha_ = std::min(1.0, 1.0 / gnorm_);
+	}
+
+	vector<double> new_xc_(m_xc_);
+	vector<double> new_gradient_(nb_free_variables_);
+	double new_fk_ = fk_;
+	if (!line_search_strong_wolfe(m_dx_, alpha_, new_xc_, new_fk_, new_gradient_))
+	{
+		if (m_is_printf){
+			printf("line search failed.\n");
+		}
+		if (new_fk_ >= fk_)
+		{
+			// no decrease at all. retry along -g once, unless that is what failed
+			m_lbfgs_fail_num++;
+			if (steepest_ || m_lbfgs_fail_num >= 2)
+			{
+				m_lbfgs_stalled = true;
+				if (m_is_printf){
+					printf("no decrease along the steepest descent, stop.\n");
+				}
+				return;
+			}
+			m_lbfgs_s_.clear();
+			m_lbfgs_y_.clear();
+			m_lbfgs_rho_.clear();
+			return;
+		}
+	}
+	m_lbfgs_fail_num = 0;
+
+	// update the correction pairs
+	vector<double> s_(nb_free_variables_), y_(nb_free_variables_);
+	for(int i=0; i<nb_free_variables_; i++) {
+		s_[i] = new_xc_[i] - m_xc_[i];
+		y_[i] = new_gradient_[i] - m_gradient_[i];
+	}
+	double ys_ = vec_multiply_vec(y_, s_);
+	if (ys_ > DBL_EPSILON * vec_multiply_vec(y_, y_))
+	{
+		if ((int) m_lbfgs_s_.size() >= lbfgs_memory_)
+		{
+			m_lbfgs_s_.pop_front();
+			m_lbfgs_y_.pop_front();
+			m_lbfgs_rho_.pop_front();
+		}
+		m_lbfgs_s_.push_back(s_);
+		m_lbfgs_y_.push_back(y_);
+		m_lbfgs_rho_.push_back(1.0 / ys_);
+	}
+
+	m_xc_.swap(new_xc_);
+	m_gradient_.swap(new_gradient_);
+	fk_ = new_fk_;
+
+	if (m_is_printf){
+		printf("function value: %f, step: %f\n", fk_, alpha_);
+	}
+}
+void NonLinearSolver::lbfgs_direction(const vector<double>& grad_, vector<double>& dir_)
+{
+	// two-loop recursion
+	int m = (int) m_lbfgs_s_.size();
+	vector<double> alpha_(m);
+
+	dir_.resize(nb_free_variables_);
+	for(int i=0; i<nb_free_variables_; i++) {
+		dir_[i] = -grad_[i];
+	}
+	for (int k = m-1; k >= 0; k--)
+	{
+		alpha_[k] = m_lbfgs_rho_[k] * vec_multiply_vec(m_lbfgs_s_[k], dir_);
+		const vector<double>& y_ = m_lbfgs_y_[k];
+		for(int i=0; i<nb_free_variables_; i++) {
+			dir_[i] -= alpha_[k] * y_[i];
+		}
+	}
+
+	// initial hessian H0 = (s.y / y.y) I
+	if (m > 0)
+	{
+		double gamma_ = 1.0 / (m_lbfgs_rho_[m-1] * vec_multiply_vec(m_lbfgs_y_[m-1], m_lbfgs_y_[m-1]));
+		for(int i=0; i<nb_free_variables_; i++) {
+			dir_[i] *= gamma_;
+		}
+	}
+
+	for (int k = 0; k < m; k++)
+	{
+		double beta_ = m_lbfgs_rho_[k] * vec_multiply_vec(m_lbfgs_y_[k], dir_);
+		const vector<double>& s_ = m_lbfgs_s_[k];
+		for(int i=0; i<nb_free_variables_; i++) {
+			dir_[i] += (alpha_[k] - beta_) * s_[i];
+		}
+	}
+}
+bool NonLinearSolver::line_search_strong_wolfe(const vector<double>& dir_, double& alpha_, 
+	vector<double>& xc_, double& f_, vector<double>& grad_)
+{
+	// Nocedal & Wright, algorithm 3.5 and 3.6
+	const double c1 = 1e-4, c2 = 0.9;
+	const int max_eval = 20;
+
+	double f0_ = fk_;
+	double dg0_ = 0;
+	for(int i=0; i<nb_free_variables_; i++) {
+		dg0_ += m_gradient_[i] * dir_[i];
+	}
+	if (dg0_ >= 0) return false;
+
+	double alpha_lo = 0, f_lo = f0_, dg_lo = dg0_;
+	double alpha_hi = 0, f_hi = f0_;
+	bool bracketed = false;
+	double alpha_cur = alpha_;
+
+	double best_alpha = 0, best_f = f0_;
+	for (int eval = 0; eval < max_eval; eval++)
+	{
+		for(int i=0; i<nb_free_variables_; i++) {
+			xc_[i] = m_xc_[i] + alpha_cur * dir_[i];
+		}
+		double f_cur = f_and_gradient(xc_, grad_);
+		double dg_cur = 0;
+		for(int i=0; i<nb_free_variables_; i++) {
+			dg_cur += grad_[i] * dir_[i];
+		}
+		if (f_cur < best_f) {
+			best_f = f_cur;
+			best_alpha = alpha_cur;
+		}
+
+		if (f_cur > f0_ + c1 * alpha_cur * dg0_ || (eval > 0 && f_cur >= f_lo))
+		{
+			// sufficient decrease violated, the minimizer is in [lo, cur]
+			alpha_hi = alpha_cur; f_hi = f_cur;
+			bracketed = true;
+		}
+		else
+		{
+			if (fabs(dg_cur) <= -c2 * dg0_)
+			{
+				alpha_ = alpha_cur;
+				f_ = f_cur;
+				return true;
+			}
+			if (bracketed && dg_cur * (alpha_hi - alpha_lo) >= 0)
+			{
+				alpha_hi = alpha_lo; f_hi = f_lo;
+			}
+			else if (!bracketed && dg_cur >= 0)
+			{
+				alpha_hi = alpha_lo; f_hi = f_lo;
+				bracketed = true;
+			}
+			alpha_lo = alpha_cur; f_lo = f_cur; dg_lo = dg_cur;
+		}
+
+		// next trial step
+		if (bracketed)
+		{
+			// quadratic interpolation from lo, safeguarded by bisection
+			double d_alpha = alpha_hi - alpha_lo;
+			double denom = 2.0 * (f_hi - f_lo - dg_lo * d_alpha);
+			double next_alpha = alpha_lo + 0.5 * d_alpha;
+			if (fabs(denom) > DBL_MIN)
+			{
+				double trial = alpha_lo - dg_lo * d_alpha * d_alpha / denom;
+				double lo_ = std::min(alpha_lo, alpha_hi), hi_ = std::max(alpha_lo, alpha_hi);
+				if (trial > lo_ + 0.1 * (hi_ - lo_) && trial < hi_ - 0.1 * (hi_ - lo_)) {
+					next_alpha = trial;
+				}
+			}
+			if (fabs(next_alpha - alpha_lo) < DBL_EPSILON * std::max(1.0, alpha_lo)) break;
+			alpha_cur = next_alpha;
+		}
+		else
+		{
+			alpha_cur *= 2.0;
+		}
+	}
+
+	// no point satisfying the wolfe conditions, fall back to the best one seen
+	alpha_ = best_alpha;
+	for(int i=0; i<nb_free_variables_; i++) {
+		xc_[i] = m_xc_[i] + best_alpha * dir_[i];
+	}
+	f_ = f_and_gradient(xc_, grad_);
+	return false;
+}
+double NonLinearSolver::f_and_gradient(vector<double>& xc_, vector<double>& grad_)
+{
+	evaluate_stencils(xc_, false, false);
+
+	grad_.resize(nb_free_variables_);
+	parallel_for(0, nb_free_variables_, ContributionSumPass<vector<double> >(m_grad_ptr_, m_grad_pos_, m_eq_grad_val_, grad_));
+
+	return parallel_reduce(0, (int) m_function_vec_.size(), 0.0, VectorSumReduce(m_function_vec_), SumJoin());
+}
 void NonLinearSolver::solve_one_iteration_Lagrange_gaussian_newton()
 {
 	//
@@ -383,20 +851,20 @@ void NonLinearSolver::solve_one_iteration_Lagrange_gaussian_newton()
 	SystemStopwatch watch_;
 	hj::sparse::spm_csc<double> spm_ATA;
 	{
-		hj::sparse::spm_csc<double> spm_A;
-		CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_A, m_Jacobi_);
-
 		if(m_jacobi_ata_first_time) 
 		{
-			cache = spm_dmm(true, spm_A, false, spm_A);
+			m_jacobi_ata_.analyze(true, m_Jacobi_, false, m_Jacobi_);
 			m_jacobi_ata_first_time = false;
 		}
-		spm_dmm(true, spm_A, false, spm_A, spm_ATA, &cache);
+		m_jacobi_ata_.multiply(true, m_Jacobi_, false, m_Jacobi_, spm_ATA);
 	}
 
-	// solve 
-	std::auto_ptr<hj::sparse::solver> m_solver_;
-	m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
+	// solve, the pattern of JT * J does not change so only the first iteration is a full factorization
+	if (!factorize(spm_ATA)) {
+		printf("factorize failed.\n");
+		return;
+	}
+	SparseDirectSolver* m_solver_ = m_factor_;
 
 	//
 	vector<double> Winv_Gfk(nb_free_variables_);
@@ -460,22 +928,16 @@ void NonLinearSolver::solve_one_iteration_gaussian_newton()
 	SystemStopwatch watch_;
 	hj::sparse::spm_csc<double> spm_ATA;
 	{
-		hj::sparse::spm_csc<double> spm_A;
-		CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_A, m_Jacobi_);
-
 		if(m_jacobi_ata_first_time) 
 		{
-			cache = spm_dmm(true, spm_A, false, spm_A);
+			m_jacobi_ata_.analyze(true, m_Jacobi_, false, m_Jacobi_);
 			m_jacobi_ata_first_time = false;
 		}
-		spm_dmm(true, spm_A, false, spm_A, spm_ATA, &cache);
+		m_jacobi_ata_.multiply(true, m_Jacobi_, false, m_Jacobi_, spm_ATA);
 	}
 
-	// solve 
-	std::auto_ptr<hj::sparse::solver> m_solver_;
-	m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
-
-	bool su = m_solver_->solve(&m_gradient_[0], &m_dx_[0]);
+	// solve, the pattern of JT * J does not change so only the first iteration is a full factorization
+	bool su = factorize(spm_ATA) && m_factor_->solve(&m_gradient_[0], &m_dx_[0]);
 	watch_.print_elapsed_time();
 	if (!su)
 	{
@@ -489,44 +951,12 @@ void NonLinearSolver::solve_one_iteration_gaussian_newton()
 }
 void NonLinearSolver::instanciate_gaussian_newton()
 {
-	// if empty, init the jacobi matrix.
-	if (m_Jacobi_.GetRowNum() == 0)
-	{
-		int row_size = (int) m_equation_vec.size();
-		int col_size = nb_free_variables_;
-		m_Jacobi_.SetRowCol(row_size, col_size);
-	}
-	vector<double> function_vector(m_Jacobi_.GetRowNum());
-
 	// fill the jacobi matrix
-	for (size_t j = 0; j < m_equation_vec.size(); j++)
-	{
-		OGF::StencilInstance& RS = m_equation_vec[j];
-		int row_ = (int) j;
-		OGF::Stencil* S = RS.stencil() ;
-		int N = RS.nb_variables() ;
-		OGF::Symbolic::Context args ;
-
-		for(int i=0; i<N; i++) {
-			args.variables.push_back(m_xc_[RS.global_variable_index(i)]) ;
-		}
-		for(int i=0; i<S->nb_parameters(); i++) {
-			args.parameters.push_back(RS.parameter(i)) ;
-		}
-
-		for(int i=0; i<N; i++) {
-			int gi = RS.global_variable_index(i) ;
-			if(is_free(gi)) {
-				m_Jacobi_.SetElement(row_, gi, S->g(i,args));
-			}
-		}
-		function_vector[j] = S->f(args);
-	}
+	evaluate_stencils(m_xc_, true, false);
 
 	//  g = JT*f
-	CMeshSparseMatrix jacobian_matrix_AT;
-	m_Jacobi_.Transpose(jacobian_matrix_AT);
-	jacobian_matrix_AT.MultiplyVector(function_vector, m_gradient_);
+	m_gradient_.resize(nb_free_variables_);
+	parallel_for(0, nb_free_variables_, JacobiTransMultiplyPass(m_Jacobi_, m_function_vec_, m_gradient_));
 
 	//
 	double f2_sum_sum = 0;
@@ -538,7 +968,7 @@ void NonLinearSolver::instanciate_gaussian_newton()
 		double f2_sum = 0;
 		for (size_t j = start_equ; j < end_equ; j++)
 		{
-			f2_sum += function_vector[j] * function_vector[j];
+			f2_sum += m_function_vec_[j] * m_function_vec_[j];
 		}
 		f2_sum_sum += f2_sum;
 		printf("%d part: %f  ", i-1, f2_sum);
@@ -552,15 +982,9 @@ void NonLinearSolver::solve_one_iteration_newton()
 
 	//
 	SystemStopwatch watch_;
-	
-	hj::sparse::spm_csc<double> spm_ATA;
-	CMatrixConverter::CSparseMatrix2hjCscMatrix(spm_ATA, m_Hessian_);
-
-	// solve 
-	std::auto_ptr<hj::sparse::solver> m_solver_;
-	m_solver_.reset(hj::sparse::solver::create(spm_ATA, "cholmod"));
 
-	bool su = m_solver_->solve(&m_gradient_[0], &m_dx_[0]);
+	// solve, the hessian pattern does not change so only the first iteration is a full factorization
+	bool su = factorize(m_Hessian_) && m_factor_->solve(&m_gradient_[0], &m_dx_[0]);
 	watch_.print_elapsed_time();
 	if (!su)
 	{
@@ -578,57 +1002,199 @@ void NonLinearSolver::solve_one_iteration_newton()
 }
 void NonLinearSolver::instanciate_newton()
 {
-	// if empty, init the hessian matrix.
-	if (m_Hessian_.GetRowNum() == 0)
-	{
-		int row_size = nb_free_variables_;
-		int col_size = nb_free_variables_;
-		m_Hessian_.SetRowCol(row_size, col_size);
+	// fill the gradient and the hessian matrix
+	evaluate_stencils(m_xc_, false, true);
+
+	parallel_for(0, nb_free_variables_, 
+		ContributionSumPass<vector<double> >(m_grad_ptr_, m_grad_pos_, m_eq_grad_val_, m_gradient_));
+	parallel_for(0, (int) m_hess_ptr_.size() - 1, 
+		ContributionSumPass<zjucad::matrix::matrix<double> >(m_hess_ptr_, m_hess_pos_, m_eq_hess_val_, m_Hessian_.val_));
+}
+void NonLinearSolver::build_stencil_pattern()
+{
+	int equ_num = (int) m_equation_vec.size();
+
+	m_eq_var_offset_.assign(equ_num + 1, 0);
+	for (int k = 0; k < equ_num; k++) {
+		m_eq_var_offset_[k+1] = m_eq_var_offset_[k] + m_equation_vec[k].nb_variables();
 	}
+	int local_num = m_eq_var_offset_[equ_num];
 
-	// fill the hessian matrix
-	for (size_t k = 0; k < m_equation_vec.size(); k++)
-	{
+	m_function_vec_.assign(equ_num, 0.0);
+	m_eq_grad_val_.assign(local_num, 0.0);
+
+	// local derivatives summed into each free variable
+	m_grad_ptr_.assign(nb_free_variables_ + 1, 0);
+	for (int k = 0; k < equ_num; k++) {
 		OGF::StencilInstance& RS = m_equation_vec[k];
-		int row_ = (int) k;
-		OGF::Stencil* S = RS.stencil() ;
-		int N = RS.nb_variables() ;
-		OGF::Symbolic::Context args ;
+		for (int i = 0; i < RS.nb_variables(); i++) {
+			int gi = RS.global_variable_index(i) ;
+			if (is_free(gi)) m_grad_ptr_[gi+1]++;
+		}
+	}
+	for (int i = 0; i < nb_free_variables_; i++) m_grad_ptr_[i+1] += m_grad_ptr_[i];
+	m_grad_pos_.resize(m_grad_ptr_[nb_free_variables_]);
+	{
+		vector<int> fill_(m_grad_ptr_.begin(), m_grad_ptr_.end() - 1);
+		for (int k = 0; k < equ_num; k++) {
+			OGF::StencilInstance& RS = m_equation_vec[k];
+			for (int i = 0; i < RS.nb_variables(); i++) {
+				int gi = RS.global_variable_index(i) ;
+				if (is_free(gi)) m_grad_pos_[fill_[gi]++] = m_eq_var_offset_[k] + i;
+			}
+		}
+	}
 
-		for(int i=0; i<N; i++) {
-			args.variables.push_back(m_xc_[RS.global_variable_index(i)]) ;
+	// jacobi matrix, one column per free variable with the rows in increasing order
+	m_eq_jacobi_slot_.assign(local_num, -1);
+	if (solve_method_ == GAUSS_NEWTON || solve_method_ == LEVENBERG_MARQUARDT || solve_method_ == LAGRANGE_GAUSS_NEWTON)
+	{
+		vector<int> col_ptr_(nb_free_variables_ + 1, 0);
+		for (int k = 0; k < equ_num; k++) {
+			OGF::StencilInstance& RS = m_equation_vec[k];
+			for (int i = 0; i < RS.nb_variables(); i++) {
+				int gi = RS.global_variable_index(i) ;
+				if (!is_free(gi)) continue;
+				int j = 0;
+				while (j < i && RS.global_variable_index(j) != gi) j++;
+				if (j == i) col_ptr_[gi+1]++;
+			}
 		}
-		for(int i=0; i<S->nb_parameters(); i++) {
-			args.parameters.push_back(RS.parameter(i)) ;
+		for (int i = 0; i < nb_free_variables_; i++) col_ptr_[i+1] += col_ptr_[i];
+
+		m_Jacobi_.resize(equ_num, nb_free_variables_, col_ptr_[nb_free_variables_]);
+		for (int i = 0; i <= nb_free_variables_; i++) m_Jacobi_.ptr_[i] = col_ptr_[i];
+
+		vector<int> fill_(col_ptr_.begin(), col_ptr_.end() - 1);
+		for (int k = 0; k < equ_num; k++) {
+			OGF::StencilInstance& RS = m_equation_vec[k];
+			int offset_ = m_eq_var_offset_[k];
+			for (int i = 0; i < RS.nb_variables(); i++) {
+				int gi = RS.global_variable_index(i) ;
+				if (!is_free(gi)) continue;
+				int j = 0;
+				while (j < i && RS.global_variable_index(j) != gi) j++;
+				if (j < i) {
+					m_eq_jacobi_slot_[offset_ + i] = m_eq_jacobi_slot_[offset_ + j];
+				} else {
+					int slot_ = fill_[gi]++;
+					m_Jacobi_.idx_[slot_] = k;
+					m_Jacobi_.val_[slot_] = 0.0;
+					m_eq_jacobi_slot_[offset_ + i] = slot_;
+				}
+			}
 		}
+	}
 
-		//
-		for(int i=0; i<N; i++) {
-			int gi = RS.global_variable_index(i) ;
-			if(is_free(gi)) {
-				//
-				m_gradient_[gi] += S->g(i,args) ;
+	// hessian matrix, both triangles are stored
+	m_eq_hess_offset_.assign(equ_num + 1, 0);
+	m_eq_hess_val_.clear();
+	m_hess_ptr_.clear();
+	m_hess_pos_.clear();
+	if (solve_method_ == NEWTON)
+	{
+		for (int k = 0; k < equ_num; k++) {
+			int N = m_equation_vec[k].nb_variables();
+			m_eq_hess_offset_[k+1] = m_eq_hess_offset_[k] + N*(N+1)/2;
+		}
+		m_eq_hess_val_.assign(m_eq_hess_offset_[equ_num], 0.0);
+
+		vector<vector<int> > col_rows_(nb_free_variables_);
+		for (int k = 0; k < equ_num; k++) {
+			OGF::StencilInstance& RS = m_equation_vec[k];
+			for (int i = 0; i < RS.nb_variables(); i++) {
+				int gi = RS.global_variable_index(i) ;
+				if (!is_free(gi)) continue;
+				for (int j = 0; j <= i; j++) {
+					int gj = RS.global_variable_index(j) ;
+					if (!is_free(gj)) continue;
+					col_rows_[gj].push_back(gi);
+					col_rows_[gi].push_back(gj);
+				}
+			}
+		}
 
-				//
-				for(int j=0; j<=i; j++) {
+		int nnz_ = 0;
+		for (int c = 0; c < nb_free_variables_; c++) {
+			std::sort(col_rows_[c].begin(), col_rows_[c].end());
+			col_rows_[c].erase(std::unique(col_rows_[c].begin(), col_rows_[c].end()), col_rows_[c].end());
+			nnz_ += (int) col_rows_[c].size();
+		}
+		m_Hessian_.resize(nb_free_variables_, nb_free_variables_, nnz_);
+		for (int c = 0, k = 0; c < nb_free_variables_; c++) {
+			m_Hessian_.ptr_[c] = k;
+			for (size_t r = 0; r < col_rows_[c].size(); r++, k++) {
+				m_Hessian_.idx_[k] = col_rows_[c][r];
+				m_Hessian_.val_[k] = 0.0;
+			}
+		}
+		m_Hessian_.ptr_[nb_free_variables_] = nnz_;
+
+		// every local second derivative goes to (gi, gj), and to (gj, gi) when i != j
+		vector<int> entry_slot_;
+		for (int k = 0; k < equ_num; k++) {
+			OGF::StencilInstance& RS = m_equation_vec[k];
+			int h = m_eq_hess_offset_[k];
+			for (int i = 0; i < RS.nb_variables(); i++) {
+				int gi = RS.global_variable_index(i) ;
+				for (int j = 0; j <= i; j++, h++) {
 					int gj = RS.global_variable_index(j) ;
-					if(is_free(gj)) {
-						double gij = S->G(i,j,args) ;
-						if(gij != 0.0) {
-							m_Hessian_.AddElement(gi, gj, gij) ;
-
-							// G (Hessian) is symmetric, but watch out:
-							// do not add diagonal elements twice !!!
-							if(gi != gj) {
-								m_Hessian_.AddElement(gj, gi, gij) ;
-							}
-						}
+					if (!is_free(gi) || !is_free(gj)) continue;
+					const vector<int>& rows_ = col_rows_[gj];
+					entry_slot_.push_back(m_Hessian_.ptr_[gj] + (int) (std::lower_bound(rows_.begin(), rows_.end(), gi) - rows_.begin()));
+					entry_slot_.push_back(h);
+					if (i != j) {
+						const vector<int>& rows_t_ = col_rows_[gi];
+						entry_slot_.push_back(m_Hessian_.ptr_[gi] + (int) (std::lower_bound(rows_t_.begin(), rows_t_.end(), gj) - rows_t_.begin()));
+						entry_slot_.push_back(h);
 					}
 				}
 			}
 		}
+		m_hess_ptr_.assign(nnz_ + 1, 0);
+		for (size_t e = 0; e < entry_slot_.size(); e += 2) m_hess_ptr_[entry_slot_[e]+1]++;
+		for (int i = 0; i < nnz_; i++) m_hess_ptr_[i+1] += m_hess_ptr_[i];
+		m_hess_pos_.resize(m_hess_ptr_[nnz_]);
+		vector<int> fill_(m_hess_ptr_.begin(), m_hess_ptr_.end() - 1);
+		for (size_t e = 0; e < entry_slot_.size(); e += 2) m_hess_pos_[fill_[entry_slot_[e]]++] = entry_slot_[e+1];
+	}
+}
+void NonLinearSolver::evaluate_stencils(vector<double>& xc_, bool with_jacobi, bool with_hessian)
+{
+	int equ_num = (int) m_equation_vec.size();
+	parallel_for(0, equ_num, StencilEvalPass(m_equation_vec, xc_, m_eq_var_offset_, m_eq_hess_offset_,
+		m_function_vec_, m_eq_grad_val_, with_hessian ? &m_eq_hess_val_ : NULL));
+
+	if (with_jacobi) {
+		parallel_for(0, equ_num, JacobiFillPass(m_eq_var_offset_, m_eq_jacobi_slot_, m_eq_grad_val_, m_Jacobi_.val_));
 	}
 }
+bool NonLinearSolver::factorize(const hj::sparse::spm_csc<double>& A_)
+{
+	bool same_pattern = (m_factor_ != NULL && m_factor_mat_.rows_ == A_.rows_ &&
+		m_factor_mat_.ptr_.size() == A_.ptr_.size() && m_factor_mat_.idx_.size() == A_.idx_.size());
+	for (size_t i = 0; same_pattern && i < A_.ptr_.size(); i++) {
+		same_pattern = (m_factor_mat_.ptr_[i] == A_.ptr_[i]);
+	}
+	for (size_t i = 0; same_pattern && i < A_.idx_.size(); i++) {
+		same_pattern = (m_factor_mat_.idx_[i] == A_.idx_[i]);
+	}
+
+	if (same_pattern) {
+		m_factor_mat_.val_ = A_.val_;
+		if (m_factor_->set_value(&m_factor_mat_.val_[0])) return true;
+	}
+
+	clear_factor();
+	m_factor_mat_ = A_;
+	m_factor_ = SparseDirectSolver::create(m_factor_mat_);
+	return m_factor_ != NULL;
+}
+void NonLinearSolver::clear_factor()
+{
+	delete m_factor_;
+	m_factor_ = NULL;
+}
 void NonLinearSolver::update_variables()
 {
 	for(int i=0; i<nb_variables_; i++) {
@@ -649,36 +1215,9 @@ double NonLinearSolver::f()
 }
 double NonLinearSolver::f(vector<double>& xc_)
 {
-	double rst_ = 0;
-	for (size_t k = 0; k < m_equation_vec.size(); k++)
-	{
-		OGF::StencilInstance& RS = m_equation_vec[k];
-		int row_ = (int) k;
-		OGF::Stencil* S = RS.stencil() ;
-		int N = RS.nb_variables() ;
-		OGF::Symbolic::Context args ;
-
-		for(int i=0; i<N; i++) {
-			args.variables.push_back(xc_[RS.global_variable_index(i)]) ;
-		}
-		for(int i=0; i<S->nb_parameters(); i++) {
-			args.parameters.push_back(RS.parameter(i)) ;
-		}
-		double val_ = S->f(args) ;
-
-		//
-		if (solve_method_ == GAUSS_NEWTON ||
-			solve_method_ == LEVENBERG_MARQUARDT)
-		{
-			rst_ += val_ * val_;
-		}
-		else
-		{
-			rst_ += val_;
-		}
-	}
-
-	return rst_;
+	bool squared = (solve_method_ == GAUSS_NEWTON || solve_method_ == LEVENBERG_MARQUARDT);
+	return parallel_reduce(0, (int) m_equation_vec.size(), 0.0, 
+		FunctionValueReduce(m_equation_vec, xc_, squared), SumJoin());
 }
 double NonLinearSolver::vec_multiply_vec(vector<double>& vec_1, vector<double>& vec_2)
 {
@@ -3,6 +3,7 @@
 
 #include "MeshSparseMatrix.h"
 #include "solver.h"
+#include "sparse_product.h"
 #include "../Graphite/OGF/math/symbolic/symbolic.h"
 #include "../Graphite/OGF/math/symbolic/stencil.h"
 #include <vector>
@@ -14,6 +15,8 @@
 #include <hj_3rd/hjlib/sparse/sparse.h>
 #endif
 
+class SparseDirectSolver;
+
 enum NonLinearSolveMethod {
 	GAUSS_NEWTON, 
 	QUASI_NEWTON,
@@ -32,6 +35,15 @@ public:
 public:
 	void set_solve_method(NonLinearSolveMethod method_);
 	void is_printf_info(bool is_printf){m_is_printf=is_printf;}
+	//! the default depends on the method, 15 and 1000 for QUASI_NEWTON. a value set here is kept by set_solve_method
+	void set_max_iteration(int max_iter) { max_newton_iter_ = max_iter; m_max_iter_set_ = true; }
+	void set_gradient_threshold(double threshold) { gradient_threshold_ = threshold; }
+	//! stop when the objective decreases by less than threshold*max(|f|, 1), 0 disables the test
+	void set_function_threshold(double threshold) { function_threshold_ = threshold; }
+	//! stop when the step is shorter than threshold*(|x| + threshold), 0 disables the test
+	void set_step_threshold(double threshold) { step_threshold_ = threshold; }
+	//! number of correction pairs kept by QUASI_NEWTON (L-BFGS), memory is O(m*n)
+	void set_lbfgs_memory(int m) { lbfgs_memory_ = m > 0 ? m : 1; }
 	// __________________ Construction _____________________
 
 	void begin_equation() ;
@@ -92,8 +104,19 @@ private:
 
 	void solve_one_Levenberg_marquardt(double& mu_, double& nu_);
 
+	void solve_one_iteration_lbfgs();
+	void lbfgs_direction(const vector<double>& grad_, vector<double>& dir_);
+	bool line_search_strong_wolfe(const vector<double>& dir_, double& alpha_, 
+		vector<double>& xc_, double& f_, vector<double>& grad_);
+	double f_and_gradient(vector<double>& xc_, vector<double>& grad_);
+
 	void solve_one_iteration_Lagrange_gaussian_newton();
 
+	void build_stencil_pattern();
+	void evaluate_stencils(vector<double>& xc_, bool with_jacobi, bool with_hessian);
+	bool factorize(const hj::sparse::spm_csc<double>& A_);
+	void clear_factor();
+
 	void update_variables();
 
 	double f() ;
@@ -119,18 +142,45 @@ private:
 
 	vector<double> m_dx_ ;             // Unknown delta vector for the variables
 	vector<double> m_gradient_ ;               // -gradient
-	CMeshSparseMatrix m_Hessian_ ;    // Hessian 
-	CMeshSparseMatrix m_Jacobi_;
+	hj::sparse::spm_csc<double> m_Hessian_ ;	// Hessian 
+	hj::sparse::spm_csc<double> m_Jacobi_;		// one row per equation
+
+	// Stencil evaluation, the patterns are built once per solve and the values refilled every iteration
+	vector<double> m_function_vec_ ;	// value of each equation
+	vector<int> m_eq_var_offset_ ;		// first local variable of each equation
+	vector<int> m_eq_jacobi_slot_ ;		// position of each local variable in m_Jacobi_, -1 if locked
+	vector<double> m_eq_grad_val_ ;		// derivative by each local variable
+	vector<int> m_eq_hess_offset_ ;		// first local second derivative (lower triangle) of each equation
+	vector<double> m_eq_hess_val_ ;
+	vector<int> m_grad_ptr_, m_grad_pos_ ;	// local derivatives summed into each free variable
+	vector<int> m_hess_ptr_, m_hess_pos_ ;	// local second derivatives summed into each entry of m_Hessian_
+
+	// Factorization, only refactorized numerically while its pattern does not change
+	SparseDirectSolver* m_factor_ ;
+	hj::sparse::spm_csc<double> m_factor_mat_ ;
 	vector<double> m_xc_ ;              // Variables + constants
 	double fk_ ;             // value of the function at current step
 	double gk_ ;            // norm of the gradient at current step
 	bool m_jacobi_ata_first_time;
+	SparseProduct m_jacobi_ata_ ;		// pattern of JT * J, analyzed at the first time
 	double m_mu_;
 	double m_nu_;
 
 	// Tuning
 	int max_newton_iter_ ;
+	bool m_max_iter_set_ ;			// set by the user, set_solve_method leaves it
 	double gradient_threshold_ ;
+	double function_threshold_ ;
+	double step_threshold_ ;
+
+	// L-BFGS state
+	int lbfgs_memory_;
+	bool m_lbfgs_first_iter;
+	int m_lbfgs_fail_num;           // consecutive line searches without decrease
+	bool m_lbfgs_stalled;           // no decrease along -g either, the solve stops
+	std::deque< vector<double> > m_lbfgs_s_;  // x_{k+1} - x_k
+	std::deque< vector<double> > m_lbfgs_y_;  // g_{k+1} - g_k
+	std::deque<double> m_lbfgs_rho_;          // 1 / (y_k . s_k)
 
 	// Solve method
 	NonLinearSolveMethod solve_method_;
@@ -0,0 +1,338 @@
+#include "schur_solver.h"
+#include "../Common/Parallel.h"
+#include "../Common/stopwatch.h"
+
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <boost/scoped_ptr.hpp>
+
+namespace
+{
+	//! number of interface columns solved together, bounds the dense panel to n_interior*PANEL_SIZE
+	const int PANEL_SIZE = 32;
+
+	bool IsSameBlock(const hj::sparse::spm_csc<double>& mat, const vector<int>& ptr,
+		const vector<int>& idx, const vector<double>& val)
+	{
+		if(mat.ptr_.size() != ptr.size() || mat.idx_.size() != idx.size()) return false;
+		for(size_t k=0; k<ptr.size(); ++k) if(mat.ptr_[k] != ptr[k]) return false;
+		for(size_t k=0; k<idx.size(); ++k) if(mat.idx_[k] != idx[k]) return false;
+		for(size_t k=0; k<val.size(); ++k) if(mat.val_[k] != val[k]) return false;
+		return true;
+	}
+
+	bool IsSameCoupling(const SchurSolver::DomainBlock& block, const vector<int>& interface_index,
+		const vector<int>& ptr, const vector<int>& row, const vector<double>& val)
+	{
+		return block.interface_index == interface_index && block.coupling_ptr == ptr &&
+			block.coupling_row == row && block.coupling_val == val;
+	}
+
+	//! factorize the interior block of a domain and compute its Schur complement contribution
+	class DomainEliminatePass
+	{
+	public:
+		DomainEliminatePass(const hj::sparse::spm_csc<double>& _A, const vector<double>& _b,
+			const vector<int>& _local_index, const vector<int>& _interface_index,
+			vector<SchurSolver::DomainBlock>& _block_vec)
+			: A(_A), b(_b), local_index(_local_index), interface_index(_interface_index), block_vec(_block_vec) {}
+
+		void operator()(int d) const
+		{
+			SchurSolver::DomainBlock& block = block_vec[d];
+			const vector<int>& var_index = block.var_index;
+			int n_interior = (int) var_index.size();
+
+			block.reused = false;
+			block.schur_rhs.clear();
+			if(n_interior == 0)
+			{
+				block.factor.reset();
+				block.interface_index.clear();
+				block.schur_mat.clear();
+				return;
+			}
+
+			/// split the columns of the interior variables into the interior block and the coupling block
+			vector<int> ptr(n_interior+1, 0), idx;
+			vector<double> val;
+			map<int, vector<pair<int, double> > > coupling_col;
+			for(int c=0; c<n_interior; ++c)
+			{
+				int col = var_index[c];
+				for(int k=A.ptr_[col]; k<A.ptr_[col+1]; ++k)
+				{
+					int row = A.idx_[k];
+					if(interface_index[row] >= 0)
+					{
+						coupling_col[interface_index[row]].push_back(make_pair(c, (double) A.val_[k]));
+					}else
+					{
+						idx.push_back(local_index[row]);
+						val.push_back(A.val_[k]);
+					}
+				}
+				ptr[c+1] = (int) idx.size();
+			}
+
+			vector<int> coupling_index, coupling_ptr(1, 0), coupling_row;
+			vector<double> coupling_val;
+			for(map<int, vector<pair<int, double> > >::const_iterator it = coupling_col.begin(); it != coupling_col.end(); ++it)
+			{
+				coupling_index.push_back(it->first);
+				for(size_t k=0; k<it->second.size(); ++k)
+				{
+					coupling_row.push_back(it->second[k].first);
+					coupling_val.push_back(it->second[k].second);
+				}
+				coupling_ptr.push_back((int) coupling_row.size());
+			}
+
+			/// reuse the factorization when the interior block is unchanged, and the
+			/// Schur contribution too when the coupling block is unchanged as well
+			bool same_coupling = IsSameCoupling(block, coupling_index, coupling_ptr, coupling_row, coupling_val);
+			if(!same_coupling)
+			{
+				block.interface_index.swap(coupling_index);
+				block.coupling_ptr.swap(coupling_ptr);
+				block.coupling_row.swap(coupling_row);
+				block.coupling_val.swap(coupling_val);
+			}
+			if(block.factor.get() && IsSameBlock(block.interior_mat, ptr, idx, val))
+			{
+				block.reused = true;
+			}else
+			{
+				hj::sparse::spm_csc<double>& mat = block.interior_mat;
+				mat.resize(n_interior, n_interior, (int) idx.size());
+				for(size_t k=0; k<ptr.size(); ++k) mat.ptr_[k] = ptr[k];
+				for(size_t k=0; k<idx.size(); ++k) { mat.idx_[k] = idx[k]; mat.val_[k] = val[k]; }
+				block.factor.reset(SparseDirectSolver::create(mat));
+				if(!block.factor.get()) return;
+			}
+
+			/// schur_rhs = B^T * A_dd^-1 * b_d
+			int n_coupling = (int) block.interface_index.size();
+			vector<double> b_interior(n_interior), y(n_interior);
+			for(int c=0; c<n_interior; ++c) b_interior[c] = b[var_index[c]];
+			block.factor->solve(&b_interior[0], &y[0]);
+
+			block.schur_rhs.assign(n_coupling, 0.0);
+			for(int g=0; g<n_coupling; ++g)
+			{
+				for(int k=block.coupling_ptr[g]; k<block.coupling_ptr[g+1]; ++k)
+					block.schur_rhs[g] += block.coupling_val[k] * y[block.coupling_row[k]];
+			}
+
+			/// schur_mat = B^T * A_dd^-1 * B, one panel of columns at a time
+			if(block.reused && same_coupling && (int) block.schur_mat.size() == n_coupling*n_coupling) return;
+			block.schur_mat.assign(n_coupling*n_coupling, 0.0);
+			vector<double> panel_b, panel_x;
+			for(int first=0; first<n_coupling; first+=PANEL_SIZE)
+			{
+				int panel_num = std::min(PANEL_SIZE, n_coupling-first);
+				panel_b.assign(n_interior*panel_num, 0.0);
+				panel_x.assign(n_interior*panel_num, 0.0);
+				for(int p=0; p<panel_num; ++p)
+				{
+					int g = first + p;
+					for(int k=block.coupling_ptr[g]; k<block.coupling_ptr[g+1]; ++k)
+						panel_b[p*n_interior + block.coupling_row[k]] = block.coupling_val[k];
+				}
+				block.factor->solve(&panel_b[0], &panel_x[0], panel_num);
+
+				for(int g=0; g<n_coupling; ++g)
+				{
+					for(int p=0; p<panel_num; ++p)
+					{
+						double sum = 0;
+						for(int k=block.coupling_ptr[g]; k<block.coupling_ptr[g+1]; ++k)
+							sum += block.coupling_val[k] * panel_x[p*n_interior + block.coupling_row[k]];
+						block.schur_mat[(first+p)*n_coupling + g] = sum;
+					}
+				}
+			}
+		}
+
+	private:
+		const hj::sparse::spm_csc<double>& A;
+		const vector<double>& b;
+		const vector<int>& local_index;
+		const vector<int>& interface_index;
+		vector<SchurSolver::DomainBlock>& block_vec;
+	};
+
+	//! x_d = A_dd^-1 * (b_d - B * x_interface)
+	class DomainBackSubstitutePass
+	{
+	public:
+		DomainBackSubstitutePass(const vector<double>& _b, const vector<double>& _x_interface,
+			vector<SchurSolver::DomainBlock>& _block_vec, vector<double>& _x)
+			: b(_b), x_interface(_x_interface), block_vec(_block_vec), x(_x) {}
+
+		void operator()(int d) const
+		{
+			SchurSolver::DomainBlock& block = block_vec[d];
+			const vector<int>& var_index = block.var_index;
+			int n_interior = (int) var_index.size();
+			if(n_interior == 0 || !block.factor.get()) return;
+
+			vector<double> rhs(n_interior), y(n_interior);
+			for(int c=0; c<n_interior; ++c) rhs[c] = b[var_index[c]];
+			for(size_t g=0; g<block.interface_index.size(); ++g)
+			{
+				double x_g = x_interface[block.interface_index[g]];
+				for(int k=block.coupling_ptr[g]; k<block.coupling_ptr[g+1]; ++k)
+					rhs[block.coupling_row[k]] -= block.coupling_val[k] * x_g;
+			}
+			block.factor->solve(&rhs[0], &y[0]);
+
+			for(int c=0; c<n_interior; ++c) x[var_index[c]] = y[c];
+		}
+
+	private:
+		const vector<double>& b;
+		const vector<double>& x_interface;
+		vector<SchurSolver::DomainBlock>& block_vec;
+		vector<double>& x;
+	};
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+SchurSolver::SchurSolver() : m_reused_num(0), m_is_printf_info(true)
+{
+}
+SchurSolver::~SchurSolver()
+{
+}
+//////////////////////////////////////////////////////////////////////
+// public methods
+//////////////////////////////////////////////////////////////////////
+void SchurSolver::clear()
+{
+	m_domain_block_vec.clear();
+	m_reused_num = 0;
+}
+bool SchurSolver::solve(const hj::sparse::spm_csc<double>& A, const vector<int>& var_domain_vec,
+						const vector<double>& b, vector<double>& x)
+{
+	SystemStopwatch watch_;
+
+	int var_num = A.size(2);
+	x.assign(var_num, 0.0);
+
+	/// a variable is on the interface when it couples with another domain
+	int domain_num = 0;
+	vector<int> interface_index(var_num, -1);
+	vector<int> interface_var;
+	for(int i=0; i<var_num; ++i)
+	{
+		int domain = var_domain_vec[i];
+		domain_num = std::max(domain_num, domain+1);
+		bool is_interface = (domain < 0);
+		for(int k=A.ptr_[i]; k<A.ptr_[i+1] && !is_interface; ++k)
+		{
+			if(var_domain_vec[A.idx_[k]] != domain) is_interface = true;
+		}
+		if(is_interface)
+		{
+			interface_index[i] = (int) interface_var.size();
+			interface_var.push_back(i);
+		}
+	}
+
+	/// interior variables of each domain, in increasing global order
+	m_domain_block_vec.resize(domain_num);
+	for(int d=0; d<domain_num; ++d) m_domain_block_vec[d].var_index.clear();
+
+	vector<int> local_index(var_num, -1);
+	for(int i=0; i<var_num; ++i)
+	{
+		if(interface_index[i] >= 0) continue;
+		vector<int>& var_index = m_domain_block_vec[var_domain_vec[i]].var_index;
+		local_index[i] = (int) var_index.size();
+		var_index.push_back(i);
+	}
+
+	parallel_for(0, domain_num, DomainEliminatePass(A, b, local_index, interface_index, m_domain_block_vec), 1);
+
+	m_reused_num = 0;
+	for(int d=0; d<domain_num; ++d)
+	{
+		const DomainBlock& block = m_domain_block_vec[d];
+		if(!block.var_index.empty() && !block.factor.get())
+		{
+			printf("factorize domain %d failed.\n", d);
+			return false;
+		}
+		if(block.reused) ++m_reused_num;
+	}
+
+	/// interface system S = A_ii - sum_d B_d^T A_dd^-1 B_d, assembled in domain order
+	int interface_num = (int) interface_var.size();
+	vector<double> x_interface(interface_num, 0.0);
+	if(interface_num > 0)
+	{
+		/// the columns are kept as maps while the contributions are summed, then copied to csc
+		vector<map<int, double> > schur_col(interface_num);
+		vector<double> schur_b(interface_num);
+		for(int g=0; g<interface_num; ++g)
+		{
+			int col = interface_var[g];
+			schur_b[g] = b[col];
+			for(int k=A.ptr_[col]; k<A.ptr_[col+1]; ++k)
+			{
+				int row = interface_index[A.idx_[k]];
+				if(row >= 0) schur_col[g][row] += A.val_[k];
+			}
+		}
+		for(int d=0; d<domain_num; ++d)
+		{
+			const DomainBlock& block = m_domain_block_vec[d];
+			int n_coupling = (int) block.interface_index.size();
+			for(int g=0; g<n_coupling; ++g)
+			{
+				schur_b[block.interface_index[g]] -= block.schur_rhs[g];
+				map<int, double>& col = schur_col[block.interface_index[g]];
+				for(int h=0; h<n_coupling; ++h)
+					col[block.interface_index[h]] -= block.schur_mat[g*n_coupling + h];
+			}
+		}
+
+		int nnz = 0;
+		for(int g=0; g<interface_num; ++g) nnz += (int) schur_col[g].size();
+		hj::sparse::spm_csc<double> schur_mat(interface_num, interface_num, nnz);
+		schur_mat.ptr_[0] = 0;
+		for(int g=0, k=0; g<interface_num; ++g)
+		{
+			for(map<int, double>::const_iterator it = schur_col[g].begin(); it != schur_col[g].end(); ++it, ++k)
+			{
+				schur_mat.idx_[k] = it->first;
+				schur_mat.val_[k] = it->second;
+			}
+			schur_mat.ptr_[g+1] = k;
+		}
+		boost::scoped_ptr<SparseDirectSolver> schur_solver(SparseDirectSolver::create(schur_mat));
+		if(!schur_solver.get() || !schur_solver->solve(&schur_b[0], &x_interface[0]))
+		{
+			printf("solve interface system failed.\n");
+			return false;
+		}
+		for(int g=0; g<interface_num; ++g) x[interface_var[g]] = x_interface[g];
+	}
+
+	parallel_for(0, domain_num, DomainBackSubstitutePass(b, x_interface, m_domain_block_vec, x), 1);
+
+	/// the Schur contributions stay for the next solve, only the right hand sides are dropped
+	for(int d=0; d<domain_num; ++d) m_domain_block_vec[d].schur_rhs.clear();
+
+	if(m_is_printf_info)
+	{
+		printf("schur solve: %d domains (%d reused), %d interface variables\n", domain_num, m_reused_num, interface_num);
+		watch_.print_elapsed_time();
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+//
+// Domain decomposition solver for sparse symmetric positive definite systems.
+// The interior variables of each domain are eliminated independently, then
+// the Schur complement on the interface variables is solved and the interior
+// values are recovered by back substitution per domain.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef SCHUR_SOLVER_H
+#define SCHUR_SOLVER_H
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "sparse_cholesky.h"
+using namespace std;
+
+class SchurSolver
+{
+public:
+	// interior block of one domain, kept between solves so that an unchanged
+	// block reuses its factorization
+	class DomainBlock
+	{
+	public:
+		vector<int> var_index;					// global index of the interior variables
+		hj::sparse::spm_csc<double> interior_mat;
+		boost::shared_ptr<SparseDirectSolver> factor;
+
+		vector<int> interface_index;			// interface variables coupled with this domain
+		vector<int> coupling_ptr;				// coupling block in csc form, columns are interface_index
+		vector<int> coupling_row;
+		vector<double> coupling_val;
+
+		vector<double> schur_mat;				// dense contribution to the interface system, kept between
+												// solves and rebuilt only when the block or the coupling changes
+		vector<double> schur_rhs;
+		bool reused;
+	};
+
+public:
+	SchurSolver();
+	~SchurSolver();
+
+	//! drop the cached factorizations
+	void clear();
+
+	//! solve A x = b, var_domain_vec[i] is the domain of variable i, a negative
+	//! domain puts the variable on the interface
+	bool solve(const hj::sparse::spm_csc<double>& A, const vector<int>& var_domain_vec,
+		const vector<double>& b, vector<double>& x);
+
+	int get_domain_num() const { return (int) m_domain_block_vec.size(); }
+	int get_reused_num() const { return m_reused_num; }
+
+	void is_printf_info(bool is_) { m_is_printf_info = is_; }
+
+private:
+	vector<DomainBlock> m_domain_block_vec;
+	int m_reused_num;
+	bool m_is_printf_info;
+};
+
+#endif
@@ -0,0 +1,878 @@
+#include "sparse_cholesky.h"
+#include "../Common/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdio.h>
+#include <boost/scoped_ptr.hpp>
+
+namespace
+{
+	//! parts of the nested dissection up to this size are ordered by minimum degree
+	const int ND_LEAF_SIZE = 64;
+	//! number of columns factorized together before the trailing update
+	const int PANEL_SIZE = 32;
+	//! fronts above this many flops run their dense kernels on all threads
+	const double PARALLEL_FRONT_FLOPS = 4.0e6;
+
+	//! symmetric pattern of the matrix without the diagonal, neighbors of v are adj[ptr[v] .. ptr[v+1]-1]
+	class Graph
+	{
+	public:
+		vector<int> ptr;
+		vector<int> adj;
+
+		int size() const { return (int) ptr.size() - 1; }
+		int degree(int v) const { return ptr[v+1] - ptr[v]; }
+	};
+
+	void BuildGraph(const hj::sparse::spm_csc<double>& A, Graph& g)
+	{
+		int n = (int) A.size(2);
+		g.ptr.assign(n+1, 0);
+		for(int c=0; c<n; ++c)
+		{
+			for(int k=(int) A.ptr_[c]; k<(int) A.ptr_[c+1]; ++k)
+			{
+				int r = (int) A.idx_[k];
+				if(r == c) continue;
+				++g.ptr[r+1];
+				++g.ptr[c+1];
+			}
+		}
+		for(int v=0; v<n; ++v) g.ptr[v+1] += g.ptr[v];
+
+		g.adj.resize(g.ptr[n]);
+		vector<int> pos(g.ptr.begin(), g.ptr.end()-1);
+		for(int c=0; c<n; ++c)
+		{
+			for(int k=(int) A.ptr_[c]; k<(int) A.ptr_[c+1]; ++k)
+			{
+				int r = (int) A.idx_[k];
+				if(r == c) continue;
+				g.adj[pos[r]++] = c;
+				g.adj[pos[c]++] = r;
+			}
+		}
+
+		//! both triangles give every edge twice
+		int m = 0;
+		for(int v=0; v<n; ++v)
+		{
+			vector<int>::iterator first = g.adj.begin() + g.ptr[v];
+			vector<int>::iterator last = g.adj.begin() + g.ptr[v+1];
+			sort(first, last);
+			last = unique(first, last);
+			g.ptr[v] = m;
+			for(vector<int>::iterator it = first; it != last; ++it) g.adj[m++] = *it;
+		}
+		g.ptr[n] = m;
+		g.adj.resize(m);
+	}
+
+	//! minimum degree order of a small part on its elimination graph, edges leaving the part are ignored
+	void MinimumDegree(const Graph& g, const vector<int>& part, vector<int>& local, int* order)
+	{
+		int m = (int) part.size();
+		for(int i=0; i<m; ++i) local[part[i]] = i;
+
+		vector< vector<int> > nb(m);
+		for(int i=0; i<m; ++i)
+		{
+			int v = part[i];
+			for(int k=g.ptr[v]; k<g.ptr[v+1]; ++k)
+			{
+				if(local[g.adj[k]] >= 0) nb[i].push_back(local[g.adj[k]]);
+			}
+			sort(nb[i].begin(), nb[i].end());
+		}
+
+		vector<char> done(m, 0);
+		vector<int> merged;
+		for(int step=0; step<m; ++step)
+		{
+			int best = -1;
+			for(int i=0; i<m; ++i)
+			{
+				if(!done[i] && (best < 0 || nb[i].size() < nb[best].size())) best = i;
+			}
+			order[step] = part[best];
+			done[best] = 1;
+
+			//! the neighbors of the eliminated vertex become a clique
+			vector<int>& clique = nb[best];
+			for(size_t a=0; a<clique.size(); ++a)
+			{
+				vector<int>& na = nb[clique[a]];
+				na.erase(find(na.begin(), na.end(), best));
+				merged.clear();
+				set_union(na.begin(), na.end(), clique.begin(), clique.end(), back_inserter(merged));
+				merged.erase(find(merged.begin(), merged.end(), clique[a]));
+				na.swap(merged);
+			}
+			vector<int>().swap(clique);
+		}
+
+		for(int i=0; i<m; ++i) local[part[i]] = -1;
+	}
+
+	//! nested dissection by level structure separators, order[k] is the vertex eliminated k-th
+	class NestedDissection
+	{
+	public:
+		NestedDissection(const Graph& _g, vector<int>& _order)
+			: g(_g), order(_order), in_part(_g.size(), 0), seen(_g.size(), 0),
+			level(_g.size(), 0), local(_g.size(), -1), stamp(0) {}
+
+		void run()
+		{
+			int n = g.size();
+			order.resize(n);
+			vector<int> all(n);
+			for(int v=0; v<n; ++v) all[v] = v;
+			dissect(all, 0);
+		}
+
+	private:
+		//! breadth first search inside the current part, returns the number of levels
+		int bfs(int root, int part_stamp, vector<int>& queue)
+		{
+			int s = ++stamp;
+			queue.clear();
+			queue.push_back(root);
+			seen[root] = s;
+			level[root] = 0;
+			for(size_t head=0; head<queue.size(); ++head)
+			{
+				int v = queue[head];
+				for(int k=g.ptr[v]; k<g.ptr[v+1]; ++k)
+				{
+					int w = g.adj[k];
+					if(in_part[w] == part_stamp && seen[w] != s)
+					{
+						seen[w] = s;
+						level[w] = level[v] + 1;
+						queue.push_back(w);
+					}
+				}
+			}
+			return level[queue.back()] + 1;
+		}
+
+		//! order the vertices of part into order[first ..]
+		void dissect(vector<int>& part, int first)
+		{
+			int m = (int) part.size();
+			if(m <= ND_LEAF_SIZE)
+			{
+				MinimumDegree(g, part, local, &order[first]);
+				return;
+			}
+
+			int part_stamp = ++stamp;
+			for(int i=0; i<m; ++i) in_part[part[i]] = part_stamp;
+
+			//! disconnected parts are ordered one component after another
+			vector<int> queue;
+			bfs(part[0], part_stamp, queue);
+			if((int) queue.size() < m)
+			{
+				vector< vector<int> > components;
+				vector<char> taken(m, 0);
+				int comp_stamp = ++stamp;
+				for(int i=0; i<m; ++i)
+				{
+					if(seen[part[i]] == comp_stamp || taken[i]) continue;
+					bfs(part[i], part_stamp, queue);
+					for(size_t k=0; k<queue.size(); ++k) seen[queue[k]] = comp_stamp;
+					components.push_back(queue);
+				}
+				for(size_t c=0; c<components.size(); ++c)
+				{
+					dissect(components[c], first);
+					first += (int) components[c].size();
+				}
+				return;
+			}
+
+			//! pseudo-peripheral root, the deepest level structure found from a thin end
+			int depth = bfs(part[0], part_stamp, queue);
+			for(int iter=0; iter<4; ++iter)
+			{
+				int root = -1;
+				for(size_t k=queue.size(); k>0 && level[queue[k-1]] == depth-1; --k)
+				{
+					if(root < 0 || g.degree(queue[k-1]) < g.degree(root)) root = queue[k-1];
+				}
+				vector<int> candidate;
+				int candidate_depth = bfs(root, part_stamp, candidate);
+				if(candidate_depth <= depth)
+				{
+					bfs(queue[0], part_stamp, queue);
+					break;
+				}
+				depth = candidate_depth;
+				queue.swap(candidate);
+			}
+			if(depth < 3)
+			{
+				MinimumDegree(g, part, local, &order[first]);
+				return;
+			}
+
+			//! the median level, trimmed to the vertices touching the next level, separates the part
+			int mid = level[queue[m/2]];
+			mid = std::max(1, std::min(mid, depth-2));
+			vector<int> part_a, part_b, separator;
+			for(int i=0; i<m; ++i)
+			{
+				int v = queue[i];
+				if(level[v] < mid) part_a.push_back(v);
+				else if(level[v] > mid) part_b.push_back(v);
+				else
+				{
+					bool touch = false;
+					for(int k=g.ptr[v]; k<g.ptr[v+1] && !touch; ++k)
+					{
+						int w = g.adj[k];
+						touch = (in_part[w] == part_stamp && level[w] == mid+1);
+					}
+					if(touch) separator.push_back(v);
+					else part_a.push_back(v);
+				}
+			}
+			vector<int>().swap(queue);
+
+			int size_a = (int) part_a.size(), size_b = (int) part_b.size();
+			for(size_t k=0; k<separator.size(); ++k) order[first+size_a+size_b+k] = separator[k];
+			dissect(part_a, first);
+			dissect(part_b, first+size_a);
+		}
+
+	private:
+		const Graph& g;
+		vector<int>& order;
+		vector<int> in_part;
+		vector<int> seen;
+		vector<int> level;
+		vector<int> local;
+		int stamp;
+	};
+
+	//! column c of the trailing part of a front minus the panel [p, p+nb)
+	class TrailingUpdatePass
+	{
+	public:
+		TrailingUpdatePass(double* _F, int _N, int _p, int _nb, const double* _D)
+			: F(_F), N(_N), p(_p), nb(_nb), D(_D) {}
+
+		void operator()(int c) const
+		{
+			double* cc = F + (size_t) c*N;
+			int jj = p;
+
+			//! four panel columns at a time, so that the column is stored once for each four
+			for(; jj+4<=p+nb; jj+=4)
+			{
+				const double* c0 = F + (size_t) jj*N;
+				const double* c1 = c0+N;
+				const double* c2 = c1+N;
+				const double* c3 = c2+N;
+				double w0 = c0[c], w1 = c1[c], w2 = c2[c], w3 = c3[c];
+				if(D)
+				{
+					w0 *= D[jj];
+					w1 *= D[jj+1];
+					w2 *= D[jj+2];
+					w3 *= D[jj+3];
+				}
+				for(int r=c; r<N; ++r) cc[r] -= c0[r]*w0 + c1[r]*w1 + c2[r]*w2 + c3[r]*w3;
+			}
+			for(; jj<p+nb; ++jj)
+			{
+				const double* cjj = F + (size_t) jj*N;
+				double w = D ? cjj[c]*D[jj] : cjj[c];
+				if(w == 0.0) continue;
+				for(int r=c; r<N; ++r) cc[r] -= cjj[r]*w;
+			}
+		}
+
+	private:
+		double* F;
+		int N, p, nb;
+		const double* D;
+	};
+
+	//! eliminate the first K columns of the N x N lower front F (column-major), which
+	//! leaves L in those columns and the update matrix in the trailing block. D is NULL for L L^T
+	bool PartialFactor(double* F, int N, int K, double* D, bool inner_parallel)
+	{
+		for(int p=0; p<K; p+=PANEL_SIZE)
+		{
+			int nb = std::min(PANEL_SIZE, K-p);
+
+			//! the panel, left-looking inside it
+			for(int j=p; j<p+nb; ++j)
+			{
+				double* cj = F + (size_t) j*N;
+				for(int jj=p; jj<j; ++jj)
+				{
+					const double* cjj = F + (size_t) jj*N;
+					double w = D ? cjj[j]*D[jj] : cjj[j];
+					if(w == 0.0) continue;
+					for(int r=j; r<N; ++r) cj[r] -= cjj[r]*w;
+				}
+
+				double d = cj[j];
+				if(D)
+				{
+					if(d == 0.0 || !(fabs(d) < HUGE_VAL)) return false;
+					D[j] = d;
+					cj[j] = 1.0;
+				}else
+				{
+					if(!(d > 0.0) || !(d < HUGE_VAL)) return false;
+					d = sqrt(d);
+					cj[j] = d;
+				}
+				double inv = 1.0/d;
+				for(int r=j+1; r<N; ++r) cj[r] *= inv;
+			}
+
+			//! the columns after the panel, the rest of L and the update matrix
+			int first = p+nb;
+			if(first >= N) continue;
+			TrailingUpdatePass update(F, N, p, nb, D);
+			double flops = (double) (N-first) * (N-first) * nb;
+			if(inner_parallel && flops > PARALLEL_FRONT_FLOPS)
+			{
+				parallel_for(first, N, update, 4);
+			}else
+			{
+				for(int c=first; c<N; ++c) update(c);
+			}
+		}
+		return true;
+	}
+
+	class FactorSupernodePass
+	{
+	public:
+		typedef void (SparseCholesky::*Method)(int, const double*, bool);
+
+		FactorSupernodePass(SparseCholesky* _solver, Method _method, const int* _super, const double* _val)
+			: solver(_solver), method(_method), super(_super), val(_val) {}
+
+		void operator()(int i) const { (solver->*method)(super[i], val, false); }
+
+	private:
+		SparseCholesky* solver;
+		Method method;
+		const int* super;
+		const double* val;
+	};
+
+	//! forward and backward substitution of one right hand side
+	class SubstitutePass
+	{
+	public:
+		SubstitutePass(const vector<int>& _super_ptr, const vector<int>& _row_ptr, const vector<int>& _row_idx,
+			const vector<size_t>& _factor_ptr, const vector<double>& _factor, const vector<double>& _diag,
+			bool _ldlt, double* _y, int _n)
+			: super_ptr(_super_ptr), row_ptr(_row_ptr), row_idx(_row_idx), factor_ptr(_factor_ptr),
+			factor(_factor), diag(_diag), ldlt(_ldlt), y(_y), n(_n) {}
+
+		void operator()(int r) const
+		{
+			double* x = y + (size_t) r*n;
+			int ns = (int) super_ptr.size() - 1;
+
+			/// L z = b, supernodes in postorder
+			for(int s=0; s<ns; ++s)
+			{
+				int f = super_ptr[s], ncol = super_ptr[s+1]-f;
+				int nrow = row_ptr[s+1]-row_ptr[s];
+				const int* rows = &row_idx[row_ptr[s]];
+				const double* L = &factor[factor_ptr[s]];
+				for(int j=0; j<ncol; ++j)
+				{
+					const double* col = L + (size_t) j*nrow;
+					double xj = x[f+j];
+					if(!ldlt) xj /= col[j];
+					x[f+j] = xj;
+					if(xj == 0.0) continue;
+					for(int i=j+1; i<nrow; ++i) x[rows[i]] -= col[i]*xj;
+				}
+			}
+
+			if(ldlt)
+			{
+				for(int k=0; k<n; ++k) x[k] /= diag[k];
+			}
+
+			/// L^T x = z, supernodes in reverse
+			for(int s=ns-1; s>=0; --s)
+			{
+				int f = super_ptr[s], ncol = super_ptr[s+1]-f;
+				int nrow = row_ptr[s+1]-row_ptr[s];
+				const int* rows = &row_idx[row_ptr[s]];
+				const double* L = &factor[factor_ptr[s]];
+				for(int j=ncol-1; j>=0; --j)
+				{
+					const double* col = L + (size_t) j*nrow;
+					double sum = x[f+j];
+					for(int i=j+1; i<nrow; ++i) sum -= col[i]*x[rows[i]];
+					if(!ldlt) sum /= col[j];
+					x[f+j] = sum;
+				}
+			}
+		}
+
+	private:
+		const vector<int>& super_ptr;
+		const vector<int>& row_ptr;
+		const vector<int>& row_idx;
+		const vector<size_t>& factor_ptr;
+		const vector<double>& factor;
+		const vector<double>& diag;
+		bool ldlt;
+		double* y;
+		int n;
+	};
+
+#ifdef WIN32
+	//! the cholmod build of the library
+	class CholmodSolver : public SparseDirectSolver
+	{
+	public:
+		CholmodSolver(hj::sparse::solver* _solver, size_t nnz) : m_solver(_solver), m_val(nnz, 1) {}
+
+		bool set_value(const double* val)
+		{
+			for(size_t k=0; k<m_val.size(); ++k) m_val[k] = val[k];
+			return m_solver->set_value(m_val);
+		}
+
+		bool solve(const double* b, double* x, int nrhs) { return m_solver->solve(b, x, nrhs); }
+
+	private:
+		boost::scoped_ptr<hj::sparse::solver> m_solver;
+		zjucad::matrix::matrix<double> m_val;
+	};
+#endif
+}
+
+SparseDirectSolver* SparseDirectSolver::create(const hj::sparse::spm_csc<double>& A, const char* name)
+{
+	if(name && strcmp(name, "cholmod") == 0)
+	{
+#ifdef WIN32
+		hj::sparse::solver* solver = hj::sparse::solver::create(A, "cholmod");
+		return solver ? new CholmodSolver(solver, A.idx_.size()) : NULL;
+#else
+		printf("cholmod is not available, using the native solver.\n");
+#endif
+	}
+
+	/// the factorization may throw from the parallel passes, the solver is freed on every failed path
+	SparseCholesky* solver = new SparseCholesky(name != NULL && strcmp(name, "ldlt") == 0);
+	bool factorized = false;
+	try
+	{
+		factorized = solver->analyze(A) && solver->factorize(A.val_.size() ? &A.val_[0] : NULL);
+	}
+	catch(...)
+	{
+		delete solver;
+		throw;
+	}
+	if(!factorized)
+	{
+		delete solver;
+		return NULL;
+	}
+	return solver;
+}
+
+SparseCholesky::SparseCholesky(bool ldlt)
+{
+	m_ldlt = ldlt;
+	m_factorized = false;
+	m_n = 0;
+}
+
+SparseCholesky::~SparseCholesky()
+{
+}
+
+bool SparseCholesky::analyze(const hj::sparse::spm_csc<double>& A)
+{
+	m_factorized = false;
+	int n = (int) A.size(2);
+	if((int) A.size(1) != n) return false;
+	m_n = n;
+
+	/// ordering
+	Graph g;
+	BuildGraph(A, g);
+	vector<int> order;
+	NestedDissection(g, order).run();
+	vector<int> iorder(n);
+	for(int k=0; k<n; ++k) iorder[order[k]] = k;
+
+	/// elimination tree of the reordered matrix, with path compression
+	vector<int> parent(n, -1), ancestor(n, -1);
+	for(int k=0; k<n; ++k)
+	{
+		int v = order[k];
+		for(int e=g.ptr[v]; e<g.ptr[v+1]; ++e)
+		{
+			int i = iorder[g.adj[e]];
+			if(i >= k) continue;
+			while(ancestor[i] != -1 && ancestor[i] != k)
+			{
+				int next = ancestor[i];
+				ancestor[i] = k;
+				i = next;
+			}
+			if(ancestor[i] == -1)
+			{
+				ancestor[i] = k;
+				parent[i] = k;
+			}
+		}
+	}
+
+	/// postorder, so that every subtree is a contiguous range of columns
+	vector<int> head(n, -1), next(n, -1), post;
+	post.reserve(n);
+	for(int j=n-1; j>=0; --j)
+	{
+		if(parent[j] == -1) continue;
+		next[j] = head[parent[j]];
+		head[parent[j]] = j;
+	}
+	vector<int> stack;
+	for(int root=0; root<n; ++root)
+	{
+		if(parent[root] != -1) continue;
+		stack.push_back(root);
+		while(!stack.empty())
+		{
+			int v = stack.back();
+			if(head[v] != -1)
+			{
+				int c = head[v];
+				head[v] = next[c];
+				stack.push_back(c);
+			}else
+			{
+				post.push_back(v);
+				stack.pop_back();
+			}
+		}
+	}
+	vector<int> ipost(n);
+	for(int k=0; k<n; ++k) ipost[post[k]] = k;
+
+	m_perm.resize(n);
+	m_iperm.resize(n);
+	vector<int> etree(n);
+	for(int k=0; k<n; ++k)
+	{
+		m_perm[k] = order[post[k]];
+		m_iperm[m_perm[k]] = k;
+		etree[k] = (parent[post[k]] == -1) ? -1 : ipost[parent[post[k]]];
+	}
+
+	/// column counts of L from the row subtrees
+	vector<int> colcount(n, 1), mark(n, -1), nchild(n, 0);
+	for(int i=0; i<n; ++i)
+	{
+		mark[i] = i;
+		int v = m_perm[i];
+		for(int e=g.ptr[v]; e<g.ptr[v+1]; ++e)
+		{
+			int j = m_iperm[g.adj[e]];
+			if(j >= i) continue;
+			for(; mark[j] != i; j = etree[j])
+			{
+				mark[j] = i;
+				++colcount[j];
+			}
+		}
+		if(etree[i] != -1) ++nchild[etree[i]];
+	}
+
+	/// fundamental supernodes, a column joins the previous one when it is its only
+	/// child and their patterns nest
+	vector<int> col_super(n);
+	m_super_ptr.clear();
+	for(int j=0; j<n; ++j)
+	{
+		bool join = j > 0 && etree[j-1] == j && nchild[j] == 1 && colcount[j-1] == colcount[j]+1;
+		if(!join) m_super_ptr.push_back(j);
+		col_super[j] = (int) m_super_ptr.size()-1;
+	}
+	int ns = (int) m_super_ptr.size();
+	m_super_ptr.push_back(n);
+
+	m_super_parent.resize(ns);
+	m_child_ptr.assign(ns+1, 0);
+	for(int s=0; s<ns; ++s)
+	{
+		int last = m_super_ptr[s+1]-1;
+		m_super_parent[s] = (etree[last] == -1) ? -1 : col_super[etree[last]];
+		if(m_super_parent[s] != -1) ++m_child_ptr[m_super_parent[s]+1];
+	}
+	for(int s=0; s<ns; ++s) m_child_ptr[s+1] += m_child_ptr[s];
+	m_child.resize(m_child_ptr[ns]);
+	vector<int> child_pos(m_child_ptr.begin(), m_child_ptr.end()-1);
+	for(int s=0; s<ns; ++s)
+	{
+		if(m_super_parent[s] != -1) m_child[child_pos[m_super_parent[s]]++] = s;
+	}
+
+	/// row structure of each supernode, from its columns of A and the rows its children pass up
+	m_row_ptr.assign(1, 0);
+	m_row_idx.clear();
+	fill(mark.begin(), mark.end(), -1);
+	vector<int> below;
+	for(int s=0; s<ns; ++s)
+	{
+		int f = m_super_ptr[s], l = m_super_ptr[s+1]-1;
+		below.clear();
+		for(int j=f; j<=l; ++j)
+		{
+			int v = m_perm[j];
+			for(int e=g.ptr[v]; e<g.ptr[v+1]; ++e)
+			{
+				int i = m_iperm[g.adj[e]];
+				if(i > l && mark[i] != s) { mark[i] = s; below.push_back(i); }
+			}
+		}
+		for(int c=m_child_ptr[s]; c<m_child_ptr[s+1]; ++c)
+		{
+			int child = m_child[c];
+			int nc = m_super_ptr[child+1]-m_super_ptr[child];
+			for(int k=m_row_ptr[child]+nc; k<m_row_ptr[child+1]; ++k)
+			{
+				int i = m_row_idx[k];
+				if(i > l && mark[i] != s) { mark[i] = s; below.push_back(i); }
+			}
+		}
+		sort(below.begin(), below.end());
+		for(int j=f; j<=l; ++j) m_row_idx.push_back(j);
+		m_row_idx.insert(m_row_idx.end(), below.begin(), below.end());
+		m_row_ptr.push_back((int) m_row_idx.size());
+	}
+
+	/// position of the rows passed up by each child in the front of its parent
+	m_row_rel.assign(m_row_idx.size(), -1);
+	vector<int>& pos = mark;
+	for(int s=0; s<ns; ++s)
+	{
+		for(int k=m_row_ptr[s]; k<m_row_ptr[s+1]; ++k) pos[m_row_idx[k]] = k-m_row_ptr[s];
+		for(int c=m_child_ptr[s]; c<m_child_ptr[s+1]; ++c)
+		{
+			int child = m_child[c];
+			int nc = m_super_ptr[child+1]-m_super_ptr[child];
+			for(int k=m_row_ptr[child]+nc; k<m_row_ptr[child+1]; ++k) m_row_rel[k] = pos[m_row_idx[k]];
+		}
+	}
+
+	/// where each entry of A goes, one triangle is taken when both are given
+	bool has_lower = false, has_upper = false;
+	for(int c=0; c<n; ++c)
+	{
+		for(int k=(int) A.ptr_[c]; k<(int) A.ptr_[c+1]; ++k)
+		{
+			if(A.idx_[k] > c) has_lower = true;
+			if(A.idx_[k] < c) has_upper = true;
+		}
+	}
+	bool both = has_lower && has_upper;
+
+	int nnz = (int) A.idx_.size();
+	vector<int> entry_super(nnz, -1), entry_pos(nnz, -1);
+	m_assemble_ptr.assign(ns+1, 0);
+	for(int c=0; c<n; ++c)
+	{
+		for(int k=(int) A.ptr_[c]; k<(int) A.ptr_[c+1]; ++k)
+		{
+			int pi = m_iperm[A.idx_[k]], pj = m_iperm[c];
+			if(pi < pj)
+			{
+				if(both) continue;
+				std::swap(pi, pj);
+			}
+			int s = col_super[pj];
+			int f = m_super_ptr[s], ncol = m_super_ptr[s+1]-f;
+			int nrow = m_row_ptr[s+1]-m_row_ptr[s];
+			int local = pi-f;
+			if(local >= ncol)
+			{
+				const int* first = &m_row_idx[m_row_ptr[s]] + ncol;
+				const int* last = &m_row_idx[0] + m_row_ptr[s+1];
+				local = ncol + (int) (lower_bound(first, last, pi) - first);
+			}
+			entry_super[k] = s;
+			entry_pos[k] = local + (pj-f)*nrow;
+			++m_assemble_ptr[s+1];
+		}
+	}
+	for(int s=0; s<ns; ++s) m_assemble_ptr[s+1] += m_assemble_ptr[s];
+	m_assemble_pos.resize(m_assemble_ptr[ns]);
+	m_assemble_src.resize(m_assemble_ptr[ns]);
+	vector<int> assemble_next(m_assemble_ptr.begin(), m_assemble_ptr.end()-1);
+	for(int k=0; k<nnz; ++k)
+	{
+		int s = entry_super[k];
+		if(s < 0) continue;
+		m_assemble_pos[assemble_next[s]] = entry_pos[k];
+		m_assemble_src[assemble_next[s]] = k;
+		++assemble_next[s];
+	}
+
+	/// supernodes by height, those of the same height are independent
+	vector<int> height(ns, 0);
+	int max_height = 0;
+	for(int s=0; s<ns; ++s)
+	{
+		int p = m_super_parent[s];
+		if(p != -1) height[p] = std::max(height[p], height[s]+1);
+		max_height = std::max(max_height, height[s]);
+	}
+	m_level_ptr.assign(max_height+2, 0);
+	for(int s=0; s<ns; ++s) ++m_level_ptr[height[s]+1];
+	for(int h=0; h<=max_height; ++h) m_level_ptr[h+1] += m_level_ptr[h];
+	m_level_super.resize(ns);
+	vector<int> level_next(m_level_ptr.begin(), m_level_ptr.end()-1);
+	for(int s=0; s<ns; ++s) m_level_super[level_next[height[s]]++] = s;
+
+	/// factor storage
+	m_factor_ptr.resize(ns+1);
+	m_factor_ptr[0] = 0;
+	for(int s=0; s<ns; ++s)
+	{
+		size_t ncol = m_super_ptr[s+1]-m_super_ptr[s];
+		size_t nrow = m_row_ptr[s+1]-m_row_ptr[s];
+		m_factor_ptr[s+1] = m_factor_ptr[s] + ncol*nrow;
+	}
+	return true;
+}
+
+void SparseCholesky::factorize_supernode(int s, const double* val, bool inner_parallel)
+{
+	int f = m_super_ptr[s], ncol = m_super_ptr[s+1]-f;
+	int nrow = m_row_ptr[s+1]-m_row_ptr[s];
+	vector<double> front((size_t) nrow*nrow, 0.0);
+
+	/// assemble the entries of A and the update matrices of the children
+	for(int k=m_assemble_ptr[s]; k<m_assemble_ptr[s+1]; ++k) front[m_assemble_pos[k]] += val[m_assemble_src[k]];
+	for(int c=m_child_ptr[s]; c<m_child_ptr[s+1]; ++c)
+	{
+		int child = m_child[c];
+		int nc = m_super_ptr[child+1]-m_super_ptr[child];
+		int m = m_row_ptr[child+1]-m_row_ptr[child]-nc;
+		const int* rel = &m_row_rel[m_row_ptr[child]+nc];
+		vector<double>& update = m_update[child];
+		for(int j=0; j<m; ++j)
+		{
+			double* col = &front[(size_t) rel[j]*nrow];
+			const double* ucol = &update[(size_t) j*m];
+			for(int i=j; i<m; ++i) col[rel[i]] += ucol[i];
+		}
+		vector<double>().swap(update);
+	}
+
+	bool ok = PartialFactor(&front[0], nrow, ncol, m_ldlt ? &m_diag[f] : NULL, inner_parallel);
+	m_super_ok[s] = ok;
+
+	memcpy(&m_factor[m_factor_ptr[s]], &front[0], sizeof(double)*ncol*nrow);
+	int m = nrow-ncol;
+	if(m > 0 && m_super_parent[s] != -1)
+	{
+		vector<double>& update = m_update[s];
+		update.resize((size_t) m*m);
+		for(int j=0; j<m; ++j)
+		{
+			const double* col = &front[(size_t) (ncol+j)*nrow + ncol];
+			memcpy(&update[(size_t) j*m+j], col+j, sizeof(double)*(m-j));
+		}
+	}
+}
+
+bool SparseCholesky::factorize(const double* val)
+{
+	m_factorized = false;
+	int ns = (int) m_super_parent.size();
+	m_factor.resize(m_factor_ptr[ns]);
+	m_diag.resize(m_ldlt ? m_n : 0);
+	m_update.assign(ns, vector<double>());
+	m_super_ok.assign(ns, 1);
+
+	/// a level at a time, small fronts in parallel and the large ones one by one with parallel kernels
+	vector<int> small_super;
+	for(size_t h=0; h+1<m_level_ptr.size(); ++h)
+	{
+		small_super.clear();
+		for(int k=m_level_ptr[h]; k<m_level_ptr[h+1]; ++k)
+		{
+			int s = m_level_super[k];
+			double ncol = m_super_ptr[s+1]-m_super_ptr[s];
+			double nrow = m_row_ptr[s+1]-m_row_ptr[s];
+			if(nrow*nrow*ncol > PARALLEL_FRONT_FLOPS) factorize_supernode(s, val, true);
+			else small_super.push_back(s);
+		}
+		if(!small_super.empty())
+		{
+			/// the fronts of a level differ a lot in size, so they are handed out one by one
+			parallel_for(0, (int) small_super.size(),
+				FactorSupernodePass(this, &SparseCholesky::factorize_supernode, &small_super[0], val), 1);
+		}
+	}
+	vector< vector<double> >().swap(m_update);
+
+	for(int s=0; s<ns; ++s)
+	{
+		if(!m_super_ok[s]) return false;
+	}
+	m_factorized = true;
+	return true;
+}
+
+bool SparseCholesky::solve(const double* b, double* x, int nrhs)
+{
+	if(!m_factorized) return false;
+	int n = m_n;
+	vector<double> y((size_t) n*nrhs);
+	for(int r=0; r<nrhs; ++r)
+	{
+		for(int k=0; k<n; ++k) y[(size_t) r*n+k] = b[(size_t) r*n+m_perm[k]];
+	}
+
+	SubstitutePass substitute(m_super_ptr, m_row_ptr, m_row_idx, m_factor_ptr, m_factor, m_diag,
+		m_ldlt, n ? &y[0] : NULL, n);
+	if(nrhs > 1) parallel_for(0, nrhs, substitute, 1);
+	else if(nrhs == 1) substitute(0);
+
+	for(int r=0; r<nrhs; ++r)
+	{
+		for(int k=0; k<n; ++k) x[(size_t) r*n+m_perm[k]] = y[(size_t) r*n+k];
+	}
+	return true;
+}
+
+size_t SparseCholesky::get_factor_nnz() const
+{
+	size_t nnz = 0;
+	for(size_t s=0; s+1<m_super_ptr.size(); ++s)
+	{
+		size_t ncol = m_super_ptr[s+1]-m_super_ptr[s];
+		size_t nrow = m_row_ptr[s+1]-m_row_ptr[s];
+		nnz += ncol*nrow - ncol*(ncol-1)/2;
+	}
+	return nnz;
+}
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////
+//
+// Sparse direct solver for symmetric systems, with no external library.
+// The unknowns are ordered by nested dissection of the matrix graph, with
+// minimum degree on the small parts. The columns of the elimination tree
+// are grouped into supernodes and each supernode is factorized as a dense
+// front by blocked kernels, the independent subtrees in parallel.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef SPARSE_CHOLESKY_H
+#define SPARSE_CHOLESKY_H
+
+#include <vector>
+#ifdef WIN32
+#include <hj_3rd/hjlib/sparse_old/sparse.h>
+#else
+#include <hj_3rd/hjlib/sparse/sparse.h>
+#endif
+using namespace std;
+
+//! direct solver of a sparse symmetric system
+class SparseDirectSolver
+{
+public:
+	virtual ~SparseDirectSolver() {}
+
+	//! factorize again for new values of the same pattern
+	virtual bool set_value(const double* val) = 0;
+
+	//! solve A x = b for nrhs right hand sides stored one after another
+	virtual bool solve(const double* b, double* x, int nrhs = 1) = 0;
+
+	//! name is "cholesky" (the default) or "ldlt" for the native solver, and
+	//! "cholmod" for the library wrapper where it ships. NULL when A can not be factorized
+	static SparseDirectSolver* create(const hj::sparse::spm_csc<double>& A, const char* name = 0);
+};
+
+//! supernodal multifrontal Cholesky (L L^T) or L D L^T factorization
+class SparseCholesky : public SparseDirectSolver
+{
+public:
+	SparseCholesky(bool ldlt = false);
+	~SparseCholesky();
+
+	//! ordering and symbolic factorization of the pattern of A, A holds both
+	//! triangles or only one of them
+	bool analyze(const hj::sparse::spm_csc<double>& A);
+
+	//! numeric factorization, val holds the values of the analyzed pattern
+	bool factorize(const double* val);
+
+	bool set_value(const double* val) { return factorize(val); }
+	bool solve(const double* b, double* x, int nrhs = 1);
+
+	int get_supernode_num() const { return (int) m_super_parent.size(); }
+	size_t get_factor_nnz() const;
+
+private:
+	void factorize_supernode(int s, const double* val, bool inner_parallel);
+
+private:
+	bool m_ldlt;
+	bool m_factorized;
+	int m_n;
+
+	vector<int> m_perm;						// m_perm[k] is the variable eliminated k-th
+	vector<int> m_iperm;
+
+	// supernode s holds the columns m_super_ptr[s] .. m_super_ptr[s+1]-1, numbered
+	// in postorder so children come before their parent
+	vector<int> m_super_ptr;
+	vector<int> m_super_parent;				// -1 for roots
+	vector<int> m_child_ptr;
+	vector<int> m_child;
+
+	// rows of supernode s, its own columns first, in m_row_idx[m_row_ptr[s] ..]
+	vector<int> m_row_ptr;
+	vector<int> m_row_idx;
+	vector<int> m_row_rel;					// position of each row below the supernode in its parent
+
+	// entries of A assembled into the front of each supernode, position in the front and index in val
+	vector<int> m_assemble_ptr;
+	vector<int> m_assemble_pos;
+	vector<int> m_assemble_src;
+
+	// supernodes grouped by their height in the tree, a group only depends on the earlier ones
+	vector<int> m_level_ptr;
+	vector<int> m_level_super;
+
+	// factor, the dense rows x columns block of each supernode, column-major
+	vector<size_t> m_factor_ptr;
+	vector<double> m_factor;
+	vector<double> m_diag;					// D of L D L^T
+
+	vector< vector<double> > m_update;		// pending update matrix of each supernode
+	vector<char> m_super_ok;
+};
+
+#endif
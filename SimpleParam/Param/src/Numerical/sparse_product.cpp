@@ -0,0 +1,120 @@
+#include "sparse_product.h"
+
+#include <algorithm>
+
+namespace
+{
+	//! the operand as it enters the product, transposed when asked
+	const hj::sparse::spm_csc<double>& GetOperand(bool is_trans, const hj::sparse::spm_csc<double>& A,
+		hj::sparse::spm_csc<double>& AT)
+	{
+		if(!is_trans) return A;
+		sparse_transpose(A, AT);
+		return AT;
+	}
+}
+
+void sparse_transpose(const hj::sparse::spm_csc<double>& A, hj::sparse::spm_csc<double>& AT)
+{
+	int rows = (int) A.size(1), cols = (int) A.size(2);
+	int nnz = (int) A.idx_.size();
+	AT.resize(cols, rows, nnz);
+
+	/// count the entries of each row, then place them column by column so the rows of AT stay sorted
+	vector<int> pos(rows+1, 0);
+	for(int k=0; k<nnz; ++k) ++pos[A.idx_[k]+1];
+	for(int r=0; r<rows; ++r) pos[r+1] += pos[r];
+	for(int r=0; r<=rows; ++r) AT.ptr_[r] = pos[r];
+
+	for(int c=0; c<cols; ++c)
+	{
+		for(int k=(int) A.ptr_[c]; k<(int) A.ptr_[c+1]; ++k)
+		{
+			int p = pos[A.idx_[k]]++;
+			AT.idx_[p] = c;
+			AT.val_[p] = A.val_[k];
+		}
+	}
+}
+
+SparseProduct::SparseProduct() : m_rows(0)
+{
+}
+void SparseProduct::clear()
+{
+	m_rows = 0;
+	m_ptr.clear();
+	m_idx.clear();
+}
+bool SparseProduct::analyze(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+							bool is_B_trans, const hj::sparse::spm_csc<double>& B)
+{
+	clear();
+	hj::sparse::spm_csc<double> AT, BT;
+	const hj::sparse::spm_csc<double>& opA = GetOperand(is_A_trans, A, AT);
+	const hj::sparse::spm_csc<double>& opB = GetOperand(is_B_trans, B, BT);
+	if(opA.size(2) != opB.size(1)) return false;
+
+	/// rows of column j of C are the union of the columns of opA picked by the rows of column j of opB
+	int rows = (int) opA.size(1), cols = (int) opB.size(2);
+	vector<int> mark(rows, -1);
+	m_ptr.assign(cols+1, 0);
+	for(int j=0; j<cols; ++j)
+	{
+		int first = (int) m_idx.size();
+		for(int kb=(int) opB.ptr_[j]; kb<(int) opB.ptr_[j+1]; ++kb)
+		{
+			int c = (int) opB.idx_[kb];
+			for(int ka=(int) opA.ptr_[c]; ka<(int) opA.ptr_[c+1]; ++ka)
+			{
+				int r = (int) opA.idx_[ka];
+				if(mark[r] == j) continue;
+				mark[r] = j;
+				m_idx.push_back(r);
+			}
+		}
+		std::sort(m_idx.begin()+first, m_idx.end());
+		m_ptr[j+1] = (int) m_idx.size();
+	}
+	m_rows = rows;
+	return true;
+}
+bool SparseProduct::multiply(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+							 bool is_B_trans, const hj::sparse::spm_csc<double>& B, hj::sparse::spm_csc<double>& C) const
+{
+	if(!is_analyzed()) return false;
+	hj::sparse::spm_csc<double> AT, BT;
+	const hj::sparse::spm_csc<double>& opA = GetOperand(is_A_trans, A, AT);
+	const hj::sparse::spm_csc<double>& opB = GetOperand(is_B_trans, B, BT);
+	int cols = (int) m_ptr.size() - 1;
+	if((int) opA.size(1) != m_rows || (int) opB.size(2) != cols || opA.size(2) != opB.size(1)) return false;
+
+	C.resize(m_rows, cols, (int) m_idx.size());
+	for(int j=0; j<=cols; ++j) C.ptr_[j] = m_ptr[j];
+
+	/// accumulate each column in a dense vector, then gather it on the pattern
+	vector<double> work(m_rows, 0.0);
+	for(int j=0; j<cols; ++j)
+	{
+		for(int kb=(int) opB.ptr_[j]; kb<(int) opB.ptr_[j+1]; ++kb)
+		{
+			int c = (int) opB.idx_[kb];
+			double b = opB.val_[kb];
+			for(int ka=(int) opA.ptr_[c]; ka<(int) opA.ptr_[c+1]; ++ka) work[opA.idx_[ka]] += opA.val_[ka] * b;
+		}
+		for(int k=m_ptr[j]; k<m_ptr[j+1]; ++k)
+		{
+			C.idx_[k] = m_idx[k];
+			C.val_[k] = work[m_idx[k]];
+			work[m_idx[k]] = 0;
+		}
+	}
+	return true;
+}
+
+bool sparse_multiply(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+					 bool is_B_trans, const hj::sparse::spm_csc<double>& B, hj::sparse::spm_csc<double>& C)
+{
+	SparseProduct product;
+	return product.analyze(is_A_trans, A, is_B_trans, B) && product.multiply(is_A_trans, A, is_B_trans, B, C);
+}
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+//
+// Product of two sparse csc matrices, with no external library. The
+// pattern of the product is computed once and kept, so the normal
+// matrix of a system whose pattern does not change only recomputes its
+// values at the next iterations.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef SPARSE_PRODUCT_H
+#define SPARSE_PRODUCT_H
+
+#include <vector>
+#ifdef WIN32
+#include <hj_3rd/hjlib/sparse_old/sparse.h>
+#else
+#include <hj_3rd/hjlib/sparse/sparse.h>
+#endif
+using namespace std;
+
+//! C = op(A) * op(B), op transposes its matrix when the flag is set
+class SparseProduct
+{
+public:
+	SparseProduct();
+
+	//! compute and keep the pattern of C, the rows of each column sorted
+	bool analyze(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+		bool is_B_trans, const hj::sparse::spm_csc<double>& B);
+
+	//! C with the analyzed pattern, A and B have the patterns given to analyze
+	bool multiply(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+		bool is_B_trans, const hj::sparse::spm_csc<double>& B, hj::sparse::spm_csc<double>& C) const;
+
+	void clear();
+	bool is_analyzed() const { return !m_ptr.empty(); }
+
+private:
+	int m_rows;
+	vector<int> m_ptr;
+	vector<int> m_idx;
+};
+
+//! C = op(A) * op(B) for a single product
+bool sparse_multiply(bool is_A_trans, const hj::sparse::spm_csc<double>& A,
+	bool is_B_trans, const hj::sparse::spm_csc<double>& B, hj::sparse::spm_csc<double>& C);
+
+//! AT = A^T
+void sparse_transpose(const hj::sparse::spm_csc<double>& A, hj::sparse::spm_csc<double>& AT);
+
+#endif
@@ -0,0 +1,205 @@
+#include "GLBuffer.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <GL/glx.h>
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/* ================== Entry Points ================== */
+
+namespace
+{
+    typedef void (APIENTRY *GenBuffersProc)(GLsizei n, GLuint* buffers);
+    typedef void (APIENTRY *DeleteBuffersProc)(GLsizei n, const GLuint* buffers);
+    typedef void (APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+    typedef void (APIENTRY *BufferDataProc)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+
+    GenBuffersProc glGenBuffersPtr = NULL;
+    DeleteBuffersProc glDeleteBuffersPtr = NULL;
+    BindBufferProc glBindBufferPtr = NULL;
+    BufferDataProc glBufferDataPtr = NULL;
+
+    void* GetProc(const char* name)
+    {
+#ifdef WIN32
+        return (void*)wglGetProcAddress(name);
+#else
+        return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+    }
+
+    bool LoadEntryPoints()
+    {
+        static bool loaded = false;
+        static bool supported = false;
+        if(loaded)
+            return supported;
+        loaded = true;
+
+        // Buffer objects are core from 1.5, and need a current context to be queried
+        const char* version = (const char*)glGetString(GL_VERSION);
+        if(version == NULL)
+        {
+            loaded = false;
+            return false;
+        }
+        int major = 0, minor = 0;
+        if(sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 15)
+            return false;
+
+        glGenBuffersPtr = (GenBuffersProc)GetProc("glGenBuffers");
+        glDeleteBuffersPtr = (DeleteBuffersProc)GetProc("glDeleteBuffers");
+        glBindBufferPtr = (BindBufferProc)GetProc("glBindBuffer");
+        glBufferDataPtr = (BufferDataProc)GetProc("glBufferData");
+        supported = glGenBuffersPtr != NULL && glDeleteBuffersPtr != NULL
+            && glBindBufferPtr != NULL && glBufferDataPtr != NULL;
+        return supported;
+    }
+}
+
+
+/* ================== Buffer ================== */
+
+// Constructor
+GLBuffer::GLBuffer(unsigned int target)
+{
+    m_Target = target;
+    m_Id = 0;
+    m_Size = 0;
+}
+
+// Destructor
+GLBuffer::~GLBuffer()
+{
+    Release();
+}
+
+void GLBuffer::Upload(const void* data, size_t size)
+{
+    m_Size = size;
+    if(LoadEntryPoints())
+    {
+        if(m_Id == 0)
+            glGenBuffersPtr(1, &m_Id);
+        glBindBufferPtr(m_Target, m_Id);
+        glBufferDataPtr(m_Target, (ptrdiff_t)size, data, GL_STATIC_DRAW);
+        glBindBufferPtr(m_Target, 0);
+    }
+    else
+    {
+        m_Data.resize(size);
+        if(size > 0)
+            memcpy(&m_Data[0], data, size);
+    }
+}
+
+const void* GLBuffer::Bind() const
+{
+    if(m_Id != 0)
+    {
+        glBindBufferPtr(m_Target, m_Id);
+        return NULL;
+    }
+    return m_Data.empty() ? NULL : &m_Data[0];
+}
+
+void GLBuffer::Unbind() const
+{
+    if(m_Id != 0)
+        glBindBufferPtr(m_Target, 0);
+}
+
+void GLBuffer::Release()
+{
+    // Without a current context the name can't be freed, it goes with its context
+    if(m_Id != 0 && glGetString(GL_VERSION) != NULL)
+        glDeleteBuffersPtr(1, &m_Id);
+    m_Id = 0;
+    m_Data.clear();
+    m_Size = 0;
+}
+
+bool GLBuffer::IsSupported()
+{
+    return LoadEntryPoints();
+}
+
+
+/* ================== Vertex Batch ================== */
+
+// Constructor
+GLVertexBatch::GLVertexBatch()
+{
+    m_bDirty = false;
+}
+
+// Destructor
+GLVertexBatch::~GLVertexBatch()
+{
+}
+
+void GLVertexBatch::ClearData()
+{
+    m_Coord.clear();
+    m_Normal.clear();
+    m_Color.clear();
+    m_bDirty = true;
+}
+
+void GLVertexBatch::AddVertex(const Coord& v, const Color& c)
+{
+    for(int i = 0; i < 3; ++ i)
+    {
+        m_Coord.push_back((float)v[i]);
+        double ci = (c[i] < 0.0) ? 0.0 : ((c[i] > 1.0) ? 1.0 : c[i]);
+        m_Color.push_back((unsigned char)(ci * 255.0 + 0.5));
+    }
+    m_bDirty = true;
+}
+
+void GLVertexBatch::AddVertex(const Coord& v, const Color& c, const Normal& n)
+{
+    AddVertex(v, c);
+    for(int i = 0; i < 3; ++ i)
+        m_Normal.push_back((float)n[i]);
+}
+
+void GLVertexBatch::Draw(GLenum mode)
+{
+    if(m_Coord.empty())
+        return;
+    bool with_normal = (m_Normal.size() == m_Coord.size());
+
+    if(m_bDirty)
+    {
+        m_CoordBuffer.Upload(&m_Coord[0], m_Coord.size() * sizeof(float));
+        m_ColorBuffer.Upload(&m_Color[0], m_Color.size());
+        if(with_normal)
+            m_NormalBuffer.Upload(&m_Normal[0], m_Normal.size() * sizeof(float));
+        m_bDirty = false;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, m_CoordBuffer.Bind());
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(3, GL_UNSIGNED_BYTE, 0, m_ColorBuffer.Bind());
+    if(with_normal)
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, 0, m_NormalBuffer.Bind());
+    }
+    m_CoordBuffer.Unbind();
+
+    glDrawArrays(mode, 0, (GLsizei)(m_Coord.size() / 3));
+
+    if(with_normal)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
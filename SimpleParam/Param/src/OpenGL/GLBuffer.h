@@ -0,0 +1,98 @@
+#ifndef GLBUFFER_H_
+#define GLBUFFER_H_
+
+#include "../Common/BasicDataType.h"
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+#include <GL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+/* ================== Macros ================== */
+
+// Buffer object targets, from OpenGL 1.5
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER             0x8892
+#define GL_ELEMENT_ARRAY_BUFFER     0x8893
+#define GL_STATIC_DRAW              0x88E4
+#endif
+
+
+/* ================== Buffer ================== */
+
+// A vertex or index array kept in a buffer object when the driver has them,
+// and in client memory otherwise. The entry points are looked up the first
+// time a buffer is uploaded, so a context has to be current by then
+class GLBuffer
+{
+private:
+    unsigned int m_Target;              // GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+    unsigned int m_Id;                  // buffer object, 0 when kept in client memory
+    std::vector<unsigned char> m_Data;  // client copy when there is no buffer object
+    size_t m_Size;
+
+public:
+    // Constructor
+    GLBuffer(unsigned int target = GL_ARRAY_BUFFER);
+
+    // Destructor -- frees the buffer object, so the context it was uploaded in has
+    // to be current. Without a current context the object goes with its context
+    ~GLBuffer();
+
+    void Upload(const void* data, size_t size);
+
+    // Bind and return the pointer for gl*Pointer or glDrawElements
+    const void* Bind() const;
+    void Unbind() const;
+
+    // Free the buffer object, the context has to be current
+    void Release();
+
+    size_t Size() const { return m_Size; }
+    unsigned int GetId() const { return m_Id; }
+
+    // Whether buffer objects are used, valid once a context is current
+    static bool IsSupported();
+
+private:
+    GLBuffer(const GLBuffer&);
+    GLBuffer& operator=(const GLBuffer&);
+};
+
+
+/* ================== Vertex Batch ================== */
+
+// Vertices with colors and optional normals, uploaded once and drawn in one call,
+// for overlays such as lines and points
+class GLVertexBatch
+{
+private:
+    std::vector<float> m_Coord;
+    std::vector<float> m_Normal;
+    std::vector<unsigned char> m_Color;
+    GLBuffer m_CoordBuffer;
+    GLBuffer m_NormalBuffer;
+    GLBuffer m_ColorBuffer;
+    bool m_bDirty;
+
+public:
+    // Constructor
+    GLVertexBatch();
+
+    // Destructor
+    ~GLVertexBatch();
+
+    void ClearData();
+    void AddVertex(const Coord& v, const Color& c);
+    void AddVertex(const Coord& v, const Color& c, const Normal& n);
+
+    bool IsEmpty() const { return m_Coord.empty(); }
+
+    // Draw all the vertices as primitives of the given mode, e.g. GL_LINES
+    void Draw(GLenum mode);
+};
+
+#endif // GLBUFFER_H_
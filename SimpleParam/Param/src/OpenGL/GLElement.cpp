@@ -3,7 +3,9 @@
 #include <math.h>
 #include <assert.h>
 #include <iostream>
+#ifndef OPENGL_NO_QT
 #include <QtOpenGL/QGLWidget>
+#endif
 #include <cassert>
 #include <fstream>
 
@@ -355,6 +357,9 @@ void GLProjection::Zoom(double scale)
 
 /* ================== OpenGL Element Information ================== */
 
+// the context needs a QGLWidget, a build without Qt only has the scene elements
+#ifndef OPENGL_NO_QT
+
 // Constructor
 COpenGL::COpenGL()
 {
@@ -853,4 +858,6 @@ void COpenGL::MakeBoundaryImage()
 		checkImage[CHECK_IMAGE_WIDTH - 1][j][2] = (GLubyte) 0;
 		checkImage[CHECK_IMAGE_WIDTH - 1][j][3] = (GLubyte) 0;
 	}
-}
\ No newline at end of file
+}
+
+#endif //OPENGL_NO_QT
@@ -1,13 +1,100 @@
 #include "ChartCreator.h"
+#include "PatchLayoutIO.h"
 #include "../ModelMesh/MeshModel.h"
+#include "../Common/Parallel.h"
 #include <fstream>
 #include <cmath>
 #include <iostream>
 #include <queue>
 #include <set>
+#include <limits>
+#include <algorithm>
 
 namespace PARAM
 {
+	namespace
+	{
+		//! faces are united in contiguous ranges of this size, then across the ranges
+		const int FLOOD_FILL_CHUNK_SIZE = 65536;
+
+		inline int FindFaceRoot(const std::vector<int>& parent, int fid)
+		{
+			while(parent[fid] != fid) fid = parent[fid];
+			return fid;
+		}
+
+		//! the larger root is linked to the smaller one, so the root of a region is
+		//! its smallest face whatever order the unions are done in
+		inline void UnionFace(std::vector<int>& parent, int fid1, int fid2)
+		{
+			while(parent[fid1] != fid1) { parent[fid1] = parent[parent[fid1]]; fid1 = parent[fid1]; }
+			while(parent[fid2] != fid2) { parent[fid2] = parent[parent[fid2]]; fid2 = parent[fid2]; }
+			if(fid1 < fid2) parent[fid2] = fid1;
+			else if(fid2 < fid1) parent[fid1] = fid2;
+		}
+
+		//! faces are united across the mesh edges that are not cut, read from the kernel's edge table
+		class FaceChunkUnionFunctor
+		{
+		public:
+			FaceChunkUnionFunctor(const IndexArray& _face_edge_offset, const IndexArray& _face_edge, const IndexArray& _edge_face,
+				const std::vector<bool>& _is_cut, int _face_num, std::vector<int>& _parent, std::vector< std::vector<int> >& _cross_pair_array)
+				: face_edge_offset(_face_edge_offset), face_edge(_face_edge), edge_face(_edge_face), is_cut(_is_cut),
+				face_num(_face_num), parent(_parent), cross_pair_array(_cross_pair_array) {}
+
+			void operator()(int c) const
+			{
+				int begin = c*FLOOD_FILL_CHUNK_SIZE;
+				int end = std::min(face_num, begin + FLOOD_FILL_CHUNK_SIZE);
+				for(int fid=begin; fid<end; ++fid) parent[fid] = fid;
+
+				/// a range only writes its own faces' parents, the pairs crossing ranges are kept for later
+				std::vector<int>& cross_pair = cross_pair_array[c];
+				cross_pair.clear();
+				for(int fid=begin; fid<end; ++fid)
+				{
+					for(int k=face_edge_offset[fid]; k<face_edge_offset[fid+1]; ++k)
+					{
+						int eid = face_edge[k];
+						if(is_cut[eid]) continue;
+						int adj_fid = (edge_face[2*eid] == fid) ? edge_face[2*eid+1] : edge_face[2*eid];
+						if(adj_fid < 0 || adj_fid == fid) continue;
+						if(adj_fid >= begin && adj_fid < end)
+						{
+							UnionFace(parent, fid, adj_fid);
+						}else
+						{
+							cross_pair.push_back(fid);
+							cross_pair.push_back(adj_fid);
+						}
+					}
+				}
+			}
+
+		private:
+			const IndexArray& face_edge_offset;
+			const IndexArray& face_edge;
+			const IndexArray& edge_face;
+			const std::vector<bool>& is_cut;
+			int face_num;
+			std::vector<int>& parent;
+			std::vector< std::vector<int> >& cross_pair_array;
+		};
+
+		class FaceRootFunctor
+		{
+		public:
+			FaceRootFunctor(const std::vector<int>& _parent, std::vector<int>& _face_root)
+				: parent(_parent), face_root(_face_root) {}
+
+			void operator()(int fid) const { face_root[fid] = FindFaceRoot(parent, fid); }
+
+		private:
+			const std::vector<int>& parent;
+			std::vector<int>& face_root;
+		};
+	}
+
     ChartCreator::ChartCreator(boost::shared_ptr<MeshModel> _p_mesh):
         p_mesh(_p_mesh) {}
 
@@ -15,83 +102,30 @@ namespace PARAM
 
     bool ChartCreator::LoadPatchFile(const std::string& patch_file)
     {
-        std::ifstream fin(patch_file.c_str());
-        if(fin.fail()){
-            std::cerr << "@@@Eroor : Load Patch File Fail!" << std::endl;
-        }
-
         //! clear data
         m_patch_conner_array.clear();
         m_patch_edge_array.clear();
         m_patch_array.clear();
-        
-        int patch_conner_num(0), patch_edge_num(0), patch_num(0);
-
-        //! read patch conner info
-        fin >> patch_conner_num;
-        m_patch_conner_array.resize(patch_conner_num);
-
-        for(int k=0; k<patch_conner_num; ++k){
-            PatchConner& patch_conner = m_patch_conner_array[k];
-            fin >> patch_conner.m_conner_type >> patch_conner.m_mesh_index;
-            //! read neighbor info
-            int neighbor_num;
-            fin >> neighbor_num;
-            patch_conner.m_nb_conner_index_array.resize(neighbor_num);
-            patch_conner.m_nb_edge_index_array.resize(neighbor_num);
-            for(int i=0; i<neighbor_num; ++i){
-                fin >> patch_conner.m_nb_conner_index_array[i];
-                fin >> patch_conner.m_nb_edge_index_array[i];
-            }
-            
-        }    
-
-        //! read patch edge info
-        fin >> patch_edge_num;
-        m_patch_edge_array.resize(patch_edge_num);
-
-        for(int k=0; k<patch_edge_num; ++k){
-            PatchEdge& patch_edge = m_patch_edge_array[k];
-            fin >> patch_edge.m_conner_pair_index.first >> patch_edge.m_conner_pair_index.second;
-            
-            int neighbor_num;
-            fin >> neighbor_num;
-            patch_edge.m_nb_patch_index_array.resize(neighbor_num);
-            for(int i=0; i<neighbor_num; ++i){
-                fin >> patch_edge.m_nb_patch_index_array[i];
-            }
 
-            int path_vert_num;
-            fin >> path_vert_num;
-            patch_edge.m_mesh_path.resize(path_vert_num);
-            for(int i=0; i<path_vert_num; ++i){
-                fin >> patch_edge.m_mesh_path[i];
-            }
+        //! text or binary layout, every index is checked against the mesh file
+        PatchLayout layout;
+        ModelInfo& model_info = p_mesh->m_Kernel.GetModelInfo();
+        int vert_num = model_info.GetFileVertexNum();
+        int face_num = model_info.GetFileFaceNum();
+        if(!LoadPatchLayout(patch_file, vert_num, face_num, layout)){
+            std::cerr << "@@@Eroor : Load Patch File Fail!" << std::endl;
+            return false;
         }
 
-        //! read patch info
-        fin >> patch_num;
-        m_patch_array.resize(patch_num);
-
-        for(int k=0; k<patch_num; ++k){
-            ParamPatch& patch = m_patch_array[k];
-            //! read face info
-            int face_num;
-            fin >> face_num;
-            patch.m_face_index_array.resize(face_num);
-            for(int i=0; i<face_num; ++i){
-                fin >> patch.m_face_index_array[i];
-            }
-
-            //! read edge info
-            int edge_num;
-            fin >> edge_num;
-            patch.m_edge_index_array.resize(edge_num);
-            for(int i=0; i<edge_num; ++i){
-                fin >> patch.m_edge_index_array[i];
-            }                
+        //! the file refers to the mesh file order
+        if(!RemapPatchLayout(layout, model_info.GetVertexRank(), model_info.GetFaceRank())){
+            std::cerr << "@@@Eroor : Patch File Refers To Removed Mesh Elements!" << std::endl;
+            return false;
         }
-        fin.close();
+
+        m_patch_conner_array.swap(layout.m_patch_conner_array);
+        m_patch_edge_array.swap(layout.m_patch_edge_array);
+        m_patch_array.swap(layout.m_patch_array);
         return true;
     }
 
@@ -100,6 +134,13 @@ namespace PARAM
 		m_half_edge.CreateHalfEdge(p_mesh);	   
 		SetPatchConners();
 		SetPatchNeighbors();
+
+		//! a layout file may leave out the patch faces, they are then found from the patch edges
+		bool has_patch_face = true;
+		for(size_t k=0; k<m_patch_array.size(); ++k){
+			if(m_patch_array[k].m_face_index_array.empty()) has_patch_face = false;
+		}
+		if(!has_patch_face && !FloodFillFaceForAllPatchs()) return false;
 		
 		
 	//	FormTriPatch();
@@ -264,7 +305,7 @@ namespace PARAM
             }
 			
         }
-        
+		m_chart_graph.Build(m_patch_array);
     }
     	
 	void ChartCreator::SpliteDegradedPatch()
@@ -427,7 +468,7 @@ namespace PARAM
 		const std::vector<int>& inner_path = m_patch_edge_array[merged_edge_idx].m_mesh_path;
 
 		const std::vector<int>& face_vec = patch.m_face_index_array;		
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		std::set< std::pair<int, int> > region_mesh_edge_set;
 		for(size_t k=0; k<patch_edge_vec.size(); ++k){
@@ -440,7 +481,7 @@ namespace PARAM
 
 		for(size_t k=0; k<face_vec.size(); ++k){
 			int fid = face_vec[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				if(find(inner_path.begin(), inner_path.end(), face[(i+1)%3]) != inner_path.end() &&
 					find(inner_path.begin(), inner_path.end(), face[i]) != inner_path.end()) continue;
@@ -629,7 +670,7 @@ namespace PARAM
 		const std::vector<int>& inner_path = m_patch_edge_array[merged_edge_idx].m_mesh_path;
 
 		const std::vector<int>& face_vec = patch.m_face_index_array;		
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		std::set< std::pair<int, int> > region_mesh_edge_set;
 		for(size_t k=0; k<patch_edge_vec.size(); ++k){
@@ -642,7 +683,7 @@ namespace PARAM
 
 		for(size_t k=0; k<face_vec.size(); ++k){
 			int fid = face_vec[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				if(find(inner_path.begin(), inner_path.end(), face[(i+1)%3]) != inner_path.end() &&
 					find(inner_path.begin(), inner_path.end(), face[i]) != inner_path.end()) continue;
@@ -1147,7 +1188,7 @@ namespace PARAM
 		/// find the common region of these two patchs
 		const std::vector<int>& face_vec_1 = param_patch_1.m_face_index_array;
 		const std::vector<int>& face_vec_2 = param_patch_2.m_face_index_array;
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		std::set< std::pair<int, int> > region_mesh_edge_set;
 		for(size_t k=0; k<patch_edge_vec_1.size(); ++k){
@@ -1165,7 +1206,7 @@ namespace PARAM
 
 		for(size_t k=0; k<face_vec_1.size(); ++k){
 			int fid = face_vec_1[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				if(find(inner_path.begin(), inner_path.end(), face[(i+1)%3]) != inner_path.end() &&
 					find(inner_path.begin(), inner_path.end(), face[i]) != inner_path.end()) continue;
@@ -1174,7 +1215,7 @@ namespace PARAM
 		}
 		for(size_t k=0; k<face_vec_2.size(); ++k){
 			int fid = face_vec_2[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				if(find(inner_path.begin(), inner_path.end(), face[(i+1)%3]) != inner_path.end() &&
 					find(inner_path.begin(), inner_path.end(), face[i]) != inner_path.end()) continue;
@@ -1205,6 +1246,91 @@ namespace PARAM
 		FindInnerFace(p_mesh, patch_bounary, patch.m_face_index_array, m_half_edge);
 	}
 
+	bool ChartCreator::FloodFillFaceForAllPatchs()
+	{
+		EdgeInfo& edge_info = p_mesh->m_Kernel.GetEdgeInfo();
+		const IndexArray& edge_vert = edge_info.GetVertexIndex();
+		const IndexArray& edge_face = edge_info.GetFaceIndex();
+		const IndexArray& vert_edge_offset = edge_info.GetVertexEdgeOffset();
+		const IndexArray& vert_edge = edge_info.GetVertexEdge();
+		int face_num = (int) p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
+
+		//! mark the mesh edges lying on a patch edge's mesh path
+		std::vector<bool> is_cut(edge_info.GetEdgeNum(), false);
+		for(size_t k=0; k<m_patch_edge_array.size(); ++k){
+			const std::vector<int>& mesh_path = m_patch_edge_array[k].m_mesh_path;
+			for(size_t i=1; i<mesh_path.size(); ++i){
+				int vid1 = mesh_path[i-1], vid2 = mesh_path[i];
+				for(int j=vert_edge_offset[vid1]; j<vert_edge_offset[vid1+1]; ++j){
+					int eid = vert_edge[j];
+					if(edge_vert[2*eid] + edge_vert[2*eid+1] - vid1 == vid2) is_cut[eid] = true;
+				}
+			}
+		}
+
+		//! connected regions of the faces, united in parallel inside each range and then across the ranges
+		int chunk_num = (face_num + FLOOD_FILL_CHUNK_SIZE - 1) / FLOOD_FILL_CHUNK_SIZE;
+		std::vector<int> parent(face_num);
+		std::vector< std::vector<int> > cross_pair_array(chunk_num);
+		parallel_for(0, chunk_num, FaceChunkUnionFunctor(edge_info.GetFaceEdgeOffset(), edge_info.GetFaceEdge(), edge_face,
+			is_cut, face_num, parent, cross_pair_array), 1);
+		for(int c=0; c<chunk_num; ++c){
+			const std::vector<int>& cross_pair = cross_pair_array[c];
+			for(size_t i=0; i<cross_pair.size(); i+=2) UnionFace(parent, cross_pair[i], cross_pair[i+1]);
+		}
+		std::vector<int> face_root(face_num);
+		parallel_for(0, face_num, FaceRootFunctor(parent, face_root));
+
+		//! each patch takes the region on the inner side of its boundary, so patch ids follow the layout file
+		std::vector<int> root_patch(face_num, -1);
+		for(size_t k=0; k<m_patch_array.size(); ++k){
+			int seed_fid = FindPatchSeedFace(k);
+			if(seed_fid < 0){
+				std::cerr << "Error: can't find the inner face of patch " << k << std::endl;
+				return false;
+			}
+			int& patch_id = root_patch[face_root[seed_fid]];
+			if(patch_id >= 0){
+				std::cerr << "Error: patch " << k << " and patch " << patch_id << " are not separated by patch edges" << std::endl;
+				return false;
+			}
+			patch_id = k;
+		}
+
+		for(size_t k=0; k<m_patch_array.size(); ++k) m_patch_array[k].m_face_index_array.clear();
+		int unset_face_num = 0;
+		for(int fid=0; fid<face_num; ++fid){
+			int patch_id = root_patch[face_root[fid]];
+			if(patch_id >= 0) m_patch_array[patch_id].m_face_index_array.push_back(fid);
+			else ++unset_face_num;
+		}
+		if(unset_face_num != 0){
+			std::cout << "Warning: " << unset_face_num << " faces are not in any patch" << std::endl;
+		}
+		return true;
+	}
+
+	int ChartCreator::FindPatchSeedFace(int patch_id) const
+	{
+		std::vector<int> boundary;
+		FormPatchBoundary(patch_id, boundary);
+
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const PolyIndexArray& vert_adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
+		//! as in FindInnerFace, the inner face of boundary edge (vid1, vid2) holds the half edge (vid2, vid1)
+		for(size_t k=1; k<boundary.size(); ++k){
+			int vid1 = boundary[k-1], vid2 = boundary[k];
+			const IndexArray& adj_face_array = vert_adj_face_array[vid2];
+			for(size_t i=0; i<adj_face_array.size(); ++i){
+				const int* face = face_info.GetFaceVertices(adj_face_array[i]);
+				for(int e=0; e<3; ++e){
+					if(face[e] == vid2 && face[(e+1)%3] == vid1) return adj_face_array[i];
+				}
+			}
+		}
+		return -1;
+	}
+
 	void ChartCreator::FormPatchBoundary(int patch_id, std::vector<int>& boundary) const
 	{
 		boundary.clear();
@@ -1473,10 +1599,10 @@ namespace PARAM
 
 		std::set< std::pair<int, int> > region_mesh_edge_set;
 		
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		for(size_t k=0; k<face_vec.size(); ++k){
 			int fid = face_vec[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				region_mesh_edge_set.insert(MakeEdge(face[i], face[(i+1)%3]));
 			}
@@ -1511,17 +1637,17 @@ namespace PARAM
 		std::set< std::pair<int, int> > region_mesh_edge_set;
 		
 
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		for(size_t k=0; k<face_vec1.size(); ++k){
 			int fid = face_vec1[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				region_mesh_edge_set.insert(MakeEdge(face[i], face[(i+1)%3]));
 			}
 		}		
 		for(size_t k=0; k<face_vec2.size(); ++k){
 			int fid = face_vec2[k];
-			const IndexArray& face = face_list_array[fid];
+			const int* face = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i){
 				region_mesh_edge_set.insert(MakeEdge(face[i], face[(i+1)%3]));
 			}
@@ -1566,6 +1692,222 @@ namespace PARAM
 		}
 	}
 
+	bool ChartCreator::MovePatchConner(int conner_idx, int new_vid, std::vector<int>& edited_patch_array)
+	{
+		edited_patch_array.clear();
+		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
+		if(conner_idx < 0 || conner_idx >= (int) m_patch_conner_array.size()) return false;
+		if(new_vid < 0 || new_vid >= vert_num) return false;
+
+		PatchConner& conner = m_patch_conner_array[conner_idx];
+		int old_vid = conner.m_mesh_index;
+		if(new_vid == old_vid) return true;
+		if(p_mesh->m_BasicOp.IsBoundaryVertex(old_vid) || p_mesh->m_BasicOp.IsBoundaryVertex(new_vid)){
+			std::cout << "Warning: only the inner conners can be moved" << std::endl;
+			return false;
+		}
+		for(size_t k=0; k<m_patch_conner_array.size(); ++k){
+			if(m_patch_conner_array[k].m_mesh_index == new_vid) return false;
+		}
+
+		/// the conner's patches, the new position has to be inside them
+		const std::vector<int>& conner_edges = conner.m_nb_edge_index_array;
+		std::vector<int> patch_id_array;
+		for(size_t k=0; k<conner_edges.size(); ++k){
+			const std::vector<int>& nb_patches = m_patch_edge_array[conner_edges[k]].m_nb_patch_index_array;
+			for(size_t i=0; i<nb_patches.size(); ++i){
+				if(find(patch_id_array.begin(), patch_id_array.end(), nb_patches[i]) == patch_id_array.end())
+					patch_id_array.push_back(nb_patches[i]);
+			}
+		}
+		std::set<int> region_face_set;
+		for(size_t k=0; k<patch_id_array.size(); ++k){
+			const std::vector<int>& face_vec = m_patch_array[patch_id_array[k]].m_face_index_array;
+			region_face_set.insert(face_vec.begin(), face_vec.end());
+		}
+		const IndexArray& adj_faces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces()[new_vid];
+		for(size_t k=0; k<adj_faces.size(); ++k){
+			if(region_face_set.find(adj_faces[k]) == region_face_set.end()) return false;
+		}
+		for(size_t k=0; k<patch_id_array.size(); ++k){
+			const std::vector<int>& patch_edge_vec = m_patch_array[patch_id_array[k]].m_edge_index_array;
+			for(size_t i=0; i<patch_edge_vec.size(); ++i){
+				if(find(conner_edges.begin(), conner_edges.end(), patch_edge_vec[i]) != conner_edges.end()) continue;
+				const std::vector<int>& path = m_patch_edge_array[patch_edge_vec[i]].m_mesh_path;
+				if(find(path.begin(), path.end(), new_vid) != path.end()) return false;
+			}
+		}
+
+		std::vector< std::vector<int> > old_path_array(conner_edges.size());
+		for(size_t k=0; k<conner_edges.size(); ++k){
+			if(m_patch_edge_array[conner_edges[k]].m_mesh_path.empty()) return false;
+		}
+		for(size_t k=0; k<conner_edges.size(); ++k){
+			old_path_array[k].swap(m_patch_edge_array[conner_edges[k]].m_mesh_path);
+		}
+		conner.m_mesh_index = new_vid;
+
+		/// reroute the conner's edges one by one, each one stays off the ones already routed
+		bool succeeded = true;
+		for(size_t k=0; k<conner_edges.size() && succeeded; ++k){
+			PatchEdge& patch_edge = m_patch_edge_array[conner_edges[k]];
+			const std::vector<int>& old_path = old_path_array[k];
+			/// the far end stays where the old path ended, ConnerRelocating may have moved its conner since
+			int start_vid = (patch_edge.m_conner_pair_index.first == conner_idx) ? new_vid : old_path.front();
+			int end_vid = (patch_edge.m_conner_pair_index.second == conner_idx) ? new_vid : old_path.back();
+
+			std::set< std::pair<int, int> > region_mesh_edge_set;
+			FormPatchEdgeRegion(conner_edges[k], patch_id_array, start_vid, end_vid, region_mesh_edge_set);
+			succeeded = FindShortestPathInRegion(p_mesh, start_vid, end_vid, region_mesh_edge_set, patch_edge.m_mesh_path);
+		}
+		if(succeeded) succeeded = RefillPatchFaces(patch_id_array);
+
+		if(!succeeded){
+			std::cout << "Warning: can't move conner " << conner_idx << " to vertex " << new_vid << std::endl;
+			conner.m_mesh_index = old_vid;
+			for(size_t k=0; k<conner_edges.size(); ++k){
+				m_patch_edge_array[conner_edges[k]].m_mesh_path.swap(old_path_array[k]);
+			}
+			return false;
+		}
+
+		edited_patch_array = patch_id_array;
+		return true;
+	}
+
+	bool ChartCreator::ReroutePatchEdge(int edge_idx, const std::vector<int>& mesh_path, std::vector<int>& edited_patch_array)
+	{
+		edited_patch_array.clear();
+		if(edge_idx < 0 || edge_idx >= (int) m_patch_edge_array.size() || mesh_path.size() < 2) return false;
+
+		PatchEdge& patch_edge = m_patch_edge_array[edge_idx];
+		if(patch_edge.m_nb_patch_index_array.size() != 2 || patch_edge.m_mesh_path.empty()){
+			std::cout << "Warning: only the inner patch edges can be rerouted" << std::endl;
+			return false;
+		}
+
+		/// the new path keeps the old one's ends and direction
+		int start_vid = patch_edge.m_mesh_path.front();
+		int end_vid = patch_edge.m_mesh_path.back();
+		std::vector<int> new_path(mesh_path);
+		if(new_path.front() == end_vid && new_path.back() == start_vid) reverse(new_path.begin(), new_path.end());
+		if(new_path.front() != start_vid || new_path.back() != end_vid) return false;
+
+		std::set< std::pair<int, int> > region_mesh_edge_set;
+		FormPatchEdgeRegion(edge_idx, patch_edge.m_nb_patch_index_array, start_vid, end_vid, region_mesh_edge_set);
+		std::set<int> path_vert_set;
+		for(size_t k=0; k<new_path.size(); ++k){
+			if(!path_vert_set.insert(new_path[k]).second) return false;
+			if(k > 0 && region_mesh_edge_set.find(MakeEdge(new_path[k-1], new_path[k])) == region_mesh_edge_set.end())
+				return false;
+		}
+
+		std::vector<int> old_path;
+		old_path.swap(patch_edge.m_mesh_path);
+		patch_edge.m_mesh_path = new_path;
+		if(!RefillPatchFaces(patch_edge.m_nb_patch_index_array)){
+			std::cout << "Warning: can't reroute patch edge " << edge_idx << std::endl;
+			patch_edge.m_mesh_path.swap(old_path);
+			return false;
+		}
+
+		edited_patch_array = patch_edge.m_nb_patch_index_array;
+		return true;
+	}
+
+	void ChartCreator::RestoreEditedLayout(const std::vector<PatchConner>& patch_conner_array,
+		const std::vector<PatchEdge>& patch_edge_array, const std::vector<ParamPatch>& patch_array)
+	{
+		/// the edits keep the topology, so the charts and the chart graph are still the ones of this layout
+		m_patch_conner_array = patch_conner_array;
+		m_patch_edge_array = patch_edge_array;
+		m_patch_array = patch_array;
+	}
+
+	int ChartCreator::FindNearestPatchConner(int vid) const
+	{
+		const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
+		if(vid < 0 || vid >= (int) vert_coord_array.size()) return -1;
+
+		int nearest_conner_idx(-1);
+		double min_dist = std::numeric_limits<double>::max();
+		for(size_t k=0; k<m_patch_conner_array.size(); ++k){
+			int conner_vid = m_patch_conner_array[k].m_mesh_index;
+			if(p_mesh->m_BasicOp.IsBoundaryVertex(conner_vid)) continue;
+			double dist = (vert_coord_array[conner_vid] - vert_coord_array[vid]).abs();
+			if(dist < min_dist){
+				min_dist = dist;
+				nearest_conner_idx = k;
+			}
+		}
+		return nearest_conner_idx;
+	}
+
+	void ChartCreator::FormPatchEdgeRegion(int edge_idx, const std::vector<int>& patch_id_array, 
+		int start_vid, int end_vid, std::set< std::pair<int, int> >& region_mesh_edge_set) const
+	{
+		region_mesh_edge_set.clear();
+
+		/// the other edges of the patches are walls, only the edge's own ends are open
+		std::set<int> blocked_vert_set;
+		for(size_t k=0; k<patch_id_array.size(); ++k){
+			const std::vector<int>& patch_edge_vec = m_patch_array[patch_id_array[k]].m_edge_index_array;
+			for(size_t i=0; i<patch_edge_vec.size(); ++i){
+				if(patch_edge_vec[i] == edge_idx) continue;
+				const std::vector<int>& path = m_patch_edge_array[patch_edge_vec[i]].m_mesh_path;
+				blocked_vert_set.insert(path.begin(), path.end());
+			}
+		}
+		blocked_vert_set.erase(start_vid);
+		blocked_vert_set.erase(end_vid);
+
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		for(size_t k=0; k<patch_id_array.size(); ++k){
+			const std::vector<int>& face_vec = m_patch_array[patch_id_array[k]].m_face_index_array;
+			for(size_t i=0; i<face_vec.size(); ++i){
+				const int* face = face_info.GetFaceVertices(face_vec[i]);
+				for(int j=0; j<3; ++j){
+					int vid1 = face[j], vid2 = face[(j+1)%3];
+					if(blocked_vert_set.find(vid1) != blocked_vert_set.end()
+						|| blocked_vert_set.find(vid2) != blocked_vert_set.end()) continue;
+					region_mesh_edge_set.insert(MakeEdge(vid1, vid2));
+				}
+			}
+		}
+	}
+
+	bool ChartCreator::RefillPatchFaces(const std::vector<int>& patch_id_array)
+	{
+		std::vector< std::vector<int> > old_face_array(patch_id_array.size());
+		std::vector<int> old_faces, new_faces;
+		for(size_t k=0; k<patch_id_array.size(); ++k){
+			std::vector<int>& face_vec = m_patch_array[patch_id_array[k]].m_face_index_array;
+			old_faces.insert(old_faces.end(), face_vec.begin(), face_vec.end());
+			old_face_array[k].swap(face_vec);
+		}
+
+		/// the edited patches have to split their old faces among themselves
+		bool succeeded = true;
+		for(size_t k=0; k<patch_id_array.size() && succeeded; ++k){
+			FindPatchInnerFace(patch_id_array[k]);
+			const std::vector<int>& face_vec = m_patch_array[patch_id_array[k]].m_face_index_array;
+			new_faces.insert(new_faces.end(), face_vec.begin(), face_vec.end());
+			succeeded = !face_vec.empty();
+		}
+		if(succeeded){
+			sort(old_faces.begin(), old_faces.end());
+			sort(new_faces.begin(), new_faces.end());
+			succeeded = (old_faces == new_faces);
+		}
+
+		if(!succeeded){
+			for(size_t k=0; k<patch_id_array.size(); ++k){
+				m_patch_array[patch_id_array[k]].m_face_index_array.swap(old_face_array[k]);
+			}
+		}
+		return succeeded;
+	}
+
 	int ChartCreator::GetCommonConnerBetweenTwoEdge(const PatchEdge& edge_1, const PatchEdge& edge_2)
 	{
 		int idx1 = edge_1.m_conner_pair_index.first;
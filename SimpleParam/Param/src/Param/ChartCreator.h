@@ -4,12 +4,14 @@
 #include "Parameterization.h"
 #include "ParamPatch.h"
 #include "ParamChart.h"
+#include "ChartGraph.h"
 
 #include <vector>
 #include <string>
 #include <boost/shared_ptr.hpp>
 
 #include <map>
+#include <set>
 
 class MeshModel;
 
@@ -30,6 +32,19 @@ namespace PARAM
 		//! optimize the patch shape, won't change the topology
 		void OptimizePatchShape();
 
+		//! interactive layout edits, they keep the topology so the charts and their transitions stay
+		//! valid. only the patches returned in edited_patch_array get their faces filled again,
+		//! a failed edit leaves the layout as it was
+		//! move an inner conner onto mesh vertex new_vid and reroute its patch edges
+		bool MovePatchConner(int conner_idx, int new_vid, std::vector<int>& edited_patch_array);
+		//! replace an inner patch edge's mesh path, which has to join the edge's two conners
+		bool ReroutePatchEdge(int edge_idx, const std::vector<int>& mesh_path, std::vector<int>& edited_patch_array);
+		//! the inner conner nearest to vertex vid, -1 if there is none
+		int FindNearestPatchConner(int vid) const;
+		//! put back the conners, edges and patches saved before an edit
+		void RestoreEditedLayout(const std::vector<PatchConner>& patch_conner_array,
+			const std::vector<PatchEdge>& patch_edge_array, const std::vector<ParamPatch>& patch_array);
+
 
     public:
         //! Get Methods
@@ -41,6 +56,8 @@ namespace PARAM
         const std::vector<PatchEdge>& GetPatchEdgeArray() const { return m_patch_edge_array; }
         int GetPatchNumber() const { return (int) m_patch_array.size(); }
         int GetChartNumber() const { return (int) m_chart_array.size(); }
+		//! routes and rings between the charts, rebuilt whenever the patch neighbors are set
+		const ChartGraph& GetChartGraph() const { return m_chart_graph; }
 
 		//! check two charts is ambiguity(have more than one common edges)? 
 		bool IsAmbiguityChartPair(int chart_id_1, int chart_id_2) const;
@@ -54,10 +71,11 @@ namespace PARAM
         //! set each patch's neighbor info
         void SetPatchNeighbors();
         
-        void SetMeshEdgePatchEdgeMapping(std::map< std::pair<int, int>, std::vector<int> >& me_pe_mapping) const;
+        //! set all the patches' faces from the patch edges, the faces are labeled by a parallel
+        //! union-find over the face adjacency cut at the patch edges' mesh paths
         bool FloodFillFaceForAllPatchs();
-        bool FloodFillFaceAPatch(int init_fid, std::vector<bool>& face_visited_flag, 
-			const std::map< std::pair<int, int>, std::vector<int> >& me_pe_mapping);
+        //! a face on the inner side of a patch's boundary, -1 if there is none
+        int FindPatchSeedFace(int patch_id) const;
 	
 	private:
 
@@ -75,6 +93,13 @@ namespace PARAM
 		void FindPatchInnerFace(int patch_id);
 		void FormPatchBoundary(int patch_id, std::vector<int>& boundary) const;
 
+		//! mesh edges a patch edge from start_vid to end_vid may run along, inside the patches
+		//! and off their other edges
+		void FormPatchEdgeRegion(int edge_idx, const std::vector<int>& patch_id_array, 
+			int start_vid, int end_vid, std::set< std::pair<int, int> >& region_mesh_edge_set) const;
+		//! fill the patches' faces again, false if they don't split their old faces among themselves
+		bool RefillPatchFaces(const std::vector<int>& patch_id_array);
+
 		void ValenceControl();
 		int FindLongestPatchEdge(int conner_index) const;
 
@@ -113,6 +138,7 @@ namespace PARAM
         std::vector<PatchConner> m_patch_conner_array;
         std::vector<PatchEdge> m_patch_edge_array;
         std::vector<ParamChart> m_chart_array;
+		ChartGraph m_chart_graph;
 
 		HalfEdge m_half_edge;
 		std::vector<int> m_unre_edge_index_array;	
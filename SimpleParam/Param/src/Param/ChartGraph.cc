@@ -0,0 +1,144 @@
+#include "ChartGraph.h"
+#include "../Common/Parallel.h"
+
+#include <algorithm>
+
+namespace PARAM
+{
+	const int MAX_CHART_RING_NUM = 6;
+
+	namespace
+	{
+		//! breadth first search from one root chart, the predecessor of each chart is
+		//! its next hop toward the root, and the first charts found are the root's rings
+		class ChartBfsFunctor
+		{
+		public:
+			ChartBfsFunctor(const std::vector<int>& _nb_offset, const std::vector<int>& _nb_chart, int _max_ring_num,
+				std::vector<int>& _next_hop, std::vector< std::vector<int> >& _ring_chart_array, std::vector<int>& _ring_end)
+				: nb_offset(_nb_offset), nb_chart(_nb_chart), max_ring_num(_max_ring_num),
+				next_hop(_next_hop), ring_chart_array(_ring_chart_array), ring_end(_ring_end) {}
+
+			void operator()(int root) const
+			{
+				int chart_num = (int) nb_offset.size() - 1;
+				int* prev = &next_hop[(size_t) root*chart_num];
+				std::fill(prev, prev + chart_num, -1);
+
+				/// the queue holds the charts in visiting order, the charts of each ring are contiguous
+				std::vector<int> queue;
+				queue.reserve(chart_num);
+				queue.push_back(root);
+				prev[root] = root;
+
+				std::vector<int>& ring_chart = ring_chart_array[root];
+				int* end = &ring_end[root*(max_ring_num+1)];
+				size_t ring_begin = 0, head = 0;
+				for(int r=0; ring_begin < queue.size(); ++r)
+				{
+					size_t ring_finish = queue.size();
+					if(r <= max_ring_num) end[r] = (int) ring_finish;
+					for(head = ring_begin; head < ring_finish; ++head)
+					{
+						int cur_chart = queue[head];
+						for(int p=nb_offset[cur_chart]; p<nb_offset[cur_chart+1]; ++p)
+						{
+							int nb = nb_chart[p];
+							if(prev[nb] != -1) continue;
+							prev[nb] = cur_chart;
+							queue.push_back(nb);
+						}
+					}
+					ring_begin = ring_finish;
+				}
+				for(int r=1; r<=max_ring_num; ++r) if(end[r] == 0) end[r] = end[r-1];
+
+				ring_chart.assign(queue.begin(), queue.begin() + end[max_ring_num]);
+				prev[root] = -1;
+			}
+
+		private:
+			const std::vector<int>& nb_offset;
+			const std::vector<int>& nb_chart;
+			int max_ring_num;
+			std::vector<int>& next_hop;
+			std::vector< std::vector<int> >& ring_chart_array;
+			std::vector<int>& ring_end;
+		};
+	}
+
+	ChartGraph::ChartGraph() : m_chart_num(0), m_max_ring_num(0)
+	{
+	}
+
+	void ChartGraph::ClearData()
+	{
+		m_chart_num = 0;
+		m_max_ring_num = 0;
+		m_nb_offset.clear();
+		m_nb_chart.clear();
+		m_next_hop.clear();
+		m_ring_offset.clear();
+		m_ring_end.clear();
+		m_ring_chart.clear();
+	}
+
+	void ChartGraph::Build(const std::vector<ParamPatch>& patch_array, int max_ring_num)
+	{
+		ClearData();
+		m_chart_num = (int) patch_array.size();
+		m_max_ring_num = std::max(0, max_ring_num);
+
+		m_nb_offset.resize(m_chart_num + 1, 0);
+		for(int k=0; k<m_chart_num; ++k)
+		{
+			const std::vector<int>& nb_patch = patch_array[k].m_nb_patch_index_array;
+			m_nb_offset[k+1] = m_nb_offset[k] + (int) nb_patch.size();
+			m_nb_chart.insert(m_nb_chart.end(), nb_patch.begin(), nb_patch.end());
+		}
+
+		/// row root of the searches' predecessors is the next hop toward root from every chart
+		m_next_hop.resize((size_t) m_chart_num*m_chart_num);
+		m_ring_end.resize(m_chart_num*(m_max_ring_num+1), 0);
+		std::vector< std::vector<int> > ring_chart_array(m_chart_num);
+		parallel_for(0, m_chart_num, ChartBfsFunctor(m_nb_offset, m_nb_chart, m_max_ring_num,
+			m_next_hop, ring_chart_array, m_ring_end), 1);
+
+		m_ring_offset.resize(m_chart_num + 1, 0);
+		for(int k=0; k<m_chart_num; ++k)
+		{
+			m_ring_offset[k+1] = m_ring_offset[k] + (int) ring_chart_array[k].size();
+			m_ring_chart.insert(m_ring_chart.end(), ring_chart_array[k].begin(), ring_chart_array[k].end());
+		}
+	}
+
+	void ChartGraph::GetNeighbors(int chart_id, const int*& begin, const int*& end) const
+	{
+		begin = m_nb_chart.empty() ? NULL : &m_nb_chart[0] + m_nb_offset[chart_id];
+		end = m_nb_chart.empty() ? NULL : &m_nb_chart[0] + m_nb_offset[chart_id+1];
+	}
+
+	bool ChartGraph::GetChartChain(int from_chart_id, int to_chart_id, std::vector<int>& chart_chain) const
+	{
+		chart_chain.clear();
+		chart_chain.push_back(from_chart_id);
+		for(int cur_chart = from_chart_id; cur_chart != to_chart_id; )
+		{
+			cur_chart = GetNextHop(cur_chart, to_chart_id);
+			if(cur_chart == -1)
+			{
+				chart_chain.clear();
+				return false;
+			}
+			chart_chain.push_back(cur_chart);
+		}
+		return true;
+	}
+
+	void ChartGraph::GetRing(int chart_id, int ring_num, const int*& begin, const int*& end) const
+	{
+		ring_num = std::min(std::max(0, ring_num), m_max_ring_num);
+		begin = &m_ring_chart[0] + m_ring_offset[chart_id];
+		end = begin + m_ring_end[chart_id*(m_max_ring_num+1) + ring_num];
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef CHARTGRAPH_H_
+#define CHARTGRAPH_H_
+
+#include "ParamPatch.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace PARAM
+{
+	//! charts within MAX_CHART_RING_NUM rings of each chart are kept by ChartGraph
+	extern const int MAX_CHART_RING_NUM;
+
+	//! adjacency of the charts, with the breadth first routes between all the chart pairs
+	//! and each chart's nearby rings, all computed once when the patch neighbors are set
+	class ChartGraph
+	{
+	public:
+		ChartGraph();
+		~ChartGraph(){}
+
+		void ClearData();
+
+		//! build from the patches' neighbors, a breadth first search is run from every chart in parallel
+		void Build(const std::vector<ParamPatch>& patch_array, int max_ring_num = MAX_CHART_RING_NUM);
+
+		int GetChartNumber() const { return m_chart_num; }
+
+		//! neighbor charts of chart_id are [begin, end), in the patch's neighbor order
+		void GetNeighbors(int chart_id, const int*& begin, const int*& end) const;
+
+		//! next chart on a shortest route from from_chart_id to to_chart_id, to_chart_id itself
+		//! when they are adjacent, -1 if there is no route
+		int GetNextHop(int from_chart_id, int to_chart_id) const
+		{
+			return m_next_hop[(size_t) to_chart_id*m_chart_num + from_chart_id];
+		}
+
+		//! charts from from_chart_id to to_chart_id along a shortest route, both ends included
+		bool GetChartChain(int from_chart_id, int to_chart_id, std::vector<int>& chart_chain) const;
+
+		//! charts within ring_num rings of chart_id are [begin, end), in breadth first order
+		//! starting with chart_id itself, ring_num is clamped to the built ring number
+		void GetRing(int chart_id, int ring_num, const int*& begin, const int*& end) const;
+
+		int GetMaxRingNumber() const { return m_max_ring_num; }
+
+	private:
+		int m_chart_num;
+		int m_max_ring_num;
+
+		//! neighbors of chart c are m_nb_chart[m_nb_offset[c], m_nb_offset[c+1])
+		std::vector<int> m_nb_offset;
+		std::vector<int> m_nb_chart;
+
+		//! m_next_hop[to*m_chart_num + from]
+		std::vector<int> m_next_hop;
+
+		//! ring r of chart c ends at m_ring_chart[m_ring_end[c*(m_max_ring_num+1) + r]],
+		//! chart c's rings start at m_ring_offset[c]
+		std::vector<int> m_ring_offset;
+		std::vector<int> m_ring_end;
+		std::vector<int> m_ring_chart;
+	};
+}
+
+#endif // CHARTGRAPH_H_
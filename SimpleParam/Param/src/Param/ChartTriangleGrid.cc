@@ -0,0 +1,192 @@
+#include "ChartTriangleGrid.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace PARAM
+{
+	//! a chart's grid has at most MAX_GRID_CELL_NUM cells along each axis
+	const int MAX_GRID_CELL_NUM = 1024;
+
+	namespace
+	{
+		inline double SegmentDistance2(double s, double t, double s0, double t0, double s1, double t1)
+		{
+			double ds = s1 - s0, dt = t1 - t0;
+			double len2 = ds*ds + dt*dt;
+			double r = 0;
+			if(len2 > 0) r = std::min(1.0, std::max(0.0, ((s - s0)*ds + (t - t0)*dt) / len2));
+			double es = s0 + r*ds - s, et = t0 + r*dt - t;
+			return es*es + et*et;
+		}
+	}
+
+	bool ComputeTriangleBarycentric(const double* tri, double s, double t, Barycentrc& baryc)
+	{
+		double det = (tri[2] - tri[0])*(tri[5] - tri[1]) - (tri[4] - tri[0])*(tri[3] - tri[1]);
+		if(fabs(det) < std::numeric_limits<double>::min()) return false;
+
+		double b1 = ((s - tri[0])*(tri[5] - tri[1]) - (tri[4] - tri[0])*(t - tri[1])) / det;
+		double b2 = ((tri[2] - tri[0])*(t - tri[1]) - (s - tri[0])*(tri[3] - tri[1])) / det;
+		baryc = Barycentrc(1.0 - b1 - b2, b1, b2);
+		return true;
+	}
+
+	ChartTriangleGrid::ChartTriangleGrid()
+		: m_min_s(0), m_min_t(0), m_cell_size(1), m_cell_num_s(0), m_cell_num_t(0)
+	{
+	}
+
+	void ChartTriangleGrid::ClearData()
+	{
+		m_face_index_array.clear();
+		m_tri_param_coord.clear();
+		m_cell_offset.clear();
+		m_cell_tri.clear();
+		m_cell_num_s = m_cell_num_t = 0;
+	}
+
+	void ChartTriangleGrid::Build(const std::vector<int>& face_index_array, const std::vector<double>& tri_param_coord)
+	{
+		ClearData();
+
+		/// degenerate triangles can not be located in, they are dropped
+		Barycentrc baryc;
+		for(size_t k=0; k<face_index_array.size(); ++k)
+		{
+			const double* tri = &tri_param_coord[k*6];
+			if(!ComputeTriangleBarycentric(tri, tri[0], tri[1], baryc)) continue;
+			m_face_index_array.push_back(face_index_array[k]);
+			m_tri_param_coord.insert(m_tri_param_coord.end(), tri, tri + 6);
+		}
+		int tri_num = (int) m_face_index_array.size();
+		if(tri_num == 0) return;
+
+		double max_s = m_tri_param_coord[0], max_t = m_tri_param_coord[1];
+		m_min_s = max_s; m_min_t = max_t;
+		for(size_t k=0; k<m_tri_param_coord.size(); k+=2)
+		{
+			m_min_s = std::min(m_min_s, m_tri_param_coord[k]);
+			max_s = std::max(max_s, m_tri_param_coord[k]);
+			m_min_t = std::min(m_min_t, m_tri_param_coord[k+1]);
+			max_t = std::max(max_t, m_tri_param_coord[k+1]);
+		}
+
+		/// about one triangle per cell
+		double width = max_s - m_min_s, height = max_t - m_min_t;
+		m_cell_size = sqrt(width*height / tri_num);
+		m_cell_size = std::max(m_cell_size, std::max(width, height) / MAX_GRID_CELL_NUM);
+		if(!(m_cell_size > 0)) m_cell_size = 1.0;
+		m_cell_num_s = std::min(MAX_GRID_CELL_NUM, (int) (width / m_cell_size) + 1);
+		m_cell_num_t = std::min(MAX_GRID_CELL_NUM, (int) (height / m_cell_size) + 1);
+
+		/// count, prefix sum and fill the triangles of each cell
+		std::vector<int> tri_cell_range(tri_num*4);
+		m_cell_offset.assign(m_cell_num_s*m_cell_num_t + 1, 0);
+		for(int k=0; k<tri_num; ++k)
+		{
+			const double* tri = &m_tri_param_coord[k*6];
+			int* range = &tri_cell_range[k*4];
+			range[0] = GetCellS(std::min(tri[0], std::min(tri[2], tri[4])));
+			range[1] = GetCellS(std::max(tri[0], std::max(tri[2], tri[4])));
+			range[2] = GetCellT(std::min(tri[1], std::min(tri[3], tri[5])));
+			range[3] = GetCellT(std::max(tri[1], std::max(tri[3], tri[5])));
+			for(int j=range[2]; j<=range[3]; ++j)
+				for(int i=range[0]; i<=range[1]; ++i) ++m_cell_offset[j*m_cell_num_s + i + 1];
+		}
+		for(size_t c=1; c<m_cell_offset.size(); ++c) m_cell_offset[c] += m_cell_offset[c-1];
+
+		m_cell_tri.resize(m_cell_offset.back());
+		std::vector<int> fill_pos(m_cell_offset.begin(), m_cell_offset.end() - 1);
+		for(int k=0; k<tri_num; ++k)
+		{
+			const int* range = &tri_cell_range[k*4];
+			for(int j=range[2]; j<=range[3]; ++j)
+				for(int i=range[0]; i<=range[1]; ++i) m_cell_tri[fill_pos[j*m_cell_num_s + i]++] = k;
+		}
+	}
+
+	void ChartTriangleGrid::Locate(const ParamCoord& param_coord, SurfaceLocateResult& result) const
+	{
+		result = SurfaceLocateResult();
+		if(IsEmpty()) return;
+
+		double s = param_coord.s_coord, t = param_coord.t_coord;
+		int ci = GetCellS(s), cj = GetCellT(t);
+		Barycentrc baryc;
+
+		/// a containing triangle overlaps the query's cell, the first one in build order wins
+		int c = cj*m_cell_num_s + ci;
+		for(int p=m_cell_offset[c]; p<m_cell_offset[c+1]; ++p)
+		{
+			int k = m_cell_tri[p];
+			ComputeTriangleBarycentric(&m_tri_param_coord[k*6], s, t, baryc);
+			if(IsValidBarycentic(baryc))
+			{
+				result.surface_coord = SurfaceCoord(m_face_index_array[k], baryc);
+				result.state = LOCATE_INSIDE;
+				return;
+			}
+		}
+
+		/// search the cell rings around the query until no closer triangle can exist,
+		/// cells in ring r are at least (r-1)*m_cell_size away
+		double best_dist = std::numeric_limits<double>::infinity();
+		int best_k = -1;
+		int max_ring = std::max(m_cell_num_s, m_cell_num_t);
+		for(int r=0; r<=max_ring; ++r)
+		{
+			for(int j=std::max(0, cj-r); j<=std::min(m_cell_num_t-1, cj+r); ++j)
+			{
+				bool is_ring_row = (j == cj-r || j == cj+r);
+				for(int i=std::max(0, ci-r); i<=std::min(m_cell_num_s-1, ci+r); ++i)
+				{
+					if(!is_ring_row && i != ci-r && i != ci+r) continue;
+					int cell = j*m_cell_num_s + i;
+					for(int p=m_cell_offset[cell]; p<m_cell_offset[cell+1]; ++p)
+					{
+						int k = m_cell_tri[p];
+						double dist = DistanceToTriangle(k, s, t);
+						if(dist < best_dist || (dist == best_dist && k < best_k))
+						{
+							best_dist = dist;
+							best_k = k;
+						}
+					}
+				}
+			}
+			if(best_k >= 0 && best_dist <= r*m_cell_size) break;
+		}
+
+		ComputeTriangleBarycentric(&m_tri_param_coord[best_k*6], s, t, baryc);
+		result.surface_coord = SurfaceCoord(m_face_index_array[best_k], baryc);
+		result.state = LOCATE_NEAREST;
+		result.out_range_error = ComputeErrorOutValidBarycentric(baryc);
+	}
+
+	int ChartTriangleGrid::GetCellS(double s) const
+	{
+		int i = (int) floor((s - m_min_s) / m_cell_size);
+		return std::min(m_cell_num_s - 1, std::max(0, i));
+	}
+
+	int ChartTriangleGrid::GetCellT(double t) const
+	{
+		int j = (int) floor((t - m_min_t) / m_cell_size);
+		return std::min(m_cell_num_t - 1, std::max(0, j));
+	}
+
+	double ChartTriangleGrid::DistanceToTriangle(int k, double s, double t) const
+	{
+		const double* tri = &m_tri_param_coord[k*6];
+		Barycentrc baryc;
+		ComputeTriangleBarycentric(tri, s, t, baryc);
+		if(baryc[0] >= 0 && baryc[1] >= 0 && baryc[2] >= 0) return 0.0;
+
+		double dist2 = SegmentDistance2(s, t, tri[0], tri[1], tri[2], tri[3]);
+		dist2 = std::min(dist2, SegmentDistance2(s, t, tri[2], tri[3], tri[4], tri[5]));
+		dist2 = std::min(dist2, SegmentDistance2(s, t, tri[4], tri[5], tri[0], tri[1]));
+		return sqrt(dist2);
+	}
+}
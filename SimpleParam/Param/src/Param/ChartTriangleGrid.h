@@ -0,0 +1,73 @@
+#ifndef CHARTTRIANGLEGRID_H_
+#define CHARTTRIANGLEGRID_H_
+
+#include "Barycentric.h"
+
+#include <vector>
+
+namespace PARAM
+{
+	enum SurfaceLocateState
+	{
+		LOCATE_INSIDE = 0,	//! the parameter coordinate is inside a triangle
+		LOCATE_NEAREST,		//! outside all the triangles, the nearest triangle is returned
+		LOCATE_FAILED		//! no triangle in the chart, or an invalid chart id
+	};
+
+	//! result of locating a chart parameter coordinate on the surface
+	class SurfaceLocateResult
+	{
+	public:
+		SurfaceLocateResult() : state(LOCATE_FAILED), out_range_error(0) {}
+		~SurfaceLocateResult(){}
+
+	public:
+		SurfaceCoord surface_coord;
+		SurfaceLocateState state;
+		double out_range_error; //! 0 when inside, otherwise the barycentric error of the nearest triangle
+	};
+
+	//! barycentric of (s, t) in a parameter triangle stored as (s0, t0, s1, t1, s2, t2),
+	//! returns false for a degenerate triangle
+	bool ComputeTriangleBarycentric(const double* tri, double s, double t, Barycentrc& baryc);
+
+	//! uniform grid over one chart's triangles in its parameter domain,
+	//! each triangle is put into all the cells its bounding box overlaps
+	class ChartTriangleGrid
+	{
+	public:
+		ChartTriangleGrid();
+		~ChartTriangleGrid(){}
+
+		void ClearData();
+
+		//! tri_param_coord holds 6 values per triangle, face_index_array the mesh face of each triangle
+		void Build(const std::vector<int>& face_index_array, const std::vector<double>& tri_param_coord);
+
+		//! find the triangle containing param_coord, or the nearest one in parameter distance
+		void Locate(const ParamCoord& param_coord, SurfaceLocateResult& result) const;
+
+		bool IsEmpty() const { return m_face_index_array.empty(); }
+
+	private:
+		int GetCellS(double s) const;
+		int GetCellT(double t) const;
+
+		//! distance from (s, t) to the k-th triangle, 0 inside
+		double DistanceToTriangle(int k, double s, double t) const;
+
+	private:
+		std::vector<int> m_face_index_array;
+		std::vector<double> m_tri_param_coord;
+
+		double m_min_s, m_min_t;
+		double m_cell_size;
+		int m_cell_num_s, m_cell_num_t;
+
+		//! triangles of cell (i, j) are m_cell_tri[m_cell_offset[c], m_cell_offset[c+1]), c = j*m_cell_num_s + i
+		std::vector<int> m_cell_offset;
+		std::vector<int> m_cell_tri;
+	};
+}
+
+#endif // CHARTTRIANGLEGRID_H_
@@ -28,11 +28,11 @@ namespace PARAM
 		ParamDistortion param_distortion_2(m_param_2);
 
 		const boost::shared_ptr<MeshModel> p_mesh_1 = m_param_1.GetMeshModel();
-		const PolyIndexArray& face_index_array_1 = p_mesh_1->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info_1 = p_mesh_1->m_Kernel.GetFaceInfo();
 		const CoordArray& vtx_coord_array_1 = p_mesh_1->m_Kernel.GetVertexInfo().GetCoord();
 
 		const boost::shared_ptr<MeshModel> p_mesh_2 = m_param_2.GetMeshModel();
-	    const PolyIndexArray& face_index_array_2 = p_mesh_2->m_Kernel.GetFaceInfo().GetIndex();
+	    const FaceInfo& face_info_2 = p_mesh_2->m_Kernel.GetFaceInfo();
 		int face_num_2 = p_mesh_2->m_Kernel.GetModelInfo().GetFaceNum();
 		
 		m_united_distortion.clear();
@@ -40,7 +40,7 @@ namespace PARAM
 
 		for(int k=0; k<face_num_2; ++k)
 		{
-			const IndexArray& face_index = face_index_array_2[k];
+			const int* face_index = face_info_2.GetFaceVertices(k);
 			/// the three vertices's position coordinate in mesh 1
 			vector<Coord> new_vtx_pos_coord(3);
 			/// the three vertices's parameter  coordinate, same in two mesh 
@@ -66,7 +66,7 @@ namespace PARAM
 				int face_id_in_mesh_1 = m_vtx_face_in_mesh_1[vtx_idx];
 				Coord barycentric = m_vtx_barycentric_in_mesh_1[vtx_idx];
 
-				const IndexArray& face_in_mesh_1 = face_index_array_1[face_id_in_mesh_1];
+				const int* face_in_mesh_1 = face_info_1.GetFaceVertices(face_id_in_mesh_1);
 				vector<Coord> vtx_coord_in_mesh_1(3);
 				for(size_t j=0; j<3; ++j)
 				{
@@ -182,7 +182,7 @@ namespace PARAM
 	void CrossParam::ComputeTexCoordOnSurface1()
 	{
 		const boost::shared_ptr<MeshModel> p_mesh_2 = m_param_2.GetMeshModel();
-		const PolyIndexArray& face_index_array_2 = p_mesh_2->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info_2 = p_mesh_2->m_Kernel.GetFaceInfo();
 		const TexCoordArray& vtx_tex_coord_array_2 = p_mesh_2->m_Kernel.GetVertexInfo().GetTexCoord();
 
 		const boost::shared_ptr<MeshModel> p_mesh_1 = m_param_1.GetMeshModel();
@@ -199,7 +199,7 @@ namespace PARAM
 			int fid_in_mesh_2 = m_vtx_face_in_mesh_2[vid];
 			Coord barycentric = m_vtx_barycentric_in_mesh_2[vid];
 
-			const IndexArray& face_index = face_index_array_2[fid_in_mesh_2];
+			const int* face_index = face_info_2.GetFaceVertices(fid_in_mesh_2);
 			vector<TexCoord> tex_coord(3);
 
 			for(size_t k=0; k<3; ++k)
@@ -215,7 +215,7 @@ namespace PARAM
 	void CrossParam::ComputeTexCoordOnSurface2()
 	{
 		const boost::shared_ptr<MeshModel> p_mesh_1 = m_param_1.GetMeshModel();
-		const PolyIndexArray& face_index_array_1 = p_mesh_1->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info_1 = p_mesh_1->m_Kernel.GetFaceInfo();
 		const TexCoordArray& vtx_tex_coord_array_1 = p_mesh_1->m_Kernel.GetVertexInfo().GetTexCoord();
 
 		const boost::shared_ptr<MeshModel> p_mesh_2 = m_param_2.GetMeshModel();
@@ -231,7 +231,7 @@ namespace PARAM
 			int fid_in_mesh_1 = m_vtx_face_in_mesh_1[vid];
 			Coord barycentric = m_vtx_barycentric_in_mesh_1[vid];
 						
-			const IndexArray& face_index = face_index_array_1[fid_in_mesh_1];
+			const int* face_index = face_info_1.GetFaceVertices(fid_in_mesh_1);
 			vector<TexCoord> tex_coord(3);
 			for(size_t k=0; k<3; ++k)
 			{
@@ -182,7 +182,7 @@ namespace PARAM
 
 		const QuadParam& param_2 = m_cross_param.GetQuadParam2();
 		const boost::shared_ptr<MeshModel> p_mesh_2 = param_2.GetMeshModel();
-		const PolyIndexArray& face_index_array = p_mesh_2->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh_2->m_Kernel.GetFaceInfo();
 		const CoordArray& vtx_coord_array = p_mesh_2->m_Kernel.GetVertexInfo().GetCoord();
 		ParamDistortion param_distortion_2(param_2);
 
@@ -236,7 +236,7 @@ namespace PARAM
 				Coord by_coord = surface_coord.barycentric;
 
 				vector<Coord> tri_vtx_coord(3);
-				const IndexArray& face_index = face_index_array[face_id];
+				const int* face_index = face_info.GetFaceVertices(face_id);
 				for(size_t i=0; i<3; ++i) tri_vtx_coord[i] = vtx_coord_array[face_index[i]];
 				vector<Coord2D> local_coord_array = ParamDistortion::ComputeLocal2DCoord(tri_vtx_coord);
 				Coord2D vtx_local_coord = local_coord_array[0]*by_coord[0] + local_coord_array[1]*by_coord[1] + local_coord_array[2]*by_coord[2];
@@ -287,7 +287,7 @@ namespace PARAM
 		zjucad::matrix::matrix<double>& j_mat)
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_cross_param.GetQuadParam2().GetMeshModel();
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		const PolyIndexArray& vtx_adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
 
 	    ParamDistortion param_distortion(m_cross_param.GetQuadParam2());
@@ -298,7 +298,7 @@ namespace PARAM
 		j_mat.resize(2, 2); 
 		j_mat(0, 0) = j_mat(0, 1) = j_mat(1, 0) = j_mat(1, 1) = 0;
 
-		const IndexArray& fv_array = face_index_array[surface_coord.face_index];
+		const int* fv_array = face_info.GetFaceVertices(surface_coord.face_index);
 
 		const Coord& by_coord = surface_coord.barycentric;
 		int zero_num=0;
@@ -477,7 +477,7 @@ namespace PARAM
 		ParamDistortion param_distortion_1(param_1);
 		ParamDistortion param_distortion_2(param_2);	
 		
-		const PolyIndexArray& face_list_2 = p_mesh_2->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info_2 = p_mesh_2->m_Kernel.GetFaceInfo();
 		const CoordArray& vtx_coord_array_2 = p_mesh_2->m_Kernel.GetVertexInfo().GetCoord();
 
 		int vert_num_1 = p_mesh_1->m_Kernel.GetModelInfo().GetVertexNum();
@@ -508,7 +508,7 @@ namespace PARAM
 			}
 
 			int std_frame_id = vtx_surface_coord.face_index;
-			const IndexArray& cur_face = face_list_2[vtx_surface_coord.face_index];
+			const int* cur_face = face_info_2.GetFaceVertices(vtx_surface_coord.face_index);
 			int std_chart_id = param_2.GetVertexChartID(cur_face[0]);
 
 			std_chart_id = cur_vtx_chart_id;
@@ -528,7 +528,7 @@ namespace PARAM
 				param_distortion_2.ComputeSurfaceCoord(ChartParamCoord(param_coord, std_chart_id), surface_coord);
 
 				int cur_frame_id = surface_coord.face_index;
-				const IndexArray& faces = face_list_2[cur_frame_id];
+				const int* faces = face_info_2.GetFaceVertices(cur_frame_id);
 				vector<Coord> vtx_pos_array_3d(3);
 				for(int i=0; i<3; ++i) vtx_pos_array_3d[i] = vtx_coord_array_2[faces[i]];
 				vector<Coord2D> vtx_pos_array_2d = ComputeTriVertexLocalCoord(vtx_pos_array_3d);				
@@ -4,6 +4,8 @@
 #include "ChartCreator.h"
 #include "TransFunctor.h"
 #include "Barycentric.h"
+#include "SolveMonitor.h"
+#include "ChartTriangleGrid.h"
 #include "../ModelMesh/MeshModel.h"
 #include <fstream>
 
@@ -11,7 +13,7 @@ namespace PARAM
 {
 
 	CrossParameter::CrossParameter(const Parameter& parameter_1, const Parameter& parameter_2)
-		: m_parameter_1(parameter_1), m_parameter_2(parameter_2){}
+		: m_parameter_1(parameter_1), m_parameter_2(parameter_2), p_solve_monitor(NULL){}
 	CrossParameter::~CrossParameter(){}
 
 	bool CrossParameter::LoadCorrespondingFile(const std::string& corresponding_file)
@@ -120,72 +122,92 @@ namespace PARAM
 	{
 		const boost::shared_ptr<MeshModel> p_mesh_1 = m_parameter_1.GetMeshModel();
 		int vert_num = p_mesh_1->m_Kernel.GetModelInfo().GetVertexNum();
-	    m_corresponding_AB.clear();
+		m_corresponding_AB.clear();
 		m_corresponding_AB.resize(vert_num);
-		printf("Find Corresponding from Surface A to Surface B: ##############");
-
-		int len = 0, progress = 0;
 		m_uncorresponding_vert_array_A.clear();
-		for(int vid=0; vid < vert_num; ++vid)
-		{
-			int chart_id = m_parameter_1.GetVertexChartID(vid);
-			PARAM::ParamCoord param_coord = m_parameter_1.GetVertexParamCoord(vid);
+		printf("Find Corresponding from Surface A to Surface B: ");
 
-			PARAM::SurfaceCoord surface_coord;
-			if(!GetSurfaceCoordOnB(PARAM::ChartParamCoord(param_coord, chart_id), surface_coord))
+		/// all the vertices are located on surface B in one batched lookup
+		std::vector<SurfaceLocateResult> locate_result_array;
+		if(!(m_conner_correspondingAB.empty() || m_edge_correspondingAB.empty() || m_patch_correspondingBA.empty()))
+		{
+			std::vector<ChartParamCoord> chart_param_coord_array(vert_num);
+			for(int vid=0; vid < vert_num; ++vid)
 			{
-				m_uncorresponding_vert_array_A.push_back(vid);
-				if(vid != 0){
-					surface_coord = m_corresponding_AB[vid-1];
-				}
+				ChartParamCoord chart_param_coord_onA(m_parameter_1.GetVertexParamCoord(vid), m_parameter_1.GetVertexChartID(vid));
+				chart_param_coord_array[vid] = GetChartParamCoord4CorrespondingChartOnB(chart_param_coord_onA);
 			}
-			m_corresponding_AB[vid] = surface_coord;
+			m_parameter_2.FindCorrespondingOnSurface(chart_param_coord_array, locate_result_array);
+		}
+		if(p_solve_monitor)
+		{
+			p_solve_monitor->ReportProgress(SOLVE_STAGE_CORRESPONDING, 100, 1.0);
+			if(p_solve_monitor->IsCanceled()) locate_result_array.clear();
+		}
 
-			if(len == (vert_num/100+1)){
-				printf("%3d%%", ++progress);
-				printf("\b\b\b\b");
-				len=0;
+		/// a vertex outside all the charts takes the surface coordinate of the previous vertex
+		for(int vid=0; vid < vert_num; ++vid)
+		{
+			if(vid < (int) locate_result_array.size() && locate_result_array[vid].state == LOCATE_INSIDE)
+			{
+				m_corresponding_AB[vid] = locate_result_array[vid].surface_coord;
+			}else
+			{
+				m_uncorresponding_vert_array_A.push_back(vid);
+				if(vid != 0)
+					m_corresponding_AB[vid] = m_corresponding_AB[vid-1];
+				else if(vid < (int) locate_result_array.size() && locate_result_array[vid].state == LOCATE_NEAREST)
+					m_corresponding_AB[vid] = locate_result_array[vid].surface_coord;
 			}
-			len ++;
 		}
-		printf("\n");
+		printf("%d vertices not found\n", (int) m_uncorresponding_vert_array_A.size());
+		if(p_solve_monitor) p_solve_monitor->ReportProgress(SOLVE_STAGE_FINISH, 100, 1.0);
 	}
 
 	void CrossParameter::FindCorrespondingBA()
 	{
 		const boost::shared_ptr<MeshModel> p_mesh_2 = m_parameter_2.GetMeshModel();
 		int vert_num = p_mesh_2->m_Kernel.GetModelInfo().GetVertexNum();
-
 		m_corresponding_BA.clear();
 		m_corresponding_BA.resize(vert_num);
-		printf("Find Corresponding from Surface B to Surface A: ##############");
+		m_uncorresponding_vert_array_B.clear();
+		printf("Find Corresponding from Surface B to Surface A: ");
 
-		int len = 0, progress = 0;
+		/// all the vertices are located on surface A in one batched lookup
+		std::vector<SurfaceLocateResult> locate_result_array;
+		if(!(m_conner_correspondingAB.empty() || m_edge_correspondingAB.empty() || m_patch_correspondingBA.empty()))
+		{
+			std::vector<ChartParamCoord> chart_param_coord_array(vert_num);
+			for(int vid=0; vid < vert_num; ++vid)
+			{
+				ChartParamCoord chart_param_coord_onB(m_parameter_2.GetVertexParamCoord(vid), m_parameter_2.GetVertexChartID(vid));
+				chart_param_coord_array[vid] = GetChartParamCoord4CorrespondingChartOnA(chart_param_coord_onB);
+			}
+			m_parameter_1.FindCorrespondingOnSurface(chart_param_coord_array, locate_result_array);
+		}
+		if(p_solve_monitor)
+		{
+			p_solve_monitor->ReportProgress(SOLVE_STAGE_CORRESPONDING, 100, 1.0);
+			if(p_solve_monitor->IsCanceled()) locate_result_array.clear();
+		}
 
-		m_uncorresponding_vert_array_B.clear();
+		/// a vertex outside all the charts takes the surface coordinate of the previous vertex
 		for(int vid=0; vid < vert_num; ++vid)
 		{
-			int chart_id = m_parameter_2.GetVertexChartID(vid);
-			PARAM::ParamCoord param_coord = m_parameter_2.GetVertexParamCoord(vid);
-
-			PARAM::SurfaceCoord surface_coord;
-			if(!GetSurfaceCoordOnA(PARAM::ChartParamCoord(param_coord, chart_id), surface_coord))
+			if(vid < (int) locate_result_array.size() && locate_result_array[vid].state == LOCATE_INSIDE)
+			{
+				m_corresponding_BA[vid] = locate_result_array[vid].surface_coord;
+			}else
 			{
 				m_uncorresponding_vert_array_B.push_back(vid);
-				if(vid != 0){
-					surface_coord = m_corresponding_BA[vid-1];
-				}
-			}
-			m_corresponding_BA[vid] = surface_coord;
-
-			if(len == (vert_num/100+1)){
-				printf("%3d%%", ++progress);
-				printf("\b\b\b\b");
-				len=0;
+				if(vid != 0)
+					m_corresponding_BA[vid] = m_corresponding_BA[vid-1];
+				else if(vid < (int) locate_result_array.size() && locate_result_array[vid].state == LOCATE_NEAREST)
+					m_corresponding_BA[vid] = locate_result_array[vid].surface_coord;
 			}
-			len ++;
 		}
-		printf("\n");
+		printf("%d vertices not found\n", (int) m_uncorresponding_vert_array_B.size());
+		if(p_solve_monitor) p_solve_monitor->ReportProgress(SOLVE_STAGE_FINISH, 100, 1.0);
 	}
 
 	void CrossParameter::VertTextureTransferBA()
@@ -218,14 +240,14 @@ namespace PARAM
 		const PolyTexCoordArray& face_tex_array_1 = p_mesh_1->m_Kernel.GetFaceInfo().GetTexCoord();
 
 		int face_num_2 = p_mesh_2->m_Kernel.GetModelInfo().GetFaceNum();
-		const PolyIndexArray& face_list_2 = p_mesh_2->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info_2 = p_mesh_2->m_Kernel.GetFaceInfo();
 
 		m_transfer_face_tex_array_B.clear();
 		m_transfer_face_tex_array_B.resize(face_num_2);
 
 		for(int i=0; i<face_num_2; ++i)
 		{
-			const IndexArray& face = face_list_2[i];
+			const int* face = face_info_2.GetFaceVertices(i);
 			TexCoordArray& face_tex_vec = m_transfer_face_tex_array_B[i];
 			face_tex_vec.clear(); face_tex_vec.resize(3);
 			for(int k=0; k<3; ++k)
@@ -7,6 +7,7 @@
 namespace PARAM
 {
 	class Parameter;
+	class SolveMonitor;
 
 	class CrossParameter
 	{
@@ -20,6 +21,10 @@ namespace PARAM
 		void ComputeUnitedDistortionAB();
 		void ComputeUnitedDistortionBA();
 	    
+		//! progress and cancellation of FindCorrespondingAB/BA, NULL for none.
+		//! the vertices are located in one batch, a cancel reported after it leaves them all uncorresponded
+		void SetSolveMonitor(SolveMonitor* monitor) { p_solve_monitor = monitor; }
+
 		void FindCorrespondingAB();
 		void FindCorrespondingBA();
 
@@ -54,6 +59,8 @@ namespace PARAM
 		const Parameter& m_parameter_1;
 		const Parameter& m_parameter_2;
 
+		SolveMonitor* p_solve_monitor;
+
 		std::vector<SurfaceCoord> m_corresponding_BA;
 
 		std::vector<TexCoord> m_transfer_vert_tex_array_A;
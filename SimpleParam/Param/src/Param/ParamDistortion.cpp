@@ -35,8 +35,8 @@ namespace PARAM
 	zjucad::matrix::matrix<double> ParamDistortion::ComputeLocalJacobiMatrix(int fid)
 	{
 		const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& face_index = face_index_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* face_index = face_info.GetFaceVertices(fid);
 
 		vector<ParamCoord> inChart_param_coord(3);
 		int face_chart_id = m_param.GetFaceChartID(fid);
@@ -99,8 +99,8 @@ namespace PARAM
 	zjucad::matrix::matrix<double> ParamDistortion::ComputeTriJacobiMatrix(int fid)
 	{		
 		const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& face_index = face_index_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* face_index = face_info.GetFaceVertices(fid);
 
 		vector<ParamCoord> inChart_param_coord(3);
 		//int face_chart_id = m_param.GetFaceChartID(fid);
@@ -227,7 +227,7 @@ namespace PARAM
 
 	bool ParamDistortion::ComputeSurfaceCoord(const ChartParamCoord& chart_param_coord, SurfaceCoord& surface_coord)
 	{
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
 		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 
@@ -239,7 +239,7 @@ namespace PARAM
 		int valid_barycentric_num = 0;
 		for(int k=0; k<face_num;  ++k)
 		{
-			const IndexArray& face_index = face_index_array[k];
+			const int* face_index = face_info.GetFaceVertices(k);
 			vector<ParamCoord> param_coord_array(3);
 			for(int i=0; i<3; ++i)
 			{
@@ -286,7 +286,7 @@ namespace PARAM
 
 				Coord pos_coord(0, 0, 0);
 				const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-				const IndexArray& face_index = face_index_array[valid_face_array[k]];
+				const int* face_index = face_info.GetFaceVertices(valid_face_array[k]);
 
 				vector<Coord> vtx_coord(3);
 				for(size_t i=0; i<3; ++i) vtx_coord[i] = vtx_coord_array[face_index[i]];
@@ -3,6 +3,7 @@
 #include "Parameter.h"
 #include "ChartCreator.h"
 #include "../ModelMesh/MeshModel.h"
+#include "../ModelMesh/MeshModelRaster.h"
 #include <vector>
 #include <limits>
 
@@ -14,6 +15,38 @@
 #endif
 namespace PARAM
 {
+	namespace
+	{
+		//! fold an index array into a running hash
+		size_t HashIndexArray(const std::vector<int>& index_array, size_t seed)
+		{
+			for(size_t k=0; k<index_array.size(); ++k) seed = (seed*1000003) ^ (size_t) (index_array[k] + 1);
+			return (seed*1000003) ^ index_array.size();
+		}
+
+		//! append a sphere as triangles, with the slices and stacks DrawSphere gives gluSphere
+		void AddSphere(GLVertexBatch& batch, const Coord& center, double radius, const Color& color)
+		{
+			const int slices = 15, stacks = 10;
+			for(int i=0; i<stacks; ++i)
+			{
+				double phi[2] = { PI*i/stacks, PI*(i+1)/stacks };
+				for(int j=0; j<slices; ++j)
+				{
+					double theta[2] = { 2*PI*j/slices, 2*PI*(j+1)/slices };
+					Normal n[4];
+					for(int q=0; q<4; ++q)
+					{
+						double p = phi[(q==1 || q==2) ? 1 : 0], t = theta[(q>=2) ? 1 : 0];
+						n[q] = Normal(sin(p)*cos(t), sin(p)*sin(t), cos(p));
+					}
+					int tri[6] = {0, 1, 2, 0, 2, 3};
+					for(int q=0; q<6; ++q) batch.AddVertex(center + n[tri[q]]*radius, color, n[tri[q]]);
+				}
+			}
+		}
+	}
+
 	ParamDrawer::ParamDrawer(const Parameter& _param) 
 		: m_parameter(_param) {
 			m_selected_patch_id = -1;
@@ -25,9 +58,25 @@ namespace PARAM
 			m_draw_flip_face = false;
 			m_draw_uncorrespoinding = false;
 			m_selected_surface_coord = SurfaceCoord(-1, 0, 0, 0);
+			InvalidateOverlay();
 	}
 	ParamDrawer::~ParamDrawer(){}
 
+	void ParamDrawer::InvalidateOverlay() const
+	{
+		m_patch_conner_sign = m_patch_edge_sign = m_patch_face_sign = m_fliped_face_sign = 0;
+	}
+
+	size_t ParamDrawer::MeshSignature() const
+	{
+		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
+		if(p_mesh == NULL) return 0;
+		size_t sign = p_mesh->m_Kernel.GetModifyCount();
+		sign = sign*1000003 + p_mesh->m_Kernel.GetVertexInfo().GetCoord().size();
+		sign = sign*1000003 + p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
+		return sign + 1;
+	}
+
 	void ParamDrawer::Draw() const
 	{
 		glEnable(GL_LIGHTING);
@@ -87,54 +136,161 @@ namespace PARAM
 	
 	}
 
-	void ParamDrawer::DrawPatchConner() const
+	void ParamDrawer::AddLayoutOverlay(MeshModelRaster& raster, bool with_edge, bool with_conner) const
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
 		boost::shared_ptr<ChartCreator> p_chart_creator = m_parameter.GetChartCreator();
 
-		if(p_mesh == NULL) return ;
+		if(p_mesh == NULL) return;
 		if(p_chart_creator == NULL) return;
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-		int colors[56][3] = 
+		if(with_edge)
 		{
-			{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
-			{ 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
+			const std::vector<PatchEdge>& patch_edge_array = p_chart_creator->GetPatchEdgeArray();
+			CoordArray strip;
+			for(size_t k=0; k<patch_edge_array.size(); ++k)
+			{
+				const std::vector<int>& path = patch_edge_array[k].m_mesh_path;
+				strip.resize(path.size());
+				for(size_t i=0; i<path.size(); ++i) strip[i] = vCoord[path[i]];
+				raster.AddLineStrip(strip, Color(0, 0, 0));
+			}
+		}
 
-			{255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
-			{0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
+		if(with_conner)
+		{
+			const std::vector<PatchConner>& conner_array = p_chart_creator->GetPatchConnerArray();
+			for(size_t k=0; k<conner_array.size(); ++k)
+			{
+				const PatchConner& conner = conner_array[k];
+				Color c(255, 255, 0);
+				if(conner.m_conner_type == 2) c = Color(255, 0, 0);
+				else if(conner.m_conner_type == 1) c = Color(0, 255, 0);
+				else if(conner.m_conner_type == 0) c = Color(0, 0, 255);
+				raster.AddPoint(vCoord[conner.m_mesh_index], c);
+			}
+		}
+	}
 
-			{255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
-			{0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
+	bool ParamDrawer::SaveSnapshot(const std::string& file_name, int mode, int width, int height) const
+	{
+		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
+		boost::shared_ptr<ChartCreator> p_chart_creator = m_parameter.GetChartCreator();
+		if(p_mesh == NULL) return false;
 
-			{128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
-			{0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
+		MeshModelKernel& kernel = p_mesh->m_Kernel;
+		const FaceInfo& face_info = kernel.GetFaceInfo();
+		size_t face_num = face_info.GetFaceNum();
 
-			{128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
-			{0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
+		MeshModelRaster raster;
+		raster.SetImageSize(width, height);
+		raster.FitCamera(kernel, Coord(0, 0, -1), Coord(0, 1, 0));
 
-			{64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
-			{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
-		};
+		/// the shading data is swapped into the mesh for the rendering and swapped back after
+		ColorArray face_color;
+		PolyTexCoordArray face_tex_coord;
+		if((mode & DRAWDISTORTION) == DRAWDISTORTION)
+		{
+			MeshModelRaster::ScalarToColor(m_parameter.GetFaceHarmonicDistortion(), face_color);
+			raster.ShadeMode() = RASTER_SHADE_FACE_COLOR;
+		}else if((mode & DRAWFACETEXTURE) == DRAWFACETEXTURE)
+		{
+			std::vector<double> face_param_coord;
+			m_parameter.GatherFaceParamCoord(face_param_coord);
+			face_tex_coord.resize(face_num);
+			for(size_t fid=0; fid<face_num; ++fid)
+			{
+				face_tex_coord[fid].resize(3);
+				for(int j=0; j<3; ++j)
+					face_tex_coord[fid][j] = TexCoord(face_param_coord[fid*6 + 2*j], face_param_coord[fid*6 + 2*j + 1]);
+			}
+			raster.ShadeMode() = RASTER_SHADE_TEX_CHECKER;
+		}else if((mode & DRAWPATCHFACE) == DRAWPATCHFACE && p_chart_creator != NULL)
+		{
+			const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
+			face_color.assign(face_num, Color(0.7, 0.7, 0.7));
+			for(size_t k=0; k<patch_array.size(); ++k)
+			{
+				/// a fixed color per patch id, so the images of two runs can be compared
+				Color c((int)(k*97 + 64)%256, (int)(k*57 + 128)%256, (int)(k*151 + 192)%256);
+				const std::vector<int>& faces = patch_array[k].m_face_index_array;
+				for(size_t i=0; i<faces.size(); ++i) face_color[faces[i]] = c;
+			}
+			raster.ShadeMode() = RASTER_SHADE_FACE_COLOR;
+		}
 
+		AddLayoutOverlay(raster, (mode & DRAWPATCHEDGE) == DRAWPATCHEDGE, (mode & DRAWPATCHCONNER) == DRAWPATCHCONNER);
 
+		kernel.GetFaceInfo().GetColor().swap(face_color);
+		kernel.GetFaceInfo().GetTexCoord().swap(face_tex_coord);
+		raster.Render(kernel);
+		kernel.GetFaceInfo().GetColor().swap(face_color);
+		kernel.GetFaceInfo().GetTexCoord().swap(face_tex_coord);
+
+		return raster.SaveImage(file_name);
+	}
+
+	void ParamDrawer::DrawPatchConner() const
+	{
+		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
+		boost::shared_ptr<ChartCreator> p_chart_creator = m_parameter.GetChartCreator();
+
+		if(p_mesh == NULL) return ;
+		if(p_chart_creator == NULL) return;
+		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 		const std::vector<PatchConner>& conner_array = p_chart_creator->GetPatchConnerArray();
-		for(size_t k=0; k<conner_array.size(); ++k)
-		{            
-			int c = k%56;
-			glColor3ub(colors[c][0], colors[c][1], colors[c][2]);
-			const PatchConner& conner = conner_array[k];
-			if(conner.m_conner_type == 2){
-				glColor3ub(255, 0, 0);
-			}else if(conner.m_conner_type == 1){
-				glColor3ub(0, 255, 0);
-			}else if(conner.m_conner_type == 0){
-				glColor3ub(0, 0, 255);
+
+		std::vector<int> conner_vert_array(conner_array.size());
+		for(size_t k=0; k<conner_array.size(); ++k) conner_vert_array[k] = conner_array[k].m_mesh_index;
+		size_t sign = HashIndexArray(conner_vert_array, MeshSignature());
+
+		if(sign != m_patch_conner_sign)
+		{
+			int colors[56][3] = 
+			{
+				{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
+				{ 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
+
+				{255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
+				{0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
+
+				{255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
+				{0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
+
+				{128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
+				{0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
+
+				{128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
+				{0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
+
+				{64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
+				{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
+			};
+
+			double bRadius;
+			Coord center;
+			p_mesh->m_Kernel.GetModelInfo().GetBoundingSphere(center, bRadius);
+
+			m_patch_conner_batch.ClearData();
+			for(size_t k=0; k<conner_array.size(); ++k)
+			{            
+				int c = k%56;
+				Color color = Color(colors[c][0], colors[c][1], colors[c][2]);
+				const PatchConner& conner = conner_array[k];
+				if(conner.m_conner_type == 2){
+					color = Color(255, 0, 0);
+				}else if(conner.m_conner_type == 1){
+					color = Color(0, 255, 0);
+				}else if(conner.m_conner_type == 0){
+					color = Color(0, 0, 255);
+				}
+				AddSphere(m_patch_conner_batch, vCoord[conner.m_mesh_index], 0.02*bRadius, color);
 			}
-			int mesh_idx = conner_array[k].m_mesh_index;
-			DrawSphere(vCoord[mesh_idx]);
+			m_patch_conner_sign = sign;
 		}
 
+		m_patch_conner_batch.Draw(GL_TRIANGLES);
 	}
 
 	void ParamDrawer::DrawPatchEdge() const
@@ -147,40 +303,49 @@ namespace PARAM
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 		const std::vector<PatchEdge>& patch_edge_array = p_chart_creator->GetPatchEdgeArray();
 
-		int colors[56][3] = 
-		{			  
-			{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
-			{ 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
+		size_t sign = MeshSignature();
+		for(size_t k=0; k<patch_edge_array.size(); ++k) sign = HashIndexArray(patch_edge_array[k].m_mesh_path, sign);
 
-			{255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
-			{0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
+		if(sign != m_patch_edge_sign)
+		{
+			int colors[56][3] = 
+			{			  
+				{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
+				{ 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
 
-			{255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
-			{0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
+				{255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
+				{0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
 
-			{128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
-			{0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
+				{255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
+				{0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
 
-			{128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
-			{0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
+				{128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
+				{0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
 
-			{64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
-			{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
-		};
+				{128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
+				{0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
 
-		for(size_t k=0; k<patch_edge_array.size(); ++k)
-		{
-			int c = k%56;
-			glColor3ub(colors[c][0], colors[c][1], colors[c][2]);
-			const std::vector<int>& path = patch_edge_array[k].m_mesh_path;
-			glBegin(GL_LINE_STRIP);
-			for(size_t i=0; i<path.size(); ++i)
+				{64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
+				{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
+			};
+
+			/// each line strip is split into segments so all the edges go in one draw
+			m_patch_edge_batch.ClearData();
+			for(size_t k=0; k<patch_edge_array.size(); ++k)
 			{
-				const Coord& vtxCoord = vCoord[path[i]];
-				glVertex3d(vtxCoord[0], vtxCoord[1], vtxCoord[2]);
+				int c = k%56;
+				Color color = Color(colors[c][0], colors[c][1], colors[c][2]);
+				const std::vector<int>& path = patch_edge_array[k].m_mesh_path;
+				for(size_t i=0; i+1<path.size(); ++i)
+				{
+					m_patch_edge_batch.AddVertex(vCoord[path[i]], color);
+					m_patch_edge_batch.AddVertex(vCoord[path[i+1]], color);
+				}
 			}
-			glEnd();
+			m_patch_edge_sign = sign;
 		}
+
+		m_patch_edge_batch.Draw(GL_LINES);
 	}
 
     void ParamDrawer::DrawPatchFace() const
@@ -191,52 +356,55 @@ namespace PARAM
         if(p_mesh == NULL) return;
         if(p_chart_creator == NULL) return;
 
-        int colors[56][3] = 
-		{			  
-			{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
-			{ 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
-
-			{255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
-			{0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
-
-			{255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
-			{0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
-
-			{128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
-			{0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
-
-			{128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
-			{0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
-
-			{64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
-			{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
-		};
-
-        
         const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
-        const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-        const NormalArray& vert_norm_array = p_mesh->m_Kernel.GetVertexInfo().GetNormal();
-        const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const NormalArray& face_norm_array = p_mesh->m_Kernel.GetFaceInfo().GetNormal();
-
-        glBegin(GL_TRIANGLES);
-        for(size_t k=0; k<patch_array.size(); ++k){           
-            const ParamPatch& patch = patch_array[k];
-            const std::vector<int>& faces = patch.m_face_index_array;
-            glColor3ub(colors[k%56][0], colors[k%56][1], colors[k%56][2]);
-            for(size_t i=0; i<faces.size(); ++i){
-                int fid = faces[i];
-                const IndexArray& vertices = face_list_array[fid];
-                for(int j=0; j<3; ++j){
-                    const Coord& v = vert_coord_array[vertices[j]];
-                    const Normal& n = vert_norm_array[vertices[j]];
-                    glNormal3d(n[0], n[1], n[2]);
-                    glVertex3d(v[0], v[1], v[2]);
+
+        size_t sign = MeshSignature();
+        for(size_t k=0; k<patch_array.size(); ++k) sign = HashIndexArray(patch_array[k].m_face_index_array, sign);
+
+        if(sign != m_patch_face_sign)
+        {
+            int colors[56][3] = 
+            {			  
+                {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, 
+                { 255, 0 , 255}, {0, 255, 255}, {255, 255, 255}, {0, 0, 0},
+
+                {255, 128, 128}, {0, 64, 128},  {255, 128, 192}, {128, 255, 128}, 
+                {0, 255, 128}, {128, 255, 255}, {0, 128, 255}, {255, 128, 255}, 
+
+                {255, 0, 0}, {255, 255, 0}, {128, 255, 0}, {0, 255, 64}, 
+                {0, 255, 255}, {0, 128, 192}, {128, 128, 192}, {255, 0, 255}, 
+
+                {128, 64, 64}, {255, 128, 64}, {0, 255, 0}, {0, 128, 128}, 
+                {0, 64, 128}, {128, 128, 255}, {128, 0, 64}, {255, 0, 128}, 
+
+                {128, 0, 0}, {0, 128, 0}, {0, 128, 64}, {255, 255, 128},
+                {0, 0, 255}, {0, 0, 160}, {128, 0, 128}, {128, 0, 255}, 
+
+                {64, 0, 0}, {128, 64, 0}, {0, 64, 0}, {0, 64, 64}, 
+                {0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
+            };
+
+            const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+            const NormalArray& vert_norm_array = p_mesh->m_Kernel.GetVertexInfo().GetNormal();
+            const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
+
+            m_patch_face_batch.ClearData();
+            for(size_t k=0; k<patch_array.size(); ++k){           
+                const ParamPatch& patch = patch_array[k];
+                const std::vector<int>& faces = patch.m_face_index_array;
+                Color color = Color(colors[k%56][0], colors[k%56][1], colors[k%56][2]);
+                for(size_t i=0; i<faces.size(); ++i){
+                    int fid = faces[i];
+                    const int* vertices = face_info.GetFaceVertices(fid);
+                    for(int j=0; j<3; ++j){
+                        m_patch_face_batch.AddVertex(vert_coord_array[vertices[j]], color, vert_norm_array[vertices[j]]);
+                    }
                 }
             }
+            m_patch_face_sign = sign;
         }
-        glEnd();
-                    
+
+        m_patch_face_batch.Draw(GL_TRIANGLES);
     }
 
 	void ParamDrawer::DrawOutRangeVertex() const
@@ -271,7 +439,7 @@ namespace PARAM
 		};
 
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
 		const std::vector<PatchConner>& patch_conners = p_chart_creator->GetPatchConnerArray();
@@ -310,7 +478,7 @@ namespace PARAM
 		for(size_t k=0; k<patch.m_face_index_array.size(); ++k)
 		{
 			int fid = patch.m_face_index_array[k];
-			const IndexArray& fIndex = face_list_array[fid];
+			const int* fIndex = face_info.GetFaceVertices(fid);
 			glBegin(GL_TRIANGLES);
 
 			for(int j = 0; j < 3; ++ j)
@@ -332,7 +500,7 @@ namespace PARAM
 			for(size_t k=0; k<nb_patch.m_face_index_array.size(); ++k)
 			{
 				int fid = nb_patch.m_face_index_array[k];
-				const IndexArray& fIndex = face_list_array[fid];
+				const int* fIndex = face_info.GetFaceVertices(fid);
 				glBegin(GL_TRIANGLES);
 
 				for(int j = 0; j < 3; ++ j)
@@ -369,7 +537,7 @@ namespace PARAM
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();		
 		if(p_mesh == NULL) return ;
 		const std::vector<int>& unset_face_array = m_parameter.GetUnSetFaceArray();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
 		glColor3ub(0, 0, 255);
@@ -377,7 +545,7 @@ namespace PARAM
 		{
 			int fid = unset_face_array[k];
 			
-			const IndexArray& fIndex = face_list_array[fid];
+			const int* fIndex = face_info.GetFaceVertices(fid);
 			glBegin(GL_TRIANGLES);
 
 			for(int j = 0; j < 3; ++ j)
@@ -397,29 +565,27 @@ namespace PARAM
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();		
 		if(p_mesh == NULL) return ;
 		const std::vector<int>& fliped_face_array = m_parameter.GetFlipedFaceArray();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-		glDisable(GL_LIGHTING);
-
-		glColor3ub(255, 255, 0);
-		for(size_t k=0; k<fliped_face_array.size(); ++k)
+		size_t sign = HashIndexArray(fliped_face_array, MeshSignature());
+		if(sign != m_fliped_face_sign)
 		{
-			int fid = fliped_face_array[k];
-
-			const IndexArray& fIndex = face_list_array[fid];
-			glBegin(GL_TRIANGLES);
+			const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+			const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-			for(int j = 0; j < 3; ++ j)
+			m_fliped_face_batch.ClearData();
+			for(size_t k=0; k<fliped_face_array.size(); ++k)
 			{
-				int vID = fIndex[j];
-				const Coord& v = vCoord[vID];
-				glVertex3d(v[0], v[1], v[2]);
+				const int* fIndex = face_info.GetFaceVertices(fliped_face_array[k]);
+				for(int j = 0; j < 3; ++ j)
+				{
+					m_fliped_face_batch.AddVertex(vCoord[fIndex[j]], Color(255, 255, 0));
+				}
 			}
-
-			glEnd();
+			m_fliped_face_sign = sign;
 		}
 
+		glDisable(GL_LIGHTING);
+		m_fliped_face_batch.Draw(GL_TRIANGLES);
 		glEnable(GL_LIGHTING);
 	}
 
@@ -438,24 +604,9 @@ namespace PARAM
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
 		if(p_mesh == NULL) return -1;
-		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
 
-		double min_dist = numeric_limits<double>::infinity();
-		
 		int nearest_vert_id(-1);
-
-		for(int k=0; k<vert_num; ++k)
-		{
-			const Coord& vtx_coord = vCoord[k];
-			double cur_dist = (vtx_coord - select_coord).abs();
-			if(min_dist > cur_dist)
-			{
-				min_dist = cur_dist;
-				nearest_vert_id = k;
-			}
-		}
-
+		if(!p_mesh->m_SpatialIndex.GetNearestVertex(select_coord, nearest_vert_id)) return -1;
 		return nearest_vert_id;
 	}
 
@@ -463,41 +614,12 @@ namespace PARAM
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
 		if(p_mesh == NULL) return SurfaceCoord(-1, 0, 0, 0);
-		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const PolyIndexArray& vAdjFaces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-
-		if(m_selected_vert_id == -1) return SurfaceCoord(-1, Barycentrc(0, 0, 0));
-		const IndexArray& adj_faces = vAdjFaces[m_selected_vert_id];
-		
-
-		double min_baryc_corod_error = std::numeric_limits<double>::infinity();
-		int min_error_fid;
-		Barycentrc min_error_baryc;
-
-		for(int k = 0; k<adj_faces.size(); ++k)
-		{
-			int fid = adj_faces[k];
-			std::vector<Coord> vert_coord_vec(3);
-			const IndexArray& face = fIndex[fid];
-			for(int i=0; i<3; ++i)
-			{
-				vert_coord_vec[i] = vCoord[face[i]];
-			}
-			Barycentrc bc = ComputeVertexBarycentric(vert_coord_vec, select_coord);
-			if(IsValidBarycentic(bc)){
-				return SurfaceCoord(fid, bc);
-			}else{
-				double error = ComputeErrorOutValidBarycentric(bc);
-				if(error < min_baryc_corod_error){
-					min_baryc_corod_error = error;
-					min_error_fid = fid;
-					min_error_baryc = bc;
-				}
-			}
-		}
 
-		return SurfaceCoord(min_error_fid, min_error_baryc);
+		int fid(-1);
+		Barycentrc baryc;
+		if(!p_mesh->m_SpatialIndex.GetNearestSurfacePoint(select_coord, fid, baryc))
+			return SurfaceCoord(-1, Barycentrc(0, 0, 0));
+		return SurfaceCoord(fid, baryc);
 	}
 
 	void ParamDrawer::SetSelectedVertCoord(const Coord& select_coord)
@@ -515,9 +637,9 @@ namespace PARAM
 		m_selected_surface_coord = select_coord;
 
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
-		const IndexArray& face_vert_array = face_list_array[select_coord.face_index];
+		const int* face_vert_array = face_info.GetFaceVertices(select_coord.face_index);
 		Coord pos_coord(0, 0, 0);
 		for(int k=0; k<3; ++k)
 		{
@@ -2,8 +2,13 @@
 #define PARAMDRAWER_H_
 
 #include "../Common/BasicDataType.h"
+#include "../OpenGL/GLBuffer.h"
 #include "Barycentric.h"
 
+#include <string>
+
+class MeshModelRaster;
+
 namespace PARAM
 {
 	class Parameter;
@@ -63,10 +68,24 @@ namespace PARAM
 
 	public:
 		ParamDrawer(const Parameter& quad_param);
+		//! frees the overlay buffer objects, the GL context has to be current
 		~ParamDrawer();
 
 		void Draw() const;
 
+		//! rebuild the cached overlay vertices on the next draw, they follow the layout
+		//! and the mesh by themselves, this is for changes made behind their back
+		void InvalidateOverlay() const;
+
+		//! add the patch edges and conners to the overlays of a software rasterizer
+		void AddLayoutOverlay(MeshModelRaster& raster, bool with_edge = true, bool with_conner = true) const;
+
+		//! render an image without OpenGL, mode picks the shading: DRAWDISTORTION for the face
+		//! harmonic distortion, DRAWFACETEXTURE for a checkerboard of the parameter coordinates,
+		//! DRAWPATCHFACE for the patch colors, and DRAWPATCHEDGE, DRAWPATCHCONNER add the layout.
+		//! the file is PNG or PPM by its extension
+		bool SaveSnapshot(const std::string& file_name, int mode, int width = 800, int height = 600) const;
+
 	private:
 		void DrawPatchConner() const;
 		void DrawPatchEdge() const;
@@ -90,6 +109,9 @@ namespace PARAM
 
 		void DrawSphere(const Coord& center, double point_size = 1.0) const;
 
+		//! signature of the mesh an overlay is built on, the overlay's own indices are hashed onto it
+		size_t MeshSignature() const;
+
 	private:
 		const Parameter& m_parameter;
 
@@ -111,6 +133,16 @@ namespace PARAM
 		bool m_draw_uncorrespoinding;
 
 		int m_selected_patch_id;
+
+		//! cached overlay vertices and the signatures they were built with
+		mutable GLVertexBatch m_patch_conner_batch;
+		mutable GLVertexBatch m_patch_edge_batch;
+		mutable GLVertexBatch m_patch_face_batch;
+		mutable GLVertexBatch m_fliped_face_batch;
+		mutable size_t m_patch_conner_sign;
+		mutable size_t m_patch_edge_sign;
+		mutable size_t m_patch_face_sign;
+		mutable size_t m_fliped_face_sign;
 	};
 }
 
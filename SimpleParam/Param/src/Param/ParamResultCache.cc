@@ -0,0 +1,183 @@
+#include "ParamResultCache.h"
+#include "../Common/MappedFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+namespace PARAM
+{
+	namespace
+	{
+		const char RESULT_FILE_MAGIC[8] = {'P', 'R', 'M', 'R', 'S', 'L', 'T', '\0'};
+		const int RESULT_FILE_VERSION = 3;
+
+		enum ResultArrayType
+		{
+			VERT_CHART = 0, VERT_PARAM_COORD, FACE_CHART, CONNER_MESH_INDEX,
+			FACE_HARMONIC_DISTORTION, FACE_ISOMETRIC_DISTORTION, FLIPED_FACE,
+			RESULT_ARRAY_NUM
+		};
+
+		struct ResultFileHeader
+		{
+			char magic[8];
+			int version;
+			int array_num;
+			unsigned long long key;
+			unsigned long long array_offset[RESULT_ARRAY_NUM]; //! byte offset from the file begin
+			unsigned long long array_size[RESULT_ARRAY_NUM]; //! element number
+		};
+
+		unsigned long long AlignOffset(unsigned long long offset)
+		{
+			return (offset + 7) & ~7ULL;
+		}
+
+		template <typename T>
+		void PlaceArray(ResultFileHeader& header, int type, const std::vector<T>& array, unsigned long long& offset)
+		{
+			header.array_offset[type] = offset;
+			header.array_size[type] = array.size();
+			offset = AlignOffset(offset + array.size()*sizeof(T));
+		}
+
+		template <typename T>
+		void WriteArray(std::vector<char>& buffer, const ResultFileHeader& header, int type, const std::vector<T>& array)
+		{
+			if(array.empty()) return;
+			memcpy(&buffer[header.array_offset[type]], &array[0], array.size()*sizeof(T));
+		}
+
+		template <typename T>
+		bool ReadArray(const MappedFile& file, const ResultFileHeader& header, int type, std::vector<T>& array)
+		{
+			unsigned long long offset = header.array_offset[type];
+			unsigned long long size = header.array_size[type];
+			if(offset > file.GetSize() || size > (file.GetSize() - offset) / sizeof(T)) return false;
+
+			array.resize((size_t) size);
+			if(size != 0) memcpy(&array[0], file.GetData() + offset, (size_t) size*sizeof(T));
+			return true;
+		}
+	}
+
+	void ParamResult::ClearData()
+	{
+		m_vert_chart_array.clear();
+		m_vert_param_coord_array.clear();
+		m_face_chart_array.clear();
+		m_conner_mesh_index_array.clear();
+		m_face_harmonic_distortion.clear();
+		m_face_isometric_distortion.clear();
+		m_fliped_face_array.clear();
+	}
+
+	void ResultHasher::Add(const void* data, size_t byte_num)
+	{
+		const unsigned char* bytes = (const unsigned char*) data;
+		for(size_t k=0; k<byte_num; ++k)
+		{
+			m_value ^= bytes[k];
+			m_value *= 1099511628211ULL;
+		}
+	}
+
+	bool SaveParamResult(const std::string& file_name, unsigned long long key, const ParamResult& result)
+	{
+		ResultFileHeader header;
+		memset(&header, 0, sizeof(ResultFileHeader));
+		memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic));
+		header.version = RESULT_FILE_VERSION;
+		header.array_num = RESULT_ARRAY_NUM;
+		header.key = key;
+
+		unsigned long long offset = AlignOffset(sizeof(ResultFileHeader));
+		PlaceArray(header, VERT_CHART, result.m_vert_chart_array, offset);
+		PlaceArray(header, VERT_PARAM_COORD, result.m_vert_param_coord_array, offset);
+		PlaceArray(header, FACE_CHART, result.m_face_chart_array, offset);
+		PlaceArray(header, CONNER_MESH_INDEX, result.m_conner_mesh_index_array, offset);
+		PlaceArray(header, FACE_HARMONIC_DISTORTION, result.m_face_harmonic_distortion, offset);
+		PlaceArray(header, FACE_ISOMETRIC_DISTORTION, result.m_face_isometric_distortion, offset);
+		PlaceArray(header, FLIPED_FACE, result.m_fliped_face_array, offset);
+
+		std::vector<char> buffer((size_t) offset, 0);
+		memcpy(&buffer[0], &header, sizeof(ResultFileHeader));
+		WriteArray(buffer, header, VERT_CHART, result.m_vert_chart_array);
+		WriteArray(buffer, header, VERT_PARAM_COORD, result.m_vert_param_coord_array);
+		WriteArray(buffer, header, FACE_CHART, result.m_face_chart_array);
+		WriteArray(buffer, header, CONNER_MESH_INDEX, result.m_conner_mesh_index_array);
+		WriteArray(buffer, header, FACE_HARMONIC_DISTORTION, result.m_face_harmonic_distortion);
+		WriteArray(buffer, header, FACE_ISOMETRIC_DISTORTION, result.m_face_isometric_distortion);
+		WriteArray(buffer, header, FLIPED_FACE, result.m_fliped_face_array);
+
+		std::ofstream fout(file_name.c_str(), std::ios::binary);
+		if(fout.fail())
+		{
+			std::cerr << "Error : cannot open result file " << file_name << " for writing!" << std::endl;
+			return false;
+		}
+		fout.write(&buffer[0], buffer.size());
+		return !fout.fail();
+	}
+
+	bool LoadParamResult(const std::string& file_name, unsigned long long key, ParamResult& result)
+	{
+		MappedFile file;
+		if(!file.Open(file_name)) return false;
+		if(file.GetSize() < sizeof(ResultFileHeader))
+		{
+			std::cerr << "Warning : result file " << file_name << " is truncated." << std::endl;
+			return false;
+		}
+
+		ResultFileHeader header;
+		memcpy(&header, file.GetData(), sizeof(ResultFileHeader));
+		if(memcmp(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != RESULT_FILE_VERSION
+			|| header.array_num != RESULT_ARRAY_NUM
+			|| header.key != key)
+		{
+			std::cerr << "Warning : " << file_name << " is not a valid result file for this input." << std::endl;
+			return false;
+		}
+
+		result.ClearData();
+		bool valid = ReadArray(file, header, VERT_CHART, result.m_vert_chart_array)
+			&& ReadArray(file, header, VERT_PARAM_COORD, result.m_vert_param_coord_array)
+			&& ReadArray(file, header, FACE_CHART, result.m_face_chart_array)
+			&& ReadArray(file, header, CONNER_MESH_INDEX, result.m_conner_mesh_index_array)
+			&& ReadArray(file, header, FACE_HARMONIC_DISTORTION, result.m_face_harmonic_distortion)
+			&& ReadArray(file, header, FACE_ISOMETRIC_DISTORTION, result.m_face_isometric_distortion)
+			&& ReadArray(file, header, FLIPED_FACE, result.m_fliped_face_array);
+
+		if(!valid || result.m_vert_chart_array.size() != result.m_vert_param_coord_array.size()
+			|| result.m_face_harmonic_distortion.size() != result.m_face_chart_array.size()
+			|| result.m_face_isometric_distortion.size() != result.m_face_chart_array.size())
+		{
+			std::cerr << "Warning : result file " << file_name << " is truncated." << std::endl;
+			result.ClearData();
+			return false;
+		}
+		return true;
+	}
+
+	bool ParamResultCache::Load(unsigned long long key, ParamResult& result) const
+	{
+		return LoadParamResult(GetCacheFileName(key), key, result);
+	}
+
+	bool ParamResultCache::Save(unsigned long long key, const ParamResult& result) const
+	{
+		return SaveParamResult(GetCacheFileName(key), key, result);
+	}
+
+	std::string ParamResultCache::GetCacheFileName(unsigned long long key) const
+	{
+		std::ostringstream oss;
+		oss << m_cache_dir << "/param_" << std::hex << std::setw(16) << std::setfill('0') << key << ".prc";
+		return oss.str();
+	}
+}
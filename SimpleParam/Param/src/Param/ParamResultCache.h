@@ -0,0 +1,89 @@
+#ifndef PARAMRESULTCACHE_H_
+#define PARAMRESULTCACHE_H_
+
+#include "Parameterization.h"
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace PARAM
+{
+	//! all the data produced by one parameterization run, enough to restore
+	//! a Parameter without solving again. the patch edge paths are not changed
+	//! by the solve and are part of the key. the face texture coordinates are
+	//! not kept by the Parameter either, GatherFaceParamCoord derives them from
+	//! the vertex arrays when they are drawn or written.
+	class ParamResult
+	{
+	public:
+		ParamResult(){}
+		~ParamResult(){}
+
+		void ClearData();
+
+	public:
+		std::vector<int> m_vert_chart_array; //! each vertex's chart
+		std::vector<ParamCoord> m_vert_param_coord_array; //! each vertex's (s,t) in its chart
+
+		std::vector<int> m_face_chart_array; //! each face's chart
+
+		std::vector<int> m_conner_mesh_index_array; //! each patch conner's mesh vertex, after relocating
+
+		std::vector<double> m_face_harmonic_distortion; //! each face's distortion
+		std::vector<double> m_face_isometric_distortion;
+		std::vector<int> m_fliped_face_array; //! the faces flipped in the parameter domain
+	};
+
+	//! FNV-1a 64 bit hash, used as the content address of a cached result
+	class ResultHasher
+	{
+	public:
+		ResultHasher() : m_value(14695981039346656037ULL) {}
+
+		void Add(const void* data, size_t byte_num);
+		void Add(int value) { Add(&value, sizeof(int)); }
+		void Add(bool value) { Add(value ? 1 : 0); }
+		void Add(double value) { Add(&value, sizeof(double)); }
+
+		template <typename T>
+		void AddArray(const std::vector<T>& array)
+		{
+			Add((int) array.size());
+			if(!array.empty()) Add(&array[0], array.size()*sizeof(T));
+		}
+
+		unsigned long long GetValue() const { return m_value; }
+
+	private:
+		unsigned long long m_value;
+	};
+
+	//! binary result file
+	//! the file is a fixed size header followed by packed arrays, each array starts
+	//! at an 8 bytes aligned offset recorded in the header, the loader maps the
+	//! file and copies each array straight from the mapping.
+	bool SaveParamResult(const std::string& file_name, unsigned long long key, const ParamResult& result);
+	bool LoadParamResult(const std::string& file_name, unsigned long long key, ParamResult& result);
+
+	//! content addressed cache of parameterization results, one file per key
+	class ParamResultCache
+	{
+	public:
+		ParamResultCache(const std::string& cache_dir = ".") : m_cache_dir(cache_dir) {}
+		~ParamResultCache(){}
+
+		bool Load(unsigned long long key, ParamResult& result) const;
+		bool Save(unsigned long long key, const ParamResult& result) const;
+
+		std::string GetCacheFileName(unsigned long long key) const;
+
+		const std::string& GetCacheDir() const { return m_cache_dir; }
+		void SetCacheDir(const std::string& cache_dir) { m_cache_dir = cache_dir; }
+
+	private:
+		std::string m_cache_dir;
+	};
+}
+
+#endif //PARAMRESULTCACHE_H_
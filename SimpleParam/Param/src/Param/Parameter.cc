@@ -3,14 +3,17 @@
 #include "TransFunctor.h"
 #include "Barycentric.h"
 #include "TriDistortion.h"
+#include "ParamResultCache.h"
+#include "ChartTriangleGrid.h"
+#include "SolveMonitor.h"
 
 #include "../ModelMesh/MeshModel.h"
+#include "../Common/Parallel.h"
 #include "../Numerical/linear_solver.h"
+#include "../Numerical/schur_solver.h"
 #include "../Numerical/MeshSparseMatrix.h"
 #include <hj_3rd/zjucad/matrix/matrix.h>
 #include <hj_3rd/zjucad/matrix/io.h>
-#include <hj_3rd/hjlib/math/blas_lapack.h>
-#include <hj_3rd/zjucad/matrix/lapack.h>
 
 #include <iostream>
 #include <queue>
@@ -18,16 +21,266 @@
 #include <limits>
 #include <fstream>
 #include <cmath>
+#include <algorithm>
 
 namespace PARAM
 {
-	Parameter::Parameter(boost::shared_ptr<MeshModel> _p_mesh) : p_mesh(_p_mesh){}
+	//! number of solve/adjust loops in ComputeParamCoord
+	const int PARAM_SOLVE_LOOP_NUM = 6;
+	//! and in UpdateParamCoord, which starts next to a solution
+	const int PARAM_UPDATE_LOOP_NUM = 2;
+
+	namespace
+	{
+		//! signed area of a face in parameter domain, (u1-u0)*(v2-v0) - (u2-u0)*(v1-v0)
+		inline double ParamSignedArea(const double* pc)
+		{
+			return (pc[2] - pc[0]) * (pc[5] - pc[1]) - (pc[4] - pc[0]) * (pc[3] - pc[1]);
+		}
+
+		//! every index of the array is in [0, index_num)
+		bool IsIndexArrayInRange(const std::vector<int>& index_array, int index_num)
+		{
+			for(size_t k=0; k<index_array.size(); ++k)
+			{
+				if(index_array[k] < 0 || index_array[k] >= index_num) return false;
+			}
+			return true;
+		}
+
+		class FaceParamCoordGatherFunctor
+		{
+		public:
+			FaceParamCoordGatherFunctor(const FaceInfo& _face_info, const std::vector<int>& _face_chart_array,
+				const std::vector<int>& _vert_chart_array, const std::vector<ParamCoord>& _vert_param_coord_array,
+				const std::vector<long long>& _trans_key_array, const std::vector<double>& _trans_mat_array,
+				long long _chart_num, std::vector<double>& _face_param_coord)
+				: face_info(_face_info), face_chart_array(_face_chart_array), vert_chart_array(_vert_chart_array),
+				vert_param_coord_array(_vert_param_coord_array), trans_key_array(_trans_key_array),
+				trans_mat_array(_trans_mat_array), chart_num(_chart_num), face_param_coord(_face_param_coord) {}
+
+			void operator()(int fid) const
+			{
+				const int* face = face_info.GetFaceVertices(fid);
+				int face_chart_id = face_chart_array[fid];
+				double* pc = &face_param_coord[fid*6];
+				for(int i=0; i<3; ++i)
+				{
+					int vid = face[i];
+					const ParamCoord& param_coord = vert_param_coord_array[vid];
+					if(vert_chart_array[vid] == face_chart_id)
+					{
+						pc[2*i] = param_coord.s_coord;
+						pc[2*i+1] = param_coord.t_coord;
+					}else
+					{
+						size_t idx = std::lower_bound(trans_key_array.begin(), trans_key_array.end(), 
+							vid*chart_num + face_chart_id) - trans_key_array.begin();
+						const double* m = &trans_mat_array[idx*6];
+						pc[2*i] = m[0]*param_coord.s_coord + m[1]*param_coord.t_coord + m[2];
+						pc[2*i+1] = m[3]*param_coord.s_coord + m[4]*param_coord.t_coord + m[5];
+					}
+				}
+			}
+
+		private:
+			const FaceInfo& face_info;
+			const std::vector<int>& face_chart_array;
+			const std::vector<int>& vert_chart_array;
+			const std::vector<ParamCoord>& vert_param_coord_array;
+			const std::vector<long long>& trans_key_array;
+			const std::vector<double>& trans_mat_array;
+			long long chart_num;
+			std::vector<double>& face_param_coord;
+		};
+
+		//! transition of each (vertex, face chart) key, each one runs its own TransFunctor chart search
+		class VertTransMatrixFunctor
+		{
+		public:
+			VertTransMatrixFunctor(const Parameter& _parameter, const std::vector<int>& _vert_chart_array,
+				const std::vector<long long>& _trans_key_array, long long _chart_num, std::vector<double>& _trans_mat_array)
+				: parameter(_parameter), vert_chart_array(_vert_chart_array), trans_key_array(_trans_key_array),
+				chart_num(_chart_num), trans_mat_array(_trans_mat_array) {}
+
+			void operator()(int k) const
+			{
+				int vid = (int) (trans_key_array[k] / chart_num);
+				int to_chart_id = (int) (trans_key_array[k] % chart_num);
+				zjucad::matrix::matrix<double> tran_mat = parameter.GetVertTransMatrix(vert_chart_array[vid], to_chart_id, vid);
+				double* m = &trans_mat_array[k*6];
+				m[0] = tran_mat(0, 0); m[1] = tran_mat(0, 1); m[2] = tran_mat(0, 2);
+				m[3] = tran_mat(1, 0); m[4] = tran_mat(1, 1); m[5] = tran_mat(1, 2);
+			}
+
+		private:
+			const Parameter& parameter;
+			const std::vector<int>& vert_chart_array;
+			const std::vector<long long>& trans_key_array;
+			long long chart_num;
+			std::vector<double>& trans_mat_array;
+		};
+
+		class ChartGridBuildFunctor
+		{
+		public:
+			ChartGridBuildFunctor(const std::vector<int>& _grid_chart_array, const std::vector<int>& _chart_tri_offset,
+				const std::vector<int>& _tri_face_array, const std::vector<double>& _tri_param_coord,
+				std::vector<ChartTriangleGrid>& _chart_grid_array)
+				: grid_chart_array(_grid_chart_array), chart_tri_offset(_chart_tri_offset), tri_face_array(_tri_face_array),
+				tri_param_coord(_tri_param_coord), chart_grid_array(_chart_grid_array) {}
+
+			void operator()(int k) const
+			{
+				int chart_id = grid_chart_array[k];
+				int begin = chart_tri_offset[k], end = chart_tri_offset[k+1];
+				std::vector<int> face_index_array(tri_face_array.begin() + begin, tri_face_array.begin() + end);
+				std::vector<double> param_coord(tri_param_coord.begin() + begin*6, tri_param_coord.begin() + end*6);
+				chart_grid_array[chart_id].Build(face_index_array, param_coord);
+			}
+
+		private:
+			const std::vector<int>& grid_chart_array;
+			const std::vector<int>& chart_tri_offset;
+			const std::vector<int>& tri_face_array;
+			const std::vector<double>& tri_param_coord;
+			std::vector<ChartTriangleGrid>& chart_grid_array;
+		};
+
+		class SurfaceLocateFunctor
+		{
+		public:
+			SurfaceLocateFunctor(const std::vector<ChartParamCoord>& _chart_param_coord_array, const std::vector<int>& _query_order,
+				const std::vector<ChartTriangleGrid>& _chart_grid_array, std::vector<SurfaceLocateResult>& _locate_result_array)
+				: chart_param_coord_array(_chart_param_coord_array), query_order(_query_order),
+				chart_grid_array(_chart_grid_array), locate_result_array(_locate_result_array) {}
+
+			void operator()(int k) const
+			{
+				int q = query_order[k];
+				const ChartParamCoord& chart_param_coord = chart_param_coord_array[q];
+				chart_grid_array[chart_param_coord.chart_id].Locate(chart_param_coord.param_coord, locate_result_array[q]);
+			}
+
+		private:
+			const std::vector<ChartParamCoord>& chart_param_coord_array;
+			const std::vector<int>& query_order;
+			const std::vector<ChartTriangleGrid>& chart_grid_array;
+			std::vector<SurfaceLocateResult>& locate_result_array;
+		};
+
+		class FaceSignFunctor
+		{
+		public:
+			FaceSignFunctor(const std::vector<double>& _face_param_coord, std::vector<int>& _face_sign)
+				: face_param_coord(_face_param_coord), face_sign(_face_sign) {}
+
+			void operator()(int fid) const
+			{
+				double area = ParamSignedArea(&face_param_coord[fid*6]);
+				face_sign[fid] = (fabs(area) < LARGE_ZERO_EPSILON) ? 0 : (area > 0 ? 1 : -1);
+			}
+
+		private:
+			const std::vector<double>& face_param_coord;
+			std::vector<int>& face_sign;
+		};
+
+		class FaceLocalDistortionFunctor
+		{
+		public:
+			FaceLocalDistortionFunctor(const std::vector<Coord2D>& _local_coord, const DoubleArray& _face_area,
+				const std::vector<double>& _face_param_coord, const std::vector<int>& _face_sign, 
+				std::vector<double>& _face_distortion)
+				: local_coord(_local_coord), face_area(_face_area), face_param_coord(_face_param_coord),
+				face_sign(_face_sign), face_distortion(_face_distortion) {}
+
+			void operator()(int fid) const
+			{
+				double jacobi_mat[4], s1, s2;
+				TriDistortion::ComputeParamJacobiMatrix(&local_coord[fid*3], 2*face_area[fid], 
+					&face_param_coord[fid*6], jacobi_mat);
+				TriDistortion::ComputeSingularValue(jacobi_mat, s1, s2);
+				face_distortion[fid] = fabs(face_sign[fid]*s1 - 1) + fabs(face_sign[fid]*s2 - 1);
+			}
+
+		private:
+			const std::vector<Coord2D>& local_coord;
+			const DoubleArray& face_area;
+			const std::vector<double>& face_param_coord;
+			const std::vector<int>& face_sign;
+			std::vector<double>& face_distortion;
+		};
+
+		//! distortion averaged over the edge adjacent faces, read from the face adjacency CSR.
+		//! boundary faces have fewer than 3 neighbors and are averaged over those they have
+		class StiffeningWeightFunctor
+		{
+		public:
+			StiffeningWeightFunctor(const IndexArray& _adj_offset, const IndexArray& _adj_index,
+				const std::vector<double>& _face_distortion, std::vector<double>& _stiffen_weight)
+				: adj_offset(_adj_offset), adj_index(_adj_index), face_distortion(_face_distortion), stiffen_weight(_stiffen_weight) {}
+
+			void operator()(int fid) const
+			{
+				double delta_d = 0.0;
+				for(int k=adj_offset[fid]; k<adj_offset[fid+1]; ++k)
+				{
+					delta_d += face_distortion[adj_index[k]];
+				}
+				int adj_num = adj_offset[fid+1] - adj_offset[fid];
+				if(adj_num > 0) delta_d /= adj_num;
+
+				stiffen_weight[fid] += std::min(delta_d, 15.0);
+			}
+
+		private:
+			const IndexArray& adj_offset;
+			const IndexArray& adj_index;
+			const std::vector<double>& face_distortion;
+			std::vector<double>& stiffen_weight;
+		};
+
+		//! ring 0 is the flipped set, rings 1 to 3 are eased towards a decreasing weight, the rest reset to 1
+		class RingStiffeningFunctor
+		{
+		public:
+			RingStiffeningFunctor(const std::vector<int>& _ring_dist, const std::vector<bool>& _flipped_face,
+				std::vector<double>& _stiffen_weight)
+				: ring_dist(_ring_dist), flipped_face(_flipped_face), stiffen_weight(_stiffen_weight) {}
+
+			void operator()(int fid) const
+			{
+				static const double ring_weight[4] = {20000, 2000, 200, 20};
+
+				int dist = ring_dist[fid];
+				if(dist == 0 || (dist > 0 && !flipped_face[fid]))
+				{
+					stiffen_weight[fid] = (stiffen_weight[fid] + ring_weight[dist]) / 2;
+				}else{
+					stiffen_weight[fid] = 1.0;
+				}
+			}
+
+		private:
+			const std::vector<int>& ring_dist;
+			const std::vector<bool>& flipped_face;
+			std::vector<double>& stiffen_weight;
+		};
+	}
+
+	Parameter::Parameter(boost::shared_ptr<MeshModel> _p_mesh) : p_mesh(_p_mesh), m_chart_parallel_solve(true), 
+		p_solve_monitor(NULL){}
 	Parameter::~Parameter(){}
 
 	bool Parameter::LoadPatchFile(const std::string& file_name)
 	{
 		p_chart_creator = boost::shared_ptr<ChartCreator> ( new ChartCreator(p_mesh));
-		p_chart_creator->LoadPatchFile(file_name);
+		if(!p_chart_creator->LoadPatchFile(file_name))
+		{
+			p_chart_creator.reset();
+			return false;
+		}
 		if(!p_chart_creator->FormParamCharts())
 		{
 			std::cout<<"Error: Cannot compute parameteriztion!\n";
@@ -52,15 +305,19 @@ namespace PARAM
 			return false;
 		}		
 
+		unsigned long long cache_key = ComputeResultCacheKey();
+		if(LoadResultCache(cache_key))
+		{
+			ReportSolveProgress(SOLVE_STAGE_FINISH, 0, 0);
+			return true;
+		}
+
+		ReportSolveProgress(SOLVE_STAGE_SETUP, 0, 0);
 		SetInitFaceChartLayout();
 		SetInitVertChartLayout();        
 
 
-		CMeshSparseMatrix lap_mat;
-		SetLapMatrixCoef(p_mesh, lap_mat);		
-
-		CMeshSparseMatrix lap_mat_with_mean_value;
-		SetLapMatrixCoefWithMeanValueCoord(p_mesh, lap_mat_with_mean_value);
+		const CMeshSparseMatrix& lap_mat_with_mean_value = p_mesh->m_OperatorCache.GetMeanValueLaplacian();
 
 		size_t face_num = (size_t)p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 		m_stiffen_weight.clear();
@@ -69,9 +326,17 @@ namespace PARAM
 		m_flippd_face.clear();
 		m_flippd_face.resize(face_num, false);
 
-		int loop_num = 6;
+		p_schur_solver.reset();
+		if(m_chart_parallel_solve) p_schur_solver = boost::shared_ptr<SchurSolver>(new SchurSolver());
+
+		std::vector<int> prev_vert_chart_array;
+		std::vector<ParamCoord> prev_vert_param_coord_array;
+
+		int loop_num = PARAM_SOLVE_LOOP_NUM;
 		for(int k=0; k<loop_num; ++k)
 		{						
+			if(IsSolveCanceled()) return false;
+
 			CMeshSparseMatrix lap_mat_with_stiffen;
 //			SetLapMatrixWithStiffeningWeight(lap_mat_with_stiffen);
 
@@ -81,10 +346,19 @@ namespace PARAM
 //			SolveParameter(lap_mat_with_stiffen);
 //			SolveParameter(lap_mat_with_mean_value);
 			SolveParameter(lap_mat_with_mean_value);
+
+			double residual = ComputeParamCoordChange(prev_vert_chart_array, prev_vert_param_coord_array);
+			prev_vert_chart_array = m_vert_chart_array;
+			prev_vert_param_coord_array = m_vert_param_coord_array;
+			ReportSolveProgress(SOLVE_STAGE_SOLVE, k, residual);
+			PublishSolveSnapshot();
+			if(IsSolveCanceled()) return false;
+
 			if(k < loop_num)
 			{
                 GetOutRangeVertices(m_out_range_vert_array);
 				AdjustPatchBoundary();
+				if(IsSolveCanceled()) return false;
 				ConnerRelocating();
 // 				LocalStiffening();		
 // 				CheckFlipedTriangle();
@@ -95,6 +369,7 @@ namespace PARAM
 
 		GetOutRangeVertices(m_out_range_vert_array);
 		AdjustPatchBoundary();
+		if(IsSolveCanceled()) return false;
 //		VertexRelalaxation();
         GetOutRangeVertices(m_out_range_vert_array);
         
@@ -108,9 +383,335 @@ namespace PARAM
 // 
  		CheckFlipedTriangle();
 
+		SaveResultCache(cache_key);
+
+		ReportSolveProgress(SOLVE_STAGE_FINISH, loop_num, 0);
+		return true;
+	}
+
+	void Parameter::UpdateMeshColor()
+	{
+		SetMeshChartColor();
+		SetMeshDistortionColor();
+	}
+
+	bool Parameter::IsSolveCanceled() const
+	{
+		return p_solve_monitor != NULL && p_solve_monitor->IsCanceled();
+	}
+
+	void Parameter::ReportSolveProgress(int stage, int iteration, double residual) const
+	{
+		if(p_solve_monitor) p_solve_monitor->ReportProgress(stage, iteration, residual);
+	}
+
+	void Parameter::PublishSolveSnapshot() const
+	{
+		if(p_solve_monitor == NULL) return;
+		std::vector<double>* face_param_coord = p_solve_monitor->GetSnapshotBuffer();
+		if(face_param_coord == NULL) return;
+		GatherFaceParamCoord(*face_param_coord);
+		p_solve_monitor->PublishSnapshot();
+	}
+
+	bool Parameter::UpdateParamCoord(const std::vector<int>& edited_patch_array, int halo_ring /* = 3 */)
+	{
+		if(p_mesh == NULL || p_chart_creator == NULL) return false;
+
+		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
+		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
+		if((int) m_vert_param_coord_array.size() != vert_num || (int) m_face_chart_array.size() != face_num)
+		{
+			//! nothing solved yet, so nothing to hold fixed
+			return ComputeParamCoord();
+		}
+
+		const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
+		for(size_t k=0; k<edited_patch_array.size(); ++k)
+		{
+			if(edited_patch_array[k] < 0 || edited_patch_array[k] >= (int) patch_array.size())
+			{
+				std::cerr << "Error : edited patch " << edited_patch_array[k] << " is out of range!" << std::endl;
+				return false;
+			}
+		}
+
+		ReportSolveProgress(SOLVE_STAGE_SETUP, 0, 0);
+
+		/// the edited patches' faces go back to their own charts, and their vertices are voted again
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		std::vector<bool> is_region_vert(vert_num, false);
+		std::vector<int> region_vert_array;
+		for(size_t k=0; k<edited_patch_array.size(); ++k)
+		{
+			int patch_id = edited_patch_array[k];
+			const std::vector<int>& faces_in_patch = patch_array[patch_id].m_face_index_array;
+			for(size_t i=0; i<faces_in_patch.size(); ++i)
+			{
+				int fid = faces_in_patch[i];
+				m_face_chart_array[fid] = m_face_patch_array[fid] = patch_id;
+				const int* face = face_info.GetFaceVertices(fid);
+				for(size_t j=0; j<face_info.GetFaceDegree(fid); ++j)
+				{
+					if(is_region_vert[face[j]]) continue;
+					is_region_vert[face[j]] = true;
+					region_vert_array.push_back(face[j]);
+				}
+			}
+		}
+		for(size_t k=0; k<region_vert_array.size(); ++k)
+		{
+			int vid = region_vert_array[k];
+			m_vert_chart_array[vid] = m_vert_patch_array[vid] = FindMajorityFaceChart(vid);
+		}
+
+		/// and a halo of rings around them, the vertices past it keep their coordinates
+		const PolyIndexArray& vert_adjvertices_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjVertices();
+		size_t ring_begin = 0;
+		for(int r=0; r<halo_ring; ++r)
+		{
+			size_t ring_end = region_vert_array.size();
+			for(size_t k=ring_begin; k<ring_end; ++k)
+			{
+				const IndexArray& adj_vertices = vert_adjvertices_array[region_vert_array[k]];
+				for(size_t i=0; i<adj_vertices.size(); ++i)
+				{
+					if(is_region_vert[adj_vertices[i]]) continue;
+					is_region_vert[adj_vertices[i]] = true;
+					region_vert_array.push_back(adj_vertices[i]);
+				}
+			}
+			ring_begin = ring_end;
+		}
+
+		std::vector<int> vari_index_mapping;
+		SetVariIndexMapping(vari_index_mapping);
+		int vari_num = 0;
+		for(int vid=0; vid<vert_num; ++vid)
+		{
+			if(vari_index_mapping[vid] != -1 && is_region_vert[vid]) vari_index_mapping[vid] = vari_num++;
+			else vari_index_mapping[vid] = -1;
+		}
+		std::cout << "Update parameterization: " << region_vert_array.size() << " vertices in the region" << std::endl;
+
+		SetBoundaryVertexParamValue();
+
+		const CMeshSparseMatrix& lap_mat_with_mean_value = p_mesh->m_OperatorCache.GetMeanValueLaplacian();
+
+		std::vector<int> prev_vert_chart_array = m_vert_chart_array;
+		std::vector<ParamCoord> prev_vert_param_coord_array = m_vert_param_coord_array;
+
+		//! the conners stay where the edit put them, so there is no ConnerRelocating here
+		int loop_num = PARAM_UPDATE_LOOP_NUM;
+		for(int k=0; k<loop_num; ++k)
+		{
+			if(IsSolveCanceled()) return false;
+
+			SolveParameter(lap_mat_with_mean_value, vari_index_mapping, vari_num);
+
+			double residual = ComputeParamCoordChange(prev_vert_chart_array, prev_vert_param_coord_array);
+			prev_vert_chart_array = m_vert_chart_array;
+			prev_vert_param_coord_array = m_vert_param_coord_array;
+			ReportSolveProgress(SOLVE_STAGE_SOLVE, k, residual);
+			PublishSolveSnapshot();
+			if(IsSolveCanceled()) return false;
+
+			GetOutRangeVertices(m_out_range_vert_array);
+			AdjustPatchBoundary();
+		}
+		if(IsSolveCanceled()) return false;
+		GetOutRangeVertices(m_out_range_vert_array);
+
+		m_unset_layout_face_array.clear();
+		ResetFaceChartLayout();
+		SetChartVerticesArray();
+		ComputeDistortion();
+		CheckFlipedTriangle();
+
+		//! not cached, the key of the edited layout belongs to its full solve
+
+		ReportSolveProgress(SOLVE_STAGE_FINISH, loop_num, 0);
+		return true;
+	}
+	void Parameter::SaveEditState(ParamEditState& state) const
+	{
+		if(p_chart_creator == NULL) return;
+		state.patch_conner_array = p_chart_creator->GetPatchConnerArray();
+		state.patch_edge_array = p_chart_creator->GetPatchEdgeArray();
+		state.patch_array = p_chart_creator->GetPatchArray();
+
+		state.vert_chart_array = m_vert_chart_array;
+		state.face_chart_array = m_face_chart_array;
+		state.vert_patch_array = m_vert_patch_array;
+		state.face_patch_array = m_face_patch_array;
+		state.vert_param_coord_array = m_vert_param_coord_array;
+		state.chart_vertices_array = m_chart_vertices_array;
+
+		state.out_range_vert_array = m_out_range_vert_array;
+		state.unset_layout_face_array = m_unset_layout_face_array;
+		state.fliped_face_array = m_fliped_face_array;
+		state.face_harmonic_distortion = m_face_harmonic_distortion;
+		state.face_isometric_distortion = m_face_isometric_distortion;
+	}
+
+	void Parameter::RestoreEditState(const ParamEditState& state)
+	{
+		if(p_chart_creator == NULL) return;
+		p_chart_creator->RestoreEditedLayout(state.patch_conner_array, state.patch_edge_array, state.patch_array);
+
+		m_vert_chart_array = state.vert_chart_array;
+		m_face_chart_array = state.face_chart_array;
+		m_vert_patch_array = state.vert_patch_array;
+		m_face_patch_array = state.face_patch_array;
+		m_vert_param_coord_array = state.vert_param_coord_array;
+		m_chart_vertices_array = state.chart_vertices_array;
+
+		m_out_range_vert_array = state.out_range_vert_array;
+		m_unset_layout_face_array = state.unset_layout_face_array;
+		m_fliped_face_array = state.fliped_face_array;
+		m_face_harmonic_distortion = state.face_harmonic_distortion;
+		m_face_isometric_distortion = state.face_isometric_distortion;
+	}
+
+	double Parameter::ComputeParamCoordChange(const std::vector<int>& prev_vert_chart_array,
+		const std::vector<ParamCoord>& prev_vert_param_coord_array) const
+	{
+		if(prev_vert_param_coord_array.size() != m_vert_param_coord_array.size()) return 0;
+
+		double sum = 0;
+		int num = 0;
+		for(size_t vid=0; vid<m_vert_param_coord_array.size(); ++vid)
+		{
+			if(prev_vert_chart_array[vid] != m_vert_chart_array[vid]) continue;
+			double ds = m_vert_param_coord_array[vid].s_coord - prev_vert_param_coord_array[vid].s_coord;
+			double dt = m_vert_param_coord_array[vid].t_coord - prev_vert_param_coord_array[vid].t_coord;
+			sum += ds*ds + dt*dt;
+			++num;
+		}
+		return num == 0 ? 0 : sqrt(sum / num);
+	}
+
+	unsigned long long Parameter::ComputeResultCacheKey() const
+	{
+		ResultHasher hasher;
+
+		//! mesh geometry
+		const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		hasher.Add((int) vert_coord_array.size());
+		for(size_t vid=0; vid<vert_coord_array.size(); ++vid)
+		{
+			for(int k=0; k<3; ++k) hasher.Add(vert_coord_array[vid][k]);
+		}
+		hasher.Add((int) face_info.GetFaceNum());
+		for(size_t fid=0; fid<face_info.GetFaceNum(); ++fid)
+		{
+			int degree = face_info.GetFaceDegree(fid);
+			hasher.Add(degree);
+			hasher.Add(face_info.GetFaceVertices(fid), degree*sizeof(int));
+		}
+
+		//! patch layout, as loaded and optimized
+		const std::vector<PatchConner>& conner_array = p_chart_creator->GetPatchConnerArray();
+		const std::vector<PatchEdge>& edge_array = p_chart_creator->GetPatchEdgeArray();
+		const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
+		hasher.Add((int) conner_array.size());
+		for(size_t k=0; k<conner_array.size(); ++k) hasher.Add(conner_array[k].m_mesh_index);
+		hasher.Add((int) edge_array.size());
+		for(size_t k=0; k<edge_array.size(); ++k)
+		{
+			hasher.Add(edge_array[k].m_conner_pair_index.first);
+			hasher.Add(edge_array[k].m_conner_pair_index.second);
+			hasher.AddArray(edge_array[k].m_mesh_path);
+		}
+		hasher.Add((int) patch_array.size());
+		for(size_t k=0; k<patch_array.size(); ++k)
+		{
+			hasher.AddArray(patch_array[k].m_conner_index_array);
+			hasher.AddArray(patch_array[k].m_edge_index_array);
+			hasher.AddArray(patch_array[k].m_face_index_array);
+		}
+
+		//! solver settings, the chart parallel solve goes through the schur
+		//! solver and rounds differently from the direct one
+		hasher.Add(m_chart_parallel_solve);
+		hasher.Add(PARAM_SOLVE_LOOP_NUM);
+		hasher.Add(LARGE_ZERO_EPSILON);
+		hasher.Add(SMALL_ZERO_EPSILON);
+
+		return hasher.GetValue();
+	}
+
+	bool Parameter::LoadResultCache(unsigned long long key)
+	{
+		if(m_result_cache_dir.empty()) return false;
+
+		ParamResult result;
+		if(!ParamResultCache(m_result_cache_dir).Load(key, result)) return false;
+
+		size_t vert_num = (size_t) p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
+		size_t face_num = (size_t) p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
+		int chart_num = (int) p_chart_creator->GetChartArray().size();
+		std::vector<PatchConner>& conner_array = p_chart_creator->GetPatchConnerArray();
+		if(result.m_vert_chart_array.size() != vert_num || result.m_face_chart_array.size() != face_num
+			|| result.m_conner_mesh_index_array.size() != conner_array.size()
+			|| !IsIndexArrayInRange(result.m_vert_chart_array, chart_num)
+			|| !IsIndexArrayInRange(result.m_face_chart_array, chart_num)
+			|| !IsIndexArrayInRange(result.m_conner_mesh_index_array, (int) vert_num)
+			|| !IsIndexArrayInRange(result.m_fliped_face_array, (int) face_num))
+		{
+			std::cerr << "Warning : cached parameterization does not fit the input, solve again." << std::endl;
+			return false;
+		}
+
+		SetInitFaceChartLayout();
+		SetInitVertChartLayout();
+
+		m_vert_chart_array = result.m_vert_chart_array;
+		m_face_chart_array = result.m_face_chart_array;
+		m_vert_param_coord_array = result.m_vert_param_coord_array;
+		m_face_harmonic_distortion = result.m_face_harmonic_distortion;
+		m_face_isometric_distortion = result.m_face_isometric_distortion;
+		m_fliped_face_array = result.m_fliped_face_array;
+		for(size_t k=0; k<conner_array.size(); ++k)
+		{
+			conner_array[k].m_mesh_index = result.m_conner_mesh_index_array[k];
+		}
+
+		m_stiffen_weight.clear(); m_stiffen_weight.resize(face_num, 1.0);
+		m_flippd_face.clear(); m_flippd_face.resize(face_num, false);
+		m_unset_layout_face_array.clear();
+
+		GetOutRangeVertices(m_out_range_vert_array);
+		SetChartVerticesArray();
+
+		std::cout << "Load parameterization from " << ParamResultCache(m_result_cache_dir).GetCacheFileName(key) << std::endl;
+		if(p_solve_monitor == NULL) SetMeshDistortionColor();
 		return true;
 	}
 
+	void Parameter::SaveResultCache(unsigned long long key) const
+	{
+		if(m_result_cache_dir.empty()) return;
+
+		ParamResult result;
+		result.m_vert_chart_array = m_vert_chart_array;
+		result.m_vert_param_coord_array = m_vert_param_coord_array;
+		result.m_face_chart_array = m_face_chart_array;
+		result.m_face_harmonic_distortion = m_face_harmonic_distortion;
+		result.m_face_isometric_distortion = m_face_isometric_distortion;
+		result.m_fliped_face_array = m_fliped_face_array;
+
+		const std::vector<PatchConner>& conner_array = p_chart_creator->GetPatchConnerArray();
+		result.m_conner_mesh_index_array.resize(conner_array.size());
+		for(size_t k=0; k<conner_array.size(); ++k)
+		{
+			result.m_conner_mesh_index_array[k] = conner_array[k].m_mesh_index;
+		}
+
+		ParamResultCache(m_result_cache_dir).Save(key, result);
+	}
+
 	void Parameter::FixAdjustedVertex(bool with_conner /* = false */)
 	{
 		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
@@ -304,27 +905,29 @@ namespace PARAM
 		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
 		m_vert_chart_array.clear(); m_vert_chart_array.resize(vert_num);
 
-		const PolyIndexArray& adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-
 		for(int vid = 0; vid < vert_num; ++vid)
 		{
-			const IndexArray& adj_faces = adj_face_array[vid];
-			std::map<int, int> chart_count_num;
-			for(size_t i=0; i<adj_faces.size(); ++i)
-			{
-				int face_chart_id = m_face_chart_array[adj_faces[i]];
-				chart_count_num[face_chart_id] ++;
-			}
-			int chart_id(-1), max_num(-1);
-			for(std::map<int, int>::const_iterator im = chart_count_num.begin(); im != chart_count_num.end(); ++im)
-			{
-				if(im->second > max_num) { max_num = im->second; chart_id = im->first; }
-			}
-			m_vert_chart_array[vid] = chart_id;
+			m_vert_chart_array[vid] = FindMajorityFaceChart(vid);
 		}			  		
 
         m_vert_patch_array = m_vert_chart_array;
 	}
+	int Parameter::FindMajorityFaceChart(int vid) const
+	{
+		const IndexArray& adj_faces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces()[vid];
+		std::map<int, int> chart_count_num;
+		for(size_t i=0; i<adj_faces.size(); ++i)
+		{
+			int face_chart_id = m_face_chart_array[adj_faces[i]];
+			chart_count_num[face_chart_id] ++;
+		}
+		int chart_id(-1), max_num(-1);
+		for(std::map<int, int>::const_iterator im = chart_count_num.begin(); im != chart_count_num.end(); ++im)
+		{
+			if(im->second > max_num) { max_num = im->second; chart_id = im->first; }
+		}
+		return chart_id;
+	}
    
 	void Parameter::SetBoundaryVertexParamValue(LinearSolver* p_linear_solver /* = NULL */)
 	{
@@ -429,16 +1032,34 @@ namespace PARAM
 		m_vert_param_coord_array.resize(vert_num);
         
 		vector<int> vari_index_mapping;
-		int vari_num = SetVariIndexMapping(vari_index_mapping);
-		vari_num *=2;
-		
+		int vari_vert_num = SetVariIndexMapping(vari_index_mapping);
+
+		SetBoundaryVertexParamValue();
+
+		SolveParameter(lap_mat, vari_index_mapping, vari_vert_num);
+	}
+	void Parameter::SolveParameter(const CMeshSparseMatrix& lap_mat, 
+		const std::vector<int>& vari_index_mapping, int vari_vert_num)
+	{
+		int vert_num = p_mesh->m_Kernel.GetModelInfo().GetVertexNum();
+		int vari_num = vari_vert_num*2;
 				
 		std::cout << "Begin solve parameterization: variable num "<< vari_num << std::endl;
 
 		LinearSolver linear_solver(vari_num);
 
-		SetBoundaryVertexParamValue();
-	 
+		if(p_schur_solver)
+		{
+			//! each chart is a domain, both coordinates of a vertex go to its chart
+			std::vector<int> vari_domain_array(vari_num, -1);
+			for(int vid = 0; vid < vert_num; ++vid)
+			{
+				int vari_index = vari_index_mapping[vid];
+				if(vari_index == -1) continue;
+				vari_domain_array[vari_index*2] = vari_domain_array[vari_index*2+1] = m_vert_chart_array[vid];
+			}
+			linear_solver.set_domain_solver(p_schur_solver.get(), vari_domain_array);
+		}
 		
 		linear_solver.begin_equation();
 		for(int vid = 0; vid < vert_num; ++vid)
@@ -550,13 +1171,6 @@ namespace PARAM
 			}
 		}
 
-        ofstream fout ("parame.txt");
-        for(size_t k=0; k<m_vert_param_coord_array.size(); ++k){
-            fout <<  m_vert_param_coord_array[k].s_coord << ' ' <<
-                m_vert_param_coord_array[k].t_coord << std::endl;
-        }
-        fout.close();
-
 	}
 
 	int Parameter::SetVariIndexMapping(std::vector<int>& vari_index_mapping)
@@ -592,6 +1206,7 @@ namespace PARAM
 		const PolyIndexArray& vert_adjvertices_array =p_mesh->m_Kernel.GetVertexInfo().GetAdjVertices();
 
 		bool swap_able = false, tag=false;
+		int round = 0;
 		do{
 			swap_able = false;
 			int adjust_num(0);
@@ -665,9 +1280,9 @@ namespace PARAM
 				}
 			}
 			std::cout << "Adjust " << adjust_num << "vertices." << std::endl;
+			ReportSolveProgress(SOLVE_STAGE_ADJUST, round++, adjust_num);
 			
-			
-		}while(swap_able);
+		}while(swap_able && !IsSolveCanceled());
 
 		std::vector<int> out_range_vertices;
 		GetOutRangeVertices(out_range_vertices);
@@ -721,27 +1336,24 @@ namespace PARAM
 		ParamCoord init_param_coord = m_vert_param_coord_array[out_range_vert];
 
 		const std::vector<ParamChart>& param_chart_array = p_chart_creator->GetChartArray();
-		const std::vector<ParamPatch>& param_patch_array = p_chart_creator->GetPatchArray();
+		const ChartGraph& chart_graph = p_chart_creator->GetChartGraph();
 
 		int valid_chart_id(-1);
 		ParamCoord valid_param_coord;
 
-		std::set<int> visited_chart;
-
-		int steps=0;
-		std::queue<int> q;
-		q.push(init_chart_id); 
-		q.push(steps);
-		visited_chart.insert(init_chart_id);
-
 		double min_out_range_error = numeric_limits<double>::infinity();
 		int min_error_valid_chart_id(-1);
 		ParamCoord min_error_valid_param_coord;
 
-		while(!q.empty())
+		/// the charts within max_ringe_num rings in breadth first order, then the first chart of the next ring
+		const int *ring_begin, *ring_end, *next_ring_end;
+		chart_graph.GetRing(init_chart_id, max_ringe_num, ring_begin, ring_end);
+		chart_graph.GetRing(init_chart_id, max_ringe_num + 1, ring_begin, next_ring_end);
+		if(next_ring_end > ring_end) ++ ring_end;
+
+		for(const int* iter = ring_begin; iter != ring_end; ++iter)
 		{
-			int cur_chart_id = q.front(); q.pop();
-			steps = q.front(); q.pop();
+			int cur_chart_id = *iter;
 
 			ParamCoord cur_param_coord;
 			TransParamCoordBetweenCharts(init_chart_id, cur_chart_id, 
@@ -766,23 +1378,6 @@ namespace PARAM
 					min_error_valid_chart_id = cur_chart_id;
 				}
 			}
-
-			if(steps > max_ringe_num) break;
-
-			const ParamPatch& cur_param_patch = param_patch_array[cur_chart_id];
-			const std::vector<int>& chart_neighbor = cur_param_patch.m_nb_patch_index_array;
-
-			for(size_t k=0; k<chart_neighbor.size(); ++k)
-			{
-				int nb_chart_id = chart_neighbor[k];
-				if(visited_chart.find(nb_chart_id) == visited_chart.end())
-				{
-					q.push(nb_chart_id);
-					q.push(steps+1);
-					visited_chart.insert(nb_chart_id);
-				}
-			}
-
 		}
 
 		if(valid_chart_id != -1)
@@ -815,23 +1410,54 @@ namespace PARAM
 
 	void Parameter::TransParamCoordBetweenCharts(int from_chart_id, int to_chart_id, int vid, 
 		const ParamCoord& from_param_coord, ParamCoord& to_param_coord) const
+	{
+		zjucad::matrix::matrix<double> tran_mat = GetVertTransMatrix(from_chart_id, to_chart_id, vid);
+
+		to_param_coord.s_coord = tran_mat(0, 0)*from_param_coord.s_coord + 
+			tran_mat(0, 1)*from_param_coord.t_coord + tran_mat(0, 2);
+		to_param_coord.t_coord = tran_mat(1, 0)*from_param_coord.s_coord +
+			tran_mat(1, 1)*from_param_coord.t_coord + tran_mat(1, 2);
+	}
+
+	zjucad::matrix::matrix<double> Parameter::GetVertTransMatrix(int from_chart_id, int to_chart_id, int vid) const
 	{
 		TransFunctor tran_functor(p_chart_creator);
-		
-		bool is_ambiguity = IsAmbiguityChartPair(from_chart_id, to_chart_id);
-		
-		if(is_ambiguity) {
-			tran_functor.TransParamCoordBetweenAmbiguityCharts(
-			vid, from_chart_id, to_chart_id, from_param_coord, to_param_coord);
+		if(IsAmbiguityChartPair(from_chart_id, to_chart_id)) {
+			return tran_functor.GetTransMatrixBetweenAmbiguityCharts(vid, from_chart_id, -1, to_chart_id);
 		}else{
-			zjucad::matrix::matrix<double> tran_mat = 
-				tran_functor.GetTransMatrix(from_chart_id, to_chart_id, vid);
+			return tran_functor.GetTransMatrix(from_chart_id, to_chart_id, vid);
+		}
+	}
+
+	void Parameter::GatherFaceParamCoord(std::vector<double>& face_param_coord) const
+	{
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		int face_num = (int) face_info.GetFaceNum();
+		long long chart_num = (long long) p_chart_creator->GetPatchArray().size();
 
-			to_param_coord.s_coord = tran_mat(0, 0)*from_param_coord.s_coord + 
-				tran_mat(0, 1)*from_param_coord.t_coord + tran_mat(0, 2);
-			to_param_coord.t_coord = tran_mat(1, 0)*from_param_coord.s_coord +
-				tran_mat(1, 1)*from_param_coord.t_coord + tran_mat(1, 2);
+		/// collect the (vertex, face chart) pairs which need a transition
+		std::vector<long long> trans_key_array;
+		for(int fid=0; fid<face_num; ++fid)
+		{
+			const int* face = face_info.GetFaceVertices(fid);
+			int face_chart_id = m_face_chart_array[fid];
+			for(int i=0; i<3; ++i)
+			{
+				int vid = face[i];
+				if(m_vert_chart_array[vid] != face_chart_id) trans_key_array.push_back(vid*chart_num + face_chart_id);
+			}
 		}
+		std::sort(trans_key_array.begin(), trans_key_array.end());
+		trans_key_array.erase(std::unique(trans_key_array.begin(), trans_key_array.end()), trans_key_array.end());
+
+		/// each transition is computed once for current chart layout, the chart searches only read the layout
+		std::vector<double> trans_mat_array(trans_key_array.size()*6);
+		parallel_for(0, (int) trans_key_array.size(), VertTransMatrixFunctor(*this, m_vert_chart_array,
+			trans_key_array, chart_num, trans_mat_array));
+
+		face_param_coord.resize(face_num*6);
+		parallel_for(0, face_num, FaceParamCoordGatherFunctor(face_info, m_face_chart_array, m_vert_chart_array,
+			m_vert_param_coord_array, trans_key_array, trans_mat_array, chart_num, face_param_coord));
 	}
 
 	zjucad::matrix::matrix<double> Parameter::GetTransMatrix(int from_vid, int to_vid, int from_chart_id, int to_chart_id) const
@@ -884,12 +1510,12 @@ namespace PARAM
 	{
 		const std::vector<ParamChart>& param_chart_array = p_chart_creator->GetChartArray();
 
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
-		size_t face_num = face_list_array.size();
+		size_t face_num = face_info.GetFaceNum();
 		for (size_t i = 0; i < face_num; ++i)
 		{
-			const IndexArray& faces= face_list_array[i];
+			const int* faces = face_info.GetFaceVertices(i);
 			std::vector<int> chart_id_vec;
 			for (size_t j = 0; j < 3; j++)
 			{
@@ -962,12 +1588,13 @@ namespace PARAM
 
 		//std::cout << "There are " << m_unset_layout_face_array.size() << "unset faces." << std::endl;
 
-		ofstream fout("unset_face.txt");
-		for(size_t k=0; k<m_unset_layout_face_array.size(); ++k)
-		{
-			fout << m_unset_layout_face_array[k] << " ";
-		}
-		fout << std::endl;
+		//! with a monitor the solving thread leaves the mesh alone, see UpdateMeshColor
+		if(p_solve_monitor == NULL) SetMeshChartColor();
+	}
+
+	void Parameter::SetMeshChartColor()
+	{
+		size_t face_num = m_face_chart_array.size();
 
 		int colors[48][3] = 
 		{
@@ -997,23 +1624,23 @@ namespace PARAM
 			int index = m_face_chart_array[i] % 48;
 			colorArray[i] = Color(colors[index][0], colors[index][1], colors[index][2]);
 		}
-
+		p_mesh->m_Render.Invalidate(RENDER_BUFFER_COLOR);
 	}
 
 	void Parameter::SetMeshFaceTextureCoord()
 	{
 		PolyTexCoordArray& face_texcoord_array = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
-		size_t face_num = face_list_array.size();
+		size_t face_num = face_info.GetFaceNum();
 		face_texcoord_array.clear(); face_texcoord_array.resize(face_num);
 
-		for(size_t fid = 0; fid < face_list_array.size(); ++fid)
+		for(size_t fid = 0; fid < face_info.GetFaceNum(); ++fid)
 		{
 			TexCoordArray& face_tex = face_texcoord_array[fid];
 			face_tex.clear(); face_tex.resize(3);
 
-			const IndexArray& faces = face_list_array[fid];			
+			const int* faces = face_info.GetFaceVertices(fid);			
 			int face_chart_id = m_face_chart_array[fid];
            // 		face_chart_id = FindBestChartIDForTriShape(fid);
 
@@ -1072,6 +1699,7 @@ namespace PARAM
 
 			vtx_color_array[vid] = Color(colors[chart_id%56][0], colors[chart_id%56][1], colors[chart_id%56][2]);
 		}
+		p_mesh->m_Render.Invalidate(RENDER_BUFFER_COLOR);
 		
 	}
 
@@ -1103,8 +1731,8 @@ namespace PARAM
 
 	int Parameter::FindBestChartIDForTriShape(int fid) const
 	{
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& faces = face_list_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* faces = face_info.GetFaceVertices(fid);
 
 		int c_0 = m_vert_chart_array[faces[0]];
 		int c_1 = m_vert_chart_array[faces[1]];
@@ -1202,7 +1830,7 @@ namespace PARAM
 		ParamCoord origin_param_coord = chart_param_coord.param_coord;
 
 		const PolyIndexArray& vert_adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		const std::vector<int>& vertics_array = m_chart_vertices_array[chart_id];
 		
@@ -1221,7 +1849,7 @@ namespace PARAM
 				if(!face_visited_flag[fid])
 				{
 					std::vector<ParamCoord> vert_param_coord(3);
-					const IndexArray& faces = face_list_array[fid];
+					const int* faces = face_info.GetFaceVertices(fid);
 					for(size_t j=0; j<3; ++j)
 					{
 						vert_param_coord[j] = m_vert_param_coord_array[faces[j]];
@@ -1251,23 +1879,130 @@ namespace PARAM
 		return false;
 	}
 
+	void Parameter::FindCorrespondingOnSurface(const std::vector<ChartParamCoord>& chart_param_coord_array, 
+		std::vector<SurfaceLocateResult>& locate_result_array) const
+	{
+		int query_num = (int) chart_param_coord_array.size();
+		int chart_num = (int) m_chart_vertices_array.size();
+		locate_result_array.assign(query_num, SurfaceLocateResult());
+
+		/// group the queries by chart, queries with an invalid chart id stay LOCATE_FAILED
+		std::vector<int> chart_query_offset(chart_num + 1, 0);
+		for(int q=0; q<query_num; ++q)
+		{
+			int chart_id = chart_param_coord_array[q].chart_id;
+			if(chart_id >= 0 && chart_id < chart_num) ++chart_query_offset[chart_id + 1];
+		}
+		for(int c=0; c<chart_num; ++c) chart_query_offset[c+1] += chart_query_offset[c];
+		std::vector<int> query_order(chart_query_offset[chart_num]);
+		std::vector<int> fill_pos(chart_query_offset.begin(), chart_query_offset.end() - 1);
+		for(int q=0; q<query_num; ++q)
+		{
+			int chart_id = chart_param_coord_array[q].chart_id;
+			if(chart_id >= 0 && chart_id < chart_num) query_order[fill_pos[chart_id]++] = q;
+		}
+
+		/// the triangles of a chart are the faces around its vertices, as in FindCorrespondingInChart
+		const PolyIndexArray& vert_adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+
+		std::vector<int> grid_chart_array;
+		std::vector<int> chart_tri_offset(1, 0);
+		std::vector<int> tri_face_array;
+		for(int c=0; c<chart_num; ++c)
+		{
+			if(chart_query_offset[c] == chart_query_offset[c+1]) continue;
+			const std::vector<int>& vertices_array = m_chart_vertices_array[c];
+			size_t first = tri_face_array.size();
+			for(size_t k=0; k<vertices_array.size(); ++k)
+			{
+				const IndexArray& adj_face_array = vert_adj_face_array[vertices_array[k]];
+				tri_face_array.insert(tri_face_array.end(), adj_face_array.begin(), adj_face_array.end());
+			}
+			std::sort(tri_face_array.begin() + first, tri_face_array.end());
+			tri_face_array.erase(std::unique(tri_face_array.begin() + first, tri_face_array.end()), tri_face_array.end());
+
+			grid_chart_array.push_back(c);
+			chart_tri_offset.push_back((int) tri_face_array.size());
+		}
+
+		/// each (vertex, chart) transition is computed once
+		long long chart_num_ll = chart_num;
+		std::vector<long long> trans_key_array;
+		for(size_t k=0; k<grid_chart_array.size(); ++k)
+		{
+			int chart_id = grid_chart_array[k];
+			for(int i=chart_tri_offset[k]; i<chart_tri_offset[k+1]; ++i)
+			{
+				const int* face = face_info.GetFaceVertices(tri_face_array[i]);
+				for(int j=0; j<3; ++j)
+				{
+					if(m_vert_chart_array[face[j]] != chart_id) trans_key_array.push_back(face[j]*chart_num_ll + chart_id);
+				}
+			}
+		}
+		std::sort(trans_key_array.begin(), trans_key_array.end());
+		trans_key_array.erase(std::unique(trans_key_array.begin(), trans_key_array.end()), trans_key_array.end());
+
+		std::vector<double> trans_mat_array(trans_key_array.size()*6);
+		parallel_for(0, (int) trans_key_array.size(), VertTransMatrixFunctor(*this, m_vert_chart_array, 
+			trans_key_array, chart_num_ll, trans_mat_array));
+
+		std::vector<ParamCoord> trans_param_coord_array(trans_key_array.size());
+		for(size_t k=0; k<trans_key_array.size(); ++k)
+		{
+			const ParamCoord& from_param_coord = m_vert_param_coord_array[trans_key_array[k] / chart_num_ll];
+			const double* m = &trans_mat_array[k*6];
+			trans_param_coord_array[k].s_coord = m[0]*from_param_coord.s_coord + m[1]*from_param_coord.t_coord + m[2];
+			trans_param_coord_array[k].t_coord = m[3]*from_param_coord.s_coord + m[4]*from_param_coord.t_coord + m[5];
+		}
+
+		std::vector<double> tri_param_coord(tri_face_array.size()*6);
+		for(size_t k=0; k<grid_chart_array.size(); ++k)
+		{
+			int chart_id = grid_chart_array[k];
+			for(int i=chart_tri_offset[k]; i<chart_tri_offset[k+1]; ++i)
+			{
+				const int* face = face_info.GetFaceVertices(tri_face_array[i]);
+				for(int j=0; j<3; ++j)
+				{
+					int vid = face[j];
+					ParamCoord param_coord = m_vert_param_coord_array[vid];
+					if(m_vert_chart_array[vid] != chart_id)
+					{
+						size_t idx = std::lower_bound(trans_key_array.begin(), trans_key_array.end(), 
+							vid*chart_num_ll + chart_id) - trans_key_array.begin();
+						param_coord = trans_param_coord_array[idx];
+					}
+					tri_param_coord[i*6 + 2*j] = param_coord.s_coord;
+					tri_param_coord[i*6 + 2*j + 1] = param_coord.t_coord;
+				}
+			}
+		}
+
+		std::vector<ChartTriangleGrid> chart_grid_array(chart_num);
+		parallel_for(0, (int) grid_chart_array.size(), ChartGridBuildFunctor(grid_chart_array, chart_tri_offset, 
+			tri_face_array, tri_param_coord, chart_grid_array), 1);
+		parallel_for(0, (int) query_order.size(), SurfaceLocateFunctor(chart_param_coord_array, query_order, 
+			chart_grid_array, locate_result_array));
+	}
+
 	void Parameter::ComputeDistortion()
 	{
 
 		TriDistortion tri_distortion(*this);
 		tri_distortion.ComputeDistortion();
 
-		const std::vector<double>& face_harmonic_distortion = tri_distortion.GetFaceHarmonicDistortion();
-		const std::vector<double>& face_isometric_distortion = tri_distortion.GetFaceIsometricDistortion();
+		m_face_harmonic_distortion = tri_distortion.GetFaceHarmonicDistortion();
+		m_face_isometric_distortion = tri_distortion.GetFaceIsometricDistortion();
 
-		ofstream fout("distortion.txt");
-		for(size_t k=0; k<face_isometric_distortion.size(); ++k){
-			fout << face_isometric_distortion[k] << std::endl;
-		}
-		fout.close();
+		if(p_solve_monitor == NULL) SetMeshDistortionColor();
+	}
 
+	void Parameter::SetMeshDistortionColor()
+	{
 		//FaceValue2VtxColor(p_mesh, face_harmonic_distortion);
-		std::vector<double> face_value = face_isometric_distortion;
+		std::vector<double> face_value = m_face_isometric_distortion;
 // 		double sum_value = 0.0;
 // 		for(size_t k=0; k<face_value.size(); ++k)
 // 		{
@@ -1286,35 +2021,16 @@ namespace PARAM
 	{
 		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		std::vector<double> face_param_coord;
+		GatherFaceParamCoord(face_param_coord);
 
-		m_fliped_face_array.clear();
+		std::vector<int> face_sign(face_num);
+		parallel_for(0, face_num, FaceSignFunctor(face_param_coord, face_sign));
 
+		m_fliped_face_array.clear();
 		for(int fid =0; fid < face_num; ++fid)
 		{
-			const IndexArray& faces = face_list_array[fid];
-			int face_chart_id = m_face_chart_array[fid];
-			std::vector<double> u(3), v(3);
-			for(int i=0; i<3; ++i)
-			{
-				int vid = faces[i];
-				int chart_id = m_vert_chart_array[vid];
-				ParamCoord param_coord = m_vert_param_coord_array[vid];
-				if(chart_id != face_chart_id)
-				{
-					TransParamCoordBetweenCharts(chart_id, face_chart_id, vid,
-						m_vert_param_coord_array[vid], param_coord);
-				}
-				u[i] = param_coord.s_coord;
-				v[i] = param_coord.t_coord;
-			}
-			/// (v2-v0)*(u1-u0) - (u2-u0)*(v1-v0)
-			double area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1]-v[0]);
-			if(fabs(area) < LARGE_ZERO_EPSILON) continue;
-			if(area < 0 ){
-				m_fliped_face_array.push_back(fid);
-//				std::cout << fid << " : " << m_stiffen_weight[fid] << std::endl;
-			}
+			if(face_sign[fid] < 0) m_fliped_face_array.push_back(fid);
 		}
 		std::cout << "There are " << m_fliped_face_array.size() <<" fliped faces." << std::endl;
 	}
@@ -1353,191 +2069,76 @@ namespace PARAM
 		return false;
 	}
 
-	void Parameter::ComputeFaceSignFuncValue(std::vector<int>& face_sign_func_value)// const
+	void Parameter::ComputeFaceSignFuncValue(const std::vector<double>& face_param_coord, 
+		std::vector<int>& face_sign_func_value) const
 	{
 		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 		face_sign_func_value.clear(); 
 		face_sign_func_value.resize(face_num, 0);
 
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		parallel_for(0, face_num, FaceSignFunctor(face_param_coord, face_sign_func_value));
 
-		int flip_tri_num = 0;
-		for(int k=0; k<face_num; ++k)
-		{
-			const IndexArray& face = face_list[k];
-			int face_chart_id = m_face_chart_array[k];
-			std::vector<double> u(3), v(3);
-			for(int i=0; i<3; ++i)
-			{
-				int vid = face[i];
-				int chart_id = m_vert_chart_array[vid];
-				ParamCoord param_coord = m_vert_param_coord_array[vid];
-				if(chart_id != face_chart_id)
-				{
-					TransParamCoordBetweenCharts(chart_id, face_chart_id, vid,
-						m_vert_param_coord_array[vid], param_coord);
-				}
-				u[i] = param_coord.s_coord;
-				v[i] = param_coord.t_coord;
-			}		   			
-			
-			double f_value = (u[1]-u[0]) * (v[2]-v[0]) - (u[2]-u[0]) * (v[1]-v[0]);
-			face_sign_func_value[k] = SignFunc(f_value);
-			if(face_sign_func_value[k] == -1){
-				flip_tri_num ++;
-				
-			}
-		}
+		int flip_tri_num = (int) std::count(face_sign_func_value.begin(), face_sign_func_value.end(), -1);
 		std::cout << "Fliped triangles number: " << flip_tri_num << std::endl;
 	}
 
-	void Parameter::ComputeFaceLocalDistortion(const std::vector<int>& face_sign_func_value, 
-		std::vector<double>& face_distortion) const
+	void Parameter::ComputeFaceLocalDistortion(const std::vector<double>& face_param_coord, 
+		const std::vector<int>& face_sign_func_value, std::vector<double>& face_distortion) const
 	{
-		TriDistortion tri_distortion(*this);
 		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 		face_distortion.clear(); face_distortion.resize(face_num);
-		for(int k=0; k<face_num; ++k)
-		{
-			zjucad::matrix::matrix<double> jaobi_mat = tri_distortion.ComputeParamJacobiMatrix(k);			
-			zjucad::matrix::matrix<double> U, S, VT;
-			svd(jaobi_mat, U, S, VT);
-			double s1 = S(0, 0), s2 = S(1, 1);
-			face_distortion[k] = fabs( face_sign_func_value[k]*s1 - 1) 
-				+ fabs( face_sign_func_value[k]*s2 - 1);
-		}
+
+		parallel_for(0, face_num, FaceLocalDistortionFunctor(p_mesh->m_OperatorCache.GetFaceLocalCoord(),
+			p_mesh->m_OperatorCache.GetFaceArea(), face_param_coord, face_sign_func_value, face_distortion));
 	}
 
 
 	void Parameter::UpdateStiffeningWeight(const std::vector<double>& face_distortion)
 	{
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-
-		size_t face_num = face_list.size();
-		
-		for(size_t fid=0; fid<face_num; ++fid)
-		{
-			const IndexArray& face = face_list[fid];
-			double delta_d = face_distortion[fid];
-			delta_d = 0.0;
-			for(int i=0; i<3; ++i)
-			{
-				int vid1 = face[i], vid2 = face[(i+1)%3];
-				std::vector<int> adj_faces = GetMeshEdgeAdjFaces(p_mesh, vid1, vid2);
-				assert(adj_faces.size() == 2);
-				int _fid = (adj_faces[0] == fid) ? adj_faces[1] : adj_faces[0];
-				delta_d += face_distortion[_fid];
-			}
-			delta_d /= 3.0;
-
-			//delta_d = face_distortion[fid];
-
-			m_stiffen_weight[fid] += std::min(delta_d, 15.0);
-		}
-
-		ofstream fout("Stiffen-Weight.txt");
-		for(size_t fid=0; fid<face_num; ++fid)
-		{
-			fout << m_stiffen_weight[fid] << std::endl;
-		}
-		fout.close();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 
+		parallel_for(0, (int) face_num, StiffeningWeightFunctor(p_mesh->m_OperatorCache.GetFaceAdjOffset(),
+			p_mesh->m_OperatorCache.GetFaceAdjIndex(), face_distortion, m_stiffen_weight));
 	}
 
 	void Parameter::LocalStiffening()
 	{						
+		std::vector<double> face_param_coord;
+		GatherFaceParamCoord(face_param_coord);
+
 		std::vector<int> face_sign_func_value;
-		ComputeFaceSignFuncValue(face_sign_func_value);
+		ComputeFaceSignFuncValue(face_param_coord, face_sign_func_value);
 		
  		std::vector<double> face_distortion;
- 		ComputeFaceLocalDistortion(face_sign_func_value, face_distortion);
-
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const PolyIndexArray& adjface_list = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
+ 		ComputeFaceLocalDistortion(face_param_coord, face_sign_func_value, face_distortion);
 
 		UpdateStiffeningWeight(face_distortion);
 
-		size_t face_num = face_list.size();
-
-		for(size_t k=0; k<face_num; ++k)
-		{
-			const IndexArray& face = face_list[k];
-			
-		}
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 
+		//! faces flipped now or in a former iteration are the sources of the ring search
+		IndexArray flipped_face_list;
 		for(size_t k=0; k < face_num; ++k)
 		{
-			const IndexArray& face = face_list[k];
 			if(face_sign_func_value[k] < 0 || m_flippd_face[k] == true)
 			{
 				m_flippd_face[k] = true;
-				m_stiffen_weight[k] = (m_stiffen_weight[k] + 20000)/2;
-
-				std::vector<int> nb_1_ring;
-				p_mesh->m_BasicOp.GetFaceNeighborhood(k, nb_1_ring);
-
-				for(size_t i=0; i<nb_1_ring.size(); ++i)
-				{
-					int nb1_fid = nb_1_ring[i];
-					if(face_sign_func_value[nb1_fid] >= 0 && m_flippd_face[nb1_fid] == false){
-						m_stiffen_weight[nb1_fid] = (m_stiffen_weight[nb1_fid] + 2000)/2;
-					}
-
-					std::vector<int> nb_2_ring;
-					p_mesh->m_BasicOp.GetFaceNeighborhood(nb1_fid, nb_2_ring);
-					for(size_t j=0; j<nb_2_ring.size(); ++j)
-					{
-						int nb2_fid = nb_2_ring[j];
-						if(find(nb_1_ring.begin(), nb_1_ring.end(), nb2_fid) != nb_1_ring.end())
-						{
-							if(face_sign_func_value[nb2_fid] >=0 && m_flippd_face[nb2_fid] == false){
-								m_stiffen_weight[nb2_fid] = (m_stiffen_weight[nb2_fid] + 200) /2;
-							}
-						}
-
-						std::vector<int> nb_3_ring;
-						p_mesh->m_BasicOp.GetFaceNeighborhood(nb2_fid, nb_3_ring);
-						for(size_t k=0; k<nb_3_ring.size(); ++k)
-						{
-							if(find(nb_1_ring.begin(), nb_1_ring.end(), nb1_fid) != nb_1_ring.end() &&
-								find(nb_2_ring.begin(), nb_2_ring.end(), nb2_fid) != nb_2_ring.end())
-							{
-								int nb3_fid = nb_3_ring[k];
-								if(face_sign_func_value[nb3_fid] >= 0 && m_flippd_face[nb3_fid] == false){
-									m_stiffen_weight[nb3_fid] = (m_stiffen_weight[nb3_fid] + 20) / 2;
-								}
-							}
-						}
-					}
-				}
-
-
-// 				for(int i=0; i<3; ++i)
-// 				{
-// 					int vid = face[i];
-// 					const IndexArray& adjfaces = adjface_list[vid];
-// 
-// 					for(size_t j=0; j<adjfaces.size(); ++j)
-// 					{
-// 						int adj_fid = adjfaces[j];
-// 						if(face_sign_func_value[adj_fid] >=0)
-// 							m_stiffen_weight[adjfaces[j]] = 500;
-// 					}
-// 				}
-			}else{
-				m_stiffen_weight[k] = 1.0;
+				flipped_face_list.push_back((int) k);
 			}
-		} 		
+		}
+
+		std::vector<int> ring_dist;
+		p_mesh->m_OperatorCache.GetFaceRingDistance(flipped_face_list, 3, ring_dist);
 
+		parallel_for(0, (int) face_num, RingStiffeningFunctor(ring_dist, m_flippd_face, m_stiffen_weight));
 	}
 
 	void Parameter::SetLapMatrixWithStiffeningWeight(CMeshSparseMatrix& stiffen_lap_mat)
 	{
-		std::vector<Coord> cot_coef_vec;
-		SetCotCoef(p_mesh, cot_coef_vec);
+		const std::vector<Coord>& cot_coef_vec = p_mesh->m_OperatorCache.GetCotCoef();
 
 		const PolyIndexArray& vAdjFaces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-		const PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& fInfo = p_mesh->m_Kernel.GetFaceInfo();
 
 		int i, j, k, n;
 		int fID, vID;
@@ -1557,7 +2158,7 @@ namespace PARAM
 			for (j = 0; j < n; j++)
 			{
 				fID = adjFaces[j];
-				const IndexArray& f = fIndex[fID];
+				const int* f = fInfo.GetFaceVertices(fID);
 
 				// Find the position of vertex i in face fID
 				for(k = 0; k < 3; ++ k)
@@ -1601,7 +2202,7 @@ namespace PARAM
 		const PolyIndexArray& vert_adj_faces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
 		const PolyIndexArray& vert_adj_vertices = p_mesh->m_Kernel.GetVertexInfo().GetAdjVertices();
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		for(int vid=0; vid < vert_num; ++vid){
 			if(p_mesh->m_BasicOp.IsBoundaryVertex(vid)) continue;
@@ -1644,7 +2245,7 @@ namespace PARAM
 
 					for(size_t k=0; k<adjFaces.size(); ++k)
 					{
-						const IndexArray& face = face_list[adjFaces[k]];
+						const int* face = face_info.GetFaceVertices(adjFaces[k]);
 						int _vid1 = face[0], _vid2 = face[1], _vid3 = face[2];
 						if(_vid1 > _vid2) swap(_vid1, _vid2);
 						if(_vid2 > _vid3) swap(_vid2, _vid3);
@@ -1681,8 +2282,8 @@ namespace PARAM
 
 	std::vector<ParamCoord> Parameter::GetFaceVertParamCoord(int fid) const
 	{
-		const PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& face= fIndex[fid];
+		const FaceInfo& fInfo = p_mesh->m_Kernel.GetFaceInfo();
+		const int* face = fInfo.GetFaceVertices(fid);
 
 		std::vector<ParamCoord> pc_vec(3);
 		int chart_id = m_face_chart_array[fid];
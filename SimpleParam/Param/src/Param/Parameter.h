@@ -12,11 +12,40 @@
 
 class MeshModel;
 class LinearSolver;
+class SchurSolver;
 class CMeshSparseMatrix;
 
 namespace PARAM
 {
     class ChartCreator;
+    class ParamResult;
+    class SurfaceLocateResult;
+    class SolveMonitor;
+
+	//! what a layout edit and the UpdateParamCoord after it change, saved before the edit
+	//! so that an update which doesn't finish can be undone
+	class ParamEditState
+	{
+	private:
+		friend class Parameter;
+
+		std::vector<PatchConner> patch_conner_array;
+		std::vector<PatchEdge> patch_edge_array;
+		std::vector<ParamPatch> patch_array;
+
+		std::vector<int> vert_chart_array;
+		std::vector<int> face_chart_array;
+		std::vector<int> vert_patch_array;
+		std::vector<int> face_patch_array;
+		std::vector<ParamCoord> vert_param_coord_array;
+		std::vector< std::vector<int> > chart_vertices_array;
+
+		std::vector<int> out_range_vert_array;
+		std::vector<int> unset_layout_face_array;
+		std::vector<int> fliped_face_array;
+		std::vector<double> face_harmonic_distortion;
+		std::vector<double> face_isometric_distortion;
+	};
 
     class Parameter
     {
@@ -26,8 +55,39 @@ namespace PARAM
 
 		void OptimizeAmbiguityPatch();
 
+        //! false when the patch layout is missing or the solve is canceled
         bool ComputeParamCoord();
 
+		//! solve again after ChartCreator::MovePatchConner or ReroutePatchEdge changed edited_patch_array.
+		//! only the vertices of these patches and halo_ring rings around them are unknowns, the others
+		//! keep their coordinates and enter the right hand side. the first call without a solution runs
+		//! ComputeParamCoord. it reports to the solve monitor as ComputeParamCoord does.
+		//! false without a change when a patch index is out of range
+		bool UpdateParamCoord(const std::vector<int>& edited_patch_array, int halo_ring = 3);
+
+		//! save the patch layout and the solution before an edit, and put them back when
+		//! UpdateParamCoord after it is canceled or fails
+		void SaveEditState(ParamEditState& state) const;
+		void RestoreEditState(const ParamEditState& state);
+
+		//! progress, cancellation and preview of ComputeParamCoord, NULL for none.
+		//! the monitor is called from the thread running ComputeParamCoord
+		void SetSolveMonitor(SolveMonitor* monitor) { p_solve_monitor = monitor; }
+
+		//! color the mesh faces by chart and the vertices by distortion. ComputeParamCoord does it
+		//! by itself without a monitor, with one it is left to the caller's thread after the solve
+		void UpdateMeshColor();
+
+		//! directory of the binary result cache, none by default. an empty directory disables the cache,
+		//! the viewer puts it next to the mesh file
+		void SetResultCacheDir(const std::string& cache_dir) { m_result_cache_dir = cache_dir; }
+		const std::string& GetResultCacheDir() const { return m_result_cache_dir; }
+
+		//! eliminate each chart's interior in parallel and solve the chart interface system,
+		//! instead of factorizing the whole system at once
+		void SetChartParallelSolve(bool chart_parallel) { m_chart_parallel_solve = chart_parallel; }
+		bool IsChartParallelSolve() const { return m_chart_parallel_solve; }
+
     public:
         //! IO
         bool LoadPatchFile(const std::string& file_name);
@@ -38,6 +98,10 @@ namespace PARAM
 
 		std::vector<ParamCoord> GetFaceVertParamCoord(int fid) const ;
 
+		//! gather each face's three vertices's parameter coordinates in the face's chart,
+		//! stored as (s0, t0, s1, t1, s2, t2) per face
+		void GatherFaceParamCoord(std::vector<double>& face_param_coord) const;
+
 
 		const std::vector<int>& GetVertexChartArray() const { return m_vert_chart_array; }
 		const std::vector<ParamCoord>& GetVertexParamCoordArray() const { return m_vert_param_coord_array; }
@@ -51,19 +115,35 @@ namespace PARAM
 		const std::vector<int>& GetFlipedFaceArray() const { return m_fliped_face_array; }
 		const std::vector<int>& GetVertexPatchArray() const { return m_vert_patch_array; }
 		const std::vector<int>& GetFacePatchArray() const {return m_face_patch_array; }
+
+		const std::vector<double>& GetFaceHarmonicDistortion() const { return m_face_harmonic_distortion; }
+		const std::vector<double>& GetFaceIsometricDistortion() const { return m_face_isometric_distortion; }
 	private:
 		int SetVariIndexMapping(std::vector<int>& vari_index_mapping);
 		void SetBoundaryVertexParamValue(LinearSolver* p_linear_solver = NULL);
         
 		void SolveParameter(const CMeshSparseMatrix& lap_mat);
+		//! solve the vertices with a variable index, the others are known
+		void SolveParameter(const CMeshSparseMatrix& lap_mat, 
+			const std::vector<int>& vari_index_mapping, int vari_vert_num);
 
 		//! after each iterator, we need reassign vertices's chart  
 		void AdjustPatchBoundary();
 
 		void VertexRelalaxation();
 
+		bool IsSolveCanceled() const;
+		void ReportSolveProgress(int stage, int iteration, double residual) const;
+		void PublishSolveSnapshot() const;
+
+		//! rms change of the parameter coordinates of the vertices still in the same chart
+		double ComputeParamCoordChange(const std::vector<int>& prev_vert_chart_array,
+			const std::vector<ParamCoord>& prev_vert_param_coord_array) const;
+
 		void SetInitVertChartLayout();
 		void SetInitFaceChartLayout();
+		//! the chart most of a vertex's adjacent faces are in
+		int FindMajorityFaceChart(int vid) const;
 		
 	  
 		void GetOutRangeVertices(std::vector<int>& out_range_vert_array) const;
@@ -83,6 +163,9 @@ namespace PARAM
 		//! set mesh texture 
 		void SetMeshFaceTextureCoord();
 
+		void SetMeshChartColor();
+		void SetMeshDistortionColor();
+
 		//! set each chart's vertices 
 		void SetChartVerticesArray();
 
@@ -99,6 +182,12 @@ namespace PARAM
 
 		bool GetConnerParamCoord(int chart_id, int conner_idx, ParamCoord& conner_pc) const;
 
+	private:
+		//! result cache, keyed by the mesh geometry, the patch layout and the solver settings
+		unsigned long long ComputeResultCacheKey() const;
+		bool LoadResultCache(unsigned long long key);
+		void SaveResultCache(unsigned long long key) const;
+
 	private:
 		/// Conner Relocating
 		void ConnerRelocating();
@@ -111,8 +200,10 @@ namespace PARAM
 		//! LocalStiffening;
 		void LocalStiffening();
 
-		void ComputeFaceSignFuncValue(std::vector<int>& face_sign_func_value) ;//const;
-		void ComputeFaceLocalDistortion(const std::vector<int>& face_sign_func_value, std::vector<double>& face_distortion) const;
+		//! face_param_coord is the output of GatherFaceParamCoord
+		void ComputeFaceSignFuncValue(const std::vector<double>& face_param_coord, std::vector<int>& face_sign_func_value) const;
+		void ComputeFaceLocalDistortion(const std::vector<double>& face_param_coord, 
+			const std::vector<int>& face_sign_func_value, std::vector<double>& face_distortion) const;
 		void UpdateStiffeningWeight(const std::vector<double>& face_distortion);
 
 		void SetLapMatrixWithStiffeningWeight(CMeshSparseMatrix& stiffen_lap_mat);
@@ -130,6 +221,9 @@ namespace PARAM
 
 		zjucad::matrix::matrix<double> GetTransMatrix(int from_vid, int to_vid, int from_chart_id, int to_chart_id) const;
 
+		//! transition matrix of vertex vid's parameter coordinate between two charts
+		zjucad::matrix::matrix<double> GetVertTransMatrix(int from_chart_id, int to_chart_id, int vid) const;
+
 // 		void TransParamCoordBetweenCharts(int from_chart_id, int to_chart_id, 
 // 			const ParamCoord& from_param_coord, ParamCoord& to_param_coord) const;
 		void TransParamCoordBetweenCharts(int from_chart_id, int to_chart_id, int vid, 
@@ -141,11 +235,23 @@ namespace PARAM
 		//! find the corresponding surface position with the chart paramerter coordinate
 		bool FindCorrespondingOnSurface(const ChartParamCoord& chart_param_coord,SurfaceCoord& surface_coord) const;
 
+		//! batch version for many queries, the queries are grouped by chart, each chart's triangles
+		//! are put into a grid once and the queries are located in parallel.
+		//! a query outside its chart gets the nearest triangle with state LOCATE_NEAREST
+		void FindCorrespondingOnSurface(const std::vector<ChartParamCoord>& chart_param_coord_array,
+			std::vector<SurfaceLocateResult>& locate_result_array) const;
+
 		void ComputeDistortion();
 	private:
 		boost::shared_ptr<MeshModel> p_mesh;
 		boost::shared_ptr<ChartCreator> p_chart_creator;
 
+		//! chart factorizations, kept across the solve loops of ComputeParamCoord
+		boost::shared_ptr<SchurSolver> p_schur_solver;
+		bool m_chart_parallel_solve;
+
+		SolveMonitor* p_solve_monitor;
+
 		std::vector<int> m_vert_chart_array; //! each vertex's chart
 		std::vector<int> m_face_chart_array; //! each face's chart
 
@@ -165,6 +271,11 @@ namespace PARAM
 		std::vector<double> m_stiffen_weight;
 
 		std::vector<bool> m_flippd_face;
+
+		std::vector<double> m_face_harmonic_distortion;
+		std::vector<double> m_face_isometric_distortion;
+
+		std::string m_result_cache_dir;
     };
 } 
 
@@ -0,0 +1,671 @@
+#include "PatchLayoutIO.h"
+#include "../Common/MappedFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <climits>
+
+namespace PARAM
+{
+	const char* const PATCH_LAYOUT_BINARY_EXT = ".bpatch";
+
+	namespace
+	{
+		const char LAYOUT_FILE_MAGIC[8] = {'P', 'R', 'M', 'P', 'T', 'C', 'H', '\0'};
+		const int LAYOUT_FILE_VERSION = 1;
+
+		enum LayoutArrayType
+		{
+			CONNER_INFO = 0,	//! (type, mesh_index) per conner
+			CONNER_NB_OFFSET, CONNER_NB,	//! (nb_conner, nb_edge) pairs
+			EDGE_CONNER,		//! conner pair per edge
+			EDGE_NB_OFFSET, EDGE_NB,
+			EDGE_PATH_OFFSET, EDGE_PATH,
+			PATCH_FACE_OFFSET, PATCH_FACE,
+			PATCH_EDGE_OFFSET, PATCH_EDGE,
+			LAYOUT_ARRAY_NUM
+		};
+
+		struct LayoutFileHeader
+		{
+			char magic[8];
+			int version;
+			int array_num;
+			int conner_num;
+			int edge_num;
+			int patch_num;
+			int reserved;
+			unsigned long long array_offset[LAYOUT_ARRAY_NUM]; //! byte offset from the file begin
+			unsigned long long array_size[LAYOUT_ARRAY_NUM]; //! element number
+		};
+
+		unsigned long long AlignOffset(unsigned long long offset)
+		{
+			return (offset + 7) & ~7ULL;
+		}
+
+		//! the loaders parse the mapped file in place, the binary arrays are read without a copy
+		bool OpenLayoutFile(const std::string& file_name, MappedFile& file)
+		{
+			if(!file.Open(file_name))
+			{
+				std::cerr << "Error : cannot open patch file " << file_name << "!" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		bool IsBinaryLayout(const MappedFile& file)
+		{
+			return file.GetSize() >= sizeof(LAYOUT_FILE_MAGIC)
+				&& memcmp(file.GetData(), LAYOUT_FILE_MAGIC, sizeof(LAYOUT_FILE_MAGIC)) == 0;
+		}
+
+		//! hand-written integer scanner over the whole text file, keeps the line and
+		//! column of the last token for error messages
+		class PatchLayoutTextReader
+		{
+		public:
+			PatchLayoutTextReader(const std::string& _file_name, const MappedFile& file)
+				: file_name(_file_name), cur(file.GetData()), end(cur + file.GetSize()),
+				line_begin(cur), line(1), token_line(1), token_column(1) {}
+
+			bool ReadInt(const char* what, int& value)
+			{
+				while(cur != end && IsSpace(*cur))
+				{
+					if(*cur == '\n') { ++line; line_begin = cur + 1; }
+					++cur;
+				}
+				token_line = line;
+				token_column = (int) (cur - line_begin) + 1;
+				if(cur == end) return Error(std::string("unexpected end of file, expected ") + what);
+
+				bool negative = (*cur == '-');
+				if(*cur == '-' || *cur == '+') ++cur;
+				long long acc = 0;
+				const char* digit_begin = cur;
+				while(cur != end && *cur >= '0' && *cur <= '9')
+				{
+					acc = acc*10 + (*cur - '0');
+					if(acc > INT_MAX) return Error(std::string(what) + " is out of the integer range");
+					++cur;
+				}
+				if(cur == digit_begin || (cur != end && !IsSpace(*cur)))
+				{
+					return Error(std::string("expected ") + what);
+				}
+				value = (int) (negative ? -acc : acc);
+				return true;
+			}
+
+			//! a count is non-negative and can not exceed the rest of the file
+			bool ReadCount(const char* what, int& count)
+			{
+				if(!ReadInt(what, count)) return false;
+				if(count < 0 || count > (end - cur)/2 + 1)
+				{
+					std::ostringstream oss;
+					oss << what << " " << count << " is invalid";
+					return Error(oss.str());
+				}
+				return true;
+			}
+
+			//! bound < 0 skips the range check
+			bool ReadIndex(const char* what, int bound, int& index)
+			{
+				if(!ReadInt(what, index)) return false;
+				return CheckIndex(what, index, bound, token_line, token_column);
+			}
+
+			//! the bound of a forward reference is not known yet, it is checked after the whole file is read
+			void DeferIndex(int index, int* bound, const char* what)
+			{
+				DeferredIndex deferred_index = {index, bound, what, token_line, token_column};
+				deferred_array.push_back(deferred_index);
+			}
+
+			bool CheckDeferredIndex()
+			{
+				for(size_t k=0; k<deferred_array.size(); ++k)
+				{
+					const DeferredIndex& d = deferred_array[k];
+					if(!CheckIndex(d.what, d.index, *d.bound, d.line, d.column)) return false;
+				}
+				return true;
+			}
+
+			bool CheckIndex(const char* what, int index, int bound, int at_line, int at_column)
+			{
+				if(index >= 0 && (bound < 0 || index < bound)) return true;
+				std::ostringstream oss;
+				oss << what << " " << index << " is out of range";
+				if(bound >= 0) oss << " [0, " << bound << ")";
+				token_line = at_line;
+				token_column = at_column;
+				return Error(oss.str());
+			}
+
+			bool Error(const std::string& msg) const
+			{
+				std::cerr << "Error : " << file_name << ":" << token_line << ":" << token_column << ": " << msg << std::endl;
+				return false;
+			}
+
+		private:
+			static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+			struct DeferredIndex
+			{
+				int index;
+				int* bound;
+				const char* what;
+				int line, column;
+			};
+
+			const std::string& file_name;
+			const char* cur;
+			const char* end;
+			const char* line_begin;
+			int line;
+			int token_line, token_column;
+			std::vector<DeferredIndex> deferred_array;
+		};
+
+		bool ParsePatchLayoutText(PatchLayoutTextReader& reader, int vert_num, int face_num, PatchLayout& layout)
+		{
+			int conner_num(0), edge_num(-1), patch_num(-1);
+
+			/// patch conners, their neighbor edges are checked once the edge number is known
+			if(!reader.ReadCount("patch conner number", conner_num)) return false;
+			layout.m_patch_conner_array.resize(conner_num);
+			for(int k=0; k<conner_num; ++k)
+			{
+				PatchConner& patch_conner = layout.m_patch_conner_array[k];
+				int neighbor_num;
+				if(!reader.ReadInt("conner type", patch_conner.m_conner_type)
+					|| !reader.ReadIndex("conner mesh vertex", vert_num, patch_conner.m_mesh_index)
+					|| !reader.ReadCount("conner neighbor number", neighbor_num)) return false;
+
+				patch_conner.m_nb_conner_index_array.resize(neighbor_num);
+				patch_conner.m_nb_edge_index_array.resize(neighbor_num);
+				for(int i=0; i<neighbor_num; ++i)
+				{
+					if(!reader.ReadIndex("neighbor conner", conner_num, patch_conner.m_nb_conner_index_array[i])
+						|| !reader.ReadInt("neighbor edge", patch_conner.m_nb_edge_index_array[i])) return false;
+					reader.DeferIndex(patch_conner.m_nb_edge_index_array[i], &edge_num, "neighbor edge");
+				}
+			}
+
+			/// patch edges, their neighbor patches are checked once the patch number is known
+			if(!reader.ReadCount("patch edge number", edge_num)) return false;
+			layout.m_patch_edge_array.resize(edge_num);
+			for(int k=0; k<edge_num; ++k)
+			{
+				PatchEdge& patch_edge = layout.m_patch_edge_array[k];
+				int neighbor_num, path_vert_num;
+				if(!reader.ReadIndex("edge conner", conner_num, patch_edge.m_conner_pair_index.first)
+					|| !reader.ReadIndex("edge conner", conner_num, patch_edge.m_conner_pair_index.second)
+					|| !reader.ReadCount("edge neighbor number", neighbor_num)) return false;
+
+				patch_edge.m_nb_patch_index_array.resize(neighbor_num);
+				for(int i=0; i<neighbor_num; ++i)
+				{
+					if(!reader.ReadInt("neighbor patch", patch_edge.m_nb_patch_index_array[i])) return false;
+					reader.DeferIndex(patch_edge.m_nb_patch_index_array[i], &patch_num, "neighbor patch");
+				}
+
+				if(!reader.ReadCount("edge path length", path_vert_num)) return false;
+				patch_edge.m_mesh_path.resize(path_vert_num);
+				for(int i=0; i<path_vert_num; ++i)
+				{
+					if(!reader.ReadIndex("edge path vertex", vert_num, patch_edge.m_mesh_path[i])) return false;
+				}
+			}
+
+			/// patches
+			if(!reader.ReadCount("patch number", patch_num)) return false;
+			layout.m_patch_array.resize(patch_num);
+			for(int k=0; k<patch_num; ++k)
+			{
+				ParamPatch& patch = layout.m_patch_array[k];
+				int patch_face_num, patch_edge_num;
+				if(!reader.ReadCount("patch face number", patch_face_num)) return false;
+				patch.m_face_index_array.resize(patch_face_num);
+				for(int i=0; i<patch_face_num; ++i)
+				{
+					if(!reader.ReadIndex("patch face", face_num, patch.m_face_index_array[i])) return false;
+				}
+
+				if(!reader.ReadCount("patch edge number", patch_edge_num)) return false;
+				patch.m_edge_index_array.resize(patch_edge_num);
+				for(int i=0; i<patch_edge_num; ++i)
+				{
+					if(!reader.ReadIndex("patch edge", edge_num, patch.m_edge_index_array[i])) return false;
+				}
+			}
+
+			return reader.CheckDeferredIndex();
+		}
+
+		void AppendInt(std::string& text, int value, char separator)
+		{
+			char str[16];
+			int len = 0;
+			unsigned int abs_value = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+			do { str[len++] = (char) ('0' + abs_value % 10); abs_value /= 10; } while(abs_value != 0);
+			if(value < 0) str[len++] = '-';
+			while(len > 0) text.push_back(str[--len]);
+			text.push_back(separator);
+		}
+
+		void AppendIntArray(std::string& text, const std::vector<int>& array)
+		{
+			AppendInt(text, (int) array.size(), array.empty() ? '\n' : ' ');
+			for(size_t i=0; i<array.size(); ++i) AppendInt(text, array[i], i+1 == array.size() ? '\n' : ' ');
+		}
+
+		template <typename T>
+		void PlaceArray(LayoutFileHeader& header, int type, const std::vector<T>& array, unsigned long long& offset)
+		{
+			header.array_offset[type] = offset;
+			header.array_size[type] = array.size();
+			offset = AlignOffset(offset + array.size()*sizeof(T));
+		}
+
+		template <typename T>
+		void WriteArray(std::vector<char>& buffer, const LayoutFileHeader& header, int type, const std::vector<T>& array)
+		{
+			if(array.empty()) return;
+			memcpy(&buffer[header.array_offset[type]], &array[0], array.size()*sizeof(T));
+		}
+
+		//! pointer to an int array of the mapped file, NULL if it does not fit in the file
+		const int* GetArray(const MappedFile& file, const LayoutFileHeader& header, int type, size_t size)
+		{
+			unsigned long long offset = header.array_offset[type];
+			if(header.array_size[type] != size || offset % sizeof(int) != 0
+				|| offset > file.GetSize() || size > (file.GetSize() - offset) / sizeof(int)) return NULL;
+			static const int empty_array = 0;
+			return size == 0 ? &empty_array : (const int*) (file.GetData() + offset);
+		}
+
+		//! an offset array of item_num+1 entries, starting at 0 and non-decreasing
+		bool IsValidOffsetArray(const int* offset, int item_num)
+		{
+			if(offset == NULL || offset[0] != 0) return false;
+			for(int k=0; k<item_num; ++k) if(offset[k+1] < offset[k]) return false;
+			return true;
+		}
+
+		bool CheckLayoutIndex(const std::string& file_name, const char* what, int owner, int index, int bound)
+		{
+			if(index >= 0 && (bound < 0 || index < bound)) return true;
+			std::cerr << "Error : " << file_name << ": " << what << " " << index << " of item " << owner
+				<< " is out of range";
+			if(bound >= 0) std::cerr << " [0, " << bound << ")";
+			std::cerr << std::endl;
+			return false;
+		}
+
+		bool ValidatePatchLayout(const std::string& file_name, const PatchLayout& layout, int vert_num, int face_num)
+		{
+			int conner_num = (int) layout.m_patch_conner_array.size();
+			int edge_num = (int) layout.m_patch_edge_array.size();
+			int patch_num = (int) layout.m_patch_array.size();
+			for(int k=0; k<conner_num; ++k)
+			{
+				const PatchConner& patch_conner = layout.m_patch_conner_array[k];
+				if(!CheckLayoutIndex(file_name, "conner mesh vertex", k, patch_conner.m_mesh_index, vert_num)) return false;
+				for(size_t i=0; i<patch_conner.m_nb_conner_index_array.size(); ++i)
+				{
+					if(!CheckLayoutIndex(file_name, "neighbor conner", k, patch_conner.m_nb_conner_index_array[i], conner_num)
+						|| !CheckLayoutIndex(file_name, "neighbor edge", k, patch_conner.m_nb_edge_index_array[i], edge_num)) return false;
+				}
+			}
+			for(int k=0; k<edge_num; ++k)
+			{
+				const PatchEdge& patch_edge = layout.m_patch_edge_array[k];
+				if(!CheckLayoutIndex(file_name, "edge conner", k, patch_edge.m_conner_pair_index.first, conner_num)
+					|| !CheckLayoutIndex(file_name, "edge conner", k, patch_edge.m_conner_pair_index.second, conner_num)) return false;
+				for(size_t i=0; i<patch_edge.m_nb_patch_index_array.size(); ++i)
+				{
+					if(!CheckLayoutIndex(file_name, "neighbor patch", k, patch_edge.m_nb_patch_index_array[i], patch_num)) return false;
+				}
+				for(size_t i=0; i<patch_edge.m_mesh_path.size(); ++i)
+				{
+					if(!CheckLayoutIndex(file_name, "edge path vertex", k, patch_edge.m_mesh_path[i], vert_num)) return false;
+				}
+			}
+			for(int k=0; k<patch_num; ++k)
+			{
+				const ParamPatch& patch = layout.m_patch_array[k];
+				for(size_t i=0; i<patch.m_face_index_array.size(); ++i)
+				{
+					if(!CheckLayoutIndex(file_name, "patch face", k, patch.m_face_index_array[i], face_num)) return false;
+				}
+				for(size_t i=0; i<patch.m_edge_index_array.size(); ++i)
+				{
+					if(!CheckLayoutIndex(file_name, "patch edge", k, patch.m_edge_index_array[i], edge_num)) return false;
+				}
+			}
+			return true;
+		}
+
+		bool ParsePatchLayoutBinary(const std::string& file_name, const MappedFile& file,
+			int vert_num, int face_num, PatchLayout& layout)
+		{
+			LayoutFileHeader header;
+			if(file.GetSize() < sizeof(LayoutFileHeader))
+			{
+				std::cerr << "Error : " << file_name << ": truncated header." << std::endl;
+				return false;
+			}
+			memcpy(&header, file.GetData(), sizeof(LayoutFileHeader));
+			if(header.version != LAYOUT_FILE_VERSION || header.array_num != LAYOUT_ARRAY_NUM
+				|| header.conner_num < 0 || header.edge_num < 0 || header.patch_num < 0)
+			{
+				std::cerr << "Error : " << file_name << ": unsupported patch layout version." << std::endl;
+				return false;
+			}
+			int conner_num = header.conner_num, edge_num = header.edge_num, patch_num = header.patch_num;
+
+			/// offset arrays first, they give the size of the value arrays
+			const int* conner_info = GetArray(file, header, CONNER_INFO, (size_t) conner_num*2);
+			const int* conner_nb_offset = GetArray(file, header, CONNER_NB_OFFSET, (size_t) conner_num + 1);
+			const int* edge_conner = GetArray(file, header, EDGE_CONNER, (size_t) edge_num*2);
+			const int* edge_nb_offset = GetArray(file, header, EDGE_NB_OFFSET, (size_t) edge_num + 1);
+			const int* edge_path_offset = GetArray(file, header, EDGE_PATH_OFFSET, (size_t) edge_num + 1);
+			const int* patch_face_offset = GetArray(file, header, PATCH_FACE_OFFSET, (size_t) patch_num + 1);
+			const int* patch_edge_offset = GetArray(file, header, PATCH_EDGE_OFFSET, (size_t) patch_num + 1);
+			bool valid = conner_info != NULL && edge_conner != NULL
+				&& IsValidOffsetArray(conner_nb_offset, conner_num) && IsValidOffsetArray(edge_nb_offset, edge_num)
+				&& IsValidOffsetArray(edge_path_offset, edge_num) && IsValidOffsetArray(patch_face_offset, patch_num)
+				&& IsValidOffsetArray(patch_edge_offset, patch_num);
+
+			const int *conner_nb = NULL, *edge_nb = NULL, *edge_path = NULL, *patch_face = NULL, *patch_edge = NULL;
+			if(valid)
+			{
+				conner_nb = GetArray(file, header, CONNER_NB, (size_t) conner_nb_offset[conner_num]*2);
+				edge_nb = GetArray(file, header, EDGE_NB, (size_t) edge_nb_offset[edge_num]);
+				edge_path = GetArray(file, header, EDGE_PATH, (size_t) edge_path_offset[edge_num]);
+				patch_face = GetArray(file, header, PATCH_FACE, (size_t) patch_face_offset[patch_num]);
+				patch_edge = GetArray(file, header, PATCH_EDGE, (size_t) patch_edge_offset[patch_num]);
+				valid = conner_nb != NULL && edge_nb != NULL && edge_path != NULL && patch_face != NULL && patch_edge != NULL;
+			}
+			if(!valid)
+			{
+				std::cerr << "Error : " << file_name << ": truncated or corrupted patch layout." << std::endl;
+				return false;
+			}
+
+			layout.m_patch_conner_array.resize(conner_num);
+			for(int k=0; k<conner_num; ++k)
+			{
+				PatchConner& patch_conner = layout.m_patch_conner_array[k];
+				patch_conner.m_conner_type = conner_info[2*k];
+				patch_conner.m_mesh_index = conner_info[2*k+1];
+				patch_conner.m_nb_conner_index_array.clear();
+				patch_conner.m_nb_edge_index_array.clear();
+				for(int i=conner_nb_offset[k]; i<conner_nb_offset[k+1]; ++i)
+				{
+					patch_conner.m_nb_conner_index_array.push_back(conner_nb[2*i]);
+					patch_conner.m_nb_edge_index_array.push_back(conner_nb[2*i+1]);
+				}
+			}
+			layout.m_patch_edge_array.resize(edge_num);
+			for(int k=0; k<edge_num; ++k)
+			{
+				PatchEdge& patch_edge_ = layout.m_patch_edge_array[k];
+				patch_edge_.m_conner_pair_index = std::make_pair(edge_conner[2*k], edge_conner[2*k+1]);
+				patch_edge_.m_nb_patch_index_array.assign(edge_nb + edge_nb_offset[k], edge_nb + edge_nb_offset[k+1]);
+				patch_edge_.m_mesh_path.assign(edge_path + edge_path_offset[k], edge_path + edge_path_offset[k+1]);
+			}
+			layout.m_patch_array.resize(patch_num);
+			for(int k=0; k<patch_num; ++k)
+			{
+				ParamPatch& patch = layout.m_patch_array[k];
+				patch.m_face_index_array.assign(patch_face + patch_face_offset[k], patch_face + patch_face_offset[k+1]);
+				patch.m_edge_index_array.assign(patch_edge + patch_edge_offset[k], patch_edge + patch_edge_offset[k+1]);
+			}
+
+			return ValidatePatchLayout(file_name, layout, vert_num, face_num);
+		}
+	}
+
+	void PatchLayout::ClearData()
+	{
+		m_patch_conner_array.clear();
+		m_patch_edge_array.clear();
+		m_patch_array.clear();
+	}
+
+	bool LoadPatchLayoutText(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout)
+	{
+		layout.ClearData();
+		MappedFile file;
+		if(!OpenLayoutFile(file_name, file)) return false;
+
+		PatchLayoutTextReader reader(file_name, file);
+		if(!ParsePatchLayoutText(reader, vert_num, face_num, layout))
+		{
+			layout.ClearData();
+			return false;
+		}
+		return true;
+	}
+
+	bool SavePatchLayoutText(const std::string& file_name, const PatchLayout& layout)
+	{
+		std::string text;
+		AppendInt(text, (int) layout.m_patch_conner_array.size(), '\n');
+		for(size_t k=0; k<layout.m_patch_conner_array.size(); ++k)
+		{
+			const PatchConner& patch_conner = layout.m_patch_conner_array[k];
+			AppendInt(text, patch_conner.m_conner_type, ' ');
+			AppendInt(text, patch_conner.m_mesh_index, ' ');
+			size_t neighbor_num = patch_conner.m_nb_conner_index_array.size();
+			AppendInt(text, (int) neighbor_num, neighbor_num == 0 ? '\n' : ' ');
+			for(size_t i=0; i<neighbor_num; ++i)
+			{
+				AppendInt(text, patch_conner.m_nb_conner_index_array[i], ' ');
+				AppendInt(text, patch_conner.m_nb_edge_index_array[i], i+1 == neighbor_num ? '\n' : ' ');
+			}
+		}
+
+		AppendInt(text, (int) layout.m_patch_edge_array.size(), '\n');
+		for(size_t k=0; k<layout.m_patch_edge_array.size(); ++k)
+		{
+			const PatchEdge& patch_edge = layout.m_patch_edge_array[k];
+			AppendInt(text, patch_edge.m_conner_pair_index.first, ' ');
+			AppendInt(text, patch_edge.m_conner_pair_index.second, '\n');
+			AppendIntArray(text, patch_edge.m_nb_patch_index_array);
+			AppendIntArray(text, patch_edge.m_mesh_path);
+		}
+
+		AppendInt(text, (int) layout.m_patch_array.size(), '\n');
+		for(size_t k=0; k<layout.m_patch_array.size(); ++k)
+		{
+			AppendIntArray(text, layout.m_patch_array[k].m_face_index_array);
+			AppendIntArray(text, layout.m_patch_array[k].m_edge_index_array);
+		}
+
+		std::ofstream fout(file_name.c_str(), std::ios::binary);
+		if(fout.fail())
+		{
+			std::cerr << "Error : cannot open patch file " << file_name << " for writing!" << std::endl;
+			return false;
+		}
+		fout.write(text.data(), text.size());
+		return !fout.fail();
+	}
+
+	bool LoadPatchLayoutBinary(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout)
+	{
+		layout.ClearData();
+		MappedFile file;
+		if(!OpenLayoutFile(file_name, file)) return false;
+		if(!IsBinaryLayout(file))
+		{
+			std::cerr << "Error : " << file_name << " is not a binary patch layout." << std::endl;
+			return false;
+		}
+		if(!ParsePatchLayoutBinary(file_name, file, vert_num, face_num, layout))
+		{
+			layout.ClearData();
+			return false;
+		}
+		return true;
+	}
+
+	bool SavePatchLayoutBinary(const std::string& file_name, const PatchLayout& layout)
+	{
+		/// flatten the lists into offset and value arrays
+		std::vector<int> conner_info, conner_nb_offset(1, 0), conner_nb;
+		for(size_t k=0; k<layout.m_patch_conner_array.size(); ++k)
+		{
+			const PatchConner& patch_conner = layout.m_patch_conner_array[k];
+			conner_info.push_back(patch_conner.m_conner_type);
+			conner_info.push_back(patch_conner.m_mesh_index);
+			for(size_t i=0; i<patch_conner.m_nb_conner_index_array.size(); ++i)
+			{
+				conner_nb.push_back(patch_conner.m_nb_conner_index_array[i]);
+				conner_nb.push_back(patch_conner.m_nb_edge_index_array[i]);
+			}
+			conner_nb_offset.push_back((int) conner_nb.size()/2);
+		}
+
+		std::vector<int> edge_conner, edge_nb_offset(1, 0), edge_nb, edge_path_offset(1, 0), edge_path;
+		for(size_t k=0; k<layout.m_patch_edge_array.size(); ++k)
+		{
+			const PatchEdge& patch_edge = layout.m_patch_edge_array[k];
+			edge_conner.push_back(patch_edge.m_conner_pair_index.first);
+			edge_conner.push_back(patch_edge.m_conner_pair_index.second);
+			edge_nb.insert(edge_nb.end(), patch_edge.m_nb_patch_index_array.begin(), patch_edge.m_nb_patch_index_array.end());
+			edge_nb_offset.push_back((int) edge_nb.size());
+			edge_path.insert(edge_path.end(), patch_edge.m_mesh_path.begin(), patch_edge.m_mesh_path.end());
+			edge_path_offset.push_back((int) edge_path.size());
+		}
+
+		std::vector<int> patch_face_offset(1, 0), patch_face, patch_edge_offset(1, 0), patch_edge;
+		for(size_t k=0; k<layout.m_patch_array.size(); ++k)
+		{
+			const ParamPatch& patch = layout.m_patch_array[k];
+			patch_face.insert(patch_face.end(), patch.m_face_index_array.begin(), patch.m_face_index_array.end());
+			patch_face_offset.push_back((int) patch_face.size());
+			patch_edge.insert(patch_edge.end(), patch.m_edge_index_array.begin(), patch.m_edge_index_array.end());
+			patch_edge_offset.push_back((int) patch_edge.size());
+		}
+
+		LayoutFileHeader header;
+		memset(&header, 0, sizeof(LayoutFileHeader));
+		memcpy(header.magic, LAYOUT_FILE_MAGIC, sizeof(header.magic));
+		header.version = LAYOUT_FILE_VERSION;
+		header.array_num = LAYOUT_ARRAY_NUM;
+		header.conner_num = (int) layout.m_patch_conner_array.size();
+		header.edge_num = (int) layout.m_patch_edge_array.size();
+		header.patch_num = (int) layout.m_patch_array.size();
+
+		unsigned long long offset = AlignOffset(sizeof(LayoutFileHeader));
+		PlaceArray(header, CONNER_INFO, conner_info, offset);
+		PlaceArray(header, CONNER_NB_OFFSET, conner_nb_offset, offset);
+		PlaceArray(header, CONNER_NB, conner_nb, offset);
+		PlaceArray(header, EDGE_CONNER, edge_conner, offset);
+		PlaceArray(header, EDGE_NB_OFFSET, edge_nb_offset, offset);
+		PlaceArray(header, EDGE_NB, edge_nb, offset);
+		PlaceArray(header, EDGE_PATH_OFFSET, edge_path_offset, offset);
+		PlaceArray(header, EDGE_PATH, edge_path, offset);
+		PlaceArray(header, PATCH_FACE_OFFSET, patch_face_offset, offset);
+		PlaceArray(header, PATCH_FACE, patch_face, offset);
+		PlaceArray(header, PATCH_EDGE_OFFSET, patch_edge_offset, offset);
+		PlaceArray(header, PATCH_EDGE, patch_edge, offset);
+
+		std::vector<char> buffer((size_t) offset, 0);
+		memcpy(&buffer[0], &header, sizeof(LayoutFileHeader));
+		WriteArray(buffer, header, CONNER_INFO, conner_info);
+		WriteArray(buffer, header, CONNER_NB_OFFSET, conner_nb_offset);
+		WriteArray(buffer, header, CONNER_NB, conner_nb);
+		WriteArray(buffer, header, EDGE_CONNER, edge_conner);
+		WriteArray(buffer, header, EDGE_NB_OFFSET, edge_nb_offset);
+		WriteArray(buffer, header, EDGE_NB, edge_nb);
+		WriteArray(buffer, header, EDGE_PATH_OFFSET, edge_path_offset);
+		WriteArray(buffer, header, EDGE_PATH, edge_path);
+		WriteArray(buffer, header, PATCH_FACE_OFFSET, patch_face_offset);
+		WriteArray(buffer, header, PATCH_FACE, patch_face);
+		WriteArray(buffer, header, PATCH_EDGE_OFFSET, patch_edge_offset);
+		WriteArray(buffer, header, PATCH_EDGE, patch_edge);
+
+		std::ofstream fout(file_name.c_str(), std::ios::binary);
+		if(fout.fail())
+		{
+			std::cerr << "Error : cannot open patch file " << file_name << " for writing!" << std::endl;
+			return false;
+		}
+		fout.write(&buffer[0], buffer.size());
+		return !fout.fail();
+	}
+
+	bool LoadPatchLayout(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout)
+	{
+		layout.ClearData();
+		MappedFile file;
+		if(!OpenLayoutFile(file_name, file)) return false;
+
+		bool ok = false;
+		if(IsBinaryLayout(file))
+		{
+			ok = ParsePatchLayoutBinary(file_name, file, vert_num, face_num, layout);
+		}else
+		{
+			PatchLayoutTextReader reader(file_name, file);
+			ok = ParsePatchLayoutText(reader, vert_num, face_num, layout);
+		}
+		if(!ok) layout.ClearData();
+		return ok;
+	}
+
+	bool RemapPatchLayout(PatchLayout& layout, const std::vector<int>& vert_rank, const std::vector<int>& face_rank)
+	{
+		struct Remap
+		{
+			static bool Apply(int& index, const std::vector<int>& rank)
+			{
+				if(rank.empty()) return true;
+				if(index < 0 || index >= (int) rank.size() || rank[index] < 0) return false;
+				index = rank[index];
+				return true;
+			}
+		};
+
+		for(size_t k=0; k<layout.m_patch_conner_array.size(); ++k){
+			if(!Remap::Apply(layout.m_patch_conner_array[k].m_mesh_index, vert_rank)) return false;
+		}
+		for(size_t k=0; k<layout.m_patch_edge_array.size(); ++k){
+			std::vector<int>& path = layout.m_patch_edge_array[k].m_mesh_path;
+			for(size_t i=0; i<path.size(); ++i){
+				if(!Remap::Apply(path[i], vert_rank)) return false;
+			}
+		}
+		for(size_t k=0; k<layout.m_patch_array.size(); ++k){
+			std::vector<int>& face = layout.m_patch_array[k].m_face_index_array;
+			for(size_t i=0; i<face.size(); ++i){
+				if(!Remap::Apply(face[i], face_rank)) return false;
+			}
+		}
+		return true;
+	}
+
+	bool ConvertPatchLayoutFile(const std::string& in_file, const std::string& out_file)
+	{
+		PatchLayout layout;
+		if(!LoadPatchLayout(in_file, -1, -1, layout)) return false;
+
+		std::string ext(PATCH_LAYOUT_BINARY_EXT);
+		bool to_binary = out_file.size() >= ext.size()
+			&& out_file.compare(out_file.size() - ext.size(), ext.size(), ext) == 0;
+		return to_binary ? SavePatchLayoutBinary(out_file, layout) : SavePatchLayoutText(out_file, layout);
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef PATCHLAYOUTIO_H_
+#define PATCHLAYOUTIO_H_
+
+#include "ParamPatch.h"
+
+#include <vector>
+#include <string>
+
+namespace PARAM
+{
+	//! patch conners, patch edges and patches of a patch layout file
+	class PatchLayout
+	{
+	public:
+		PatchLayout(){}
+		~PatchLayout(){}
+
+		void ClearData();
+
+	public:
+		std::vector<PatchConner> m_patch_conner_array;
+		std::vector<PatchEdge> m_patch_edge_array;
+		std::vector<ParamPatch> m_patch_array;
+	};
+
+	/*
+	 * Text layout, the format read by ChartCreator::LoadPatchFile:
+	 *   conner_num, then per conner: type mesh_index nb_num (nb_conner nb_edge)*nb_num
+	 *   edge_num, then per edge: conner_1 conner_2 nb_num nb_patch*nb_num path_num path_vert*path_num
+	 *   patch_num, then per patch: face_num face*face_num edge_num edge*edge_num
+	 * The file is read in one buffered pass. Every index is checked against the
+	 * mesh (vert_num, face_num, a negative number skips the check) and against
+	 * the layout itself, an error is reported with its line and column.
+	 */
+	bool LoadPatchLayoutText(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout);
+	bool SavePatchLayoutText(const std::string& file_name, const PatchLayout& layout);
+
+	/*
+	 * Binary layout, a fixed header followed by 8 byte aligned int arrays,
+	 * variable length lists are stored as offset and value arrays. All the
+	 * arrays are at fixed offsets so the file can be mapped as it is.
+	 */
+	bool LoadPatchLayoutBinary(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout);
+	bool SavePatchLayoutBinary(const std::string& file_name, const PatchLayout& layout);
+
+	//! load either form, the binary form is recognized by its magic
+	bool LoadPatchLayout(const std::string& file_name, int vert_num, int face_num, PatchLayout& layout);
+
+	//! move the mesh indices of a layout from the file order to the mesh order of a
+	//! reordered mesh, rank[i] is the mesh index of file element i and an empty rank
+	//! keeps the indices. Fails when an index has no mesh element
+	bool RemapPatchLayout(PatchLayout& layout, const std::vector<int>& vert_rank, const std::vector<int>& face_rank);
+
+	//! convert between the text and binary forms, the output is binary when
+	//! out_file ends with PATCH_LAYOUT_BINARY_EXT and text otherwise
+	bool ConvertPatchLayoutFile(const std::string& in_file, const std::string& out_file);
+
+	extern const char* const PATCH_LAYOUT_BINARY_EXT;
+}
+
+#endif // PATCHLAYOUTIO_H_
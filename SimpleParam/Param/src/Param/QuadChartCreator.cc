@@ -122,7 +122,7 @@ namespace PARAM
 	bool QuadChartCreator::FloodFillFaceAPatch(int init_fid, std::vector<bool>& face_visited_flag,
 		const std::map< std::pair<int, int>, std::vector<int> >& me_pe_mapping)	
 	{
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		std::set<int> visited_face_set;
 		std::queue<int> q;
 		q.push(init_fid);
@@ -134,7 +134,7 @@ namespace PARAM
 		{
 			int cur_fid = q.front(); q.pop();
 
-			const IndexArray& face_vertices = face_list[cur_fid];
+			const int* face_vertices = face_info.GetFaceVertices(cur_fid);
 			for(int k=0; k<3; ++k)
 			{
 				int vid1 = face_vertices[k], vid2 = face_vertices[(k+1)%3];
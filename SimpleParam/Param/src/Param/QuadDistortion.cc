@@ -19,7 +19,7 @@ namespace PARAM
 		boost::shared_ptr<MeshModel> p_mesh = m_quad_parameter.GetMeshModel();
 		assert(p_mesh != NULL);
 		
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		size_t face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 
 		m_face_harmonic_distortion.clear(); m_face_harmonic_distortion.resize(face_num);
@@ -37,17 +37,13 @@ namespace PARAM
 	zjucad::matrix::matrix<double> QuadDistortion::ComputeParamJacobiMatrix(int fid) const
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_quad_parameter.GetMeshModel();
-		const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& faces = face_list_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* faces = face_info.GetFaceVertices(fid);
 
 		// Algorithm : Sig2007 parameterization course, p40, equation(4.8)  
-		std::vector<Coord> tri_vert_coord_3d(3);
-		for(size_t k=0; k<3; ++k) tri_vert_coord_3d[k] = vert_coord_array[faces[k]];
+		const Coord2D* local_coord = &(p_mesh->m_OperatorCache.GetFaceLocalCoord())[fid*3];
 
-		std::vector<Coord2D> local_coord = ComputeTriangleLocal2DCoord(tri_vert_coord_3d);
-
-		double area_2 = 2*(p_mesh->m_Kernel.GetFaceInfo().GetFaceArea())[fid];
+		double area_2 = 2*(p_mesh->m_OperatorCache.GetFaceArea())[fid];
 
 		/// get these three vertices's parameter coordinate
 		int chart_id = m_quad_parameter.FindBestChartIDForTriShape(fid);
@@ -29,7 +29,7 @@ namespace PARAM
 		p_mesh = mesh;
 
 		size_t vertex_num = p_mesh->m_Kernel.GetVertexInfo().GetCoord().size();
-		size_t face_num =  p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num =  p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 
 		m_vertex_group.clear();
 		m_face_group.clear();
@@ -133,8 +133,8 @@ namespace PARAM
 			}
 		}
 		
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		size_t face_num = face_index_array.size(); 
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		size_t face_num = face_info.GetFaceNum(); 
 
 		vector<bool> face_visited_flag(face_num, false);
 		int chart_id = 0;
@@ -333,7 +333,7 @@ namespace PARAM
 	int QuadParam::FloodFillChart(int face_id, std::set<int>& face_set, std::set<int>& quad_path_set,
 		std::vector<bool>& face_visited_flag, const std::map< std::pair<int,int>, vector<int> >& edge_pid_mapping)
 	{
-		PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		queue<int> q;
 		q.push(face_id);
@@ -344,11 +344,11 @@ namespace PARAM
 			int fid = q.front(); q.pop();
 			face_set.insert(fid);
 
-			IndexArray& faces = face_index_array[fid];
-			for(size_t k=0; k<faces.size(); ++k)
+			const int* faces = face_info.GetFaceVertices(fid);
+			for(size_t k=0; k<face_info.GetFaceDegree(fid); ++k)
 			{
 				int vtx1 = faces[k];
-				int vtx2 = faces[(k+1)%faces.size()];
+				int vtx2 = faces[(k+1)%face_info.GetFaceDegree(fid)];
 
 				pair<int, int> edge = make_pair(vtx1, vtx2);
 				map< pair<int, int>, vector<int> >::const_iterator im = edge_pid_mapping.find(edge);
@@ -1185,15 +1185,15 @@ namespace PARAM
 
 	void QuadParam::SetFaceGroup(std::vector<int>& face_group)
 	{
-		const PolyIndexArray& faceIndexArray = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		//
-		size_t face_num = faceIndexArray.size();
+		size_t face_num = face_info.GetFaceNum();
 		face_group.resize(face_num);
 		fill(face_group.begin(), face_group.end(), -1);
 		for (size_t i = 0; i < face_num; ++i)
 		{
-			const IndexArray& face_ = faceIndexArray[i];
+			const int* face_ = face_info.GetFaceVertices(i);
 			vector<int> chart_id_vec;
 			for (size_t j = 0; j < 3; j++)
 			{
@@ -1221,7 +1221,7 @@ namespace PARAM
 		PolyTexCoordArray& faceTexCoord = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
 
 		//
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 		faceTexCoord.resize(face_num);
 
 		m_face_tex_flag.clear();
@@ -1240,22 +1240,22 @@ namespace PARAM
 	void QuadParam::SetChartTexture(int chart_id, std::vector<int>& face_group)
 	{
 		PolyTexCoordArray& faceTexCoord = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
-		const PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& fInfo = p_mesh->m_Kernel.GetFaceInfo();
  
 		size_t i, k;
 		double sValue, tValue;
 
-	   size_t face_num = fIndex.size();
+	   size_t face_num = fInfo.GetFaceNum();
 	   
 		for (i = 0; i < face_num; ++i)
 		{
 			if (face_group[i] == chart_id && !m_face_tex_flag[i]) 
 			{
-				const IndexArray& face = fIndex[i];
+				const int* face = fInfo.GetFaceVertices(i);
 				TexCoordArray& face_tex = faceTexCoord[i];
 				face_tex.clear();
 
-				for (k = 0; k < face.size(); k++)
+				for (k = 0; k < fInfo.GetFaceDegree(i); k++)
 				{
 					const VertexID& vID = face[k];
 					sValue = m_param_coord[vID].s_coord;
@@ -1344,9 +1344,9 @@ namespace PARAM
 	void QuadParam::SetCotCoef()
 	{
 		const CoordArray& vCoord = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& fInfo = p_mesh->m_Kernel.GetFaceInfo();
 
-		size_t nFace = fIndex.size();
+		size_t nFace = fInfo.GetFaceNum();
 		m_cot_coef_vec.clear();
 		m_cot_coef_vec.resize(nFace);
 
@@ -1355,7 +1355,7 @@ namespace PARAM
 		double a[3];
 		for(i = 0; i < nFace; ++ i)
 		{
-			const IndexArray& f = fIndex[i];
+			const int* f = fInfo.GetFaceVertices(i);
 			for(j = 0; j < 3; ++ j)
 			{
 				e[j] = (vCoord[f[(j+1)%3]] - vCoord[f[j]]).unit();
@@ -1398,8 +1398,8 @@ namespace PARAM
 			{
 				FaceID fID1 = adjf[(j+n-1)%n];
 				FaceID fID2 = adjf[j];
-				const IndexArray& f1 = fIndex[fID1];
-				const IndexArray& f2 = fIndex[fID2];
+				const int* f1 = fInfo.GetFaceVertices(fID1);
+				const int* f2 = fInfo.GetFaceVertices(fID2);
 				for( k = 0; k < 3; ++ k)
 				{
 					if(f1[k] == i)
@@ -1423,7 +1423,7 @@ namespace PARAM
 	void QuadParam::SetLapMatrix()
 	{
 		PolyIndexArray& vAdjFaces = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-		PolyIndexArray& fIndex = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& fInfo = p_mesh->m_Kernel.GetFaceInfo();
 
 		int i, j, k, n;
 		int fID, vID;
@@ -1444,7 +1444,7 @@ namespace PARAM
 			for (j = 0; j < n; j++)
 			{
 				fID = adjFaces[j];
-				IndexArray& f = fIndex[fID];
+				const int* f = fInfo.GetFaceVertices(fID);
 
 				// Find the position of vertex i in face fID
 				for(k = 0; k < 3; ++ k)
@@ -1613,7 +1613,7 @@ namespace PARAM
 
 	void QuadParam::ComputeDistortion()
 	{
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 		m_local_distortion.clear(); 
 		m_local_distortion.resize(face_num);
 
@@ -1642,11 +1642,11 @@ namespace PARAM
 
 	void QuadParam::ComputeAllChartDistortion()
 	{
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		const DoubleArray& face_area_array = p_mesh->m_Kernel.GetFaceInfo().GetFaceArea();
 		const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-		size_t face_num = face_index_array.size();
+		size_t face_num = face_info.GetFaceNum();
 		m_local_distortion.clear(); 
 		m_local_distortion.resize(face_num);
 
@@ -1654,7 +1654,7 @@ namespace PARAM
 		{
 			int chart_id = m_face_tex_group[k];
 				
-			const IndexArray& face_vtx = face_index_array[k];
+			const int* face_vtx = face_info.GetFaceVertices(k);
 			double area = face_area_array[k];
 			double distort = 0.0;
 
@@ -1725,17 +1725,17 @@ namespace PARAM
 
 	void QuadParam::ComputeChartDistortion(int chart_id, const std::vector<int>& face_group)
 	{
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		const DoubleArray& face_area_array = p_mesh->m_Kernel.GetFaceInfo().GetFaceArea();
 		const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
 
-		size_t face_num = face_index_array.size();
+		size_t face_num = face_info.GetFaceNum();
 
 		for(size_t k=0; k<face_num; ++k)
 		{
 			if(face_group[k] == chart_id)
 			{
-				const IndexArray& face_vtx = face_index_array[k];
+				const int* face_vtx = face_info.GetFaceVertices(k);
 				double area = face_area_array[k];
 				double distort = 0.0;
 				for(size_t i=0; i<3; ++i)
@@ -1812,7 +1812,7 @@ namespace PARAM
 			{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
 		};
 
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 		ColorArray& colorArray = p_mesh->m_Kernel.GetFaceInfo().GetColor();
 		colorArray.clear();
 		colorArray.resize(face_num);
@@ -1978,7 +1978,7 @@ namespace PARAM
 		color.m_S = 0.9f;
 		color.m_V = 0.9f;
 
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 
 		double min = 1e20, max = -1e20;
 		for(size_t i = 0; i < face_num; ++i)
@@ -2087,7 +2087,7 @@ namespace PARAM
 		std::set<int> visited_face_set;
 
 		const PolyIndexArray& vert_adjface_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-		const PolyIndexArray& face_index_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		
 		const vector<int>& chart_vertices = m_chart_array[chart_id];
 
@@ -2100,8 +2100,8 @@ namespace PARAM
 				int fid = nb_faces[i];
 				if(visited_face_set.find(fid) != visited_face_set.end()) continue;
 				visited_face_set.insert(fid);
-				const IndexArray& face_vertices = face_index_array[fid];
-				vector<ParamCoord> node_param_coord(face_vertices.size());
+				const int* face_vertices = face_info.GetFaceVertices(fid);
+				vector<ParamCoord> node_param_coord(face_info.GetFaceDegree(fid));
 				for(int j=0; j<3; ++j)
 				{
 					int cur_vid = face_vertices[j];
@@ -118,7 +118,7 @@ namespace PARAM
 			{0, 0, 128}, {0, 0, 64}, {64, 0, 64}, {64, 0, 128}, 
 		};
 
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 		ColorArray& colorArray = p_mesh->m_Kernel.GetFaceInfo().GetColor();
 		colorArray.clear();
 		colorArray.resize(face_num);
@@ -592,12 +592,12 @@ namespace PARAM
 	{
 		const std::vector<QuadChart>& quad_chart_array = p_quad_chart_creator->GetQuadChartArray();
 
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
-		size_t face_num = face_list_array.size();
+		size_t face_num = face_info.GetFaceNum();
 		for (size_t i = 0; i < face_num; ++i)
 		{
-			const IndexArray& faces= face_list_array[i];
+			const int* faces = face_info.GetFaceVertices(i);
 			std::vector<int> chart_id_vec;
 			for (size_t j = 0; j < 3; j++)
 			{
@@ -687,17 +687,17 @@ namespace PARAM
 	void QuadParameter::SetMeshFaceTextureCoord()
 	{
 		PolyTexCoordArray& face_texcoord_array = p_mesh->m_Kernel.GetFaceInfo().GetTexCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
-		size_t face_num = face_list_array.size();
+		size_t face_num = face_info.GetFaceNum();
 		face_texcoord_array.clear(); face_texcoord_array.resize(face_num);
 
-		for(size_t fid = 0; fid < face_list_array.size(); ++fid)
+		for(size_t fid = 0; fid < face_info.GetFaceNum(); ++fid)
 		{
 			TexCoordArray& face_tex = face_texcoord_array[fid];
 			face_tex.clear(); face_tex.resize(3);
 
-			const IndexArray& faces = face_list_array[fid];			
+			const int* faces = face_info.GetFaceVertices(fid);			
 			int face_chart_id = m_face_chart_array[fid];
 			face_chart_id = FindBestChartIDForTriShape(fid);
 
@@ -746,8 +746,8 @@ namespace PARAM
 
 	int QuadParameter::FindBestChartIDForTriShape(int fid) const
 	{
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& faces = face_list_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* faces = face_info.GetFaceVertices(fid);
 
 		int c_0 = m_vert_chart_array[faces[0]];
 		int c_1 = m_vert_chart_array[faces[1]];
@@ -853,7 +853,7 @@ namespace PARAM
 		}
 
 		const PolyIndexArray& vert_adj_face_array = p_mesh->m_Kernel.GetVertexInfo().GetAdjFaces();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 
 		const std::vector<int>& vertics_array = m_chart_vertices_array[chart_id];
 		
@@ -872,7 +872,7 @@ namespace PARAM
 				if(!face_visited_flag[fid])
 				{
 					std::vector<ParamCoord> vert_param_coord(3);
-					const IndexArray& faces = face_list_array[fid];
+					const int* faces = face_info.GetFaceVertices(fid);
 					for(size_t j=0; j<3; ++j)
 					{
 						vert_param_coord[j] = m_vert_param_coord_array[faces[j]];
@@ -912,7 +912,7 @@ namespace PARAM
 		color.m_S = 0.9f;
 		color.m_V = 0.9f;
 
-		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetIndex().size();
+		size_t face_num = p_mesh->m_Kernel.GetFaceInfo().GetFaceNum();
 
 		double min = 1e20, max = -1e20;
 		for(size_t i = 0; i < face_num; ++i)
@@ -0,0 +1,41 @@
+#ifndef SOLVEMONITOR_H_
+#define SOLVEMONITOR_H_
+
+#include <vector>
+#include <cstddef>
+
+namespace PARAM
+{
+	//! stages of a long running solve, as reported to a SolveMonitor
+	enum SolveStage
+	{
+		SOLVE_STAGE_SETUP = 0,			//! initial chart layout and matrices
+		SOLVE_STAGE_SOLVE,				//! one linear solve of the parameter coordinates
+		SOLVE_STAGE_ADJUST,				//! moving out range vertices to the neighbor charts
+		SOLVE_STAGE_CORRESPONDING,		//! locating the vertices of one surface on the other
+		SOLVE_STAGE_FINISH
+	};
+
+	//! observer of a long running solve. all the calls come from the solving thread,
+	//! the solver checks IsCanceled() between its iterations and returns early once it is set
+	class SolveMonitor
+	{
+	public:
+		virtual ~SolveMonitor() {}
+
+		virtual bool IsCanceled() = 0;
+
+		//! residual is the stage's own measure: the rms change of the parameter coordinates
+		//! for SOLVE_STAGE_SOLVE, the number of moved vertices for SOLVE_STAGE_ADJUST and
+		//! the done fraction for SOLVE_STAGE_CORRESPONDING
+		virtual void ReportProgress(int stage, int iteration, double residual) = 0;
+
+		//! buffer for the parameter coordinates after an iteration, (s0, t0, s1, t1, s2, t2)
+		//! per face as Parameter::GatherFaceParamCoord, NULL when no preview is wanted.
+		//! PublishSnapshot() hands the filled buffer over
+		virtual std::vector<double>* GetSnapshotBuffer() { return NULL; }
+		virtual void PublishSnapshot() {}
+	};
+}
+
+#endif //SOLVEMONITOR_H_
@@ -4,8 +4,6 @@
 #include <hj_3rd/zjucad/matrix/lapack.h>
 
 #include <map>
-#include <set>
-#include <queue>
 #include <iostream>
 #include <limits>
 
@@ -75,50 +73,8 @@ namespace PARAM
 
 	bool TransFunctor::GetTranslistBetweenTwoCharts(int from_chart_id, int to_chart_id, std::vector<int>& trans_list) const
 	{
-		trans_list.clear();
-
-		const std::vector<ParamPatch>& patch_array = p_chart_creator->GetPatchArray();
-
-		std::set<int> visited_face_set;
-		std::map<int, int> prev_chart_map;
-
-		std::queue<int> q;
-		q.push(to_chart_id);
-		visited_face_set.insert(to_chart_id);
-		prev_chart_map[to_chart_id] = -1;
-        
-		bool flag = false;
-		while(!q.empty())
-		{
-			int cur_chart_id = q.front(); q.pop();
-			if(cur_chart_id == from_chart_id) { flag = true; break;}
-
-			const std::vector<int>& adj_charts = patch_array[cur_chart_id].m_nb_patch_index_array;
-			
-			for(size_t k=0; k<adj_charts.size(); ++k)
-			{
-				int chart_id = adj_charts[k];
-				if(visited_face_set.find(chart_id) == visited_face_set.end())
-				{
-					q.push(chart_id);
-					visited_face_set.insert(chart_id);
-					prev_chart_map[chart_id] = cur_chart_id;
-				}
-			}
-		}
-
-		if(!flag) return false;
-
-		trans_list.push_back(from_chart_id);
-		int prev_chart = prev_chart_map[from_chart_id];
-
-		while(prev_chart != -1)
-		{
-			trans_list.push_back(prev_chart);
-			prev_chart = prev_chart_map[prev_chart];
-		}
-
-		return true;
+		/// the routes are precomputed by a breadth first search from every chart
+		return p_chart_creator->GetChartGraph().GetChartChain(from_chart_id, to_chart_id, trans_list);
 	}
 
 	zjucad::matrix::matrix<double> TransFunctor::GetTransMatrixInOneChart(int chart_id, std::pair<int,int> old_x_axis,
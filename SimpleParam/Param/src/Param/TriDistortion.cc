@@ -2,6 +2,7 @@
 #include "Parameter.h"
 #include "Barycentric.h"
 #include "../ModelMesh/MeshModel.h"
+#include "../Common/Parallel.h"
 #include <boost/shared_ptr.hpp>
 
 #include <hj_3rd/hjlib/math/blas_lapack.h>
@@ -10,6 +11,35 @@
 
 namespace PARAM
 {
+	namespace
+	{
+		class FaceDistortionFunctor
+		{
+		public:
+			FaceDistortionFunctor(const std::vector<Coord2D>& _local_coord, const DoubleArray& _face_area,
+				const std::vector<double>& _face_param_coord, std::vector<double>& _harmonic_distortion, 
+				std::vector<double>& _isometric_distortion)
+				: local_coord(_local_coord), face_area(_face_area), face_param_coord(_face_param_coord),
+				harmonic_distortion(_harmonic_distortion), isometric_distortion(_isometric_distortion) {}
+
+			void operator()(int fid) const
+			{
+				double jacobi_mat[4];
+				TriDistortion::ComputeParamJacobiMatrix(&local_coord[fid*3], 2*face_area[fid], 
+					&face_param_coord[fid*6], jacobi_mat);
+				harmonic_distortion[fid] = TriDistortion::ComputeHarmonicDistortion(jacobi_mat);
+				isometric_distortion[fid] = TriDistortion::ComputeIsometricDistortion(jacobi_mat);
+			}
+
+		private:
+			const std::vector<Coord2D>& local_coord;
+			const DoubleArray& face_area;
+			const std::vector<double>& face_param_coord;
+			std::vector<double>& harmonic_distortion;
+			std::vector<double>& isometric_distortion;
+		};
+	}
+
 	TriDistortion::TriDistortion(const Parameter& parameter) 
 		: m_parameter(parameter){}
 	TriDistortion::~TriDistortion(){}
@@ -19,35 +49,60 @@ namespace PARAM
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
 		assert(p_mesh != NULL);
 
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
 		size_t face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 
 		m_face_harmonic_distortion.clear(); m_face_harmonic_distortion.resize(face_num);
 		m_face_isometric_distortion.clear(); m_face_isometric_distortion.resize(face_num);
 
-		for(size_t fid = 0; fid < face_num; ++fid)
+		std::vector<double> face_param_coord;
+		m_parameter.GatherFaceParamCoord(face_param_coord);
+
+		parallel_for(0, (int) face_num, FaceDistortionFunctor(p_mesh->m_OperatorCache.GetFaceLocalCoord(),
+			p_mesh->m_OperatorCache.GetFaceArea(), face_param_coord, m_face_harmonic_distortion, 
+			m_face_isometric_distortion));
+	}
+
+	void TriDistortion::ComputeParamJacobiMatrix(const Coord2D* local_coord, double area_2, 
+		const double* param_coord, double* jacobi_mat)
+	{
+		/// J = 1/(2A) * [0 -1; 1 0] * [x2-x1 x0-x2 x1-x0; y2-y1 y0-y2 y1-y0] * [u v]
+		double dx[3], dy[3];
+		for(int k=0; k<3; ++k)
 		{
-			zjucad::matrix::matrix<double> jacobi_mat = ComputeParamJacobiMatrix(fid);
-			m_face_harmonic_distortion[fid] = ComputeHarmonicDistortion(jacobi_mat);
-			m_face_isometric_distortion[fid] = ComputeIsometricDistortion(jacobi_mat);
+			dx[k] = local_coord[(k+2)%3][0] - local_coord[(k+1)%3][0];
+			dy[k] = local_coord[(k+2)%3][1] - local_coord[(k+1)%3][1];
 		}
 
+		double u_dx(0), v_dx(0), u_dy(0), v_dy(0);
+		for(int k=0; k<3; ++k)
+		{
+			u_dx += dx[k]*param_coord[2*k]; v_dx += dx[k]*param_coord[2*k+1];
+			u_dy += dy[k]*param_coord[2*k]; v_dy += dy[k]*param_coord[2*k+1];
+		}
+
+		jacobi_mat[0] = -u_dy / area_2; jacobi_mat[1] = -v_dy / area_2;
+		jacobi_mat[2] =  u_dx / area_2; jacobi_mat[3] =  v_dx / area_2;
+	}
+
+	void TriDistortion::ComputeSingularValue(const double* mat, double& s1, double& s2)
+	{
+		double e = (mat[0] + mat[3]) / 2, f = (mat[0] - mat[3]) / 2;
+		double g = (mat[2] + mat[1]) / 2, h = (mat[2] - mat[1]) / 2;
+		double q = sqrt(e*e + h*h), r = sqrt(f*f + g*g);
+		s1 = q + r;
+		s2 = fabs(q - r);
 	}
 
 	zjucad::matrix::matrix<double> TriDistortion::ComputeParamJacobiMatrix(int fid) const
 	{
 		boost::shared_ptr<MeshModel> p_mesh = m_parameter.GetMeshModel();
-		const CoordArray& vert_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& faces = face_list_array[fid];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* faces = face_info.GetFaceVertices(fid);
 
 		// Algorithm : Sig2007 parameterization course, p40, equation(4.8)  
-		std::vector<Coord> tri_vert_coord_3d(3);
-		for(size_t k=0; k<3; ++k) tri_vert_coord_3d[k] = vert_coord_array[faces[k]];
+		const Coord2D* local_coord = &(p_mesh->m_OperatorCache.GetFaceLocalCoord())[fid*3];
 
-		std::vector<Coord2D> local_coord = ComputeTriangleLocal2DCoord(tri_vert_coord_3d);
-
-		double area_2 = 2*(p_mesh->m_Kernel.GetFaceInfo().GetFaceArea())[fid];
+		double area_2 = 2*(p_mesh->m_OperatorCache.GetFaceArea())[fid];
 
 		/// get these three vertices's parameter coordinate
 		int chart_id = m_parameter.GetFaceChartID(fid);
@@ -125,19 +180,17 @@ namespace PARAM
 		return tmp * tm_2;
 	}
 
-	double TriDistortion::ComputeHarmonicDistortion(const zjucad::matrix::matrix<double>& jacobi_mat) const
+	double TriDistortion::ComputeHarmonicDistortion(const double* jacobi_mat)
 	{
-		zjucad::matrix::matrix<double> J_tJ = trans(jacobi_mat) * jacobi_mat;
-
-		return 0.5*(J_tJ(0, 0) + J_tJ(1, 1));
+		/// half of the trace of J^t*J
+		return 0.5*(jacobi_mat[0]*jacobi_mat[0] + jacobi_mat[1]*jacobi_mat[1] + 
+			jacobi_mat[2]*jacobi_mat[2] + jacobi_mat[3]*jacobi_mat[3]);
 	}
 
-	double TriDistortion::ComputeIsometricDistortion(const zjucad::matrix::matrix<double>& jacobi_mat) const
+	double TriDistortion::ComputeIsometricDistortion(const double* jacobi_mat)
 	{
-		zjucad::matrix::matrix<double> a = jacobi_mat;
-		zjucad::matrix::matrix<double> u, s, vt;
-		svd(a, u, s, vt);
-		return fabs(s(0, 0) - 1) + fabs(s(1, 1) - 1);
-		return norm( trans(jacobi_mat) * jacobi_mat - zjucad::matrix::eye<double>(2));
+		double s1, s2;
+		ComputeSingularValue(jacobi_mat, s1, s2);
+		return fabs(s1 - 1) + fabs(s2 - 1);
 	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef TRIDISTORTION_H_
 #define TRIDISTORTION_H_
 
+#include "../Common/BasicDataType.h"
 #include <hj_3rd/zjucad/matrix/matrix.h>
 #include <vector>
 
@@ -24,10 +25,16 @@ namespace PARAM
 		//! compute the jacobi matrix from surface to parameter domain
 		zjucad::matrix::matrix<double> ComputeParamJacobiMatrix(int fid) const;
 
+		//! jacobi matrix (2x2, row major) of a face from its local frame coordinates, twice its area
+		//! and its three vertices's parameter coordinates (s0, t0, s1, t1, s2, t2)
+		static void ComputeParamJacobiMatrix(const Coord2D* local_coord, double area_2, 
+			const double* param_coord, double* jacobi_mat);
 
-	private:
-		double ComputeHarmonicDistortion(const zjucad::matrix::matrix<double>& jacobi_mat) const;
-		double ComputeIsometricDistortion(const zjucad::matrix::matrix<double>& jacobi_mat) const;		
+		//! singular values of a 2x2 row major matrix, s1 >= s2 >= 0
+		static void ComputeSingularValue(const double* mat, double& s1, double& s2);
+
+		static double ComputeHarmonicDistortion(const double* jacobi_mat);
+		static double ComputeIsometricDistortion(const double* jacobi_mat);
 
 	private:
 		const Parameter& m_parameter;
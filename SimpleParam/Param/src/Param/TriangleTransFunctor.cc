@@ -61,9 +61,9 @@ namespace PARAM
 
 	zjucad::matrix::matrix<double> TriTransFunctor::GetTransMatrixOfAdjCharts(int from_chart_id, int to_chart_id) const
 	{
-		const PolyIndexArray& face_list = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
-		const IndexArray& face_1 = face_list[from_chart_id];
-		const IndexArray& face_2 = face_list[to_chart_id];
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
+		const int* face_1 = face_info.GetFaceVertices(from_chart_id);
+		const int* face_2 = face_info.GetFaceVertices(to_chart_id);
 
 		/// find the common edge of these two faces
 		pair<int, int> com_edge_idx_1, com_edge_idx_2;
@@ -100,11 +100,7 @@ namespace PARAM
 		zjucad::matrix::matrix<double> r_mat( zjucad::matrix::eye<double>(3));
 
 		/// Get this triangle's local 2d frame
-		const CoordArray& vtx_coord_array = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
-		const IndexArray& face = (p_mesh->m_Kernel.GetFaceInfo().GetIndex())[chart_id];
-		vector<Coord> tri_vtx_coord_array(3);
-		for(int k=0; k<3; ++k) tri_vtx_coord_array[k] = vtx_coord_array[face[k]];
-		vector<Coord2D> local_coord_array = ComputeTriangleLocal2DCoord(tri_vtx_coord_array);
+		const Coord2D* local_coord_array = &(p_mesh->m_OperatorCache.GetFaceLocalCoord())[chart_id*3];
 
 		int old_origin_idx = old_x_index.first;
 		int new_origin_idx = new_x_index.first;
@@ -226,7 +222,7 @@ namespace PARAM
 
 	void TriTransFunctor::SetChartNeighbors()
 	{
-		const PolyIndexArray& face_list_array = p_mesh->m_Kernel.GetFaceInfo().GetIndex();
+		const FaceInfo& face_info = p_mesh->m_Kernel.GetFaceInfo();
 		int face_num = p_mesh->m_Kernel.GetModelInfo().GetFaceNum();
 
 		m_neighbor_charts.clear();
@@ -236,7 +232,7 @@ namespace PARAM
 
 		for(int fid=0; fid < face_num; ++fid)
 		{
-			const IndexArray& vertices = face_list_array[fid];
+			const int* vertices = face_info.GetFaceVertices(fid);
 			for(int i=0; i<3; ++i)
 			{
 				int vid1 = vertices[i];
@@ -248,7 +244,7 @@ namespace PARAM
 
 		for(int fid=0; fid < face_num; ++fid)
 		{
-			const IndexArray& vertices = face_list_array[fid];
+			const int* vertices = face_info.GetFaceVertices(fid);
 			m_neighbor_charts[fid].clear(); 			
 			for(int i=0; i<3; ++i)
 			{
@@ -0,0 +1,176 @@
+#include "TestUtil.h"
+#include "../Param/ChartCreator.h"
+#include "../Param/PatchLayoutIO.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <string>
+#include <boost/shared_ptr.hpp>
+
+TEST_MAIN_COUNTER;
+
+// Grid vertices from (i0, j0) to (i1, j1) along a grid line
+static std::vector<int> GridPath(int nx, int i0, int j0, int i1, int j1)
+{
+    std::vector<int> path;
+    int di = (i1 > i0) - (i1 < i0), dj = (j1 > j0) - (j1 < j0);
+    for(int i = i0, j = j0; ; i += di, j += dj)
+    {
+        path.push_back(j*(nx+1) + i);
+        if(i == i1 && j == j1)
+            break;
+    }
+    return path;
+}
+
+static void AddEdge(PARAM::PatchLayout& layout, int c1, int c2, const std::vector<int>& path,
+                    int patch1, int patch2 = -1)
+{
+    PARAM::PatchEdge edge;
+    edge.m_conner_pair_index = std::make_pair(c1, c2);
+    edge.m_mesh_path = path;
+    edge.m_nb_patch_index_array.push_back(patch1);
+    if(patch2 >= 0)
+        edge.m_nb_patch_index_array.push_back(patch2);
+    layout.m_patch_edge_array.push_back(edge);
+
+    int e = (int) layout.m_patch_edge_array.size() - 1;
+    layout.m_patch_conner_array[c1].m_nb_conner_index_array.push_back(c2);
+    layout.m_patch_conner_array[c1].m_nb_edge_index_array.push_back(e);
+    layout.m_patch_conner_array[c2].m_nb_conner_index_array.push_back(c1);
+    layout.m_patch_conner_array[c2].m_nb_edge_index_array.push_back(e);
+}
+
+// The nx * ny grid cut along the grid line x = cx into a left and a right
+// patch, both without their faces. The edges of a patch run ccw, the right
+// patch comes first in the file when right_first is set
+static void CreateTwoPatchLayout(int nx, int ny, int cx, bool right_first, PARAM::PatchLayout& layout)
+{
+    int left = right_first ? 1 : 0, right = 1 - left;
+    const int conner_vert[6][2] = { {0, 0}, {cx, 0}, {cx, ny}, {0, ny}, {nx, 0}, {nx, ny} };
+
+    layout.ClearData();
+    layout.m_patch_conner_array.resize(6);
+    for(int k = 0; k < 6; ++ k)
+    {
+        layout.m_patch_conner_array[k].m_conner_type = 1;
+        layout.m_patch_conner_array[k].m_mesh_index = conner_vert[k][1]*(nx+1) + conner_vert[k][0];
+    }
+    AddEdge(layout, 0, 1, GridPath(nx, 0, 0, cx, 0), left);
+    AddEdge(layout, 1, 2, GridPath(nx, cx, 0, cx, ny), left, right);
+    AddEdge(layout, 2, 3, GridPath(nx, cx, ny, 0, ny), left);
+    AddEdge(layout, 3, 0, GridPath(nx, 0, ny, 0, 0), left);
+    AddEdge(layout, 1, 4, GridPath(nx, cx, 0, nx, 0), right);
+    AddEdge(layout, 4, 5, GridPath(nx, nx, 0, nx, ny), right);
+    AddEdge(layout, 5, 2, GridPath(nx, nx, ny, cx, ny), right);
+
+    const int left_edge[4] = {0, 1, 2, 3}, right_edge[4] = {4, 5, 6, 1};
+    layout.m_patch_array.resize(2);
+    layout.m_patch_array[left].m_edge_index_array.assign(left_edge, left_edge + 4);
+    layout.m_patch_array[right].m_edge_index_array.assign(right_edge, right_edge + 4);
+}
+
+// Loads the layout on the grid and fills the patch faces, face_patch[f] is
+// the patch holding face f or -1
+static bool FillGridPatches(int nx, int ny, int cx, bool right_first, std::vector<int>& face_patch,
+                            std::vector< std::vector<int> >& patch_edge)
+{
+    boost::shared_ptr<MeshModel> p_mesh(new MeshModel);
+    CreateGridModel(*p_mesh, nx, ny, (double) nx, (double) ny);
+
+    PARAM::PatchLayout layout;
+    CreateTwoPatchLayout(nx, ny, cx, right_first, layout);
+    std::string file = GetTestTempDir("ChartCreatorTest") + "/grid_layout.txt";
+    if(!PARAM::SavePatchLayoutText(file, layout))
+        return false;
+
+    PARAM::ChartCreator creator(p_mesh);
+    if(!creator.LoadPatchFile(file) || !creator.FormParamCharts())
+        return false;
+
+    const std::vector<PARAM::ParamPatch>& patch_array = creator.GetPatchArray();
+    face_patch.assign(2*nx*ny, -1);
+    patch_edge.clear();
+    for(size_t k = 0; k < patch_array.size(); ++ k)
+    {
+        const std::vector<int>& faces = patch_array[k].m_face_index_array;
+        for(size_t i = 0; i < faces.size(); ++ i)
+            face_patch[faces[i]] = (int) k;
+        patch_edge.push_back(patch_array[k].m_edge_index_array);
+    }
+    return creator.GetChartNumber() == 2;
+}
+
+// Quad (i, j) of the grid holds faces 2*(j*nx + i) and 2*(j*nx + i) + 1, the
+// faces left of the cut go to the left patch and the patch ids are the file's
+static void CheckGridLabels(int nx, int ny, int cx)
+{
+    for(int order = 0; order < 2; ++ order)
+    {
+        bool right_first = (order == 1);
+        int left = right_first ? 1 : 0;
+        std::vector<int> face_patch;
+        std::vector< std::vector<int> > patch_edge;
+        TEST_CHECK(FillGridPatches(nx, ny, cx, right_first, face_patch, patch_edge));
+
+        bool label_ok = (int) face_patch.size() == 2*nx*ny;
+        for(int f = 0; f < (int) face_patch.size() && label_ok; ++ f)
+        {
+            int i = (f/2) % nx;
+            label_ok = face_patch[f] == (i < cx ? left : 1 - left);
+        }
+        TEST_CHECK(label_ok);
+        TEST_CHECK(patch_edge.size() == 2 && patch_edge[left][0] == 0 && patch_edge[1-left][0] == 4);
+    }
+}
+
+// A small grid fits in one range of the union-find
+static void TestSmallGrid()
+{
+    CheckGridLabels(4, 2, 2);
+    CheckGridLabels(5, 3, 1);
+}
+
+// A grid over two ranges is united across them, the labels do not depend on
+// the thread number
+static void TestLargeGrid()
+{
+    CheckGridLabels(240, 160, 100);
+
+    std::vector<int> face_patch, serial_patch;
+    std::vector< std::vector<int> > patch_edge;
+    TEST_CHECK(FillGridPatches(240, 160, 100, false, face_patch, patch_edge));
+    ParallelRuntime runtime(1);
+    {
+        ParallelRuntimeScope scope(runtime);
+        TEST_CHECK(FillGridPatches(240, 160, 100, false, serial_patch, patch_edge));
+    }
+    TEST_CHECK(serial_patch == face_patch);
+}
+
+// The middle edge jumps from vertex 2 to vertex 12 and cuts no mesh edge,
+// both patches fall in one region and the fill fails
+static void TestUnseparatedPatches()
+{
+    boost::shared_ptr<MeshModel> p_mesh(new MeshModel);
+    CreateGridModel(*p_mesh, 4, 2, 4.0, 2.0);
+
+    PARAM::PatchLayout layout;
+    CreateTwoPatchLayout(4, 2, 2, false, layout);
+    layout.m_patch_edge_array[1].m_mesh_path.assign(1, 2);
+    layout.m_patch_edge_array[1].m_mesh_path.push_back(12);
+    std::string file = GetTestTempDir("ChartCreatorTest") + "/open_layout.txt";
+    TEST_CHECK(PARAM::SavePatchLayoutText(file, layout));
+
+    PARAM::ChartCreator creator(p_mesh);
+    TEST_CHECK(creator.LoadPatchFile(file));
+    TEST_CHECK(!creator.FormParamCharts());
+}
+
+int main()
+{
+    TestSmallGrid();
+    TestLargeGrid();
+    TestUnseparatedPatches();
+    return TestReport("ChartCreatorTest");
+}
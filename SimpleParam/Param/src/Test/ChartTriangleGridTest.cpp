@@ -0,0 +1,133 @@
+#include "TestUtil.h"
+#include "../Param/ChartTriangleGrid.h"
+
+#include <vector>
+
+TEST_MAIN_COUNTER;
+
+// The n * n quads on [0, 1]^2 cut like CreateGridModel, triangle k is mesh
+// face 100 + k, quad (i, j) holds triangles 2*(j*n + i) (below its diagonal)
+// and 2*(j*n + i) + 1
+static void BuildGrid(int n, std::vector<double>& tri_param_coord, PARAM::ChartTriangleGrid& grid)
+{
+    std::vector<int> face_index_array;
+    tri_param_coord.clear();
+    for(int j = 0; j < n; ++ j)
+    {
+        for(int i = 0; i < n; ++ i)
+        {
+            double s0 = (double) i/n, s1 = (double) (i+1)/n;
+            double t0 = (double) j/n, t1 = (double) (j+1)/n;
+            double lower[6] = { s0, t0, s1, t0, s1, t1 };
+            double upper[6] = { s0, t0, s1, t1, s0, t1 };
+            tri_param_coord.insert(tri_param_coord.end(), lower, lower + 6);
+            tri_param_coord.insert(tri_param_coord.end(), upper, upper + 6);
+            face_index_array.push_back(100 + (int) face_index_array.size());
+            face_index_array.push_back(100 + (int) face_index_array.size());
+        }
+    }
+    grid.Build(face_index_array, tri_param_coord);
+}
+
+// The located triangle's corners weighted by the barycentric give back the query
+static bool LocatesAt(const PARAM::SurfaceLocateResult& result, const std::vector<double>& tri_param_coord,
+                      double s, double t)
+{
+    int k = result.surface_coord.face_index - 100;
+    if(k < 0 || 6*k >= (int) tri_param_coord.size())
+        return false;
+    const double* tri = &tri_param_coord[6*k];
+    const Coord& b = result.surface_coord.barycentric;
+    return std::fabs(b[0]*tri[0] + b[1]*tri[2] + b[2]*tri[4] - s) < 1e-12
+        && std::fabs(b[0]*tri[1] + b[1]*tri[3] + b[2]*tri[5] - t) < 1e-12
+        && std::fabs(b[0] + b[1] + b[2] - 1.0) < 1e-12;
+}
+
+// Points inside a triangle and on the edges between triangles
+static void TestInside()
+{
+    std::vector<double> tri_param_coord;
+    PARAM::ChartTriangleGrid grid;
+    BuildGrid(4, tri_param_coord, grid);
+    PARAM::SurfaceLocateResult result;
+
+    grid.Locate(PARAM::ParamCoord(0.3, 0.1), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_INSIDE);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 3);
+    TEST_CHECK(LocatesAt(result, tri_param_coord, 0.3, 0.1));
+    TEST_CHECK(result.out_range_error == 0);
+
+    // The diagonal of quad (1, 1) and the line s = 0.5 between quads (1, 2)
+    // and (2, 2), the first triangle holding the point wins
+    grid.Locate(PARAM::ParamCoord(0.375, 0.375), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_INSIDE);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 10);
+    TEST_CHECK(LocatesAt(result, tri_param_coord, 0.375, 0.375));
+
+    grid.Locate(PARAM::ParamCoord(0.5, 0.6), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_INSIDE);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 18);
+    TEST_CHECK(LocatesAt(result, tri_param_coord, 0.5, 0.6));
+    TEST_CHECK_NEAR(result.surface_coord.barycentric[0], 0.0, 1e-12);
+
+    // A chart corner
+    grid.Locate(PARAM::ParamCoord(1.0, 1.0), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_INSIDE);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 30);
+}
+
+// Points just off the chart go to the nearest triangle, within the
+// barycentric tolerance they still count as inside
+static void TestOutside()
+{
+    std::vector<double> tri_param_coord;
+    PARAM::ChartTriangleGrid grid;
+    BuildGrid(4, tri_param_coord, grid);
+    PARAM::SurfaceLocateResult result;
+    const double eps = 1e-6;
+
+    grid.Locate(PARAM::ParamCoord(1.0 + eps, 0.6), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_NEAREST);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 22);
+    TEST_CHECK(LocatesAt(result, tri_param_coord, 1.0 + eps, 0.6));
+    TEST_CHECK_NEAR(result.out_range_error, (4*eps)*(4*eps), 1e-15);
+
+    grid.Locate(PARAM::ParamCoord(0.6, -eps), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_NEAREST);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 4);
+    TEST_CHECK(result.out_range_error > 0);
+
+    // Far off a corner the nearest triangle is still found through the cell rings
+    grid.Locate(PARAM::ParamCoord(-2.0, -3.0), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_NEAREST);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 0 || result.surface_coord.face_index == 100 + 1);
+
+    grid.Locate(PARAM::ParamCoord(1.0 + 1e-10, 0.6), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_INSIDE);
+    TEST_CHECK(result.surface_coord.face_index == 100 + 22);
+}
+
+// Degenerate triangles are dropped, a grid without triangles fails
+static void TestDegenerate()
+{
+    std::vector<int> face_index_array(1, 7);
+    std::vector<double> tri_param_coord(6, 0.0);
+    tri_param_coord[2] = 1.0;
+    tri_param_coord[4] = 2.0;
+
+    PARAM::ChartTriangleGrid grid;
+    grid.Build(face_index_array, tri_param_coord);
+    TEST_CHECK(grid.IsEmpty());
+    PARAM::SurfaceLocateResult result;
+    grid.Locate(PARAM::ParamCoord(0.5, 0.0), result);
+    TEST_CHECK(result.state == PARAM::LOCATE_FAILED);
+    TEST_CHECK(result.surface_coord.face_index == -1);
+}
+
+int main()
+{
+    TestInside();
+    TestOutside();
+    TestDegenerate();
+    return TestReport("ChartTriangleGridTest");
+}
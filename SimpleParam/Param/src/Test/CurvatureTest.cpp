@@ -0,0 +1,132 @@
+#include "TestUtil.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <algorithm>
+
+TEST_MAIN_COUNTER;
+
+// Curvature errors on the sphere of the given radius, relative to 1/r and
+// 1/r^2. The six vertices of the octahedron have four neighbors and carry the
+// largest error, which does not go away with refinement
+class SphereCurvatureError
+{
+public:
+    double mean_max, mean_avg;
+    double gauss_max, gauss_avg;
+    double anisotropy_max;
+    bool positive;
+
+    SphereCurvatureError(MeshModel& model, double radius)
+        : mean_max(0), mean_avg(0), gauss_max(0), gauss_avg(0), anisotropy_max(0), positive(true)
+    {
+        const DoubleArray& vMean = model.m_Kernel.GetVertexInfo().GetMeanCurvature();
+        const DoubleArray& vGauss = model.m_Kernel.GetVertexInfo().GetGaussCurvature();
+        const CurvatureArray& vCurvature = model.m_Kernel.GetVertexInfo().GetCurvatures();
+        size_t nVertex = vMean.size();
+        for(size_t i = 0; i < nVertex; ++ i)
+        {
+            double mean_err = fabs(vMean[i]*radius - 1.0);
+            double gauss_err = fabs(vGauss[i]*radius*radius - 1.0);
+            mean_max = std::max(mean_max, mean_err);
+            gauss_max = std::max(gauss_max, gauss_err);
+            mean_avg += mean_err / nVertex;
+            gauss_avg += gauss_err / nVertex;
+            anisotropy_max = std::max(anisotropy_max, (vCurvature[i].m_kmax - vCurvature[i].m_kmin)*radius);
+            positive = positive && vCurvature[i].m_kmin > 0 && vCurvature[i].m_kmin <= vCurvature[i].m_kmax;
+        }
+    }
+};
+
+// The curvature approaches 1/r on average as the sphere is refined, and is
+// right within 20% everywhere
+static void TestSphere()
+{
+    const double radius = 2.0;
+    MeshModel coarse, fine;
+    CreateSphereModel(coarse, 3, radius);
+    CreateSphereModel(fine, 5, radius);
+    SphereCurvatureError coarse_err(coarse, radius), fine_err(fine, radius);
+
+    TEST_CHECK(fine_err.positive);
+    TEST_CHECK(fine_err.mean_avg < 0.02);
+    TEST_CHECK(fine_err.gauss_avg < 0.04);
+    TEST_CHECK(fine_err.mean_max < 0.2);
+    TEST_CHECK(fine_err.gauss_max < 0.35);
+    TEST_CHECK(fine_err.anisotropy_max < 0.2);
+    TEST_CHECK(fine_err.mean_avg < 0.5*coarse_err.mean_avg);
+    TEST_CHECK(fine_err.gauss_avg < 0.5*coarse_err.gauss_avg);
+}
+
+// The principal directions are unit tangents, orthogonal to each other
+static void TestDirections()
+{
+    MeshModel model;
+    CreateSphereModel(model, 4);
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    const CurvatureArray& vCurvature = model.m_Kernel.GetVertexInfo().GetCurvatures();
+
+    double err = 0;
+    for(size_t i = 0; i < vCoord.size(); ++ i)
+    {
+        const Coord& dmin = vCurvature[i].m_direction_kmin;
+        const Coord& dmax = vCurvature[i].m_direction_kmax;
+        err = std::max(err, fabs(dmin.abs() - 1.0));
+        err = std::max(err, fabs(dmax.abs() - 1.0));
+        err = std::max(err, fabs(dot(dmin, dmax)));
+        err = std::max(err, fabs(dot(dmin, vCoord[i])));
+        err = std::max(err, fabs(dot(dmax, vCoord[i])));
+    }
+    TEST_CHECK(err < 0.05);
+}
+
+// Smoothing over a ring lowers the largest error, the curvature scales with
+// 1/r, and the result does not depend on the thread number
+static void TestSmoothAndScale()
+{
+    const double radius = 2.0;
+    MeshModel model, unit;
+    CreateSphereModel(model, 4, radius);
+    CreateSphereModel(unit, 4);
+
+    SphereCurvatureError raw(model, radius);
+    model.m_BasicOp.CalVertexCurvature(1);
+    SphereCurvatureError smooth(model, radius);
+    TEST_CHECK(smooth.mean_max < 0.5*raw.mean_max);
+    TEST_CHECK(smooth.gauss_max < 0.5*raw.gauss_max);
+
+    ParallelRuntime::Instance().SetThreadNum(1);
+    model.m_BasicOp.CalVertexCurvature();
+    DoubleArray Serial = model.m_Kernel.GetVertexInfo().GetMeanCurvature();
+    ParallelRuntime::Instance().SetThreadNum(4);
+    model.m_BasicOp.CalVertexCurvature();
+    TEST_CHECK(Serial == model.m_Kernel.GetVertexInfo().GetMeanCurvature());
+
+    const DoubleArray& vUnitMean = unit.m_Kernel.GetVertexInfo().GetMeanCurvature();
+    double diff = 0;
+    for(size_t i = 0; i < Serial.size(); ++ i)
+        diff = std::max(diff, fabs(Serial[i]*radius - vUnitMean[i]));
+    TEST_CHECK(diff < 1e-9);
+}
+
+// A plane has no curvature
+static void TestPlane()
+{
+    MeshModel model;
+    CreateGridModel(model, 8, 8);
+    const DoubleArray& vMean = model.m_Kernel.GetVertexInfo().GetMeanCurvature();
+    const DoubleArray& vGauss = model.m_Kernel.GetVertexInfo().GetGaussCurvature();
+    double k = 0;
+    for(size_t i = 0; i < vMean.size(); ++ i)
+        k = std::max(k, std::max(fabs(vMean[i]), fabs(vGauss[i])));
+    TEST_CHECK(k < 1e-9);
+}
+
+int main()
+{
+    TestSphere();
+    TestDirections();
+    TestSmoothAndScale();
+    TestPlane();
+    return TestReport("CurvatureTest");
+}
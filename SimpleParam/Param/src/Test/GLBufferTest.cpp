@@ -0,0 +1,185 @@
+#include "TestUtil.h"
+#include "../OpenGL/GLBuffer.h"
+#include "../ModelMesh/MeshModelRenderBuffer.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <vector>
+
+TEST_MAIN_COUNTER;
+
+typedef GLboolean (APIENTRY *IsBufferProc)(GLuint buffer);
+
+static const int WIDTH = 64, HEIGHT = 64;
+
+// Headless context on an EGL pbuffer, e.g. Mesa llvmpipe without a display
+class HeadlessContext
+{
+public:
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+
+    HeadlessContext() : display(EGL_NO_DISPLAY), surface(EGL_NO_SURFACE), context(EGL_NO_CONTEXT)
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC GetPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        display = GetPlatformDisplay ? GetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL)
+                                     : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint major, minor;
+        if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        {
+            display = EGL_NO_DISPLAY;
+            return;
+        }
+
+        const EGLint config_attrib[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint config_num = 0;
+        if(!eglChooseConfig(display, config_attrib, &config, 1, &config_num) || config_num < 1)
+            return;
+        const EGLint surface_attrib[] = { EGL_WIDTH, WIDTH, EGL_HEIGHT, HEIGHT, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surface_attrib);
+        eglBindAPI(EGL_OPENGL_API);
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+        if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT)
+            return;
+        MakeCurrent();
+    }
+
+    ~HeadlessContext()
+    {
+        if(display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        if(surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+
+    bool IsValid() const { return context != EGL_NO_CONTEXT && surface != EGL_NO_SURFACE; }
+    void MakeCurrent() { eglMakeCurrent(display, surface, surface, context); }
+    void DoneCurrent() { eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); }
+};
+
+// [0, 1]^2 fills the viewport
+static void BeginFrame()
+{
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_LIGHTING);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, 1, 0, 1, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+static void ReadPixel(int x, int y, unsigned char rgb[3])
+{
+    unsigned char rgba[4];
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    rgb[0] = rgba[0]; rgb[1] = rgba[1]; rgb[2] = rgba[2];
+}
+
+static bool IsPixel(int x, int y, int r, int g, int b)
+{
+    unsigned char rgb[3];
+    ReadPixel(x, y, rgb);
+    return rgb[0] == r && rgb[1] == g && rgb[2] == b;
+}
+
+static void TestVertexBatch()
+{
+    GLVertexBatch batch;
+    batch.AddVertex(Coord(0, 0, 0), Color(1.0, 0.0, 0.0));
+    batch.AddVertex(Coord(1, 0, 0), Color(1.0, 0.0, 0.0));
+    batch.AddVertex(Coord(0, 1, 0), Color(1.0, 0.0, 0.0));
+
+    BeginFrame();
+    batch.Draw(GL_TRIANGLES);
+    TEST_CHECK(IsPixel(8, 8, 255, 0, 0));
+    TEST_CHECK(IsPixel(56, 56, 0, 0, 0));
+
+    // A changed batch is uploaded again
+    batch.ClearData();
+    batch.AddVertex(Coord(1, 1, 0), Color(0.0, 1.0, 0.0));
+    batch.AddVertex(Coord(0, 1, 0), Color(0.0, 1.0, 0.0));
+    batch.AddVertex(Coord(1, 0, 0), Color(0.0, 1.0, 0.0));
+    BeginFrame();
+    batch.Draw(GL_TRIANGLES);
+    TEST_CHECK(IsPixel(8, 8, 0, 0, 0));
+    TEST_CHECK(IsPixel(56, 56, 0, 255, 0));
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+}
+
+static void TestRenderBuffer()
+{
+    MeshModel model;
+    CreateGridModel(model, 4, 4);
+    ColorArray& face_color = model.m_Kernel.GetFaceInfo().GetColor();
+    face_color.assign(model.m_Kernel.GetModelInfo().GetFaceNum(), Color(0.0, 0.0, 1.0));
+
+    MeshModelRenderBuffer buffer;
+    buffer.AttachKernel(&model.m_Kernel);
+    BeginFrame();
+    TEST_CHECK(buffer.DrawCornerFaces(RENDER_ARRAY_COLOR));
+    TEST_CHECK(IsPixel(20, 40, 0, 0, 255));
+
+    // In-place colors show after Invalidate
+    face_color.assign(face_color.size(), Color(1.0, 1.0, 0.0));
+    buffer.Invalidate(RENDER_BUFFER_COLOR);
+    BeginFrame();
+    TEST_CHECK(buffer.DrawCornerFaces(RENDER_ARRAY_COLOR));
+    TEST_CHECK(IsPixel(20, 40, 255, 255, 0));
+    TEST_CHECK(glGetError() == GL_NO_ERROR);
+}
+
+static void TestRelease(HeadlessContext& context)
+{
+    IsBufferProc IsBuffer = (IsBufferProc) eglGetProcAddress("glIsBuffer");
+    TEST_CHECK(IsBuffer != NULL);
+    if(IsBuffer == NULL)
+        return;
+
+    const float data[3] = { 1, 2, 3 };
+    GLuint id = 0;
+    {
+        GLBuffer buffer;
+        buffer.Upload(data, sizeof(data));
+        id = buffer.GetId();
+        TEST_CHECK(id != 0);
+        TEST_CHECK(IsBuffer(id));
+    }
+    // Freed by the destructor
+    TEST_CHECK(!IsBuffer(id));
+
+    // Without a current context the destructor leaves the name to its context
+    GLBuffer* pBuffer = new GLBuffer;
+    pBuffer->Upload(data, sizeof(data));
+    id = pBuffer->GetId();
+    context.DoneCurrent();
+    delete pBuffer;
+    context.MakeCurrent();
+    TEST_CHECK(IsBuffer(id));
+}
+
+int main()
+{
+    HeadlessContext context;
+    if(!context.IsValid())
+    {
+        std::cout << "GLBufferTest: no EGL context, skipped" << std::endl;
+        return 0;
+    }
+    TEST_CHECK(GLBuffer::IsSupported());
+
+    TestVertexBatch();
+    TestRenderBuffer();
+    TestRelease(context);
+    return TestReport("GLBufferTest");
+}
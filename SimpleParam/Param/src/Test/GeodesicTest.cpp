@@ -0,0 +1,171 @@
+#include "TestUtil.h"
+
+#include <vector>
+#include <algorithm>
+
+TEST_MAIN_COUNTER;
+
+// Great circle distance on the sphere of the given radius around the origin
+static double SphereDistance(const Coord& a, const Coord& b, double radius)
+{
+    double c = dot(a, b) / (radius*radius);
+    return radius * acos(std::max(-1.0, std::min(1.0, c)));
+}
+
+// Largest and mean error of the distances from vertex vSource
+static void DistanceError(MeshModel& model, VertexID vSource, double radius, double& max_err, double& mean_err)
+{
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    DoubleArray VtxDist;
+    TEST_CHECK(model.m_Geodesic.ComputeDistance(IndexArray(1, vSource), VtxDist));
+    TEST_CHECK(VtxDist.size() == vCoord.size());
+
+    max_err = mean_err = 0;
+    for(size_t i = 0; i < vCoord.size() && i < VtxDist.size(); ++ i)
+    {
+        double err = fabs(VtxDist[i] - SphereDistance(vCoord[vSource], vCoord[i], radius));
+        max_err = std::max(max_err, err);
+        mean_err += err;
+    }
+    mean_err /= vCoord.size();
+}
+
+// The distances from a pole approach the great circle distances as the
+// sphere is refined
+static void TestSphere()
+{
+    const double radius = 2.0;
+    double max_err[2], mean_err[2];
+    for(int k = 0; k < 2; ++ k)
+    {
+        MeshModel model;
+        CreateSphereModel(model, 4 + k, radius);
+        DistanceError(model, 4, radius, max_err[k], mean_err[k]);
+    }
+    TEST_CHECK(max_err[1] < 0.02*PI*radius);
+    TEST_CHECK(mean_err[1] < 0.01*PI*radius);
+    TEST_CHECK(max_err[1] < 0.75*max_err[0]);
+    TEST_CHECK(mean_err[1] < 0.75*mean_err[0]);
+}
+
+// Several source sets at once give what they give one by one, a source set
+// of two vertices gives the nearer one's distance
+static void TestSourceSets()
+{
+    MeshModel model;
+    CreateSphereModel(model, 4);
+
+    std::vector<IndexArray> SourceSets(3);
+    SourceSets[0].push_back(0);
+    SourceSets[1].push_back(5);
+    SourceSets[2].push_back(0);
+    SourceSets[2].push_back(1);
+    std::vector<DoubleArray> Dists;
+    TEST_CHECK(model.m_Geodesic.ComputeDistance(SourceSets, Dists));
+    TEST_CHECK(Dists.size() == 3);
+    if(Dists.size() != 3)
+        return;
+
+    double diff = 0;
+    for(int k = 0; k < 3; ++ k)
+    {
+        DoubleArray VtxDist;
+        model.m_Geodesic.ComputeDistance(SourceSets[k], VtxDist);
+        for(size_t i = 0; i < VtxDist.size(); ++ i)
+            diff = std::max(diff, fabs(VtxDist[i] - Dists[k][i]));
+    }
+    TEST_CHECK(diff < 1e-12);
+
+    // (1, 0, 0) and (-1, 0, 0) are antipodal, no point is farther than a
+    // quarter circle from both
+    TEST_CHECK(Dists[2][0] == 0.0 && Dists[2][1] == 0.0);
+    TEST_CHECK(*std::max_element(Dists[2].begin(), Dists[2].end()) < 0.5*PI*1.05);
+}
+
+// A sphere without a source is out of reach
+static void TestComponents()
+{
+    MeshModel sphere;
+    CreateSphereModel(sphere, 3);
+    CoordArray Coords = sphere.m_Kernel.GetVertexInfo().GetCoord();
+    PolyIndexArray Faces;
+    sphere.m_Kernel.GetFaceInfo().CopyIndex(Faces);
+    int nVertex = (int) Coords.size(), nFace = (int) Faces.size();
+    for(int i = 0; i < nVertex; ++ i)
+        Coords.push_back(Coords[i] + Coord(3, 0, 0));
+    for(int f = 0; f < nFace; ++ f)
+    {
+        IndexArray face = Faces[f];
+        for(size_t k = 0; k < face.size(); ++ k)
+            face[k] += nVertex;
+        Faces.push_back(face);
+    }
+
+    MeshModel model;
+    model.CreateModel(Coords, Faces);
+    DoubleArray VtxDist;
+    TEST_CHECK(model.m_Geodesic.ComputeDistance(IndexArray(1, 4), VtxDist));
+    TEST_CHECK(VtxDist[4] == 0.0);
+    TEST_CHECK(VtxDist[5] > 0.9*PI && VtxDist[5] < 1.1*PI);
+    TEST_CHECK(VtxDist[nVertex + 4] == INFINITE_DISTANCE);
+    TEST_CHECK(VtxDist[2*nVertex - 1] == INFINITE_DISTANCE);
+}
+
+// The path from (1, 0, 0) to the pole follows a quarter circle over
+// neighboring vertices
+static void TestShortestPath()
+{
+    MeshModel model;
+    CreateSphereModel(model, 4);
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    const PolyIndexArray& vAdjVertices = model.m_Kernel.GetVertexInfo().GetAdjVertices();
+
+    IndexArray Path;
+    model.m_Geodesic.GetShortestPath(0, 4, Path);
+    TEST_CHECK(Path.size() > 2);
+    if(Path.size() < 2)
+        return;
+    TEST_CHECK(Path.front() == 0 && Path.back() == 4);
+
+    double length = 0;
+    bool adjacent = true;
+    for(size_t i = 1; i < Path.size(); ++ i)
+    {
+        const IndexArray& adj = vAdjVertices[Path[i-1]];
+        adjacent = adjacent && std::find(adj.begin(), adj.end(), Path[i]) != adj.end();
+        length += (vCoord[Path[i]] - vCoord[Path[i-1]]).abs();
+    }
+    TEST_CHECK(adjacent);
+    TEST_CHECK(length <= 0.5*PI);
+    TEST_CHECK(length > 0.98*0.5*PI);
+}
+
+// Scaling the model by 2 doubles the distances once the kernel reports the change
+static void TestInvalidate()
+{
+    MeshModel model;
+    CreateSphereModel(model, 3);
+    DoubleArray Before, After;
+    model.m_Geodesic.ComputeDistance(IndexArray(1, 4), Before);
+
+    CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    for(size_t i = 0; i < vCoord.size(); ++ i)
+        vCoord[i] *= 2.0;
+    model.m_Kernel.IncModifyCount();
+    model.m_Geodesic.ComputeDistance(IndexArray(1, 4), After);
+
+    double diff = 0;
+    for(size_t i = 0; i < Before.size(); ++ i)
+        diff = std::max(diff, fabs(After[i] - 2.0*Before[i]));
+    TEST_CHECK(diff < 1e-9);
+}
+
+int main()
+{
+    TestSphere();
+    TestSourceSets();
+    TestComponents();
+    TestShortestPath();
+    TestInvalidate();
+    return TestReport("GeodesicTest");
+}
@@ -0,0 +1,328 @@
+#include "TestUtil.h"
+#include "../Param/PatchLayoutIO.h"
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+TEST_MAIN_COUNTER;
+
+static bool SameFaces(const FaceInfo& fInfo, const PolyIndexArray& Faces)
+{
+    if(fInfo.GetFaceNum() != (int) Faces.size())
+        return false;
+    for(int i = 0; i < fInfo.GetFaceNum(); ++ i)
+    {
+        IndexArray face;
+        fInfo.GetFace(i, face);
+        if(face != Faces[i])
+            return false;
+    }
+    return true;
+}
+
+// A triangle model keeps its faces only in the flat store, an edit through
+// GetIndex() moves them out and BuildTriIndex() back
+static void TestTriangleStore()
+{
+    MeshModel model;
+    CreateGridModel(model, 4, 3);
+    FaceInfo& fInfo = model.m_Kernel.GetFaceInfo();
+    TEST_CHECK(fInfo.HasTriIndex());
+    TEST_CHECK(fInfo.GetTriIndex().size() == 3*24);
+
+    PolyIndexArray Faces;
+    fInfo.CopyIndex(Faces);
+    TEST_CHECK(SameFaces(fInfo, Faces));
+    TEST_CHECK(fInfo.HasTriIndex());
+
+    PolyIndexArray& fIndex = fInfo.GetIndex();
+    TEST_CHECK(!fInfo.HasTriIndex());
+    TEST_CHECK(fIndex == Faces);
+    std::rotate(fIndex[0].begin(), fIndex[0].begin()+1, fIndex[0].end());
+    std::rotate(Faces[0].begin(), Faces[0].begin()+1, Faces[0].end());
+
+    TEST_CHECK(fInfo.BuildTriIndex());
+    TEST_CHECK(fInfo.HasTriIndex());
+    TEST_CHECK(SameFaces(fInfo, Faces));
+
+    // The loader fills the flat store directly
+    std::string file = GetTestTempDir("MeshModelTest") + "/grid.off";
+    model.StoreModel(file);
+    MeshModel loaded;
+    loaded.AttachModel(file);
+    TEST_CHECK(loaded.m_Kernel.GetFaceInfo().HasTriIndex());
+    TEST_CHECK(SameFaces(loaded.m_Kernel.GetFaceInfo(), Faces));
+}
+
+// A model with a polygon keeps all faces in m_Index
+static void TestPolygonStore()
+{
+    CoordArray Coords;
+    Coords.push_back(Coord(0, 0, 0));
+    Coords.push_back(Coord(1, 0, 0));
+    Coords.push_back(Coord(1, 1, 0));
+    Coords.push_back(Coord(0, 1, 0));
+    Coords.push_back(Coord(2, 0, 0));
+    int quad[4] = {0, 1, 2, 3}, tri[3] = {1, 4, 2};
+
+    FaceInfo fInfo;
+    fInfo.ReserveFaces(2);
+    fInfo.AddFace(tri, 3);
+    TEST_CHECK(fInfo.HasTriIndex());
+    fInfo.AddFace(quad, 4);
+    TEST_CHECK(!fInfo.HasTriIndex());
+    TEST_CHECK(!fInfo.BuildTriIndex());
+    TEST_CHECK(fInfo.GetFaceNum() == 2);
+    TEST_CHECK(fInfo.GetFaceDegree(0) == 3 && fInfo.GetFaceDegree(1) == 4);
+    TEST_CHECK(fInfo.GetFaceVertices(1)[3] == 3);
+
+    MeshModel model;
+    PolyIndexArray Faces;
+    fInfo.CopyIndex(Faces);
+    model.CreateModel(Coords, Faces);
+    TEST_CHECK(!model.m_Kernel.GetFaceInfo().HasTriIndex());
+    TEST_CHECK(SameFaces(model.m_Kernel.GetFaceInfo(), Faces));
+}
+
+static std::string ReadFileText(const std::string& file_name)
+{
+    std::ifstream fin(file_name.c_str());
+    std::ostringstream oss;
+    oss << fin.rdbuf();
+    return oss.str();
+}
+
+// A reordered model maps its elements to the file order and back, stores
+// them in the file order and moves a layout of the file order onto itself
+static void TestReorderRoundTrip()
+{
+    std::string dir = GetTestTempDir("MeshModelTest");
+    MeshModel sphere;
+    CreateSphereModel(sphere, 2);
+    sphere.StoreModel(dir + "/sphere.off");
+
+    MeshModel file, model;
+    file.AttachModel(dir + "/sphere.off");
+    model.AttachModel(dir + "/sphere.off");
+    model.ReorderModel();
+
+    ModelInfo& mInfo = model.m_Kernel.GetModelInfo();
+    const FaceInfo& fFile = file.m_Kernel.GetFaceInfo();
+    const FaceInfo& fModel = model.m_Kernel.GetFaceInfo();
+    const CoordArray& vFile = file.m_Kernel.GetVertexInfo().GetCoord();
+    const CoordArray& vModel = model.m_Kernel.GetVertexInfo().GetCoord();
+    int nVertex = (int) vModel.size(), nFace = fModel.GetFaceNum();
+    TEST_CHECK(mInfo.IsReordered());
+    TEST_CHECK(mInfo.GetFileVertexNum() == nVertex && mInfo.GetFileFaceNum() == nFace);
+
+    bool vtx_ok = true, face_ok = true, moved = false;
+    for(int i = 0; i < nVertex; ++ i)
+    {
+        int k = mInfo.GetFileVertexID(i);
+        vtx_ok = vtx_ok && mInfo.GetModelVertexID(k) == i && vModel[i] == vFile[k];
+        moved = moved || k != i;
+    }
+    for(int i = 0; i < nFace; ++ i)
+    {
+        int k = mInfo.GetFileFaceID(i);
+        face_ok = face_ok && mInfo.GetModelFaceID(k) == i;
+        for(int j = 0; j < 3 && face_ok; ++ j)
+            face_ok = mInfo.GetFileVertexID(fModel.GetFaceVertices(i)[j]) == fFile.GetFaceVertices(k)[j];
+    }
+    TEST_CHECK(vtx_ok);
+    TEST_CHECK(face_ok);
+    TEST_CHECK(moved);
+    TEST_CHECK(mInfo.GetModelFaceID(nFace) == -1 && mInfo.GetFileFaceID(-1) == -1);
+
+    // The stored file is the loaded one
+    model.StoreModel(dir + "/sphere_reordered.off");
+    TEST_CHECK(ReadFileText(dir + "/sphere_reordered.off") == ReadFileText(dir + "/sphere.off"));
+
+    // A layout of the file order lands on the same elements of the model
+    PARAM::PatchLayout layout;
+    layout.m_patch_conner_array.resize(2);
+    layout.m_patch_conner_array[0].m_mesh_index = 0;
+    layout.m_patch_conner_array[1].m_mesh_index = nVertex - 1;
+    layout.m_patch_edge_array.resize(1);
+    layout.m_patch_edge_array[0].m_mesh_path.push_back(1);
+    layout.m_patch_edge_array[0].m_mesh_path.push_back(2);
+    layout.m_patch_array.resize(1);
+    for(int k = 0; k < nFace; k += 7)
+        layout.m_patch_array[0].m_face_index_array.push_back(k);
+    PARAM::PatchLayout file_layout = layout;
+    TEST_CHECK(PARAM::RemapPatchLayout(layout, mInfo.GetVertexRank(), mInfo.GetFaceRank()));
+    TEST_CHECK(mInfo.GetFileVertexID(layout.m_patch_conner_array[1].m_mesh_index) == nVertex - 1);
+    TEST_CHECK(mInfo.GetFileVertexID(layout.m_patch_edge_array[0].m_mesh_path[1]) == 2);
+    const std::vector<int>& faces = layout.m_patch_array[0].m_face_index_array;
+    bool layout_ok = true;
+    for(size_t i = 0; i < faces.size(); ++ i)
+        layout_ok = layout_ok && mInfo.GetFileFaceID(faces[i]) == file_layout.m_patch_array[0].m_face_index_array[i];
+    TEST_CHECK(layout_ok);
+
+    file_layout.m_patch_array[0].m_face_index_array.push_back(nFace);
+    TEST_CHECK(!PARAM::RemapPatchLayout(file_layout, mInfo.GetVertexRank(), mInfo.GetFaceRank()));
+}
+
+// A compacted model keeps the file numbers, its removed faces map to -1
+static void TestCompactFileOrder()
+{
+    MeshModel model;
+    CreateGridModel(model, 2, 1);
+    model.m_Kernel.GetFaceInfo().GetFlag()[3] = FLAG_INVALID;
+    model.CompactModel();
+
+    ModelInfo& mInfo = model.m_Kernel.GetModelInfo();
+    TEST_CHECK(model.m_Kernel.GetFaceInfo().GetFaceNum() == 3);
+    TEST_CHECK(mInfo.GetFaceNum() == 3);
+    TEST_CHECK(mInfo.GetFileFaceNum() == 4);
+    TEST_CHECK(mInfo.GetModelFaceID(3) == -1);
+    TEST_CHECK(mInfo.GetModelFaceID(2) == 2 && mInfo.GetFileFaceID(2) == 2);
+
+    PARAM::PatchLayout layout;
+    layout.m_patch_array.resize(1);
+    layout.m_patch_array[0].m_face_index_array.push_back(3);
+    TEST_CHECK(!PARAM::RemapPatchLayout(layout, mInfo.GetVertexRank(), mInfo.GetFaceRank()));
+}
+
+// The invariants of the edge table: sorted unique edges, face corners and
+// vertices mapped to the edges they touch, faces on the side of their half
+// edge. Returns the number of edges with one face
+static int CheckEdgeTable(MeshModel& model)
+{
+    EdgeInfo& eInfo = model.m_Kernel.GetEdgeInfo();
+    const FaceInfo& fInfo = model.m_Kernel.GetFaceInfo();
+    const IndexArray& eVtx = eInfo.GetVertexIndex();
+    const IndexArray& eFace = eInfo.GetFaceIndex();
+    const IndexArray& fEdgeOffset = eInfo.GetFaceEdgeOffset();
+    const IndexArray& fEdge = eInfo.GetFaceEdge();
+    const IndexArray& vEdgeOffset = eInfo.GetVertexEdgeOffset();
+    const IndexArray& vEdge = eInfo.GetVertexEdge();
+    int nVertex = (int) model.m_Kernel.GetVertexInfo().GetCoord().size();
+    int nFace = fInfo.GetFaceNum();
+    int nEdge = (int) eInfo.GetEdgeNum();
+
+    bool sorted = eFace.size() == eVtx.size();
+    for(int e = 0; e < nEdge && sorted; ++ e)
+    {
+        sorted = eVtx[2*e] < eVtx[2*e+1] && eVtx[2*e+1] < nVertex;
+        if(e > 0)
+            sorted = sorted && std::make_pair(eVtx[2*e-2], eVtx[2*e-1]) < std::make_pair(eVtx[2*e], eVtx[2*e+1]);
+    }
+    TEST_CHECK(sorted);
+
+    // Corner j of face f starts the edge to corner j+1, the face is on the
+    // first side of the edge when it runs from the smaller vertex
+    bool face_ok = (int) fEdgeOffset.size() == nFace + 1 && fEdgeOffset[0] == 0;
+    for(int f = 0; f < nFace && face_ok; ++ f)
+    {
+        int n = fInfo.GetFaceDegree(f);
+        const int* face = fInfo.GetFaceVertices(f);
+        face_ok = fEdgeOffset[f+1] - fEdgeOffset[f] == n;
+        for(int j = 0; j < n && face_ok; ++ j)
+        {
+            int e = fEdge[fEdgeOffset[f] + j];
+            int v1 = face[j], v2 = face[(j+1)%n];
+            face_ok = e >= 0 && e < nEdge && std::min(v1, v2) == eVtx[2*e] && std::max(v1, v2) == eVtx[2*e+1]
+                && eFace[2*e + (v1 < v2 ? 0 : 1)] == f;
+        }
+    }
+    TEST_CHECK(face_ok && (int) fEdge.size() == fEdgeOffset[nFace]);
+
+    // Each edge is listed once under each of its vertices
+    bool vtx_ok = (int) vEdgeOffset.size() == nVertex + 1 && vEdgeOffset[0] == 0
+        && vEdgeOffset[nVertex] == 2*nEdge && (int) vEdge.size() == 2*nEdge;
+    std::vector<int> count(nEdge, 0);
+    for(int v = 0; v < nVertex && vtx_ok; ++ v)
+    {
+        vtx_ok = vEdgeOffset[v] <= vEdgeOffset[v+1];
+        for(int k = vEdgeOffset[v]; k < vEdgeOffset[v+1] && vtx_ok; ++ k)
+        {
+            int e = vEdge[k];
+            vtx_ok = e >= 0 && e < nEdge && (eVtx[2*e] == v || eVtx[2*e+1] == v);
+            if(vtx_ok)
+                ++ count[e];
+        }
+    }
+    TEST_CHECK(vtx_ok && std::count(count.begin(), count.end(), 2) == nEdge);
+
+    int nBoundary = 0;
+    bool side_ok = true;
+    for(int e = 0; e < nEdge; ++ e)
+    {
+        side_ok = side_ok && (eFace[2*e] >= 0 || eFace[2*e+1] >= 0);
+        if(eFace[2*e] < 0 || eFace[2*e+1] < 0)
+            ++ nBoundary;
+    }
+    TEST_CHECK(side_ok);
+    return nBoundary;
+}
+
+// The edge table of a closed, an open and a polygon model, the edges with
+// one face are the model's boundary
+static void TestEdgeTable()
+{
+    MeshModel sphere;
+    CreateSphereModel(sphere, 2);
+    int nFace = sphere.m_Kernel.GetFaceInfo().GetFaceNum();
+    TEST_CHECK(CheckEdgeTable(sphere) == 0);
+    TEST_CHECK((int) sphere.m_Kernel.GetEdgeInfo().GetEdgeNum() == 3*nFace/2);
+
+    int nx = 4, ny = 3;
+    MeshModel grid;
+    CreateGridModel(grid, nx, ny);
+    TEST_CHECK(CheckEdgeTable(grid) == 2*(nx + ny));
+    TEST_CHECK((int) grid.m_Kernel.GetEdgeInfo().GetEdgeNum() == nx*(ny+1) + ny*(nx+1) + nx*ny);
+
+    // The boundary loop runs over the edges with one face
+    EdgeInfo& eInfo = grid.m_Kernel.GetEdgeInfo();
+    const IndexArray& eVtx = eInfo.GetVertexIndex();
+    const IndexArray& eFace = eInfo.GetFaceIndex();
+    std::vector< std::pair<int, int> > table_edge, loop_edge;
+    for(int e = 0; e < (int) eInfo.GetEdgeNum(); ++ e)
+        if(eFace[2*e] < 0 || eFace[2*e+1] < 0)
+            table_edge.push_back(std::make_pair(eVtx[2*e], eVtx[2*e+1]));
+    ModelInfo& mInfo = grid.m_Kernel.GetModelInfo();
+    TEST_CHECK(mInfo.GetBoundaryNum() == 1);
+    if(mInfo.GetBoundaryNum() == 1)
+    {
+        const IndexArray& loop = mInfo.GetBoundary()[0];
+        for(size_t i = 0; i < loop.size(); ++ i)
+        {
+            int v1 = loop[i], v2 = loop[(i+1)%loop.size()];
+            loop_edge.push_back(std::make_pair(std::min(v1, v2), std::max(v1, v2)));
+        }
+        std::sort(loop_edge.begin(), loop_edge.end());
+    }
+    TEST_CHECK(loop_edge == table_edge);
+
+    // A quad and a triangle sharing the edge (1, 2)
+    CoordArray Coords;
+    Coords.push_back(Coord(0, 0, 0));
+    Coords.push_back(Coord(1, 0, 0));
+    Coords.push_back(Coord(1, 1, 0));
+    Coords.push_back(Coord(0, 1, 0));
+    Coords.push_back(Coord(2, 0, 0));
+    int quad[4] = {0, 1, 2, 3}, tri[3] = {1, 4, 2};
+    PolyIndexArray Faces;
+    Faces.push_back(IndexArray(quad, quad+4));
+    Faces.push_back(IndexArray(tri, tri+3));
+    MeshModel poly;
+    poly.CreateModel(Coords, Faces);
+    TEST_CHECK(CheckEdgeTable(poly) == 5);
+    EdgeInfo& pInfo = poly.m_Kernel.GetEdgeInfo();
+    TEST_CHECK(pInfo.GetEdgeNum() == 6);
+    int shared = pInfo.GetFaceEdge()[pInfo.GetFaceEdgeOffset()[0] + 1];
+    TEST_CHECK(pInfo.GetFaceIndex()[2*shared] == 0 && pInfo.GetFaceIndex()[2*shared+1] == 1);
+}
+
+int main()
+{
+    TestTriangleStore();
+    TestPolygonStore();
+    TestReorderRoundTrip();
+    TestCompactFileOrder();
+    TestEdgeTable();
+    return TestReport("MeshModelTest");
+}
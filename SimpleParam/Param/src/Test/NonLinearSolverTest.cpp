@@ -0,0 +1,110 @@
+#include "TestUtil.h"
+#include "../Numerical/non_linear_solver.h"
+
+#include <vector>
+
+TEST_MAIN_COUNTER;
+
+// f(x, y) = (1-x)^2 + 100 (y-x^2)^2, minimum 0 at (1, 1)
+class RosenbrockStencil : public OGF::Stencil
+{
+public:
+    RosenbrockStencil() : OGF::Stencil(2, 0) {}
+
+    double f(const OGF::Symbolic::Context& args)
+    {
+        double x = args.variables[0], y = args.variables[1];
+        return (1-x)*(1-x) + 100*(y-x*x)*(y-x*x);
+    }
+    double g(int i, const OGF::Symbolic::Context& args)
+    {
+        double x = args.variables[0], y = args.variables[1];
+        if(i == 0)
+            return -2*(1-x) - 400*x*(y-x*x);
+        return 200*(y-x*x);
+    }
+    double G(int i, int j, const OGF::Symbolic::Context& args)
+    {
+        double x = args.variables[0], y = args.variables[1];
+        if(i == 0 && j == 0)
+            return 2 - 400*(y-x*x) + 800*x*x;
+        if(i == 1 && j == 1)
+            return 200;
+        return -400*x;
+    }
+};
+
+// f(x) = x^2 with the sign of the gradient flipped, so no step along the
+// "descent" direction decreases f. Counts its evaluations
+class WrongGradientStencil : public OGF::Stencil
+{
+public:
+    int& nEval;
+    WrongGradientStencil(int& n) : OGF::Stencil(1, 0), nEval(n) {}
+
+    double f(const OGF::Symbolic::Context& args)
+    {
+        ++ nEval;
+        return args.variables[0]*args.variables[0];
+    }
+    double g(int i, const OGF::Symbolic::Context& args) { return -2*args.variables[0]; }
+    double G(int i, int j, const OGF::Symbolic::Context& args) { return -2; }
+};
+
+static void TestLbfgsRosenbrock()
+{
+    NonLinearSolver solver(2);
+    solver.is_printf_info(false);
+    solver.set_solve_method(QUASI_NEWTON);
+    solver.set_gradient_threshold(1e-8);
+
+    solver.begin_equation();
+    int id = solver.declare_stencil(new RosenbrockStencil);
+    solver.begin_stencil_instance(id);
+    solver.stencil_variable(0);
+    solver.stencil_variable(1);
+    solver.end_stencil_instance();
+    solver.end_equation();
+
+    // set_value() would lock the variables, start from (-1.2, 1) instead
+    std::vector<double> init_val(2);
+    init_val[0] = -1.2;
+    init_val[1] = 1.0;
+    solver.set_init_variables_value(init_val);
+    solver.solve();
+
+    TEST_CHECK_NEAR(solver.variable(0).value(), 1.0, 1e-5);
+    TEST_CHECK_NEAR(solver.variable(1).value(), 1.0, 1e-5);
+}
+
+static void TestLbfgsStopsWithoutDecrease()
+{
+    int nEval = 0;
+    NonLinearSolver solver(1);
+    solver.is_printf_info(false);
+    solver.set_solve_method(QUASI_NEWTON);
+    solver.set_gradient_threshold(0);
+
+    solver.begin_equation();
+    int id = solver.declare_stencil(new WrongGradientStencil(nEval));
+    solver.begin_stencil_instance(id);
+    solver.stencil_variable(0);
+    solver.end_stencil_instance();
+    solver.end_equation();
+
+    std::vector<double> init_val(1, 1.0);
+    solver.set_init_variables_value(init_val);
+    solver.solve();
+
+    // The first line search is along -g already, its failure ends the solve
+    // instead of 1000 retries
+    TEST_CHECK(nEval < 100);
+    TEST_CHECK_NEAR(solver.variable(0).value(), 1.0, 1e-12);
+}
+
+int main()
+{
+    TestLbfgsRosenbrock();
+    TestLbfgsStopsWithoutDecrease();
+    return TestReport("NonLinearSolverTest");
+}
@@ -0,0 +1,78 @@
+#include "TestUtil.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+
+TEST_MAIN_COUNTER;
+
+// Asks the operator cache for its operators from every index
+class CacheBody
+{
+public:
+    MeshModel& model;
+    std::vector<const DoubleArray*>& area;
+    std::vector<const std::vector<Coord2D>*>& gradient;
+    CacheBody(MeshModel& m, std::vector<const DoubleArray*>& a, std::vector<const std::vector<Coord2D>*>& g)
+        : model(m), area(a), gradient(g) {}
+
+    void operator()(int i) const
+    {
+        area[i] = &model.m_OperatorCache.GetFaceArea();
+        gradient[i] = &model.m_OperatorCache.GetFaceGradient();
+        model.m_OperatorCache.GetCotLaplacian();
+    }
+};
+
+static double TotalArea(const DoubleArray& face_area)
+{
+    double sum = 0;
+    for(size_t i = 0; i < face_area.size(); ++ i)
+        sum += face_area[i];
+    return sum;
+}
+
+static void TestConcurrentGet()
+{
+    MeshModel model;
+    CreateSphereModel(model, 4);
+
+    // The operators are computed once, while the threads race for them
+    ParallelRuntime::Instance().SetThreadNum(4);
+    std::vector<const DoubleArray*> area(64, (const DoubleArray*) NULL);
+    std::vector<const std::vector<Coord2D>*> gradient(64, (const std::vector<Coord2D>*) NULL);
+    parallel_for(0, 64, CacheBody(model, area, gradient), 1);
+
+    size_t nFace = model.m_Kernel.GetFaceInfo().GetFaceNum();
+    bool ok = true;
+    for(size_t i = 0; i < area.size(); ++ i)
+        ok = ok && area[i] == area[0] && gradient[i] == gradient[0];
+    TEST_CHECK(ok);
+    TEST_CHECK(area[0]->size() == nFace);
+    TEST_CHECK(gradient[0]->size() == 3*nFace);
+
+    // The inscribed polyhedron approaches the sphere area from below
+    double total = TotalArea(*area[0]);
+    TEST_CHECK(total < 4*PI);
+    TEST_CHECK_NEAR(total, 4*PI, 0.05);
+}
+
+static void TestInvalidate()
+{
+    MeshModel model;
+    CreateGridModel(model, 4, 4);
+    TEST_CHECK_NEAR(TotalArea(model.m_OperatorCache.GetFaceArea()), 1.0, 1e-12);
+
+    // Scaling the grid by 2 changes the kernel, the areas are recomputed
+    CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    for(size_t i = 0; i < vCoord.size(); ++ i)
+        vCoord[i] *= 2.0;
+    model.m_Kernel.IncModifyCount();
+    TEST_CHECK_NEAR(TotalArea(model.m_OperatorCache.GetFaceArea()), 4.0, 1e-12);
+}
+
+int main()
+{
+    TestConcurrentGet();
+    TestInvalidate();
+    return TestReport("OperatorCacheTest");
+}
@@ -0,0 +1,213 @@
+#include "TestUtil.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <stdexcept>
+#include <new>
+
+TEST_MAIN_COUNTER;
+
+class SquareBody
+{
+public:
+    std::vector<double>& out;
+    SquareBody(std::vector<double>& o) : out(o) {}
+    void operator()(int i) const { out[i] = (double) i * i; }
+};
+
+class SumBody
+{
+public:
+    double operator()(int begin, int end, double init) const
+    {
+        double sum = init;
+        for(int i = begin; i < end; ++ i)
+            sum += 1.0 / (1.0 + i);
+        return sum;
+    }
+};
+
+class Plus
+{
+public:
+    double operator()(double a, double b) const { return a + b; }
+};
+
+// Throws on one index, counts the others
+class ThrowBody
+{
+public:
+    int bad;
+    bool bad_alloc;
+    ThrowBody(int b, bool ba) : bad(b), bad_alloc(ba) {}
+    void operator()(int i) const
+    {
+        if(i != bad)
+            return;
+        if(bad_alloc)
+            throw std::bad_alloc();
+        throw std::runtime_error("bad index");
+    }
+};
+
+// Throws on index 0, counts and slows down the others
+class CountBody
+{
+public:
+    ParallelMutex& mutex;
+    int& count;
+    CountBody(ParallelMutex& m, int& c) : mutex(m), count(c) {}
+    void operator()(int i) const
+    {
+        if(i == 0)
+            throw std::runtime_error("first index");
+        volatile double x = 0;
+        for(int k = 0; k < 2000; ++ k)
+            x += k;
+        ParallelLock lock(mutex);
+        ++ count;
+    }
+};
+
+// A nested loop inside each index
+class NestedBody
+{
+public:
+    std::vector<double>& out;
+    NestedBody(std::vector<double>& o) : out(o) {}
+    void operator()(int i) const
+    {
+        std::vector<double> inner(64, 0.0);
+        parallel_for(0, 64, SquareBody(inner), 1);
+        double sum = 0;
+        for(size_t k = 0; k < inner.size(); ++ k)
+            sum += inner[k];
+        out[i] = sum;
+    }
+};
+
+// Records the runtime each index runs on
+class RuntimeBody
+{
+public:
+    std::vector<ParallelRuntime*>& out;
+    RuntimeBody(std::vector<ParallelRuntime*>& o) : out(o) {}
+    void operator()(int i) const { out[i] = &ParallelRuntime::Current(); }
+};
+
+static void TestParallelFor(int nThread)
+{
+    ParallelRuntime::Instance().SetThreadNum(nThread);
+    std::vector<double> out(10000, -1.0);
+    parallel_for(0, (int) out.size(), SquareBody(out), 7);
+    bool ok = true;
+    for(size_t i = 0; i < out.size(); ++ i)
+        ok = ok && (out[i] == (double) i * i);
+    TEST_CHECK(ok);
+}
+
+static void TestParallelReduce()
+{
+    // The chunks and their join order do not depend on the thread number
+    ParallelRuntime::Instance().SetThreadNum(1);
+    double serial = parallel_reduce(0, 100000, 0.0, SumBody(), Plus(), 100);
+    ParallelRuntime::Instance().SetThreadNum(4);
+    double parallel = parallel_reduce(0, 100000, 0.0, SumBody(), Plus(), 100);
+    TEST_CHECK(serial == parallel);
+}
+
+static void TestException(int bad, bool bad_alloc)
+{
+    ParallelRuntime::Instance().SetThreadNum(4);
+    bool caught_runtime = false, caught_bad_alloc = false;
+    try
+    {
+        parallel_for(0, 1000, ThrowBody(bad, bad_alloc), 1);
+    }
+    catch(std::bad_alloc&)
+    {
+        caught_bad_alloc = true;
+    }
+    catch(std::runtime_error& e)
+    {
+        caught_runtime = (std::string(e.what()) == "bad index");
+    }
+    TEST_CHECK(caught_bad_alloc == bad_alloc);
+    TEST_CHECK(caught_runtime == !bad_alloc);
+
+    // The runtime is released, the next loop runs normally
+    std::vector<double> out(1000, -1.0);
+    parallel_for(0, 1000, SquareBody(out), 1);
+    TEST_CHECK(out[999] == 999.0 * 999.0);
+}
+
+static void TestCancel()
+{
+    // The chunks not yet started are dropped, those stolen included, so a
+    // throw on the first index stops the loop well before its end
+    ParallelRuntime::Instance().SetThreadNum(4);
+    const int n = 20000;
+    bool all_canceled = true;
+    for(int k = 0; k < 20; ++ k)
+    {
+        ParallelMutex mutex;
+        int count = 0;
+        try
+        {
+            parallel_for(0, n, CountBody(mutex, count), 1);
+        }
+        catch(std::runtime_error&)
+        {
+        }
+        all_canceled = all_canceled && count < n/2;
+    }
+    TEST_CHECK(all_canceled);
+}
+
+static void TestNested()
+{
+    ParallelRuntime::Instance().SetThreadNum(4);
+    std::vector<double> out(100, 0.0);
+    parallel_for(0, 100, NestedBody(out), 1);
+    double expected = 0;
+    for(int k = 0; k < 64; ++ k)
+        expected += (double) k * k;
+    bool ok = true;
+    for(size_t i = 0; i < out.size(); ++ i)
+        ok = ok && (out[i] == expected);
+    TEST_CHECK(ok);
+}
+
+static void TestRuntimeScope()
+{
+    TEST_CHECK(&ParallelRuntime::Current() == &ParallelRuntime::Instance());
+    {
+        ParallelRuntime runtime(3);
+        ParallelRuntimeScope scope(runtime);
+        TEST_CHECK(&ParallelRuntime::Current() == &runtime);
+
+        // The pool threads of the runtime are bound to it too
+        std::vector<ParallelRuntime*> out(300, (ParallelRuntime*) NULL);
+        parallel_for(0, (int) out.size(), RuntimeBody(out), 1);
+        bool ok = true;
+        for(size_t i = 0; i < out.size(); ++ i)
+            ok = ok && (out[i] == &runtime);
+        TEST_CHECK(ok);
+    }
+    TEST_CHECK(&ParallelRuntime::Current() == &ParallelRuntime::Instance());
+}
+
+int main()
+{
+    TestParallelFor(1);
+    TestParallelFor(4);
+    TestParallelReduce();
+    // On the calling thread's first chunk and on a worker's last one
+    TestException(0, false);
+    TestException(999, false);
+    TestException(500, true);
+    TestCancel();
+    TestNested();
+    TestRuntimeScope();
+    return TestReport("ParallelTest");
+}
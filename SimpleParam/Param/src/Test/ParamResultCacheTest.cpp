@@ -0,0 +1,301 @@
+#include "TestUtil.h"
+#include "../Param/Parameter.h"
+#include "../Param/ParamResultCache.h"
+#include "../Param/SolveMonitor.h"
+
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdio>
+#include <boost/shared_ptr.hpp>
+
+TEST_MAIN_COUNTER;
+
+// Counts the solve iterations, a result taken from the cache has none
+class CountMonitor : public PARAM::SolveMonitor
+{
+public:
+    int nSolve;
+    CountMonitor() : nSolve(0) {}
+
+    bool IsCanceled() { return false; }
+    void ReportProgress(int stage, int iteration, double residual)
+    {
+        if(stage == PARAM::SOLVE_STAGE_SOLVE)
+            ++ nSolve;
+    }
+};
+
+// Surface of the [-0.5, 0.5]^3 cube with n * n quads per side, the lattice
+// point (i, j, k) of the surface is vertex LatticeVertex[(i*(n+1) + j)*(n+1) + k]
+static void CreateCubeModel(MeshModel& model, int n, std::vector<int>& LatticeVertex)
+{
+    CoordArray Coords;
+    LatticeVertex.assign((n+1)*(n+1)*(n+1), -1);
+    for(int i = 0; i <= n; ++ i)
+        for(int j = 0; j <= n; ++ j)
+            for(int k = 0; k <= n; ++ k)
+            {
+                if(i != 0 && i != n && j != 0 && j != n && k != 0 && k != n)
+                    continue;
+                LatticeVertex[(i*(n+1) + j)*(n+1) + k] = (int) Coords.size();
+                Coords.push_back(Coord((double) i/n - 0.5, (double) j/n - 0.5, (double) k/n - 0.5));
+            }
+
+    // Side axis a at the lattice value s, (u, v) axes with u x v pointing out
+    PolyIndexArray Faces;
+    for(int a = 0; a < 3; ++ a)
+        for(int s = 0; s <= n; s += n)
+        {
+            int u = (a+1)%3, v = (a+2)%3;
+            if(s == 0)
+                std::swap(u, v);
+            for(int x = 0; x < n; ++ x)
+                for(int y = 0; y < n; ++ y)
+                {
+                    int Quad[4];
+                    const int Offset[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+                    for(int c = 0; c < 4; ++ c)
+                    {
+                        int p[3];
+                        p[a] = s;
+                        p[u] = x + Offset[c][0];
+                        p[v] = y + Offset[c][1];
+                        Quad[c] = LatticeVertex[(p[0]*(n+1) + p[1])*(n+1) + p[2]];
+                    }
+                    int Lower[3] = { Quad[0], Quad[1], Quad[2] };
+                    int Upper[3] = { Quad[0], Quad[2], Quad[3] };
+                    Faces.push_back(IndexArray(Lower, Lower+3));
+                    Faces.push_back(IndexArray(Upper, Upper+3));
+                }
+        }
+    model.CreateModel(Coords, Faces);
+}
+
+// One patch per cube side in the text layout format, conner c is the cube
+// corner with the lattice coordinates ((c&1)*n, ((c>>1)&1)*n, ((c>>2)&1)*n)
+static bool WriteCubeLayout(const std::string& file_name, int n, const std::vector<int>& LatticeVertex)
+{
+    // Edges join the corners differing in one bit, the path runs from the
+    // smaller corner to the larger one
+    std::vector< std::pair<int, int> > Edges;
+    for(int c = 0; c < 8; ++ c)
+        for(int b = 0; b < 3; ++ b)
+            if((c & (1 << b)) == 0)
+                Edges.push_back(std::make_pair(c, c | (1 << b)));
+
+    // Sides in the order of CreateCubeModel, corners counterclockwise from outside
+    std::vector< std::vector<int> > Patches;
+    for(int a = 0; a < 3; ++ a)
+        for(int s = 0; s <= 1; ++ s)
+        {
+            int u = (a+1)%3, v = (a+2)%3;
+            if(s == 0)
+                std::swap(u, v);
+            const int Offset[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+            std::vector<int> Corner(4);
+            for(int c = 0; c < 4; ++ c)
+                Corner[c] = (s << a) | (Offset[c][0] << u) | (Offset[c][1] << v);
+
+            std::vector<int> PatchEdges;
+            for(int c = 0; c < 4; ++ c)
+            {
+                std::pair<int, int> e(std::min(Corner[c], Corner[(c+1)%4]), std::max(Corner[c], Corner[(c+1)%4]));
+                PatchEdges.push_back((int) (std::find(Edges.begin(), Edges.end(), e) - Edges.begin()));
+            }
+            Patches.push_back(PatchEdges);
+        }
+
+    std::ofstream out(file_name.c_str());
+    out << 8 << std::endl;
+    for(int c = 0; c < 8; ++ c)
+    {
+        int i = (c & 1)*n, j = ((c >> 1) & 1)*n, k = ((c >> 2) & 1)*n;
+        out << 0 << " " << LatticeVertex[(i*(n+1) + j)*(n+1) + k] << " " << 3;
+        for(size_t e = 0; e < Edges.size(); ++ e)
+        {
+            if(Edges[e].first == c)
+                out << " " << Edges[e].second << " " << e;
+            else if(Edges[e].second == c)
+                out << " " << Edges[e].first << " " << e;
+        }
+        out << std::endl;
+    }
+
+    out << Edges.size() << std::endl;
+    for(size_t e = 0; e < Edges.size(); ++ e)
+    {
+        std::vector<int> NbPatch;
+        for(size_t p = 0; p < Patches.size(); ++ p)
+            if(std::find(Patches[p].begin(), Patches[p].end(), (int) e) != Patches[p].end())
+                NbPatch.push_back((int) p);
+
+        int c0 = Edges[e].first, c1 = Edges[e].second;
+        out << c0 << " " << c1 << " " << NbPatch.size() << " " << NbPatch[0] << " " << NbPatch[1] << " " << n+1;
+        for(int t = 0; t <= n; ++ t)
+        {
+            int p[3];
+            for(int b = 0; b < 3; ++ b)
+                p[b] = ((c0 >> b) & 1)*n + (((c1 >> b) & 1) - ((c0 >> b) & 1))*t;
+            out << " " << LatticeVertex[(p[0]*(n+1) + p[1])*(n+1) + p[2]];
+        }
+        out << std::endl;
+    }
+
+    out << Patches.size() << std::endl;
+    for(size_t p = 0; p < Patches.size(); ++ p)
+        out << 0 << std::endl << 4 << " " << Patches[p][0] << " " << Patches[p][1]
+            << " " << Patches[p][2] << " " << Patches[p][3] << std::endl;
+    return !out.fail();
+}
+
+// Solves the cube with the given cache, returns the number of solve iterations
+static int SolveCube(PARAM::Parameter& param, const std::string& layout_file, const std::string& cache_dir, bool chart_parallel)
+{
+    CountMonitor monitor;
+    param.SetChartParallelSolve(chart_parallel);
+    param.SetResultCacheDir(cache_dir);
+    TEST_CHECK(param.LoadPatchFile(layout_file));
+    param.SetSolveMonitor(&monitor);
+    TEST_CHECK(param.ComputeParamCoord());
+    param.SetSolveMonitor(NULL);
+    return monitor.nSolve;
+}
+
+static bool SameResult(const PARAM::Parameter& a, const PARAM::Parameter& b)
+{
+    if(a.GetVertexChartArray() != b.GetVertexChartArray() || a.GetFlipedFaceArray() != b.GetFlipedFaceArray()
+        || a.GetFaceIsometricDistortion() != b.GetFaceIsometricDistortion()
+        || a.GetFaceHarmonicDistortion() != b.GetFaceHarmonicDistortion())
+        return false;
+
+    std::vector<double> fa, fb;
+    a.GatherFaceParamCoord(fa);
+    b.GatherFaceParamCoord(fb);
+    const std::vector<PARAM::ParamCoord>& va = a.GetVertexParamCoordArray();
+    const std::vector<PARAM::ParamCoord>& vb = b.GetVertexParamCoordArray();
+    for(size_t i = 0; i < va.size(); ++ i)
+        if(va[i].s_coord != vb[i].s_coord || va[i].t_coord != vb[i].t_coord)
+            return false;
+    return fa == fb;
+}
+
+// A second solve of the same input is taken from the cache, a changed option
+// or a changed mesh misses it
+static void TestParameterCache()
+{
+    std::string dir = GetTestTempDir("ParamResultCacheTest");
+    std::string layout_file = dir + "/cube.quad";
+
+    const int n = 6;
+    std::vector<int> LatticeVertex;
+    boost::shared_ptr<MeshModel> p_mesh(new MeshModel);
+    CreateCubeModel(*p_mesh, n, LatticeVertex);
+    TEST_CHECK(WriteCubeLayout(layout_file, n, LatticeVertex));
+
+    // References solved without a cache
+    PARAM::Parameter solved(p_mesh);
+    TEST_CHECK(SolveCube(solved, layout_file, "", true) > 0);
+    PARAM::Parameter direct(p_mesh);
+    TEST_CHECK(SolveCube(direct, layout_file, "", false) > 0);
+
+    // The files of an earlier run may be there already, either way the first
+    // solve leaves its result in the cache
+    PARAM::Parameter first(p_mesh);
+    SolveCube(first, layout_file, dir, true);
+    TEST_CHECK(SameResult(first, solved));
+    PARAM::Parameter cached(p_mesh);
+    TEST_CHECK(SolveCube(cached, layout_file, dir, true) == 0);
+    TEST_CHECK(SameResult(cached, solved));
+
+    // The direct solver does not take the chart parallel result, which rounds
+    // differently
+    TEST_CHECK(!SameResult(direct, solved));
+    PARAM::Parameter first_direct(p_mesh);
+    SolveCube(first_direct, layout_file, dir, false);
+    TEST_CHECK(SameResult(first_direct, direct));
+    PARAM::Parameter cached_direct(p_mesh);
+    TEST_CHECK(SolveCube(cached_direct, layout_file, dir, false) == 0);
+    TEST_CHECK(SameResult(cached_direct, direct));
+
+    // Nor does a mesh with a vertex moved along its side
+    CoordArray Coords = p_mesh->m_Kernel.GetVertexInfo().GetCoord();
+    PolyIndexArray Faces;
+    p_mesh->m_Kernel.GetFaceInfo().CopyIndex(Faces);
+    Coords[LatticeVertex[(n*(n+1) + 3)*(n+1) + 3]][1] += 0.25/n;
+    boost::shared_ptr<MeshModel> p_moved(new MeshModel);
+    p_moved->CreateModel(Coords, Faces);
+    PARAM::Parameter moved_solved(p_moved);
+    TEST_CHECK(SolveCube(moved_solved, layout_file, "", true) > 0);
+    TEST_CHECK(!SameResult(moved_solved, solved));
+    PARAM::Parameter moved(p_moved);
+    SolveCube(moved, layout_file, dir, true);
+    TEST_CHECK(SameResult(moved, moved_solved));
+}
+
+static void FillResult(PARAM::ParamResult& result)
+{
+    for(int i = 0; i < 10; ++ i)
+    {
+        result.m_vert_chart_array.push_back(i % 3);
+        result.m_vert_param_coord_array.push_back(PARAM::ParamCoord(0.1*i, 1.0 - 0.1*i));
+    }
+    for(int i = 0; i < 7; ++ i)
+    {
+        result.m_face_chart_array.push_back(i % 2);
+        result.m_face_harmonic_distortion.push_back(1.0 + 0.5*i);
+        result.m_face_isometric_distortion.push_back(2.0 + 0.25*i);
+    }
+    result.m_fliped_face_array.push_back(1);
+    result.m_fliped_face_array.push_back(5);
+    result.m_fliped_face_array.push_back(6);
+    for(int i = 0; i < 4; ++ i)
+        result.m_conner_mesh_index_array.push_back(2*i);
+}
+
+// The file gives back what was saved, a wrong key, a truncated or a missing
+// file is a miss
+static void TestResultFile()
+{
+    std::string file_name = GetTestTempDir("ParamResultCacheTest") + "/result.prc";
+    PARAM::ParamResult saved;
+    FillResult(saved);
+    TEST_CHECK(PARAM::SaveParamResult(file_name, 42, saved));
+
+    PARAM::ParamResult loaded;
+    TEST_CHECK(PARAM::LoadParamResult(file_name, 42, loaded));
+    TEST_CHECK(loaded.m_vert_chart_array == saved.m_vert_chart_array);
+    TEST_CHECK(loaded.m_face_chart_array == saved.m_face_chart_array);
+    TEST_CHECK(loaded.m_conner_mesh_index_array == saved.m_conner_mesh_index_array);
+    TEST_CHECK(loaded.m_face_harmonic_distortion == saved.m_face_harmonic_distortion);
+    TEST_CHECK(loaded.m_face_isometric_distortion == saved.m_face_isometric_distortion);
+    TEST_CHECK(loaded.m_fliped_face_array == saved.m_fliped_face_array);
+    TEST_CHECK(loaded.m_vert_param_coord_array.size() == saved.m_vert_param_coord_array.size());
+    TEST_CHECK(loaded.m_vert_param_coord_array[7].s_coord == saved.m_vert_param_coord_array[7].s_coord);
+    TEST_CHECK(loaded.m_vert_param_coord_array[7].t_coord == saved.m_vert_param_coord_array[7].t_coord);
+
+    TEST_CHECK(!PARAM::LoadParamResult(file_name, 43, loaded));
+
+    std::vector<char> buffer;
+    {
+        std::ifstream in(file_name.c_str(), std::ios::binary);
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(file_name.c_str(), std::ios::binary);
+        out.write(&buffer[0], buffer.size() - 8);
+    }
+    TEST_CHECK(!PARAM::LoadParamResult(file_name, 42, loaded));
+    TEST_CHECK(loaded.m_vert_chart_array.empty());
+
+    remove(file_name.c_str());
+    TEST_CHECK(!PARAM::LoadParamResult(file_name, 42, loaded));
+}
+
+int main()
+{
+    TestResultFile();
+    TestParameterCache();
+    return TestReport("ParamResultCacheTest");
+}
@@ -0,0 +1,186 @@
+#include "TestUtil.h"
+#include "../Param/PatchLayoutIO.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+TEST_MAIN_COUNTER;
+
+static std::string ReadFileText(const std::string& file_name)
+{
+    std::ifstream fin(file_name.c_str(), std::ios::binary);
+    std::ostringstream oss;
+    oss << fin.rdbuf();
+    return oss.str();
+}
+
+static void WriteFileText(const std::string& file_name, const std::string& text)
+{
+    std::ofstream fout(file_name.c_str(), std::ios::binary);
+    fout << text;
+}
+
+static bool SameLayout(const PARAM::PatchLayout& a, const PARAM::PatchLayout& b)
+{
+    if(a.m_patch_conner_array.size() != b.m_patch_conner_array.size()
+        || a.m_patch_edge_array.size() != b.m_patch_edge_array.size()
+        || a.m_patch_array.size() != b.m_patch_array.size())
+        return false;
+    for(size_t i = 0; i < a.m_patch_conner_array.size(); ++ i)
+    {
+        const PARAM::PatchConner& ca = a.m_patch_conner_array[i];
+        const PARAM::PatchConner& cb = b.m_patch_conner_array[i];
+        if(ca.m_conner_type != cb.m_conner_type || ca.m_mesh_index != cb.m_mesh_index
+            || ca.m_nb_conner_index_array != cb.m_nb_conner_index_array
+            || ca.m_nb_edge_index_array != cb.m_nb_edge_index_array)
+            return false;
+    }
+    for(size_t i = 0; i < a.m_patch_edge_array.size(); ++ i)
+    {
+        const PARAM::PatchEdge& ea = a.m_patch_edge_array[i];
+        const PARAM::PatchEdge& eb = b.m_patch_edge_array[i];
+        if(ea.m_conner_pair_index != eb.m_conner_pair_index || ea.m_mesh_path != eb.m_mesh_path
+            || ea.m_nb_patch_index_array != eb.m_nb_patch_index_array)
+            return false;
+    }
+    for(size_t i = 0; i < a.m_patch_array.size(); ++ i)
+    {
+        if(a.m_patch_array[i].m_face_index_array != b.m_patch_array[i].m_face_index_array
+            || a.m_patch_array[i].m_edge_index_array != b.m_patch_array[i].m_edge_index_array)
+            return false;
+    }
+    return true;
+}
+
+// One patch over the 2 x 2 grid, its conners are the grid corners 0, 2, 8, 6
+// and its edges run along the border
+static void CreateSquareLayout(PARAM::PatchLayout& layout)
+{
+    const int conner_vert[4] = {0, 2, 8, 6};
+    const int path_vert[4][3] = {{0, 1, 2}, {2, 5, 8}, {8, 7, 6}, {6, 3, 0}};
+
+    layout.ClearData();
+    layout.m_patch_conner_array.resize(4);
+    layout.m_patch_edge_array.resize(4);
+    layout.m_patch_array.resize(1);
+    for(int k = 0; k < 4; ++ k)
+    {
+        PARAM::PatchConner& conner = layout.m_patch_conner_array[k];
+        conner.m_conner_type = 1;
+        conner.m_mesh_index = conner_vert[k];
+        conner.m_nb_conner_index_array.push_back((k+1)%4);
+        conner.m_nb_edge_index_array.push_back(k);
+        conner.m_nb_conner_index_array.push_back((k+3)%4);
+        conner.m_nb_edge_index_array.push_back((k+3)%4);
+
+        PARAM::PatchEdge& edge = layout.m_patch_edge_array[k];
+        edge.m_conner_pair_index = std::make_pair(k, (k+1)%4);
+        edge.m_nb_patch_index_array.push_back(0);
+        edge.m_mesh_path.assign(path_vert[k], path_vert[k] + 3);
+
+        layout.m_patch_array[0].m_edge_index_array.push_back(k);
+    }
+    for(int f = 0; f < 8; ++ f)
+        layout.m_patch_array[0].m_face_index_array.push_back(f);
+}
+
+// The text form goes to the binary form and back unchanged, the loader
+// recognizes either form
+static void TestRoundTrip()
+{
+    std::string dir = GetTestTempDir("PatchLayoutTest");
+    PARAM::PatchLayout layout, loaded;
+    CreateSquareLayout(layout);
+
+    std::string text_file = dir + "/square.txt";
+    std::string binary_file = dir + "/square" + PARAM::PATCH_LAYOUT_BINARY_EXT;
+    std::string back_file = dir + "/square_back.txt";
+    TEST_CHECK(PARAM::SavePatchLayoutText(text_file, layout));
+    TEST_CHECK(PARAM::LoadPatchLayoutText(text_file, 9, 8, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+
+    TEST_CHECK(PARAM::ConvertPatchLayoutFile(text_file, binary_file));
+    TEST_CHECK(ReadFileText(binary_file).compare(0, 7, "PRMPTCH") == 0);
+    TEST_CHECK(PARAM::LoadPatchLayoutBinary(binary_file, 9, 8, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+    TEST_CHECK(PARAM::LoadPatchLayout(binary_file, 9, 8, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+
+    TEST_CHECK(PARAM::ConvertPatchLayoutFile(binary_file, back_file));
+    TEST_CHECK(ReadFileText(back_file) == ReadFileText(text_file));
+    TEST_CHECK(PARAM::LoadPatchLayout(back_file, 9, 8, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+
+    TEST_CHECK(!PARAM::ConvertPatchLayoutFile(dir + "/missing.txt", back_file));
+}
+
+// A bad token or an index out of the mesh or of the layout fails the load
+// and leaves the layout empty
+static void TestMalformedText()
+{
+    std::string dir = GetTestTempDir("PatchLayoutTest");
+    PARAM::PatchLayout layout, loaded;
+    CreateSquareLayout(layout);
+    std::string text_file = dir + "/square.txt";
+    TEST_CHECK(PARAM::SavePatchLayoutText(text_file, layout));
+    std::string text = ReadFileText(text_file);
+
+    std::string bad_file = dir + "/bad.txt";
+    WriteFileText(bad_file, "4\n1 0 x\n");
+    TEST_CHECK(!PARAM::LoadPatchLayoutText(bad_file, 9, 8, loaded));
+    TEST_CHECK(loaded.m_patch_conner_array.empty() && loaded.m_patch_array.empty());
+
+    // A truncated text file runs out of tokens
+    WriteFileText(bad_file, text.substr(0, text.size()/2));
+    TEST_CHECK(!PARAM::LoadPatchLayoutText(bad_file, 9, 8, loaded));
+
+    // Face 7 is out of a mesh with 7 faces, the check is skipped without a mesh
+    TEST_CHECK(!PARAM::LoadPatchLayoutText(text_file, 9, 7, loaded));
+    TEST_CHECK(loaded.m_patch_array.empty());
+    TEST_CHECK(PARAM::LoadPatchLayoutText(text_file, -1, -1, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+
+    // An edge pointing at a fifth conner
+    PARAM::PatchLayout wrong = layout;
+    wrong.m_patch_edge_array[2].m_conner_pair_index.second = 4;
+    TEST_CHECK(PARAM::SavePatchLayoutText(bad_file, wrong));
+    TEST_CHECK(!PARAM::LoadPatchLayoutText(bad_file, -1, -1, loaded));
+    TEST_CHECK(!PARAM::ConvertPatchLayoutFile(bad_file, dir + "/bad" + PARAM::PATCH_LAYOUT_BINARY_EXT));
+}
+
+// A binary file cut short anywhere fails the load
+static void TestTruncatedBinary()
+{
+    std::string dir = GetTestTempDir("PatchLayoutTest");
+    PARAM::PatchLayout layout, loaded;
+    CreateSquareLayout(layout);
+    std::string binary_file = dir + "/square" + PARAM::PATCH_LAYOUT_BINARY_EXT;
+    TEST_CHECK(PARAM::SavePatchLayoutBinary(binary_file, layout));
+    std::string bytes = ReadFileText(binary_file);
+    TEST_CHECK(PARAM::LoadPatchLayoutBinary(binary_file, 9, 8, loaded));
+    TEST_CHECK(SameLayout(layout, loaded));
+
+    std::string cut_file = dir + "/cut" + PARAM::PATCH_LAYOUT_BINARY_EXT;
+    const size_t cut_size[4] = {4, 12, bytes.size()/2, bytes.size() - 4};
+    bool all_failed = true;
+    for(int k = 0; k < 4; ++ k)
+    {
+        WriteFileText(cut_file, bytes.substr(0, cut_size[k]));
+        all_failed = all_failed && !PARAM::LoadPatchLayoutBinary(cut_file, 9, 8, loaded);
+        all_failed = all_failed && loaded.m_patch_conner_array.empty();
+    }
+    TEST_CHECK(all_failed);
+
+    // A binary file is checked against the mesh too
+    TEST_CHECK(!PARAM::LoadPatchLayoutBinary(binary_file, 8, 8, loaded));
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestMalformedText();
+    TestTruncatedBinary();
+    return TestReport("PatchLayoutTest");
+}
@@ -0,0 +1,48 @@
+#include "TestUtil.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+
+TEST_MAIN_COUNTER;
+
+// Two rings around each vertex through the overload without a context
+class RingBody
+{
+public:
+    MeshModel& model;
+    std::vector< std::vector<int> >& out;
+    RingBody(MeshModel& m, std::vector< std::vector<int> >& o) : model(m), out(o) {}
+
+    void operator()(int i) const
+    {
+        model.m_BasicOp.GetNeighborhoodVertex(i, 2, false, out[i]);
+    }
+};
+
+static void TestConcurrentNeighborhood()
+{
+    MeshModel model;
+    CreateGridModel(model, 20, 20);
+    int nVertex = (int) model.m_Kernel.GetVertexInfo().GetCoord().size();
+
+    std::vector< std::vector<int> > serial(nVertex);
+    MeshModelQueryContext context;
+    for(int i = 0; i < nVertex; ++ i)
+        model.m_BasicOp.GetNeighborhoodVertex(i, 2, false, serial[i], context);
+
+    ParallelRuntime::Instance().SetThreadNum(4);
+    std::vector< std::vector<int> > parallel(nVertex);
+    parallel_for(0, nVertex, RingBody(model, parallel), 1);
+    TEST_CHECK(parallel == serial);
+
+    // An interior vertex of the grid has 6 neighbors in its first ring
+    std::vector<int> ring;
+    model.m_BasicOp.GetNeighborhoodVertex(10*21 + 10, 1, true, ring);
+    TEST_CHECK(ring.size() == 6);
+}
+
+int main()
+{
+    TestConcurrentNeighborhood();
+    return TestReport("QueryContextTest");
+}
@@ -0,0 +1,186 @@
+#include "TestUtil.h"
+#include "../ModelMesh/MeshModelRaster.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+TEST_MAIN_COUNTER;
+
+static std::vector<unsigned char> ReadFileBytes(const std::string& file_name)
+{
+    std::ifstream fin(file_name.c_str(), std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+}
+
+static unsigned int ReadUInt32(const std::vector<unsigned char>& bytes, size_t pos)
+{
+    return ((unsigned int) bytes[pos] << 24) | ((unsigned int) bytes[pos+1] << 16)
+        | ((unsigned int) bytes[pos+2] << 8) | (unsigned int) bytes[pos+3];
+}
+
+static unsigned int Crc32(const unsigned char* data, size_t size)
+{
+    unsigned int crc = 0xFFFFFFFFu;
+    for(size_t i = 0; i < size; ++ i)
+    {
+        crc ^= data[i];
+        for(int k = 0; k < 8; ++ k)
+            crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+    }
+    return ~crc;
+}
+
+static bool IsPixel(const MeshModelRaster& raster, int x, int y, int r, int g, int b)
+{
+    const unsigned char* p = &raster.GetImage()[((size_t) y*raster.GetWidth() + x)*3];
+    return p[0] == r && p[1] == g && p[2] == b;
+}
+
+// The 2 x 1 grid on [0, 2] x [0, 1] seen from z = 4, its left half red and
+// its right half blue. The grid covers x in [9.6, 54.4] and y in [12.8, 35.2]
+// of the 64 x 48 image
+static void RenderGrid(MeshModel& model, MeshModelRaster& raster)
+{
+    ColorArray& fColor = model.m_Kernel.GetFaceInfo().GetColor();
+    fColor.assign(4, Color(0.0, 0.0, 1.0));
+    fColor[0] = fColor[1] = Color(1.0, 0.0, 0.0);
+
+    raster.SetImageSize(64, 48);
+    raster.SetCamera(Coord(1.0, 0.5, 4.0), Coord(1.0, 0.5, 0.0), Coord(0.0, 1.0, 0.0));
+    raster.ShadeMode() = RASTER_SHADE_FACE_COLOR;
+
+    // The middle edge on top of the grid, a point hidden behind it
+    CoordArray strip;
+    strip.push_back(Coord(1.0, 0.0, 0.0));
+    strip.push_back(Coord(1.0, 1.0, 0.0));
+    raster.ClearOverlay();
+    raster.AddLineStrip(strip, Color(0.0, 0.0, 0.0));
+    raster.AddPoint(Coord(1.5, 0.5, -1.0), Color(0.0, 1.0, 0.0));
+    raster.Render(model.m_Kernel);
+}
+
+// Face colors, the background, the overlay line and the depth test
+static void TestPixels()
+{
+    MeshModel model;
+    CreateGridModel(model, 2, 1, 2.0, 1.0);
+    MeshModelRaster raster;
+    RenderGrid(model, raster);
+
+    TEST_CHECK(IsPixel(raster, 20, 24, 255, 0, 0));
+    TEST_CHECK(IsPixel(raster, 44, 24, 0, 0, 255));
+    TEST_CHECK(IsPixel(raster, 40, 24, 0, 0, 255));
+    TEST_CHECK(IsPixel(raster, 32, 24, 0, 0, 0));
+    TEST_CHECK(IsPixel(raster, 2, 2, 255, 255, 255));
+    TEST_CHECK(IsPixel(raster, 32, 40, 255, 255, 255));
+    TEST_CHECK(IsPixel(raster, 60, 24, 255, 255, 255));
+
+    // The tiles are drawn in parallel, the image does not depend on the thread number
+    std::vector<unsigned char> image = raster.GetImage();
+    ParallelRuntime runtime(1);
+    {
+        ParallelRuntimeScope scope(runtime);
+        MeshModelRaster serial;
+        RenderGrid(model, serial);
+        TEST_CHECK(serial.GetImage() == image);
+    }
+
+    // The heat colors run from blue to green to red
+    std::vector<double> value(3);
+    value[0] = 2.0; value[1] = 3.0; value[2] = 4.0;
+    ColorArray color;
+    MeshModelRaster::ScalarToColor(value, color);
+    TEST_CHECK(color.size() == 3);
+    TEST_CHECK_NEAR(color[0][2], 1.0, 1e-12);
+    TEST_CHECK_NEAR(color[1][1], 1.0, 1e-12);
+    TEST_CHECK_NEAR(color[2][0], 1.0, 1e-12);
+}
+
+// The PPM is the header and the RGB rows, the PNG is an RGB image with CRC
+// checked chunks whose stored deflate blocks hold the rows with filter 0
+static void TestFiles()
+{
+    MeshModel model;
+    CreateGridModel(model, 2, 1, 2.0, 1.0);
+    MeshModelRaster raster;
+    RenderGrid(model, raster);
+    const std::vector<unsigned char>& image = raster.GetImage();
+    std::string dir = GetTestTempDir("RasterTest");
+
+    TEST_CHECK(raster.SaveImage(dir + "/grid.ppm"));
+    std::vector<unsigned char> ppm = ReadFileBytes(dir + "/grid.ppm");
+    const char* header = "P6\n64 48\n255\n";
+    size_t header_size = strlen(header);
+    TEST_CHECK(ppm.size() == header_size + image.size());
+    if(ppm.size() == header_size + image.size())
+    {
+        TEST_CHECK(memcmp(&ppm[0], header, header_size) == 0);
+        TEST_CHECK(std::equal(image.begin(), image.end(), ppm.begin() + header_size));
+    }
+
+    TEST_CHECK(raster.SaveImage(dir + "/grid.PNG"));
+    std::vector<unsigned char> png = ReadFileBytes(dir + "/grid.PNG");
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    TEST_CHECK(png.size() > 8 && memcmp(&png[0], signature, 8) == 0);
+
+    // Walk the chunks and check their CRC
+    std::vector<unsigned char> ihdr, idat;
+    bool has_end = false, crc_ok = true;
+    size_t pos = 8;
+    while(pos + 12 <= png.size() && !has_end)
+    {
+        size_t len = ReadUInt32(png, pos);
+        if(pos + 12 + len > png.size())
+            break;
+        std::string type(png.begin() + pos + 4, png.begin() + pos + 8);
+        crc_ok = crc_ok && Crc32(&png[pos+4], len + 4) == ReadUInt32(png, pos + 8 + len);
+        std::vector<unsigned char> data(png.begin() + pos + 8, png.begin() + pos + 8 + len);
+        if(type == "IHDR") ihdr = data;
+        else if(type == "IDAT") idat.insert(idat.end(), data.begin(), data.end());
+        else if(type == "IEND") has_end = true;
+        pos += 12 + len;
+    }
+    TEST_CHECK(has_end && pos == png.size());
+    TEST_CHECK(crc_ok);
+    TEST_CHECK(ihdr.size() == 13);
+    if(ihdr.size() == 13)
+    {
+        TEST_CHECK(ReadUInt32(ihdr, 0) == 64 && ReadUInt32(ihdr, 4) == 48);
+        TEST_CHECK(ihdr[8] == 8 && ihdr[9] == 2);
+    }
+
+    // Inflate the stored blocks
+    std::vector<unsigned char> raw;
+    bool final_block = false;
+    pos = 2;
+    TEST_CHECK(idat.size() > 2 && idat[0] == 0x78);
+    while(!final_block && pos + 5 <= idat.size())
+    {
+        final_block = (idat[pos] & 1) != 0;
+        size_t len = idat[pos+1] | (idat[pos+2] << 8);
+        size_t nlen = idat[pos+3] | (idat[pos+4] << 8);
+        TEST_CHECK(len == (~nlen & 0xFFFF));
+        raw.insert(raw.end(), idat.begin() + pos + 5, idat.begin() + pos + 5 + len);
+        pos += 5 + len;
+    }
+    TEST_CHECK(final_block && pos + 4 == idat.size());
+
+    std::vector<unsigned char> rows;
+    for(int y = 0; y < 48; ++ y)
+    {
+        rows.push_back(0);
+        rows.insert(rows.end(), image.begin() + y*64*3, image.begin() + (y+1)*64*3);
+    }
+    TEST_CHECK(raw == rows);
+}
+
+int main()
+{
+    TestPixels();
+    TestFiles();
+    return TestReport("RasterTest");
+}
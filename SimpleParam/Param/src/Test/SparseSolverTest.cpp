@@ -0,0 +1,227 @@
+#include "TestUtil.h"
+#include "../Numerical/sparse_cholesky.h"
+#include "../Numerical/schur_solver.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <boost/scoped_ptr.hpp>
+
+TEST_MAIN_COUNTER;
+
+// Five point Laplacian of an n * n grid plus shift on the diagonal, both
+// triangles in csc, or only the lower one
+static void GridMatrix(int n, double shift, bool lower_only, hj::sparse::spm_csc<double>& A)
+{
+    std::vector<int> ptr(1, 0), idx;
+    std::vector<double> val;
+    for(int j = 0; j < n; ++ j)
+        for(int i = 0; i < n; ++ i)
+        {
+            int col = j*n + i;
+            const int Row[5] = { col - n, col - 1, col, col + 1, col + n };
+            const bool Valid[5] = { j > 0, i > 0, true, i < n-1, j < n-1 };
+            for(int k = 0; k < 5; ++ k)
+            {
+                if(!Valid[k] || (lower_only && Row[k] < col))
+                    continue;
+                idx.push_back(Row[k]);
+                val.push_back(Row[k] == col ? 4.0 + shift : -1.0);
+            }
+            ptr.push_back((int) idx.size());
+        }
+
+    A.resize(n*n, n*n, (int) idx.size());
+    for(size_t k = 0; k < ptr.size(); ++ k)
+        A.ptr_[k] = ptr[k];
+    for(size_t k = 0; k < idx.size(); ++ k)
+    {
+        A.idx_[k] = idx[k];
+        A.val_[k] = val[k];
+    }
+}
+
+// Reference solve by Gaussian elimination with partial pivoting on the
+// dense matrix
+static void DenseSolve(const hj::sparse::spm_csc<double>& A, const std::vector<double>& b, std::vector<double>& x)
+{
+    int n = A.size(2);
+    std::vector<double> M(n*n, 0.0);
+    for(int c = 0; c < n; ++ c)
+        for(int k = A.ptr_[c]; k < A.ptr_[c+1]; ++ k)
+            M[A.idx_[k]*n + c] = A.val_[k];
+    x = b;
+
+    for(int c = 0; c < n; ++ c)
+    {
+        int pivot = c;
+        for(int r = c+1; r < n; ++ r)
+            if(fabs(M[r*n + c]) > fabs(M[pivot*n + c]))
+                pivot = r;
+        if(pivot != c)
+        {
+            std::swap_ranges(M.begin() + c*n, M.begin() + (c+1)*n, M.begin() + pivot*n);
+            std::swap(x[c], x[pivot]);
+        }
+        for(int r = c+1; r < n; ++ r)
+        {
+            double f = M[r*n + c] / M[c*n + c];
+            if(f == 0.0)
+                continue;
+            for(int k = c; k < n; ++ k)
+                M[r*n + k] -= f * M[c*n + k];
+            x[r] -= f * x[c];
+        }
+    }
+    for(int c = n-1; c >= 0; -- c)
+    {
+        for(int k = c+1; k < n; ++ k)
+            x[c] -= M[c*n + k] * x[k];
+        x[c] /= M[c*n + c];
+    }
+}
+
+static double MaxDiff(const double* a, const double* b, int n)
+{
+    double d = 0;
+    for(int i = 0; i < n; ++ i)
+        d = std::max(d, fabs(a[i] - b[i]));
+    return d;
+}
+
+static void RandomVector(int n, unsigned int seed, std::vector<double>& b)
+{
+    srand(seed);
+    b.resize(n);
+    for(int i = 0; i < n; ++ i)
+        b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static void TestCholesky(int nThread)
+{
+    ParallelRuntime::Instance().SetThreadNum(nThread);
+    const int n = 24, N = n*n;
+    hj::sparse::spm_csc<double> A;
+    GridMatrix(n, 0.01, false, A);
+
+    // Three right hand sides in one call
+    std::vector<double> b, b1, ref(3*N);
+    RandomVector(3*N, 11, b);
+    for(int r = 0; r < 3; ++ r)
+    {
+        std::vector<double> br(b.begin() + r*N, b.begin() + (r+1)*N), xr;
+        DenseSolve(A, br, xr);
+        std::copy(xr.begin(), xr.end(), ref.begin() + r*N);
+    }
+
+    boost::scoped_ptr<SparseDirectSolver> solver(SparseDirectSolver::create(A));
+    TEST_CHECK(solver.get() != NULL);
+    if(!solver.get())
+        return;
+    std::vector<double> x(3*N);
+    TEST_CHECK(solver->solve(&b[0], &x[0], 3));
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], 3*N) < 1e-9);
+
+    // The lower triangle alone gives the same factor
+    hj::sparse::spm_csc<double> L;
+    GridMatrix(n, 0.01, true, L);
+    boost::scoped_ptr<SparseDirectSolver> lower(SparseDirectSolver::create(L));
+    TEST_CHECK(lower.get() != NULL);
+    if(lower.get())
+    {
+        std::vector<double> xl(N);
+        TEST_CHECK(lower->solve(&b[0], &xl[0]));
+        TEST_CHECK(MaxDiff(&xl[0], &ref[0], N) < 1e-9);
+    }
+
+    // New values of the same pattern, A scaled by 2 halves x
+    std::vector<double> val2(A.val_.size());
+    for(size_t k = 0; k < val2.size(); ++ k)
+        val2[k] = 2.0 * A.val_[k];
+    TEST_CHECK(solver->set_value(&val2[0]));
+    TEST_CHECK(solver->solve(&b[0], &x[0]));
+    for(int i = 0; i < N; ++ i)
+        x[i] *= 2.0;
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], N) < 1e-9);
+}
+
+// -A is negative definite, L L^T refuses it and L D L^T solves it
+static void TestIndefinite()
+{
+    const int n = 12, N = n*n;
+    hj::sparse::spm_csc<double> A;
+    GridMatrix(n, 0.5, false, A);
+    for(size_t k = 0; k < A.val_.size(); ++ k)
+        A.val_[k] = -A.val_[k];
+
+    std::vector<double> b, ref;
+    RandomVector(N, 5, b);
+    DenseSolve(A, b, ref);
+
+    boost::scoped_ptr<SparseDirectSolver> cholesky(SparseDirectSolver::create(A));
+    TEST_CHECK(cholesky.get() == NULL);
+
+    boost::scoped_ptr<SparseDirectSolver> ldlt(SparseDirectSolver::create(A, "ldlt"));
+    TEST_CHECK(ldlt.get() != NULL);
+    if(!ldlt.get())
+        return;
+    std::vector<double> x(N);
+    TEST_CHECK(ldlt->solve(&b[0], &x[0]));
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], N) < 1e-9);
+}
+
+// Four quadrant domains of the grid, the variables next to another quadrant
+// go to the interface
+static void TestSchur(int nThread)
+{
+    ParallelRuntime::Instance().SetThreadNum(nThread);
+    const int n = 20, N = n*n;
+    hj::sparse::spm_csc<double> A;
+    GridMatrix(n, 0.01, false, A);
+
+    std::vector<int> domain(N);
+    for(int j = 0; j < n; ++ j)
+        for(int i = 0; i < n; ++ i)
+            domain[j*n + i] = (i < n/2 ? 0 : 1) + (j < n/2 ? 0 : 2);
+    // One variable put on the interface by hand
+    domain[3*n + 3] = -1;
+
+    std::vector<double> b, ref, x;
+    RandomVector(N, 3, b);
+    DenseSolve(A, b, ref);
+
+    SchurSolver schur;
+    schur.is_printf_info(false);
+    TEST_CHECK(schur.solve(A, domain, b, x));
+    TEST_CHECK(x.size() == (size_t) N);
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], N) < 1e-9);
+    TEST_CHECK(schur.get_domain_num() == 4);
+    TEST_CHECK(schur.get_reused_num() == 0);
+
+    // The same matrix keeps all the factorizations, another right hand side
+    RandomVector(N, 4, b);
+    DenseSolve(A, b, ref);
+    TEST_CHECK(schur.solve(A, domain, b, x));
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], N) < 1e-9);
+    TEST_CHECK(schur.get_reused_num() == 4);
+
+    // A changed diagonal in the interior of the last quadrant
+    for(int k = A.ptr_[N-1]; k < A.ptr_[N]; ++ k)
+        if(A.idx_[k] == N-1)
+            A.val_[k] += 1.0;
+    DenseSolve(A, b, ref);
+    TEST_CHECK(schur.solve(A, domain, b, x));
+    TEST_CHECK(MaxDiff(&x[0], &ref[0], N) < 1e-9);
+    TEST_CHECK(schur.get_reused_num() == 3);
+}
+
+int main()
+{
+    TestCholesky(1);
+    TestCholesky(4);
+    TestIndefinite();
+    TestSchur(1);
+    TestSchur(4);
+    return TestReport("SparseSolverTest");
+}
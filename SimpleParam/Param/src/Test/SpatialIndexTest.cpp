@@ -0,0 +1,191 @@
+#include "TestUtil.h"
+#include "../Common/Parallel.h"
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdlib>
+
+TEST_MAIN_COUNTER;
+
+// Points in [-r, r]^3 from a fixed seed
+static void RandomPoints(int n, double r, CoordArray& PosArray)
+{
+    srand(7);
+    PosArray.resize(n);
+    for(int i = 0; i < n; ++ i)
+    {
+        for(int k = 0; k < 3; ++ k)
+            PosArray[i][k] = r * (2.0 * rand() / RAND_MAX - 1.0);
+    }
+}
+
+// Reference closest point: the projection when it falls inside, else the
+// nearest point of the three edges
+static Coord SegmentClosestPoint(const Coord& p, const Coord& a, const Coord& b)
+{
+    Coord ab = b - a;
+    double s = dot(p - a, ab) / ab.sqrabs();
+    s = std::max(0.0, std::min(1.0, s));
+    return a + ab*s;
+}
+
+static double TriangleSqrDistance(const Coord& p, const Coord& a, const Coord& b, const Coord& c)
+{
+    Coord n = cross(b - a, c - a);
+    Coord q = p - n * (dot(p - a, n) / n.sqrabs());
+    if(dot(cross(b - a, q - a), n) >= 0 && dot(cross(c - b, q - b), n) >= 0 && dot(cross(a - c, q - c), n) >= 0)
+        return (p - q).sqrabs();
+
+    double d = (p - SegmentClosestPoint(p, a, b)).sqrabs();
+    d = std::min(d, (p - SegmentClosestPoint(p, b, c)).sqrabs());
+    d = std::min(d, (p - SegmentClosestPoint(p, c, a)).sqrabs());
+    return d;
+}
+
+// Reference ray hit: the plane crossing, kept when it is inside the triangle
+static bool TriangleRayHit(const Coord& o, const Coord& dir, const Coord& a, const Coord& b, const Coord& c, double& t)
+{
+    Coord n = cross(b - a, c - a);
+    double nd = dot(n, dir);
+    if(nd == 0.0)
+        return false;
+    t = dot(n, a - o) / nd;
+    if(t < 0.0)
+        return false;
+    Coord q = o + dir*t;
+    return dot(cross(b - a, q - a), n) >= 0 && dot(cross(c - b, q - b), n) >= 0 && dot(cross(a - c, q - c), n) >= 0;
+}
+
+static void TestNearestVertex(MeshModel& model)
+{
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    CoordArray PosArray;
+    RandomPoints(500, 1.5, PosArray);
+
+    IndexArray VtxArray;
+    TEST_CHECK(model.m_SpatialIndex.GetNearestVertex(PosArray, VtxArray));
+    TEST_CHECK(VtxArray.size() == PosArray.size());
+
+    int nWrong = 0;
+    for(size_t i = 0; i < PosArray.size(); ++ i)
+    {
+        double best = std::numeric_limits<double>::max();
+        for(size_t v = 0; v < vCoord.size(); ++ v)
+            best = std::min(best, (vCoord[v] - PosArray[i]).sqrabs());
+
+        VertexID vID = -1;
+        model.m_SpatialIndex.GetNearestVertex(PosArray[i], vID);
+        if(vID != VtxArray[i] || (vCoord[vID] - PosArray[i]).sqrabs() != best)
+            ++ nWrong;
+    }
+    TEST_CHECK(nWrong == 0);
+}
+
+static void TestNearestSurfacePoint(MeshModel& model)
+{
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = model.m_Kernel.GetFaceInfo();
+    CoordArray PosArray;
+    RandomPoints(100, 1.5, PosArray);
+
+    int nWrong = 0;
+    for(size_t i = 0; i < PosArray.size(); ++ i)
+    {
+        double best = std::numeric_limits<double>::max();
+        for(int f = 0; f < fInfo.GetFaceNum(); ++ f)
+        {
+            const int* face = fInfo.GetFaceVertices(f);
+            best = std::min(best, TriangleSqrDistance(PosArray[i], vCoord[face[0]], vCoord[face[1]], vCoord[face[2]]));
+        }
+
+        FaceID fID = -1;
+        Coord bc;
+        if(!model.m_SpatialIndex.GetNearestSurfacePoint(PosArray[i], fID, bc))
+        {
+            ++ nWrong;
+            continue;
+        }
+        const int* f = fInfo.GetFaceVertices(fID);
+        Coord p = vCoord[f[0]]*bc[0] + vCoord[f[1]]*bc[1] + vCoord[f[2]]*bc[2];
+        if(fabs((p - PosArray[i]).sqrabs() - best) > 1e-12)
+            ++ nWrong;
+    }
+    TEST_CHECK(nWrong == 0);
+}
+
+static void TestRayIntersect(MeshModel& model)
+{
+    const CoordArray& vCoord = model.m_Kernel.GetVertexInfo().GetCoord();
+    const FaceInfo& fInfo = model.m_Kernel.GetFaceInfo();
+    CoordArray Origin, Dir;
+    RandomPoints(100, 1.5, Origin);
+    RandomPoints(100, 1.0, Dir);
+    std::reverse(Dir.begin(), Dir.end());
+
+    int nWrong = 0;
+    for(size_t i = 0; i < Origin.size(); ++ i)
+    {
+        double best = std::numeric_limits<double>::max();
+        for(int f = 0; f < fInfo.GetFaceNum(); ++ f)
+        {
+            const int* face = fInfo.GetFaceVertices(f);
+            double t;
+            if(TriangleRayHit(Origin[i], Dir[i], vCoord[face[0]], vCoord[face[1]], vCoord[face[2]], t))
+                best = std::min(best, t);
+        }
+
+        FaceID fID = -1;
+        Coord bc;
+        double t = 0;
+        bool hit = model.m_SpatialIndex.RayIntersect(Origin[i], Dir[i], fID, bc, t);
+        if(hit != (best != std::numeric_limits<double>::max()))
+            ++ nWrong;
+        else if(hit && fabs(t - best) > 1e-9)
+            ++ nWrong;
+    }
+    TEST_CHECK(nWrong == 0);
+}
+
+// Axis aligned rays through the grid lines, where a ray starts on the slab
+// planes of many boxes
+static void TestAxisRay()
+{
+    MeshModel model;
+    CreateGridModel(model, 8, 8);
+
+    FaceID fID = -1;
+    Coord bc;
+    double t = 0;
+    TEST_CHECK(model.m_SpatialIndex.RayIntersect(Coord(0.5, 0.25, 2.0), Coord(0, 0, -1), fID, bc, t));
+    TEST_CHECK_NEAR(t, 2.0, 1e-12);
+    TEST_CHECK(model.m_SpatialIndex.RayIntersect(Coord(0.0, 0.0, -3.0), Coord(0, 0, 1), fID, bc, t));
+    TEST_CHECK_NEAR(t, 3.0, 1e-12);
+    TEST_CHECK(!model.m_SpatialIndex.RayIntersect(Coord(0.5, 0.5, 1.0), Coord(1, 0, 0), fID, bc, t));
+    TEST_CHECK(!model.m_SpatialIndex.RayIntersect(Coord(0.5, 0.5, 1.0), Coord(0, 0, 0), fID, bc, t));
+
+    // A model a million times smaller is hit the same way
+    MeshModel tiny;
+    CreateGridModel(tiny, 8, 8, 1e-6, 1e-6);
+    TEST_CHECK(tiny.m_SpatialIndex.RayIntersect(Coord(0.5e-6, 0.25e-6, 2e-6), Coord(0, 0, -1), fID, bc, t));
+    TEST_CHECK_NEAR(t, 2e-6, 1e-18);
+}
+
+// The tree and the answers do not depend on the thread number
+static void TestThreadNum(int nThread)
+{
+    ParallelRuntime::Instance().SetThreadNum(nThread);
+    MeshModel model;
+    CreateSphereModel(model, 5);
+    TestNearestVertex(model);
+    TestNearestSurfacePoint(model);
+    TestRayIntersect(model);
+}
+
+int main()
+{
+    TestThreadNum(1);
+    TestThreadNum(4);
+    TestAxisRay();
+    return TestReport("SpatialIndexTest");
+}
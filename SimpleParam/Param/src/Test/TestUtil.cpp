@@ -0,0 +1,101 @@
+#include "TestUtil.h"
+
+#include <map>
+#include <utility>
+#include <cstdlib>
+
+#ifdef WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static int GetMidVertex(int v0, int v1, CoordArray& Coords, std::map<std::pair<int, int>, int>& MidVertex)
+{
+    std::pair<int, int> key(std::min(v0, v1), std::max(v0, v1));
+    std::map<std::pair<int, int>, int>::iterator it = MidVertex.find(key);
+    if(it != MidVertex.end())
+        return it->second;
+
+    Coord mid = (Coords[v0] + Coords[v1]) / 2.0;
+    mid.normalize();
+    Coords.push_back(mid);
+    int v = (int) Coords.size() - 1;
+    MidVertex[key] = v;
+    return v;
+}
+
+void CreateSphereModel(MeshModel& model, int nLevel, double radius)
+{
+    CoordArray Coords;
+    Coords.push_back(Coord( 1, 0, 0));
+    Coords.push_back(Coord(-1, 0, 0));
+    Coords.push_back(Coord( 0, 1, 0));
+    Coords.push_back(Coord( 0,-1, 0));
+    Coords.push_back(Coord( 0, 0, 1));
+    Coords.push_back(Coord( 0, 0,-1));
+
+    const int OctaFace[8][3] = { {0, 2, 4}, {2, 1, 4}, {1, 3, 4}, {3, 0, 4},
+                                 {2, 0, 5}, {1, 2, 5}, {3, 1, 5}, {0, 3, 5} };
+    PolyIndexArray Faces;
+    for(int f = 0; f < 8; ++ f)
+    {
+        IndexArray face(OctaFace[f], OctaFace[f]+3);
+        Faces.push_back(face);
+    }
+
+    for(int level = 0; level < nLevel; ++ level)
+    {
+        std::map<std::pair<int, int>, int> MidVertex;
+        PolyIndexArray NewFaces;
+        for(size_t f = 0; f < Faces.size(); ++ f)
+        {
+            int a = Faces[f][0], b = Faces[f][1], c = Faces[f][2];
+            int ab = GetMidVertex(a, b, Coords, MidVertex);
+            int bc = GetMidVertex(b, c, Coords, MidVertex);
+            int ca = GetMidVertex(c, a, Coords, MidVertex);
+            int Sub[4][3] = { {a, ab, ca}, {ab, b, bc}, {ca, bc, c}, {ab, bc, ca} };
+            for(int k = 0; k < 4; ++ k)
+                NewFaces.push_back(IndexArray(Sub[k], Sub[k]+3));
+        }
+        Faces.swap(NewFaces);
+    }
+
+    for(size_t v = 0; v < Coords.size(); ++ v)
+        Coords[v] *= radius;
+    model.CreateModel(Coords, Faces);
+}
+
+void CreateGridModel(MeshModel& model, int nx, int ny, double sx, double sy)
+{
+    CoordArray Coords;
+    for(int j = 0; j <= ny; ++ j)
+        for(int i = 0; i <= nx; ++ i)
+            Coords.push_back(Coord(sx*i/nx, sy*j/ny, 0));
+
+    PolyIndexArray Faces;
+    for(int j = 0; j < ny; ++ j)
+    {
+        for(int i = 0; i < nx; ++ i)
+        {
+            int v00 = j*(nx+1) + i, v10 = v00 + 1;
+            int v01 = v00 + nx + 1, v11 = v01 + 1;
+            int Lower[3] = { v00, v10, v11 };
+            int Upper[3] = { v00, v11, v01 };
+            Faces.push_back(IndexArray(Lower, Lower+3));
+            Faces.push_back(IndexArray(Upper, Upper+3));
+        }
+    }
+    model.CreateModel(Coords, Faces);
+}
+
+std::string GetTestTempDir(const std::string& name)
+{
+    std::string dir = "test_" + name;
+#ifdef WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    return dir;
+}
@@ -0,0 +1,74 @@
+/* ================== File Information ================== */
+// [Name]
+// TestUtil.h
+//
+// [Goal]
+// Checks and procedural meshes shared by the test programs
+//
+// Each test program is a main() calling its test functions, a failed check
+// prints the expression with its location and the program returns the number
+// of failed checks, so ctest reports it as failed.
+
+
+
+#include "../Common/BasicDataType.h"
+#include "../ModelMesh/MeshModel.h"
+
+#include <iostream>
+#include <cmath>
+#include <string>
+#pragma once
+
+
+
+/* ================== Checks ================== */
+
+extern int g_nFailedCheck;
+
+#define TEST_CHECK(expr) \
+    do { \
+        if(!(expr)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #expr << std::endl; \
+            ++ g_nFailedCheck; \
+        } \
+    } while(0)
+
+#define TEST_CHECK_NEAR(a, b, tol) \
+    do { \
+        double _a = (a), _b = (b); \
+        if(!(std::fabs(_a-_b) <= (tol))) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #a << " = " << _a \
+                      << ", " << #b << " = " << _b << ", tolerance " << (tol) << std::endl; \
+            ++ g_nFailedCheck; \
+        } \
+    } while(0)
+
+// Defines the failed check counter, once per test program
+#define TEST_MAIN_COUNTER int g_nFailedCheck = 0
+
+// Report and exit code of a test program
+inline int TestReport(const char* name)
+{
+    if(g_nFailedCheck == 0)
+        std::cout << name << ": all checks passed" << std::endl;
+    else
+        std::cout << name << ": " << g_nFailedCheck << " checks failed" << std::endl;
+    return g_nFailedCheck == 0 ? 0 : 1;
+}
+
+
+
+/* ================== Procedural Meshes ================== */
+
+// Unit sphere by subdividing an octahedron nLevel times, vertices projected
+// on the sphere
+void CreateSphereModel(MeshModel& model, int nLevel, double radius = 1.0);
+
+// Grid of nx * ny quads on [0, sx] x [0, sy] in the z = 0 plane, each quad
+// cut in two triangles
+void CreateGridModel(MeshModel& model, int nx, int ny, double sx = 1.0, double sy = 1.0);
+
+// A writable directory of the build tree for the files of a test
+std::string GetTestTempDir(const std::string& name);